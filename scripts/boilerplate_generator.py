@@ -142,7 +142,7 @@ def get_arg_names(args):
 
     return [starred_name.strip("* ") for starred_name in starred_names]
 
-def get_func_boilerplate(fn_info):
+def get_func_boilerplate(fn_info, module_name):
     call_args_str = ", ".join(get_arg_names(fn_info.args))
     args_ann_unused = fn_info.args.replace(",", " G_GNUC_UNUSED,")
 
@@ -159,18 +159,23 @@ def get_func_boilerplate(fn_info):
         # enum or whatever
         default_ret = 0
 
-    # first add the stub function doing nothing and just reporting error
-    ret = ("static {0.rtype} {0.name}_stub ({2}) {{\n" +
-           "    bd_utils_log_format (BD_UTILS_LOG_CRIT, \"The function '{0.name}' called, but not implemented!\");\n" +
-           "    g_set_error (error, BD_INIT_ERROR, BD_INIT_ERROR_NOT_IMPLEMENTED,\n"+
-           "                \"The function '{0.name}' called, but not implemented!\");\n"
-           "    return {1};\n"
-           "}}\n\n").format(fn_info, default_ret, args_ann_unused)
-
-    # then add a variable holding a reference to the dynamically loaded function
-    # (if any) initialized to the stub
+    # first add a variable holding a reference to the dynamically loaded
+    # function (if any) initialized to the stub
+    ret = "static {0.rtype} {0.name}_stub ({0.args});\n".format(fn_info)
     ret += "static {0.rtype} (*_{0.name}) ({0.args}) = {0.name}_stub;\n\n".format(fn_info)
 
+    # then add the stub function loading the plugin if it is to be loaded on
+    # demand or doing nothing and just reporting error
+    ret += ("static {0.rtype} {0.name}_stub ({2}) {{\n" +
+            "    if (lazy_load_plugin ({3}) && _{0.name} != {0.name}_stub)\n" +
+            "        return _{0.name} ({4});\n\n" +
+            "    bd_utils_log_format (BD_UTILS_LOG_CRIT, \"The function '{0.name}' called, but not implemented!\");\n" +
+            "    g_set_error (error, BD_INIT_ERROR, BD_INIT_ERROR_NOT_IMPLEMENTED,\n"+
+            "                \"The function '{0.name}' called, but not implemented!\");\n"
+            "    return {1};\n"
+            "}}\n\n").format(fn_info, default_ret, args_ann_unused,
+                              "BD_PLUGIN_" + module_name.upper(), call_args_str)
+
     # then add a documented function calling the dynamically loaded one via the
     # reference
     ret += ("{0.doc}{0.rtype} {0.name} ({0.args}) {{\n" +
@@ -284,7 +289,7 @@ def generate_source_header(api_file, out_dir, skip_patterns=None):
         for info in nonapi_fn_infos:
             src_f.write(get_fn_code(info))
         for info in api_fn_infos:
-            src_f.write(get_func_boilerplate(info))
+            src_f.write(get_func_boilerplate(info, mod_name))
         src_f.write(get_loading_func(api_fn_infos, mod_name))
         src_f.write(get_unloading_func(api_fn_infos, mod_name))
 
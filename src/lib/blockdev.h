@@ -17,6 +17,22 @@ typedef enum {
     BD_INIT_ERROR_NOT_IMPLEMENTED,
 } BDInitError;
 
+/**
+ * BDInitFlags:
+ * @BD_INIT_FLAGS_NONE: load and initialize all the plugins one by one during the
+ *                      *init*() call (default)
+ * @BD_INIT_FLAGS_LAZY: load and initialize the plugins on the first call of
+ *                      their functions
+ * @BD_INIT_FLAGS_PARALLEL: load and initialize the plugins in parallel
+ */
+typedef enum {
+    BD_INIT_FLAGS_NONE     = 0,
+    BD_INIT_FLAGS_LAZY     = 1 << 0,
+    BD_INIT_FLAGS_PARALLEL = 1 << 1,
+} BDInitFlags;
+
+void bd_set_init_flags (BDInitFlags flags);
+
 gboolean bd_init (BDPluginSpec **require_plugins, BDUtilsLogFunc log_func, GError **error);
 gboolean bd_ensure_init (BDPluginSpec **require_plugins, BDUtilsLogFunc log_func, GError **error);
 gboolean bd_reinit (BDPluginSpec **require_plugins, gboolean reload, BDUtilsLogFunc log_func, GError **error);
@@ -20,6 +20,14 @@
 #include <glib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/vfs.h>
+#include <linux/btrfs.h>
+#include <linux/btrfs_tree.h>
+#include <linux/fs.h>
+#include <linux/magic.h>
 #include <blockdev/utils.h>
 #include <bs_size.h>
 
@@ -170,6 +178,21 @@ gboolean bd_btrfs_is_tech_avail (BDBtrfsTech tech G_GNUC_UNUSED, guint64 mode G_
            check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error);
 }
 
+/* patterns for parsing the output of 'btrfs filesystem show' (devices and
+   filesystem info) and 'btrfs subvol list', used if the ioctls cannot be used */
+#define DEVICE_LIST_PATTERN "devid[ \\t]+(?P<id>\\d+)[ \\t]+" \
+                            "size[ \\t]+(?P<size>\\S+)[ \\t]+" \
+                            "used[ \\t]+(?P<used>\\S+)[ \\t]+" \
+                            "path[ \\t]+(?P<path>\\S+)\n"
+#define SUBVOL_LIST_PATTERN "ID\\s+(?P<id>\\d+)\\s+gen\\s+\\d+\\s+(cgen\\s+\\d+\\s+)?" \
+                            "parent\\s+(?P<parent_id>\\d+)\\s+top\\s+level\\s+\\d+\\s+" \
+                            "(otime\\s+(\\d{4}-\\d{2}-\\d{2}\\s+\\d\\d:\\d\\d:\\d\\d|-)\\s+)?" \
+                            "path\\s+(<FS_TREE>/)?(?P<path>\\S+)"
+#define FILESYSTEM_INFO_PATTERN "Label:\\s+(none|'(?P<label>.+)')\\s+" \
+                                "uuid:\\s+(?P<uuid>\\S+)\\s+" \
+                                "Total\\sdevices\\s+(?P<num_devices>\\d+)\\s+" \
+                                "FS\\sbytes\\sused\\s+(?P<used>\\S+)"
+
 static BDBtrfsDeviceInfo* get_device_info_from_match (GMatchInfo *match_info) {
     BDBtrfsDeviceInfo *ret = g_new(BDBtrfsDeviceInfo, 1);
     gchar *item = NULL;
@@ -257,6 +280,342 @@ static BDBtrfsFilesystemInfo* get_filesystem_info_from_match (GMatchInfo *match_
     return ret;
 }
 
+/* Sorts @subvol_infos in a way that no child subvolume appears in the list
+   before its parent (sub)volume. Frees @subvol_infos, but not its items. */
+static BDBtrfsSubvolumeInfo** sort_subvolumes (GPtrArray *subvol_infos) {
+    guint64 i = 0;
+    guint64 y = 0;
+    guint64 next_sorted_idx = 0;
+    BDBtrfsSubvolumeInfo* item = NULL;
+    BDBtrfsSubvolumeInfo* swap_item = NULL;
+    BDBtrfsSubvolumeInfo** ret = NULL;
+
+    /* now we know how much space to allocate for the result (subvols + NULL) */
+    ret = g_new0 (BDBtrfsSubvolumeInfo*, subvol_infos->len + 1);
+
+    /* we need to sort the subvolumes in a way that no child subvolume appears
+       in the list before its parent (sub)volume */
+
+    /* let's start by moving all top-level (sub)volumes to the beginning */
+    for (i=0; i < subvol_infos->len; i++) {
+        item = (BDBtrfsSubvolumeInfo*) g_ptr_array_index (subvol_infos, i);
+        if (item->parent_id == BD_BTRFS_MAIN_VOLUME_ID)
+            /* top-level (sub)volume */
+            ret[next_sorted_idx++] = item;
+    }
+    /* top-level (sub)volumes are now processed */
+    for (i=0; i < next_sorted_idx; i++)
+        g_ptr_array_remove_fast (subvol_infos, ret[i]);
+
+    /* now sort the rest in a way that we search for an already sorted parent or sibling */
+    for (i=0; i < subvol_infos->len; i++) {
+        item = (BDBtrfsSubvolumeInfo*) g_ptr_array_index (subvol_infos, i);
+        ret[next_sorted_idx] = item;
+        /* move the item towards beginning of the array checking if some parent
+           or sibling has been already processed/sorted before or we reached the
+           top-level (sub)volumes */
+        for (y=next_sorted_idx; (y > 0 && (ret[y-1]->id != item->parent_id) && (ret[y-1]->parent_id != item->parent_id) && (ret[y-1]->parent_id != BD_BTRFS_MAIN_VOLUME_ID)); y--) {
+            swap_item = ret[y-1];
+            ret[y-1] = ret[y];
+            ret[y] = swap_item;
+        }
+        next_sorted_idx++;
+    }
+    ret[next_sorted_idx] = NULL;
+
+    /* now just free the pointer array */
+    g_ptr_array_free (subvol_infos, TRUE);
+
+    return ret;
+}
+/* Opens @path for the ioctl-based queries. Returns -1 if @path is not a
+   directory on a mounted btrfs volume, the 'btrfs' utility has to be used in
+   such case. */
+static gint open_btrfs_dir (const gchar *path) {
+    struct statfs sfs;
+    gint fd = -1;
+
+    fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    if (fstatfs (fd, &sfs) != 0 || sfs.f_type != BTRFS_SUPER_MAGIC) {
+        close (fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static BDBtrfsDeviceInfo** list_devices_ioctl (gint fd) {
+    struct btrfs_ioctl_fs_info_args fs_info;
+    struct btrfs_ioctl_dev_info_args dev_info;
+    GPtrArray *dev_infos = NULL;
+    BDBtrfsDeviceInfo *info = NULL;
+    guint64 devid = 0;
+
+    memset (&fs_info, 0, sizeof (fs_info));
+    if (ioctl (fd, BTRFS_IOC_FS_INFO, &fs_info) != 0) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_FS_INFO failed: %m");
+        return NULL;
+    }
+
+    dev_infos = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_btrfs_device_info_free);
+    for (devid = 1; devid <= fs_info.max_id; devid++) {
+        memset (&dev_info, 0, sizeof (dev_info));
+        dev_info.devid = devid;
+        if (ioctl (fd, BTRFS_IOC_DEV_INFO, &dev_info) != 0) {
+            if (errno == ENODEV)
+                /* no device with this ID (e.g. it was removed) */
+                continue;
+            bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_DEV_INFO failed: %m");
+            g_ptr_array_free (dev_infos, TRUE);
+            return NULL;
+        }
+
+        info = g_new0 (BDBtrfsDeviceInfo, 1);
+        info->id = dev_info.devid;
+        info->path = g_strndup ((const gchar *) dev_info.path, BTRFS_DEVICE_PATH_NAME_MAX);
+        info->size = dev_info.total_bytes;
+        info->used = dev_info.bytes_used;
+        g_ptr_array_add (dev_infos, info);
+    }
+
+    if (dev_infos->len == 0) {
+        g_ptr_array_free (dev_infos, TRUE);
+        return NULL;
+    }
+
+    g_ptr_array_set_free_func (dev_infos, NULL);
+    g_ptr_array_add (dev_infos, NULL);
+    return (BDBtrfsDeviceInfo **) g_ptr_array_free (dev_infos, FALSE);
+}
+
+static BDBtrfsFilesystemInfo* filesystem_info_ioctl (gint fd) {
+    struct btrfs_ioctl_fs_info_args fs_info;
+    struct btrfs_ioctl_space_args space_args;
+    struct btrfs_ioctl_space_args *spaces = NULL;
+    gchar label[BTRFS_LABEL_SIZE + 1];
+    const guint8 *u = NULL;
+    BDBtrfsFilesystemInfo *ret = NULL;
+    guint64 i = 0;
+
+    memset (&fs_info, 0, sizeof (fs_info));
+    if (ioctl (fd, BTRFS_IOC_FS_INFO, &fs_info) != 0) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_FS_INFO failed: %m");
+        return NULL;
+    }
+
+    memset (label, 0, sizeof (label));
+    if (ioctl (fd, BTRFS_IOC_GET_FSLABEL, label) != 0) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_GET_FSLABEL failed: %m");
+        return NULL;
+    }
+
+    /* first call just to get the number of the space info items */
+    memset (&space_args, 0, sizeof (space_args));
+    if (ioctl (fd, BTRFS_IOC_SPACE_INFO, &space_args) != 0) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_SPACE_INFO failed: %m");
+        return NULL;
+    }
+    spaces = g_malloc0 (sizeof (struct btrfs_ioctl_space_args) +
+                        space_args.total_spaces * sizeof (struct btrfs_ioctl_space_info));
+    spaces->space_slots = space_args.total_spaces;
+    if (ioctl (fd, BTRFS_IOC_SPACE_INFO, spaces) != 0) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_SPACE_INFO failed: %m");
+        g_free (spaces);
+        return NULL;
+    }
+
+    ret = g_new0 (BDBtrfsFilesystemInfo, 1);
+    ret->label = g_strdup (label);
+    u = fs_info.fsid;
+    ret->uuid = g_strdup_printf ("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                                 u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7],
+                                 u[8], u[9], u[10], u[11], u[12], u[13], u[14], u[15]);
+    ret->num_devices = fs_info.num_devices;
+    /* the same value 'btrfs filesystem show' reports as 'FS bytes used' */
+    for (i = 0; i < spaces->total_spaces; i++)
+        ret->used += spaces->spaces[i].used_bytes;
+
+    g_free (spaces);
+    return ret;
+}
+
+typedef struct SubvolEntry {
+    guint64 id;
+    guint64 parent_id;
+    guint64 dirid;
+    gchar *name;
+    gboolean is_snapshot;
+    gboolean has_ref;
+    gboolean resolving;
+    gchar *path;
+} SubvolEntry;
+
+static void subvol_entry_free (SubvolEntry *entry) {
+    g_free (entry->name);
+    g_free (entry->path);
+    g_free (entry);
+}
+
+/* Returns the path of @entry relative to the top-level volume (the same one
+   'btrfs subvolume list -a' prints) or %NULL if it cannot be determined. */
+static const gchar* subvol_entry_get_path (gint fd, GHashTable *entries, SubvolEntry *entry) {
+    struct btrfs_ioctl_ino_lookup_args lookup;
+    SubvolEntry *parent = NULL;
+    const gchar *parent_path = NULL;
+
+    if (entry->path || entry->resolving)
+        /* a loop in the references shouldn't happen, but let's be safe */
+        return entry->path;
+    entry->resolving = TRUE;
+
+    if (entry->parent_id != BD_BTRFS_MAIN_VOLUME_ID) {
+        parent = g_hash_table_lookup (entries, &(entry->parent_id));
+        if (!parent || !parent->has_ref)
+            return NULL;
+        parent_path = subvol_entry_get_path (fd, entries, parent);
+        if (!parent_path)
+            return NULL;
+    }
+
+    /* path of the directory the subvolume is in (relative to its parent) */
+    memset (&lookup, 0, sizeof (lookup));
+    if (entry->dirid != BTRFS_FIRST_FREE_OBJECTID) {
+        lookup.treeid = entry->parent_id;
+        lookup.objectid = entry->dirid;
+        if (ioctl (fd, BTRFS_IOC_INO_LOOKUP, &lookup) != 0) {
+            bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_INO_LOOKUP failed: %m");
+            return NULL;
+        }
+        lookup.name[BTRFS_INO_LOOKUP_PATH_MAX - 1] = '\0';
+    }
+
+    /* lookup.name is either empty or ends with a '/' */
+    if (parent_path)
+        entry->path = g_strdup_printf ("%s/%s%s", parent_path, lookup.name, entry->name);
+    else
+        entry->path = g_strdup_printf ("%s%s", lookup.name, entry->name);
+
+    return entry->path;
+}
+
+#define TREE_SEARCH_BUF_SIZE (64 * 1024)
+
+/* Searches the root tree for the subvolumes (ROOT_ITEM and ROOT_BACKREF items),
+   processing the results batch by batch, and calls @func for every subvolume
+   found. Returns FALSE if the search fails (before @func is called). */
+static gboolean list_subvolumes_ioctl (gint fd, gboolean snapshots_only, BDBtrfsSubvolumeInfoFunc func, gpointer user_data) {
+    struct btrfs_ioctl_search_args_v2 *args = NULL;
+    struct btrfs_ioctl_search_key *sk = NULL;
+    struct btrfs_ioctl_search_header *hdr = NULL;
+    struct btrfs_root_ref *ref = NULL;
+    GHashTable *entries = NULL;
+    GHashTableIter iter;
+    SubvolEntry *entry = NULL;
+    BDBtrfsSubvolumeInfo info;
+    const gchar *path = NULL;
+    gboolean cont = TRUE;
+    gsize off = 0;
+    guint32 i = 0;
+
+    args = g_malloc0 (sizeof (struct btrfs_ioctl_search_args_v2) + TREE_SEARCH_BUF_SIZE);
+    sk = &(args->key);
+    sk->tree_id = BTRFS_ROOT_TREE_OBJECTID;
+    sk->min_objectid = BTRFS_FIRST_FREE_OBJECTID;
+    sk->max_objectid = BTRFS_LAST_FREE_OBJECTID;
+    sk->min_type = BTRFS_ROOT_ITEM_KEY;
+    sk->max_type = BTRFS_ROOT_BACKREF_KEY;
+    sk->min_offset = 0;
+    sk->max_offset = G_MAXUINT64;
+    sk->min_transid = 0;
+    sk->max_transid = G_MAXUINT64;
+
+    entries = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, (GDestroyNotify) subvol_entry_free);
+
+    while (TRUE) {
+        sk->nr_items = G_MAXUINT32;
+        args->buf_size = TREE_SEARCH_BUF_SIZE;
+        if (ioctl (fd, BTRFS_IOC_TREE_SEARCH_V2, args) != 0) {
+            bd_utils_log_format (BD_UTILS_LOG_DEBUG, "BTRFS_IOC_TREE_SEARCH_V2 failed: %m");
+            g_hash_table_destroy (entries);
+            g_free (args);
+            return FALSE;
+        }
+        if (sk->nr_items == 0)
+            break;
+
+        off = 0;
+        for (i = 0; i < sk->nr_items; i++) {
+            hdr = (struct btrfs_ioctl_search_header *) (args->buf + off);
+            off += sizeof (struct btrfs_ioctl_search_header) + hdr->len;
+
+            /* the search key range is not per-field, other items may appear */
+            if (hdr->type != BTRFS_ROOT_ITEM_KEY && hdr->type != BTRFS_ROOT_BACKREF_KEY)
+                continue;
+
+            entry = g_hash_table_lookup (entries, &(hdr->objectid));
+            if (!entry) {
+                entry = g_new0 (SubvolEntry, 1);
+                entry->id = hdr->objectid;
+                g_hash_table_insert (entries, &(entry->id), entry);
+            }
+
+            if (hdr->type == BTRFS_ROOT_ITEM_KEY)
+                /* snapshots have the transaction ID they were created in as the offset */
+                entry->is_snapshot = hdr->offset != 0;
+            else if (!entry->has_ref && hdr->len >= sizeof (struct btrfs_root_ref)) {
+                ref = (struct btrfs_root_ref *) (hdr + 1);
+                entry->parent_id = hdr->offset;
+                entry->dirid = GUINT64_FROM_LE (ref->dirid);
+                entry->name = g_strndup ((const gchar *) (ref + 1),
+                                         MIN (GUINT16_FROM_LE (ref->name_len), hdr->len - sizeof (struct btrfs_root_ref)));
+                entry->has_ref = TRUE;
+            }
+        }
+
+        /* continue right after the last item found */
+        sk->min_objectid = hdr->objectid;
+        sk->min_type = hdr->type;
+        sk->min_offset = hdr->offset;
+        if (sk->min_offset < G_MAXUINT64)
+            sk->min_offset++;
+        else if (sk->min_type < G_MAXUINT8) {
+            sk->min_type++;
+            sk->min_offset = 0;
+        } else {
+            sk->min_objectid++;
+            sk->min_type = 0;
+            sk->min_offset = 0;
+        }
+        if (sk->min_objectid > sk->max_objectid)
+            break;
+    }
+    g_free (args);
+
+    g_hash_table_iter_init (&iter, entries);
+    while (cont && g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+        /* subvolumes without a reference are deleted (but not cleaned up yet) */
+        if (!entry->has_ref || (snapshots_only && !entry->is_snapshot))
+            continue;
+
+        path = subvol_entry_get_path (fd, entries, entry);
+        if (!path) {
+            bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to get path of the subvolume %"G_GUINT64_FORMAT, entry->id);
+            continue;
+        }
+
+        info.id = entry->id;
+        info.parent_id = entry->parent_id;
+        info.path = (gchar *) path;
+        cont = func (&info, user_data);
+    }
+    g_hash_table_destroy (entries);
+
+    return TRUE;
+}
+
 /**
  * bd_btrfs_create_volume:
  * @devices: (array zero-terminated=1): list of devices to create btrfs volume from
@@ -566,6 +925,10 @@ gboolean bd_btrfs_create_snapshot (const gchar *source, const gchar *dest, gbool
  * Returns: (array zero-terminated=1): information about the devices that are part of the btrfs volume
  * containing @device or %NULL in case of error
  *
+ * If @device is a directory on a mounted btrfs volume, the information is
+ * queried directly from the kernel, the 'btrfs' utility is used otherwise (or
+ * if the ioctls fail, e.g. because of missing privileges).
+ *
  * Tech category: %BD_BTRFS_TECH_MULTI_DEV-%BD_BTRFS_TECH_MODE_QUERY
  */
 BDBtrfsDeviceInfo** bd_btrfs_list_devices (const gchar *device, GError **error) {
@@ -574,19 +937,26 @@ BDBtrfsDeviceInfo** bd_btrfs_list_devices (const gchar *device, GError **error)
     gboolean success = FALSE;
     gchar **lines = NULL;
     gchar **line_p = NULL;
-    gchar const * const pattern = "devid[ \\t]+(?P<id>\\d+)[ \\t]+" \
-                                  "size[ \\t]+(?P<size>\\S+)[ \\t]+" \
-                                  "used[ \\t]+(?P<used>\\S+)[ \\t]+" \
-                                  "path[ \\t]+(?P<path>\\S+)\n";
     GRegex *regex = NULL;
     GMatchInfo *match_info = NULL;
     GPtrArray *dev_infos;
+    BDBtrfsDeviceInfo **ret = NULL;
+    gint fd = -1;
+
+    fd = open_btrfs_dir (device);
+    if (fd >= 0) {
+        ret = list_devices_ioctl (fd);
+        close (fd);
+        if (ret)
+            return ret;
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to list devices of '%s' using ioctls, falling back to 'btrfs'", device);
+    }
 
     if (!check_deps (&avail_deps, DEPS_BTRFS_MASK, deps, DEPS_LAST, &deps_check_lock, error) ||
         !check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return NULL;
 
-    regex = g_regex_new (pattern, G_REGEX_EXTENDED, 0, error);
+    regex = g_regex_new (DEVICE_LIST_PATTERN, G_REGEX_EXTENDED, 0, error);
     if (!regex) {
         bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create new GRegex");
         /* error is already populated */
@@ -628,44 +998,55 @@ BDBtrfsDeviceInfo** bd_btrfs_list_devices (const gchar *device, GError **error)
     return (BDBtrfsDeviceInfo **) g_ptr_array_free (dev_infos, FALSE);
 }
 
-/**
- * bd_btrfs_list_subvolumes:
- * @mountpoint: a mountpoint of the queried btrfs volume
- * @snapshots_only: whether to list only snapshot subvolumes or not
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: (array zero-terminated=1): information about the subvolumes that are part of the btrfs volume
- * mounted at @mountpoint or %NULL in case of error
- *
- * The subvolumes are sorted in a way that no child subvolume appears in the
- * list before its parent (sub)volume.
- *
- * Tech category: %BD_BTRFS_TECH_SUBVOL-%BD_BTRFS_TECH_MODE_QUERY
- */
-BDBtrfsSubvolumeInfo** bd_btrfs_list_subvolumes (const gchar *mountpoint, gboolean snapshots_only, GError **error) {
+typedef struct SubvolListContext {
+    GRegex *regex;
+    BDBtrfsSubvolumeInfoFunc func;
+    gpointer user_data;
+    gboolean output;
+    gboolean parsed;
+    gboolean cont;
+} SubvolListContext;
+
+static gboolean process_subvol_list_line (const gchar *line, gboolean from_stderr, gpointer user_data) {
+    SubvolListContext *ctx = (SubvolListContext *) user_data;
+    GMatchInfo *match_info = NULL;
+    BDBtrfsSubvolumeInfo *info = NULL;
+
+    if (from_stderr)
+        /* keep it for the error message */
+        return FALSE;
+
+    if (*line)
+        ctx->output = TRUE;
+
+    if (!ctx->cont)
+        /* no more subvolumes wanted, just let the process finish */
+        return TRUE;
+
+    if (!g_regex_match (ctx->regex, line, 0, &match_info)) {
+        g_match_info_free (match_info);
+        return TRUE;
+    }
+
+    info = get_subvolume_info_from_match (match_info);
+    g_match_info_free (match_info);
+    ctx->parsed = TRUE;
+    ctx->cont = ctx->func (info, ctx->user_data);
+    bd_btrfs_subvolume_info_free (info);
+
+    return TRUE;
+}
+
+/* Runs 'btrfs subvol list' on @mountpoint and calls @func for every subvolume
+   as soon as the line with it is printed. */
+static gboolean list_subvolumes_cli (const gchar *mountpoint, gboolean snapshots_only, BDBtrfsSubvolumeInfoFunc func, gpointer user_data, GError **error) {
     const gchar *argv[8] = {"btrfs", "subvol", "list", "-a", "-p", NULL, NULL, NULL};
-    gchar *output = NULL;
     gboolean success = FALSE;
-    gchar **lines = NULL;
-    gchar **line_p = NULL;
-    gchar const * const pattern = "ID\\s+(?P<id>\\d+)\\s+gen\\s+\\d+\\s+(cgen\\s+\\d+\\s+)?" \
-                                  "parent\\s+(?P<parent_id>\\d+)\\s+top\\s+level\\s+\\d+\\s+" \
-                                  "(otime\\s+(\\d{4}-\\d{2}-\\d{2}\\s+\\d\\d:\\d\\d:\\d\\d|-)\\s+)?"\
-                                  "path\\s+(<FS_TREE>/)?(?P<path>\\S+)";
-    GRegex *regex = NULL;
-    GMatchInfo *match_info = NULL;
-    guint64 i = 0;
-    guint64 y = 0;
-    guint64 next_sorted_idx = 0;
-    GPtrArray *subvol_infos;
-    BDBtrfsSubvolumeInfo* item = NULL;
-    BDBtrfsSubvolumeInfo* swap_item = NULL;
-    BDBtrfsSubvolumeInfo** ret = NULL;
-    GError *l_error = NULL;
+    SubvolListContext ctx = {NULL, func, user_data, FALSE, FALSE, TRUE};
 
     if (!check_deps (&avail_deps, DEPS_BTRFS_MASK, deps, DEPS_LAST, &deps_check_lock, error) ||
         !check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
-        return NULL;
+        return FALSE;
 
     if (snapshots_only) {
         argv[5] = "-s";
@@ -673,87 +1054,100 @@ BDBtrfsSubvolumeInfo** bd_btrfs_list_subvolumes (const gchar *mountpoint, gboole
     } else
         argv[5] = mountpoint;
 
-    regex = g_regex_new (pattern, G_REGEX_EXTENDED, 0, error);
-    if (!regex) {
+    ctx.regex = g_regex_new (SUBVOL_LIST_PATTERN, G_REGEX_EXTENDED, 0, error);
+    if (!ctx.regex) {
         bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create new GRegex");
         /* error is already populated */
-        return NULL;
-    }
-
-    success = bd_utils_exec_and_capture_output (argv, NULL, &output, &l_error);
-    if (!success) {
-        g_regex_unref (regex);
-        if (g_error_matches (l_error,  BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
-            /* no output -> no subvolumes */
-            g_clear_error (&l_error);
-            return g_new0 (BDBtrfsSubvolumeInfo*, 1);
-        } else {
-            g_propagate_error (error, l_error);
-            return NULL;
-        }
+        return FALSE;
     }
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    subvol_infos = g_ptr_array_new ();
-    for (line_p = lines; *line_p; line_p++) {
-        success = g_regex_match (regex, *line_p, 0, &match_info);
-        if (!success) {
-            g_match_info_free (match_info);
-            continue;
-        }
+    success = bd_utils_exec_and_process_lines (argv, NULL, process_subvol_list_line, &ctx, NULL, NULL, error);
+    g_regex_unref (ctx.regex);
+    if (!success)
+        /* error is already populated */
+        return FALSE;
 
-        g_ptr_array_add (subvol_infos, get_subvolume_info_from_match (match_info));
-        g_match_info_free (match_info);
+    if (ctx.output && !ctx.parsed) {
+        g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_PARSE, "Failed to parse information about subvolumes");
+        return FALSE;
     }
 
-    g_strfreev (lines);
-    g_regex_unref (regex);
+    /* no output -> no subvolumes */
+    return TRUE;
+}
 
-    if (subvol_infos->len == 0) {
-        g_set_error (error, BD_BTRFS_ERROR, BD_BTRFS_ERROR_PARSE, "Failed to parse information about subvolumes");
-        g_ptr_array_free (subvol_infos, TRUE);
-        return NULL;
+static gboolean list_subvolumes (const gchar *mountpoint, gboolean snapshots_only, BDBtrfsSubvolumeInfoFunc func, gpointer user_data, GError **error) {
+    gint fd = -1;
+    gboolean success = FALSE;
+
+    fd = open_btrfs_dir (mountpoint);
+    if (fd >= 0) {
+        success = list_subvolumes_ioctl (fd, snapshots_only, func, user_data);
+        close (fd);
+        if (success)
+            return TRUE;
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to list subvolumes of '%s' using ioctls, falling back to 'btrfs'", mountpoint);
     }
 
-    /* now we know how much space to allocate for the result (subvols + NULL) */
-    ret = g_new0 (BDBtrfsSubvolumeInfo*, subvol_infos->len + 1);
+    return list_subvolumes_cli (mountpoint, snapshots_only, func, user_data, error);
+}
 
-    /* we need to sort the subvolumes in a way that no child subvolume appears
-       in the list before its parent (sub)volume */
+static gboolean collect_subvolume (BDBtrfsSubvolumeInfo *info, gpointer user_data) {
+    g_ptr_array_add ((GPtrArray *) user_data, bd_btrfs_subvolume_info_copy (info));
+    return TRUE;
+}
 
-    /* let's start by moving all top-level (sub)volumes to the beginning */
-    for (i=0; i < subvol_infos->len; i++) {
-        item = (BDBtrfsSubvolumeInfo*) g_ptr_array_index (subvol_infos, i);
-        if (item->parent_id == BD_BTRFS_MAIN_VOLUME_ID)
-            /* top-level (sub)volume */
-            ret[next_sorted_idx++] = item;
-    }
-    /* top-level (sub)volumes are now processed */
-    for (i=0; i < next_sorted_idx; i++)
-        g_ptr_array_remove_fast (subvol_infos, ret[i]);
+/**
+ * bd_btrfs_list_subvolumes:
+ * @mountpoint: a mountpoint of the queried btrfs volume
+ * @snapshots_only: whether to list only snapshot subvolumes or not
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (array zero-terminated=1): information about the subvolumes that are part of the btrfs volume
+ * mounted at @mountpoint or %NULL in case of error
+ *
+ * The subvolumes are sorted in a way that no child subvolume appears in the
+ * list before its parent (sub)volume.
+ *
+ * The subvolumes are looked up in the volume's root tree directly, the 'btrfs'
+ * utility is only used if that fails (e.g. because of missing privileges).
+ *
+ * Tech category: %BD_BTRFS_TECH_SUBVOL-%BD_BTRFS_TECH_MODE_QUERY
+ */
+BDBtrfsSubvolumeInfo** bd_btrfs_list_subvolumes (const gchar *mountpoint, gboolean snapshots_only, GError **error) {
+    GPtrArray *subvol_infos = NULL;
 
-    /* now sort the rest in a way that we search for an already sorted parent or sibling */
-    for (i=0; i < subvol_infos->len; i++) {
-        item = (BDBtrfsSubvolumeInfo*) g_ptr_array_index (subvol_infos, i);
-        ret[next_sorted_idx] = item;
-        /* move the item towards beginning of the array checking if some parent
-           or sibling has been already processed/sorted before or we reached the
-           top-level (sub)volumes */
-        for (y=next_sorted_idx; (y > 0 && (ret[y-1]->id != item->parent_id) && (ret[y-1]->parent_id != item->parent_id) && (ret[y-1]->parent_id != BD_BTRFS_MAIN_VOLUME_ID)); y--) {
-            swap_item = ret[y-1];
-            ret[y-1] = ret[y];
-            ret[y] = swap_item;
-        }
-        next_sorted_idx++;
+    subvol_infos = g_ptr_array_new ();
+    if (!list_subvolumes (mountpoint, snapshots_only, collect_subvolume, subvol_infos, error)) {
+        g_ptr_array_set_free_func (subvol_infos, (GDestroyNotify) bd_btrfs_subvolume_info_free);
+        g_ptr_array_free (subvol_infos, TRUE);
+        return NULL;
     }
-    ret[next_sorted_idx] = NULL;
 
-    /* now just free the pointer array */
-    g_ptr_array_free (subvol_infos, TRUE);
+    return sort_subvolumes (subvol_infos);
+}
 
-    return ret;
+/**
+ * bd_btrfs_list_subvolumes_foreach:
+ * @mountpoint: a mountpoint of the queried btrfs volume
+ * @snapshots_only: whether to list only snapshot subvolumes or not
+ * @func: (scope call): function to call for every subvolume found
+ * @user_data: (closure): data to pass to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Calls @func for every subvolume of the btrfs volume mounted at @mountpoint
+ * as soon as it is found. Unlike with bd_btrfs_list_subvolumes(), the
+ * subvolumes are not sorted. The information is only valid during the call of
+ * @func, use bd_btrfs_subvolume_info_copy() to keep it. If @func returns
+ * %FALSE, no more subvolumes are reported.
+ *
+ * Returns: whether the subvolumes were successfully listed or not (stopping
+ *          the listing from @func is not an error)
+ *
+ * Tech category: %BD_BTRFS_TECH_SUBVOL-%BD_BTRFS_TECH_MODE_QUERY
+ */
+gboolean bd_btrfs_list_subvolumes_foreach (const gchar *mountpoint, gboolean snapshots_only, BDBtrfsSubvolumeInfoFunc func, gpointer user_data, GError **error) {
+    return list_subvolumes (mountpoint, snapshots_only, func, user_data, error);
 }
 
 /**
@@ -763,25 +1157,35 @@ BDBtrfsSubvolumeInfo** bd_btrfs_list_subvolumes (const gchar *mountpoint, gboole
  *
  * Returns: information about the @device's volume's filesystem or %NULL in case of error
  *
+ * If @device is a directory on a mounted btrfs volume, the information is
+ * queried directly from the kernel, the 'btrfs' utility is used otherwise (or
+ * if the ioctls fail).
+ *
  * Tech category: %BD_BTRFS_TECH_FS-%BD_BTRFS_TECH_MODE_QUERY
  */
 BDBtrfsFilesystemInfo* bd_btrfs_filesystem_info (const gchar *device, GError **error) {
     const gchar *argv[5] = {"btrfs", "filesystem", "show", device, NULL};
     gchar *output = NULL;
     gboolean success = FALSE;
-    gchar const * const pattern = "Label:\\s+(none|'(?P<label>.+)')\\s+" \
-                                  "uuid:\\s+(?P<uuid>\\S+)\\s+" \
-                                  "Total\\sdevices\\s+(?P<num_devices>\\d+)\\s+" \
-                                  "FS\\sbytes\\sused\\s+(?P<used>\\S+)";
     GRegex *regex = NULL;
     GMatchInfo *match_info = NULL;
     BDBtrfsFilesystemInfo *ret = NULL;
+    gint fd = -1;
+
+    fd = open_btrfs_dir (device);
+    if (fd >= 0) {
+        ret = filesystem_info_ioctl (fd);
+        close (fd);
+        if (ret)
+            return ret;
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to get filesystem info of '%s' using ioctls, falling back to 'btrfs'", device);
+    }
 
     if (!check_deps (&avail_deps, DEPS_BTRFS_MASK, deps, DEPS_LAST, &deps_check_lock, error) ||
         !check_module_deps (&avail_module_deps, MODULE_DEPS_BTRFS_MASK, module_deps, MODULE_DEPS_LAST, &deps_check_lock, error))
         return NULL;
 
-    regex = g_regex_new (pattern, G_REGEX_EXTENDED, 0, error);
+    regex = g_regex_new (FILESYSTEM_INFO_PATTERN, G_REGEX_EXTENDED, 0, error);
     if (!regex) {
         bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create new GRegex");
         /* error is already populated */
@@ -35,6 +35,8 @@ typedef struct BDBtrfsSubvolumeInfo {
 void bd_btrfs_subvolume_info_free (BDBtrfsSubvolumeInfo *info);
 BDBtrfsSubvolumeInfo* bd_btrfs_subvolume_info_copy (BDBtrfsSubvolumeInfo *info);
 
+typedef gboolean (*BDBtrfsSubvolumeInfoFunc) (BDBtrfsSubvolumeInfo *info, gpointer user_data);
+
 typedef struct BDBtrfsFilesystemInfo {
     gchar *label;
     gchar *uuid;
@@ -83,6 +85,7 @@ gboolean bd_btrfs_set_default_subvolume (const gchar *mountpoint, guint64 subvol
 gboolean bd_btrfs_create_snapshot (const gchar *source, const gchar *dest, gboolean ro, const BDExtraArg **extra, GError **error);
 BDBtrfsDeviceInfo** bd_btrfs_list_devices (const gchar *device, GError **error);
 BDBtrfsSubvolumeInfo** bd_btrfs_list_subvolumes (const gchar *mountpoint, gboolean snapshots_only, GError **error);
+gboolean bd_btrfs_list_subvolumes_foreach (const gchar *mountpoint, gboolean snapshots_only, BDBtrfsSubvolumeInfoFunc func, gpointer user_data, GError **error);
 BDBtrfsFilesystemInfo* bd_btrfs_filesystem_info (const gchar *device, GError **error);
 
 gboolean bd_btrfs_mkfs (const gchar **devices, const gchar *label, const gchar *data_level, const gchar *md_level, const BDExtraArg **extra, GError **error);
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "cache_settings.h"
+
+/* Translation of the typed cache settings to the LVM options, shared by both
+ * the LVM plugin implementations (lvmdbusd passes the extra options to the
+ * LVM commands as they are). The dm-cache policy and policy settings together
+ * with the writecache tunables all go to the single '--cachesettings' option
+ * LVM stores in the metadata of the cached LV. */
+
+#define MIN_CHUNK_SIZE (32 KiB)
+#define MAX_CHUNK_SIZE (1 GiB)
+
+void bd_lvm_cache_settings_free (BDLVMCacheSettings *settings) {
+    if (settings == NULL)
+        return;
+
+    g_free (settings->policy);
+    g_free (settings->policy_settings);
+    g_free (settings);
+}
+
+BDLVMCacheSettings* bd_lvm_cache_settings_copy (BDLVMCacheSettings *settings) {
+    BDLVMCacheSettings *new_settings = NULL;
+
+    if (settings == NULL)
+        return NULL;
+
+    new_settings = g_new0 (BDLVMCacheSettings, 1);
+    *new_settings = *settings;
+    new_settings->policy = g_strdup (settings->policy);
+    new_settings->policy_settings = g_strdup (settings->policy_settings);
+
+    return new_settings;
+}
+
+static gboolean check_settings (const BDLVMCacheSettings *settings, CacheSettingsType type, gboolean attach, GError **error) {
+    gboolean cache = settings->chunk_size != 0 || settings->migration_threshold != 0 || settings->policy;
+    gboolean writecache = settings->high_watermark != 0 || settings->low_watermark != 0 || settings->writeback_jobs != 0 ||
+                          settings->autocommit_blocks != 0 || settings->autocommit_time != 0;
+
+    if (type == CACHE_SETTINGS_CACHE && writecache) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                     "Writecache settings cannot be used for a dm-cache");
+        return FALSE;
+    }
+    if (type == CACHE_SETTINGS_WRITECACHE && cache) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                     "Chunk size, migration threshold and policy cannot be used for a writecache");
+        return FALSE;
+    }
+
+    if (settings->chunk_size != 0) {
+        if (!attach) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                         "Chunk size of an existing cache cannot be changed");
+            return FALSE;
+        }
+        if (settings->chunk_size < MIN_CHUNK_SIZE || settings->chunk_size > MAX_CHUNK_SIZE ||
+            settings->chunk_size % MIN_CHUNK_SIZE != 0) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                         "Invalid chunk size %"G_GUINT64_FORMAT": needs to be a multiple of 32 KiB between 32 KiB and 1 GiB",
+                         settings->chunk_size);
+            return FALSE;
+        }
+    }
+
+    if (settings->migration_threshold % 512 != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                     "Invalid migration threshold %"G_GUINT64_FORMAT": needs to be a multiple of 512 bytes",
+                     settings->migration_threshold);
+        return FALSE;
+    }
+
+    if (settings->high_watermark > 100 || settings->low_watermark > 100 ||
+        (settings->high_watermark != 0 && settings->low_watermark > settings->high_watermark)) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                     "Invalid watermarks %u%% (high) and %u%% (low): need to be percents with the low one not above the high one",
+                     settings->high_watermark, settings->low_watermark);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * cache_settings_to_extra: (skip)
+ * @settings: (nullable): settings to translate
+ * @type: type of the cache the @settings are for
+ * @attach: whether the @settings are for attaching a new cache (or for
+ *          changing the settings of an existing one)
+ * @extra: (nullable) (array zero-terminated=1): extra options to append
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the LVM options for
+ *          @settings followed by (copies of) @extra or %NULL in case of error
+ */
+BDExtraArg** cache_settings_to_extra (const BDLVMCacheSettings *settings, CacheSettingsType type, gboolean attach,
+                                      const BDExtraArg **extra, GError **error) {
+    GPtrArray *args = NULL;
+    GString *cache_settings = NULL;
+    const BDExtraArg **extra_p = NULL;
+    gchar *value = NULL;
+
+    if (settings && !check_settings (settings, type, attach, error))
+        return NULL;
+
+    args = g_ptr_array_new ();
+    if (settings) {
+        if (settings->chunk_size != 0) {
+            value = g_strdup_printf ("%"G_GUINT64_FORMAT"K", settings->chunk_size / 1024);
+            g_ptr_array_add (args, bd_extra_arg_new ("--chunksize", value));
+            g_free (value);
+        }
+        if (settings->policy)
+            g_ptr_array_add (args, bd_extra_arg_new ("--cachepolicy", settings->policy));
+
+        cache_settings = g_string_new (NULL);
+        if (settings->migration_threshold != 0)
+            /* in sectors */
+            g_string_append_printf (cache_settings, " migration_threshold=%"G_GUINT64_FORMAT, settings->migration_threshold / 512);
+        if (settings->high_watermark != 0)
+            g_string_append_printf (cache_settings, " high_watermark=%u", settings->high_watermark);
+        if (settings->low_watermark != 0)
+            g_string_append_printf (cache_settings, " low_watermark=%u", settings->low_watermark);
+        if (settings->writeback_jobs != 0)
+            g_string_append_printf (cache_settings, " writeback_jobs=%"G_GUINT64_FORMAT, settings->writeback_jobs);
+        if (settings->autocommit_blocks != 0)
+            g_string_append_printf (cache_settings, " autocommit_blocks=%"G_GUINT64_FORMAT, settings->autocommit_blocks);
+        if (settings->autocommit_time != 0)
+            g_string_append_printf (cache_settings, " autocommit_time=%"G_GUINT64_FORMAT, settings->autocommit_time);
+        if (settings->policy_settings && *(settings->policy_settings))
+            g_string_append_printf (cache_settings, " %s", settings->policy_settings);
+
+        if (cache_settings->len > 0)
+            g_ptr_array_add (args, bd_extra_arg_new ("--cachesettings", cache_settings->str + 1));
+        g_string_free (cache_settings, TRUE);
+    }
+
+    if (extra)
+        for (extra_p = extra; *extra_p; extra_p++)
+            g_ptr_array_add (args, bd_extra_arg_copy ((BDExtraArg *) *extra_p));
+    g_ptr_array_add (args, NULL);
+
+    return (BDExtraArg **) g_ptr_array_free (args, FALSE);
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "lvm.h"
+
+#ifndef BD_CACHE_SETTINGS
+#define BD_CACHE_SETTINGS
+
+typedef enum {
+    CACHE_SETTINGS_CACHE,
+    CACHE_SETTINGS_WRITECACHE,
+    /* type of the cache not known (existing cached LV), let LVM check it */
+    CACHE_SETTINGS_ANY,
+} CacheSettingsType;
+
+BDExtraArg** cache_settings_to_extra (const BDLVMCacheSettings *settings, CacheSettingsType type, gboolean attach,
+                                      const BDExtraArg **extra, GError **error);
+
+#endif  /* BD_CACHE_SETTINGS */
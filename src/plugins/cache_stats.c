@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <libdevmapper.h>
+#include <blockdev/utils.h>
+
+#include "cache_stats.h"
+#include "dm_snapshot.h"
+
+/* Sampling of the dm-cache and writecache statistics, the DM map name is
+ * resolved only once when the sampler is created and every sample then means
+ * just a single DM_DEVICE_STATUS call for the map. The counters from the
+ * previous sample are kept in the sampler to compute the deltas and rates. */
+
+/* writecache status: error, total blocks, free blocks, blocks under writeback
+ * and (since kernel 5.15) reads, read hits, writes, write hits (uncommitted),
+ * write hits (committed), ... */
+static gboolean parse_writecache_status (const gchar *status, CacheCounters *counters) {
+    gchar **fields = NULL;
+    guint n_fields = 0;
+    guint64 total = 0;
+    guint64 free_blocks = 0;
+    guint64 reads = 0;
+    guint64 writes = 0;
+
+    fields = g_strsplit (status, " ", -1);
+    n_fields = g_strv_length (fields);
+    if (n_fields < 4) {
+        g_strfreev (fields);
+        return FALSE;
+    }
+
+    total = g_ascii_strtoull (fields[1], NULL, 10);
+    free_blocks = g_ascii_strtoull (fields[2], NULL, 10);
+    counters->dirty_blocks = total > free_blocks ? total - free_blocks : 0;
+
+    if (n_fields >= 9) {
+        reads = g_ascii_strtoull (fields[4], NULL, 10);
+        counters->read_hits = g_ascii_strtoull (fields[5], NULL, 10);
+        counters->read_misses = reads > counters->read_hits ? reads - counters->read_hits : 0;
+        writes = g_ascii_strtoull (fields[6], NULL, 10);
+        counters->write_hits = g_ascii_strtoull (fields[7], NULL, 10) + g_ascii_strtoull (fields[8], NULL, 10);
+        counters->write_misses = writes > counters->write_hits ? writes - counters->write_hits : 0;
+    }
+
+    g_strfreev (fields);
+    return TRUE;
+}
+
+gboolean cache_stats_read_counters (const gchar *map_name, CacheCounters *counters, GError **error) {
+    DMSnapshotMap *map = NULL;
+    struct dm_pool *pool = NULL;
+    struct dm_status_cache *status = NULL;
+
+    memset (counters, 0, sizeof (CacheCounters));
+
+    map = dm_snapshot_map_status (map_name);
+    if (!map) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_NOCACHE,
+                     "The cache map '%s' doesn't exist", map_name);
+        return FALSE;
+    }
+    counters->timestamp = g_get_monotonic_time ();
+
+    if (g_strcmp0 (map->target_type, "cache") == 0) {
+        pool = dm_pool_create ("bd-pool", 20);
+        if (dm_get_status_cache (pool, map->status, &status) == 0) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                         "Failed to get status of the cache map '%s'", map_name);
+            dm_pool_destroy (pool);
+            dm_snapshot_map_free (map);
+            return FALSE;
+        }
+
+        counters->read_hits = status->read_hits;
+        counters->read_misses = status->read_misses;
+        counters->write_hits = status->write_hits;
+        counters->write_misses = status->write_misses;
+        counters->promotions = status->promotions;
+        counters->demotions = status->demotions;
+        counters->dirty_blocks = status->dirty_blocks;
+        dm_pool_destroy (pool);
+    } else if (g_strcmp0 (map->target_type, "writecache") == 0) {
+        counters->writecache = TRUE;
+        if (!parse_writecache_status (map->status, counters)) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
+                         "Failed to get status of the writecache map '%s'", map_name);
+            dm_snapshot_map_free (map);
+            return FALSE;
+        }
+    } else {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_NOCACHE,
+                     "The map '%s' is not a cache map", map_name);
+        dm_snapshot_map_free (map);
+        return FALSE;
+    }
+
+    dm_snapshot_map_free (map);
+    return TRUE;
+}
+
+/* counters may go back if the cache was reloaded, the new value is the delta then */
+static inline guint64 counter_delta (guint64 prev, guint64 cur) {
+    return cur >= prev ? cur - prev : cur;
+}
+
+static gdouble hit_ratio (guint64 hits, guint64 misses) {
+    return (hits + misses) > 0 ? (gdouble) hits / (gdouble) (hits + misses) : 0.0;
+}
+
+BDLVMCacheSampler* cache_sampler_new (const gchar *vg_name, const gchar *lv_name, const gchar *map_name, GError **error) {
+    BDLVMCacheSampler *sampler = NULL;
+    CacheCounters *counters = g_new0 (CacheCounters, 1);
+
+    /* take the first status as a base for the first sample (and to check the
+       map is there and is a cache) */
+    if (!cache_stats_read_counters (map_name, counters, error)) {
+        g_free (counters);
+        return NULL;
+    }
+
+    sampler = g_new0 (BDLVMCacheSampler, 1);
+    sampler->vg_name = g_strdup (vg_name);
+    sampler->lv_name = g_strdup (lv_name);
+    sampler->map_name = g_strdup (map_name);
+    sampler->ref_count = 1;
+    g_mutex_init (&(sampler->lock));
+    sampler->last = counters;
+
+    return sampler;
+}
+
+BDLVMCacheSample* cache_sampler_sample (BDLVMCacheSampler *sampler, GError **error) {
+    CacheCounters cur;
+    CacheCounters *prev = NULL;
+    BDLVMCacheSample *sample = NULL;
+
+    g_mutex_lock (&(sampler->lock));
+    if (!cache_stats_read_counters (sampler->map_name, &cur, error)) {
+        g_mutex_unlock (&(sampler->lock));
+        return NULL;
+    }
+    prev = (CacheCounters *) sampler->last;
+
+    sample = g_new0 (BDLVMCacheSample, 1);
+    sample->writecache = cur.writecache;
+    sample->interval = (gdouble) (cur.timestamp - prev->timestamp) / G_USEC_PER_SEC;
+
+    sample->read_hits = cur.read_hits;
+    sample->read_misses = cur.read_misses;
+    sample->write_hits = cur.write_hits;
+    sample->write_misses = cur.write_misses;
+    sample->promotions = cur.promotions;
+    sample->demotions = cur.demotions;
+    sample->dirty_blocks = cur.dirty_blocks;
+
+    sample->read_hits_delta = counter_delta (prev->read_hits, cur.read_hits);
+    sample->read_misses_delta = counter_delta (prev->read_misses, cur.read_misses);
+    sample->write_hits_delta = counter_delta (prev->write_hits, cur.write_hits);
+    sample->write_misses_delta = counter_delta (prev->write_misses, cur.write_misses);
+    sample->promotions_delta = counter_delta (prev->promotions, cur.promotions);
+    sample->demotions_delta = counter_delta (prev->demotions, cur.demotions);
+
+    if (sample->interval > 0) {
+        sample->read_hits_rate = sample->read_hits_delta / sample->interval;
+        sample->read_misses_rate = sample->read_misses_delta / sample->interval;
+        sample->write_hits_rate = sample->write_hits_delta / sample->interval;
+        sample->write_misses_rate = sample->write_misses_delta / sample->interval;
+        sample->promotions_rate = sample->promotions_delta / sample->interval;
+        sample->demotions_rate = sample->demotions_delta / sample->interval;
+    }
+
+    sample->read_hit_ratio = hit_ratio (sample->read_hits_delta, sample->read_misses_delta);
+    sample->write_hit_ratio = hit_ratio (sample->write_hits_delta, sample->write_misses_delta);
+
+    *prev = cur;
+    g_mutex_unlock (&(sampler->lock));
+
+    return sample;
+}
+
+void bd_lvm_cache_sampler_free (BDLVMCacheSampler *sampler) {
+    if (sampler == NULL)
+        return;
+
+    if (!g_atomic_int_dec_and_test (&(sampler->ref_count)))
+        return;
+
+    g_free (sampler->vg_name);
+    g_free (sampler->lv_name);
+    g_free (sampler->map_name);
+    g_free (sampler->last);
+    g_mutex_clear (&(sampler->lock));
+    g_free (sampler);
+}
+
+BDLVMCacheSampler* bd_lvm_cache_sampler_copy (BDLVMCacheSampler *sampler) {
+    if (sampler == NULL)
+        return NULL;
+
+    g_atomic_int_inc (&(sampler->ref_count));
+    return sampler;
+}
+
+void bd_lvm_cache_sample_free (BDLVMCacheSample *sample) {
+    g_free (sample);
+}
+
+BDLVMCacheSample* bd_lvm_cache_sample_copy (BDLVMCacheSample *sample) {
+    BDLVMCacheSample *new_sample = NULL;
+
+    if (sample == NULL)
+        return NULL;
+
+    new_sample = g_new0 (BDLVMCacheSample, 1);
+    *new_sample = *sample;
+
+    return new_sample;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "lvm.h"
+
+#ifndef BD_CACHE_STATS
+#define BD_CACHE_STATS
+
+/* raw counters from the status of a dm-cache or writecache map */
+typedef struct CacheCounters {
+    /* monotonic time when the status was taken (in microseconds) */
+    gint64 timestamp;
+    gboolean writecache;
+    guint64 read_hits;
+    guint64 read_misses;
+    guint64 write_hits;
+    guint64 write_misses;
+    guint64 promotions;
+    guint64 demotions;
+    guint64 dirty_blocks;
+} CacheCounters;
+
+gboolean cache_stats_read_counters (const gchar *map_name, CacheCounters *counters, GError **error);
+
+BDLVMCacheSampler* cache_sampler_new (const gchar *vg_name, const gchar *lv_name, const gchar *map_name, GError **error);
+BDLVMCacheSample* cache_sampler_sample (BDLVMCacheSampler *sampler, GError **error);
+
+#endif  /* BD_CACHE_STATS */
@@ -32,6 +32,7 @@ check_deps (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_spec
     gboolean ret = FALSE;
     GError *l_error = NULL;
     guint val = 0;
+    BDUtilsTimingSpan span;
 
     val = (guint) g_atomic_int_get (avail_deps);
     if ((val & req_deps) == req_deps)
@@ -51,8 +52,10 @@ check_deps (volatile guint *avail_deps, guint req_deps, const UtilDep *deps_spec
 
     for (i=0; i < l_deps; i++) {
         if (((1 << i) & req_deps) && !((1 << i) & val)) {
+            bd_utils_timing_span_begin (&span, NULL, "check_deps");
             ret = bd_utils_check_util_version (deps_specs[i].name, deps_specs[i].version,
                                                deps_specs[i].ver_arg, deps_specs[i].ver_regexp, &l_error);
+            bd_utils_timing_span_end (&span, 0, deps_specs[i].name, 0, ret ? 0 : -1);
             /* if not ret and l_error -> set/prepend error */
             if (!ret) {
                 if (error) {
@@ -17,7 +17,9 @@
  * Author: Vratislav Podzimek <vpodzime@redhat.com>
  */
 
+#define _GNU_SOURCE
 #include <string.h>
+#include <stdlib.h>
 #include <glib.h>
 #include <libcryptsetup.h>
 #include <fcntl.h>
@@ -28,6 +30,8 @@
 #include <errno.h>
 #include <blkid.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
 #include <keyutils.h>
 #include <blockdev/utils.h>
 
@@ -37,6 +41,10 @@
 #endif
 
 #include "crypto.h"
+/* internal, not installed with the public utils headers */
+#include "../utils/io_engine.h"
+#include "../utils/parallel.h"
+#include "../utils/probe.h"
 
 #ifdef __clang__
 #define ZERO_INIT {}
@@ -52,6 +60,9 @@
 #define SQUARE_LOWER_LIMIT 136
 #define SQUARE_UPPER_LIMIT 426
 #define SQUARE_BYTES_TO_CHECK 512
+/* aligned for O_DIRECT on devices with up to 4 KiB logical sectors */
+#define SQUARE_SAMPLE_ALIGN 4096
+#define SQUARE_DEFAULT_SAMPLES 4
 
 #ifdef LIBCRYPTSETUP_24
 /* 0 for autodetect since 2.4.0 */
@@ -169,6 +180,52 @@ BDCryptoIntegrityExtra* bd_crypto_integrity_extra_new (guint32 sector_size, guin
     return ret;
 }
 
+BDCryptoLUKSReencryptParams* bd_crypto_luks_reencrypt_params_copy (BDCryptoLUKSReencryptParams *params) {
+    if (params == NULL)
+        return NULL;
+
+    BDCryptoLUKSReencryptParams *new_params = g_new0 (BDCryptoLUKSReencryptParams, 1);
+
+    new_params->key_size = params->key_size;
+    new_params->cipher = g_strdup (params->cipher);
+    new_params->cipher_mode = g_strdup (params->cipher_mode);
+    new_params->resilience = g_strdup (params->resilience);
+    new_params->hash = g_strdup (params->hash);
+    new_params->max_hotzone_size = params->max_hotzone_size;
+    new_params->max_bandwidth = params->max_bandwidth;
+    new_params->offline = params->offline;
+    new_params->pbkdf = bd_crypto_luks_pbkdf_copy (params->pbkdf);
+
+    return new_params;
+}
+
+void bd_crypto_luks_reencrypt_params_free (BDCryptoLUKSReencryptParams *params) {
+    if (params == NULL)
+        return;
+
+    g_free (params->cipher);
+    g_free (params->cipher_mode);
+    g_free (params->resilience);
+    g_free (params->hash);
+    bd_crypto_luks_pbkdf_free (params->pbkdf);
+    g_free (params);
+}
+
+BDCryptoLUKSReencryptParams* bd_crypto_luks_reencrypt_params_new (guint32 key_size, const gchar *cipher, const gchar *cipher_mode, const gchar *resilience, const gchar *hash, guint64 max_hotzone_size, guint64 max_bandwidth, gboolean offline, BDCryptoLUKSPBKDF *pbkdf) {
+    BDCryptoLUKSReencryptParams *ret = g_new0 (BDCryptoLUKSReencryptParams, 1);
+    ret->key_size = key_size;
+    ret->cipher = g_strdup (cipher);
+    ret->cipher_mode = g_strdup (cipher_mode);
+    ret->resilience = g_strdup (resilience);
+    ret->hash = g_strdup (hash);
+    ret->max_hotzone_size = max_hotzone_size;
+    ret->max_bandwidth = max_bandwidth;
+    ret->offline = offline;
+    ret->pbkdf = bd_crypto_luks_pbkdf_copy (pbkdf);
+
+    return ret;
+}
+
 BDCryptoIntegrityExtra* bd_crypto_integrity_extra_copy (BDCryptoIntegrityExtra *extra) {
     if (extra == NULL)
         return NULL;
@@ -182,6 +239,8 @@ BDCryptoIntegrityExtra* bd_crypto_integrity_extra_copy (BDCryptoIntegrityExtra *
     new_extra->interleave_sectors = extra->interleave_sectors;
     new_extra->tag_size = extra->tag_size;
     new_extra->buffer_sectors = extra->buffer_sectors;
+    new_extra->bitmap_sectors_per_bit = extra->bitmap_sectors_per_bit;
+    new_extra->bitmap_flush_time = extra->bitmap_flush_time;
 
     return new_extra;
 }
@@ -300,6 +359,53 @@ BDCryptoLUKSTokenInfo* bd_crypto_luks_token_info_copy (BDCryptoLUKSTokenInfo *in
     return new_info;
 }
 
+void bd_crypto_bulk_result_free (BDCryptoBulkResult *result) {
+    if (result == NULL)
+        return;
+
+    g_free (result->device);
+    if (result->error)
+        g_error_free (result->error);
+    g_free (result);
+}
+
+BDCryptoBulkResult* bd_crypto_bulk_result_copy (BDCryptoBulkResult *result) {
+    if (result == NULL)
+        return NULL;
+
+    BDCryptoBulkResult *new_result = g_new0 (BDCryptoBulkResult, 1);
+
+    new_result->device = g_strdup (result->device);
+    if (result->error)
+        new_result->error = g_error_copy (result->error);
+
+    return new_result;
+}
+
+void bd_crypto_seems_encrypted_result_free (BDCryptoSeemsEncryptedResult *result) {
+    if (result == NULL)
+        return;
+
+    g_free (result->device);
+    if (result->error)
+        g_error_free (result->error);
+    g_free (result);
+}
+
+BDCryptoSeemsEncryptedResult* bd_crypto_seems_encrypted_result_copy (BDCryptoSeemsEncryptedResult *result) {
+    if (result == NULL)
+        return NULL;
+
+    BDCryptoSeemsEncryptedResult *new_result = g_new0 (BDCryptoSeemsEncryptedResult, 1);
+
+    new_result->device = g_strdup (result->device);
+    new_result->seems_encrypted = result->seems_encrypted;
+    if (result->error)
+        new_result->error = g_error_copy (result->error);
+
+    return new_result;
+}
+
 /* "C" locale to get the locale-agnostic error messages */
 static locale_t c_locale = (locale_t) 0;
 
@@ -329,6 +435,155 @@ static void crypto_log_redirect (gint level, const gchar *msg, void *usrptr G_GN
     }
 }
 
+/*
+ * Small LRU cache of loaded LUKS headers (contexts) used by the query functions
+ * to avoid crypt_init() and crypt_load() -- reading, parsing and verifying the
+ * (LUKS 2 JSON) header -- on every call. A cached context is only used if
+ * the device is still the same one and the beginning of the header is unchanged.
+ * For LUKS 2 that covers the header sequence ID and checksum (of the whole
+ * metadata area), for LUKS 1 the whole header with keyslots information.
+ *
+ * Contexts are removed from the cache while being used so each of them is only
+ * ever used by one thread at a time.
+ */
+#define HEADER_CACHE_SIZE 32
+#define HEADER_SIG_SIZE 4096
+
+typedef struct CachedHeader {
+    gchar *device;
+    dev_t rdev;
+    ino_t ino;
+    guint8 sig[HEADER_SIG_SIZE];
+    struct crypt_device *cd;
+} CachedHeader;
+
+static GMutex header_cache_lock;
+static GQueue header_cache = G_QUEUE_INIT;
+
+static void cached_header_free (CachedHeader *entry) {
+    if (!entry)
+        return;
+
+    g_free (entry->device);
+    crypt_free (entry->cd);
+    g_free (entry);
+}
+
+static gboolean read_header_sig (const gchar *device, dev_t *rdev, ino_t *ino, guint8 *sig) {
+    struct stat st;
+    gssize ret = 0;
+    gint fd = -1;
+
+    fd = open (device, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return FALSE;
+
+    if (fstat (fd, &st) != 0) {
+        close (fd);
+        return FALSE;
+    }
+    *rdev = st.st_rdev;
+    *ino = st.st_ino;
+
+    ret = pread (fd, sig, HEADER_SIG_SIZE, 0);
+    close (fd);
+
+    return ret == HEADER_SIG_SIZE;
+}
+
+static gint cached_header_cmp (gconstpointer entry, gconstpointer device) {
+    return g_strcmp0 (((CachedHeader *) entry)->device, (const gchar *) device);
+}
+
+/**
+ * header_cache_acquire: (skip)
+ * @device: LUKS device to get a loaded context for
+ *
+ * Returns: (transfer full): a cached (or a newly loaded) LUKS context for @device or
+ *                           %NULL if @device cannot be loaded as LUKS
+ *
+ * Give the returned entry back with header_cache_release().
+ */
+static CachedHeader* header_cache_acquire (const gchar *device) {
+    CachedHeader *entry = NULL;
+    CachedHeader *cached = NULL;
+    GList *item = NULL;
+    gboolean have_sig = FALSE;
+    gint ret = 0;
+
+    entry = g_new0 (CachedHeader, 1);
+    entry->device = g_strdup (device);
+    /* read before loading the header -- a change in between is detected the next time */
+    have_sig = read_header_sig (device, &(entry->rdev), &(entry->ino), entry->sig);
+
+    if (have_sig) {
+        g_mutex_lock (&header_cache_lock);
+        item = g_queue_find_custom (&header_cache, device, cached_header_cmp);
+        if (item) {
+            cached = item->data;
+            g_queue_delete_link (&header_cache, item);
+        }
+        g_mutex_unlock (&header_cache_lock);
+
+        if (cached) {
+            if (cached->rdev == entry->rdev && cached->ino == entry->ino &&
+                memcmp (cached->sig, entry->sig, HEADER_SIG_SIZE) == 0) {
+                cached_header_free (entry);
+                return cached;
+            }
+            cached_header_free (cached);
+        }
+    }
+
+    ret = crypt_init (&(entry->cd), device);
+    if (ret == 0)
+        ret = crypt_load (entry->cd, CRYPT_LUKS, NULL);
+    if (ret != 0) {
+        cached_header_free (entry);
+        return NULL;
+    }
+
+    if (!have_sig) {
+        /* cannot be validated later, don't cache it */
+        g_free (entry->device);
+        entry->device = NULL;
+    }
+
+    return entry;
+}
+
+static void header_cache_release (CachedHeader *entry) {
+    CachedHeader *evicted = NULL;
+
+    if (!entry->device) {
+        cached_header_free (entry);
+        return;
+    }
+
+    g_mutex_lock (&header_cache_lock);
+    g_queue_push_head (&header_cache, entry);
+    if (g_queue_get_length (&header_cache) > HEADER_CACHE_SIZE)
+        evicted = g_queue_pop_tail (&header_cache);
+    g_mutex_unlock (&header_cache_lock);
+
+    cached_header_free (evicted);
+}
+
+/* gives @cd back to the cache if it came from there (@cached), frees it otherwise */
+static void release_device (struct crypt_device *cd, CachedHeader *cached) {
+    if (cached)
+        header_cache_release (cached);
+    else
+        crypt_free (cd);
+}
+
+static void header_cache_clear (void) {
+    g_mutex_lock (&header_cache_lock);
+    g_queue_foreach (&header_cache, (GFunc) (void *) cached_header_free, NULL);
+    g_queue_clear (&header_cache);
+    g_mutex_unlock (&header_cache_lock);
+}
+
 /**
  * bd_crypto_init:
  *
@@ -353,6 +608,7 @@ gboolean bd_crypto_init (void) {
  *
  */
 void bd_crypto_close (void) {
+    header_cache_clear ();
     c_locale = (locale_t) 0;
     crypt_set_log_callback (NULL, NULL, NULL);
     crypt_set_debug_level (CRYPT_DEBUG_NONE);
@@ -484,6 +740,8 @@ gchar* bd_crypto_generate_backup_passphrase (GError **error G_GNUC_UNUSED) {
     return ret;
 }
 
+#define PROBE_TIMEOUT_MS 500
+
 /**
  * bd_crypto_device_is_luks:
  * @device: the queried device
@@ -500,7 +758,6 @@ gboolean bd_crypto_device_is_luks (const gchar *device, GError **error) {
     gint fd = 0;
     gint status = 0;
     const gchar *value = NULL;
-    guint n_try = 0;
 
     probe = blkid_new_probe ();
     if (!probe) {
@@ -517,13 +774,9 @@ gboolean bd_crypto_device_is_luks (const gchar *device, GError **error) {
         return FALSE;
     }
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; (status != 0) && (n_try > 0); n_try--) {
-        status = blkid_probe_set_device (probe, fd, 0, 0);
-        if (status != 0)
-            g_usleep (100 * 1000); /* microseconds */
-    }
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = bd_utils_probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SET_DEVICE, PROBE_TIMEOUT_MS);
     if (status != 0) {
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
                      "Failed to create a probe for the device '%s'", device);
@@ -538,13 +791,9 @@ gboolean bd_crypto_device_is_luks (const gchar *device, GError **error) {
     blkid_probe_set_superblocks_flags (probe, BLKID_SUBLKS_USAGE | BLKID_SUBLKS_TYPE |
                                               BLKID_SUBLKS_MAGIC | BLKID_SUBLKS_BADCSUM);
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; !(status == 0 || status == 1) && (n_try > 0); n_try--) {
-        status = blkid_do_safeprobe (probe);
-        if (status < 0)
-            g_usleep (100 * 1000); /* microseconds */
-    }
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = bd_utils_probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SAFEPROBE, PROBE_TIMEOUT_MS);
     if (status < 0) {
         /* -1 or -2 = error during probing*/
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
@@ -904,29 +1153,61 @@ BDCryptoKeyslotContext* bd_crypto_keyslot_context_new_volume_key (const guint8 *
 }
 
 /**
- * bd_crypto_luks_format:
- * @device: a device to format as LUKS
- * @cipher: (nullable): cipher specification (type-mode, e.g. "aes-xts-plain64") or %NULL to use the default
+ * bd_crypto_luks_pbkdf_calibrate:
+ * @pbkdf: (nullable): PBKDF parameters to calibrate or %NULL to calibrate the default PBKDF
  * @key_size: size of the volume key in bits or 0 to use the default
- * @context: key slot context (passphrase/keyfile/token...) for this LUKS device
- * @min_entropy: minimum random data entropy (in bits) required to format @device as LUKS
- * @luks_version: whether to use LUKS v1 or LUKS v2
- * @extra: (nullable): extra arguments for LUKS format creation
  * @error: (out) (optional): place to store error (if any)
  *
- * Formats the given @device as LUKS according to the other parameters given. If
- * @min_entropy is specified (greater than 0), the function waits for enough
- * entropy to be available in the random data pool (WHICH MAY POTENTIALLY TAKE
- * FOREVER).
+ * Runs the PBKDF benchmark for the parameters given in @pbkdf (so that unlocking
+ * takes @time_ms) and returns the result with the concrete @iterations (and
+ * @max_memory_kb and @parallel_threads for Argon2). The result can be passed
+ * to bd_crypto_luks_format() (as part of #BDCryptoLUKSExtra) for any number of
+ * devices without running the benchmark again for each of them.
  *
- * Supported @context types for this function: passphrase, key file
+ * If @pbkdf already contains @iterations, no benchmark is run and only the
+ * missing values are filled in with the defaults.
  *
- * Returns: whether the given @device was successfully formatted as LUKS or not
- * (the @error) contains the error in such cases)
+ * Returns: (transfer full): calibrated PBKDF parameters or %NULL in case of error
  *
  * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_CREATE
  */
-gboolean bd_crypto_luks_format (const gchar *device, const gchar *cipher, guint64 key_size, BDCryptoKeyslotContext *context, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra,GError **error) {
+BDCryptoLUKSPBKDF* bd_crypto_luks_pbkdf_calibrate (BDCryptoLUKSPBKDF *pbkdf, guint64 key_size, GError **error) {
+    BDCryptoLUKSPBKDF empty_pbkdf = ZERO_INIT;
+    struct crypt_pbkdf_type *params = NULL;
+    BDCryptoLUKSPBKDF *ret = NULL;
+    GError *l_error = NULL;
+    gint r = 0;
+
+    params = get_pbkdf_params (pbkdf ? pbkdf : &empty_pbkdf, &l_error);
+    if (!params) {
+        g_propagate_prefixed_error (error, l_error, "Failed to get PBKDF parameters: ");
+        return NULL;
+    }
+
+    if (key_size == 0)
+        key_size = DEFAULT_LUKS_KEYSIZE_BITS * 2;
+
+    if (!(params->flags & CRYPT_PBKDF_NO_BENCHMARK)) {
+        /* the values used for the benchmark don't matter, only their sizes do */
+        r = crypt_benchmark_pbkdf (NULL, params, "foobarfo", 8,
+                                   "0123456789abcdef0123456789abcdef", 32,
+                                   key_size / 8, NULL, NULL);
+        if (r < 0) {
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_PARAMS,
+                         "Failed to benchmark PBKDF '%s': %s", params->type, strerror_l (-r, c_locale));
+            g_free (params);
+            return NULL;
+        }
+    }
+
+    ret = bd_crypto_luks_pbkdf_new (params->type, params->hash, params->max_memory_kb,
+                                    params->iterations, params->time_ms, params->parallel_threads);
+    g_free (params);
+
+    return ret;
+}
+
+static gboolean _crypto_luks_format (const gchar *device, const gchar *cipher, guint64 key_size, BDCryptoKeyslotContext *context, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra, GError **error) {
     struct crypt_device *cd = NULL;
     gint ret;
     gchar **cipher_specs = NULL;
@@ -1121,156 +1402,1011 @@ gboolean bd_crypto_luks_format (const gchar *device, const gchar *cipher, guint6
 }
 
 /**
- * bd_crypto_luks_open:
- * @device: the device to open
- * @name: name for the LUKS device
- * @context: key slot context (passphrase/keyfile/token...) to open this LUKS @device
- * @read_only: whether to open as read-only or not (meaning read-write)
+ * bd_crypto_luks_format:
+ * @device: a device to format as LUKS
+ * @cipher: (nullable): cipher specification (type-mode, e.g. "aes-xts-plain64") or %NULL to use the default
+ * @key_size: size of the volume key in bits or 0 to use the default
+ * @context: key slot context (passphrase/keyfile/token...) for this LUKS device
+ * @min_entropy: minimum random data entropy (in bits) required to format @device as LUKS
+ * @luks_version: whether to use LUKS v1 or LUKS v2
+ * @extra: (nullable): extra arguments for LUKS format creation
  * @error: (out) (optional): place to store error (if any)
  *
- * Supported @context types for this function: passphrase, key file, keyring
- *
- * Returns: whether the @device was successfully opened or not
- *
- * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ * Formats the given @device as LUKS according to the other parameters given. If
+ * @min_entropy is specified (greater than 0), the function waits for enough
+ * entropy to be available in the random data pool (WHICH MAY POTENTIALLY TAKE
+ * FOREVER).
  *
- * Example of using %bd_crypto_luks_open with %BDCryptoKeyslotContext:
+ * Supported @context types for this function: passphrase, key file
  *
- * |[<!-- language="C" -->
- * BDCryptoKeyslotContext *context = NULL;
+ * Returns: whether the given @device was successfully formatted as LUKS or not
+ * (the @error) contains the error in such cases)
  *
- * context = bd_crypto_keyslot_context_new_passphrase ("passphrase", 10, NULL);
- * bd_crypto_luks_open ("/dev/vda1", "luks-device", context, FALSE, NULL);
- * ]|
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_CREATE
  */
-gboolean bd_crypto_luks_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, gboolean read_only, GError **error) {
-    struct crypt_device *cd = NULL;
-    gchar *key_buffer = NULL;
-    gsize buf_len = 0;
-    gint ret = 0;
-    guint64 progress_id = 0;
-    gchar *msg = NULL;
-    GError *l_error = NULL;
+gboolean bd_crypto_luks_format (const gchar *device, const gchar *cipher, guint64 key_size, BDCryptoKeyslotContext *context, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra,GError **error) {
+    BDUtilsTimingSpan span;
+    gboolean ret = FALSE;
 
-    msg = g_strdup_printf ("Started opening '%s' LUKS device", device);
-    progress_id = bd_utils_report_started (msg);
-    g_free (msg);
+    bd_utils_timing_span_begin (&span, "crypto", G_STRFUNC);
+    ret = _crypto_luks_format (device, cipher, key_size, context, min_entropy, luks_version, extra, error);
+    bd_utils_timing_span_end (&span, 0, "crypt_format", 0, ret ? 0 : -1);
 
-    ret = crypt_init (&cd, device);
-    if (ret != 0) {
-        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
+    return ret;
+}
 
-    ret = crypt_load (cd, CRYPT_LUKS, NULL);
-    if (ret != 0) {
-        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
+static gboolean get_context_passphrase (struct crypt_device *cd, BDCryptoKeyslotContext *context,
+                                        gchar **pass, gsize *pass_len, GError **error) {
+    key_serial_t key_id = 0;
+    void *key_data = NULL;
+    glong key_len = 0;
+    gint ret = 0;
 
     if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_PASSPHRASE) {
-        ret = crypt_activate_by_passphrase (cd, name, CRYPT_ANY_SLOT,
-                                            (const char *) context->u.passphrase.pass_data,
-                                            context->u.passphrase.data_len,
-                                            read_only ? CRYPT_ACTIVATE_READONLY : 0);
+        *pass = crypt_safe_alloc (context->u.passphrase.data_len);
+        if (!*pass) {
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to allocate memory for the passphrase");
+            return FALSE;
+        }
+        memcpy (*pass, context->u.passphrase.pass_data, context->u.passphrase.data_len);
+        *pass_len = context->u.passphrase.data_len;
     } else if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_KEYFILE) {
-        ret = crypt_keyfile_device_read (cd, context->u.keyfile.keyfile, &key_buffer, &buf_len,
+        ret = crypt_keyfile_device_read (cd, context->u.keyfile.keyfile, pass, pass_len,
                                          context->u.keyfile.keyfile_offset, context->u.keyfile.key_size, 0);
         if (ret != 0) {
-            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYFILE_FAILED,
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYFILE_FAILED,
                          "Failed to read key from file '%s: %s", context->u.keyfile.keyfile, strerror_l (-ret, c_locale));
-            crypt_free (cd);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return FALSE;
         }
-        ret = crypt_activate_by_passphrase (cd, name, CRYPT_ANY_SLOT, key_buffer, buf_len,
-                                            read_only ? CRYPT_ACTIVATE_READONLY : 0);
-        crypt_safe_free (key_buffer);
-    } else if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_KEYRING)
-        ret = crypt_activate_by_keyring (cd, name, context->u.keyring.key_desc, CRYPT_ANY_SLOT,
-                                         read_only ? CRYPT_ACTIVATE_READONLY : 0);
-    else {
-        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_CONTEXT,
+    } else if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_KEYRING) {
+        /* the same lookup libcryptsetup does for crypt_activate_by_keyring() */
+        key_id = request_key ("user", context->u.keyring.key_desc, NULL, 0);
+        if (key_id < 0) {
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYRING,
+                         "Failed to get key '%s' from the kernel keyring: %s", context->u.keyring.key_desc,
+                         strerror_l (errno, c_locale));
+            return FALSE;
+        }
+        key_len = keyctl_read_alloc (key_id, &key_data);
+        if (key_len < 0) {
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYRING,
+                         "Failed to read key '%s' from the kernel keyring: %s", context->u.keyring.key_desc,
+                         strerror_l (errno, c_locale));
+            return FALSE;
+        }
+        *pass = crypt_safe_alloc (key_len);
+        if (*pass)
+            memcpy (*pass, key_data, key_len);
+        explicit_bzero (key_data, key_len);
+        free (key_data);
+        if (!*pass) {
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to allocate memory for the passphrase");
+            return FALSE;
+        }
+        *pass_len = key_len;
+    } else {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_CONTEXT,
                      "Only 'passphrase', 'key file' and 'keyring' context types are valid for LUKS open.");
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        crypt_free (cd);
         return FALSE;
     }
 
-    if (ret < 0) {
-        if (ret == -EPERM)
-          g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                       "Failed to activate device: Incorrect passphrase.");
-        else
-          g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                       "Failed to activate device: %s", strerror_l (-ret, c_locale));
+    return TRUE;
+}
 
-        crypt_free (cd);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
+#define VOLUME_KEY_DESC_PREFIX "libblockdev:volume-key:"
 
-    crypt_free (cd);
-    bd_utils_report_finished (progress_id, "Completed");
-    return TRUE;
+/* description of the (user) key with the volume key of @cd in the kernel keyring */
+static gchar* get_volume_key_desc (struct crypt_device *cd) {
+    const gchar *uuid = crypt_get_uuid (cd);
+
+    return uuid ? g_strdup_printf (VOLUME_KEY_DESC_PREFIX "%s", uuid) : NULL;
 }
 
-static gboolean _crypto_close (const gchar *device, const gchar *tech_name, GError **error) {
-    struct crypt_device *cd = NULL;
-    gint ret = 0;
-    guint64 progress_id = 0;
-    gchar *msg = NULL;
-    GError *l_error = NULL;
+static gboolean get_cached_volume_key (struct crypt_device *cd, gchar **vk, gsize *vk_size) {
+    g_autofree gchar *desc = NULL;
+    key_serial_t key_id = 0;
+    void *key_data = NULL;
+    glong key_len = 0;
 
-    msg = g_strdup_printf ("Started closing %s device '%s'", tech_name, device);
-    progress_id = bd_utils_report_started (msg);
-    g_free (msg);
+    desc = get_volume_key_desc (cd);
+    if (!desc)
+        return FALSE;
 
-    ret = crypt_init_by_name (&cd, device);
-    if (ret != 0) {
-        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
+    key_id = request_key ("user", desc, NULL, 0);
+    if (key_id < 0)
         return FALSE;
-    }
 
-    ret = crypt_deactivate (cd, device);
-    if (ret != 0) {
-        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to deactivate device: %s", strerror_l (-ret, c_locale));
+    key_len = keyctl_read_alloc (key_id, &key_data);
+    if (key_len < 0)
+        return FALSE;
+
+    *vk = crypt_safe_alloc (key_len);
+    if (*vk)
+        memcpy (*vk, key_data, key_len);
+    explicit_bzero (key_data, key_len);
+    free (key_data);
+    *vk_size = key_len;
+
+    return *vk != NULL;
+}
+
+static void drop_cached_volume_key (const gchar *desc) {
+    key_serial_t key_id = 0;
+
+    key_id = request_key ("user", desc, NULL, 0);
+    if (key_id >= 0)
+        keyctl_unlink (key_id, KEY_SPEC_SESSION_KEYRING);
+}
+
+/* keeps @vk in the session keyring, accessible only to its possessors (not to
+   all the processes of the user) */
+static gboolean keep_volume_key (struct crypt_device *cd, const gchar *vk, gsize vk_size, GError **error) {
+    g_autofree gchar *desc = NULL;
+    key_serial_t key_id = 0;
+
+    desc = get_volume_key_desc (cd);
+    if (!desc) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYRING,
+                     "Failed to get UUID of the device");
+        return FALSE;
+    }
+
+    /* new keys get the default permissions (readable by the user), so the key
+       is created with a dummy payload in the (private) thread keyring and only
+       gets the volume key and moves to the session keyring once its permissions
+       are restricted */
+    key_id = add_key ("user", desc, "", 1, KEY_SPEC_THREAD_KEYRING);
+    if (key_id < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYRING,
+                     "Failed to add the key: %s", strerror_l (errno, c_locale));
+        return FALSE;
+    }
+
+    if (keyctl_setperm (key_id, KEY_POS_ALL) < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYRING,
+                     "Failed to set permissions of the key: %s", strerror_l (errno, c_locale));
+        keyctl_unlink (key_id, KEY_SPEC_THREAD_KEYRING);
+        return FALSE;
+    }
+
+    if (keyctl_update (key_id, vk, vk_size) < 0 || keyctl_link (key_id, KEY_SPEC_SESSION_KEYRING) < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYRING,
+                     "Failed to add the key: %s", strerror_l (errno, c_locale));
+        keyctl_unlink (key_id, KEY_SPEC_THREAD_KEYRING);
+        return FALSE;
+    }
+    keyctl_unlink (key_id, KEY_SPEC_THREAD_KEYRING);
+
+    return TRUE;
+}
+
+/* activates @cd getting its volume key (running the PBKDF) first and keeping
+   it in the kernel keyring for the later operations (resize, resume) */
+static gboolean activate_keep_volume_key (struct crypt_device *cd, const gchar *name, BDCryptoKeyslotContext *context,
+                                          guint32 activate_flags, GError **error) {
+    gchar *pass = NULL;
+    gsize pass_len = 0;
+    gchar *vk = NULL;
+    gsize vk_size = 0;
+    gint ret = 0;
+    GError *l_error = NULL;
+
+    if (!get_context_passphrase (cd, context, &pass, &pass_len, error))
+        return FALSE;
+
+    vk_size = crypt_get_volume_key_size (cd);
+    vk = crypt_safe_alloc (vk_size);
+    ret = crypt_volume_key_get (cd, CRYPT_ANY_SLOT, vk, &vk_size, pass, pass_len);
+    crypt_safe_free (pass);
+    if (ret < 0) {
+        if (ret == -EPERM)
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to activate device: Incorrect passphrase.");
+        else
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to activate device: %s", strerror_l (-ret, c_locale));
+        crypt_safe_free (vk);
+        return FALSE;
+    }
+
+    if (g_strcmp0 (crypt_get_type (cd), CRYPT_LUKS2) == 0)
+        activate_flags |= CRYPT_ACTIVATE_KEYRING_KEY;
+    ret = crypt_activate_by_volume_key (cd, name, vk, vk_size, activate_flags);
+    if (ret < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to activate device: %s", strerror_l (-ret, c_locale));
+        crypt_safe_free (vk);
+        return FALSE;
+    }
+
+    /* the device is activated and usable, just resize and resume will need
+       a key slot context */
+    if (!keep_volume_key (cd, vk, vk_size, &l_error)) {
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to keep the volume key of '%s' in the kernel keyring: %s",
+                             name, l_error->message);
+        g_clear_error (&l_error);
+    }
+
+    crypt_safe_free (vk);
+    return TRUE;
+}
+
+static gboolean luks_open_flags_to_activate (const gchar *device, BDCryptoLUKSOpenFlags flags, guint32 *activate_flags, GError **error) {
+    *activate_flags = 0;
+
+    if (flags & BD_CRYPTO_LUKS_OPEN_READONLY)
+        *activate_flags |= CRYPT_ACTIVATE_READONLY;
+    if (flags & BD_CRYPTO_LUKS_OPEN_ALLOW_DISCARDS)
+        *activate_flags |= CRYPT_ACTIVATE_ALLOW_DISCARDS;
+    if (flags & BD_CRYPTO_LUKS_OPEN_SAME_CPU_CRYPT)
+        *activate_flags |= CRYPT_ACTIVATE_SAME_CPU_CRYPT;
+    if (flags & BD_CRYPTO_LUKS_OPEN_SUBMIT_FROM_CRYPT_CPUS)
+        *activate_flags |= CRYPT_ACTIVATE_SUBMIT_FROM_CRYPT_CPUS;
+
+    if (flags & (BD_CRYPTO_LUKS_OPEN_NO_READ_WORKQUEUE | BD_CRYPTO_LUKS_OPEN_NO_WRITE_WORKQUEUE)) {
+#ifndef CRYPT_ACTIVATE_NO_READ_WORKQUEUE
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
+                     "Cannot bypass dm-crypt workqueues while activating %s, installed version of cryptsetup doesn't support this option.", device);
+        return FALSE;
+#else
+        if (flags & BD_CRYPTO_LUKS_OPEN_NO_READ_WORKQUEUE)
+            *activate_flags |= CRYPT_ACTIVATE_NO_READ_WORKQUEUE;
+        if (flags & BD_CRYPTO_LUKS_OPEN_NO_WRITE_WORKQUEUE)
+            *activate_flags |= CRYPT_ACTIVATE_NO_WRITE_WORKQUEUE;
+#endif
+    }
+
+    return TRUE;
+}
+
+static gboolean _crypto_luks_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, BDCryptoLUKSOpenFlags flags, GError **error) {
+    struct crypt_device *cd = NULL;
+    gchar *key_buffer = NULL;
+    gsize buf_len = 0;
+    gint ret = 0;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    guint32 activate_flags = 0;
+    GError *l_error = NULL;
+
+    if (!luks_open_flags_to_activate (device, flags, &activate_flags, error))
+        return FALSE;
+
+    msg = g_strdup_printf ("Started opening '%s' LUKS device", device);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    ret = crypt_init (&cd, device);
+    if (ret != 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    if (ret != 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    if ((flags & BD_CRYPTO_LUKS_OPEN_PERSISTENT) && g_strcmp0 (crypt_get_type (cd), CRYPT_LUKS2) != 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_PARAMS,
+                     "Activation flags can be stored only in the LUKS 2 header");
         crypt_free (cd);
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    crypt_free (cd);
-    bd_utils_report_finished (progress_id, "Completed");
+    if (flags & BD_CRYPTO_LUKS_OPEN_KEYRING_VOLUME_KEY) {
+        if (!activate_keep_volume_key (cd, name, context, activate_flags, &l_error)) {
+            crypt_free (cd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+    } else if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_PASSPHRASE) {
+        ret = crypt_activate_by_passphrase (cd, name, CRYPT_ANY_SLOT,
+                                            (const char *) context->u.passphrase.pass_data,
+                                            context->u.passphrase.data_len,
+                                            activate_flags);
+    } else if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_KEYFILE) {
+        ret = crypt_keyfile_device_read (cd, context->u.keyfile.keyfile, &key_buffer, &buf_len,
+                                         context->u.keyfile.keyfile_offset, context->u.keyfile.key_size, 0);
+        if (ret != 0) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_KEYFILE_FAILED,
+                         "Failed to read key from file '%s: %s", context->u.keyfile.keyfile, strerror_l (-ret, c_locale));
+            crypt_free (cd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+        ret = crypt_activate_by_passphrase (cd, name, CRYPT_ANY_SLOT, key_buffer, buf_len,
+                                            activate_flags);
+        crypt_safe_free (key_buffer);
+    } else if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_KEYRING)
+        ret = crypt_activate_by_keyring (cd, name, context->u.keyring.key_desc, CRYPT_ANY_SLOT,
+                                         activate_flags);
+    else {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_CONTEXT,
+                     "Only 'passphrase', 'key file' and 'keyring' context types are valid for LUKS open.");
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    if (ret < 0) {
+        if (ret == -EPERM)
+          g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                       "Failed to activate device: Incorrect passphrase.");
+        else
+          g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                       "Failed to activate device: %s", strerror_l (-ret, c_locale));
+
+        crypt_free (cd);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    if (flags & BD_CRYPTO_LUKS_OPEN_PERSISTENT) {
+        /* read-only is a property of the activation, not of the device */
+        ret = crypt_persistent_flags_set (cd, CRYPT_FLAGS_ACTIVATION, activate_flags & ~CRYPT_ACTIVATE_READONLY);
+        if (ret != 0) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Device activated, but failed to store the activation flags in the LUKS header: %s",
+                         strerror_l (-ret, c_locale));
+            crypt_free (cd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+    }
+
+    crypt_free (cd);
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_open:
+ * @device: the device to open
+ * @name: name for the LUKS device
+ * @context: key slot context (passphrase/keyfile/token...) to open this LUKS @device
+ * @read_only: whether to open as read-only or not (meaning read-write)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Supported @context types for this function: passphrase, key file, keyring
+ *
+ * Returns: whether the @device was successfully opened or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ *
+ * Example of using %bd_crypto_luks_open with %BDCryptoKeyslotContext:
+ *
+ * |[<!-- language="C" -->
+ * BDCryptoKeyslotContext *context = NULL;
+ *
+ * context = bd_crypto_keyslot_context_new_passphrase ("passphrase", 10, NULL);
+ * bd_crypto_luks_open ("/dev/vda1", "luks-device", context, FALSE, NULL);
+ * ]|
+ */
+gboolean bd_crypto_luks_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, gboolean read_only, GError **error) {
+    BDUtilsTimingSpan span;
+    gboolean ret = FALSE;
+
+    bd_utils_timing_span_begin (&span, "crypto", G_STRFUNC);
+    ret = _crypto_luks_open (device, name, context, read_only ? BD_CRYPTO_LUKS_OPEN_READONLY : 0, error);
+    bd_utils_timing_span_end (&span, 0, "crypt_activate", 0, ret ? 0 : -1);
+
+    return ret;
+}
+
+/**
+ * bd_crypto_luks_open_flags:
+ * @device: the device to open
+ * @name: name for the LUKS device
+ * @context: key slot context (passphrase/keyfile/token...) to open this LUKS @device
+ * @flags: flags for the LUKS device activation
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Same as %bd_crypto_luks_open, but allows tuning the dm-crypt device with
+ * the activation @flags. Bypassing the dm-crypt workqueues
+ * (%BD_CRYPTO_LUKS_OPEN_NO_READ_WORKQUEUE and %BD_CRYPTO_LUKS_OPEN_NO_WRITE_WORKQUEUE)
+ * considerably improves performance on fast (e.g. NVMe) devices, but requires
+ * cryptsetup 2.3.4 or newer. With %BD_CRYPTO_LUKS_OPEN_PERSISTENT the flags
+ * (except for %BD_CRYPTO_LUKS_OPEN_READONLY) are also stored in the LUKS 2
+ * header and used for the future activations of @device.
+ *
+ * With %BD_CRYPTO_LUKS_OPEN_KEYRING_VOLUME_KEY the volume key of @device is
+ * kept (as a "user" key) in the session kernel keyring until the device is
+ * closed, so that %bd_crypto_luks_resize and %bd_crypto_luks_resume don't
+ * need a key slot context and don't run the (expensive) PBKDF again. The key
+ * is only accessible to the processes possessing the session keyring (not to
+ * the other processes of the same user). A failure to keep the key doesn't
+ * make the activation fail, it is only logged as a warning and key slot
+ * contexts are needed for resize and resume then.
+ *
+ * Supported @context types for this function: passphrase, key file, keyring
+ *
+ * Returns: whether the @device was successfully opened or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ */
+gboolean bd_crypto_luks_open_flags (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, BDCryptoLUKSOpenFlags flags, GError **error) {
+    BDUtilsTimingSpan span;
+    gboolean ret = FALSE;
+
+    bd_utils_timing_span_begin (&span, "crypto", G_STRFUNC);
+    ret = _crypto_luks_open (device, name, context, flags, error);
+    bd_utils_timing_span_end (&span, 0, "crypt_activate", 0, ret ? 0 : -1);
+
+    return ret;
+}
+
+static gboolean _crypto_close (const gchar *device, const gchar *tech_name, GError **error) {
+    struct crypt_device *cd = NULL;
+    g_autofree gchar *vk_desc = NULL;
+    gint ret = 0;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    msg = g_strdup_printf ("Started closing %s device '%s'", tech_name, device);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    ret = crypt_init_by_name (&cd, device);
+    if (ret != 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    vk_desc = get_volume_key_desc (cd);
+
+    ret = crypt_deactivate (cd, device);
+    if (ret != 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to deactivate device: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    /* the volume key may have been kept in the keyring when opening the device */
+    if (vk_desc)
+        drop_cached_volume_key (vk_desc);
+
+    crypt_free (cd);
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_close:
+ * @luks_device: LUKS device to close
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the given @luks_device was successfully closed or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ */
+gboolean bd_crypto_luks_close (const gchar *luks_device, GError **error) {
+    return _crypto_close (luks_device, "LUKS", error);
+}
+
+/* libdevmapper is not thread-safe, only the PBKDFs run in parallel */
+static GMutex bulk_dm_lock;
+
+typedef struct BulkVolumeKey {
+    gchar *key;
+    gsize key_size;
+} BulkVolumeKey;
+
+typedef struct BulkOpenData {
+    BDCryptoKeyslotContext *context;
+    gboolean read_only;
+
+    /* protects everything below */
+    GMutex lock;
+    /* volume keys recovered so far */
+    GPtrArray *keys;
+    guint64 mem_budget_kb;
+    guint64 mem_used_kb;
+    GCond mem_cond;
+} BulkOpenData;
+
+typedef struct BulkOpenItem {
+    BDCryptoBulkResult *result;
+    const gchar *name;
+    BulkOpenData *data;
+} BulkOpenItem;
+
+static void bulk_volume_key_free (BulkVolumeKey *key) {
+    crypt_safe_free (key->key);
+    g_free (key);
+}
+
+/* the memory the PBKDF of the most expensive active keyslot of @cd needs */
+static guint64 get_unlock_memory (struct crypt_device *cd) {
+    struct crypt_pbkdf_type pbkdf = ZERO_INIT;
+    const gchar *type = crypt_get_type (cd);
+    guint64 ret = 0;
+    gint max_slots = 0;
+
+    if (g_strcmp0 (type, CRYPT_LUKS2) != 0)
+        /* LUKS 1 uses PBKDF2 only */
+        return 0;
+
+    max_slots = crypt_keyslot_max (type);
+    for (gint slot = 0; slot < max_slots; slot++) {
+        if (crypt_keyslot_status (cd, slot) < CRYPT_SLOT_ACTIVE)
+            continue;
+        if (crypt_keyslot_get_pbkdf (cd, slot, &pbkdf) == 0)
+            ret = MAX (ret, pbkdf.max_memory_kb);
+    }
+
+    return ret;
+}
+
+static void bulk_mem_acquire (BulkOpenData *data, guint64 mem_kb) {
+    g_mutex_lock (&(data->lock));
+    /* always let at least one PBKDF run, even if it doesn't fit into the budget */
+    while (data->mem_budget_kb && data->mem_used_kb > 0 && data->mem_used_kb + mem_kb > data->mem_budget_kb)
+        g_cond_wait (&(data->mem_cond), &(data->lock));
+    data->mem_used_kb += mem_kb;
+    g_mutex_unlock (&(data->lock));
+}
+
+static void bulk_mem_release (BulkOpenData *data, guint64 mem_kb) {
+    g_mutex_lock (&(data->lock));
+    data->mem_used_kb -= mem_kb;
+    g_cond_broadcast (&(data->mem_cond));
+    g_mutex_unlock (&(data->lock));
+}
+
+/* tries the already known volume keys, returns the matching one (or %NULL) */
+static BulkVolumeKey* find_known_volume_key (struct crypt_device *cd, BulkOpenData *data) {
+    BulkVolumeKey *key = NULL;
+    gsize key_size = crypt_get_volume_key_size (cd);
+    guint num_keys = 0;
+
+    g_mutex_lock (&(data->lock));
+    num_keys = data->keys->len;
+    g_mutex_unlock (&(data->lock));
+
+    for (guint i = 0; i < num_keys; i++) {
+        /* keys are only ever added, never removed */
+        g_mutex_lock (&(data->lock));
+        key = g_ptr_array_index (data->keys, i);
+        g_mutex_unlock (&(data->lock));
+
+        /* no name -> only verifies the key against the header digest */
+        if (key->key_size == key_size &&
+            crypt_activate_by_volume_key (cd, NULL, key->key, key->key_size, 0) == 0)
+            return key;
+    }
+
+    return NULL;
+}
+
+static void luks_open_one (gpointer item_p, gpointer user_data G_GNUC_UNUSED) {
+    BulkOpenItem *item = (BulkOpenItem *) item_p;
+    BulkOpenData *data = item->data;
+    struct crypt_device *cd = NULL;
+    BulkVolumeKey *key = NULL;
+    gchar *pass = NULL;
+    gsize pass_len = 0;
+    gchar *vk = NULL;
+    gsize vk_size = 0;
+    guint64 mem_kb = 0;
+    gint ret = 0;
+    GError **error = &(item->result->error);
+
+    ret = crypt_init (&cd, item->result->device);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        return;
+    }
+
+    ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        return;
+    }
+
+    key = find_known_volume_key (cd, data);
+    if (key) {
+        g_mutex_lock (&bulk_dm_lock);
+        ret = crypt_activate_by_volume_key (cd, item->name, key->key, key->key_size,
+                                            data->read_only ? CRYPT_ACTIVATE_READONLY : 0);
+        g_mutex_unlock (&bulk_dm_lock);
+    } else {
+        if (!get_context_passphrase (cd, data->context, &pass, &pass_len, error)) {
+            crypt_free (cd);
+            return;
+        }
+
+        vk_size = crypt_get_volume_key_size (cd);
+        vk = crypt_safe_alloc (vk_size);
+        mem_kb = get_unlock_memory (cd);
+
+        bulk_mem_acquire (data, mem_kb);
+        ret = crypt_volume_key_get (cd, CRYPT_ANY_SLOT, vk, &vk_size, pass, pass_len);
+        bulk_mem_release (data, mem_kb);
+        crypt_safe_free (pass);
+
+        if (ret >= 0) {
+            g_mutex_lock (&bulk_dm_lock);
+            ret = crypt_activate_by_volume_key (cd, item->name, vk, vk_size,
+                                                data->read_only ? CRYPT_ACTIVATE_READONLY : 0);
+            g_mutex_unlock (&bulk_dm_lock);
+        }
+
+        if (ret >= 0) {
+            key = g_new0 (BulkVolumeKey, 1);
+            key->key = vk;
+            key->key_size = vk_size;
+            g_mutex_lock (&(data->lock));
+            g_ptr_array_add (data->keys, key);
+            g_mutex_unlock (&(data->lock));
+        } else
+            crypt_safe_free (vk);
+    }
+
+    if (ret < 0) {
+        if (ret == -EPERM)
+          g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                       "Failed to activate device: Incorrect passphrase.");
+        else
+          g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                       "Failed to activate device: %s", strerror_l (-ret, c_locale));
+    }
+
+    crypt_free (cd);
+}
+
+/**
+ * bd_crypto_luks_open_many:
+ * @devices: (array zero-terminated=1): the devices to open
+ * @names: (array zero-terminated=1): names for the LUKS devices (one for each of @devices)
+ * @context: key slot context (passphrase/keyfile/keyring) to open the LUKS @devices
+ * @read_only: whether to open as read-only or not (meaning read-write)
+ * @max_memory_kb: maximum memory (in KiB) to be used by the PBKDFs running in parallel or 0 for no limit
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Opens all the @devices using the same @context. The first device is unlocked
+ * first and its volume key is then tried for the other devices -- devices
+ * sharing the volume key are activated without running the (expensive) PBKDF
+ * again. The other devices are unlocked in parallel, running at most as many
+ * PBKDFs at the same time as fit into @max_memory_kb (at least one is always
+ * running).
+ *
+ * Supported @context types for this function: passphrase, key file, keyring
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results for the @devices (in
+ *                                                     the same order as @devices) or
+ *                                                     %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ */
+BDCryptoBulkResult** bd_crypto_luks_open_many (const gchar **devices, const gchar **names, BDCryptoKeyslotContext *context, gboolean read_only, guint64 max_memory_kb, GError **error) {
+    BDCryptoBulkResult **ret = NULL;
+    BulkOpenItem *items = NULL;
+    BulkOpenData data = ZERO_INIT;
+    guint num_devices = 0;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+
+    if (!devices || !names || g_strv_length ((gchar **) devices) != g_strv_length ((gchar **) names)) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_PARAMS,
+                     "Exactly one name has to be given for every device");
+        return NULL;
+    }
+
+    if (context->type != BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_PASSPHRASE &&
+        context->type != BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_KEYFILE &&
+        context->type != BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_KEYRING) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_CONTEXT,
+                     "Only 'passphrase', 'key file' and 'keyring' context types are valid for LUKS open.");
+        return NULL;
+    }
+
+    num_devices = g_strv_length ((gchar **) devices);
+
+    msg = g_strdup_printf ("Started opening %u LUKS devices", num_devices);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    data.context = context;
+    data.read_only = read_only;
+    data.mem_budget_kb = max_memory_kb;
+    data.keys = g_ptr_array_new_with_free_func ((GDestroyNotify) bulk_volume_key_free);
+    g_mutex_init (&(data.lock));
+    g_cond_init (&(data.mem_cond));
+
+    ret = g_new0 (BDCryptoBulkResult *, num_devices + 1);
+    items = g_new0 (BulkOpenItem, num_devices);
+    for (guint i = 0; i < num_devices; i++) {
+        ret[i] = g_new0 (BDCryptoBulkResult, 1);
+        ret[i]->device = g_strdup (devices[i]);
+        items[i].result = ret[i];
+        items[i].name = names[i];
+        items[i].data = &data;
+    }
+
+    /* the first device is unlocked first so that (hopefully) the others can
+       use its volume key */
+    if (num_devices > 0) {
+        luks_open_one (&(items[0]), NULL);
+        bd_utils_parallel_run_array (luks_open_one, items + 1, sizeof (BulkOpenItem), num_devices - 1, 0, NULL);
+    }
+
+    g_free (items);
+    g_ptr_array_free (data.keys, TRUE);
+    g_mutex_clear (&(data.lock));
+    g_cond_clear (&(data.mem_cond));
+
+    bd_utils_report_finished (progress_id, "Completed");
+    return ret;
+}
+
+/**
+ * bd_crypto_luks_close_many:
+ * @luks_devices: (array zero-terminated=1): LUKS devices to close
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results for the @luks_devices (in
+ *                                                     the same order as @luks_devices) or
+ *                                                     %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ */
+BDCryptoBulkResult** bd_crypto_luks_close_many (const gchar **luks_devices, GError **error) {
+    BDCryptoBulkResult **ret = NULL;
+    guint num_devices = 0;
+
+    if (!luks_devices) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_PARAMS,
+                     "No devices specified");
+        return NULL;
+    }
+
+    num_devices = g_strv_length ((gchar **) luks_devices);
+    ret = g_new0 (BDCryptoBulkResult *, num_devices + 1);
+
+    /* closing is all about device-mapper which cannot be done in parallel */
+    for (guint i = 0; i < num_devices; i++) {
+        ret[i] = g_new0 (BDCryptoBulkResult, 1);
+        ret[i]->device = g_strdup (luks_devices[i]);
+        g_mutex_lock (&bulk_dm_lock);
+        _crypto_close (luks_devices[i], "LUKS", &(ret[i]->error));
+        g_mutex_unlock (&bulk_dm_lock);
+    }
+
+    return ret;
+}
+
+typedef struct WipeProgress {
+    guint64 progress_id;
+    /* progress of the whole task when the wipe starts */
+    gdouble start;
+    const gchar *msg;
+} WipeProgress;
+
+static void report_wipe_progress (WipeProgress *progress, guint64 size, guint64 offset) {
+    gdouble completion = progress->start + ((gdouble) offset / size) * (100 - progress->start);
+    bd_utils_report_progress (progress->progress_id, completion, progress->msg);
+}
+
+static int _wipe_progress (guint64 size, guint64 offset, void *usrptr) {
+    report_wipe_progress ((WipeProgress *) usrptr, size, offset);
+
+    return 0;
+}
+
+#define WIPE_MAX_WORKERS 8
+
+static void _fast_wipe_progress (guint64 size, guint64 done, gpointer user_data) {
+    report_wipe_progress ((WipeProgress *) user_data, size, done);
+}
+
+/* Fills @path with zeroes using write-zeroes offload if the device supports it
+   or multiple threads doing large direct I/O writes otherwise.
+   %BD_CRYPTO_ERROR_TECH_UNAVAIL in @error means the device needs to be wiped
+   the traditional way (crypt_wipe()). */
+static gboolean fast_wipe_device (const gchar *path, WipeProgress *progress, GError **error) {
+    guint64 size = 0;
+    GError *l_error = NULL;
+    gint fd = -1;
+
+    fd = open (path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to open '%s': %s", path, strerror_l (errno, c_locale));
+        return FALSE;
+    }
+
+    if (ioctl (fd, BLKGETSIZE64, &size) != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
+                     "Failed to get size of '%s': %s", path, strerror_l (errno, c_locale));
+        close (fd);
+        return FALSE;
+    }
+
+    report_wipe_progress (progress, size, 0);
+
+    if (bd_utils_io_can_offload_zeroes (fd)) {
+        if (bd_utils_io_zero_out_device (fd, path, size, FALSE, _fast_wipe_progress, progress, &l_error)) {
+            close (fd);
+            return TRUE;
+        } else if (!g_error_matches (l_error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_NOT_SUPPORTED)) {
+            g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE, "%s", l_error->message);
+            g_clear_error (&l_error);
+            close (fd);
+            return FALSE;
+        }
+        g_clear_error (&l_error);
+        bd_utils_log_format (BD_UTILS_LOG_INFO, "Write zeroes not supported on '%s', writing zeroes directly", path);
+    }
+    close (fd);
+
+    if (!bd_utils_io_write_zeroes (path, size, MIN (g_get_num_processors (), WIPE_MAX_WORKERS),
+                                   _fast_wipe_progress, progress, &l_error)) {
+        g_set_error (error, BD_CRYPTO_ERROR,
+                     g_error_matches (l_error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_NOT_SUPPORTED) ?
+                     BD_CRYPTO_ERROR_TECH_UNAVAIL : BD_CRYPTO_ERROR_DEVICE,
+                     "%s", l_error->message);
+        g_clear_error (&l_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* wipes @path, falls back to crypt_wipe() if the fast way is not possible */
+static gboolean wipe_device (struct crypt_device *cd, const gchar *path, WipeProgress *progress, GError **error) {
+    GError *l_error = NULL;
+    gint ret = 0;
+
+    if (fast_wipe_device (path, progress, &l_error)) {
+        report_wipe_progress (progress, 1, 1);
+        return TRUE;
+    }
+
+    if (!g_error_matches (l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL)) {
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "%s, falling back to libcryptsetup wipe", l_error->message);
+    g_clear_error (&l_error);
+
+    ret = crypt_wipe (cd, path, CRYPT_WIPE_ZERO, 0, 0, 1 MiB, 0, &_wipe_progress, progress);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "%s", strerror_l (-ret, c_locale));
+        return FALSE;
+    }
+    report_wipe_progress (progress, 1, 1);
+
     return TRUE;
 }
 
 /**
- * bd_crypto_luks_close:
- * @luks_device: LUKS device to close
+ * bd_crypto_luks_wipe:
+ * @device: LUKS device to wipe the data area of
+ * @context: key slot context (passphrase/keyfile/token...) for this LUKS device
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether the given @luks_device was successfully closed or not
+ * Wipes the data area of the (inactive) LUKS @device by writing zeroes through
+ * a temporary mapping. This initializes the integrity tags of a LUKS 2 device
+ * with integrity protection and fills other devices with encrypted data.
+ * Write-zeroes offload is used if the device supports it, otherwise zeroes are
+ * written in parallel using direct I/O.
  *
- * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_OPEN_CLOSE
+ * Supported @context types for this function: passphrase, key file, keyring
+ *
+ * Returns: whether the data area of @device was successfully wiped or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_CREATE
  */
-gboolean bd_crypto_luks_close (const gchar *luks_device, GError **error) {
-    return _crypto_close (luks_device, "LUKS", error);
+gboolean bd_crypto_luks_wipe (const gchar *device, BDCryptoKeyslotContext *context, GError **error) {
+    struct crypt_device *cd = NULL;
+    gchar *pass = NULL;
+    gsize pass_len = 0;
+    gint ret = 0;
+    WipeProgress progress = ZERO_INIT;
+    gchar *msg = NULL;
+    g_autofree gchar *tmp_name = NULL;
+    g_autofree gchar *tmp_path = NULL;
+    g_autofree gchar *dev_name = NULL;
+    GError *l_error = NULL;
+
+    msg = g_strdup_printf ("Started wiping '%s' LUKS device", device);
+    progress.progress_id = bd_utils_report_started (msg);
+    progress.msg = "LUKS device wipe in progress";
+    g_free (msg);
+
+    ret = crypt_init (&cd, device);
+    if (ret != 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    if (ret != 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device's parameters: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    if (!get_context_passphrase (cd, context, &pass, &pass_len, &l_error)) {
+        crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    dev_name = g_path_get_basename (device);
+    tmp_name = g_strdup_printf ("bd-temp-luks-%s-%d", dev_name, g_random_int ());
+    tmp_path = g_strdup_printf ("%s/%s", crypt_get_dir (), tmp_name);
+
+    ret = crypt_activate_by_passphrase (cd, tmp_name, CRYPT_ANY_SLOT, pass, pass_len,
+                                        CRYPT_ACTIVATE_PRIVATE | CRYPT_ACTIVATE_NO_JOURNAL);
+    crypt_safe_free (pass);
+    if (ret < 0) {
+        if (ret == -EPERM)
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to activate device for wiping: Incorrect passphrase.");
+        else
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to activate device for wiping: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    if (!wipe_device (cd, tmp_path, &progress, &l_error))
+        g_prefix_error (&l_error, "Failed to wipe the LUKS device: ");
+
+    ret = crypt_deactivate (cd, tmp_name);
+    if (ret != 0)
+        bd_utils_log_format (BD_UTILS_LOG_ERR, "Failed to deactivate temporary device %s", tmp_name);
+
+    crypt_free (cd);
+
+    if (l_error) {
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    bd_utils_report_finished (progress.progress_id, "Completed");
+    return TRUE;
 }
 
 /**
@@ -1620,6 +2756,8 @@ gboolean bd_crypto_luks_change_key (const gchar *device, BDCryptoKeyslotContext
  * You need to specify either @context for LUKS 2 devices that
  * don't have verified key loaded in kernel.
  * For LUKS 1 devices you can set @context %NULL.
+ * If @luks_device was opened with %BD_CRYPTO_LUKS_OPEN_KEYRING_VOLUME_KEY,
+ * @context can be %NULL and the volume key from the kernel keyring is used.
  *
  * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_RESIZE
  */
@@ -1698,6 +2836,19 @@ gboolean bd_crypto_luks_resize (const gchar *luks_device, guint64 size, BDCrypto
             g_propagate_error (error, l_error);
             return FALSE;
         }
+    } else if (get_cached_volume_key (cd, &key_buffer, &buf_len)) {
+        /* volume key kept in the keyring by bd_crypto_luks_open_flags(), no need for the PBKDF */
+        ret = crypt_activate_by_volume_key (cd, NULL, key_buffer, buf_len,
+                                            cad.flags & CRYPT_ACTIVATE_KEYRING_KEY);
+        crypt_safe_free (key_buffer);
+        if (ret < 0) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to verify the volume key from the kernel keyring: %s", strerror_l (-ret, c_locale));
+            crypt_free (cd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
     }
 
     ret = crypt_resize (cd, luks_device, size);
@@ -1774,6 +2925,8 @@ gboolean bd_crypto_luks_suspend (const gchar *luks_device, GError **error) {
  * bd_crypto_luks_resume:
  * @luks_device: LUKS device to resume
  * @context: (nullable): key slot context (passphrase/keyfile/token...) for @luks_device
+ *           or %NULL to use the volume key from the kernel keyring (see
+ *           %BD_CRYPTO_LUKS_OPEN_KEYRING_VOLUME_KEY)
  * @error: (out) (optional): place to store error (if any)
  *
  * Supported @context types for this function: passphrase, key file
@@ -1814,7 +2967,19 @@ gboolean bd_crypto_luks_resume (const gchar *luks_device, BDCryptoKeyslotContext
         return FALSE;
     }
 
-    if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_PASSPHRASE) {
+    if (!context) {
+        /* volume key kept in the keyring by bd_crypto_luks_open_flags(), no need for the PBKDF */
+        if (!get_cached_volume_key (cd, &key_buffer, &buf_len)) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_CONTEXT,
+                         "No context specified and no volume key for '%s' found in the kernel keyring.", luks_device);
+            crypt_free (cd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+        ret = crypt_resume_by_volume_key (cd, luks_device, key_buffer, buf_len);
+        crypt_safe_free (key_buffer);
+    } else if (context->type == BD_CRYPTO_KEYSLOT_CONTEXT_TYPE_PASSPHRASE) {
         ret = crypt_resume_by_passphrase (cd, luks_device, CRYPT_ANY_SLOT,
                                           (const char *) context->u.passphrase.pass_data,
                                           context->u.passphrase.data_len);
@@ -2052,122 +3217,439 @@ gboolean bd_crypto_luks_set_label (const gchar *device, const gchar *label, cons
         return FALSE;
     }
 
-    ret = crypt_set_label (cd, label, subsystem);
+    ret = crypt_set_label (cd, label, subsystem);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to set label: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    crypt_free (cd);
+
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_set_uuid:
+ * @device: device to set UUID on
+ * @uuid: (nullable): UUID to set or %NULL to generate a new one
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the given @uuid was successfully set or not
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_MODIFY
+ */
+gboolean bd_crypto_luks_set_uuid (const gchar *device, const gchar *uuid, GError **error) {
+    struct crypt_device *cd = NULL;
+    gint ret = 0;
+
+    ret = crypt_init (&cd, device);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        return FALSE;
+    }
+
+    ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    ret = crypt_set_uuid (cd, uuid);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to set UUID: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    crypt_free (cd);
+
+    return TRUE;
+}
+
+/**
+ * bd_crypto_luks_convert:
+ * @device:  a LUKS device to convert to a different version of LUKS
+ * @target_version: the LUKS version to convert to
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @device was converted to @target_version.
+ *          False, if the @device is already in the @target_version format.
+ *
+ * Warning: LUKS header loss is possible. See bd_crypto_luks_header_backup() and bd_crypto_luks_header_restore()
+ *
+ * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_MODIFY
+ */
+gboolean bd_crypto_luks_convert (const gchar *device, BDCryptoLUKSVersion target_version, GError **error) {
+    struct crypt_device *cd = NULL;
+    const char *cd_type;
+    const char *target_type;
+    gint ret = 0;
+
+    ret = crypt_init (&cd, device);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        return FALSE;
+    }
+
+    ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    cd_type = crypt_get_type (cd);
+    if (g_strcmp0 (cd_type, CRYPT_LUKS1) != 0 &&
+        g_strcmp0 (cd_type, CRYPT_LUKS2) != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_CONVERT_FAILED,
+                     "It is possible to convert only between LUKS1 and LUKS2 formats. Device %s is of type: %s", device, cd_type);
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    target_type = target_version == BD_CRYPTO_LUKS_VERSION_LUKS1 ? CRYPT_LUKS1 : CRYPT_LUKS2;
+    if (g_strcmp0 (cd_type, target_type) == 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_CONVERT_FAILED,
+                     "Conversion to the %s type was requested, but device %s is already of type: %s", target_type, device, cd_type);
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    ret = crypt_convert (cd, target_type, NULL);
+    if (ret != 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Conversion failed: %s", strerror_l (-ret, c_locale));
+        crypt_free (cd);
+        return FALSE;
+    }
+
+    crypt_free (cd);
+    return TRUE;
+}
+
+/* gets the name of the active LUKS 2 mapping on top of @device (if any) */
+static gchar* get_luks2_holder (const gchar *device) {
+    g_autofree gchar *real_path = NULL;
+    g_autofree gchar *dev_name = NULL;
+    g_autofree gchar *holders_path = NULL;
+    g_autofree gchar *uuid_path = NULL;
+    g_autofree gchar *name_path = NULL;
+    gchar *uuid = NULL;
+    gchar *name = NULL;
+    const gchar *holder = NULL;
+    GDir *dir = NULL;
+
+    real_path = realpath (device, NULL);
+    if (!real_path)
+        return NULL;
+
+    dev_name = g_path_get_basename (real_path);
+    holders_path = g_strdup_printf ("/sys/class/block/%s/holders", dev_name);
+    dir = g_dir_open (holders_path, 0, NULL);
+    if (!dir)
+        return NULL;
+
+    while (!name && (holder = g_dir_read_name (dir))) {
+        uuid_path = g_strdup_printf ("/sys/class/block/%s/dm/uuid", holder);
+        if (g_file_get_contents (uuid_path, &uuid, NULL, NULL) && g_str_has_prefix (uuid, "CRYPT-LUKS2-")) {
+            name_path = g_strdup_printf ("/sys/class/block/%s/dm/name", holder);
+            if (g_file_get_contents (name_path, &name, NULL, NULL))
+                g_strstrip (name);
+            g_clear_pointer (&name_path, g_free);
+        }
+        g_clear_pointer (&uuid, g_free);
+        g_clear_pointer (&uuid_path, g_free);
+    }
+    g_dir_close (dir);
+
+    return name;
+}
+
+typedef struct ReencryptProgress {
+    guint64 progress_id;
+    guint64 max_bandwidth;
+    gint64 start_time;
+    guint64 start_offset;
+    gboolean started;
+} ReencryptProgress;
+
+static int reencrypt_progress (uint64_t size, uint64_t offset, void *usrptr) {
+    ReencryptProgress *progress = (ReencryptProgress *) usrptr;
+    gint64 elapsed = 0;
+    gint64 expected = 0;
+
+    if (!progress->started) {
+        /* the reencryption may be resumed from the middle of the device */
+        progress->start_time = g_get_monotonic_time ();
+        progress->start_offset = offset;
+        progress->started = TRUE;
+    }
+
+    if (size > 0)
+        bd_utils_report_progress (progress->progress_id, offset * 100 / size, NULL);
+
+    /* throttle by sleeping after each hotzone for the time the data would take
+       at the requested bandwidth */
+    if (progress->max_bandwidth > 0 && offset > progress->start_offset) {
+        expected = (gint64) ((gdouble) (offset - progress->start_offset) / progress->max_bandwidth * G_USEC_PER_SEC);
+        elapsed = g_get_monotonic_time () - progress->start_time;
+        if (expected > elapsed)
+            g_usleep (expected - elapsed);
+    }
+
+    return 0;
+}
+
+/* runs the initialized reencryption and frees @cd */
+static gboolean run_reencrypt (struct crypt_device *cd, ReencryptProgress *progress, GError **error) {
+    gint ret = 0;
+    GError *l_error = NULL;
+
+#ifdef LIBCRYPTSETUP_24
+    ret = crypt_reencrypt_run (cd, reencrypt_progress, progress);
+#else
+    ret = crypt_reencrypt (cd, NULL);
+#endif
+    crypt_free (cd);
     if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to set label: %s", strerror_l (-ret, c_locale));
-        crypt_free (cd);
+        /* the reencryption is resumable, the key slots have to stay */
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_REENCRYPT_FAILED,
+                     "Reencryption failed: %s", strerror_l (-ret, c_locale));
+        bd_utils_report_finished (progress->progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    crypt_free (cd);
-
+    bd_utils_report_finished (progress->progress_id, "Completed");
     return TRUE;
 }
 
 /**
- * bd_crypto_luks_set_uuid:
- * @device: device to set UUID on
- * @uuid: (nullable): UUID to set or %NULL to generate a new one
+ * bd_crypto_luks_reencrypt:
+ * @device: a LUKS 2 device to reencrypt
+ * @params: (nullable): reencryption parameters or %NULL for defaults
+ * @context: key slot context (passphrase/keyfile/keyring) to unlock @device
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether the given @uuid was successfully set or not
+ * Reencrypts @device with a newly generated volume key (optionally with a different
+ * cipher). The passphrase from @context is used for the new key slot replacing the
+ * one it unlocked. Unless @params specify offline reencryption, @device needs to be
+ * opened and stays usable during the reencryption. Progress is reported with
+ * %bd_utils_report_progress after each hotzone; the hotzone size and the bandwidth
+ * limit from @params can be used to reduce the impact on the other I/O. An interrupted
+ * reencryption (of @device or started by other tools) is resumed by calling this function
+ * again, the cipher, key size and PBKDF from @params are ignored then (the values stored
+ * in the reencryption metadata are used) and no new key slot is added.
+ *
+ * Supported @context types for this function: passphrase, key file, keyring
+ *
+ * Returns: whether the @device was successfully reencrypted or not
  *
  * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_MODIFY
  */
-gboolean bd_crypto_luks_set_uuid (const gchar *device, const gchar *uuid, GError **error) {
+gboolean bd_crypto_luks_reencrypt (const gchar *device, BDCryptoLUKSReencryptParams *params, BDCryptoKeyslotContext *context, GError **error) {
     struct crypt_device *cd = NULL;
+    struct crypt_params_reencrypt rparams = ZERO_INIT;
+    struct crypt_params_luks2 luks2_params = ZERO_INIT;
+    struct crypt_pbkdf_type *pbkdf = NULL;
+    BDCryptoLUKSReencryptParams default_params = ZERO_INIT;
+    ReencryptProgress progress = ZERO_INIT;
+    g_autofree gchar *name = NULL;
+    g_autofree gchar *cipher = NULL;
+    g_autofree gchar *cipher_mode = NULL;
+    gchar *pass = NULL;
+    gsize pass_len = 0;
+    gsize key_size = 0;
+    gint keyslot_old = 0;
+    gint keyslot_new = 0;
+    crypt_reencrypt_info status = CRYPT_REENCRYPT_NONE;
     gint ret = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    if (!params)
+        params = &default_params;
+
+#ifndef LIBCRYPTSETUP_24
+    if (params->max_bandwidth > 0) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
+                     "Cannot limit the reencryption bandwidth, installed version of cryptsetup doesn't support this option.");
+        return FALSE;
+    }
+#endif
+
+    msg = g_strdup_printf ("Started reencrypting LUKS device '%s'", device);
+    progress.progress_id = bd_utils_report_started (msg);
+    progress.max_bandwidth = params->max_bandwidth;
+    g_free (msg);
 
     ret = crypt_init (&cd, device);
     if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
                      "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    ret = crypt_load (cd, CRYPT_LUKS2, NULL);
     if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to load device: %s", strerror_l (-ret, c_locale));
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to load device's parameters (only LUKS 2 devices can be reencrypted): %s",
+                     strerror_l (-ret, c_locale));
         crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    ret = crypt_set_uuid (cd, uuid);
-    if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to set UUID: %s", strerror_l (-ret, c_locale));
+    if (!params->offline) {
+        name = get_luks2_holder (device);
+        if (!name) {
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_STATE,
+                         "Device '%s' is not opened, cannot reencrypt it online", device);
+            crypt_free (cd);
+            bd_utils_report_finished (progress.progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+    }
+
+    if (!get_context_passphrase (cd, context, &pass, &pass_len, &l_error)) {
         crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    crypt_free (cd);
-
-    return TRUE;
-}
+    luks2_params.sector_size = crypt_get_sector_size (cd);
 
-/**
- * bd_crypto_luks_convert:
- * @device:  a LUKS device to convert to a different version of LUKS
- * @target_version: the LUKS version to convert to
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: whether the @device was converted to @target_version.
- *          False, if the @device is already in the @target_version format.
- *
- * Warning: LUKS header loss is possible. See bd_crypto_luks_header_backup() and bd_crypto_luks_header_restore()
- *
- * Tech category: %BD_CRYPTO_TECH_LUKS-%BD_CRYPTO_TECH_MODE_MODIFY
- */
-gboolean bd_crypto_luks_convert (const gchar *device, BDCryptoLUKSVersion target_version, GError **error) {
-    struct crypt_device *cd = NULL;
-    const char *cd_type;
-    const char *target_type;
-    gint ret = 0;
+    /* in 512B sectors */
+    rparams.max_hotzone_size = params->max_hotzone_size / 512;
+    rparams.luks2 = &luks2_params;
 
-    ret = crypt_init (&cd, device);
-    if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to initialize device: %s", strerror_l (-ret, c_locale));
+    status = crypt_reencrypt_status (cd, NULL);
+    if (status == CRYPT_REENCRYPT_INVALID) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_REENCRYPT_FAILED,
+                     "Failed to get reencryption status of device '%s'", device);
+        crypt_safe_free (pass);
+        crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    ret = crypt_load (cd, CRYPT_LUKS, NULL);
-    if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Failed to load device: %s", strerror_l (-ret, c_locale));
-        crypt_free (cd);
-        return FALSE;
+    if (status != CRYPT_REENCRYPT_NONE) {
+        /* an interrupted reencryption, the key slot for the new volume key
+           and the other parameters are already stored in the metadata (an
+           interrupted resilience operation is recovered by cryptsetup) */
+        msg = g_strdup_printf ("Resuming interrupted reencryption of LUKS device '%s'", device);
+        bd_utils_report_progress (progress.progress_id, 0, msg);
+        g_free (msg);
+
+        rparams.resilience = params->resilience;
+        if (g_strcmp0 (rparams.resilience, "checksum") == 0)
+            rparams.hash = params->hash ? params->hash : "sha256";
+        rparams.flags = CRYPT_REENCRYPT_RESUME_ONLY;
+
+        ret = crypt_reencrypt_init_by_passphrase (cd, name, pass, pass_len, CRYPT_ANY_SLOT, CRYPT_ANY_SLOT,
+                                                  NULL, NULL, &rparams);
+        crypt_safe_free (pass);
+        if (ret < 0) {
+            if (ret == -EPERM)
+                g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                             "Failed to resume reencryption: Incorrect passphrase.");
+            else
+                g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_REENCRYPT_FAILED,
+                             "Failed to resume reencryption: %s", strerror_l (-ret, c_locale));
+            crypt_free (cd);
+            bd_utils_report_finished (progress.progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+
+        return run_reencrypt (cd, &progress, error);
     }
 
-    cd_type = crypt_get_type (cd);
-    if (g_strcmp0 (cd_type, CRYPT_LUKS1) != 0 &&
-        g_strcmp0 (cd_type, CRYPT_LUKS2) != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_CONVERT_FAILED,
-                     "It is possible to convert only between LUKS1 and LUKS2 formats. Device %s is of type: %s", device, cd_type);
+    /* just checks the passphrase and gets the key slot it opens */
+    keyslot_old = crypt_activate_by_passphrase (cd, NULL, CRYPT_ANY_SLOT, pass, pass_len, 0);
+    if (keyslot_old < 0) {
+        if (keyslot_old == -EPERM)
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to unlock device: Incorrect passphrase.");
+        else
+            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                         "Failed to unlock device: %s", strerror_l (-keyslot_old, c_locale));
+        crypt_safe_free (pass);
         crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    target_type = target_version == BD_CRYPTO_LUKS_VERSION_LUKS1 ? CRYPT_LUKS1 : CRYPT_LUKS2;
-    if (g_strcmp0 (cd_type, target_type) == 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_CONVERT_FAILED,
-                     "Conversion to the %s type was requested, but device %s is already of type: %s", target_type, device, cd_type);
+    cipher = g_strdup (params->cipher ? params->cipher : crypt_get_cipher (cd));
+    cipher_mode = g_strdup (params->cipher_mode ? params->cipher_mode : crypt_get_cipher_mode (cd));
+    key_size = params->key_size ? params->key_size / 8 : (gsize) crypt_get_volume_key_size (cd);
+
+    if (params->pbkdf) {
+        pbkdf = get_pbkdf_params (params->pbkdf, &l_error);
+        if (pbkdf == NULL && l_error != NULL) {
+            crypt_safe_free (pass);
+            crypt_free (cd);
+            g_prefix_error (&l_error, "Failed to get PBKDF parameters for '%s'.", device);
+            bd_utils_report_finished (progress.progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+        crypt_set_pbkdf_type (cd, pbkdf);
+    }
+
+    /* a key slot for the new volume key, not used for any segment yet */
+    keyslot_new = crypt_keyslot_add_by_key (cd, CRYPT_ANY_SLOT, NULL, key_size, pass, pass_len,
+                                            CRYPT_VOLUME_KEY_NO_SEGMENT);
+    if (keyslot_new < 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_ADD_KEY,
+                     "Failed to add a key slot for the new volume key: %s", strerror_l (-keyslot_new, c_locale));
+        crypt_safe_free (pass);
         crypt_free (cd);
+        g_free (pbkdf);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    ret = crypt_convert (cd, target_type, NULL);
-    if (ret != 0) {
-        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                     "Conversion failed: %s", strerror_l (-ret, c_locale));
+    luks2_params.pbkdf = pbkdf;
+
+    rparams.mode = CRYPT_REENCRYPT_REENCRYPT;
+    rparams.direction = CRYPT_REENCRYPT_FORWARD;
+    rparams.resilience = params->resilience ? params->resilience : "checksum";
+    if (g_strcmp0 (rparams.resilience, "checksum") == 0)
+        rparams.hash = params->hash ? params->hash : "sha256";
+    rparams.flags = 0;
+
+    ret = crypt_reencrypt_init_by_passphrase (cd, name, pass, pass_len, keyslot_old, keyslot_new,
+                                              cipher, cipher_mode, &rparams);
+    crypt_safe_free (pass);
+    g_free (pbkdf);
+    if (ret < 0) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_REENCRYPT_FAILED,
+                     "Failed to initialize reencryption: %s", strerror_l (-ret, c_locale));
+        crypt_keyslot_destroy (cd, keyslot_new);
         crypt_free (cd);
+        bd_utils_report_finished (progress.progress_id, l_error->message);
+        g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    crypt_free (cd);
-    return TRUE;
+    return run_reencrypt (cd, &progress, error);
 }
 
 static gint synced_close (gint fd) {
@@ -2275,24 +3757,18 @@ static gboolean get_subsystem_label (const gchar *device, gchar **subsystem, gch
  */
 BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error) {
     struct crypt_device *cd = NULL;
+    CachedHeader *cached = NULL;
     BDCryptoLUKSInfo *info = NULL;
     const gchar *version = NULL;
-    gint ret;
+    gint ret = 0;
     gboolean success = FALSE;
 
-    ret = crypt_init (&cd, device);
-    if (ret != 0) {
-        /* not a block device, try init_by_name */
-        crypt_free (cd);
+    cached = header_cache_acquire (device);
+    if (cached)
+        cd = cached->cd;
+    else
+        /* not a LUKS block device, try init_by_name */
         ret = crypt_init_by_name (&cd, device);
-    } else {
-        ret = crypt_load (cd, CRYPT_LUKS, NULL);
-        if (ret != 0) {
-            /* not a LUKS device, try init_by_name */
-            crypt_free (cd);
-            ret = crypt_init_by_name (&cd, device);
-        }
-    }
 
     if (ret != 0) {
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
@@ -2311,6 +3787,7 @@ BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error) {
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_TECH_UNAVAIL,
                      "Unknown or unsupported LUKS version");
         bd_crypto_luks_info_free (info);
+        release_device (cd, cached);
         return NULL;
     }
 
@@ -2325,7 +3802,7 @@ BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error) {
     if (info->version == BD_CRYPTO_LUKS_VERSION_LUKS2) {
         success = get_subsystem_label (crypt_get_device_name (cd) , &(info->subsystem), &(info->label), error);
         if (!success) {
-            crypt_free (cd);
+            release_device (cd, cached);
             bd_crypto_luks_info_free (info);
             return NULL;
         }
@@ -2334,7 +3811,7 @@ BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error) {
         info->subsystem = g_strdup ("");
     }
 
-    crypt_free (cd);
+    release_device (cd, cached);
 
     return info;
 }
@@ -2403,16 +3880,19 @@ BDCryptoIntegrityInfo* bd_crypto_integrity_info (const gchar *device, GError **e
     struct crypt_device *cd = NULL;
     struct crypt_params_integrity ip = ZERO_INIT;
     BDCryptoIntegrityInfo *info = NULL;
-    gint ret;
+    CachedHeader *cached = NULL;
+    gint ret = 0;
 
-    ret = crypt_init (&cd, device);
-    if (ret != 0) {
-        /* not a block device, try init_by_name */
-        crypt_free (cd);
-        ret = crypt_init_by_name (&cd, device);
-    } else {
-        ret = crypt_load (cd, CRYPT_LUKS, NULL);
+    cached = header_cache_acquire (device);
+    if (cached)
+        cd = cached->cd;
+    else {
+        ret = crypt_init (&cd, device);
         if (ret != 0) {
+            /* not a block device, try init_by_name */
+            crypt_free (cd);
+            ret = crypt_init_by_name (&cd, device);
+        } else {
             /* not a LUKS device, try integrity */
             ret = crypt_load (cd, CRYPT_INTEGRITY, NULL);
             if (ret != 0) {
@@ -2432,7 +3912,7 @@ BDCryptoIntegrityInfo* bd_crypto_integrity_info (const gchar *device, GError **e
     if (ret != 0) {
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
                      "Failed to get information about device: %s", strerror_l (-ret, c_locale));
-        crypt_free (cd);
+        release_device (cd, cached);
         return NULL;
     }
 
@@ -2447,7 +3927,7 @@ BDCryptoIntegrityInfo* bd_crypto_integrity_info (const gchar *device, GError **e
     info->journal_crypt = g_strdup (ip.journal_crypt);
     info->journal_integrity = g_strdup (ip.journal_integrity);
 
-    crypt_free (cd);
+    release_device (cd, cached);
     return info;
 }
 
@@ -2476,20 +3956,15 @@ BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError *
     const gchar *type = NULL;
     gint ret;
     gint token_it, keyslot_it;
+    CachedHeader *cached = NULL;
 
-    ret = crypt_init (&cd, device);
-    if (ret != 0) {
-        /* not a block device, try init_by_name */
-        crypt_free (cd);
+    cached = header_cache_acquire (device);
+    if (cached) {
+        cd = cached->cd;
+        ret = 0;
+    } else
+        /* not a LUKS block device, try init_by_name */
         ret = crypt_init_by_name (&cd, device);
-    } else {
-        ret = crypt_load (cd, CRYPT_LUKS, NULL);
-        if (ret != 0) {
-            /* not a LUKS device, try init_by_name */
-            crypt_free (cd);
-            ret = crypt_init_by_name (&cd, device);
-        }
-    }
 
     if (ret != 0) {
         g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
@@ -2498,7 +3973,7 @@ BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError *
     }
 
     if (g_strcmp0 (crypt_get_type (cd), CRYPT_LUKS2) != 0) {
-        crypt_free (cd);
+        release_device (cd, cached);
         return NULL;
     }
 
@@ -2525,21 +4000,13 @@ BDCryptoLUKSTokenInfo** bd_crypto_luks_token_info (const gchar *device, GError *
         g_ptr_array_add (tokens, info);
     }
 
-    crypt_free (cd);
+    release_device (cd, cached);
 
     /* returning NULL-terminated array of BDCryptoLUKSTokenInfo */
     g_ptr_array_add (tokens, NULL);
     return (BDCryptoLUKSTokenInfo **) g_ptr_array_free (tokens, FALSE);
 }
 
-static int _wipe_progress (guint64 size, guint64 offset, void *usrptr) {
-    /* "convert" the progress from 0-100 to 50-100 because wipe starts at 50 in bd_crypto_integrity_format */
-    gdouble progress = 50 + (((gdouble) offset / size) * 100) / 2;
-    bd_utils_report_progress (*(guint64 *) usrptr, progress, "Integrity device wipe in progress");
-
-    return 0;
-}
-
 /**
  * bd_crypto_integrity_format:
  * @device: a device to format as integrity
@@ -2564,6 +4031,7 @@ gboolean bd_crypto_integrity_format (const gchar *device, const gchar *algorithm
     guint64 progress_id = 0;
     gchar *msg = NULL;
     struct crypt_params_integrity params = ZERO_INIT;
+    WipeProgress progress = ZERO_INIT;
     g_autofree gchar *tmp_name = NULL;
     g_autofree gchar *tmp_path = NULL;
     g_autofree gchar *dev_name = NULL;
@@ -2636,13 +4104,13 @@ gboolean bd_crypto_integrity_format (const gchar *device, const gchar *algorithm
         }
 
         bd_utils_report_progress (progress_id, 50, "Starting to wipe the newly created integrity device");
-        ret = crypt_wipe (cd, tmp_path, CRYPT_WIPE_ZERO, 0, 0, 1048576,
-                          0, &_wipe_progress, &progress_id);
-        bd_utils_report_progress (progress_id, 100, "Wipe finished");
-        if (ret != 0) {
-            g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
-                         "Failed to wipe the newly created integrity device: %s",
-                         strerror_l (-ret, c_locale));
+        /* wipe starts at 50 % of the whole format */
+        progress.progress_id = progress_id;
+        progress.start = 50;
+        progress.msg = "Integrity device wipe in progress";
+        if (!wipe_device (cd, tmp_path, &progress, &l_error)) {
+            bd_utils_report_progress (progress_id, 100, "Wipe finished");
+            g_prefix_error (&l_error, "Failed to wipe the newly created integrity device: ");
 
             ret = crypt_deactivate (cd, tmp_name);
             if (ret != 0)
@@ -2654,6 +4122,8 @@ gboolean bd_crypto_integrity_format (const gchar *device, const gchar *algorithm
             return FALSE;
         }
 
+        bd_utils_report_progress (progress_id, 100, "Wipe finished");
+
         ret = crypt_deactivate (cd, tmp_name);
         if (ret != 0)
             bd_utils_log_format (BD_UTILS_LOG_ERR, "Failed to deactivate temporary device %s", tmp_name);
@@ -2710,8 +4180,30 @@ gboolean bd_crypto_integrity_open (const gchar *device, const gchar *name, const
         params.interleave_sectors = extra->interleave_sectors;
         params.tag_size = extra->tag_size;
         params.buffer_sectors = extra->buffer_sectors;
+
+        if (extra->bitmap_sectors_per_bit || extra->bitmap_flush_time) {
+            if (!(flags & BD_CRYPTO_INTEGRITY_OPEN_NO_JOURNAL_BITMAP)) {
+                g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_PARAMS,
+                             "Bitmap parameters can be used only in the bitmap mode.");
+                bd_utils_report_finished (progress_id, l_error->message);
+                g_propagate_error (error, l_error);
+                return FALSE;
+            }
+            /* libcryptsetup uses the journal parameters for the bitmap mode */
+            if (extra->bitmap_sectors_per_bit)
+                params.journal_watermark = extra->bitmap_sectors_per_bit;
+            if (extra->bitmap_flush_time)
+                params.journal_commit_time = extra->bitmap_flush_time;
+        }
     }
 
+    if ((flags & BD_CRYPTO_INTEGRITY_OPEN_NO_JOURNAL) && (flags & BD_CRYPTO_INTEGRITY_OPEN_NO_JOURNAL_BITMAP)) {
+        g_set_error (&l_error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_PARAMS,
+                     "The 'no journal' and the bitmap modes cannot be combined.");
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
 
     if (flags & BD_CRYPTO_INTEGRITY_OPEN_NO_JOURNAL)
         activate_flags |= CRYPT_ACTIVATE_NO_JOURNAL;
@@ -2815,6 +4307,33 @@ gboolean bd_crypto_keyring_add_key (const gchar *key_desc, const guint8 *key_dat
     return TRUE;
 }
 
+static gfloat compute_chi_square (const guchar *buf, gsize len) {
+    /* four separate histograms so that the increments of the same symbol in
+       consecutive bytes don't depend on each other */
+    guint symbols[4][256] = {{0}};
+    gfloat chi_square = 0.0;
+    gfloat e = (gfloat) len / (gfloat) 256.0;
+    gfloat diff = 0.0;
+    gsize i;
+
+    for (i = 0; i + 4 <= len; i += 4) {
+        /* This is safe because the max value of buf[i] is < 256. */
+        symbols[0][buf[i]]++;
+        symbols[1][buf[i + 1]]++;
+        symbols[2][buf[i + 2]]++;
+        symbols[3][buf[i + 3]]++;
+    }
+    for (; i < len; i++)
+        symbols[0][buf[i]]++;
+
+    for (i = 0; i < 256; i++) {
+        diff = (symbols[0][i] + symbols[1][i] + symbols[2][i] + symbols[3][i]) - e;
+        chi_square += diff * diff;
+    }
+
+    return chi_square / e;
+}
+
 /**
  * bd_crypto_device_seems_encrypted:
  * @device: the queried device
@@ -2841,10 +4360,7 @@ gboolean bd_crypto_keyring_add_key (const gchar *key_desc, const guint8 *key_dat
 gboolean bd_crypto_device_seems_encrypted (const gchar *device, GError **error) {
     gint fd = -1;
     guchar buf[SQUARE_BYTES_TO_CHECK];
-    guint symbols[256] = {0};
     gfloat chi_square = 0.0;
-    gfloat e = (gfloat) sizeof (buf) / (gfloat) 256.0;
-    guint i;
     guint64 progress_id = 0;
     gchar *msg = NULL;
     GError *l_error = NULL;
@@ -2871,18 +4387,161 @@ gboolean bd_crypto_device_seems_encrypted (const gchar *device, GError **error)
 
     close (fd);
 
-    /* Calculate Chi Square */
-    for (i = 0; i < sizeof (buf); i++)
-        /* This is safe because the max value of buf[i] is < sizeof (symbols). */
-        symbols[buf[i]]++;
-    for (i = 0; i < 256; i++)
-        chi_square += (symbols[i] - e) * (symbols[i] - e);
-    chi_square /= e;
+    chi_square = compute_chi_square (buf, sizeof (buf));
 
     bd_utils_report_finished (progress_id, "Completed");
     return SQUARE_LOWER_LIMIT < chi_square && chi_square < SQUARE_UPPER_LIMIT;
 }
 
+typedef struct SeemsEncryptedItem {
+    BDCryptoSeemsEncryptedResult *result;
+    gint fd;
+} SeemsEncryptedItem;
+
+#define SQUARE_QUEUE_DEPTH 256
+
+static void seems_encrypted_sample_done (BDUtilsIORequest *request, gpointer user_data G_GNUC_UNUSED) {
+    SeemsEncryptedItem *item = (SeemsEncryptedItem *) request->user_data;
+    gfloat chi_square = 0.0;
+
+    if (!item->result->seems_encrypted)
+        /* some other sample already failed */
+        return;
+
+    if (request->result < SQUARE_BYTES_TO_CHECK) {
+        g_set_error (&(item->result->error), BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to read device '%s': %s", item->result->device,
+                     request->result < 0 ? strerror_l (-request->result, c_locale) : "Short read");
+        item->result->seems_encrypted = FALSE;
+        return;
+    }
+
+    chi_square = compute_chi_square (request->buf, SQUARE_BYTES_TO_CHECK);
+    item->result->seems_encrypted = SQUARE_LOWER_LIMIT < chi_square && chi_square < SQUARE_UPPER_LIMIT;
+}
+
+/* adds the requests for the samples of the device of @item to @requests */
+static void seems_encrypted_prepare (SeemsEncryptedItem *item, guint num_samples, GArray *requests) {
+    const gchar *device = item->result->device;
+    BDUtilsIORequest request;
+    guint64 size = 0;
+    guint64 offset = 0;
+    guint i = 0;
+
+    item->fd = bd_utils_io_open_direct (device, O_RDONLY, NULL);
+    if (item->fd == -1) {
+        g_set_error (&(item->result->error), BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Failed to open device '%s': %s", device, strerror_l (errno, c_locale));
+        return;
+    }
+
+    if (ioctl (item->fd, BLKGETSIZE64, &size) != 0) {
+        /* not a block device */
+        size = (guint64) lseek (item->fd, 0, SEEK_END);
+    }
+
+    /* encrypted devices look random everywhere, not only at the start */
+    for (i = 0; i < num_samples; i++) {
+        offset = (size / num_samples) * i;
+        offset -= offset % SQUARE_SAMPLE_ALIGN;
+        if (offset + SQUARE_SAMPLE_ALIGN > size)
+            break;
+        memset (&request, 0, sizeof (request));
+        request.fd = item->fd;
+        request.offset = offset;
+        request.length = SQUARE_SAMPLE_ALIGN;
+        request.user_data = item;
+        g_array_append_val (requests, request);
+    }
+
+    if (i == 0)
+        g_set_error (&(item->result->error), BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_DEVICE,
+                     "Device '%s' is too small", device);
+    else
+        item->result->seems_encrypted = TRUE;
+}
+
+/**
+ * bd_crypto_devices_seem_encrypted:
+ * @devices: (array zero-terminated=1): the queried devices
+ * @num_samples: number of places (evenly spread, starting at the beginning) to check
+ *               on each of the @devices or 0 for default (4)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Determines whether the block @devices seem to be encrypted in the same way
+ * as %bd_crypto_device_seems_encrypted does, but for many devices at once.
+ * The samples of all the devices are read at once (with direct I/O, using
+ * io_uring if available) and the chi square test is done for @num_samples
+ * places on each device -- a device seems to be encrypted only if all the
+ * samples pass. Only the start of the batch and its end are reported as
+ * progress.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results for the @devices (in
+ *                                                     the same order as @devices) or
+ *                                                     %NULL in case of error
+ *
+ * Tech category: %BD_CRYPTO_TECH_TRUECRYPT-%BD_CRYPTO_TECH_MODE_QUERY
+ */
+BDCryptoSeemsEncryptedResult** bd_crypto_devices_seem_encrypted (const gchar **devices, guint num_samples, GError **error) {
+    BDCryptoSeemsEncryptedResult **ret = NULL;
+    SeemsEncryptedItem *items = NULL;
+    BDUtilsIOEngine *engine = NULL;
+    GArray *requests = NULL;
+    guint num_devices = 0;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    if (!devices) {
+        g_set_error (error, BD_CRYPTO_ERROR, BD_CRYPTO_ERROR_INVALID_PARAMS,
+                     "No devices given");
+        return NULL;
+    }
+
+    num_devices = g_strv_length ((gchar **) devices);
+    if (num_samples == 0)
+        num_samples = SQUARE_DEFAULT_SAMPLES;
+
+    msg = g_strdup_printf ("Started determining if %u devices seem to be encrypted", num_devices);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    ret = g_new0 (BDCryptoSeemsEncryptedResult *, num_devices + 1);
+    items = g_new0 (SeemsEncryptedItem, num_devices);
+    requests = g_array_new (FALSE, FALSE, sizeof (BDUtilsIORequest));
+    for (guint i = 0; i < num_devices; i++) {
+        ret[i] = g_new0 (BDCryptoSeemsEncryptedResult, 1);
+        ret[i]->device = g_strdup (devices[i]);
+        items[i].result = ret[i];
+        seems_encrypted_prepare (&(items[i]), num_samples, requests);
+    }
+
+    engine = bd_utils_io_engine_new (MIN (requests->len, SQUARE_QUEUE_DEPTH), SQUARE_SAMPLE_ALIGN, &l_error);
+    if (!engine || !bd_utils_io_engine_run (engine, (BDUtilsIORequest *) requests->data, requests->len,
+                                            seems_encrypted_sample_done, NULL, &l_error)) {
+        g_prefix_error (&l_error, "Failed to read the devices: ");
+        for (guint i = 0; i < num_devices; i++)
+            bd_crypto_seems_encrypted_result_free (ret[i]);
+        g_clear_pointer (&ret, g_free);
+    }
+    bd_utils_io_engine_free (engine);
+
+    for (guint i = 0; i < num_devices; i++)
+        if (items[i].fd != -1)
+            close (items[i].fd);
+    g_array_free (requests, TRUE);
+    g_free (items);
+
+    if (!ret) {
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    bd_utils_report_finished (progress_id, "Completed");
+    return ret;
+}
+
 /**
  * bd_crypto_tc_open:
  * @device: the device to open
@@ -26,6 +26,7 @@ typedef enum {
     BD_CRYPTO_ERROR_KEYFILE_FAILED,
     BD_CRYPTO_ERROR_INVALID_CONTEXT,
     BD_CRYPTO_ERROR_CONVERT_FAILED,
+    BD_CRYPTO_ERROR_REENCRYPT_FAILED,
 } BDCryptoError;
 
 #define BD_CRYPTO_BACKUP_PASSPHRASE_CHARSET "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz./"
@@ -112,6 +113,34 @@ void bd_crypto_luks_extra_free (BDCryptoLUKSExtra *extra);
 BDCryptoLUKSExtra* bd_crypto_luks_extra_copy (BDCryptoLUKSExtra *extra);
 BDCryptoLUKSExtra* bd_crypto_luks_extra_new (guint64 data_alignment, const gchar *data_device, const gchar *integrity, guint32 sector_size, const gchar *label, const gchar *subsystem, BDCryptoLUKSPBKDF *pbkdf);
 
+/**
+ * BDCryptoLUKSReencryptParams:
+ * @key_size: size of the new volume key in bits or 0 to keep the current size
+ * @cipher: new cipher (e.g. "aes") or NULL to keep the current one
+ * @cipher_mode: new cipher mode (e.g. "xts-plain64") or NULL to keep the current one
+ * @resilience: resilience mode for the hotzone ("checksum", "journal" or "none") or NULL for default ("checksum")
+ * @hash: hash for the "checksum" resilience mode or NULL for default ("sha256")
+ * @max_hotzone_size: maximum size (in bytes) of the area reencrypted in one step or 0 for default
+ * @max_bandwidth: maximum reencryption throughput (in bytes per second) or 0 for no limit
+ * @offline: whether to reencrypt a closed device (instead of an opened one)
+ * @pbkdf: key derivation function specification for the new key slot or NULL for default
+ */
+typedef struct BDCryptoLUKSReencryptParams {
+    guint32 key_size;
+    gchar *cipher;
+    gchar *cipher_mode;
+    gchar *resilience;
+    gchar *hash;
+    guint64 max_hotzone_size;
+    guint64 max_bandwidth;
+    gboolean offline;
+    BDCryptoLUKSPBKDF *pbkdf;
+} BDCryptoLUKSReencryptParams;
+
+void bd_crypto_luks_reencrypt_params_free (BDCryptoLUKSReencryptParams *params);
+BDCryptoLUKSReencryptParams* bd_crypto_luks_reencrypt_params_copy (BDCryptoLUKSReencryptParams *params);
+BDCryptoLUKSReencryptParams* bd_crypto_luks_reencrypt_params_new (guint32 key_size, const gchar *cipher, const gchar *cipher_mode, const gchar *resilience, const gchar *hash, guint64 max_hotzone_size, guint64 max_bandwidth, gboolean offline, BDCryptoLUKSPBKDF *pbkdf);
+
 /**
  * BDCryptoIntegrityExtra:
  * @sector_size: integrity sector size
@@ -121,6 +150,9 @@ BDCryptoLUKSExtra* bd_crypto_luks_extra_new (guint64 data_alignment, const gchar
  * @interleave_sectors: number of interleave sectors (power of two)
  * @tag_size: tag size per-sector in bytes
  * @buffer_sectors: number of sectors in one buffer
+ * @bitmap_sectors_per_bit: number of sectors covered by one bit in bitmap mode
+ *                          (see %BD_CRYPTO_INTEGRITY_OPEN_NO_JOURNAL_BITMAP), 0 for default
+ * @bitmap_flush_time: bitmap flush interval in ms in bitmap mode, 0 for default
  */
 typedef struct BDCryptoIntegrityExtra {
     guint32 sector_size;
@@ -130,6 +162,8 @@ typedef struct BDCryptoIntegrityExtra {
     guint32 interleave_sectors;
     guint32 tag_size;
     guint32 buffer_sectors;
+    guint32 bitmap_sectors_per_bit;
+    guint bitmap_flush_time;
 } BDCryptoIntegrityExtra;
 
 void bd_crypto_integrity_extra_free (BDCryptoIntegrityExtra *extra);
@@ -145,6 +179,17 @@ typedef enum {
     BD_CRYPTO_INTEGRITY_OPEN_ALLOW_DISCARDS     = 1 << 5,
 } BDCryptoIntegrityOpenFlags;
 
+typedef enum {
+    BD_CRYPTO_LUKS_OPEN_READONLY               = 1 << 0,
+    BD_CRYPTO_LUKS_OPEN_ALLOW_DISCARDS         = 1 << 1,
+    BD_CRYPTO_LUKS_OPEN_SAME_CPU_CRYPT         = 1 << 2,
+    BD_CRYPTO_LUKS_OPEN_SUBMIT_FROM_CRYPT_CPUS = 1 << 3,
+    BD_CRYPTO_LUKS_OPEN_NO_READ_WORKQUEUE      = 1 << 4,
+    BD_CRYPTO_LUKS_OPEN_NO_WRITE_WORKQUEUE     = 1 << 5,
+    BD_CRYPTO_LUKS_OPEN_PERSISTENT             = 1 << 6,
+    BD_CRYPTO_LUKS_OPEN_KEYRING_VOLUME_KEY     = 1 << 7,
+} BDCryptoLUKSOpenFlags;
+
 /**
  * BDCryptoLUKSInfo:
  * @version: LUKS version
@@ -232,6 +277,34 @@ typedef struct BDCryptoLUKSTokenInfo {
 void bd_crypto_luks_token_info_free (BDCryptoLUKSTokenInfo *info);
 BDCryptoLUKSTokenInfo* bd_crypto_luks_token_info_copy (BDCryptoLUKSTokenInfo *info);
 
+/**
+ * BDCryptoBulkResult:
+ * @device: device the result is for
+ * @error: (nullable): error that occurred for @device or %NULL in case of success
+ */
+typedef struct BDCryptoBulkResult {
+    gchar *device;
+    GError *error;
+} BDCryptoBulkResult;
+
+void bd_crypto_bulk_result_free (BDCryptoBulkResult *result);
+BDCryptoBulkResult* bd_crypto_bulk_result_copy (BDCryptoBulkResult *result);
+
+/**
+ * BDCryptoSeemsEncryptedResult:
+ * @device: device the result is for
+ * @seems_encrypted: whether @device seems to be encrypted or not
+ * @error: (nullable): error that occurred for @device or %NULL in case of success
+ */
+typedef struct BDCryptoSeemsEncryptedResult {
+    gchar *device;
+    gboolean seems_encrypted;
+    GError *error;
+} BDCryptoSeemsEncryptedResult;
+
+void bd_crypto_seems_encrypted_result_free (BDCryptoSeemsEncryptedResult *result);
+BDCryptoSeemsEncryptedResult* bd_crypto_seems_encrypted_result_copy (BDCryptoSeemsEncryptedResult *result);
+
 typedef struct _BDCryptoKeyslotContext BDCryptoKeyslotContext;
 
 void bd_crypto_keyslot_context_free (BDCryptoKeyslotContext *context);
@@ -259,9 +332,14 @@ gchar* bd_crypto_generate_backup_passphrase(GError **error);
 gboolean bd_crypto_device_is_luks (const gchar *device, GError **error);
 const gchar* bd_crypto_luks_status (const gchar *luks_device, GError **error);
 
+BDCryptoLUKSPBKDF* bd_crypto_luks_pbkdf_calibrate (BDCryptoLUKSPBKDF *pbkdf, guint64 key_size, GError **error);
 gboolean bd_crypto_luks_format (const gchar *device, const gchar *cipher, guint64 key_size, BDCryptoKeyslotContext *context, guint64 min_entropy, BDCryptoLUKSVersion luks_version, BDCryptoLUKSExtra *extra,GError **error);
 gboolean bd_crypto_luks_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, gboolean read_only, GError **error);
+gboolean bd_crypto_luks_open_flags (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, BDCryptoLUKSOpenFlags flags, GError **error);
 gboolean bd_crypto_luks_close (const gchar *luks_device, GError **error);
+BDCryptoBulkResult** bd_crypto_luks_open_many (const gchar **devices, const gchar **names, BDCryptoKeyslotContext *context, gboolean read_only, guint64 max_memory_kb, GError **error);
+BDCryptoBulkResult** bd_crypto_luks_close_many (const gchar **luks_devices, GError **error);
+gboolean bd_crypto_luks_wipe (const gchar *device, BDCryptoKeyslotContext *context, GError **error);
 gboolean bd_crypto_luks_add_key (const gchar *device, BDCryptoKeyslotContext *context, BDCryptoKeyslotContext *ncontext, GError **error);
 gboolean bd_crypto_luks_remove_key (const gchar *device, BDCryptoKeyslotContext *context, GError **error);
 gboolean bd_crypto_luks_change_key (const gchar *device, BDCryptoKeyslotContext *context, BDCryptoKeyslotContext *ncontext, GError **error);
@@ -274,6 +352,7 @@ gboolean bd_crypto_luks_header_restore (const gchar *device, const gchar *backup
 gboolean bd_crypto_luks_set_label (const gchar *device, const gchar *label, const gchar *subsystem, GError **error);
 gboolean bd_crypto_luks_set_uuid (const gchar *device, const gchar *uuid, GError **error);
 gboolean bd_crypto_luks_convert (const gchar *device, BDCryptoLUKSVersion target_version, GError **error);
+gboolean bd_crypto_luks_reencrypt (const gchar *device, BDCryptoLUKSReencryptParams *params, BDCryptoKeyslotContext *context, GError **error);
 
 BDCryptoLUKSInfo* bd_crypto_luks_info (const gchar *device, GError **error);
 BDCryptoBITLKInfo* bd_crypto_bitlk_info (const gchar *device, GError **error);
@@ -287,6 +366,7 @@ gboolean bd_crypto_integrity_close (const gchar *integrity_device, GError **erro
 gboolean bd_crypto_keyring_add_key (const gchar *key_desc, const guint8 *key_data, gsize data_len, GError **error);
 
 gboolean bd_crypto_device_seems_encrypted (const gchar *device, GError **error);
+BDCryptoSeemsEncryptedResult** bd_crypto_devices_seem_encrypted (const gchar **devices, guint num_samples, GError **error);
 gboolean bd_crypto_tc_open (const gchar *device, const gchar *name, BDCryptoKeyslotContext *context, const gchar **keyfiles, gboolean hidden, gboolean system, gboolean veracrypt, guint32 veracrypt_pim, gboolean read_only, GError **error);
 gboolean bd_crypto_tc_close (const gchar *tc_device, GError **error);
 
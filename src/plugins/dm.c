@@ -19,6 +19,7 @@
 
 #include <glib.h>
 #include <unistd.h>
+#include <string.h>
 #include <blockdev/utils.h>
 #include <libdevmapper.h>
 #include <stdarg.h>
@@ -27,6 +28,7 @@
 #include "dm.h"
 #include "check_deps.h"
 #include "dm_logging.h"
+#include "dm_snapshot.h"
 
 #define DM_MIN_VERSION "1.02.93"
 
@@ -236,17 +238,68 @@ gchar* bd_dm_node_from_name (const gchar *map_name, GError **error) {
  * Tech category: %BD_DM_TECH_MAP-%BD_DM_TECH_MODE_QUERY
  */
 gchar* bd_dm_get_subsystem_from_name (const gchar *device_name, GError **error) {
-    gchar *output = NULL;
-    gboolean success = FALSE;
-    const gchar *argv[] = {"dmsetup", "info", "-co", "subsystem", "--noheadings", device_name, NULL};
+    DMSnapshotMap *map = NULL;
+    const gchar *dash = NULL;
+    gchar *ret = NULL;
 
-    success = bd_utils_exec_and_capture_output (argv, NULL, &output, error);
-    if (!success)
-        /* error is already populated */
+    if (geteuid () != 0) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_NOT_ROOT,
+                     "Not running as root, cannot query DM maps");
         return NULL;
+    }
+
+    map = dm_snapshot_map_status (device_name);
+    if (!map) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
+                     "Failed to get information about the DM map '%s'", device_name);
+        return NULL;
+    }
+
+    /* the subsystem is the UUID prefix (as reported by 'dmsetup info -co subsystem') */
+    dash = strchr (map->uuid, '-');
+    if (dash)
+        ret = g_strndup (map->uuid, dash - map->uuid);
+    else
+        ret = g_strdup ("");
+    dm_snapshot_map_free (map);
+
+    return ret;
+}
+
+/* looks up @map_name directly by its name (DM_DEVICE_INFO) instead of going
+ * through the list of all the maps */
+static gboolean map_exists (const gchar *map_name, gboolean live_only, gboolean active_only, GError **error) {
+    struct dm_task *task_info = NULL;
+    struct dm_info info;
+    gboolean ret = FALSE;
+
+    task_info = dm_task_create (DM_DEVICE_INFO);
+    if (!task_info) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
+                     "Failed to create DM task");
+        return FALSE;
+    }
 
-    output = g_strstrip (output);
-    return output;
+    /* a failure here means the map cannot exist (e.g. invalid name) */
+    if (dm_task_set_name (task_info, map_name) == 0 ||
+        dm_task_run (task_info) == 0 ||
+        dm_task_get_info (task_info, &info) == 0) {
+        dm_task_destroy (task_info);
+        return FALSE;
+    }
+
+    if (info.exists) {
+        /* found existing name match, let's test the restrictions */
+        ret = TRUE;
+        if (live_only)
+            ret = info.live_table;
+        if (active_only)
+            ret = ret && !info.suspended;
+    }
+
+    dm_task_destroy (task_info);
+
+    return ret;
 }
 
 /**
@@ -263,82 +316,59 @@ gchar* bd_dm_get_subsystem_from_name (const gchar *device_name, GError **error)
  * Tech category: %BD_DM_TECH_MAP-%BD_DM_TECH_MODE_QUERY
  */
 gboolean bd_dm_map_exists (const gchar *map_name, gboolean live_only, gboolean active_only, GError **error) {
-    struct dm_task *task_list = NULL;
-    struct dm_task *task_info = NULL;
-    struct dm_names *names = NULL;
-    struct dm_info info;
-    guint64 next = 0;
-    gboolean ret = FALSE;
-
     if (geteuid () != 0) {
         g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_NOT_ROOT,
                      "Not running as root, cannot query DM maps");
         return FALSE;
     }
 
-    task_list = dm_task_create (DM_DEVICE_LIST);
-    if (!task_list) {
-        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
-                     "Failed to create DM task");
-        return FALSE;
-    }
-
-    dm_task_run (task_list);
-    names = dm_task_get_names (task_list);
-
-    if (!names || !names->dev)
+    if (!map_name || *map_name == '\0')
         return FALSE;
 
-    do {
-        names = (void *)names + next;
-        next = names->next;
-        /* we are searching for the particular map_name map */
-        if (g_strcmp0 (map_name, names->name) != 0)
-            /* not matching, skip */
-            continue;
+    return map_exists (map_name, live_only, active_only, error);
+}
 
-        /* get device info */
-        task_info = dm_task_create (DM_DEVICE_INFO);
-        if (!task_info) {
-            g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_TASK,
-                         "Failed to create DM task");
-            break;
-        }
+/**
+ * bd_dm_maps_exist:
+ * @map_names: (array zero-terminated=1): names of the queried maps
+ * @live_only: whether to go through the live maps only or not
+ * @active_only: whether to ignore suspended maps or not
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * The same as bd_dm_map_exists() but for multiple maps at once. Each of the
+ * maps is looked up directly by its name so the cost doesn't depend on the
+ * total number of DM maps in the system.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): names from @map_names that exist
+ * (and are live if @live_only is %TRUE (and are active if @active_only is %TRUE)),
+ * in the same order as in @map_names or %NULL in case of error
+ *
+ * Tech category: %BD_DM_TECH_MAP-%BD_DM_TECH_MODE_QUERY
+ */
+gchar** bd_dm_maps_exist (const gchar **map_names, gboolean live_only, gboolean active_only, GError **error) {
+    GPtrArray *found = NULL;
+    GError *l_error = NULL;
+    const gchar **name = NULL;
 
-        /* something failed, try next one */
-        if (dm_task_set_name (task_info, names->name) == 0) {
-            dm_task_destroy (task_info);
-            continue;
-        }
-        if (dm_task_run (task_info) == 0) {
-            dm_task_destroy (task_info);
-            continue;
-        }
-        if (dm_task_get_info (task_info, &info) == 0) {
-            dm_task_destroy (task_info);
-            continue;
-        }
+    if (geteuid () != 0) {
+        g_set_error (error, BD_DM_ERROR, BD_DM_ERROR_NOT_ROOT,
+                     "Not running as root, cannot query DM maps");
+        return NULL;
+    }
 
-        if (!info.exists) {
-            /* doesn't exist, try next one */
-            dm_task_destroy (task_info);
+    found = g_ptr_array_new_with_free_func (g_free);
+    for (name = map_names; name && *name; name++) {
+        if (**name == '\0')
             continue;
+        if (map_exists (*name, live_only, active_only, &l_error))
+            g_ptr_array_add (found, g_strdup (*name));
+        else if (l_error) {
+            g_propagate_error (error, l_error);
+            g_ptr_array_free (found, TRUE);
+            return NULL;
         }
+    }
+    g_ptr_array_add (found, NULL);
 
-        /* found existing name match, let's test the restrictions */
-        ret = TRUE;
-        if (live_only)
-            ret = info.live_table;
-        if (active_only)
-            ret = ret && !info.suspended;
-
-        dm_task_destroy (task_info);
-        if (ret)
-            /* found match according to restrictions */
-            break;
-    } while (next);
-
-    dm_task_destroy (task_list);
-
-    return ret;
+    return (gchar **) g_ptr_array_free (found, FALSE);
 }
@@ -41,6 +41,7 @@ gboolean bd_dm_is_tech_avail (BDDMTech tech, guint64 mode, GError **error);
 gboolean bd_dm_create_linear (const gchar *map_name, const gchar *device, guint64 length, const gchar *uuid, GError **error);
 gboolean bd_dm_remove (const gchar *map_name, GError **error);
 gboolean bd_dm_map_exists (const gchar *map_name, gboolean live_only, gboolean active_only, GError **error);
+gchar** bd_dm_maps_exist (const gchar **map_names, gboolean live_only, gboolean active_only, GError **error);
 gchar* bd_dm_name_from_node (const gchar *dm_node, GError **error);
 gchar* bd_dm_node_from_name (const gchar *map_name, GError **error);
 gchar* bd_dm_get_subsystem_from_name (const gchar *device_name, GError **error);
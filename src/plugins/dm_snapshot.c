@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <sys/sysmacros.h>
+#include <libdevmapper.h>
+#include <blockdev/utils.h>
+
+#include "dm_snapshot.h"
+
+/* The snapshot records the information about all the DM maps in a single sweep
+ * so that queries for multiple maps (e.g. "which maps are multipath maps" or
+ * "what are the deps of all the multipath maps") don't need to issue
+ * DM_DEVICE_STATUS and DM_DEVICE_DEPS for every map again and again. The last
+ * snapshot is cached for DM_SNAPSHOT_TTL, snapshots are immutable and
+ * reference counted so they can be used from multiple threads.
+ *
+ * The module is compiled into every plugin using it and so is the cache,
+ * dm_snapshot_invalidate() only drops the cache of the calling plugin. The
+ * snapshots are thus only meant for queries over many maps that can live
+ * with the status being up to DM_SNAPSHOT_TTL old, queries for a single map
+ * (especially its status counters) should use dm_snapshot_map_status(). */
+
+static GMutex snapshot_lock;
+static DMSnapshot *last_snapshot = NULL;
+
+void dm_snapshot_map_free (DMSnapshotMap *map) {
+    g_free (map->name);
+    g_free (map->uuid);
+    g_free (map->target_type);
+    g_free (map->status);
+    g_free (map->deps);
+    g_free (map);
+}
+
+static void snapshot_free (DMSnapshot *snapshot) {
+    g_hash_table_destroy (snapshot->by_name);
+    g_ptr_array_free (snapshot->maps, TRUE);
+    g_free (snapshot);
+}
+
+/* gets the status (incl. the info and UUID) of the map, returns %FALSE if
+ * the map doesn't exist (anymore) */
+static gboolean get_map_status (DMSnapshotMap *map) {
+    struct dm_task *task = NULL;
+    struct dm_info info;
+    const gchar *uuid = NULL;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *type = NULL;
+    gchar *params = NULL;
+
+    task = dm_task_create (DM_DEVICE_STATUS);
+    if (!task)
+        return FALSE;
+
+    if (dm_task_set_name (task, map->name) == 0 ||
+        dm_task_run (task) == 0 ||
+        dm_task_get_info (task, &info) == 0 ||
+        !info.exists) {
+        dm_task_destroy (task);
+        return FALSE;
+    }
+
+    if (map->dev == 0)
+        map->dev = makedev (info.major, info.minor);
+    map->suspended = info.suspended;
+    map->live_table = info.live_table;
+    map->event_nr = info.event_nr;
+    uuid = dm_task_get_uuid (task);
+    map->uuid = g_strdup (uuid ? uuid : "");
+
+    dm_get_next_target (task, NULL, &start, &length, &type, &params);
+    map->target_type = g_strdup (type);
+    map->status = g_strdup (params);
+
+    dm_task_destroy (task);
+    return TRUE;
+}
+
+static gboolean get_map_deps (DMSnapshotMap *map) {
+    struct dm_task *task = NULL;
+    struct dm_deps *deps = NULL;
+    guint i = 0;
+
+    task = dm_task_create (DM_DEVICE_DEPS);
+    if (!task)
+        return FALSE;
+
+    if (dm_task_set_name (task, map->name) == 0 ||
+        dm_task_run (task) == 0) {
+        dm_task_destroy (task);
+        return FALSE;
+    }
+
+    deps = dm_task_get_deps (task);
+    if (!deps) {
+        dm_task_destroy (task);
+        return FALSE;
+    }
+
+    map->n_deps = deps->count;
+    map->deps = g_new0 (dev_t, deps->count + 1);
+    for (i = 0; i < deps->count; i++)
+        map->deps[i] = (dev_t) deps->device[i];
+
+    dm_task_destroy (task);
+    return TRUE;
+}
+
+static DMSnapshot* take_snapshot (void) {
+    struct dm_task *task_names = NULL;
+    struct dm_names *names = NULL;
+    DMSnapshot *snapshot = NULL;
+    DMSnapshotMap *map = NULL;
+    guint64 next = 0;
+
+    task_names = dm_task_create (DM_DEVICE_LIST);
+    if (!task_names) {
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create DM task");
+        return NULL;
+    }
+
+    if (dm_task_run (task_names) == 0) {
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to list DM maps");
+        dm_task_destroy (task_names);
+        return NULL;
+    }
+
+    snapshot = g_new0 (DMSnapshot, 1);
+    snapshot->ref_count = 1;
+    snapshot->timestamp = g_get_monotonic_time ();
+    snapshot->maps = g_ptr_array_new_with_free_func ((GDestroyNotify) dm_snapshot_map_free);
+    snapshot->by_name = g_hash_table_new (g_str_hash, g_str_equal);
+
+    names = dm_task_get_names (task_names);
+    if (names && names->dev) {
+        do {
+            names = (void *)names + next;
+            next = names->next;
+
+            map = g_new0 (DMSnapshotMap, 1);
+            map->name = g_strdup (names->name);
+            map->dev = (dev_t) names->dev;
+            /* the map may disappear in the meantime, just skip it then */
+            if (!get_map_status (map) || !get_map_deps (map)) {
+                dm_snapshot_map_free (map);
+                continue;
+            }
+            g_ptr_array_add (snapshot->maps, map);
+            g_hash_table_insert (snapshot->by_name, map->name, map);
+        } while (next);
+    }
+
+    dm_task_destroy (task_names);
+    return snapshot;
+}
+
+/* returns a snapshot of all the DM maps (to be released with dm_snapshot_unref())
+ * or %NULL in case of error, the cached one is reused unless @force_refresh is
+ * %TRUE or it's older than DM_SNAPSHOT_TTL */
+DMSnapshot* dm_snapshot_get (gboolean force_refresh) {
+    DMSnapshot *snapshot = NULL;
+
+    g_mutex_lock (&snapshot_lock);
+    if (last_snapshot && !force_refresh &&
+        (g_get_monotonic_time () - last_snapshot->timestamp) < DM_SNAPSHOT_TTL) {
+        snapshot = last_snapshot;
+        g_atomic_int_inc (&(snapshot->ref_count));
+        g_mutex_unlock (&snapshot_lock);
+        return snapshot;
+    }
+
+    snapshot = take_snapshot ();
+    if (snapshot) {
+        if (last_snapshot)
+            dm_snapshot_unref (last_snapshot);
+        /* one reference for the cache, one for the caller */
+        g_atomic_int_inc (&(snapshot->ref_count));
+        last_snapshot = snapshot;
+    }
+    g_mutex_unlock (&snapshot_lock);
+
+    return snapshot;
+}
+
+void dm_snapshot_unref (DMSnapshot *snapshot) {
+    if (snapshot && g_atomic_int_dec_and_test (&(snapshot->ref_count)))
+        snapshot_free (snapshot);
+}
+
+/* returns information about the map called @name or %NULL if not found */
+const DMSnapshotMap* dm_snapshot_lookup (DMSnapshot *snapshot, const gchar *name) {
+    return g_hash_table_lookup (snapshot->by_name, name);
+}
+
+/* drops the cached snapshot so that the next dm_snapshot_get() call takes
+ * a new one, should be called after the DM maps are changed */
+void dm_snapshot_invalidate (void) {
+    g_mutex_lock (&snapshot_lock);
+    if (last_snapshot) {
+        dm_snapshot_unref (last_snapshot);
+        last_snapshot = NULL;
+    }
+    g_mutex_unlock (&snapshot_lock);
+}
+
+/* gets the current status of the map called @name (without the deps) outside
+ * of any snapshot, e.g. for sampling of the status counters, returns %NULL if
+ * the map doesn't exist, the result needs to be freed with
+ * dm_snapshot_map_free() */
+DMSnapshotMap* dm_snapshot_map_status (const gchar *name) {
+    DMSnapshotMap *map = g_new0 (DMSnapshotMap, 1);
+
+    map->name = g_strdup (name);
+    if (!get_map_status (map)) {
+        dm_snapshot_map_free (map);
+        return NULL;
+    }
+
+    return map;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <sys/types.h>
+
+#ifndef BD_DM_SNAPSHOT
+#define BD_DM_SNAPSHOT
+
+/* how long (in microseconds) a snapshot is reused before a new one is taken */
+#define DM_SNAPSHOT_TTL (2 * G_USEC_PER_SEC)
+
+typedef struct DMSnapshotMap {
+    gchar *name;
+    gchar *uuid;
+    dev_t dev;
+    gboolean suspended;
+    gboolean live_table;
+    guint32 event_nr;
+    /* type and status params of the first target (if any) */
+    gchar *target_type;
+    gchar *status;
+    dev_t *deps;
+    guint n_deps;
+} DMSnapshotMap;
+
+typedef struct DMSnapshot {
+    gint ref_count;
+    gint64 timestamp;
+    /* DMSnapshotMap items in the order given by the kernel */
+    GPtrArray *maps;
+    GHashTable *by_name;
+} DMSnapshot;
+
+DMSnapshot* dm_snapshot_get (gboolean force_refresh);
+void dm_snapshot_unref (DMSnapshot *snapshot);
+const DMSnapshotMap* dm_snapshot_lookup (DMSnapshot *snapshot, const gchar *name);
+void dm_snapshot_invalidate (void);
+
+DMSnapshotMap* dm_snapshot_map_status (const gchar *name);
+void dm_snapshot_map_free (DMSnapshotMap *map);
+
+#endif  /* BD_DM_SNAPSHOT */
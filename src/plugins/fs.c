@@ -22,6 +22,7 @@
 
 #include <check_deps.h>
 #include "fs.h"
+#include "fs/common.h"
 
 /**
  * SECTION: fs
@@ -72,7 +73,7 @@ gboolean bd_fs_init (void) {
  *
  */
 void bd_fs_close (void) {
-    /* nothing to do here */
+    mounts_cache_clear ();
 }
 
 /**
@@ -11,4 +11,13 @@ gint synced_close (gint fd);
 gboolean get_uuid_label (const gchar *device, gchar **uuid, gchar **label, GError **error);
 gboolean check_uuid (const gchar *uuid, GError **error);
 
+typedef struct FSMountEntry {
+    gchar *mountpoint;
+    gchar *fstype;
+} FSMountEntry;
+
+void fs_mount_entry_free (FSMountEntry *entry);
+GHashTable* get_mount_entries (GError **error);
+void mounts_cache_clear (void);
+
 #endif  /* BD_FS_COMMON */
@@ -238,9 +238,30 @@ void bd_fs_ext4_info_free (BDFSExt4Info *data) {
     bd_fs_ext2_info_free ((BDFSExt2Info*) data);
 }
 
+/* block size the file system will be created with, needed to express the stripe
+   geometry in blocks (mke2fs uses 1 KiB blocks for small devices so 4 KiB blocks
+   are requested explicitly if not specified in @extra) */
+static guint64 ext_mkfs_block_size (const BDExtraArg **extra, gboolean *explicit) {
+    const BDExtraArg **extra_p = NULL;
+    guint64 block_size = 0;
+
+    for (extra_p = extra; extra_p && *extra_p; extra_p++)
+        if (g_strcmp0 ((*extra_p)->opt, "-b") == 0)
+            block_size = g_ascii_strtoull ((*extra_p)->val, NULL, 10);
+
+    *explicit = block_size != 0;
+    return block_size != 0 ? block_size : 4 KiB;
+}
+
 static BDExtraArg **ext_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
     GPtrArray *options_array = g_ptr_array_new ();
     const BDExtraArg **extra_p = NULL;
+    GPtrArray *ext_opts = g_ptr_array_new_with_free_func (g_free);
+    GPtrArray *journal_opts = g_ptr_array_new_with_free_func (g_free);
+    gchar *opts_str = NULL;
+    gboolean explicit_bs = FALSE;
+    guint64 block_size = 0;
+    guint64 stride = 0;
 
     if (options->label && g_strcmp0 (options->label, "") != 0)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-L", options->label));
@@ -252,7 +273,53 @@ static BDExtraArg **ext_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg
         g_ptr_array_add (options_array, bd_extra_arg_new ("-n", ""));
 
     if (options->no_discard)
-        g_ptr_array_add (options_array, bd_extra_arg_new ("-E", "nodiscard"));
+        g_ptr_array_add (ext_opts, g_strdup ("nodiscard"));
+
+    if (options->lazy_init) {
+        g_ptr_array_add (ext_opts, g_strdup ("lazy_itable_init=1"));
+        g_ptr_array_add (ext_opts, g_strdup ("lazy_journal_init=1"));
+    }
+
+    if (options->stripe_unit > 0) {
+        block_size = ext_mkfs_block_size (extra, &explicit_bs);
+        stride = options->stripe_unit / block_size;
+        if (stride > 0) {
+            if (!explicit_bs)
+                g_ptr_array_add (options_array, bd_extra_arg_new ("-b", "4096"));
+            g_ptr_array_add (ext_opts, g_strdup_printf ("stride=%"G_GUINT64_FORMAT, stride));
+            if (options->stripe_width > 0)
+                g_ptr_array_add (ext_opts, g_strdup_printf ("stripe_width=%"G_GUINT64_FORMAT,
+                                                            stride * options->stripe_width));
+        }
+    }
+
+    if (ext_opts->len > 0) {
+        g_ptr_array_add (ext_opts, NULL);
+        opts_str = g_strjoinv (",", (gchar **) ext_opts->pdata);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-E", opts_str));
+        g_free (opts_str);
+    }
+    g_ptr_array_free (ext_opts, TRUE);
+
+    if (options->log_size > 0)
+        g_ptr_array_add (journal_opts, g_strdup_printf ("size=%"G_GUINT32_FORMAT, options->log_size));
+
+    if (options->log_device && g_strcmp0 (options->log_device, "") != 0)
+        g_ptr_array_add (journal_opts, g_strdup_printf ("device=%s", options->log_device));
+
+    if (journal_opts->len > 0) {
+        g_ptr_array_add (journal_opts, NULL);
+        opts_str = g_strjoinv (",", (gchar **) journal_opts->pdata);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-J", opts_str));
+        g_free (opts_str);
+    }
+    g_ptr_array_free (journal_opts, TRUE);
+
+    if (options->inode_size > 0) {
+        opts_str = g_strdup_printf ("%"G_GUINT32_FORMAT, options->inode_size);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-I", opts_str));
+        g_free (opts_str);
+    }
 
     if (options->force)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-F", ""));
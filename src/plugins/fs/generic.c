@@ -17,6 +17,7 @@
  * Author: Vratislav Podzimek <vpodzime@redhat.com>
  */
 
+#define _GNU_SOURCE
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <blkid.h>
@@ -27,6 +28,9 @@
 #include <linux/fs.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/statvfs.h>
+#include <stdlib.h>
 
 #include <blockdev/utils.h>
 
@@ -39,6 +43,9 @@
 #include "vfat.h"
 #include "ntfs.h"
 #include "f2fs.h"
+#include "../../utils/parallel.h"
+#include "../../utils/io_engine.h"
+#include "../../utils/probe.h"
 
 
 
@@ -63,7 +70,7 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* EXT2 */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW | BD_FS_OFFLINE_SHRINK,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_LAZY_INIT | BD_FS_MKFS_STRIPE | BD_FS_MKFS_INODE_SIZE,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -72,7 +79,8 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* EXT3 */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW | BD_FS_OFFLINE_SHRINK,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_LAZY_INIT | BD_FS_MKFS_STRIPE | BD_FS_MKFS_LOG_SIZE |
+              BD_FS_MKFS_LOG_DEVICE | BD_FS_MKFS_INODE_SIZE,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -81,7 +89,8 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* EXT4 */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW | BD_FS_OFFLINE_SHRINK,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_LAZY_INIT | BD_FS_MKFS_STRIPE | BD_FS_MKFS_LOG_SIZE |
+              BD_FS_MKFS_LOG_DEVICE | BD_FS_MKFS_INODE_SIZE,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -90,7 +99,8 @@ static const BDFSFeatures fs_features[BD_FS_LAST_FS] = {
     /* XFS */
     { .resize = BD_FS_ONLINE_GROW | BD_FS_OFFLINE_GROW,
       .mkfs = BD_FS_MKFS_LABEL | BD_FS_MKFS_UUID | BD_FS_MKFS_DRY_RUN | BD_FS_MKFS_NODISCARD |
-              BD_FS_MKFS_FORCE,
+              BD_FS_MKFS_FORCE | BD_FS_MKFS_STRIPE | BD_FS_MKFS_LOG_SIZE | BD_FS_MKFS_LOG_DEVICE |
+              BD_FS_MKFS_INODE_SIZE,
       .fsck = BD_FS_FSCK_CHECK | BD_FS_FSCK_REPAIR,
       .configure = BD_FS_SUPPORT_SET_LABEL | BD_FS_SUPPORT_SET_UUID,
       .features =  BD_FS_FEATURE_OWNERS,
@@ -349,6 +359,42 @@ static BDFSTech fstype_to_tech (const gchar *fstype) {
     }
 }
 
+#define DEFAULT_PROBE_TIMEOUT_MS 500
+
+static guint probe_timeout_ms = DEFAULT_PROBE_TIMEOUT_MS;
+
+/**
+ * bd_fs_set_probe_timeout:
+ * @timeout_ms: how long (in milliseconds) to keep retrying to probe a busy
+ *              device or 0 to reset to the default (500 ms)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Sets the deadline for the signature probing functions (bd_fs_wipe(),
+ * bd_fs_get_fstype(),...) to wait for a device that cannot be probed at the
+ * moment (e.g. because it is still being processed by udev after partitioning).
+ *
+ * Returns: whether the new timeout was successfully set or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC no mode (it is ignored)
+ */
+gboolean bd_fs_set_probe_timeout (guint timeout_ms, GError **error G_GNUC_UNUSED) {
+    g_atomic_int_set (&probe_timeout_ms, timeout_ms ? timeout_ms : DEFAULT_PROBE_TIMEOUT_MS);
+    return TRUE;
+}
+
+/* Runs @step until it succeeds or the probe timeout passes, see
+   bd_utils_probe_with_retry(). */
+static gint probe_with_retry (const gchar *device, blkid_probe probe, gint fd, BDUtilsProbeStep step) {
+    BDUtilsTimingSpan span;
+    gint status = 0;
+
+    bd_utils_timing_span_begin (&span, "fs", G_STRFUNC);
+    status = bd_utils_probe_with_retry (device, probe, fd, step, g_atomic_int_get (&probe_timeout_ms));
+    bd_utils_timing_span_end (&span, 0, "blkid probe", 0, status >= 0 ? 0 : -1);
+
+    return status;
+}
+
 /**
  * bd_fs_wipe:
  * @device: the device to wipe signatures from
@@ -366,7 +412,6 @@ gboolean bd_fs_wipe (const gchar *device, gboolean all, gboolean force, GError *
     gint status = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
-    guint n_try = 0;
     gint mode = 0;
     GError *l_error = NULL;
 
@@ -398,13 +443,9 @@ gboolean bd_fs_wipe (const gchar *device, gboolean all, gboolean force, GError *
         return FALSE;
     }
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; (status != 0) && (n_try > 0); n_try--) {
-        status = blkid_probe_set_device (probe, fd, 0, 0);
-        if (status != 0)
-            g_usleep (100 * 1000); /* microseconds */
-    }
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SET_DEVICE);
     if (status != 0) {
         g_set_error (&l_error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Failed to create a probe for the device '%s'", device);
@@ -420,15 +461,9 @@ gboolean bd_fs_wipe (const gchar *device, gboolean all, gboolean force, GError *
     blkid_probe_enable_superblocks (probe, 1);
     blkid_probe_set_superblocks_flags (probe, BLKID_SUBLKS_MAGIC | BLKID_SUBLKS_BADCSUM);
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; (status != 0) && (n_try > 0); n_try--) {
-        status = blkid_do_safeprobe (probe);
-        if (status == 1)
-            break;
-        if (status < 0)
-            g_usleep (100 * 1000); /* microseconds */
-    }
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SAFEPROBE);
     if (status == 1) {
         g_set_error (&l_error, BD_FS_ERROR, BD_FS_ERROR_NOFS,
                      "No signature detected on the device '%s'", device);
@@ -517,27 +552,338 @@ gboolean bd_fs_clean (const gchar *device, gboolean force, GError **error) {
       return TRUE;
 }
 
+/* signatures (partition tables, RAID and LVM metadata, filesystem superblocks)
+   live in the first and last MiB of the device (GPT backup, MD 1.0 and 0.90
+   metadata, ZFS labels,...) */
+#define CLEAN_EDGE_SIZE (1 MiB)
+
+static gboolean clean_zero_edges (gint fd, guint64 size, const gchar *device, GError **error) {
+    g_autofree guint8 *buf = NULL;
+    guint64 ranges[2][2] = {{0, MIN (CLEAN_EDGE_SIZE, size)}, {0, 0}};
+    guint64 range[2];
+    gssize written = 0;
+
+    if (size > 2 * CLEAN_EDGE_SIZE) {
+        ranges[1][0] = size - CLEAN_EDGE_SIZE;
+        ranges[1][1] = CLEAN_EDGE_SIZE;
+    } else
+        ranges[0][1] = size;
+
+    for (guint i = 0; i < 2; i++) {
+        if (ranges[i][1] == 0)
+            continue;
+
+        range[0] = ranges[i][0];
+        range[1] = ranges[i][1];
+        if (ioctl (fd, BLKZEROOUT, &range) == 0)
+            continue;
+
+        /* not a block device or not supported, just write the zeroes */
+        if (!buf)
+            buf = g_malloc0 (CLEAN_EDGE_SIZE);
+        for (guint64 offset = 0; offset < ranges[i][1]; offset += written) {
+            written = pwrite (fd, buf, MIN (CLEAN_EDGE_SIZE, ranges[i][1] - offset), ranges[i][0] + offset);
+            if (written <= 0) {
+                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                             "Failed to zero out the device '%s': %s",
+                             device, strerror_l (errno, _C_LOCALE));
+                return FALSE;
+            }
+        }
+    }
+
+    if (fsync (fd) != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to sync the device '%s': %s",
+                     device, strerror_l (errno, _C_LOCALE));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void clean_progress (guint64 size, guint64 done, gpointer user_data) {
+    bd_utils_report_progress (*((guint64 *) user_data), (done * 100) / size, NULL);
+}
+
+/* discards or zeroes out the whole device, %BD_FS_ERROR_NOT_SUPPORTED in @error
+   means the device doesn't support the operation at all */
+static gboolean clean_whole_device (gint fd, guint64 size, gboolean discard, const gchar *device,
+                                    guint64 progress_id, GError **error) {
+    GError *l_error = NULL;
+
+    if (bd_utils_io_zero_out_device (fd, device, size, discard, clean_progress, &progress_id, &l_error))
+        return TRUE;
+
+    g_set_error (error, BD_FS_ERROR,
+                 g_error_matches (l_error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_NOT_SUPPORTED) ?
+                 BD_FS_ERROR_NOT_SUPPORTED : BD_FS_ERROR_FAIL,
+                 "%s", l_error->message);
+    g_clear_error (&l_error);
+    return FALSE;
+}
+
 /**
- * bd_fs_get_fstype:
- * @device: the device to probe
+ * bd_fs_clean_device:
+ * @device: the device to clean
+ * @mode: how to clean @device
+ * @force: whether to clean a mounted (or otherwise used) @device
  * @error: (out) (optional): place to store error (if any)
  *
- * Get first signature on @device as a string.
+ * Cleans @device the way specified by @mode. Unlike bd_fs_clean() which removes
+ * signatures one by one, %BD_FS_CLEAN_EDGES zeroes out the regions at the start
+ * and the end of @device where the signatures live (including the backup GPT
+ * header) without probing, %BD_FS_CLEAN_ZEROOUT zeroes out the whole @device
+ * (offloaded to the device if supported) and %BD_FS_CLEAN_DISCARD discards all
+ * the blocks of @device returning it to a "factory empty" state. As discarded
+ * blocks don't necessarily read back as zeroes, the edges are zeroed out after
+ * the discard and if @device doesn't support discard at all, only the edges are
+ * zeroed out.
  *
- * Returns: (transfer full): type of filesystem found on @device, %NULL in case
- *                           no signature has been detected or in case of error
- *                           (@error is set in this case)
+ * Returns: whether @device was successfully cleaned or not
  *
- * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_WIPE
  */
-gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
+gboolean bd_fs_clean_device (const gchar *device, BDFSCleanMode mode, gboolean force, GError **error) {
+    gint fd = 0;
+    gint flags = 0;
+    guint64 size = 0;
+    guint64 progress_id = 0;
+    gboolean ret = FALSE;
+    struct stat st;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    if (mode == BD_FS_CLEAN_SIGNATURES)
+        return bd_fs_clean (device, force, error);
+
+    msg = g_strdup_printf ("Started cleaning the device '%s'", device);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    flags = O_RDWR | O_CLOEXEC;
+    if (!force)
+        flags |= O_EXCL;
+
+    fd = open (device, flags);
+    if (fd == -1) {
+        g_set_error (&l_error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to open the device '%s': %s",
+                     device, strerror_l (errno, _C_LOCALE));
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode))
+        size = (guint64) st.st_size;
+    else if (ioctl (fd, BLKGETSIZE64, &size) != 0) {
+        g_set_error (&l_error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                     "Failed to get size of the device '%s': %s",
+                     device, strerror_l (errno, _C_LOCALE));
+        synced_close (fd);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    switch (mode) {
+        case BD_FS_CLEAN_DISCARD:
+            ret = clean_whole_device (fd, size, TRUE, device, progress_id, &l_error);
+            if (!ret && g_error_matches (l_error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED))
+                /* only the edges can be zeroed out then */
+                g_clear_error (&l_error);
+            if (!l_error)
+                ret = clean_zero_edges (fd, size, device, &l_error);
+            break;
+        case BD_FS_CLEAN_ZEROOUT:
+            ret = clean_whole_device (fd, size, FALSE, device, progress_id, &l_error);
+            break;
+        case BD_FS_CLEAN_EDGES:
+            ret = clean_zero_edges (fd, size, device, &l_error);
+            break;
+        default:
+            g_set_error (&l_error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                         "Invalid clean mode: %d", mode);
+    }
+
+    synced_close (fd);
+
+    if (!ret) {
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    bd_utils_report_finished (progress_id, "Completed");
+    return TRUE;
+}
+
+/**
+ * bd_fs_clean_result_free: (skip)
+ * @data: (nullable): %BDFSCleanResult to free
+ *
+ * Frees @data.
+ */
+void bd_fs_clean_result_free (BDFSCleanResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->device);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+/**
+ * bd_fs_clean_result_copy: (skip)
+ * @data: (nullable): %BDFSCleanResult to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSCleanResult* bd_fs_clean_result_copy (BDFSCleanResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSCleanResult *ret = g_new0 (BDFSCleanResult, 1);
+
+    ret->device = g_strdup (data->device);
+    ret->success = data->success;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+typedef struct CleanManyData {
+    BDFSCleanMode mode;
+    gboolean force;
+    BDUtilsParallelProgress progress;
+} CleanManyData;
+
+static void clean_many_thread (gpointer data, gpointer user_data) {
+    BDFSCleanResult *result = (BDFSCleanResult *) data;
+    CleanManyData *clean_data = (CleanManyData *) user_data;
+
+    result->success = bd_fs_clean_device (result->device, clean_data->mode, clean_data->force, &(result->error));
+
+    bd_utils_parallel_progress_item_done (&(clean_data->progress), result->device, result->success, result->error);
+}
+
+/**
+ * bd_fs_clean_many:
+ * @devices: (array zero-terminated=1): devices to clean
+ * @mode: how to clean the @devices
+ * @force: whether to clean mounted (or otherwise used) devices
+ * @max_workers: maximum number of devices to clean in parallel or 0 for the default
+ *               (number of CPUs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Cleans all the @devices in parallel the same way bd_fs_clean_device() does.
+ * A failure for one of the devices doesn't affect the others, it is reported in
+ * the #BDFSCleanResult.error field of the particular entry. The overall progress
+ * is reported as a single task with a progress update for every cleaned device,
+ * progress of the individual devices is reported (as separate tasks) only to
+ * the global progress reporting function, if set.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the cleaning (one entry
+ *                                                     per device in the same order as in @devices)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_WIPE
+ */
+BDFSCleanResult** bd_fs_clean_many (const gchar **devices, BDFSCleanMode mode, gboolean force, guint max_workers, GError **error) {
+    BDFSCleanResult **ret = NULL;
+    CleanManyData data;
+    guint n_devices = 0;
+    gchar *msg = NULL;
+
+    if (!devices) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "No devices specified");
+        return NULL;
+    }
+
+    memset (&data, 0, sizeof (data));
+    data.mode = mode;
+    data.force = force;
+    n_devices = g_strv_length ((gchar **) devices);
+
+    ret = g_new0 (BDFSCleanResult *, n_devices + 1);
+    for (guint i = 0; i < n_devices; i++) {
+        ret[i] = g_new0 (BDFSCleanResult, 1);
+        ret[i]->device = g_strdup (devices[i]);
+    }
+
+    msg = g_strdup_printf ("Started cleaning %u devices", n_devices);
+    bd_utils_parallel_progress_start (&(data.progress), n_devices, msg);
+    g_free (msg);
+
+    bd_utils_parallel_run (clean_many_thread, (gpointer *) ret, n_devices, max_workers, &data);
+
+    bd_utils_parallel_progress_finish (&(data.progress), NULL);
+
+    return ret;
+}
+
+/**
+ * bd_fs_probe_info_free: (skip)
+ * @data: (nullable): %BDFSProbeInfo to free
+ *
+ * Frees @data.
+ */
+void bd_fs_probe_info_free (BDFSProbeInfo *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->type);
+    g_free (data->usage);
+    g_free (data->uuid);
+    g_free (data->label);
+    g_free (data->version);
+    g_free (data->pt_type);
+    g_free (data->part_uuid);
+    g_free (data);
+}
+
+/**
+ * bd_fs_probe_info_copy: (skip)
+ * @data: (nullable): %BDFSProbeInfo to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSProbeInfo* bd_fs_probe_info_copy (BDFSProbeInfo *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSProbeInfo *ret = g_new0 (BDFSProbeInfo, 1);
+
+    ret->type = g_strdup (data->type);
+    ret->usage = g_strdup (data->usage);
+    ret->uuid = g_strdup (data->uuid);
+    ret->label = g_strdup (data->label);
+    ret->version = g_strdup (data->version);
+    ret->pt_type = g_strdup (data->pt_type);
+    ret->part_uuid = g_strdup (data->part_uuid);
+    ret->size = data->size;
+
+    return ret;
+}
+
+static gchar* probe_get_value (blkid_probe probe, const gchar *name) {
+    const gchar *value = NULL;
+
+    if (blkid_probe_lookup_value (probe, name, &value, NULL) != 0)
+        return NULL;
+
+    return g_strdup (value);
+}
+
+/* runs a single (safe)probe on @device, @details also asks for the values
+   not needed to just identify the signature (UUID, label, partition entry...) */
+static BDFSProbeInfo* probe_device (const gchar *device, gboolean details, GError **error) {
     blkid_probe probe = NULL;
+    BDFSProbeInfo *ret = NULL;
     gint fd = 0;
     gint status = 0;
-    const gchar *value = NULL;
-    gchar *fstype = NULL;
-    size_t len = 0;
-    guint n_try = 0;
 
     probe = blkid_new_probe ();
     if (!probe) {
@@ -555,13 +901,9 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
         return NULL;
     }
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; (status != 0) && (n_try > 0); n_try--) {
-        status = blkid_probe_set_device (probe, fd, 0, 0);
-        if (status != 0)
-            g_usleep (100 * 1000); /* microseconds */
-    }
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SET_DEVICE);
     if (status != 0) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Failed to create a probe for the device '%s'", device);
@@ -571,18 +913,23 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
     }
 
     blkid_probe_enable_partitions (probe, 1);
-    blkid_probe_set_partitions_flags (probe, BLKID_PARTS_MAGIC);
-    blkid_probe_enable_superblocks (probe, 1);
-    blkid_probe_set_superblocks_flags (probe, BLKID_SUBLKS_USAGE | BLKID_SUBLKS_TYPE |
-                                              BLKID_SUBLKS_MAGIC | BLKID_SUBLKS_BADCSUM);
-
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; !(status == 0 || status == 1) && (n_try > 0); n_try--) {
-        status = blkid_do_safeprobe (probe);
-        if (status < 0)
-            g_usleep (100 * 1000); /* microseconds */
+    if (details) {
+        blkid_probe_set_partitions_flags (probe, BLKID_PARTS_MAGIC | BLKID_PARTS_ENTRY_DETAILS);
+        blkid_probe_enable_superblocks (probe, 1);
+        blkid_probe_set_superblocks_flags (probe, BLKID_SUBLKS_USAGE | BLKID_SUBLKS_TYPE |
+                                                  BLKID_SUBLKS_MAGIC | BLKID_SUBLKS_BADCSUM |
+                                                  BLKID_SUBLKS_UUID | BLKID_SUBLKS_LABEL |
+                                                  BLKID_SUBLKS_VERSION);
+    } else {
+        blkid_probe_set_partitions_flags (probe, BLKID_PARTS_MAGIC);
+        blkid_probe_enable_superblocks (probe, 1);
+        blkid_probe_set_superblocks_flags (probe, BLKID_SUBLKS_USAGE | BLKID_SUBLKS_TYPE |
+                                                  BLKID_SUBLKS_MAGIC | BLKID_SUBLKS_BADCSUM);
     }
+
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SAFEPROBE);
     if (status < 0) {
         /* -1 or -2 = error during probing*/
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
@@ -590,46 +937,252 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
         blkid_free_probe (probe);
         synced_close (fd);
         return NULL;
-    } else if (status == 1) {
-        /* 1 = nothing detected */
-        blkid_free_probe (probe);
-        synced_close (fd);
+    }
+
+    ret = g_new0 (BDFSProbeInfo, 1);
+    ret->size = blkid_probe_get_size (probe);
+
+    /* 1 = nothing detected */
+    if (status == 0) {
+        ret->type = probe_get_value (probe, "TYPE");
+        ret->usage = probe_get_value (probe, "USAGE");
+        ret->pt_type = probe_get_value (probe, "PTTYPE");
+        if (details) {
+            ret->uuid = probe_get_value (probe, "UUID");
+            ret->label = probe_get_value (probe, "LABEL");
+            ret->version = probe_get_value (probe, "VERSION");
+            ret->part_uuid = probe_get_value (probe, "PART_ENTRY_UUID");
+        }
+    }
+
+    blkid_free_probe (probe);
+    synced_close (fd);
+
+    return ret;
+}
+
+/**
+ * bd_fs_get_fstype:
+ * @device: the device to probe
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Get first signature on @device as a string.
+ *
+ * Returns: (transfer full): type of filesystem found on @device, %NULL in case
+ *                           no signature has been detected or in case of error
+ *                           (@error is set in this case)
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
+    BDFSProbeInfo *info = NULL;
+    gchar *fstype = NULL;
+
+    info = probe_device (device, FALSE, error);
+    if (!info)
+        return NULL;
+
+    if (!info->type && !info->usage && !info->pt_type) {
+        /* nothing detected */
+        bd_fs_probe_info_free (info);
         return NULL;
     }
 
-    status = blkid_probe_lookup_value (probe, "USAGE", &value, &len);
-    if (status != 0) {
+    if (!info->usage) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Failed to get usage for the device '%s'", device);
-        blkid_free_probe (probe);
-        synced_close (fd);
+        bd_fs_probe_info_free (info);
         return NULL;
     }
 
-    if (strncmp (value, "filesystem", 10) != 0) {
+    if (strncmp (info->usage, "filesystem", 10) != 0) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
-                     "The signature on the device '%s' is of type '%s', not 'filesystem'", device, value);
-        blkid_free_probe (probe);
-        synced_close (fd);
+                     "The signature on the device '%s' is of type '%s', not 'filesystem'", device, info->usage);
+        bd_fs_probe_info_free (info);
         return NULL;
     }
 
-    status = blkid_probe_lookup_value (probe, "TYPE", &value, &len);
-    if (status != 0) {
+    if (!info->type) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Failed to get filesystem type for the device '%s'", device);
-        blkid_free_probe (probe);
-        synced_close (fd);
+        bd_fs_probe_info_free (info);
         return NULL;
     }
 
-    fstype = g_strdup (value);
-    blkid_free_probe (probe);
-    synced_close (fd);
+    fstype = info->type;
+    info->type = NULL;
+    bd_fs_probe_info_free (info);
 
     return fstype;
 }
 
+/**
+ * bd_fs_probe_all:
+ * @device: the device to probe
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Identifies the first signature on @device with a single read pass, getting
+ * all the information the separate query functions (bd_fs_get_fstype(),
+ * bd_crypto_device_is_luks(),...) would get one by one.
+ *
+ * Returns: (transfer full): information about the signature found on @device
+ *                           (with all the fields except for @size set to %NULL
+ *                           if no signature was detected) or %NULL in case of
+ *                           error (@error is set in this case)
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+BDFSProbeInfo* bd_fs_probe_all (const gchar *device, GError **error) {
+    return probe_device (device, TRUE, error);
+}
+
+typedef struct TempMount {
+    gchar *mountpoint;
+    gboolean read_only;
+} TempMount;
+
+/* temporary mounts kept while held by the thread */
+typedef struct TempMounts {
+    guint holds;
+    /* device -> TempMount */
+    GHashTable *mounts;
+} TempMounts;
+
+static void temp_mounts_free (TempMounts *temp_mounts);
+
+/* the holds are per thread so that a hold doesn't affect (e.g. make fail
+   operations requiring a device to be unmounted) other threads */
+static GPrivate thread_temp_mounts = G_PRIVATE_INIT ((GDestroyNotify) temp_mounts_free);
+
+static void temp_mount_free (TempMount *temp) {
+    g_free (temp->mountpoint);
+    g_free (temp);
+}
+
+static gboolean temp_mount_unmount (const gchar *device, TempMount *temp, GError **error) {
+    GError *l_error = NULL;
+
+    if (!bd_fs_unmount (temp->mountpoint, FALSE, FALSE, NULL, &l_error)) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_UNMOUNT_FAIL,
+                     "Failed to unmount '%s' from the temporary mountpoint: %s",
+                     device, l_error->message);
+        g_clear_error (&l_error);
+        return FALSE;
+    }
+    g_rmdir (temp->mountpoint);
+
+    return TRUE;
+}
+
+/* unmounts all the temporary mounts of the thread, returns the first error */
+static gboolean temp_mounts_unmount_all (TempMounts *temp_mounts, GError **error) {
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+    GError *l_error = NULL;
+    gboolean ret = TRUE;
+
+    g_hash_table_iter_init (&iter, temp_mounts->mounts);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        if (!temp_mount_unmount ((const gchar *) key, (TempMount *) value, &l_error)) {
+            /* report the first error, but try to unmount all of them */
+            if (ret)
+                g_propagate_error (error, l_error);
+            else
+                g_clear_error (&l_error);
+            l_error = NULL;
+            ret = FALSE;
+        }
+    }
+    g_hash_table_remove_all (temp_mounts->mounts);
+
+    return ret;
+}
+
+/* called when a thread holding the temporary mounts exits */
+static void temp_mounts_free (TempMounts *temp_mounts) {
+    GError *l_error = NULL;
+
+    if (!temp_mounts_unmount_all (temp_mounts, &l_error)) {
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to release temporary mounts of a finished thread: %s",
+                             l_error->message);
+        g_clear_error (&l_error);
+    }
+    g_hash_table_destroy (temp_mounts->mounts);
+    g_free (temp_mounts);
+}
+
+/* returns the temporary mounts of the calling thread if it holds them */
+static TempMounts* get_held_temp_mounts (void) {
+    TempMounts *temp_mounts = g_private_get (&thread_temp_mounts);
+
+    return (temp_mounts && temp_mounts->holds > 0) ? temp_mounts : NULL;
+}
+
+/**
+ * bd_fs_hold_temp_mounts:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Makes the operations that need to (temporarily) mount a file system (e.g.
+ * bd_fs_resize(), bd_fs_get_size() or bd_fs_get_free_space() for XFS, btrfs
+ * and NILFS2) keep the temporary mounts until bd_fs_release_temp_mounts() is
+ * called. A batch of such operations on the same device then only needs to
+ * mount it once. The mounts are held only for the operations run in the calling
+ * thread, other threads are not affected (and the mounts are released when the
+ * thread exits without calling bd_fs_release_temp_mounts()).
+ *
+ * While a temporary mount is held, the file system is mounted so operations
+ * requiring it to be unmounted (e.g. bd_fs_check()) fail and it must not be
+ * unmounted by the caller. Calls of this function can be nested, the mounts
+ * are released by the last matching bd_fs_release_temp_mounts() call.
+ *
+ * Returns: whether the temporary mounts are now held or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+gboolean bd_fs_hold_temp_mounts (GError **error G_GNUC_UNUSED) {
+    TempMounts *temp_mounts = g_private_get (&thread_temp_mounts);
+
+    if (!temp_mounts) {
+        temp_mounts = g_new0 (TempMounts, 1);
+        temp_mounts->mounts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                     (GDestroyNotify) temp_mount_free);
+        g_private_set (&thread_temp_mounts, temp_mounts);
+    }
+    temp_mounts->holds++;
+
+    return TRUE;
+}
+
+/**
+ * bd_fs_release_temp_mounts:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Releases the temporary mounts held since the matching
+ * bd_fs_hold_temp_mounts() call in the calling thread, unmounting all of them
+ * if this was the last hold.
+ *
+ * Returns: whether the temporary mounts were successfully released (and
+ *          unmounted) or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+gboolean bd_fs_release_temp_mounts (GError **error) {
+    TempMounts *temp_mounts = get_held_temp_mounts ();
+
+    if (!temp_mounts) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "Temporary mounts are not being held");
+        return FALSE;
+    }
+
+    temp_mounts->holds--;
+    if (temp_mounts->holds > 0)
+        return TRUE;
+
+    return temp_mounts_unmount_all (temp_mounts, error);
+}
+
 /**
  * fs_mount:
  * @device: the device to mount for an FS operation
@@ -642,15 +1195,33 @@ gchar* bd_fs_get_fstype (const gchar *device,  GError **error) {
  * This is just a helper function for FS operations that need @device to be mounted.
  * If the device is already mounted, this will just return the existing mountpoint.
  * If the device is not mounted, we will mount it to a temporary directory and set
- * @unmount to %TRUE.
+ * @unmount to %TRUE. If temporary mounts are being held by the calling thread (see
+ * bd_fs_hold_temp_mounts()), the temporary mount is reused by the following
+ * operations and @unmount is %FALSE.
  *
  * Returns: (transfer full): mountpoint @device is mounted at (or %NULL in case of error)
  */
 static gchar* fs_mount (const gchar *device, gchar *fstype, gboolean read_only, gboolean *unmount, GError **error) {
     gchar *mountpoint = NULL;
     gboolean ret = FALSE;
+    TempMount *temp = NULL;
+    TempMounts *temp_mounts = NULL;
     GError *l_error = NULL;
 
+    temp_mounts = get_held_temp_mounts ();
+    if (temp_mounts) {
+        temp = g_hash_table_lookup (temp_mounts->mounts, device);
+        if (temp && (!temp->read_only || read_only)) {
+            *unmount = FALSE;
+            return g_strdup (temp->mountpoint);
+        } else if (temp) {
+            /* read-write mount needed now, replace the read-only one */
+            if (!temp_mount_unmount (device, temp, error))
+                return NULL;
+            g_hash_table_remove (temp_mounts->mounts, device);
+        }
+    }
+
     mountpoint = bd_fs_get_mountpoint (device, &l_error);
     if (!mountpoint) {
         if (l_error == NULL) {
@@ -667,6 +1238,12 @@ static gchar* fs_mount (const gchar *device, gchar *fstype, gboolean read_only,
                 g_rmdir (mountpoint);
                 g_free (mountpoint);
                 return NULL;
+            } else if (temp_mounts) {
+                temp = g_new0 (TempMount, 1);
+                temp->mountpoint = g_strdup (mountpoint);
+                temp->read_only = read_only;
+                g_hash_table_insert (temp_mounts->mounts, g_strdup (device), temp);
+                *unmount = FALSE;
             } else
                 *unmount = TRUE;
         } else {
@@ -1174,26 +1751,317 @@ gboolean bd_fs_repair (const gchar *device, const gchar *fstype, GError **error)
  }
 
 /**
- * bd_fs_check:
- * @device: the device the file system of which to check
- * @fstype: (nullable): the filesystem type on @device or %NULL to detect
+ * bd_fs_check:
+ * @device: the device the file system of which to check
+ * @fstype: (nullable): the filesystem type on @device or %NULL to detect
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Check filesystem on @device avoiding any modifications or repairs.
+ * This calls other fs check functions from this plugin based on detected
+ * filesystem (e.g. bd_fs_xfs_check for XFS). This function will return
+ * an error for unknown/unsupported filesystems.
+ *
+ * Note that depending on a corresponding filesystem type and configured
+ * features running this function on a mounted filesystem may result
+ * in false errors reported.
+ *
+ * Returns: whether the file system on @device passed the consistency check or not
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_CHECK
+ */
+gboolean bd_fs_check (const gchar *device, const gchar *fstype, GError **error) {
+    return device_operation (device, fstype, BD_FS_CHECK, 0, NULL, NULL, error);
+}
+
+/**
+ * bd_fs_check_result_free: (skip)
+ * @data: (nullable): %BDFSCheckResult to free
+ *
+ * Frees @data.
+ */
+void bd_fs_check_result_free (BDFSCheckResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->device);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+/**
+ * bd_fs_check_result_copy: (skip)
+ * @data: (nullable): %BDFSCheckResult to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSCheckResult* bd_fs_check_result_copy (BDFSCheckResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSCheckResult *ret = g_new0 (BDFSCheckResult, 1);
+
+    ret->device = g_strdup (data->device);
+    ret->success = data->success;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+/* deeper stacks than this are not something we expect to see */
+#define MAX_STACK_DEPTH 16
+
+static void add_physical_disks (const gchar *name, GPtrArray *disks, guint depth) {
+    gchar *path = NULL;
+    gchar *real_path = NULL;
+    gchar *parent = NULL;
+    gchar *disk = NULL;
+    GDir *dir = NULL;
+    const gchar *slave = NULL;
+    gboolean has_slaves = FALSE;
+
+    /* devices stacked on top of others (DM, MD,...) use all their slaves */
+    path = g_build_filename ("/sys/class/block", name, "slaves", NULL);
+    dir = g_dir_open (path, 0, NULL);
+    g_free (path);
+    if (dir) {
+        while (depth < MAX_STACK_DEPTH && (slave = g_dir_read_name (dir))) {
+            has_slaves = TRUE;
+            add_physical_disks (slave, disks, depth + 1);
+        }
+        g_dir_close (dir);
+    }
+    if (has_slaves)
+        return;
+
+    /* partitions share the limit with the other partitions of the disk */
+    path = g_build_filename ("/sys/class/block", name, "partition", NULL);
+    if (g_file_test (path, G_FILE_TEST_EXISTS)) {
+        g_free (path);
+        path = g_build_filename ("/sys/class/block", name, NULL);
+        real_path = realpath (path, NULL);
+        if (real_path) {
+            parent = g_path_get_dirname (real_path);
+            disk = g_path_get_basename (parent);
+            g_free (parent);
+            free (real_path);
+        }
+    }
+    g_free (path);
+    if (!disk)
+        disk = g_strdup (name);
+
+    for (guint i = 0; i < disks->len; i++)
+        if (g_strcmp0 (disks->pdata[i], disk) == 0) {
+            g_free (disk);
+            return;
+        }
+    g_ptr_array_add (disks, disk);
+}
+
+static GPtrArray* get_physical_disks (const gchar *device) {
+    GPtrArray *disks = g_ptr_array_new_with_free_func (g_free);
+    gchar *real_device = NULL;
+    gchar *name = NULL;
+    gchar *path = NULL;
+
+    real_device = realpath (device, NULL);
+    if (real_device) {
+        name = g_path_get_basename (real_device);
+        path = g_build_filename ("/sys/class/block", name, NULL);
+        if (g_file_test (path, G_FILE_TEST_EXISTS))
+            add_physical_disks (name, disks, 0);
+        g_free (path);
+        g_free (name);
+    }
+
+    /* not a block device (e.g. an image file), limited only by itself */
+    if (disks->len == 0)
+        g_ptr_array_add (disks, g_strdup (real_device ? real_device : device));
+    free (real_device);
+
+    return disks;
+}
+
+typedef struct CheckManyTask {
+    BDFSCheckResult *result;
+    GPtrArray *disks;
+    gboolean started;
+} CheckManyTask;
+
+typedef struct CheckManyData {
+    GMutex lock;
+    GCond cond;
+    CheckManyTask *tasks;
+    guint n_tasks;
+    guint n_pending;
+    /* finished tasks not reported yet */
+    GQueue finished;
+    /* disk name -> number of tasks running on it */
+    GHashTable *disk_tasks;
+    guint max_per_disk;
+    gboolean repair;
+} CheckManyData;
+
+static gboolean disks_available (CheckManyData *data, CheckManyTask *task) {
+    for (guint i = 0; i < task->disks->len; i++)
+        if (GPOINTER_TO_UINT (g_hash_table_lookup (data->disk_tasks, task->disks->pdata[i])) >= data->max_per_disk)
+            return FALSE;
+    return TRUE;
+}
+
+static void update_disk_tasks (CheckManyData *data, CheckManyTask *task, gint diff) {
+    guint count = 0;
+
+    for (guint i = 0; i < task->disks->len; i++) {
+        count = GPOINTER_TO_UINT (g_hash_table_lookup (data->disk_tasks, task->disks->pdata[i]));
+        g_hash_table_insert (data->disk_tasks, task->disks->pdata[i], GUINT_TO_POINTER (count + diff));
+    }
+}
+
+static gpointer check_many_thread (gpointer user_data) {
+    CheckManyData *data = (CheckManyData *) user_data;
+    CheckManyTask *task = NULL;
+    BDFSCheckResult *result = NULL;
+
+    g_mutex_lock (&(data->lock));
+    while (data->n_pending > 0) {
+        task = NULL;
+        for (guint i = 0; !task && i < data->n_tasks; i++)
+            if (!data->tasks[i].started && disks_available (data, &(data->tasks[i])))
+                task = &(data->tasks[i]);
+
+        if (!task) {
+            /* all the remaining tasks need a disk that is busy */
+            g_cond_wait (&(data->cond), &(data->lock));
+            continue;
+        }
+
+        task->started = TRUE;
+        data->n_pending--;
+        update_disk_tasks (data, task, 1);
+        g_mutex_unlock (&(data->lock));
+
+        result = task->result;
+        if (data->repair)
+            result->success = bd_fs_repair (result->device, NULL, &(result->error));
+        else
+            result->success = bd_fs_check (result->device, NULL, &(result->error));
+
+        g_mutex_lock (&(data->lock));
+        update_disk_tasks (data, task, -1);
+        g_queue_push_tail (&(data->finished), result);
+        g_cond_broadcast (&(data->cond));
+    }
+    g_mutex_unlock (&(data->lock));
+
+    return NULL;
+}
+
+/**
+ * bd_fs_check_many:
+ * @devices: (array zero-terminated=1): devices the file systems of which to check
+ * @repair: whether to repair the file systems instead of just checking them
+ * @max_workers: maximum number of checks to run in parallel or 0 for the default
+ *               (number of CPUs)
+ * @max_per_disk: maximum number of checks to run in parallel on a single physical
+ *                disk or 0 for the default (1)
  * @error: (out) (optional): place to store error (if any)
  *
- * Check filesystem on @device avoiding any modifications or repairs.
- * This calls other fs check functions from this plugin based on detected
- * filesystem (e.g. bd_fs_xfs_check for XFS). This function will return
- * an error for unknown/unsupported filesystems.
+ * Checks (or repairs, see @repair) the file systems on all the @devices in
+ * parallel the same way bd_fs_check() (bd_fs_repair()) does. The physical disks
+ * the @devices are on are found by following the slaves of the devices in sysfs,
+ * so for example checks of multiple partitions or LVs on the same disk are not
+ * run at the same time unless allowed by @max_per_disk.
  *
- * Note that depending on a corresponding filesystem type and configured
- * features running this function on a mounted filesystem may result
- * in false errors reported.
+ * A failure for one of the devices doesn't affect the others, it is reported in
+ * the #BDFSCheckResult.error field of the particular entry. The overall progress
+ * is reported as a single task with a progress update for every finished check,
+ * progress of the individual checks is reported (as separate tasks) only to
+ * the global progress reporting function, if set.
  *
- * Returns: whether the file system on @device passed the consistency check or not
+ * Returns: (transfer full) (array zero-terminated=1): results of the checks (one entry
+ *                                                     per device in the same order as in @devices)
+ *                                                     or %NULL in case of error
  *
  * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_CHECK
  */
-gboolean bd_fs_check (const gchar *device, const gchar *fstype, GError **error) {
-    return device_operation (device, fstype, BD_FS_CHECK, 0, NULL, NULL, error);
+BDFSCheckResult** bd_fs_check_many (const gchar **devices, gboolean repair, guint max_workers, guint max_per_disk, GError **error) {
+    BDFSCheckResult **ret = NULL;
+    BDFSCheckResult *result = NULL;
+    CheckManyData data;
+    GPtrArray *threads = NULL;
+    GThread *thread = NULL;
+    BDUtilsParallelProgress progress;
+    gchar *msg = NULL;
+
+    if (!devices) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "No devices specified");
+        return NULL;
+    }
+
+    memset (&data, 0, sizeof (data));
+    g_mutex_init (&(data.lock));
+    g_cond_init (&(data.cond));
+    g_queue_init (&(data.finished));
+    data.disk_tasks = g_hash_table_new (g_str_hash, g_str_equal);
+    data.max_per_disk = max_per_disk > 0 ? max_per_disk : 1;
+    data.repair = repair;
+    data.n_tasks = g_strv_length ((gchar **) devices);
+    data.n_pending = data.n_tasks;
+    data.tasks = g_new0 (CheckManyTask, data.n_tasks);
+
+    ret = g_new0 (BDFSCheckResult *, data.n_tasks + 1);
+    for (guint i = 0; i < data.n_tasks; i++) {
+        ret[i] = g_new0 (BDFSCheckResult, 1);
+        ret[i]->device = g_strdup (devices[i]);
+        data.tasks[i].result = ret[i];
+        data.tasks[i].disks = get_physical_disks (devices[i]);
+    }
+
+    msg = g_strdup_printf ("Started %s %u filesystems", repair ? "repairing" : "checking", data.n_tasks);
+    bd_utils_parallel_progress_start (&progress, data.n_tasks, msg);
+    g_free (msg);
+
+    /* not a thread pool, the workers pick the tasks respecting the per-disk limit */
+    max_workers = bd_utils_parallel_workers (max_workers, data.n_tasks);
+
+    threads = g_ptr_array_new ();
+    for (guint i = 0; i < max_workers; i++) {
+        thread = g_thread_try_new ("bd-fs-check", check_many_thread, &data, NULL);
+        if (!thread)
+            break;
+        g_ptr_array_add (threads, thread);
+    }
+    if (threads->len == 0)
+        /* no threads, let's just do all the work here */
+        check_many_thread (&data);
+
+    g_mutex_lock (&(data.lock));
+    while (progress.n_done < data.n_tasks) {
+        result = g_queue_pop_head (&(data.finished));
+        if (!result) {
+            g_cond_wait (&(data.cond), &(data.lock));
+            continue;
+        }
+        bd_utils_parallel_progress_item_done (&progress, result->device, result->success, result->error);
+    }
+    g_mutex_unlock (&(data.lock));
+
+    for (guint i = 0; i < threads->len; i++)
+        g_thread_join (threads->pdata[i]);
+    g_ptr_array_free (threads, TRUE);
+
+    bd_utils_parallel_progress_finish (&progress, NULL);
+
+    for (guint i = 0; i < data.n_tasks; i++)
+        g_ptr_array_free (data.tasks[i].disks, TRUE);
+    g_free (data.tasks);
+    g_hash_table_destroy (data.disk_tasks);
+    g_cond_clear (&(data.cond));
+    g_mutex_clear (&(data.lock));
+
+    return ret;
 }
 
 /**
@@ -1477,6 +2345,151 @@ guint64 bd_fs_get_free_space (const gchar *device, const gchar *fstype, GError *
     }
 }
 
+/**
+ * bd_fs_usage_free: (skip)
+ * @data: (nullable): %BDFSUsage to free
+ *
+ * Frees @data.
+ */
+void bd_fs_usage_free (BDFSUsage *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->device);
+    g_free (data->fstype);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+/**
+ * bd_fs_usage_copy: (skip)
+ * @data: (nullable): %BDFSUsage to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSUsage* bd_fs_usage_copy (BDFSUsage *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSUsage *ret = g_new0 (BDFSUsage, 1);
+
+    ret->device = g_strdup (data->device);
+    ret->fstype = g_strdup (data->fstype);
+    ret->size = data->size;
+    ret->free_space = data->free_space;
+    ret->mounted = data->mounted;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+/* file systems bd_fs_get_free_space() supports */
+static const gchar* const free_space_fstypes[] = {"ext2", "ext3", "ext4", "vfat", "ntfs", "nilfs2", "btrfs", NULL};
+
+static void get_usage_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    BDFSUsage *usage = (BDFSUsage *) data;
+    const gchar* const *fstype_p = NULL;
+
+    if (!usage->fstype) {
+        usage->fstype = bd_fs_get_fstype (usage->device, &(usage->error));
+        if (!usage->fstype) {
+            if (!usage->error)
+                g_set_error (&(usage->error), BD_FS_ERROR, BD_FS_ERROR_NOFS,
+                             "No filesystem detected on the device '%s'", usage->device);
+            else
+                g_prefix_error (&(usage->error), "Error when trying to detect filesystem on '%s': ", usage->device);
+            return;
+        }
+    }
+
+    usage->size = bd_fs_get_size (usage->device, usage->fstype, &(usage->error));
+    if (usage->error)
+        return;
+
+    for (fstype_p = free_space_fstypes; *fstype_p; fstype_p++)
+        if (g_strcmp0 (*fstype_p, usage->fstype) == 0) {
+            usage->free_space = bd_fs_get_free_space (usage->device, usage->fstype, &(usage->error));
+            break;
+        }
+}
+
+/**
+ * bd_fs_get_usage_many:
+ * @devices: (array zero-terminated=1): devices to get file system size and free space for
+ * @max_workers: maximum number of unmounted devices to query in parallel or 0 for the default
+ *               (number of CPUs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets size and free space of the file systems on all the @devices. For the
+ * file systems that are mounted, the values are taken from statvfs() on the
+ * mountpoint and thus match what tools like df report. The unmounted devices
+ * are queried in parallel by the same means bd_fs_get_size() and
+ * bd_fs_get_free_space() use. A failure for one of the devices doesn't affect
+ * the others, it is reported in the #BDFSUsage.error field of the particular
+ * entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): usage of the @devices (one entry
+ *                                                     per device in the same order as in @devices)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+BDFSUsage** bd_fs_get_usage_many (const gchar **devices, guint max_workers, GError **error) {
+    BDFSUsage **ret = NULL;
+    GHashTable *mounts = NULL;
+    FSMountEntry *entry = NULL;
+    GPtrArray *unmounted = NULL;
+    guint num_devices = 0;
+    gchar *real_device = NULL;
+    struct statvfs stat_buf;
+
+    if (!devices) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "No devices specified");
+        return NULL;
+    }
+
+    mounts = get_mount_entries (error);
+    if (!mounts)
+        return NULL;
+
+    num_devices = g_strv_length ((gchar **) devices);
+    ret = g_new0 (BDFSUsage *, num_devices + 1);
+    unmounted = g_ptr_array_new ();
+
+    for (guint i = 0; i < num_devices; i++) {
+        ret[i] = g_new0 (BDFSUsage, 1);
+        ret[i]->device = g_strdup (devices[i]);
+
+        real_device = realpath (devices[i], NULL);
+        entry = real_device ? g_hash_table_lookup (mounts, real_device) : NULL;
+        free (real_device);
+
+        if (!entry) {
+            g_ptr_array_add (unmounted, ret[i]);
+            continue;
+        }
+
+        ret[i]->mounted = TRUE;
+        ret[i]->fstype = g_strdup (entry->fstype);
+        if (statvfs (entry->mountpoint, &stat_buf) != 0) {
+            g_set_error (&(ret[i]->error), BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                         "Failed to get usage of the filesystem mounted at '%s': %s",
+                         entry->mountpoint, strerror_l (errno, _C_LOCALE));
+            continue;
+        }
+        ret[i]->size = (guint64) stat_buf.f_blocks * stat_buf.f_frsize;
+        ret[i]->free_space = (guint64) stat_buf.f_bfree * stat_buf.f_frsize;
+    }
+    g_hash_table_destroy (mounts);
+
+    bd_utils_parallel_run (get_usage_thread, unmounted->pdata, unmounted->len, max_workers, NULL);
+
+    g_ptr_array_free (unmounted, TRUE);
+
+    return ret;
+}
+
 /**
  * bd_fs_get_min_size:
  * @device: the device with file system to get minimum size for
@@ -1524,9 +2537,48 @@ guint64 bd_fs_get_min_size (const gchar *device, const gchar *fstype, GError **e
     }
 }
 
+/* returns the utility required for @op on @fsinfo ("" if none is needed, %NULL
+ * if @op is not supported) and the name of the operation (for error messages) */
+static const gchar* get_op_util (const BDFSInfo *fsinfo, BDFSOpType op, const gchar **op_name) {
+    switch (op) {
+        case BD_FS_MKFS:
+            *op_name = "Creating";
+            return fsinfo->mkfs_util;
+        case BD_FS_RESIZE:
+            *op_name = "Resizing";
+            return fsinfo->resize_util;
+        case BD_FS_REPAIR:
+            *op_name = "Repairing";
+            return fsinfo->repair_util;
+        case BD_FS_CHECK:
+            *op_name = "Checking";
+            return fsinfo->check_util;
+        case BD_FS_LABEL:
+            *op_name = "Setting the label of";
+            return fsinfo->label_util;
+        case BD_FS_UUID:
+            *op_name = "Setting UUID of";
+            return fsinfo->uuid_util;
+        case BD_FS_GET_SIZE:
+            *op_name = "Getting size of";
+            return fsinfo->info_util;
+        case BD_FS_GET_FREE_SPACE:
+            *op_name = "Getting free space on";
+            return fsinfo->info_util;
+        case BD_FS_GET_INFO:
+            *op_name = "Getting filesystem info of";
+            return fsinfo->info_util;
+        case BD_FS_GET_MIN_SIZE:
+            *op_name = "Getting minimum size of";
+            return fsinfo->minsize_util;
+        default:
+            g_assert_not_reached ();
+    }
+    return NULL;
+}
+
 static gboolean query_fs_operation (const gchar *fs_type, BDFSOpType op, gchar **required_utility, BDFSResizeFlags *mode, BDFSMkfsOptionsFlags *options, GError **error) {
     gboolean ret;
-    const BDFSInfo *fsinfo = NULL;
     const gchar* op_name = NULL;
     const gchar* exec_util = NULL;
     BDFSTech tech;
@@ -1546,52 +2598,8 @@ static gboolean query_fs_operation (const gchar *fs_type, BDFSOpType op, gchar *
                      "Filesystem '%s' is not supported.", fs_type);
         return FALSE;
     }
-    fsinfo = &fs_info[tech];
 
-    switch (op) {
-        case BD_FS_MKFS:
-            op_name = "Creating";
-            exec_util = fsinfo->mkfs_util;
-            break;
-        case BD_FS_RESIZE:
-            op_name = "Resizing";
-            exec_util = fsinfo->resize_util;
-            break;
-        case BD_FS_REPAIR:
-            op_name = "Repairing";
-            exec_util = fsinfo->repair_util;
-            break;
-        case BD_FS_CHECK:
-            op_name = "Checking";
-            exec_util = fsinfo->check_util;
-            break;
-        case BD_FS_LABEL:
-            op_name = "Setting the label of";
-            exec_util = fsinfo->label_util;
-            break;
-        case BD_FS_UUID:
-            op_name = "Setting UUID of";
-            exec_util = fsinfo->uuid_util;
-            break;
-        case BD_FS_GET_SIZE:
-            op_name = "Getting size of";
-            exec_util = fsinfo->info_util;
-            break;
-        case BD_FS_GET_FREE_SPACE:
-            op_name = "Getting free space on";
-            exec_util = fsinfo->info_util;
-            break;
-        case BD_FS_GET_INFO:
-            op_name = "Getting filesystem info of";
-            exec_util = fsinfo->info_util;
-            break;
-        case BD_FS_GET_MIN_SIZE:
-            op_name = "Getting minimum size of";
-            exec_util = fsinfo->minsize_util;
-            break;
-        default:
-            g_assert_not_reached ();
-    }
+    exec_util = get_op_util (&fs_info[tech], op, &op_name);
 
     if (exec_util == NULL) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
@@ -1810,6 +2818,182 @@ gboolean bd_fs_can_get_min_size (const gchar *type, gchar **required_utility, GE
     return query_fs_operation (type, BD_FS_GET_MIN_SIZE, required_utility, NULL, NULL, error);
 }
 
+/**
+ * bd_fs_capabilities_free: (skip)
+ * @data: (nullable): %BDFSCapabilities to free
+ *
+ * Frees @data.
+ */
+void bd_fs_capabilities_free (BDFSCapabilities *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->type);
+    g_strfreev (data->missing_utils);
+    g_free (data);
+}
+
+/**
+ * bd_fs_capabilities_copy: (skip)
+ * @data: (nullable): %BDFSCapabilities to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSCapabilities* bd_fs_capabilities_copy (BDFSCapabilities *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSCapabilities *ret = g_new0 (BDFSCapabilities, 1);
+
+    ret->type = g_strdup (data->type);
+    ret->supported = data->supported;
+    ret->available = data->available;
+    ret->mkfs_options = data->mkfs_options;
+    ret->resize_mode = data->resize_mode;
+    ret->missing_utils = g_strdupv (data->missing_utils);
+
+    return ret;
+}
+
+static const struct {
+    BDFSOpType op;
+    BDFSOperationFlags flag;
+} capability_ops[] = {
+    { BD_FS_MKFS, BD_FS_OPERATION_MKFS },
+    { BD_FS_RESIZE, BD_FS_OPERATION_RESIZE },
+    { BD_FS_CHECK, BD_FS_OPERATION_CHECK },
+    { BD_FS_REPAIR, BD_FS_OPERATION_REPAIR },
+    { BD_FS_LABEL, BD_FS_OPERATION_SET_LABEL },
+    { BD_FS_UUID, BD_FS_OPERATION_SET_UUID },
+    { BD_FS_GET_SIZE, BD_FS_OPERATION_GET_SIZE },
+    { BD_FS_GET_FREE_SPACE, BD_FS_OPERATION_GET_FREE_SPACE },
+    { BD_FS_GET_INFO, BD_FS_OPERATION_GET_INFO },
+    { BD_FS_GET_MIN_SIZE, BD_FS_OPERATION_GET_MIN_SIZE },
+};
+
+/* the capability matrix and the PATH it was computed for */
+static BDFSCapabilities **capabilities_cache = NULL;
+static gchar *capabilities_path = NULL;
+static GMutex capabilities_lock;
+
+static gboolean fstype_has_free_space (const gchar *fstype) {
+    const gchar* const *fstype_p = NULL;
+
+    for (fstype_p = free_space_fstypes; *fstype_p; fstype_p++)
+        if (g_strcmp0 (*fstype_p, fstype) == 0)
+            return TRUE;
+
+    return FALSE;
+}
+
+static BDFSCapabilities** compute_capabilities (void) {
+    BDFSCapabilities **ret = g_new0 (BDFSCapabilities *, BD_FS_LAST_FS - BD_FS_OFFSET + 1);
+    BDFSCapabilities *caps = NULL;
+    /* utility -> GINT_TO_POINTER (available), every utility is looked up only once */
+    GHashTable *utils = g_hash_table_new (g_str_hash, g_str_equal);
+    GPtrArray *missing = NULL;
+    const gchar *op_name = NULL;
+    const gchar *util = NULL;
+    gpointer avail = NULL;
+    gboolean found = FALSE;
+    guint i = 0;
+    guint j = 0;
+    gint tech = 0;
+
+    for (tech = BD_FS_OFFSET; tech < BD_FS_LAST_FS; tech++) {
+        caps = g_new0 (BDFSCapabilities, 1);
+        caps->type = g_strdup (fs_info[tech].type);
+        missing = g_ptr_array_new ();
+
+        for (i = 0; i < G_N_ELEMENTS (capability_ops); i++) {
+            util = get_op_util (&fs_info[tech], capability_ops[i].op, &op_name);
+            if (!util)
+                continue;
+            /* some filesystems can't tell us free space even if we have the tools */
+            if (capability_ops[i].op == BD_FS_GET_FREE_SPACE && !fstype_has_free_space (caps->type))
+                continue;
+
+            caps->supported |= capability_ops[i].flag;
+            if (strlen (util) == 0) {
+                caps->available |= capability_ops[i].flag;
+                continue;
+            }
+
+            if (!g_hash_table_lookup_extended (utils, util, NULL, &avail)) {
+                avail = GINT_TO_POINTER (bd_utils_check_util_version (util, NULL, "", NULL, NULL));
+                g_hash_table_insert (utils, (gpointer) util, avail);
+            }
+
+            if (GPOINTER_TO_INT (avail)) {
+                caps->available |= capability_ops[i].flag;
+                continue;
+            }
+
+            found = FALSE;
+            for (j = 0; j < missing->len && !found; j++)
+                found = g_strcmp0 (missing->pdata[j], util) == 0;
+            if (!found)
+                g_ptr_array_add (missing, g_strdup (util));
+        }
+
+        if (caps->supported & BD_FS_OPERATION_MKFS)
+            caps->mkfs_options = fs_features[tech].mkfs;
+        if (caps->supported & BD_FS_OPERATION_RESIZE)
+            caps->resize_mode = fs_features[tech].resize;
+
+        g_ptr_array_add (missing, NULL);
+        caps->missing_utils = (gchar **) g_ptr_array_free (missing, FALSE);
+        ret[tech - BD_FS_OFFSET] = caps;
+    }
+
+    g_hash_table_destroy (utils);
+    return ret;
+}
+
+/**
+ * bd_fs_get_capabilities:
+ * @refresh: whether to recompute the capabilities even if they are cached
+ * @error: (out) (optional): currently unused
+ *
+ * Gets the whole capability matrix -- which operations are supported and which
+ * can be performed with the installed utilities -- for all the filesystems
+ * supported by this plugin. This gives the same results as calling all the
+ * `bd_fs_can_` functions for all the filesystems, but every required utility
+ * is only looked up once and the results are cached. The cache is invalidated
+ * automatically when the value of the PATH environment variable changes, use
+ * @refresh to invalidate it explicitly (e.g. after installing new packages).
+ *
+ * Returns: (transfer full) (array zero-terminated=1): capabilities of the filesystems
+ *                                                     (in the same order as
+ *                                                     bd_fs_supported_filesystems() returns them)
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_QUERY
+ */
+BDFSCapabilities** bd_fs_get_capabilities (gboolean refresh, GError **error G_GNUC_UNUSED) {
+    BDFSCapabilities **ret = NULL;
+    BDFSCapabilities **caps_p = NULL;
+    const gchar *path = g_getenv ("PATH");
+    guint i = 0;
+
+    g_mutex_lock (&capabilities_lock);
+    if (refresh || !capabilities_cache || g_strcmp0 (path, capabilities_path) != 0) {
+        for (caps_p = capabilities_cache; caps_p && *caps_p; caps_p++)
+            bd_fs_capabilities_free (*caps_p);
+        g_free (capabilities_cache);
+        g_free (capabilities_path);
+
+        capabilities_cache = compute_capabilities ();
+        capabilities_path = g_strdup (path);
+    }
+
+    ret = g_new0 (BDFSCapabilities *, BD_FS_LAST_FS - BD_FS_OFFSET + 1);
+    for (i = 0; capabilities_cache[i]; i++)
+        ret[i] = bd_fs_capabilities_copy (capabilities_cache[i]);
+    g_mutex_unlock (&capabilities_lock);
+
+    return ret;
+}
+
 static gboolean fs_freeze (const char *mountpoint, gboolean freeze, GError **error) {
     gint fd = -1;
     gint status = 0;
@@ -1897,6 +3081,55 @@ extern BDExtraArg** bd_fs_xfs_mkfs_options (BDFSMkfsOptions *options, const BDEx
 extern BDExtraArg** bd_fs_btrfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
 extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra);
 
+/* value of the queue attribute @attr of @device (of the disk for partitions) or 0 */
+static guint64 get_queue_attr (const gchar *device, const gchar *attr) {
+    g_autofree gchar *real_device = NULL;
+    g_autofree gchar *name = NULL;
+    g_autofree gchar *path = NULL;
+    g_autofree gchar *sys_dir = NULL;
+    g_autofree gchar *contents = NULL;
+
+    real_device = realpath (device, NULL);
+    if (!real_device)
+        return 0;
+
+    name = g_path_get_basename (real_device);
+    path = g_build_filename ("/sys/class/block", name, NULL);
+    sys_dir = realpath (path, NULL);
+    if (!sys_dir)
+        return 0;
+    g_free (path);
+
+    /* partitions have no queue, the one of the disk applies */
+    path = g_build_filename (sys_dir, "partition", NULL);
+    if (g_file_test (path, G_FILE_TEST_EXISTS)) {
+        g_free (path);
+        path = g_build_filename (sys_dir, "..", "queue", attr, NULL);
+    } else {
+        g_free (path);
+        path = g_build_filename (sys_dir, "queue", attr, NULL);
+    }
+
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        return 0;
+
+    return g_ascii_strtoull (contents, NULL, 10);
+}
+
+/* RAID devices (and the layers on top of them) report the chunk size as the
+   minimum I/O size and the full stripe as the optimal I/O size, the stripe
+   geometry is left untouched if it cannot be derived from these */
+static void get_topology_stripe (const gchar *device, guint32 *stripe_unit, guint32 *stripe_width) {
+    guint64 min_io = get_queue_attr (device, "minimum_io_size");
+    guint64 opt_io = get_queue_attr (device, "optimal_io_size");
+
+    if (min_io == 0 || opt_io <= min_io || opt_io % min_io != 0 || opt_io > G_MAXUINT32)
+        return;
+
+    *stripe_unit = (guint32) min_io;
+    *stripe_width = (guint32) (opt_io / min_io);
+}
+
 /**
  * bd_fs_mkfs:
  * @device: the device to create the new filesystem on
@@ -1917,6 +3150,10 @@ extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDEx
  * specified using @options. Extra options are added after the @options and
  * there are no additional checks for duplicate and/or conflicting options.
  *
+ * If @options have the stripe_from_topology field set and no stripe unit
+ * specified, the stripe geometry is derived from the minimum and optimal I/O
+ * size @device reports (if they describe a stripe).
+ *
  * Returns: whether @fstype was successfully created on @device or not.
  *
  * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_MKFS
@@ -1924,8 +3161,15 @@ extern BDExtraArg** bd_fs_udf_mkfs_options (BDFSMkfsOptions *options, const BDEx
  */
 gboolean bd_fs_mkfs (const gchar *device, const gchar *fstype, BDFSMkfsOptions *options, const BDExtraArg **extra, GError **error) {
     BDExtraArg **extra_args = NULL;
+    BDFSMkfsOptions topology_options;
     gboolean ret = FALSE;
 
+    if (options && options->stripe_from_topology && options->stripe_unit == 0) {
+        topology_options = *options;
+        get_topology_stripe (device, &(topology_options.stripe_unit), &(topology_options.stripe_width));
+        options = &topology_options;
+    }
+
     if (g_strcmp0 (fstype, "exfat") == 0) {
         extra_args = bd_fs_exfat_mkfs_options (options, extra);
         ret = bd_fs_exfat_mkfs (device, (const BDExtraArg **) extra_args, error);
@@ -1969,6 +3213,122 @@ gboolean bd_fs_mkfs (const gchar *device, const gchar *fstype, BDFSMkfsOptions *
     return ret;
 }
 
+/**
+ * bd_fs_mkfs_result_free: (skip)
+ * @data: (nullable): %BDFSMkfsResult to free
+ *
+ * Frees @data.
+ */
+void bd_fs_mkfs_result_free (BDFSMkfsResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->device);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+/**
+ * bd_fs_mkfs_result_copy: (skip)
+ * @data: (nullable): %BDFSMkfsResult to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDFSMkfsResult* bd_fs_mkfs_result_copy (BDFSMkfsResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDFSMkfsResult *ret = g_new0 (BDFSMkfsResult, 1);
+
+    ret->device = g_strdup (data->device);
+    ret->success = data->success;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+typedef struct MkfsManyData {
+    const gchar *fstype;
+    BDFSMkfsOptions *options;
+    const BDExtraArg **extra;
+} MkfsManyData;
+
+static void mkfs_many_thread (gpointer data, gpointer user_data) {
+    BDFSMkfsResult *result = (BDFSMkfsResult *) data;
+    MkfsManyData *mkfs_data = (MkfsManyData *) user_data;
+
+    result->success = bd_fs_mkfs (result->device, mkfs_data->fstype, mkfs_data->options,
+                                  mkfs_data->extra, &(result->error));
+}
+
+/**
+ * bd_fs_mkfs_many:
+ * @devices: (array zero-terminated=1): devices to create the new filesystems on
+ * @fstype: name of the filesystem to create (e.g. "ext4")
+ * @options: additional options like label or stripe geometry for the filesystems
+ * @extra: (nullable) (array zero-terminated=1): extra mkfs options not provided in @options
+ * @max_workers: maximum number of filesystems to create in parallel or 0 for the default
+ *               (number of CPUs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates @fstype filesystems on all the @devices in parallel the same way
+ * bd_fs_mkfs() does. With the stripe_from_topology field of @options set, the
+ * stripe geometry is derived for every device separately. @options specifying a
+ * UUID or an external log device cannot be used for multiple devices.
+ *
+ * A failure for one of the devices doesn't affect the others, it is reported in
+ * the #BDFSMkfsResult.error field of the particular entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the mkfs runs (one entry
+ *                                                     per device in the same order as in @devices)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_FS_TECH_GENERIC-%BD_FS_TECH_MODE_MKFS
+ */
+BDFSMkfsResult** bd_fs_mkfs_many (const gchar **devices, const gchar *fstype, BDFSMkfsOptions *options, const BDExtraArg **extra, guint max_workers, GError **error) {
+    BDFSMkfsResult **ret = NULL;
+    MkfsManyData data;
+    guint num_devices = 0;
+
+    if (!devices) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "No devices specified");
+        return NULL;
+    }
+
+    if (fstype_to_tech (fstype) == BD_FS_TECH_GENERIC) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_NOT_SUPPORTED,
+                     "Filesystem '%s' is not supported.", fstype);
+        return NULL;
+    }
+
+    num_devices = g_strv_length ((gchar **) devices);
+    if (num_devices > 1 && options && options->uuid && g_strcmp0 (options->uuid, "") != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "The same UUID cannot be used for multiple filesystems");
+        return NULL;
+    }
+    if (num_devices > 1 && options && options->log_device && g_strcmp0 (options->log_device, "") != 0) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "The same log device cannot be used for multiple filesystems");
+        return NULL;
+    }
+
+    data.fstype = fstype;
+    data.options = options;
+    data.extra = extra;
+
+    ret = g_new0 (BDFSMkfsResult *, num_devices + 1);
+    for (guint i = 0; i < num_devices; i++) {
+        ret[i] = g_new0 (BDFSMkfsResult, 1);
+        ret[i]->device = g_strdup (devices[i]);
+    }
+
+    bd_utils_parallel_run (mkfs_many_thread, (gpointer *) ret, num_devices, max_workers, &data);
+
+    return ret;
+}
+
 /**
  * bd_fs_features:
  * @fstype: name of the filesystem to get features for (e.g. "ext4")
@@ -5,18 +5,62 @@
 
 gboolean bd_fs_wipe (const gchar *device, gboolean all, gboolean force, GError **error) ;
 gboolean bd_fs_clean (const gchar *device, gboolean force, GError **error);
+
+typedef enum {
+    BD_FS_CLEAN_SIGNATURES = 0,
+    BD_FS_CLEAN_EDGES,
+    BD_FS_CLEAN_ZEROOUT,
+    BD_FS_CLEAN_DISCARD,
+} BDFSCleanMode;
+
+gboolean bd_fs_clean_device (const gchar *device, BDFSCleanMode mode, gboolean force, GError **error);
+
+typedef struct BDFSCleanResult {
+    gchar *device;
+    gboolean success;
+    GError *error;
+} BDFSCleanResult;
+
+BDFSCleanResult* bd_fs_clean_result_copy (BDFSCleanResult *data);
+void bd_fs_clean_result_free (BDFSCleanResult *data);
+
+BDFSCleanResult** bd_fs_clean_many (const gchar **devices, BDFSCleanMode mode, gboolean force, guint max_workers, GError **error);
 gchar* bd_fs_get_fstype (const gchar *device,  GError **error);
 
+typedef struct BDFSProbeInfo {
+    gchar *type;
+    gchar *usage;
+    gchar *uuid;
+    gchar *label;
+    gchar *version;
+    gchar *pt_type;
+    gchar *part_uuid;
+    guint64 size;
+} BDFSProbeInfo;
+
+BDFSProbeInfo* bd_fs_probe_info_copy (BDFSProbeInfo *data);
+void bd_fs_probe_info_free (BDFSProbeInfo *data);
+
+BDFSProbeInfo* bd_fs_probe_all (const gchar *device, GError **error);
+gboolean bd_fs_set_probe_timeout (guint timeout_ms, GError **error);
+gboolean bd_fs_hold_temp_mounts (GError **error);
+gboolean bd_fs_release_temp_mounts (GError **error);
+
 gboolean bd_fs_freeze (const gchar *mountpoint, GError **error);
 gboolean bd_fs_unfreeze (const gchar *mountpoint, GError **error);
 
 typedef enum {
-    BD_FS_MKFS_LABEL     = 1 << 0,
-    BD_FS_MKFS_UUID      = 1 << 1,
-    BD_FS_MKFS_DRY_RUN   = 1 << 2,
-    BD_FS_MKFS_NODISCARD = 1 << 3,
-    BD_FS_MKFS_FORCE     = 1 << 4,
-    BD_FS_MKFS_NOPT      = 1 << 5,
+    BD_FS_MKFS_LABEL       = 1 << 0,
+    BD_FS_MKFS_UUID        = 1 << 1,
+    BD_FS_MKFS_DRY_RUN     = 1 << 2,
+    BD_FS_MKFS_NODISCARD   = 1 << 3,
+    BD_FS_MKFS_FORCE       = 1 << 4,
+    BD_FS_MKFS_NOPT        = 1 << 5,
+    BD_FS_MKFS_LAZY_INIT   = 1 << 6,
+    BD_FS_MKFS_STRIPE      = 1 << 7,
+    BD_FS_MKFS_LOG_SIZE    = 1 << 8,
+    BD_FS_MKFS_LOG_DEVICE  = 1 << 9,
+    BD_FS_MKFS_INODE_SIZE  = 1 << 10,
 } BDFSMkfsOptionsFlags;
 
 typedef struct BDFSMkfsOptions {
@@ -26,7 +70,13 @@ typedef struct BDFSMkfsOptions {
     gboolean no_discard;
     gboolean force;
     gboolean no_pt;
-    guint8 reserve[32];
+    gboolean lazy_init;
+    gboolean stripe_from_topology;
+    guint32 stripe_unit;
+    guint32 stripe_width;
+    guint32 log_size;
+    guint32 inode_size;
+    const gchar *log_device;
 } BDFSMkfsOptions;
 
 BDFSMkfsOptions* bd_fs_mkfs_options_copy (BDFSMkfsOptions *data);
@@ -36,9 +86,32 @@ const gchar** bd_fs_supported_filesystems (GError **error);
 
 gboolean bd_fs_mkfs (const gchar *device, const gchar *fstype, BDFSMkfsOptions *options, const BDExtraArg **extra, GError **error);
 
+typedef struct BDFSMkfsResult {
+    gchar *device;
+    gboolean success;
+    GError *error;
+} BDFSMkfsResult;
+
+BDFSMkfsResult* bd_fs_mkfs_result_copy (BDFSMkfsResult *data);
+void bd_fs_mkfs_result_free (BDFSMkfsResult *data);
+
+BDFSMkfsResult** bd_fs_mkfs_many (const gchar **devices, const gchar *fstype, BDFSMkfsOptions *options, const BDExtraArg **extra, guint max_workers, GError **error);
+
 gboolean bd_fs_resize (const gchar *device, guint64 new_size, const gchar *fstype, GError **error);
 gboolean bd_fs_repair (const gchar *device, const gchar *fstype, GError **error);
 gboolean bd_fs_check (const gchar *device, const gchar *fstype, GError **error);
+
+typedef struct BDFSCheckResult {
+    gchar *device;
+    gboolean success;
+    GError *error;
+} BDFSCheckResult;
+
+BDFSCheckResult* bd_fs_check_result_copy (BDFSCheckResult *data);
+void bd_fs_check_result_free (BDFSCheckResult *data);
+
+BDFSCheckResult** bd_fs_check_many (const gchar **devices, gboolean repair, guint max_workers, guint max_per_disk, GError **error);
+
 gboolean bd_fs_set_label (const gchar *device, const gchar *label, const gchar *fstype, GError **error);
 gboolean bd_fs_check_label (const gchar *fstype, const gchar *label, GError **error);
 gboolean bd_fs_set_uuid (const gchar *device, const gchar *uuid, const gchar *fstype, GError **error);
@@ -47,6 +120,20 @@ guint64 bd_fs_get_size (const gchar *device, const gchar *fstype, GError **error
 guint64 bd_fs_get_free_space (const gchar *device, const gchar *fstype, GError **error);
 guint64 bd_fs_get_min_size (const gchar *device, const gchar *fstype, GError **error);
 
+typedef struct BDFSUsage {
+    gchar *device;
+    gchar *fstype;
+    guint64 size;
+    guint64 free_space;
+    gboolean mounted;
+    GError *error;
+} BDFSUsage;
+
+BDFSUsage* bd_fs_usage_copy (BDFSUsage *data);
+void bd_fs_usage_free (BDFSUsage *data);
+
+BDFSUsage** bd_fs_get_usage_many (const gchar **devices, guint max_workers, GError **error);
+
 typedef enum {
     BD_FS_OFFLINE_SHRINK = 1 << 1,
     BD_FS_OFFLINE_GROW = 1 << 2,
@@ -95,4 +182,31 @@ gboolean bd_fs_can_get_free_space (const gchar *type, gchar **required_utility,
 gboolean bd_fs_can_get_info (const gchar *type, gchar **required_utility, GError **error);
 gboolean bd_fs_can_get_min_size (const gchar *type, gchar **required_utility, GError **error);
 
+typedef enum {
+    BD_FS_OPERATION_MKFS           = 1 << 0,
+    BD_FS_OPERATION_RESIZE         = 1 << 1,
+    BD_FS_OPERATION_CHECK          = 1 << 2,
+    BD_FS_OPERATION_REPAIR         = 1 << 3,
+    BD_FS_OPERATION_SET_LABEL      = 1 << 4,
+    BD_FS_OPERATION_SET_UUID       = 1 << 5,
+    BD_FS_OPERATION_GET_SIZE       = 1 << 6,
+    BD_FS_OPERATION_GET_FREE_SPACE = 1 << 7,
+    BD_FS_OPERATION_GET_INFO       = 1 << 8,
+    BD_FS_OPERATION_GET_MIN_SIZE   = 1 << 9,
+} BDFSOperationFlags;
+
+typedef struct BDFSCapabilities {
+    gchar *type;
+    BDFSOperationFlags supported;
+    BDFSOperationFlags available;
+    BDFSMkfsOptionsFlags mkfs_options;
+    BDFSResizeFlags resize_mode;
+    gchar **missing_utils;
+} BDFSCapabilities;
+
+BDFSCapabilities* bd_fs_capabilities_copy (BDFSCapabilities *data);
+void bd_fs_capabilities_free (BDFSCapabilities *data);
+
+BDFSCapabilities** bd_fs_get_capabilities (gboolean refresh, GError **error);
+
 #endif  /* BD_FS_GENERIC */
@@ -24,13 +24,18 @@
 
 #include <libmount/libmount.h>
 #include <sys/types.h>
-#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <sys/statfs.h>
+#include <linux/magic.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
+#include <poll.h>
 
 #include "fs.h"
 #include "mount.h"
+#include "common.h"
 
 #define MOUNT_ERR_BUF_SIZE 1024
 
@@ -440,8 +445,14 @@ static gboolean do_mount (MountArgs *args, GError **error) {
     return success;
 }
 
+/* glibc's setres[ug]id() change the credentials of all threads of the process
+   (as required by POSIX), the raw syscalls only change the calling thread */
 static gboolean set_ruid (uid_t uid, GError **error) {
-    if (setresuid (uid, -1, -1) != 0) {
+#ifdef SYS_setresuid32
+    if (syscall (SYS_setresuid32, uid, -1, -1) != 0) {
+#else
+    if (syscall (SYS_setresuid, uid, -1, -1) != 0) {
+#endif
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Error setting ruid: %m");
         return FALSE;
@@ -451,7 +462,11 @@ static gboolean set_ruid (uid_t uid, GError **error) {
 }
 
 static gboolean set_rgid (gid_t gid, GError **error) {
-    if (setresgid (gid, -1, -1) != 0) {
+#ifdef SYS_setresgid32
+    if (syscall (SYS_setresgid32, gid, -1, -1) != 0) {
+#else
+    if (syscall (SYS_setresgid, gid, -1, -1) != 0) {
+#endif
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Error setting rgid: %m");
         return FALSE;
@@ -460,30 +475,45 @@ static gboolean set_rgid (gid_t gid, GError **error) {
     return TRUE;
 }
 
+typedef struct RunAsUserData {
+    MountFunc func;
+    MountArgs *args;
+    uid_t run_as_uid;
+    gid_t run_as_gid;
+    gboolean ret;
+    GError *error;
+} RunAsUserData;
+
+static gpointer run_as_user_thread (gpointer user_data) {
+    RunAsUserData *data = (RunAsUserData *) user_data;
+
+    if (data->run_as_gid != getgid () && !set_rgid (data->run_as_gid, &(data->error)))
+        return NULL;
+
+    if (data->run_as_uid != getuid () && !set_ruid (data->run_as_uid, &(data->error)))
+        return NULL;
+
+    data->ret = data->func (data->args, &(data->error));
+
+    /* the thread ends right away, its credentials die with it */
+    return NULL;
+}
 
 /**
  * run_as_user:
  *
- * Runs given @func in a child process with real user and group ID specified by
- * @run_as_uid and @run_as_gid. The child process is ended after @func is finished.
+ * Runs given @func in a short-lived thread with real user and group ID specified
+ * by @run_as_uid and @run_as_gid. The thread is ended after @func is finished.
  * This is used to run mount and unmount functions in a similar way how the `mount`
  * command, which is a suid binary, works and is used to set the libmount context
- * to restricted.
+ * to restricted. Only the credentials of the thread are changed so there is no
+ * need to fork the (possibly big) process and the rest of the process is not
+ * affected.
  */
 static gboolean run_as_user (MountFunc func, MountArgs *args, uid_t run_as_uid, gid_t run_as_gid, GError ** error) {
-    uid_t current_uid = -1;
-    gid_t current_gid = -1;
-    pid_t pid = -1;
-    pid_t wpid = -1;
-    int pipefd[2];
-    int status = 0;
-    GIOChannel *channel = NULL;
-    GError *local_error = NULL;
-    gchar *error_msg = NULL;
-    gsize msglen = 0;
-
-    current_uid = getuid ();
-    current_gid = getgid ();
+    RunAsUserData data = ZERO_INIT;
+    GThread *thread = NULL;
+    GError *l_error = NULL;
 
     if (geteuid () != 0) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
@@ -491,123 +521,32 @@ static gboolean run_as_user (MountFunc func, MountArgs *args, uid_t run_as_uid,
         return FALSE;
     }
 
-    if (pipe(pipefd) == -1) {
+    data.func = func;
+    data.args = args;
+    data.run_as_uid = run_as_uid;
+    data.run_as_gid = run_as_gid;
+    data.ret = FALSE;
+    data.error = NULL;
+
+    thread = g_thread_try_new ("bd-fs-run-as-user", run_as_user_thread, &data, &l_error);
+    if (!thread) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                     "Error creating pipe.");
+                     "Error creating thread: %s", l_error->message);
+        g_clear_error (&l_error);
         return FALSE;
     }
+    g_thread_join (thread);
 
-    pid = fork ();
-
-    if (pid == -1) {
-        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                     "Error forking.");
+    if (!data.ret) {
+        if (data.error)
+            g_propagate_error (error, data.error);
+        else
+            g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
+                         "Unknown error while running as user %d.", run_as_uid);
         return FALSE;
-    } else if (pid == 0) {
-        close (pipefd[0]);
-
-        if (run_as_gid != current_gid) {
-            if (!set_rgid (run_as_gid, error)) {
-                if (write(pipefd[1], (*error)->message, strlen((*error)->message)) < 0)
-                    _exit (BD_FS_ERROR_PIPE);
-                else
-                    _exit ((*error)->code);
-            }
-        }
-
-        if (run_as_uid != current_uid) {
-            if (!set_ruid (run_as_uid, error)) {
-                if (write(pipefd[1], (*error)->message, strlen((*error)->message)) < 0)
-                    _exit (BD_FS_ERROR_PIPE);
-                else
-                    _exit ((*error)->code);
-            }
-        }
-
-        if (!func (args, error)) {
-            if (write(pipefd[1], (*error)->message, strlen((*error)->message)) < 0)
-                _exit (BD_FS_ERROR_PIPE);
-            else
-                _exit ((*error)->code);
-        }
-
-        _exit (EXIT_SUCCESS);
-
-    } else {
-        close (pipefd[1]);
-
-        do {
-            wpid = waitpid (pid, &status, WUNTRACED | WCONTINUED);
-            if (wpid == -1) {
-                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                             "Error while waiting for process.");
-                close (pipefd[0]);
-                return FALSE;
-            }
-
-            if (WIFEXITED (status)) {
-              if (WEXITSTATUS (status) != EXIT_SUCCESS) {
-                  if (WEXITSTATUS (status) == BD_FS_ERROR_PIPE) {
-                      g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                                   "Error while reading error.");
-                      close (pipefd[0]);
-                      return FALSE;
-                  }
-
-                  channel = g_io_channel_unix_new (pipefd[0]);
-                  if (g_io_channel_read_to_end (channel, &error_msg, &msglen, &local_error) != G_IO_STATUS_NORMAL) {
-                      if (local_error) {
-                          g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                                       "Error while reading error: %s (%d)",
-                                       local_error->message, local_error->code);
-                          g_clear_error (&local_error);
-                      } else
-                          g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                                       "Unknown error while reading error.");
-                      g_io_channel_unref (channel);
-                      close (pipefd[0]);
-                      g_free (error_msg);
-                      return FALSE;
-                  }
-
-                  if (g_io_channel_shutdown (channel, TRUE, &local_error) == G_IO_STATUS_ERROR) {
-                      g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                                   "Error shutting down GIO channel: %s (%d)",
-                                   local_error->message, local_error->code);
-                      g_clear_error (&local_error);
-                      g_io_channel_unref (channel);
-                      close (pipefd[0]);
-                      g_free (error_msg);
-                      return FALSE;
-                  }
-
-                  if (WEXITSTATUS (status) > BD_FS_ERROR_AUTH)
-                      g_set_error_literal (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                                           error_msg);
-                  else
-                      g_set_error_literal (error, BD_FS_ERROR, WEXITSTATUS (status),
-                                           error_msg);
-
-                  g_io_channel_unref (channel);
-                  close (pipefd[0]);
-                  g_free (error_msg);
-                  return FALSE;
-              } else {
-                  close (pipefd[0]);
-                  return TRUE;
-              }
-            } else if (WIFSIGNALED (status)) {
-                g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                             "Killed by signal %d.", WTERMSIG(status));
-                close (pipefd[0]);
-                return FALSE;
-            }
-
-        } while (!WIFEXITED (status) && !WIFSIGNALED (status));
-        close (pipefd[0]);
     }
 
-    return FALSE;
+    return TRUE;
 }
 
 /**
@@ -621,7 +560,8 @@ static gboolean run_as_user (MountFunc func, MountArgs *args, uid_t run_as_uid,
  *                                               value must be a valid non zero
  *                                               uid (gid), if you specify one of
  *                                               these, the function will run in
- *                                               a child process with real user
+ *                                               a thread with real user
+ *                                               and/or group ID set to these values.
  * @error: (out) (optional): place to store error (if any)
  *
  * Returns: whether @spec was successfully unmounted or not
@@ -702,7 +642,7 @@ gboolean bd_fs_unmount (const gchar *spec, gboolean lazy, gboolean force, const
  *                                               value must be a valid non zero
  *                                               uid (gid), if you specify one of
  *                                               these, the function will run in
- *                                               a child process with real user
+ *                                               a thread with real user
  *                                               and/or group ID set to these values.
  * @error: (out) (optional): place to store error (if any)
  *
@@ -771,27 +711,80 @@ gboolean bd_fs_mount (const gchar *device, const gchar *mountpoint, const gchar
     return TRUE;
 }
 
-/**
- * bd_fs_get_mountpoint:
- * @device: device to find mountpoint for
- * @error: (out) (optional): place to store error (if any)
- *
- * Get mountpoint for @device. If @device is mounted multiple times only
- * one mountpoint will be returned.
- *
- * Returns: (transfer full): mountpoint for @device, %NULL in case device is
- *                           not mounted or in case of an error (@error is set
- *                           in this case)
- *
- * Tech category: %BD_FS_TECH_MOUNT (no mode, ignored)
- */
-gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
+/* cache of the parsed mount table, /proc/self/mountinfo supports poll() to
+   notify about changes (POLLERR|POLLPRI) so we keep it open and only parse the
+   table again when the set of mounts changes */
+static GMutex mounts_lock;
+static gint mounts_fd = -1;
+static gboolean mounts_pollable = FALSE;
+static struct libmnt_table *mounts_table = NULL;
+static struct libmnt_cache *mounts_mnt_cache = NULL;
+/* canonical source path -> FSMountEntry of its first mount */
+static GHashTable *mounts_sources = NULL;
+/* set of the targets (mountpoints) */
+static GHashTable *mounts_targets = NULL;
+
+/* mounts_lock needs to be held */
+static void mounts_cache_drop (void) {
+    if (mounts_sources) {
+        g_hash_table_destroy (mounts_sources);
+        mounts_sources = NULL;
+    }
+    if (mounts_targets) {
+        g_hash_table_destroy (mounts_targets);
+        mounts_targets = NULL;
+    }
+    if (mounts_table) {
+        mnt_free_table (mounts_table);
+        mounts_table = NULL;
+    }
+    if (mounts_mnt_cache) {
+        mnt_free_cache (mounts_mnt_cache);
+        mounts_mnt_cache = NULL;
+    }
+}
+
+/* mounts_lock needs to be held, returns whether the mount table has (or may
+   have) changed since the last check */
+static gboolean mounts_changed (void) {
+    struct pollfd pfd;
+
+    if (!mounts_pollable)
+        return TRUE;
+
+    pfd.fd = mounts_fd;
+    pfd.events = POLLPRI;
+    pfd.revents = 0;
+    if (poll (&pfd, 1, 0) < 0)
+        return TRUE;
+
+    return (pfd.revents & (POLLERR | POLLPRI)) != 0;
+}
+
+/* mounts_lock needs to be held */
+static gboolean mounts_cache_update (GError **error) {
     struct libmnt_table *table = NULL;
-    struct libmnt_fs *fs = NULL;
     struct libmnt_cache *cache = NULL;
-    gint ret = 0;
-    gchar *mountpoint = NULL;
+    struct libmnt_iter *iter = NULL;
+    struct libmnt_fs *fs = NULL;
+    struct statfs stfs;
+    FSMountEntry *entry = NULL;
+    const gchar *source = NULL;
     const gchar *target = NULL;
+    gchar *real_source = NULL;
+    gboolean changed = FALSE;
+    gint ret = 0;
+
+    if (mounts_fd < 0) {
+        mounts_fd = open ("/proc/self/mountinfo", O_RDONLY|O_CLOEXEC);
+        /* not fatal, the table is just parsed every time */
+        mounts_pollable = mounts_fd >= 0 && fstatfs (mounts_fd, &stfs) == 0 && stfs.f_type == PROC_SUPER_MAGIC;
+    }
+
+    /* always check to consume a possible change notification */
+    changed = mounts_changed ();
+    if (mounts_table && !changed)
+        return TRUE;
 
     table = mnt_new_table ();
     cache = mnt_new_cache ();
@@ -801,7 +794,8 @@ gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
         g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
                      "Failed to set cache for mount info table.");
         mnt_free_table (table);
-        return NULL;
+        mnt_free_cache (cache);
+        return FALSE;
     }
 
     ret = mnt_table_parse_mtab (table, NULL);
@@ -810,84 +804,223 @@ gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
                      "Failed to parse mount info.");
         mnt_free_table (table);
         mnt_free_cache (cache);
-        return NULL;
+        return FALSE;
     }
 
-    fs = mnt_table_find_source (table, device, MNT_ITER_FORWARD);
-    if (!fs) {
-        mnt_free_table (table);
-        mnt_free_cache (cache);
-        return NULL;
+    mounts_cache_drop ();
+    mounts_table = table;
+    mounts_mnt_cache = cache;
+    mounts_sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) fs_mount_entry_free);
+    mounts_targets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    iter = mnt_new_iter (MNT_ITER_FORWARD);
+    while (mnt_table_next_fs (table, iter, &fs) == 0) {
+        target = mnt_fs_get_target (fs);
+        if (!target)
+            continue;
+        g_hash_table_add (mounts_targets, g_strdup (target));
+
+        source = mnt_fs_get_srcpath (fs);
+        if (!source || source[0] != '/')
+            continue;
+
+        real_source = realpath (source, NULL);
+        if (!real_source)
+            continue;
+        if (g_hash_table_contains (mounts_sources, real_source)) {
+            free (real_source);
+            continue;
+        }
+
+        entry = g_new0 (FSMountEntry, 1);
+        entry->mountpoint = g_strdup (target);
+        entry->fstype = g_strdup (mnt_fs_get_fstype (fs));
+        g_hash_table_insert (mounts_sources, g_strdup (real_source), entry);
+        free (real_source);
     }
+    mnt_free_iter (iter);
 
-    target = mnt_fs_get_target (fs);
-    if (!target) {
-        mnt_free_fs (fs);
-        mnt_free_table (table);
-        mnt_free_cache (cache);
+    return TRUE;
+}
+
+/* mounts_lock needs to be held and the cache up to date */
+static gchar* mounts_cache_find_source (const gchar *device) {
+    struct libmnt_fs *fs = NULL;
+    FSMountEntry *entry = NULL;
+    gchar *real_device = NULL;
+    const gchar *target = NULL;
+
+    real_device = realpath (device, NULL);
+    if (real_device) {
+        entry = g_hash_table_lookup (mounts_sources, real_device);
+        free (real_device);
+        /* all the existing paths are in the index */
+        return entry ? g_strdup (entry->mountpoint) : NULL;
+    }
+
+    /* not an existing path (e.g. a tag or a network source) */
+    fs = mnt_table_find_source (mounts_table, device, MNT_ITER_FORWARD);
+    if (fs)
+        target = mnt_fs_get_target (fs);
+
+    return g_strdup (target);
+}
+
+/**
+ * mounts_cache_clear: (skip)
+ *
+ * Drops the cached mount table.
+ */
+void mounts_cache_clear (void) {
+    g_mutex_lock (&mounts_lock);
+    mounts_cache_drop ();
+    if (mounts_fd >= 0) {
+        close (mounts_fd);
+        mounts_fd = -1;
+    }
+    g_mutex_unlock (&mounts_lock);
+}
+
+/**
+ * bd_fs_get_mountpoint:
+ * @device: device to find mountpoint for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Get mountpoint for @device. If @device is mounted multiple times only
+ * one mountpoint will be returned.
+ *
+ * Returns: (transfer full): mountpoint for @device, %NULL in case device is
+ *                           not mounted or in case of an error (@error is set
+ *                           in this case)
+ *
+ * Tech category: %BD_FS_TECH_MOUNT (no mode, ignored)
+ */
+gchar* bd_fs_get_mountpoint (const gchar *device, GError **error) {
+    gchar *mountpoint = NULL;
+
+    g_mutex_lock (&mounts_lock);
+    if (!mounts_cache_update (error)) {
+        g_mutex_unlock (&mounts_lock);
         return NULL;
     }
+    mountpoint = mounts_cache_find_source (device);
+    g_mutex_unlock (&mounts_lock);
 
-    mountpoint = g_strdup (target);
-    mnt_free_fs (fs);
-    mnt_free_table (table);
-    mnt_free_cache (cache);
     return mountpoint;
 }
 
 /**
- * bd_fs_is_mountpoint:
- * @path: path (folder) to check
+ * bd_fs_get_mountpoints:
+ * @devices: (array zero-terminated=1): devices to find mountpoints for
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether @path is a mountpoint or not
+ * The same as bd_fs_get_mountpoint() but for multiple devices at once. The
+ * mount table is read at most once.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): mountpoints for the @devices
+ * (in the same order, an empty string for devices that are not mounted) or %NULL
+ * in case of error
  *
  * Tech category: %BD_FS_TECH_MOUNT (no mode, ignored)
  */
-gboolean bd_fs_is_mountpoint (const gchar *path, GError **error) {
-    struct libmnt_table *table = NULL;
-    struct libmnt_fs *fs = NULL;
-    struct libmnt_cache *cache = NULL;
-    const gchar *target = NULL;
-    gint ret = 0;
+gchar** bd_fs_get_mountpoints (const gchar **devices, GError **error) {
+    gchar **ret = NULL;
+    guint n_devices = 0;
+    guint i = 0;
+
+    if (!devices) {
+        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_INVAL,
+                     "No devices specified");
+        return NULL;
+    }
 
-    table = mnt_new_table ();
-    cache = mnt_new_cache ();
+    g_mutex_lock (&mounts_lock);
+    if (!mounts_cache_update (error)) {
+        g_mutex_unlock (&mounts_lock);
+        return NULL;
+    }
 
-    ret = mnt_table_set_cache (table, cache);
-    if (ret != 0) {
-        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                     "Failed to set cache for mount info table.");
-        mnt_free_table (table);
-        return FALSE;
+    n_devices = g_strv_length ((gchar **) devices);
+    ret = g_new0 (gchar*, n_devices + 1);
+    for (i = 0; i < n_devices; i++) {
+        ret[i] = mounts_cache_find_source (devices[i]);
+        if (!ret[i])
+            ret[i] = g_strdup ("");
     }
+    g_mutex_unlock (&mounts_lock);
 
-    ret = mnt_table_parse_mtab (table, NULL);
-    if (ret != 0) {
-        g_set_error (error, BD_FS_ERROR, BD_FS_ERROR_FAIL,
-                     "Failed to parse mount info.");
-        mnt_free_table (table);
-        mnt_free_cache (cache);
-        return FALSE;
+    return ret;
+}
+
+void fs_mount_entry_free (FSMountEntry *entry) {
+    if (!entry)
+        return;
+
+    g_free (entry->mountpoint);
+    g_free (entry->fstype);
+    g_free (entry);
+}
+
+/**
+ * get_mount_entries: (skip)
+ *
+ * Returns the first mount of every mounted block device (from the cached
+ * mount table). The keys are the canonical device paths (see realpath()).
+ *
+ * Returns: (transfer full): canonical device path -> #FSMountEntry or %NULL in case of error
+ */
+GHashTable* get_mount_entries (GError **error) {
+    GHashTable *ret = NULL;
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+    FSMountEntry *entry = NULL;
+
+    g_mutex_lock (&mounts_lock);
+    if (!mounts_cache_update (error)) {
+        g_mutex_unlock (&mounts_lock);
+        return NULL;
     }
 
-    fs = mnt_table_find_target (table, path, MNT_ITER_BACKWARD);
-    if (!fs) {
-        mnt_free_table (table);
-        mnt_free_cache (cache);
-        return FALSE;
+    ret = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) fs_mount_entry_free);
+    g_hash_table_iter_init (&iter, mounts_sources);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        entry = g_new0 (FSMountEntry, 1);
+        entry->mountpoint = g_strdup (((FSMountEntry *) value)->mountpoint);
+        entry->fstype = g_strdup (((FSMountEntry *) value)->fstype);
+        g_hash_table_insert (ret, g_strdup ((const gchar *) key), entry);
     }
+    g_mutex_unlock (&mounts_lock);
 
-    target = mnt_fs_get_target (fs);
-    if (!target) {
-        mnt_free_fs (fs);
-        mnt_free_table (table);
-        mnt_free_cache (cache);
+    return ret;
+}
+
+/**
+ * bd_fs_is_mountpoint:
+ * @path: path (folder) to check
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether @path is a mountpoint or not
+ *
+ * Tech category: %BD_FS_TECH_MOUNT (no mode, ignored)
+ */
+gboolean bd_fs_is_mountpoint (const gchar *path, GError **error) {
+    gchar *real_path = NULL;
+    gboolean ret = FALSE;
+
+    g_mutex_lock (&mounts_lock);
+    if (!mounts_cache_update (error)) {
+        g_mutex_unlock (&mounts_lock);
         return FALSE;
     }
 
-    mnt_free_fs (fs);
-    mnt_free_table (table);
-    mnt_free_cache (cache);
-    return TRUE;
+    ret = g_hash_table_contains (mounts_targets, path);
+    if (!ret) {
+        real_path = realpath (path, NULL);
+        ret = real_path && g_hash_table_contains (mounts_targets, real_path);
+        free (real_path);
+    }
+    g_mutex_unlock (&mounts_lock);
+
+    return ret;
 }
@@ -7,6 +7,7 @@
 gboolean bd_fs_unmount (const gchar *spec, gboolean lazy, gboolean force, const BDExtraArg **extra, GError **error);
 gboolean bd_fs_mount (const gchar *device, const gchar *mountpoint, const gchar *fstype, const gchar *options, const BDExtraArg **extra, GError **error);
 gchar* bd_fs_get_mountpoint (const gchar *device, GError **error);
+gchar** bd_fs_get_mountpoints (const gchar **devices, GError **error);
 gboolean bd_fs_is_mountpoint (const gchar *path, GError **error);
 
 #endif  /* BD_FS_MOUNT */
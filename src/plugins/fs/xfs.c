@@ -21,6 +21,10 @@
 #include <check_deps.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
 
 #include "xfs.h"
 #include "fs.h"
@@ -126,6 +130,8 @@ bd_fs_xfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
     GPtrArray *options_array = g_ptr_array_new ();
     const BDExtraArg **extra_p = NULL;
     gchar *uuid_option = NULL;
+    gchar *option = NULL;
+    GString *log_option = NULL;
 
     if (options->label && g_strcmp0 (options->label, "") != 0)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-L", options->label));
@@ -142,6 +148,33 @@ bd_fs_xfs_mkfs_options (BDFSMkfsOptions *options, const BDExtraArg **extra) {
     if (options->no_discard)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-K", ""));
 
+    if (options->stripe_unit > 0) {
+        if (options->stripe_width > 0)
+            option = g_strdup_printf ("su=%"G_GUINT32_FORMAT",sw=%"G_GUINT32_FORMAT,
+                                      options->stripe_unit, options->stripe_width);
+        else
+            option = g_strdup_printf ("su=%"G_GUINT32_FORMAT",sw=1", options->stripe_unit);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-d", option));
+        g_free (option);
+    }
+
+    if (options->log_size > 0 || (options->log_device && g_strcmp0 (options->log_device, "") != 0)) {
+        log_option = g_string_new (NULL);
+        if (options->log_size > 0)
+            g_string_append_printf (log_option, "size=%"G_GUINT32_FORMAT"m", options->log_size);
+        if (options->log_device && g_strcmp0 (options->log_device, "") != 0)
+            g_string_append_printf (log_option, "%slogdev=%s", log_option->len > 0 ? "," : "",
+                                    options->log_device);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-l", log_option->str));
+        g_string_free (log_option, TRUE);
+    }
+
+    if (options->inode_size > 0) {
+        option = g_strdup_printf ("size=%"G_GUINT32_FORMAT, options->inode_size);
+        g_ptr_array_add (options_array, bd_extra_arg_new ("-i", option));
+        g_free (option);
+    }
+
     if (options->force)
         g_ptr_array_add (options_array, bd_extra_arg_new ("-f", ""));
 
@@ -320,6 +353,116 @@ gboolean bd_fs_xfs_check_uuid (const gchar *uuid, GError **error) {
     return check_uuid (uuid, error);
 }
 
+#define XFS_SB_MAGIC 0x58465342  /* 'XFSB' */
+#define XFS_SB_READ_SIZE 512
+#define XFS_LABEL_MAX 12
+
+/* the (stable) v1 geometry structure and ioctl from <xfs/xfs_fs.h> which is
+   only available with the xfsprogs development headers */
+typedef struct XfsGeometryV1 {
+    guint32 blocksize;
+    guint32 rtextsize;
+    guint32 agblocks;
+    guint32 agcount;
+    guint32 logblocks;
+    guint32 sectsize;
+    guint32 inodesize;
+    guint32 imaxpct;
+    guint64 datablocks;
+    guint64 rtblocks;
+    guint64 rtextents;
+    guint64 logstart;
+    guchar uuid[16];
+    guint32 sunit;
+    guint32 swidth;
+    gint32 version;
+    guint32 flags;
+    guint32 logsectsize;
+    guint32 rtsectsize;
+    guint32 dirblocksize;
+} XfsGeometryV1;
+
+#define XFS_IOC_FSGEOMETRY_V1 _IOR ('X', 100, XfsGeometryV1)
+
+static guint16 get_be16 (const guint8 *buf) {
+    guint16 val;
+    memcpy (&val, buf, sizeof (val));
+    return GUINT16_FROM_BE (val);
+}
+
+static guint32 get_be32 (const guint8 *buf) {
+    guint32 val;
+    memcpy (&val, buf, sizeof (val));
+    return GUINT32_FROM_BE (val);
+}
+
+static guint64 get_be64 (const guint8 *buf) {
+    guint64 val;
+    memcpy (&val, buf, sizeof (val));
+    return GUINT64_FROM_BE (val);
+}
+
+/* Reads the primary superblock of the (unmounted) file system on @device.
+   Returns %FALSE if it doesn't look like a valid XFS superblock in which case
+   the information should be taken from xfs_db. */
+static gboolean read_xfs_superblock (const gchar *device, BDFSXfsInfo *info) {
+    guint8 sb[XFS_SB_READ_SIZE];
+    const guint8 *uuid = NULL;
+    guint16 sect_size = 0;
+    gint fd = -1;
+    ssize_t num = 0;
+
+    fd = open (device, O_RDONLY|O_CLOEXEC);
+    if (fd == -1)
+        return FALSE;
+    num = pread (fd, sb, sizeof (sb), 0);
+    close (fd);
+    if (num != sizeof (sb))
+        return FALSE;
+
+    /* all the fields are big endian, offsets match struct xfs_dsb */
+    if (get_be32 (sb) != XFS_SB_MAGIC)
+        return FALSE;
+
+    info->block_size = get_be32 (sb + 4);
+    info->block_count = get_be64 (sb + 8);
+    sect_size = get_be16 (sb + 102);
+
+    if (info->block_size < 512 || info->block_size > 65536 ||
+        (info->block_size & (info->block_size - 1)) != 0 ||
+        sect_size < 512 || sect_size > info->block_size || info->block_count == 0)
+        return FALSE;
+
+    uuid = sb + 32;
+    info->uuid = g_strdup_printf ("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                                  uuid[0], uuid[1], uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7],
+                                  uuid[8], uuid[9], uuid[10], uuid[11], uuid[12], uuid[13], uuid[14], uuid[15]);
+    info->label = g_strndup ((const gchar *) (sb + 108), XFS_LABEL_MAX);
+
+    return TRUE;
+}
+
+/* Gets the data section geometry of the file system mounted on @mountpoint
+   the same way xfs_spaceman does it. */
+static gboolean get_xfs_geometry (const gchar *mountpoint, BDFSXfsInfo *info) {
+    XfsGeometryV1 geo;
+    gint fd = -1;
+    gint status = 0;
+
+    fd = open (mountpoint, O_RDONLY|O_CLOEXEC);
+    if (fd == -1)
+        return FALSE;
+    status = ioctl (fd, XFS_IOC_FSGEOMETRY_V1, &geo);
+    close (fd);
+    if (status != 0)
+        return FALSE;
+
+    info->block_size = geo.blocksize;
+    info->block_count = geo.datablocks;
+
+    return TRUE;
+}
+
 /**
  * bd_fs_xfs_get_info:
  * @device: the device containing the file system to get info for
@@ -340,11 +483,15 @@ BDFSXfsInfo* bd_fs_xfs_get_info (const gchar *device, GError **error) {
     gchar *val_start = NULL;
     g_autofree gchar* mountpoint = NULL;
 
-    if (!check_deps (&avail_deps, DEPS_XFS_ADMIN_MASK, deps, DEPS_LAST, &deps_check_lock, error))
-        return NULL;
-
     ret = g_new0 (BDFSXfsInfo, 1);
 
+    /* try to get the information without running any of the xfs tools first */
+    mountpoint = bd_fs_get_mountpoint (device, NULL);
+    if (!mountpoint && read_xfs_superblock (device, ret))
+        return ret;
+    g_clear_pointer (&(ret->uuid), g_free);
+    g_clear_pointer (&(ret->label), g_free);
+
     success = get_uuid_label (device, &(ret->uuid), &(ret->label), error);
     if (!success) {
         /* error is already populated */
@@ -352,6 +499,14 @@ BDFSXfsInfo* bd_fs_xfs_get_info (const gchar *device, GError **error) {
         return NULL;
     }
 
+    if (mountpoint && get_xfs_geometry (mountpoint, ret))
+        return ret;
+
+    if (!check_deps (&avail_deps, DEPS_XFS_ADMIN_MASK, deps, DEPS_LAST, &deps_check_lock, error)) {
+        bd_fs_xfs_info_free (ret);
+        return NULL;
+    }
+
     /* It is important to use xfs_spaceman for a mounted filesystem
        since xfs_db might return old information.  xfs_info would be
        able to do the job for us (running xfs_spaceman or xfs_db
@@ -360,7 +515,6 @@ BDFSXfsInfo* bd_fs_xfs_get_info (const gchar *device, GError **error) {
        events just for reading information.
     */
 
-    mountpoint = bd_fs_get_mountpoint (device, NULL);
     if (mountpoint) {
       args[0] = "xfs_spaceman";
       args[1] = "-c";
@@ -23,15 +23,31 @@
 #include <string.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <linux/loop.h>
 #include <errno.h>
 #include <blockdev/utils.h>
 #include "loop.h"
+#include "../utils/parallel.h"
+
+#ifndef LOOP_SET_DIRECT_IO
+#define LOOP_SET_DIRECT_IO	0x4C08
+#endif
 
 #ifndef LOOP_SET_BLOCK_SIZE
 #define LOOP_SET_BLOCK_SIZE	0x4C09
 #endif
 
+#ifndef LOOP_CONFIGURE
+#define LOOP_CONFIGURE	0x4C0A
+struct loop_config {
+    __u32 fd;
+    __u32 block_size;
+    struct loop_info64 info;
+    __u64 __reserved[8];
+};
+#endif
+
 /**
  * SECTION: loop
  * @short_description: plugin for operations with loop devices
@@ -43,6 +59,20 @@
  */
 
 static GMutex loop_control_lock;
+/* numbers of the loop devices returned by LOOP_CTL_GET_FREE to a caller that
+   hasn't bound them yet, protected by loop_control_lock */
+static GHashTable *loop_claimed = NULL;
+
+static BDLoopSetupFlags bool_to_setup_flags (gboolean read_only, gboolean part_scan) {
+    BDLoopSetupFlags flags = BD_LOOP_SETUP_FLAG_NONE;
+
+    if (read_only)
+        flags |= BD_LOOP_SETUP_FLAG_READ_ONLY;
+    if (part_scan)
+        flags |= BD_LOOP_SETUP_FLAG_PART_SCAN;
+
+    return flags;
+}
 
 /**
  * bd_loop_error_quark: (skip)
@@ -72,7 +102,9 @@ gboolean bd_loop_init (void) {
  *
  */
 void bd_loop_close (void) {
-    /* nothing to do here */
+    g_mutex_lock (&loop_control_lock);
+    g_clear_pointer (&loop_claimed, g_hash_table_destroy);
+    g_mutex_unlock (&loop_control_lock);
 }
 
 
@@ -95,6 +127,7 @@ void bd_loop_info_free (BDLoopInfo *info) {
         return;
 
     g_free (info->backing_file);
+    g_free (info->name);
     g_free (info);
 }
 
@@ -110,6 +143,7 @@ BDLoopInfo* bd_loop_info_copy (BDLoopInfo *info) {
     new_info->direct_io = info->direct_io;
     new_info->part_scan = info->part_scan;
     new_info->read_only = info->read_only;
+    new_info->name = g_strdup (info->name);
 
     return new_info;
 }
@@ -135,22 +169,18 @@ static gchar* _loop_get_backing_file (const gchar *dev_name, GError **error) {
     return g_strstrip (ret);
 }
 
-/**
- * bd_loop_info:
- * @loop: name of the loop device to get information about (e.g. "loop0")
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: (transfer full): information about the @loop device or %NULL in case of error
- *
- * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_QUERY
- */
-BDLoopInfo* bd_loop_info (const gchar *loop, GError **error) {
+/* gets information about the @loop device, also stores the loop_info64 data
+ * to @li64 (if not %NULL) */
+static BDLoopInfo* _loop_get_info (const gchar *loop, struct loop_info64 *li64, GError **error) {
     BDLoopInfo *info = NULL;
     g_autofree gchar *dev_loop = NULL;
     gint fd = -1;
-    struct loop_info64 li64;
+    struct loop_info64 l_li64;
     GError *l_error = NULL;
 
+    if (!li64)
+        li64 = &l_li64;
+
     if (!g_str_has_prefix (loop, "/dev/"))
         dev_loop = g_strdup_printf ("/dev/%s", loop);
 
@@ -161,8 +191,8 @@ BDLoopInfo* bd_loop_info (const gchar *loop, GError **error) {
         return NULL;
     }
 
-    memset (&li64, 0, sizeof (li64));
-    if (ioctl (fd, LOOP_GET_STATUS64, &li64) < 0) {
+    memset (li64, 0, sizeof (*li64));
+    if (ioctl (fd, LOOP_GET_STATUS64, li64) < 0) {
         g_set_error (error, BD_LOOP_ERROR,
                      errno == ENXIO ? BD_LOOP_ERROR_DEVICE : BD_LOOP_ERROR_FAIL,
                      "Failed to get status of the device %s: %m", loop);
@@ -173,17 +203,18 @@ BDLoopInfo* bd_loop_info (const gchar *loop, GError **error) {
     close (fd);
 
     info = g_new0 (BDLoopInfo, 1);
-    info->offset = li64.lo_offset;
-    if ((li64.lo_flags & LO_FLAGS_AUTOCLEAR) != 0)
+    info->offset = li64->lo_offset;
+    if ((li64->lo_flags & LO_FLAGS_AUTOCLEAR) != 0)
         info->autoclear = TRUE;
-    if ((li64.lo_flags & LO_FLAGS_DIRECT_IO) != 0)
+    if ((li64->lo_flags & LO_FLAGS_DIRECT_IO) != 0)
         info->direct_io = TRUE;
-    if ((li64.lo_flags & LO_FLAGS_PARTSCAN) != 0)
+    if ((li64->lo_flags & LO_FLAGS_PARTSCAN) != 0)
         info->part_scan = TRUE;
-    if ((li64.lo_flags & LO_FLAGS_READ_ONLY) != 0)
+    if ((li64->lo_flags & LO_FLAGS_READ_ONLY) != 0)
         info->read_only = TRUE;
+    info->name = g_strdup (g_str_has_prefix (loop, "/dev/") ? loop + 5 : loop);
 
-    info->backing_file = _loop_get_backing_file (loop, &l_error);
+    info->backing_file = _loop_get_backing_file (info->name, &l_error);
     if (l_error) {
         bd_loop_info_free (info);
         g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
@@ -195,11 +226,148 @@ BDLoopInfo* bd_loop_info (const gchar *loop, GError **error) {
     return info;
 }
 
+/**
+ * bd_loop_info:
+ * @loop: name of the loop device to get information about (e.g. "loop0")
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): information about the @loop device or %NULL in case of error
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_QUERY
+ */
+BDLoopInfo* bd_loop_info (const gchar *loop, GError **error) {
+    return _loop_get_info (loop, NULL, error);
+}
+
+typedef struct LoopScanEntry {
+    BDLoopInfo *info;
+    guint64 lo_device;
+    guint64 lo_inode;
+} LoopScanEntry;
+
+static void _loop_scan_entry_free (LoopScanEntry *entry) {
+    bd_loop_info_free (entry->info);
+    g_free (entry);
+}
+
+static gint _loop_cmp_names (gconstpointer a, gconstpointer b) {
+    const LoopScanEntry *entry_a = *((LoopScanEntry **) a);
+    const LoopScanEntry *entry_b = *((LoopScanEntry **) b);
+    guint64 num_a = g_ascii_strtoull (entry_a->info->name + 4, NULL, 10);
+    guint64 num_b = g_ascii_strtoull (entry_b->info->name + 4, NULL, 10);
+
+    return (num_a > num_b) - (num_a < num_b);
+}
+
+/* scans all the (set up) loop devices once, returns an array of LoopScanEntry items
+ * sorted by the loop device number */
+static GPtrArray* _loop_scan (GError **error) {
+    GDir *dir = NULL;
+    const gchar *name = NULL;
+    gchar *sys_path = NULL;
+    gboolean bound = FALSE;
+    struct loop_info64 li64;
+    LoopScanEntry *entry = NULL;
+    BDLoopInfo *info = NULL;
+    GPtrArray *ret = NULL;
+
+    dir = g_dir_open ("/sys/block", 0, error);
+    if (!dir) {
+        g_prefix_error (error, "Failed to get the list of loop devices: ");
+        return NULL;
+    }
+
+    ret = g_ptr_array_new_with_free_func ((GDestroyNotify) _loop_scan_entry_free);
+    while ((name = g_dir_read_name (dir))) {
+        if (!g_str_has_prefix (name, "loop"))
+            continue;
+
+        /* the backing_file attribute only exists for loop devices that are set up */
+        sys_path = g_strdup_printf ("/sys/block/%s/loop/backing_file", name);
+        bound = access (sys_path, R_OK) == 0;
+        g_free (sys_path);
+        if (!bound)
+            continue;
+
+        /* the device may have been torn down in the meantime, just skip it then */
+        info = _loop_get_info (name, &li64, NULL);
+        if (!info)
+            continue;
+
+        entry = g_new0 (LoopScanEntry, 1);
+        entry->info = info;
+        entry->lo_device = li64.lo_device;
+        entry->lo_inode = li64.lo_inode;
+        g_ptr_array_add (ret, entry);
+    }
+    g_dir_close (dir);
+
+    g_ptr_array_sort (ret, _loop_cmp_names);
+
+    return ret;
+}
+
+/* finds the loop device backed by @file in the result of _loop_scan(),
+ * matching either the backing file path or (if @file exists) its inode */
+static const gchar* _loop_scan_find (GPtrArray *scan, const gchar *file) {
+    LoopScanEntry *entry = NULL;
+    struct stat st;
+    gboolean have_stat = FALSE;
+    guint i = 0;
+
+    have_stat = stat (file, &st) == 0;
+    for (i = 0; i < scan->len; i++) {
+        entry = scan->pdata[i];
+        if (g_strcmp0 (entry->info->backing_file, file) == 0)
+            return entry->info->name;
+        if (have_stat && entry->lo_inode == (guint64) st.st_ino && entry->lo_device == (guint64) st.st_dev)
+            return entry->info->name;
+    }
+
+    return NULL;
+}
+
+/**
+ * bd_loop_list:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): information about all
+ * the loop devices that are set up (sorted by the loop device number) or %NULL
+ * in case of error
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_QUERY
+ */
+BDLoopInfo** bd_loop_list (GError **error) {
+    GPtrArray *scan = NULL;
+    BDLoopInfo **ret = NULL;
+    LoopScanEntry *entry = NULL;
+    guint i = 0;
+
+    scan = _loop_scan (error);
+    if (!scan)
+        return NULL;
+
+    ret = g_new0 (BDLoopInfo*, scan->len + 1);
+    for (i = 0; i < scan->len; i++) {
+        entry = scan->pdata[i];
+        /* steal the info */
+        ret[i] = entry->info;
+        entry->info = NULL;
+    }
+    g_ptr_array_free (scan, TRUE);
+
+    return ret;
+}
+
 /**
  * bd_loop_get_loop_name:
  * @file: path of the backing file to get loop name for
  * @error: (out) (optional): place to store error (if any)
  *
+ * The loop device is found either by the path of the backing file or, if
+ * the path is different (e.g. a symlink or a relative path), by the inode
+ * of the @file.
+ *
  * Returns: (transfer full): name of the loop device associated with the given
  * @file or %NULL if failed to determine
  *
@@ -213,6 +381,7 @@ gchar* bd_loop_get_loop_name (const gchar *file, GError **error G_GNUC_UNUSED) {
     gboolean found = FALSE;
     gchar **parts;
     gchar *ret;
+    GPtrArray *scan = NULL;
 
     if (glob ("/sys/block/loop*/loop/backing_file", GLOB_NOSORT, NULL, &globbuf) != 0) {
         return NULL;
@@ -230,7 +399,16 @@ gchar* bd_loop_get_loop_name (const gchar *file, GError **error G_GNUC_UNUSED) {
 
     if (!found) {
         globfree (&globbuf);
-        return NULL;
+
+        /* no exact match of the path, try matching the inode */
+        if (access (file, F_OK) != 0)
+            return NULL;
+        scan = _loop_scan (NULL);
+        if (!scan)
+            return NULL;
+        ret = g_strdup (_loop_scan_find (scan, file));
+        g_ptr_array_free (scan, TRUE);
+        return ret;
     }
 
     parts = g_strsplit (*(path_p - 1), "/", 5);
@@ -241,6 +419,42 @@ gchar* bd_loop_get_loop_name (const gchar *file, GError **error G_GNUC_UNUSED) {
     return ret;
 }
 
+/**
+ * bd_loop_get_loop_names:
+ * @files: (array zero-terminated=1): paths of the backing files to get loop names for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * The same as bd_loop_get_loop_name() but for multiple files at once. All the
+ * loop devices are scanned only once.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): names of the loop devices
+ * associated with the given @files (in the same order, an empty string for
+ * files without a loop device) or %NULL in case of error
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_QUERY
+ */
+gchar** bd_loop_get_loop_names (const gchar **files, GError **error) {
+    GPtrArray *scan = NULL;
+    const gchar *name = NULL;
+    gchar **ret = NULL;
+    guint n_files = 0;
+    guint i = 0;
+
+    scan = _loop_scan (error);
+    if (!scan)
+        return NULL;
+
+    n_files = files ? g_strv_length ((gchar **) files) : 0;
+    ret = g_new0 (gchar*, n_files + 1);
+    for (i = 0; i < n_files; i++) {
+        name = _loop_scan_find (scan, files[i]);
+        ret[i] = g_strdup (name ? name : "");
+    }
+    g_ptr_array_free (scan, TRUE);
+
+    return ret;
+}
+
 /**
  * bd_loop_setup:
  * @file: file to setup as a loop device
@@ -257,10 +471,31 @@ gchar* bd_loop_get_loop_name (const gchar *file, GError **error G_GNUC_UNUSED) {
  * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_CREATE
  */
 gboolean bd_loop_setup (const gchar *file, guint64 offset, guint64 size, gboolean read_only, gboolean part_scan, guint64 sector_size, const gchar **loop_name, GError **error) {
+    return bd_loop_setup_with_flags (file, offset, size, bool_to_setup_flags (read_only, part_scan),
+                                     sector_size, loop_name, error);
+}
+
+/**
+ * bd_loop_setup_with_flags:
+ * @file: file to setup as a loop device
+ * @offset: offset of the start of the device (in @file)
+ * @size: maximum size of the device (or 0 to leave unspecified)
+ * @flags: flags for the new loop device (combination of #BDLoopSetupFlags)
+ * @sector_size: logical sector size for the loop device in bytes (or 0 for default)
+ * @loop_name: (optional) (out): if not %NULL, it is used to store the name of the loop device
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @file was successfully setup as a loop device or not
+ *
+ * See bd_loop_setup_from_fd_with_flags() for details about the @flags.
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_CREATE
+ */
+gboolean bd_loop_setup_with_flags (const gchar *file, guint64 offset, guint64 size, BDLoopSetupFlags flags, guint64 sector_size, const gchar **loop_name, GError **error) {
     gint fd = -1;
     gboolean ret = FALSE;
 
-    /* open as RDWR so that @read_only determines whether the device is
+    /* open as RDWR so that @flags determine whether the device is
        read-only or not */
     fd = open (file, O_RDWR);
     if (fd < 0) {
@@ -269,7 +504,7 @@ gboolean bd_loop_setup (const gchar *file, guint64 offset, guint64 size, gboolea
         return FALSE;
     }
 
-    ret = bd_loop_setup_from_fd (fd, offset, size, read_only, part_scan, sector_size, loop_name, error);
+    ret = bd_loop_setup_from_fd_with_flags (fd, offset, size, flags, sector_size, loop_name, error);
     close (fd);
     return ret;
 }
@@ -290,6 +525,147 @@ gboolean bd_loop_setup (const gchar *file, guint64 offset, guint64 size, gboolea
  * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_CREATE
  */
 gboolean bd_loop_setup_from_fd (gint fd, guint64 offset, guint64 size, gboolean read_only, gboolean part_scan, guint64 sector_size, const gchar **loop_name, GError **error) {
+    return bd_loop_setup_from_fd_with_flags (fd, offset, size, bool_to_setup_flags (read_only, part_scan),
+                                             sector_size, loop_name, error);
+}
+
+#define IOCTL_TIMEOUT_MS 1000
+
+typedef struct IoctlAttempt {
+    gint loop_fd;
+    unsigned long request;
+    unsigned long arg;
+    gint status;
+    gint saved_errno;
+} IoctlAttempt;
+
+static gboolean ioctl_attempt (gpointer user_data) {
+    IoctlAttempt *attempt = (IoctlAttempt *) user_data;
+
+    attempt->status = ioctl (attempt->loop_fd, attempt->request, attempt->arg);
+    attempt->saved_errno = errno;
+    return !(attempt->status < 0 && attempt->saved_errno == EAGAIN);
+}
+
+/* runs @request on @loop_fd (opened @loop_device), retrying in case the device
+   is busy at the very moment */
+static gint loop_ioctl_retry (const gchar *loop_device, gint loop_fd, unsigned long request, unsigned long arg) {
+    IoctlAttempt attempt = {loop_fd, request, arg, -1, 0};
+
+    bd_utils_dev_retry (loop_device, IOCTL_TIMEOUT_MS, ioctl_attempt, &attempt);
+    errno = attempt.saved_errno;
+
+    return attempt.status;
+}
+
+/* configures the loop device with the LOOP_CONFIGURE ioctl (kernel >= 5.8)
+   which sets the backing file, the status and the block size in one step,
+   returns 1 if the ioctl is not supported (so the caller should fall back to
+   the old way) */
+static gint loop_configure (const gchar *loop_device, gint loop_fd, gint fd, struct loop_info64 *li64, guint64 sector_size) {
+    struct loop_config config;
+    gint status = 0;
+
+    memset (&config, 0, sizeof (config));
+    config.fd = fd;
+    config.block_size = (__u32) sector_size;
+    config.info = *li64;
+
+    status = loop_ioctl_retry (loop_device, loop_fd, LOOP_CONFIGURE, (unsigned long) &config);
+    if (status < 0 && (errno == EINVAL || errno == ENOTTY))
+        /* probably an old kernel, but it's also possible that just some of
+           the values are invalid, let the old way figure that out */
+        return 1;
+
+    return status;
+}
+
+#define SETUP_ATTEMPTS 8
+
+static gboolean loop_is_free (gint loop_number) {
+    gchar *loop_device = NULL;
+    struct loop_info64 li64;
+    gint fd = -1;
+    gboolean ret = FALSE;
+
+    loop_device = g_strdup_printf ("/dev/loop%d", loop_number);
+    fd = open (loop_device, O_RDONLY);
+    g_free (loop_device);
+    if (fd < 0)
+        return FALSE;
+
+    /* no backing file -> ENXIO */
+    ret = ioctl (fd, LOOP_GET_STATUS64, &li64) < 0 && errno == ENXIO;
+    close (fd);
+
+    return ret;
+}
+
+/* gets a free loop device and claims it so that other threads don't get the
+   same one before it is bound, the claim has to be released with
+   release_loop() once the device is bound (or failed to be bound) */
+static gint claim_free_loop (gint loop_control_fd) {
+    gint loop_number = -1;
+
+    /* XXX: serialize access to loop-control (seems to be required, but it's not
+            documented anywhere) */
+    g_mutex_lock (&loop_control_lock);
+    if (!loop_claimed)
+        loop_claimed = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    loop_number = ioctl (loop_control_fd, LOOP_CTL_GET_FREE);
+
+    /* LOOP_CTL_GET_FREE returns the first unbound device which may be already
+       claimed by another thread, find (or create) the next free one then */
+    while (loop_number >= 0 && g_hash_table_contains (loop_claimed, GINT_TO_POINTER (loop_number))) {
+        do {
+            loop_number++;
+            if (ioctl (loop_control_fd, LOOP_CTL_ADD, loop_number) < 0 && errno != EEXIST) {
+                loop_number = -1;
+                break;
+            }
+        } while (!loop_is_free (loop_number));
+    }
+
+    if (loop_number >= 0)
+        g_hash_table_add (loop_claimed, GINT_TO_POINTER (loop_number));
+    g_mutex_unlock (&loop_control_lock);
+
+    return loop_number;
+}
+
+static void release_loop (gint loop_number) {
+    g_mutex_lock (&loop_control_lock);
+    g_hash_table_remove (loop_claimed, GINT_TO_POINTER (loop_number));
+    g_mutex_unlock (&loop_control_lock);
+}
+
+/**
+ * bd_loop_setup_from_fd_with_flags:
+ * @fd: file descriptor for a file to setup as a new loop device
+ * @offset: offset of the start of the device (in file given by @fd)
+ * @size: maximum size of the device (or 0 to leave unspecified)
+ * @flags: flags for the new loop device (combination of #BDLoopSetupFlags)
+ * @sector_size: logical sector size for the loop device in bytes (or 0 for default)
+ * @loop_name: (optional) (out): if not %NULL, it is used to store the name of the loop device
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether an new loop device was successfully setup for @fd or not
+ *
+ * If supported by the kernel, the new loop device is configured atomically
+ * with a single `LOOP_CONFIGURE` ioctl so that there is no window in which the
+ * device is bound to @fd but has no flags, offset or sector size set yet (and
+ * no extra partition scan is triggered). Older kernels get the backing file,
+ * status and sector size set one after another.
+ *
+ * With %BD_LOOP_SETUP_FLAG_DIRECT_IO the loop device accesses the backing
+ * file with direct I/O bypassing the page cache. This requires the @offset
+ * and @sector_size to be aligned to the logical block size of the device
+ * backing the file, the setup fails if direct I/O cannot be enabled.
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_CREATE
+ */
+gboolean bd_loop_setup_from_fd_with_flags (gint fd, guint64 offset, guint64 size, BDLoopSetupFlags flags, guint64 sector_size, const gchar **loop_name, GError **error) {
     gint loop_control_fd = -1;
     gint loop_number = -1;
     gchar *loop_device = NULL;
@@ -297,7 +673,11 @@ gboolean bd_loop_setup_from_fd (gint fd, guint64 offset, guint64 size, gboolean
     struct loop_info64 li64;
     guint64 progress_id = 0;
     gint status = 0;
-    guint n_try = 0;
+    gint saved_errno = 0;
+    gboolean configured = FALSE;
+    guint attempt = 0;
+    gboolean read_only = (flags & BD_LOOP_SETUP_FLAG_READ_ONLY) != 0;
+    gboolean direct_io = (flags & BD_LOOP_SETUP_FLAG_DIRECT_IO) != 0;
     GError *l_error = NULL;
 
     progress_id = bd_utils_report_started ("Started setting up loop device");
@@ -311,86 +691,131 @@ gboolean bd_loop_setup_from_fd (gint fd, guint64 offset, guint64 size, gboolean
         return FALSE;
     }
 
-    /* XXX: serialize access to loop-control (seems to be required, but it's not
-            documented anywhere) */
-    g_mutex_lock (&loop_control_lock);
-    loop_number = ioctl (loop_control_fd, LOOP_CTL_GET_FREE);
-    g_mutex_unlock (&loop_control_lock);
-    close (loop_control_fd);
-    if (loop_number < 0) {
-        g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
-                     "Failed to open the loop-control device: %m");
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
-
-    bd_utils_report_progress (progress_id, 33, "Got free loop device");
-
-    loop_device = g_strdup_printf ("/dev/loop%d", loop_number);
-    loop_fd = open (loop_device, read_only ? O_RDONLY : O_RDWR);
-    if (loop_fd == -1) {
-        g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
-                     "Failed to open the %s device: %m", loop_device);
-        g_free (loop_device);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
-
     memset (&li64, '\0', sizeof (li64));
     if (read_only)
         li64.lo_flags |= LO_FLAGS_READ_ONLY;
-    if (part_scan)
+    if (flags & BD_LOOP_SETUP_FLAG_PART_SCAN)
         li64.lo_flags |= LO_FLAGS_PARTSCAN;
+    if (direct_io)
+        li64.lo_flags |= LO_FLAGS_DIRECT_IO;
     if (offset > 0)
         li64.lo_offset = offset;
     if (size > 0)
         li64.lo_sizelimit = size;
-    if (ioctl (loop_fd, LOOP_SET_FD, fd) < 0) {
-        g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
-                     "Failed to associate the %s device with the file descriptor: %m", loop_device);
+
+    for (attempt = 0; attempt < SETUP_ATTEMPTS; attempt++) {
+        loop_number = claim_free_loop (loop_control_fd);
+        if (loop_number < 0) {
+            g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                         "Failed to get a free loop device: %m");
+            close (loop_control_fd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+
+        if (attempt == 0)
+            bd_utils_report_progress (progress_id, 33, "Got free loop device");
+
         g_free (loop_device);
-        close (loop_fd);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
+        loop_device = g_strdup_printf ("/dev/loop%d", loop_number);
+        loop_fd = open (loop_device, read_only ? O_RDONLY : O_RDWR);
+        if (loop_fd == -1) {
+            g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                         "Failed to open the %s device: %m", loop_device);
+            release_loop (loop_number);
+            g_free (loop_device);
+            close (loop_control_fd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
 
-    bd_utils_report_progress (progress_id, 66, "Associated the loop device");
+        status = loop_configure (loop_device, loop_fd, fd, &li64, sector_size);
+        configured = status != 1;
+        if (!configured)
+            /* LOOP_CONFIGURE not supported, do it step by step */
+            status = ioctl (loop_fd, LOOP_SET_FD, fd);
+        saved_errno = errno;
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=10, status=-1; (status != 0) && (n_try > 0); n_try--) {
-        status = ioctl (loop_fd, LOOP_SET_STATUS64, &li64);
-        if (status < 0 && errno == EAGAIN)
-            g_usleep (100 * 1000); /* microseconds */
-        else
+        /* bound (or failed), LOOP_CTL_GET_FREE takes care of it from now on */
+        release_loop (loop_number);
+        if (status >= 0 || saved_errno != EBUSY)
             break;
+
+        /* somebody else (another process) took the device in the meantime */
+        close (loop_fd);
+        loop_fd = -1;
     }
+    close (loop_control_fd);
 
-    if (status != 0) {
-        g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
-                     "Failed to set status for the %s device: %m", loop_device);
+    if (status < 0) {
+        errno = saved_errno;
+        if (configured)
+            g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
+                         "Failed to configure the %s device: %m", loop_device);
+        else
+            g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_DEVICE,
+                         "Failed to associate the %s device with the file descriptor: %m", loop_device);
         g_free (loop_device);
-        close (loop_fd);
+        if (loop_fd >= 0)
+            close (loop_fd);
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    if (sector_size > 0) {
-        for (n_try=10, status=-1; (status != 0) && (n_try > 0); n_try--) {
-            status = ioctl (loop_fd, LOOP_SET_BLOCK_SIZE, (unsigned long) sector_size);
-            if (status < 0 && errno == EAGAIN)
-                g_usleep (100 * 1000); /* microseconds */
-            else
-                break;
-        }
+    if (!configured) {
+        bd_utils_report_progress (progress_id, 66, "Associated the loop device");
 
+        /* LO_FLAGS_DIRECT_IO is ignored by LOOP_SET_STATUS64, set below */
+        status = loop_ioctl_retry (loop_device, loop_fd, LOOP_SET_STATUS64, (unsigned long) &li64);
         if (status != 0) {
             g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
-                         "Failed to set sector size for the %s device: %m", loop_device);
+                         "Failed to set status for the %s device: %m", loop_device);
+            ioctl (loop_fd, LOOP_CLR_FD);
+            g_free (loop_device);
+            close (loop_fd);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return FALSE;
+        }
+
+        if (sector_size > 0) {
+            status = loop_ioctl_retry (loop_device, loop_fd, LOOP_SET_BLOCK_SIZE, (unsigned long) sector_size);
+            if (status != 0) {
+                g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                             "Failed to set sector size for the %s device: %m", loop_device);
+                ioctl (loop_fd, LOOP_CLR_FD);
+                g_free (loop_device);
+                close (loop_fd);
+                bd_utils_report_finished (progress_id, l_error->message);
+                g_propagate_error (error, l_error);
+                return FALSE;
+            }
+        }
+
+        if (direct_io) {
+            status = loop_ioctl_retry (loop_device, loop_fd, LOOP_SET_DIRECT_IO, 1);
+            if (status != 0) {
+                g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                             "Failed to enable direct I/O for the %s device: %m", loop_device);
+                ioctl (loop_fd, LOOP_CLR_FD);
+                g_free (loop_device);
+                close (loop_fd);
+                bd_utils_report_finished (progress_id, l_error->message);
+                g_propagate_error (error, l_error);
+                return FALSE;
+            }
+        }
+    } else if (direct_io) {
+        /* LOOP_CONFIGURE silently falls back to buffered I/O if direct I/O
+           cannot be used (e.g. because of misaligned offset) */
+        memset (&li64, '\0', sizeof (li64));
+        if (ioctl (loop_fd, LOOP_GET_STATUS64, &li64) < 0 || !(li64.lo_flags & LO_FLAGS_DIRECT_IO)) {
+            g_set_error (&l_error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                         "Failed to enable direct I/O for the %s device", loop_device);
+            ioctl (loop_fd, LOOP_CLR_FD);
             g_free (loop_device);
             close (loop_fd);
             bd_utils_report_finished (progress_id, l_error->message);
@@ -453,6 +878,238 @@ gboolean bd_loop_teardown (const gchar *loop, GError **error) {
     return TRUE;
 }
 
+void bd_loop_setup_result_free (BDLoopSetupResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->file);
+    g_free (data->name);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+BDLoopSetupResult* bd_loop_setup_result_copy (BDLoopSetupResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDLoopSetupResult *ret = g_new0 (BDLoopSetupResult, 1);
+
+    ret->file = g_strdup (data->file);
+    ret->name = g_strdup (data->name);
+    ret->success = data->success;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+void bd_loop_teardown_result_free (BDLoopTeardownResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->loop);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+BDLoopTeardownResult* bd_loop_teardown_result_copy (BDLoopTeardownResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDLoopTeardownResult *ret = g_new0 (BDLoopTeardownResult, 1);
+
+    ret->loop = g_strdup (data->loop);
+    ret->success = data->success;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+#define UDEV_TIMEOUT_MS (30 * 1000)
+
+typedef struct LoopManyData {
+    BDLoopSetupFlags flags;
+    guint64 sector_size;
+    GMutex lock;
+    GCond cond;
+    /* device nodes udev has processed a "change" event for */
+    GHashTable *changed;
+    BDUtilsParallelProgress progress;
+} LoopManyData;
+
+static void setup_many_thread (gpointer data, gpointer user_data) {
+    BDLoopSetupResult *result = (BDLoopSetupResult *) data;
+    LoopManyData *setup_data = (LoopManyData *) user_data;
+    const gchar *name = NULL;
+
+    result->success = bd_loop_setup_with_flags (result->file, 0, 0, setup_data->flags, setup_data->sector_size,
+                                                &name, &(result->error));
+    result->name = (gchar *) name;
+
+    bd_utils_parallel_progress_item_done (&(setup_data->progress), result->file, result->success, result->error);
+}
+
+/* binding the backing file to a loop device (and the partition scan) makes
+   the kernel send a "change" uevent for the device */
+static void setup_many_event (const gchar *action, const gchar *device, guint64 devnum G_GNUC_UNUSED,
+                              const gchar *dm_name G_GNUC_UNUSED, gpointer user_data) {
+    LoopManyData *setup_data = (LoopManyData *) user_data;
+
+    if (g_strcmp0 (action, "change") != 0 || !g_str_has_prefix (device, "/dev/loop"))
+        return;
+
+    g_mutex_lock (&(setup_data->lock));
+    g_hash_table_add (setup_data->changed, g_strdup (device));
+    g_cond_broadcast (&(setup_data->cond));
+    g_mutex_unlock (&(setup_data->lock));
+}
+
+/**
+ * bd_loop_setup_many:
+ * @files: (array zero-terminated=1): files to setup as loop devices
+ * @flags: flags for the new loop devices (combination of #BDLoopSetupFlags)
+ * @sector_size: logical sector size for the loop devices in bytes (or 0 for default)
+ * @max_workers: maximum number of loop devices to setup in parallel or 0 for the
+ *               default (number of CPUs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Sets up all the @files as loop devices in parallel the same way
+ * bd_loop_setup_with_flags() does (concurrent setups never get the same free
+ * loop device). Once all the devices are set up, this waits (at most 30 seconds
+ * in total) for udev to process the events for all of them so that their
+ * device nodes, symlinks and partitions are ready. A failure for one of the
+ * files doesn't affect the others, it is reported in the
+ * #BDLoopSetupResult.error field of the particular entry. The overall progress
+ * is reported as a single task with a progress update for every loop device.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the setup (one entry
+ *                                                     per file in the same order as in @files)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_CREATE
+ */
+BDLoopSetupResult** bd_loop_setup_many (const gchar **files, BDLoopSetupFlags flags, guint64 sector_size, guint max_workers, GError **error) {
+    BDLoopSetupResult **ret = NULL;
+    LoopManyData data;
+    guint n_files = 0;
+    guint events_id = 0;
+    gint64 deadline = 0;
+    gchar *loop_device = NULL;
+    gchar *msg = NULL;
+    gboolean timed_out = FALSE;
+
+    if (!files) {
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                     "No files specified");
+        return NULL;
+    }
+
+    memset (&data, 0, sizeof (data));
+    g_mutex_init (&(data.lock));
+    g_cond_init (&(data.cond));
+    data.changed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    data.flags = flags;
+    data.sector_size = sector_size;
+    n_files = g_strv_length ((gchar **) files);
+
+    ret = g_new0 (BDLoopSetupResult *, n_files + 1);
+    for (guint i = 0; i < n_files; i++) {
+        ret[i] = g_new0 (BDLoopSetupResult, 1);
+        ret[i]->file = g_strdup (files[i]);
+    }
+
+    msg = g_strdup_printf ("Started setting up %u loop devices", n_files);
+    bd_utils_parallel_progress_start (&(data.progress), n_files, msg);
+    g_free (msg);
+
+    /* subscribe before the setup so that no event is missed, without udev
+       there's nothing to wait for (the device nodes exist once set up) */
+    events_id = bd_utils_dev_events_subscribe (setup_many_event, &data, NULL);
+
+    bd_utils_parallel_run (setup_many_thread, (gpointer *) ret, n_files, max_workers, &data);
+
+    if (events_id != 0) {
+        bd_utils_report_progress (data.progress.progress_id, 100, "Waiting for udev to process the loop devices");
+        deadline = g_get_monotonic_time () + UDEV_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND;
+        g_mutex_lock (&(data.lock));
+        for (guint i = 0; i < n_files && !timed_out; i++) {
+            if (!ret[i]->success)
+                continue;
+            loop_device = g_strdup_printf ("/dev/%s", ret[i]->name);
+            while (!g_hash_table_contains (data.changed, loop_device) && !timed_out)
+                timed_out = !g_cond_wait_until (&(data.cond), &(data.lock), deadline);
+            g_free (loop_device);
+        }
+        g_mutex_unlock (&(data.lock));
+        bd_utils_dev_events_unsubscribe (events_id);
+    }
+
+    g_hash_table_destroy (data.changed);
+    g_cond_clear (&(data.cond));
+    g_mutex_clear (&(data.lock));
+    bd_utils_parallel_progress_finish (&(data.progress),
+                                       timed_out ? "Completed, timed out waiting for udev" : NULL);
+
+    return ret;
+}
+
+static void teardown_many_thread (gpointer data, gpointer user_data) {
+    BDLoopTeardownResult *result = (BDLoopTeardownResult *) data;
+    LoopManyData *teardown_data = (LoopManyData *) user_data;
+
+    result->success = bd_loop_teardown (result->loop, &(result->error));
+
+    bd_utils_parallel_progress_item_done (&(teardown_data->progress), result->loop, result->success, result->error);
+}
+
+/**
+ * bd_loop_teardown_many:
+ * @loops: (array zero-terminated=1): paths or names of the loop devices to tear down
+ * @max_workers: maximum number of loop devices to tear down in parallel or 0 for
+ *               the default (number of CPUs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Tears down all the @loops in parallel the same way bd_loop_teardown() does.
+ * A failure for one of the devices doesn't affect the others, it is reported in
+ * the #BDLoopTeardownResult.error field of the particular entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the teardown (one entry
+ *                                                     per device in the same order as in @loops)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_LOOP_TECH_LOOP-%BD_LOOP_TECH_MODE_DESTROY
+ */
+BDLoopTeardownResult** bd_loop_teardown_many (const gchar **loops, guint max_workers, GError **error) {
+    BDLoopTeardownResult **ret = NULL;
+    LoopManyData data;
+    guint n_loops = 0;
+    gchar *msg = NULL;
+
+    if (!loops) {
+        g_set_error (error, BD_LOOP_ERROR, BD_LOOP_ERROR_FAIL,
+                     "No loop devices specified");
+        return NULL;
+    }
+
+    memset (&data, 0, sizeof (data));
+    n_loops = g_strv_length ((gchar **) loops);
+
+    ret = g_new0 (BDLoopTeardownResult *, n_loops + 1);
+    for (guint i = 0; i < n_loops; i++) {
+        ret[i] = g_new0 (BDLoopTeardownResult, 1);
+        ret[i]->loop = g_strdup (loops[i]);
+    }
+
+    msg = g_strdup_printf ("Started tearing down %u loop devices", n_loops);
+    bd_utils_parallel_progress_start (&(data.progress), n_loops, msg);
+    g_free (msg);
+
+    bd_utils_parallel_run (teardown_many_thread, (gpointer *) ret, n_loops, max_workers, &data);
+
+    bd_utils_parallel_progress_finish (&(data.progress), NULL);
+
+    return ret;
+}
+
 /**
  * bd_loop_set_autoclear:
  * @loop: path or name of the loop device
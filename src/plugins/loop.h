@@ -22,6 +22,13 @@ typedef enum {
     BD_LOOP_TECH_MODE_QUERY   = 1 << 3,
 } BDLoopTechMode;
 
+typedef enum {
+    BD_LOOP_SETUP_FLAG_NONE      = 0,
+    BD_LOOP_SETUP_FLAG_READ_ONLY = 1 << 0,
+    BD_LOOP_SETUP_FLAG_PART_SCAN = 1 << 1,
+    BD_LOOP_SETUP_FLAG_DIRECT_IO = 1 << 2,
+} BDLoopSetupFlags;
+
 /**
  * BDLoopInfo:
  * @backing_file: backing file for the give loop device;
@@ -30,6 +37,7 @@ typedef enum {
  * @direct_io: whether direct IO is enabled or not;
  * @part_scan: whether the partition scan is enforced or not;
  * @read_only: whether the device is read-only or not;
+ * @name: name of the loop device (e.g. "loop0");
  */
 typedef struct BDLoopInfo {
     gchar *backing_file;
@@ -38,12 +46,32 @@ typedef struct BDLoopInfo {
     gboolean direct_io;
     gboolean part_scan;
     gboolean read_only;
+    gchar *name;
 } BDLoopInfo;
 
 
 void bd_loop_info_free (BDLoopInfo *info);
 BDLoopInfo* bd_loop_info_copy (BDLoopInfo *info);
 
+typedef struct BDLoopSetupResult {
+    gchar *file;
+    gchar *name;
+    gboolean success;
+    GError *error;
+} BDLoopSetupResult;
+
+void bd_loop_setup_result_free (BDLoopSetupResult *data);
+BDLoopSetupResult* bd_loop_setup_result_copy (BDLoopSetupResult *data);
+
+typedef struct BDLoopTeardownResult {
+    gchar *loop;
+    gboolean success;
+    GError *error;
+} BDLoopTeardownResult;
+
+void bd_loop_teardown_result_free (BDLoopTeardownResult *data);
+BDLoopTeardownResult* bd_loop_teardown_result_copy (BDLoopTeardownResult *data);
+
 
 /*
  * If using the plugin as a standalone library, the following functions should
@@ -61,9 +89,15 @@ gboolean bd_loop_is_tech_avail (BDLoopTech tech, guint64 mode, GError **error);
 BDLoopInfo* bd_loop_info (const gchar *loop, GError **error);
 
 gchar* bd_loop_get_loop_name (const gchar *file, GError **error);
+gchar** bd_loop_get_loop_names (const gchar **files, GError **error);
+BDLoopInfo** bd_loop_list (GError **error);
 gboolean bd_loop_setup (const gchar *file, guint64 offset, guint64 size, gboolean read_only, gboolean part_scan, guint64 sector_size, const gchar **loop_name, GError **error);
 gboolean bd_loop_setup_from_fd (gint fd, guint64 offset, guint64 size, gboolean read_only, gboolean part_scan, guint64 sector_size, const gchar **loop_name, GError **error);
+gboolean bd_loop_setup_with_flags (const gchar *file, guint64 offset, guint64 size, BDLoopSetupFlags flags, guint64 sector_size, const gchar **loop_name, GError **error);
+gboolean bd_loop_setup_from_fd_with_flags (gint fd, guint64 offset, guint64 size, BDLoopSetupFlags flags, guint64 sector_size, const gchar **loop_name, GError **error);
 gboolean bd_loop_teardown (const gchar *loop, GError **error);
+BDLoopSetupResult** bd_loop_setup_many (const gchar **files, BDLoopSetupFlags flags, guint64 sector_size, guint max_workers, GError **error);
+BDLoopTeardownResult** bd_loop_teardown_many (const gchar **loops, guint max_workers, GError **error);
 
 gboolean bd_loop_set_autoclear (const gchar *loop, gboolean autoclear, GError **error);
 
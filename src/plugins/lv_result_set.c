@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "lv_result_set.h"
+
+/* All the records, arrays and strings of a result set live in one block of
+ * memory. The block is filled in two passes over the source data -- the first
+ * one (with no block) only measures the space needed. Records and pointer
+ * arrays go first (they need to be aligned), strings follow them. */
+
+#define ARENA_ALIGN(size) (((size) + 7) & ~((gsize) 7))
+
+typedef struct Arena {
+    gchar *data;
+    gchar *strings;
+    gsize data_size;
+    gsize strings_size;
+} Arena;
+
+static gpointer arena_alloc (Arena *arena, gsize size) {
+    gpointer ret = arena->data ? arena->data + arena->data_size : NULL;
+
+    arena->data_size += ARENA_ALIGN (size);
+    return ret;
+}
+
+static gchar* arena_strdup (Arena *arena, const gchar *str) {
+    gchar *ret = NULL;
+    gsize len = 0;
+
+    if (!str)
+        return NULL;
+
+    len = strlen (str) + 1;
+    if (arena->strings) {
+        ret = arena->strings + arena->strings_size;
+        memcpy (ret, str, len);
+    }
+    arena->strings_size += len;
+
+    return ret;
+}
+
+static gchar** arena_strdupv (Arena *arena, gchar **strv) {
+    gchar **ret = NULL;
+    guint len = 0;
+
+    if (!strv)
+        return NULL;
+
+    len = g_strv_length (strv);
+    ret = arena_alloc (arena, (len + 1) * sizeof (gchar *));
+    for (guint i = 0; i < len; i++) {
+        gchar *str = arena_strdup (arena, strv[i]);
+        if (ret)
+            ret[i] = str;
+    }
+    if (ret)
+        ret[len] = NULL;
+
+    return ret;
+}
+
+static BDLVMSEGdata** arena_copy_segs (Arena *arena, BDLVMSEGdata **segs) {
+    BDLVMSEGdata **ret = NULL;
+    BDLVMSEGdata *seg = NULL;
+    guint len = 0;
+
+    if (!segs)
+        return NULL;
+
+    for (len = 0; segs[len]; len++);
+    ret = arena_alloc (arena, (len + 1) * sizeof (BDLVMSEGdata *));
+    for (guint i = 0; i < len; i++) {
+        seg = arena_alloc (arena, sizeof (BDLVMSEGdata));
+        gchar *pvdev = arena_strdup (arena, segs[i]->pvdev);
+        if (seg) {
+            seg->size_pe = segs[i]->size_pe;
+            seg->pv_start_pe = segs[i]->pv_start_pe;
+            seg->pvdev = pvdev;
+            ret[i] = seg;
+        }
+    }
+    if (ret)
+        ret[len] = NULL;
+
+    return ret;
+}
+
+static void arena_copy_lv (Arena *arena, BDLVMLVdata *dest, BDLVMLVdata *src) {
+    BDLVMLVdata copy = *src;
+
+    copy.lv_name = arena_strdup (arena, src->lv_name);
+    copy.vg_name = arena_strdup (arena, src->vg_name);
+    copy.uuid = arena_strdup (arena, src->uuid);
+    copy.attr = arena_strdup (arena, src->attr);
+    copy.segtype = arena_strdup (arena, src->segtype);
+    copy.origin = arena_strdup (arena, src->origin);
+    copy.pool_lv = arena_strdup (arena, src->pool_lv);
+    copy.data_lv = arena_strdup (arena, src->data_lv);
+    copy.metadata_lv = arena_strdup (arena, src->metadata_lv);
+    copy.roles = arena_strdup (arena, src->roles);
+    copy.move_pv = arena_strdup (arena, src->move_pv);
+    copy.lv_tags = arena_strdupv (arena, src->lv_tags);
+    copy.data_lvs = arena_strdupv (arena, src->data_lvs);
+    copy.metadata_lvs = arena_strdupv (arena, src->metadata_lvs);
+    copy.segs = arena_copy_segs (arena, src->segs);
+
+    if (dest)
+        *dest = copy;
+}
+
+/* packs all the LVs and everything they reference into one block of memory */
+static BDLVMLVdata** arena_copy_lvs (Arena *arena, BDLVMLVdata **lvs, guint n_lvs) {
+    BDLVMLVdata **ret = NULL;
+    BDLVMLVdata *records = NULL;
+
+    ret = arena_alloc (arena, (n_lvs + 1) * sizeof (BDLVMLVdata *));
+    records = arena_alloc (arena, n_lvs * sizeof (BDLVMLVdata));
+    for (guint i = 0; i < n_lvs; i++) {
+        arena_copy_lv (arena, records ? &(records[i]) : NULL, lvs[i]);
+        if (ret)
+            ret[i] = &(records[i]);
+    }
+    if (ret)
+        ret[n_lvs] = NULL;
+
+    return ret;
+}
+
+/* creates a new result set with the data from @lvs (which are freed) */
+BDLVMLVResultSet* lv_result_set_new (BDLVMLVdata **lvs) {
+    BDLVMLVResultSet *ret = g_new0 (BDLVMLVResultSet, 1);
+    Arena arena = {NULL, NULL, 0, 0};
+    guint n_lvs = 0;
+
+    for (n_lvs = 0; lvs[n_lvs]; n_lvs++);
+
+    /* measure */
+    arena_copy_lvs (&arena, lvs, n_lvs);
+
+    arena.data = g_malloc (arena.data_size + arena.strings_size);
+    arena.strings = arena.data + arena.data_size;
+    arena.data_size = 0;
+    arena.strings_size = 0;
+
+    /* the block starts with the array of the LVs so it's freed together with it */
+    ret->lvs = arena_copy_lvs (&arena, lvs, n_lvs);
+    ret->n_lvs = n_lvs;
+    ret->ref_count = 1;
+
+    for (guint i = 0; i < n_lvs; i++)
+        bd_lvm_lvdata_free (lvs[i]);
+    g_free (lvs);
+
+    return ret;
+}
+
+void bd_lvm_lv_result_set_free (BDLVMLVResultSet *set) {
+    if (set == NULL)
+        return;
+
+    if (!g_atomic_int_dec_and_test (&(set->ref_count)))
+        return;
+
+    g_free (set->lvs);
+    g_free (set);
+}
+
+BDLVMLVResultSet* bd_lvm_lv_result_set_copy (BDLVMLVResultSet *set) {
+    if (set == NULL)
+        return NULL;
+
+    g_atomic_int_inc (&(set->ref_count));
+    return set;
+}
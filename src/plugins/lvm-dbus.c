@@ -29,6 +29,15 @@
 #include "check_deps.h"
 #include "dm_logging.h"
 #include "vdo_stats.h"
+#include "cache_stats.h"
+#include "cache_settings.h"
+#include "vdo_settings.h"
+#include "pool_monitor.h"
+#include "pvmove_job.h"
+#include "lv_result_set.h"
+#include "dm_snapshot.h"
+#include "lvm_config.h"
+#include "../utils/parallel.h"
 
 #define INT_FLOAT_EPS 1e-5
 #define SECTOR_SIZE 512
@@ -64,11 +73,6 @@
 #define MAX_LV_SIZE (16 TiB)
 #endif
 
-static GMutex global_config_lock;
-static gchar *global_config_str = NULL;
-
-static gchar *global_devices_str = NULL;
-
 #define LVM_BUS_NAME "com.redhat.lvmdbus1"
 #define LVM_OBJ_PREFIX "/com/redhat/lvmdbus1"
 #define MANAGER_OBJ "/com/redhat/lvmdbus1/Manager"
@@ -93,13 +97,19 @@ static gchar *global_devices_str = NULL;
 #define CACHE_POOL_INTF LVM_BUS_NAME".CachePool"
 #define VDO_POOL_INTF LVM_BUS_NAME".VdoPool"
 #define DBUS_PROPS_IFACE "org.freedesktop.DBus.Properties"
-#define DBUS_INTRO_IFACE "org.freedesktop.DBus.Introspectable"
+#define DBUS_OBJ_MANAGER_IFACE "org.freedesktop.DBus.ObjectManager"
 #define METHOD_CALL_TIMEOUT 5000
 #define PROGRESS_WAIT 500 * 1000 /* microseconds */
+#define JOB_WAIT_TIMEOUT 1 /* seconds */
+#define BATCH_DEFAULT_WORKERS 16
 
 
 static GDBusConnection *bus = NULL;
 
+/* cache of the LVM objects (see get_lvm_objects_snapshot()) */
+static void invalidate_objects_cache (void);
+static void stop_objects_cache_monitor (void);
+
 /**
  * SECTION: lvm
  * @short_description: plugin for operations with LVM
@@ -226,6 +236,103 @@ void bd_lvm_lvdata_free (BDLVMLVdata *data) {
     g_free (data);
 }
 
+BDLVMBatchOp* bd_lvm_batch_op_new (BDLVMBatchOpType type, const gchar *vg_name, const gchar *lv_name, const gchar *new_name, const gchar **tags) {
+    BDLVMBatchOp *ret = g_new0 (BDLVMBatchOp, 1);
+
+    ret->type = type;
+    ret->vg_name = g_strdup (vg_name);
+    ret->lv_name = g_strdup (lv_name);
+    ret->new_name = g_strdup (new_name);
+    ret->tags = g_strdupv ((gchar **) tags);
+
+    return ret;
+}
+
+BDLVMBatchOp* bd_lvm_batch_op_copy (BDLVMBatchOp *data) {
+    if (data == NULL)
+        return NULL;
+
+    return bd_lvm_batch_op_new (data->type, data->vg_name, data->lv_name, data->new_name, (const gchar **) data->tags);
+}
+
+void bd_lvm_batch_op_free (BDLVMBatchOp *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->vg_name);
+    g_free (data->lv_name);
+    g_free (data->new_name);
+    g_strfreev (data->tags);
+    g_free (data);
+}
+
+BDLVMBatchResult* bd_lvm_batch_result_copy (BDLVMBatchResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDLVMBatchResult *ret = g_new0 (BDLVMBatchResult, 1);
+
+    ret->success = data->success;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+void bd_lvm_batch_result_free (BDLVMBatchResult *data) {
+    if (data == NULL)
+        return;
+
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+BDLVMReportdata* bd_lvm_reportdata_copy (BDLVMReportdata *data) {
+    guint64 i = 0;
+
+    if (data == NULL)
+        return NULL;
+
+    BDLVMReportdata *new_data = g_new0 (BDLVMReportdata, 1);
+
+    for (i = 0; data->pvs && data->pvs[i]; i++);
+    new_data->pvs = g_new0 (BDLVMPVdata *, i + 1);
+    for (i = 0; data->pvs && data->pvs[i]; i++)
+        new_data->pvs[i] = bd_lvm_pvdata_copy (data->pvs[i]);
+
+    for (i = 0; data->vgs && data->vgs[i]; i++);
+    new_data->vgs = g_new0 (BDLVMVGdata *, i + 1);
+    for (i = 0; data->vgs && data->vgs[i]; i++)
+        new_data->vgs[i] = bd_lvm_vgdata_copy (data->vgs[i]);
+
+    for (i = 0; data->lvs && data->lvs[i]; i++);
+    new_data->lvs = g_new0 (BDLVMLVdata *, i + 1);
+    for (i = 0; data->lvs && data->lvs[i]; i++)
+        new_data->lvs[i] = bd_lvm_lvdata_copy (data->lvs[i]);
+
+    return new_data;
+}
+
+void bd_lvm_reportdata_free (BDLVMReportdata *data) {
+    guint64 i = 0;
+
+    if (data == NULL)
+        return;
+
+    for (i = 0; data->pvs && data->pvs[i]; i++)
+        bd_lvm_pvdata_free (data->pvs[i]);
+    g_free (data->pvs);
+
+    for (i = 0; data->vgs && data->vgs[i]; i++)
+        bd_lvm_vgdata_free (data->vgs[i]);
+    g_free (data->vgs);
+
+    for (i = 0; data->lvs && data->lvs[i]; i++)
+        bd_lvm_lvdata_free (data->lvs[i]);
+    g_free (data->lvs);
+
+    g_free (data);
+}
+
 BDLVMCacheStats* bd_lvm_cache_stats_copy (BDLVMCacheStats *data) {
     if (data == NULL)
         return NULL;
@@ -366,6 +473,8 @@ gboolean bd_lvm_init (void) {
 void bd_lvm_close (void) {
     GError *error = NULL;
 
+    stop_objects_cache_monitor ();
+
     /* the check() call should create the DBus connection for us, but let's not
        completely rely on it */
     if (!g_dbus_connection_flush_sync (bus, NULL, &error)) {
@@ -377,6 +486,7 @@ void bd_lvm_close (void) {
         g_clear_error (&error);
     }
 
+    vdo_stats_close ();
     dm_log_with_errno_init (NULL);
     dm_log_init_verbose (0);
 }
@@ -421,42 +531,6 @@ gboolean bd_lvm_is_tech_avail (BDLVMTech tech, guint64 mode, GError **error) {
     }
 }
 
-static gchar** get_existing_objects (const gchar *obj_prefix, GError **error) {
-    GVariant *intro_v = NULL;
-    gchar *intro_data = NULL;
-    GDBusNodeInfo *info = NULL;
-    gchar **ret = NULL;
-    GDBusNodeInfo **nodes;
-    guint64 n_nodes = 0;
-    guint64 i = 0;
-
-    intro_v = g_dbus_connection_call_sync (bus, LVM_BUS_NAME, obj_prefix, DBUS_INTRO_IFACE,
-                                           "Introspect", NULL, NULL, G_DBUS_CALL_FLAGS_NONE,
-                                           -1, NULL, error);
-    if (!intro_v)
-        /* no introspection data, something went wrong (error must be set) */
-        return NULL;
-
-    g_variant_get (intro_v, "(s)", &intro_data);
-    g_variant_unref (intro_v);
-    info = g_dbus_node_info_new_for_xml (intro_data, error);
-    g_free (intro_data);
-
-    for (nodes = info->nodes; (*nodes); nodes++)
-        n_nodes++;
-
-    ret = g_new0 (gchar*, n_nodes + 1);
-    for (nodes = info->nodes, i=0; (*nodes); nodes++, i++) {
-        ret[i] = g_strdup_printf ("%s/%s", obj_prefix, ((*nodes)->path));
-    }
-    ret[i] = NULL;
-
-    g_dbus_node_info_unref (info);
-
-    return ret;
-}
-
-
 /**
  * get_object_path:
  * @obj_id: get object path for an LVM object (vgname/lvname)
@@ -586,13 +660,12 @@ static gboolean unbox_params_and_add (GVariant *params, GVariantBuilder *builder
  * @extra_args: extra command line argument to be passed to the LVM command
  * @task_id: (out): task ID to watch progress of the operation
  * @progress_id: (out): progress ID to watch progress of the operation
- * @lock_config: whether to lock %global_config_lock or not (if %FALSE is given, caller is responsible
- *               for holding the lock for this call)
+ * @cfg: (nullable): config to use for the call or %NULL to use the thread or (a snapshot of) the global one
  * @error: (out) (optional): place to store error (if any)
  *
  * Returns: (transfer full): return value of @method (variant)
  */
-static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, guint64 *task_id, guint64 *progress_id, gboolean lock_config, GError **error) {
+static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, guint64 *task_id, guint64 *progress_id, LVMConfig *cfg, GError **error) {
     GVariant *config = NULL;
     GVariant *devices = NULL;
     GVariant *param = NULL;
@@ -608,16 +681,16 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
     gchar *prog_msg = NULL;
     const BDExtraArg **extra_p = NULL;
     gboolean added_extra = FALSE;
+    BDUtilsTimingSpan span;
 
     if (!check_dbus_deps (&avail_dbus_deps, DBUS_DEPS_LVMDBUSD_MASK, dbus_deps, DBUS_DEPS_LAST, &deps_check_lock, error))
         return NULL;
 
-    /* don't allow global config string changes during the run */
-    if (lock_config)
-        g_mutex_lock (&global_config_lock);
+    /* the snapshot doesn't change during the run even if the global config does */
+    cfg = cfg ? lvm_config_ref (cfg) : lvm_config_get ();
 
-    if (global_config_str || global_devices_str || extra_params || extra_args) {
-        if (global_config_str || global_devices_str || extra_args) {
+    if (cfg->config || cfg->devices || extra_params || extra_args) {
+        if (cfg->config || cfg->devices || extra_args) {
             /* add the global config to the extra_params */
             g_variant_builder_init (&extra_builder, G_VARIANT_TYPE_DICTIONARY);
 
@@ -633,13 +706,13 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
                     added_extra = TRUE;
                 }
             }
-            if (global_config_str) {
-                config = g_variant_new ("s", global_config_str);
+            if (cfg->config) {
+                config = g_variant_new ("s", cfg->config);
                 g_variant_builder_add (&extra_builder, "{sv}", "--config", config);
                 added_extra = TRUE;
             }
-            if (global_devices_str) {
-                devices = g_variant_new ("s", global_devices_str);
+            if (cfg->devices) {
+                devices = g_variant_new ("s", cfg->devices);
                 g_variant_builder_add (&extra_builder, "{sv}", "--devices", devices);
                 added_extra = TRUE;
             }
@@ -688,11 +761,12 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
     g_free (log_msg);
 
     /* now do the call with all the parameters */
+    bd_utils_timing_span_begin (&span, "lvm-dbus", method);
     ret = g_dbus_connection_call_sync (bus, LVM_BUS_NAME, obj, intf, method, all_params,
                                        NULL, G_DBUS_CALL_FLAGS_NONE, METHOD_CALL_TIMEOUT, NULL, error);
+    bd_utils_timing_span_end (&span, *task_id, intf, ret ? g_variant_get_size (ret) : 0, ret ? 0 : -1);
 
-    if (lock_config)
-         g_mutex_unlock (&global_config_lock);
+    lvm_config_unref (cfg);
     prog_msg = g_strdup_printf ("Started the '%s.%s' method on the '%s' object with the following parameters: '%s'",
                                intf, method, obj, params_str);
     g_free (params_str);
@@ -707,6 +781,9 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
     return ret;
 }
 
+/* whether the running lvmdbusd supports the Job.Wait method (checked on first use) */
+static gboolean job_wait_supported = TRUE;
+
 /**
  * call_lvm_method_sync
  * @obj: lvmdbusd object path
@@ -715,13 +792,12 @@ static GVariant* call_lvm_method (const gchar *obj, const gchar *intf, const gch
  * @params: parameters for @method
  * @extra_params: extra parameters for @method
  * @extra_args: extra command line argument to be passed to the LVM command
- * @lock_config: whether to lock %global_config_lock or not (if %FALSE is given, caller is responsible
- *               for holding the lock for this call)
+ * @cfg: (nullable): config to use for the call or %NULL to use the thread or (a snapshot of) the global one
  * @error: (out) (optional): place to store error (if any)
  *
  * Returns: whether calling the method was successful or not
  */
-static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean _call_lvm_method_sync (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, LVMConfig *cfg, GError **error) {
     GVariant *ret = NULL;
     gchar *obj_path = NULL;
     gchar *task_path = NULL;
@@ -734,7 +810,7 @@ static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const
     gchar *error_msg = NULL;
     GError *l_error = NULL;
 
-    ret = call_lvm_method (obj, intf, method, params, extra_params, extra_args, &log_task_id, &prog_id, lock_config, &l_error);
+    ret = call_lvm_method (obj, intf, method, params, extra_params, extra_args, &log_task_id, &prog_id, cfg, &l_error);
     bd_utils_log_task_status (log_task_id, "Done.");
     if (!ret) {
         if (l_error) {
@@ -802,12 +878,30 @@ static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const
 
     ret = NULL;
     while (!completed && !l_error) {
-        g_usleep (PROGRESS_WAIT);
-        ret = get_object_property (task_path, JOB_INTF, "Complete", &l_error);
-        if (ret) {
-            g_variant_get (ret, "b", &completed);
-            g_variant_unref (ret);
-            ret = NULL;
+        if (job_wait_supported) {
+            /* returns as soon as the job completes (or when the timeout expires) */
+            ret = g_dbus_connection_call_sync (bus, LVM_BUS_NAME, task_path, JOB_INTF, "Wait",
+                                               g_variant_new ("(i)", JOB_WAIT_TIMEOUT), G_VARIANT_TYPE ("(b)"),
+                                               G_DBUS_CALL_FLAGS_NONE, METHOD_CALL_TIMEOUT, NULL, &l_error);
+            if (ret) {
+                g_variant_get (ret, "(b)", &completed);
+                g_variant_unref (ret);
+                ret = NULL;
+            } else if (g_error_matches (l_error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+                /* old lvmdbusd, fall back to polling */
+                bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Job.Wait not supported, polling the job status");
+                g_clear_error (&l_error);
+                job_wait_supported = FALSE;
+            }
+        }
+        if (!job_wait_supported) {
+            g_usleep (PROGRESS_WAIT);
+            ret = get_object_property (task_path, JOB_INTF, "Complete", &l_error);
+            if (ret) {
+                g_variant_get (ret, "b", &completed);
+                g_variant_unref (ret);
+                ret = NULL;
+            }
         }
         if (!completed && !l_error) {
             /* let's report progress and wait longer */
@@ -899,30 +993,42 @@ static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const
     return TRUE;
 }
 
-static gboolean call_lvm_obj_method_sync (const gchar *obj_id, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_lvm_method_sync (const gchar *obj, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, LVMConfig *cfg, GError **error) {
+    gboolean ret = FALSE;
+
+    ret = _call_lvm_method_sync (obj, intf, method, params, extra_params, extra_args, cfg, error);
+
+    /* the signals about the changes may not have been processed yet, make sure
+       the next query doesn't use stale data */
+    invalidate_objects_cache ();
+
+    return ret;
+}
+
+static gboolean call_lvm_obj_method_sync (const gchar *obj_id, const gchar *intf, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, LVMConfig *cfg, GError **error) {
     g_autofree gchar *obj_path = get_object_path (obj_id, error);
     if (!obj_path)
         return FALSE;
 
-    return call_lvm_method_sync (obj_path, intf, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_method_sync (obj_path, intf, method, params, extra_params, extra_args, cfg, error);
 }
 
-static gboolean call_lv_method_sync (const gchar *vg_name, const gchar *lv_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_lv_method_sync (const gchar *vg_name, const gchar *lv_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, LVMConfig *cfg, GError **error) {
     g_autofree gchar *obj_id = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    return call_lvm_obj_method_sync (obj_id, LV_INTF, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_obj_method_sync (obj_id, LV_INTF, method, params, extra_params, extra_args, cfg, error);
 }
 
-static gboolean call_thpool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_thpool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, LVMConfig *cfg, GError **error) {
     g_autofree gchar *obj_id = g_strdup_printf ("%s/%s", vg_name, pool_name);
 
-    return call_lvm_obj_method_sync (obj_id, THPOOL_INTF, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_obj_method_sync (obj_id, THPOOL_INTF, method, params, extra_params, extra_args, cfg, error);
 }
 
-static gboolean call_vdopool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, gboolean lock_config, GError **error) {
+static gboolean call_vdopool_method_sync (const gchar *vg_name, const gchar *pool_name, const gchar *method, GVariant *params, GVariant *extra_params, const BDExtraArg **extra_args, LVMConfig *cfg, GError **error) {
     g_autofree gchar *obj_id = g_strdup_printf ("%s/%s", vg_name, pool_name);
 
-    return call_lvm_obj_method_sync (obj_id, VDO_POOL_INTF, method, params, extra_params, extra_args, lock_config, error);
+    return call_lvm_obj_method_sync (obj_id, VDO_POOL_INTF, method, params, extra_params, extra_args, cfg, error);
 }
 
 static GVariant* get_lv_property (const gchar *vg_name, const gchar *lv_name, const gchar *property, GError **error) {
@@ -1007,31 +1113,465 @@ static GVariant* get_vg_properties (const gchar *vg_name, GError **error) {
     return ret;
 }
 
-static GVariant* get_lv_properties (const gchar *vg_name, const gchar *lv_name, GError **error) {
+static GVariant* get_vdo_properties (const gchar *vg_name, const gchar *pool_name, GError **error) {
     gchar *lvm_spec = NULL;
     GVariant *ret = NULL;
 
-    lvm_spec = g_strdup_printf ("%s/%s", vg_name, lv_name);
+    lvm_spec = g_strdup_printf ("%s/%s", vg_name, pool_name);
 
-    ret = get_lvm_object_properties (lvm_spec, LV_CMN_INTF, error);
+    ret = get_lvm_object_properties (lvm_spec, VDO_POOL_INTF, error);
     g_free (lvm_spec);
 
     return ret;
 }
 
-static GVariant* get_vdo_properties (const gchar *vg_name, const gchar *pool_name, GError **error) {
-    gchar *lvm_spec = NULL;
+/**
+ * LVMObjects: (skip)
+ *
+ * Snapshot of all the objects exported by lvmdbusd (with all their properties)
+ * obtained with a single GetManagedObjects() call and (if cached) kept up to
+ * date by the signals lvmdbusd emits. A snapshot that is referenced by anybody
+ * else than the cache is never modified, the cache is updated in a copy instead.
+ */
+typedef struct LVMObjects {
+    gint ref_count;
+    /* object path -> (interface name -> a{sv} properties) */
+    GHashTable *paths;
+} LVMObjects;
+
+static LVMObjects* lvm_objects_new (void) {
+    LVMObjects *objs = g_new0 (LVMObjects, 1);
+
+    objs->ref_count = 1;
+    objs->paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_destroy);
+
+    return objs;
+}
+
+static LVMObjects* lvm_objects_ref (LVMObjects *objs) {
+    g_atomic_int_inc (&(objs->ref_count));
+    return objs;
+}
+
+static void lvm_objects_unref (LVMObjects *objs) {
+    if (!objs || !g_atomic_int_dec_and_test (&(objs->ref_count)))
+        return;
+
+    g_hash_table_destroy (objs->paths);
+    g_free (objs);
+}
+
+/* the properties are immutable variants so only the tables are copied */
+static LVMObjects* lvm_objects_copy (LVMObjects *objs) {
+    LVMObjects *new_objs = lvm_objects_new ();
+    GHashTableIter iter;
+    GHashTableIter iface_iter;
+    gpointer path = NULL;
+    gpointer obj_ifaces = NULL;
+    gpointer iface = NULL;
+    gpointer props = NULL;
+    GHashTable *new_ifaces = NULL;
+
+    g_hash_table_iter_init (&iter, objs->paths);
+    while (g_hash_table_iter_next (&iter, &path, &obj_ifaces)) {
+        new_ifaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+        g_hash_table_iter_init (&iface_iter, obj_ifaces);
+        while (g_hash_table_iter_next (&iface_iter, &iface, &props))
+            g_hash_table_insert (new_ifaces, g_strdup (iface), g_variant_ref (props));
+        g_hash_table_insert (new_objs->paths, g_strdup (path), new_ifaces);
+    }
+
+    return new_objs;
+}
+
+/* adds (or replaces) the @ifaces (a{sa{sv}}) interfaces of the @obj_path object */
+static void lvm_objects_add_ifaces (LVMObjects *objs, const gchar *obj_path, GVariant *ifaces) {
+    GHashTable *obj_ifaces = NULL;
+    GVariantIter iter;
+    gchar *iface = NULL;
+    GVariant *props = NULL;
+
+    obj_ifaces = g_hash_table_lookup (objs->paths, obj_path);
+    if (!obj_ifaces) {
+        obj_ifaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+        g_hash_table_insert (objs->paths, g_strdup (obj_path), obj_ifaces);
+    }
+
+    g_variant_iter_init (&iter, ifaces);
+    while (g_variant_iter_next (&iter, "{s@a{sv}}", &iface, &props))
+        g_hash_table_insert (obj_ifaces, iface, props);
+}
+
+/* removes the @ifaces (as) interfaces of the @obj_path object (and the object
+   itself if it has no interfaces left) */
+static void lvm_objects_remove_ifaces (LVMObjects *objs, const gchar *obj_path, GVariant *ifaces) {
+    GHashTable *obj_ifaces = NULL;
+    GVariantIter iter;
+    const gchar *iface = NULL;
+
+    obj_ifaces = g_hash_table_lookup (objs->paths, obj_path);
+    if (!obj_ifaces)
+        return;
+
+    g_variant_iter_init (&iter, ifaces);
+    while (g_variant_iter_next (&iter, "&s", &iface))
+        g_hash_table_remove (obj_ifaces, iface);
+
+    if (g_hash_table_size (obj_ifaces) == 0)
+        g_hash_table_remove (objs->paths, obj_path);
+}
+
+/**
+ * lvm_objects_update_props: (skip)
+ * @changed: (a{sv}) changed properties with their new values
+ * @invalidated: (as) properties that changed without their new values
+ *
+ * Returns: whether the @iface properties of the @obj_path object were updated
+ *          or not (the new values of the @invalidated properties are unknown)
+ */
+static gboolean lvm_objects_update_props (LVMObjects *objs, const gchar *obj_path, const gchar *iface,
+                                          GVariant *changed, GVariant *invalidated) {
+    GHashTable *obj_ifaces = NULL;
+    GVariant *props = NULL;
+    GVariantDict dict;
+    GVariantIter iter;
+    const gchar *key = NULL;
+    GVariant *value = NULL;
+
+    if (g_variant_n_children (invalidated) > 0)
+        return FALSE;
+
+    obj_ifaces = g_hash_table_lookup (objs->paths, obj_path);
+    props = obj_ifaces ? g_hash_table_lookup (obj_ifaces, iface) : NULL;
+    if (!props)
+        /* not an object (interface) we know about (e.g. a job) */
+        return TRUE;
+
+    g_variant_dict_init (&dict, props);
+    g_variant_iter_init (&iter, changed);
+    while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+        g_variant_dict_insert_value (&dict, key, value);
+        g_variant_unref (value);
+    }
+    g_hash_table_insert (obj_ifaces, g_strdup (iface), g_variant_ref_sink (g_variant_dict_end (&dict)));
+
+    return TRUE;
+}
+
+/* sort object paths of the same type by their numeric suffix (.../Lv/2 < .../Lv/10) */
+static gint compare_object_paths (gconstpointer a, gconstpointer b) {
+    gsize len_a = strlen (a);
+    gsize len_b = strlen (b);
+
+    if (len_a != len_b)
+        return len_a < len_b ? -1 : 1;
+
+    return strcmp (a, b);
+}
+
+/* whether @obj_path is an object of the @obj_prefix type (e.g. PV_OBJ_PREFIX) */
+static gboolean is_object_of_type (const gchar *obj_path, const gchar *obj_prefix) {
+    gsize len = strlen (obj_prefix);
+
+    return strncmp (obj_path, obj_prefix, len) == 0 && obj_path[len] == '/';
+}
+
+/**
+ * lvm_objects_get_paths: (skip)
+ *
+ * Returns: (transfer container) (element-type utf8): sorted list of paths of
+ *          the objects of the @obj_prefix type in @objs
+ */
+static GList* lvm_objects_get_paths (LVMObjects *objs, const gchar *obj_prefix) {
+    GHashTableIter iter;
+    gpointer path = NULL;
+    GList *ret = NULL;
+
+    g_hash_table_iter_init (&iter, objs->paths);
+    while (g_hash_table_iter_next (&iter, &path, NULL))
+        if (is_object_of_type (path, obj_prefix))
+            ret = g_list_prepend (ret, path);
+
+    return g_list_sort (ret, compare_object_paths);
+}
+
+static LVMObjects* get_lvm_objects (GError **error) {
     GVariant *ret = NULL;
+    GVariant *objects = NULL;
+    LVMObjects *objs = NULL;
+    GVariantIter iter;
+    const gchar *path = NULL;
+    GVariant *ifaces = NULL;
 
-    lvm_spec = g_strdup_printf ("%s/%s", vg_name, pool_name);
+    ret = g_dbus_connection_call_sync (bus, LVM_BUS_NAME, LVM_OBJ_PREFIX, DBUS_OBJ_MANAGER_IFACE,
+                                       "GetManagedObjects", NULL, G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+                                       G_DBUS_CALL_FLAGS_NONE, -1, NULL, error);
+    if (!ret) {
+        g_prefix_error (error, "Failed to get the LVM objects: ");
+        return NULL;
+    }
 
-    ret = get_lvm_object_properties (lvm_spec, VDO_POOL_INTF, error);
-    g_free (lvm_spec);
+    objs = lvm_objects_new ();
+    objects = g_variant_get_child_value (ret, 0);
+    g_variant_iter_init (&iter, objects);
+    while (g_variant_iter_next (&iter, "{&o@a{sa{sv}}}", &path, &ifaces)) {
+        lvm_objects_add_ifaces (objs, path, ifaces);
+        g_variant_unref (ifaces);
+    }
+    g_variant_unref (objects);
+    g_variant_unref (ret);
+
+    return objs;
+}
+
+/**
+ * lvm_objects_get_props: (skip)
+ *
+ * Returns: (transfer full): properties of the @iface interface of the @obj_path
+ *                           object in the @objs snapshot or %NULL if not found
+ */
+static GVariant* lvm_objects_get_props (LVMObjects *objs, const gchar *obj_path, const gchar *iface) {
+    GHashTable *obj_ifaces = NULL;
+    GVariant *props = NULL;
+
+    obj_ifaces = g_hash_table_lookup (objs->paths, obj_path);
+    if (!obj_ifaces)
+        return NULL;
+
+    props = g_hash_table_lookup (obj_ifaces, iface);
+    return props ? g_variant_ref (props) : NULL;
+}
+
+/* The cached snapshot of the LVM objects (NULL if it needs to be fetched) kept
+ * up to date by the handlers of the lvmdbusd signals. The signals are
+ * dispatched in a separate thread (with its own main context) so that the
+ * cache works without the caller running a main loop. */
+static GMutex objects_cache_lock;
+static LVMObjects *objects_cache = NULL;
+static GMainContext *objects_cache_context = NULL;
+static GMainLoop *objects_cache_loop = NULL;
+static GThread *objects_cache_thread = NULL;
+static guint objects_cache_subscriptions[3] = {0, 0, 0};
+
+static void invalidate_objects_cache (void) {
+    g_mutex_lock (&objects_cache_lock);
+    lvm_objects_unref (objects_cache);
+    objects_cache = NULL;
+    g_mutex_unlock (&objects_cache_lock);
+}
+
+/* must be called with objects_cache_lock held, returns the cache that can be
+   modified (copying it if needed) */
+static LVMObjects* get_writable_objects_cache (void) {
+    LVMObjects *new_cache = NULL;
+
+    if (g_atomic_int_get (&(objects_cache->ref_count)) > 1) {
+        /* somebody is using the snapshot (without holding the lock) */
+        new_cache = lvm_objects_copy (objects_cache);
+        lvm_objects_unref (objects_cache);
+        objects_cache = new_cache;
+    }
+
+    return objects_cache;
+}
+
+static void objects_cache_signal_handler (GDBusConnection *connection G_GNUC_UNUSED, const gchar *sender_name G_GNUC_UNUSED,
+                                          const gchar *obj_path, const gchar *iface, const gchar *signal_name,
+                                          GVariant *parameters, gpointer user_data G_GNUC_UNUSED) {
+    const gchar *path = NULL;
+    const gchar *changed_iface = NULL;
+    GVariant *ifaces = NULL;
+    GVariant *changed = NULL;
+    GVariant *invalidated = NULL;
+
+    g_mutex_lock (&objects_cache_lock);
+    if (!objects_cache) {
+        /* nothing to update, will be fetched (with the changes) when needed */
+        g_mutex_unlock (&objects_cache_lock);
+        return;
+    }
+
+    if (g_strcmp0 (iface, DBUS_OBJ_MANAGER_IFACE) == 0 &&
+        g_strcmp0 (signal_name, "InterfacesAdded") == 0 &&
+        g_variant_check_format_string (parameters, "(&o@a{sa{sv}})", FALSE)) {
+        g_variant_get (parameters, "(&o@a{sa{sv}})", &path, &ifaces);
+        lvm_objects_add_ifaces (get_writable_objects_cache (), path, ifaces);
+        g_variant_unref (ifaces);
+    } else if (g_strcmp0 (iface, DBUS_OBJ_MANAGER_IFACE) == 0 &&
+               g_strcmp0 (signal_name, "InterfacesRemoved") == 0 &&
+               g_variant_check_format_string (parameters, "(&o@as)", FALSE)) {
+        g_variant_get (parameters, "(&o@as)", &path, &ifaces);
+        lvm_objects_remove_ifaces (get_writable_objects_cache (), path, ifaces);
+        g_variant_unref (ifaces);
+    } else if (g_strcmp0 (iface, DBUS_PROPS_IFACE) == 0 &&
+               g_strcmp0 (signal_name, "PropertiesChanged") == 0 &&
+               g_variant_check_format_string (parameters, "(&s@a{sv}@as)", FALSE)) {
+        g_variant_get (parameters, "(&s@a{sv}@as)", &changed_iface, &changed, &invalidated);
+        if (!lvm_objects_update_props (get_writable_objects_cache (), obj_path, changed_iface, changed, invalidated)) {
+            lvm_objects_unref (objects_cache);
+            objects_cache = NULL;
+        }
+        g_variant_unref (changed);
+        g_variant_unref (invalidated);
+    } else {
+        /* lvmdbusd (re)started or stopped or something we don't understand */
+        lvm_objects_unref (objects_cache);
+        objects_cache = NULL;
+    }
+
+    g_mutex_unlock (&objects_cache_lock);
+}
+
+static gpointer objects_cache_thread_func (gpointer data G_GNUC_UNUSED) {
+    g_main_context_push_thread_default (objects_cache_context);
+    g_main_loop_run (objects_cache_loop);
+    g_main_context_pop_thread_default (objects_cache_context);
+
+    return NULL;
+}
+
+/* must be called with objects_cache_lock held */
+static void start_objects_cache_monitor (void) {
+    g_autoptr(GError) l_error = NULL;
+
+    objects_cache_context = g_main_context_new ();
+    objects_cache_loop = g_main_loop_new (objects_cache_context, FALSE);
+
+    /* the signal handlers are called in the thread-default main context of the
+       thread that subscribes to the signals */
+    g_main_context_push_thread_default (objects_cache_context);
+    objects_cache_subscriptions[0] = g_dbus_connection_signal_subscribe (bus, LVM_BUS_NAME, DBUS_OBJ_MANAGER_IFACE,
+                                                                         NULL, LVM_OBJ_PREFIX, NULL,
+                                                                         G_DBUS_SIGNAL_FLAGS_NONE,
+                                                                         objects_cache_signal_handler,
+                                                                         NULL, NULL);
+    objects_cache_subscriptions[1] = g_dbus_connection_signal_subscribe (bus, LVM_BUS_NAME, DBUS_PROPS_IFACE,
+                                                                         "PropertiesChanged", NULL, NULL,
+                                                                         G_DBUS_SIGNAL_FLAGS_NONE,
+                                                                         objects_cache_signal_handler,
+                                                                         NULL, NULL);
+    objects_cache_subscriptions[2] = g_dbus_connection_signal_subscribe (bus, "org.freedesktop.DBus", "org.freedesktop.DBus",
+                                                                         "NameOwnerChanged", "/org/freedesktop/DBus",
+                                                                         LVM_BUS_NAME, G_DBUS_SIGNAL_FLAGS_NONE,
+                                                                         objects_cache_signal_handler,
+                                                                         NULL, NULL);
+    g_main_context_pop_thread_default (objects_cache_context);
+
+    objects_cache_thread = g_thread_try_new ("bd-lvm-dbus-cache", objects_cache_thread_func, NULL, &l_error);
+    if (!objects_cache_thread) {
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to start the LVM DBus objects cache thread: %s",
+                             l_error->message);
+        for (guint i = 0; i < G_N_ELEMENTS (objects_cache_subscriptions); i++) {
+            g_dbus_connection_signal_unsubscribe (bus, objects_cache_subscriptions[i]);
+            objects_cache_subscriptions[i] = 0;
+        }
+        g_main_loop_unref (objects_cache_loop);
+        objects_cache_loop = NULL;
+        g_main_context_unref (objects_cache_context);
+        objects_cache_context = NULL;
+    }
+}
+
+static void stop_objects_cache_monitor (void) {
+    g_mutex_lock (&objects_cache_lock);
+    if (objects_cache_thread) {
+        for (guint i = 0; i < G_N_ELEMENTS (objects_cache_subscriptions); i++) {
+            g_dbus_connection_signal_unsubscribe (bus, objects_cache_subscriptions[i]);
+            objects_cache_subscriptions[i] = 0;
+        }
+        g_main_loop_quit (objects_cache_loop);
+        g_mutex_unlock (&objects_cache_lock);
+        /* the signal handler may be waiting for the lock */
+        g_thread_join (objects_cache_thread);
+        g_mutex_lock (&objects_cache_lock);
+
+        objects_cache_thread = NULL;
+        g_main_loop_unref (objects_cache_loop);
+        objects_cache_loop = NULL;
+        g_main_context_unref (objects_cache_context);
+        objects_cache_context = NULL;
+    }
+    lvm_objects_unref (objects_cache);
+    objects_cache = NULL;
+    g_mutex_unlock (&objects_cache_lock);
+}
+
+/**
+ * get_lvm_objects_snapshot: (skip)
+ *
+ * The cache lock is only held for getting the snapshot (and fetching it if
+ * needed), the data is read from the returned snapshot without any locking
+ * because the signal handlers never modify a snapshot that is in use.
+ *
+ * Returns: (transfer full): the (cached) snapshot of the LVM objects or %NULL
+ *          in case of error, the snapshot must be released with
+ *          lvm_objects_unref()
+ */
+static LVMObjects* get_lvm_objects_snapshot (GError **error) {
+    LVMObjects *ret = NULL;
+
+    g_mutex_lock (&objects_cache_lock);
+
+    if (!objects_cache_thread)
+        start_objects_cache_monitor ();
+
+    if (!objects_cache) {
+        ret = get_lvm_objects (error);
+        if (ret && objects_cache_thread)
+            objects_cache = lvm_objects_ref (ret);
+        /* else no signals to keep the snapshot up to date, cannot keep it */
+    } else
+        ret = lvm_objects_ref (objects_cache);
+
+    g_mutex_unlock (&objects_cache_lock);
+
+    return ret;
+}
+
+/**
+ * lookup_object_property: (skip)
+ * @objs: (nullable): snapshot of the LVM objects to get the property from or
+ *                    %NULL to get it from lvmdbusd
+ *
+ * Returns: (transfer full): the @property of the @iface interface of the
+ *                           @obj_path object
+ */
+static GVariant* lookup_object_property (LVMObjects *objs, const gchar *obj_path, const gchar *iface, const gchar *property, GError **error) {
+    GVariant *props = NULL;
+    GVariant *ret = NULL;
+
+    if (!objs)
+        return get_object_property (obj_path, iface, property, error);
+
+    props = lvm_objects_get_props (objs, obj_path, iface);
+    if (props) {
+        ret = g_variant_lookup_value (props, property, NULL);
+        g_variant_unref (props);
+    }
+
+    if (!ret)
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
+                     "Failed to get %s property of the %s object", property, obj_path);
+
+    return ret;
+}
+
+/* returns the name of the @obj_path object (or %NULL if not available) */
+static gchar* lookup_object_name (LVMObjects *objs, const gchar *obj_path, const gchar *iface) {
+    GVariant *name = NULL;
+    gchar *ret = NULL;
+
+    name = lookup_object_property (objs, obj_path, iface, "Name", NULL);
+    if (!name)
+        return NULL;
+
+    g_variant_get (name, "s", &ret);
+    g_variant_unref (name);
 
     return ret;
 }
 
-static BDLVMPVdata* get_pv_data_from_props (GVariant *props, GError **error G_GNUC_UNUSED) {
+static BDLVMPVdata* get_pv_data_from_props (GVariant *props, LVMObjects *objs, GError **error G_GNUC_UNUSED) {
     BDLVMPVdata *data = g_new0 (BDLVMPVdata, 1);
     GVariantDict dict;
     gchar *path = NULL;
@@ -1070,7 +1610,10 @@ static BDLVMPVdata* get_pv_data_from_props (GVariant *props, GError **error G_GN
         return data;
     }
 
-    vg_props = get_object_properties (path, VG_INTF, &l_error);
+    if (objs)
+        vg_props = lvm_objects_get_props (objs, path, VG_INTF);
+    else
+        vg_props = get_object_properties (path, VG_INTF, &l_error);
     g_variant_dict_clear (&dict);
     if (!vg_props) {
         if (l_error) {
@@ -1134,49 +1677,41 @@ static BDLVMVGdata* get_vg_data_from_props (GVariant *props, GError **error G_GN
     return data;
 }
 
-static gchar* _lvm_data_lv_name (const gchar *vg_name, const gchar *lv_name, GError **error) {
+static gchar* _lvm_data_lv_name (LVMObjects *objs, const gchar *obj_path, GError **error) {
     GVariant *prop = NULL;
-    gchar *obj_id = NULL;
-    gchar *obj_path = NULL;
+    gchar *path = NULL;
     gchar *ret = NULL;
     gchar *segtype = NULL;
 
-    obj_id = g_strdup_printf ("%s/%s", vg_name, lv_name);
-    obj_path = get_object_path (obj_id, error);
-    g_free (obj_id);
-    if (!obj_path)
-        return NULL;
-
-    prop = get_lv_property (vg_name, lv_name, "SegType", error);
+    prop = lookup_object_property (objs, obj_path, LV_CMN_INTF, "SegType", error);
     if (!prop)
         return NULL;
     g_variant_get_child (prop, 0, "s", &segtype);
     g_variant_unref (prop);
+    prop = NULL;
 
     if (g_strcmp0 (segtype, "thin-pool") == 0)
-        prop = get_object_property (obj_path, THPOOL_INTF, "DataLv", NULL);
+        prop = lookup_object_property (objs, obj_path, THPOOL_INTF, "DataLv", NULL);
     else if (g_strcmp0 (segtype, "cache-pool") == 0)
-        prop = get_object_property (obj_path, CACHE_POOL_INTF, "DataLv", NULL);
+        prop = lookup_object_property (objs, obj_path, CACHE_POOL_INTF, "DataLv", NULL);
     else if (g_strcmp0 (segtype, "vdo-pool") == 0)
-        prop = get_object_property (obj_path, VDO_POOL_INTF, "DataLv", NULL);
+        prop = lookup_object_property (objs, obj_path, VDO_POOL_INTF, "DataLv", NULL);
 
     g_free (segtype);
-    g_free (obj_path);
     if (!prop)
         return NULL;
-    g_variant_get (prop, "o", &obj_path);
+    g_variant_get (prop, "o", &path);
     g_variant_unref (prop);
 
-    if (g_strcmp0 (obj_path, "/") == 0) {
+    if (g_strcmp0 (path, "/") == 0) {
         /* no origin LV */
-        g_free (obj_path);
+        g_free (path);
         return NULL;
     }
-    prop = get_object_property (obj_path, LV_CMN_INTF, "Name", error);
-    if (!prop) {
-        g_free (obj_path);
+    prop = lookup_object_property (objs, path, LV_CMN_INTF, "Name", error);
+    g_free (path);
+    if (!prop)
         return NULL;
-    }
 
     g_variant_get (prop, "s", &ret);
     g_variant_unref (prop);
@@ -1184,37 +1719,28 @@ static gchar* _lvm_data_lv_name (const gchar *vg_name, const gchar *lv_name, GEr
     return g_strstrip (g_strdelimit (ret, "[]", ' '));
 }
 
-static gchar* _lvm_metadata_lv_name (const gchar *vg_name, const gchar *lv_name, GError **error) {
+static gchar* _lvm_metadata_lv_name (LVMObjects *objs, const gchar *obj_path, GError **error) {
     GVariant *prop = NULL;
-    gchar *obj_id = NULL;
-    gchar *obj_path = NULL;
+    gchar *path = NULL;
     gchar *ret = NULL;
 
-    obj_id = g_strdup_printf ("%s/%s", vg_name, lv_name);
-    obj_path = get_object_path (obj_id, error);
-    g_free (obj_id);
-    if (!obj_path)
-        return NULL;
-
-    prop = get_object_property (obj_path, THPOOL_INTF, "MetaDataLv", NULL);
+    prop = lookup_object_property (objs, obj_path, THPOOL_INTF, "MetaDataLv", NULL);
     if (!prop)
-        prop = get_object_property (obj_path, CACHE_POOL_INTF, "MetaDataLv", NULL);
-    g_free (obj_path);
+        prop = lookup_object_property (objs, obj_path, CACHE_POOL_INTF, "MetaDataLv", NULL);
     if (!prop)
         return NULL;
-    g_variant_get (prop, "o", &obj_path);
+    g_variant_get (prop, "o", &path);
     g_variant_unref (prop);
 
-    if (g_strcmp0 (obj_path, "/") == 0) {
+    if (g_strcmp0 (path, "/") == 0) {
         /* no origin LV */
-        g_free (obj_path);
+        g_free (path);
         return NULL;
     }
-    prop = get_object_property (obj_path, LV_CMN_INTF, "Name", error);
-    if (!prop) {
-        g_free (obj_path);
+    prop = lookup_object_property (objs, path, LV_CMN_INTF, "Name", error);
+    g_free (path);
+    if (!prop)
         return NULL;
-    }
 
     g_variant_get (prop, "s", &ret);
     g_variant_unref (prop);
@@ -1222,7 +1748,7 @@ static gchar* _lvm_metadata_lv_name (const gchar *vg_name, const gchar *lv_name,
     return g_strstrip (g_strdelimit (ret, "[]", ' '));
 }
 
-static BDLVMSEGdata** _lvm_segs (const gchar *vg_name, const gchar *lv_name, GError **error) {
+static BDLVMSEGdata** _lvm_segs (LVMObjects *objs, const gchar *obj_path, GError **error) {
     GVariant *prop = NULL;
     BDLVMSEGdata **segs;
     gsize n_segs;
@@ -1233,7 +1759,7 @@ static BDLVMSEGdata** _lvm_segs (const gchar *vg_name, const gchar *lv_name, GEr
     guint64 pv_first_pe, pv_last_pe;
     int i;
 
-    prop = get_lv_property (vg_name, lv_name, "Devices", error);
+    prop = lookup_object_property (objs, obj_path, LV_CMN_INTF, "Devices", error);
     if (!prop)
         return NULL;
 
@@ -1255,7 +1781,7 @@ static BDLVMSEGdata** _lvm_segs (const gchar *vg_name, const gchar *lv_name, GEr
     i = 0;
     g_variant_iter_init (&iter, prop);
     while (g_variant_iter_next (&iter, "(&o@a(tts))", &pv, &pv_segs)) {
-      pv_name_prop = get_object_property (pv, PV_INTF, "Name", NULL);
+      pv_name_prop = lookup_object_property (objs, pv, PV_INTF, "Name", NULL);
       if (pv_name_prop) {
         g_variant_get (pv_name_prop, "&s", &pv_name);
         g_variant_iter_init (&iter2, pv_segs);
@@ -1275,7 +1801,7 @@ static BDLVMSEGdata** _lvm_segs (const gchar *vg_name, const gchar *lv_name, GEr
     return segs;
 }
 
-static void _lvm_data_and_metadata_lvs (const gchar *vg_name, const gchar *lv_name,
+static void _lvm_data_and_metadata_lvs (LVMObjects *objs, const gchar *obj_path,
                                         gchar ***data_lvs_ret, gchar ***metadata_lvs_ret,
                                         GError **error) {
   GVariant *prop;
@@ -1290,8 +1816,10 @@ static void _lvm_data_and_metadata_lvs (const gchar *vg_name, const gchar *lv_na
   GVariant *sublv_name_prop;
   gchar *sublv_name;
   const gchar *role;
+  /* Roles and Name are properties of the common LV interface in the snapshot */
+  const gchar *sublv_intf = objs ? LV_CMN_INTF : LV_INTF;
 
-  prop = get_lv_property (vg_name, lv_name, "HiddenLvs", error);
+  prop = lookup_object_property (objs, obj_path, LV_CMN_INTF, "HiddenLvs", error);
   if (!prop) {
     *data_lvs_ret = NULL;
     *metadata_lvs_ret = NULL;
@@ -1306,9 +1834,9 @@ static void _lvm_data_and_metadata_lvs (const gchar *vg_name, const gchar *lv_na
   i_metadata = 0;
   g_variant_iter_init (&iter, prop);
   while (g_variant_iter_next (&iter, "&o", &sublv)) {
-    sublv_roles_prop = get_object_property (sublv, LV_INTF, "Roles", NULL);
+    sublv_roles_prop = lookup_object_property (objs, sublv, sublv_intf, "Roles", NULL);
     if (sublv_roles_prop) {
-      sublv_name_prop = get_object_property (sublv, LV_INTF, "Name", NULL);
+      sublv_name_prop = lookup_object_property (objs, sublv, sublv_intf, "Name", NULL);
       if (sublv_name_prop) {
         g_variant_get (sublv_name_prop, "s", &sublv_name);
         if (sublv_name) {
@@ -1340,12 +1868,11 @@ static void _lvm_data_and_metadata_lvs (const gchar *vg_name, const gchar *lv_na
   return;
 }
 
-static BDLVMLVdata* get_lv_data_from_props (GVariant *props, GError **error G_GNUC_UNUSED) {
+static BDLVMLVdata* get_lv_data_from_props (GVariant *props, LVMObjects *objs, GError **error G_GNUC_UNUSED) {
     BDLVMLVdata *data = g_new0 (BDLVMLVdata, 1);
     GVariantDict dict;
     GVariant *value = NULL;
     gchar *path = NULL;
-    GVariant *name = NULL;
     gsize n_children = 0;
     gsize i = 0;
     gchar **roles = NULL;
@@ -1386,35 +1913,25 @@ static BDLVMLVdata* get_lv_data_from_props (GVariant *props, GError **error G_GN
 
     /* returns an object path for the VG */
     g_variant_dict_lookup (&dict, "Vg", "o", &path);
-    name = get_object_property (path, VG_INTF, "Name", NULL);
+    data->vg_name = lookup_object_name (objs, path, VG_INTF);
     g_free (path);
-    g_variant_get (name, "s", &(data->vg_name));
-    g_variant_unref (name);
+    path = NULL;
 
     g_variant_dict_lookup (&dict, "OriginLv", "o", &path);
-    if (g_strcmp0 (path, "/") != 0) {
-        name = get_object_property (path, LV_CMN_INTF, "Name", NULL);
-        g_variant_get (name, "s", &(data->origin));
-        g_variant_unref (name);
-    }
+    if (g_strcmp0 (path, "/") != 0)
+        data->origin = lookup_object_name (objs, path, LV_CMN_INTF);
     g_free (path);
     path = NULL;
 
     g_variant_dict_lookup (&dict, "PoolLv", "o", &path);
-    if (g_strcmp0 (path, "/") != 0) {
-        name = get_object_property (path, LV_CMN_INTF, "Name", NULL);
-        g_variant_get (name, "s", &(data->pool_lv));
-        g_variant_unref (name);
-    }
+    if (g_strcmp0 (path, "/") != 0)
+        data->pool_lv = lookup_object_name (objs, path, LV_CMN_INTF);
     g_free (path);
     path = NULL;
 
     g_variant_dict_lookup (&dict, "MovePv", "o", &path);
-    if (path && g_strcmp0 (path, "/") != 0) {
-        name = get_object_property (path, PV_INTF, "Name", NULL);
-        g_variant_get (name, "s", &(data->move_pv));
-        g_variant_unref (name);
-    }
+    if (path && g_strcmp0 (path, "/") != 0)
+        data->move_pv = lookup_object_name (objs, path, PV_INTF);
     g_free (path);
     path = NULL;
 
@@ -1435,6 +1952,123 @@ static BDLVMLVdata* get_lv_data_from_props (GVariant *props, GError **error G_GN
     return data;
 }
 
+/**
+ * add_lv_related_data: (skip)
+ * @objs: (nullable): snapshot of the LVM objects to get the data from or %NULL
+ *                    to get it from lvmdbusd
+ * @obj_path: object path of the LV
+ * @data: data of the LV to fill
+ * @tree: whether to also fill the segs, data_lvs and metadata_lvs fields
+ *
+ * Fills the data_lv and metadata_lv fields of @data for pools (and the fields
+ * describing the LV tree if requested).
+ */
+static gboolean add_lv_related_data (LVMObjects *objs, const gchar *obj_path, BDLVMLVdata *data, gboolean tree, GError **error) {
+    GError *l_error = NULL;
+
+    if ((g_strcmp0 (data->segtype, "thin-pool") == 0) ||
+        (g_strcmp0 (data->segtype, "cache-pool") == 0)) {
+        data->data_lv = _lvm_data_lv_name (objs, obj_path, &l_error);
+        if (!l_error)
+            data->metadata_lv = _lvm_metadata_lv_name (objs, obj_path, &l_error);
+    } else if (g_strcmp0 (data->segtype, "vdo-pool") == 0)
+        data->data_lv = _lvm_data_lv_name (objs, obj_path, &l_error);
+
+    if (!l_error && tree) {
+        data->segs = _lvm_segs (objs, obj_path, &l_error);
+        if (!l_error)
+            _lvm_data_and_metadata_lvs (objs, obj_path, &data->data_lvs, &data->metadata_lvs, &l_error);
+    }
+
+    if (l_error) {
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static BDLVMPVdata** get_pvs_from_objects (LVMObjects *objs, GError **error) {
+    GPtrArray *pvs = g_ptr_array_new ();
+    GList *paths = NULL;
+    GVariant *props = NULL;
+
+    paths = lvm_objects_get_paths (objs, PV_OBJ_PREFIX);
+    for (GList *path = paths; path; path = g_list_next (path)) {
+        props = lvm_objects_get_props (objs, path->data, PV_INTF);
+        if (!props)
+            continue;
+        g_ptr_array_add (pvs, get_pv_data_from_props (props, objs, error));
+        g_variant_unref (props);
+    }
+    g_list_free (paths);
+
+    /* returning NULL-terminated array of BDLVMPVdata */
+    g_ptr_array_add (pvs, NULL);
+    return (BDLVMPVdata **) g_ptr_array_free (pvs, FALSE);
+}
+
+static BDLVMVGdata** get_vgs_from_objects (LVMObjects *objs, GError **error) {
+    GPtrArray *vgs = g_ptr_array_new ();
+    GList *paths = NULL;
+    GVariant *props = NULL;
+
+    paths = lvm_objects_get_paths (objs, VG_OBJ_PREFIX);
+    for (GList *path = paths; path; path = g_list_next (path)) {
+        props = lvm_objects_get_props (objs, path->data, VG_INTF);
+        if (!props)
+            continue;
+        g_ptr_array_add (vgs, get_vg_data_from_props (props, error));
+        g_variant_unref (props);
+    }
+    g_list_free (paths);
+
+    /* returning NULL-terminated array of BDLVMVGdata */
+    g_ptr_array_add (vgs, NULL);
+    return (BDLVMVGdata **) g_ptr_array_free (vgs, FALSE);
+}
+
+/* all types of objects lvmdbusd exports LVs as (in the order we list them) */
+static const gchar *const lv_obj_prefixes[] = {LV_OBJ_PREFIX, THIN_POOL_OBJ_PREFIX, CACHE_POOL_OBJ_PREFIX,
+                                               VDO_POOL_OBJ_PREFIX, HIDDEN_LV_OBJ_PREFIX, NULL};
+
+static BDLVMLVdata** get_lvs_from_objects (LVMObjects *objs, const gchar *vg_name, gboolean tree, GError **error) {
+    GPtrArray *lvs = g_ptr_array_new ();
+    GList *paths = NULL;
+    GVariant *props = NULL;
+    BDLVMLVdata *lvdata = NULL;
+
+    for (const gchar *const *prefix = lv_obj_prefixes; *prefix; prefix++) {
+        paths = lvm_objects_get_paths (objs, *prefix);
+        for (GList *path = paths; path; path = g_list_next (path)) {
+            props = lvm_objects_get_props (objs, path->data, LV_CMN_INTF);
+            if (!props)
+                continue;
+
+            /* consumes (frees) the 'props' parameter */
+            lvdata = get_lv_data_from_props (props, objs, error);
+            if (vg_name && g_strcmp0 (lvdata->vg_name, vg_name) != 0) {
+                bd_lvm_lvdata_free (lvdata);
+                continue;
+            }
+
+            if (!add_lv_related_data (objs, path->data, lvdata, tree, error)) {
+                bd_lvm_lvdata_free (lvdata);
+                g_list_free (paths);
+                g_ptr_array_set_free_func (lvs, (GDestroyNotify) bd_lvm_lvdata_free);
+                g_ptr_array_free (lvs, TRUE);
+                return NULL;
+            }
+            g_ptr_array_add (lvs, lvdata);
+        }
+        g_list_free (paths);
+    }
+
+    /* returning NULL-terminated array of BDLVMLVdata */
+    g_ptr_array_add (lvs, NULL);
+    return (BDLVMLVdata **) g_ptr_array_free (lvs, FALSE);
+}
+
 static BDLVMVDOPooldata* get_vdo_data_from_props (GVariant *props, GError **error G_GNUC_UNUSED) {
     BDLVMVDOPooldata *data = g_new0 (BDLVMVDOPooldata, 1);
     GVariantDict dict;
@@ -1758,7 +2392,7 @@ gboolean bd_lvm_pvcreate (const gchar *device, guint64 data_alignment, guint64 m
 
     params = g_variant_new ("(s)", device);
 
-    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvCreate", params, extra_params, extra, TRUE, error);
+    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvCreate", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -1784,7 +2418,7 @@ gboolean bd_lvm_pvresize (const gchar *device, guint64 size, const BDExtraArg **
         return FALSE;
 
     params = g_variant_new ("(t)", size);
-    return call_lvm_method_sync (obj_path, PV_INTF, "ReSize", params, NULL, extra, TRUE, error);
+    return call_lvm_method_sync (obj_path, PV_INTF, "ReSize", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -1818,7 +2452,7 @@ gboolean bd_lvm_pvremove (const gchar *device, const BDExtraArg **extra, GError
 
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
-    ret = call_lvm_obj_method_sync (device, PV_INTF, "Remove", NULL, params, extra, TRUE, &l_error);
+    ret = call_lvm_obj_method_sync (device, PV_INTF, "Remove", NULL, params, extra, NULL, &l_error);
     if (!ret && l_error && g_error_matches (l_error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST)) {
         /* if the object doesn't exist, the given device is not a PV and thus
            this function should be a noop */
@@ -1899,7 +2533,7 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_method_sync (vg_obj_path, VG_INTF, "Move", params, NULL, extra, TRUE, error);
+    ret = call_lvm_method_sync (vg_obj_path, VG_INTF, "Move", params, NULL, extra, NULL, error);
 
     g_free (src_path);
     g_free (dest_path);
@@ -1907,6 +2541,80 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
     return ret;
 }
 
+/**
+ * bd_lvm_pvmove_start:
+ * @src: the PV device to move extents off of
+ * @dest: (nullable): the PV device to move extents onto or %NULL
+ * @extra: (nullable) (array zero-terminated=1): extra options for the PV move
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): a job representing the running move or %NULL in case of error
+ *
+ * Background moves are not supported by this plugin implementation, use
+ * bd_lvm_pvmove() instead.
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+BDLVMPVMoveJob* bd_lvm_pvmove_start (const gchar *src G_GNUC_UNUSED, const gchar *dest G_GNUC_UNUSED, const BDExtraArg **extra G_GNUC_UNUSED, GError **error) {
+    g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_TECH_UNAVAIL,
+                 "Background pvmove is not supported by this plugin implementation.");
+    return NULL;
+}
+
+/**
+ * bd_lvm_pvmove_job_get_progress:
+ * @job: a job started with bd_lvm_pvmove_start()
+ * @progress: (out): place to store the progress of the move (in percents)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * The progress is taken directly from the status of the DM maps of the move,
+ * no LVM command is run. Once the move is not running anymore (finished or
+ * aborted, see #BDLVMPVMoveJob.aborted), the progress is 100.
+ *
+ * Returns: whether the progress was successfully determined or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pvmove_job_get_progress (BDLVMPVMoveJob *job, gdouble *progress, GError **error) {
+    return pvmove_job_get_progress (job, progress, error);
+}
+
+/**
+ * bd_lvm_pvmove_job_abort:
+ * @job: a job started with bd_lvm_pvmove_start()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the move was successfully aborted or not
+ *
+ * Background moves are not supported by this plugin implementation.
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_job_abort (BDLVMPVMoveJob *job G_GNUC_UNUSED, GError **error) {
+    g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_TECH_UNAVAIL,
+                 "Background pvmove is not supported by this plugin implementation.");
+    return FALSE;
+}
+
+/**
+ * bd_lvm_pvmove_set_throttle:
+ * @percent: percentage of time (1 -- 100) the copying of the data is allowed to take
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Limits the share of time the kernel spends copying the data of the moves
+ * (and synchronizing mirrors) so that the other I/O is not affected too much.
+ * The limit is system-wide (it's the 'raid1_resync_throttle' parameter of the
+ * dm_mirror kernel module), use 100 to disable the throttling.
+ *
+ * Returns: whether the throttle was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_set_throttle (guint percent, GError **error) {
+    return pvmove_set_throttle (percent, error);
+}
+
 /**
  * bd_lvm_pvscan:
  * @device: (nullable): the device to scan for PVs or %NULL
@@ -1948,7 +2656,7 @@ gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtr
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvScan", params, NULL, extra, TRUE, error);
+    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "PvScan", params, NULL, extra, NULL, error);
 }
 
 
@@ -1977,7 +2685,7 @@ static gboolean _manage_lvm_tags (const gchar *objpath, const gchar *pv_path, co
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_method_sync (objpath, intf, func, params, NULL, NULL, TRUE, error);
+    ret = call_lvm_method_sync (objpath, intf, func, params, NULL, NULL, NULL, error);
     g_free (tags_array);
     return ret;
 }
@@ -2076,7 +2784,7 @@ BDLVMPVdata* bd_lvm_pvinfo (const gchar *device, GError **error) {
         /* the error is already populated */
         return NULL;
 
-    ret = get_pv_data_from_props (props, error);
+    ret = get_pv_data_from_props (props, NULL, error);
     g_variant_unref (props);
 
     return ret;
@@ -2091,48 +2799,17 @@ BDLVMPVdata* bd_lvm_pvinfo (const gchar *device, GError **error) {
  * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
  */
 BDLVMPVdata** bd_lvm_pvs (GError **error) {
-    gchar **objects = NULL;
-    guint64 n_pvs = 0;
-    GVariant *props = NULL;
+    LVMObjects *objs = NULL;
     BDLVMPVdata **ret = NULL;
-    guint64 i = 0;
-    GError *l_error = NULL;
-
-    objects = get_existing_objects (PV_OBJ_PREFIX, &l_error);
-    if (!objects) {
-        if (!l_error) {
-            /* no PVs */
-            ret = g_new0 (BDLVMPVdata*, 1);
-            ret[0] = NULL;
-            return ret;
-        } else {
-            g_propagate_error (error, l_error);
-            return NULL;
-        }
-    }
 
-    n_pvs = g_strv_length ((gchar **) objects);
+    objs = get_lvm_objects_snapshot (error);
+    if (!objs)
+        /* the error is already populated */
+        return NULL;
 
-    /* now create the return value -- NULL-terminated array of BDLVMPVdata */
-    ret = g_new0 (BDLVMPVdata*, n_pvs + 1);
-    for (i=0; i < n_pvs; i++) {
-        props = get_object_properties (objects[i], PV_INTF, error);
-        if (!props) {
-            g_strfreev (objects);
-            g_free (ret);
-            return NULL;
-        }
-        ret[i] = get_pv_data_from_props (props, error);
-        g_variant_unref (props);
-        if (!(ret[i])) {
-            g_strfreev (objects);
-            g_free (ret);
-            return NULL;
-        }
-    }
-    ret[i] = NULL;
+    ret = get_pvs_from_objects (objs, error);
+    lvm_objects_unref (objs);
 
-    g_strfreev (objects);
     return ret;
 }
 
@@ -2184,7 +2861,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
     extra_params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "VgCreate", params, extra_params, extra, TRUE, error);
+    return call_lvm_method_sync (MANAGER_OBJ, MANAGER_INTF, "VgCreate", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2199,7 +2876,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
  * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_REMOVE
  */
 gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Remove", NULL, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Remove", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -2216,7 +2893,7 @@ gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError
  */
 gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(s)", new_vg_name);
-    return call_lvm_obj_method_sync (old_vg_name, VG_INTF, "Rename", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (old_vg_name, VG_INTF, "Rename", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2232,7 +2909,7 @@ gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, co
  */
 gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(t)", (guint64) 0);
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Activate", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Activate", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2248,7 +2925,7 @@ gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GErr
  */
 gboolean bd_lvm_vgdeactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(t)", (guint64) 0);
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Deactivate", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Deactivate", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2276,7 +2953,7 @@ gboolean bd_lvm_vgextend (const gchar *vg_name, const gchar *device, const BDExt
     pv_var = g_variant_new ("o", pv);
     pvs = g_variant_new_array (NULL, &pv_var, 1);
     params = g_variant_new_tuple (&pvs, 1);
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Extend", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Extend", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2332,7 +3009,7 @@ gboolean bd_lvm_vgreduce (const gchar *vg_name, const gchar *device, const BDExt
         g_variant_builder_clear (&builder);
     }
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Reduce", params, extra_params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Reduce", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2383,7 +3060,7 @@ static gboolean _vglock_start_stop (const gchar *vg_name, gboolean start, const
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Change", NULL, params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "Change", NULL, params, extra, NULL, error);
 }
 
 /**
@@ -2450,48 +3127,17 @@ BDLVMVGdata* bd_lvm_vginfo (const gchar *vg_name, GError **error) {
  * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
  */
 BDLVMVGdata** bd_lvm_vgs (GError **error) {
-    gchar **objects = NULL;
-    guint64 n_vgs = 0;
-    GVariant *props = NULL;
+    LVMObjects *objs = NULL;
     BDLVMVGdata **ret = NULL;
-    guint64 i = 0;
-    GError *l_error = NULL;
-
-    objects = get_existing_objects (VG_OBJ_PREFIX, &l_error);
-    if (!objects) {
-        if (!l_error) {
-            /* no VGs */
-            ret = g_new0 (BDLVMVGdata*, 1);
-            ret[0] = NULL;
-            return ret;
-        } else {
-            g_propagate_error (error, l_error);
-            return NULL;
-        }
-    }
 
-    n_vgs = g_strv_length ((gchar **) objects);
+    objs = get_lvm_objects_snapshot (error);
+    if (!objs)
+        /* the error is already populated */
+        return NULL;
 
-    /* now create the return value -- NULL-terminated array of BDLVMVGdata */
-    ret = g_new0 (BDLVMVGdata*, n_vgs + 1);
-    for (i=0; i < n_vgs; i++) {
-        props = get_object_properties (objects[i], VG_INTF, error);
-        if (!props) {
-            g_strfreev (objects);
-            g_free (ret);
-            return NULL;
-        }
-        ret[i] = get_vg_data_from_props (props, error);
-        g_variant_unref (props);
-        if (!(ret[i])) {
-            g_strfreev (objects);
-            g_free (ret);
-            return NULL;
-        }
-    }
-    ret[i] = NULL;
+    ret = get_vgs_from_objects (objs, error);
+    lvm_objects_unref (objs);
 
-    g_strfreev (objects);
     return ret;
 }
 
@@ -2597,7 +3243,7 @@ gboolean bd_lvm_lvcreate (const gchar *vg_name, const gchar *lv_name, guint64 si
         g_variant_builder_clear (&builder);
     }
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreate", params, extra_params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreate", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2626,7 +3272,7 @@ gboolean bd_lvm_lvremove (const gchar *vg_name, const gchar *lv_name, gboolean f
     extra_params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lv_method_sync (vg_name, lv_name, "Remove", NULL, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Remove", NULL, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2647,7 +3293,7 @@ gboolean bd_lvm_lvrename (const gchar *vg_name, const gchar *lv_name, const gcha
     GVariant *params = NULL;
 
     params = g_variant_new ("(s)", new_name);
-    return call_lv_method_sync (vg_name, lv_name, "Rename", params, NULL, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Rename", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2690,7 +3336,7 @@ gboolean bd_lvm_lvresize (const gchar *vg_name, const gchar *lv_name, guint64 si
       g_variant_builder_clear (&builder);
     }
 
-    return call_lv_method_sync (vg_name, lv_name, "Resize", params, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Resize", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2745,7 +3391,7 @@ gboolean bd_lvm_lvactivate (const gchar *vg_name, const gchar *lv_name, gboolean
         g_variant_builder_clear (&builder);
     }
 
-    return call_lv_method_sync (vg_name, lv_name, "Activate", params, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Activate", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -2762,7 +3408,177 @@ gboolean bd_lvm_lvactivate (const gchar *vg_name, const gchar *lv_name, gboolean
  */
 gboolean bd_lvm_lvdeactivate (const gchar *vg_name, const gchar *lv_name, const BDExtraArg **extra, GError **error) {
     GVariant *params = g_variant_new ("(t)", (guint64) 0);
-    return call_lv_method_sync (vg_name, lv_name, "Deactivate", params, NULL, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, lv_name, "Deactivate", params, NULL, extra, NULL, error);
+}
+
+typedef struct LVActivateTask {
+    const gchar *lv_id;
+    gboolean activate;
+    gboolean ignore_skip;
+    gboolean shared;
+    const BDExtraArg **extra;
+    GError *error;
+} LVActivateTask;
+
+static void lv_activate_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    LVActivateTask *task = (LVActivateTask *) data;
+    g_autofree gchar *vg_name = NULL;
+    const gchar *lv_name = NULL;
+
+    lv_name = strchr (task->lv_id, '/');
+    vg_name = g_strndup (task->lv_id, lv_name - task->lv_id);
+    lv_name++;
+
+    if (task->activate)
+        bd_lvm_lvactivate (vg_name, lv_name, task->ignore_skip, task->shared, task->extra, &(task->error));
+    else
+        bd_lvm_lvdeactivate (vg_name, lv_name, task->extra, &(task->error));
+}
+
+static gboolean lv_has_tag (BDLVMLVdata *lv, const gchar *tag) {
+    gchar **tag_p = NULL;
+
+    for (tag_p = lv->lv_tags; tag_p && *tag_p; tag_p++)
+        if (g_strcmp0 (*tag_p, tag) == 0)
+            return TRUE;
+
+    return FALSE;
+}
+
+/* translates the VG names and tags in @lv_specs into the "VG/LV" IDs of the LVs */
+static GPtrArray* expand_lv_specs (const gchar **lv_specs, GError **error) {
+    GPtrArray *lv_ids = g_ptr_array_new_with_free_func (g_free);
+    BDLVMLVdata **lvs = NULL;
+    BDLVMLVdata **lv_p = NULL;
+    const gchar **spec_p = NULL;
+    gboolean match = FALSE;
+
+    for (spec_p = lv_specs; *spec_p; spec_p++) {
+        if (strchr (*spec_p, '/')) {
+            g_ptr_array_add (lv_ids, g_strdup (*spec_p));
+            continue;
+        }
+
+        /* VG name or tag, need the list of the LVs (just once) */
+        if (!lvs) {
+            lvs = bd_lvm_lvs (NULL, error);
+            if (!lvs) {
+                g_ptr_array_free (lv_ids, TRUE);
+                return NULL;
+            }
+        }
+
+        for (lv_p = lvs; *lv_p; lv_p++) {
+            /* internal LVs are activated together with their top-level LVs */
+            if ((*lv_p)->lv_name[0] == '[')
+                continue;
+            if (**spec_p == '@')
+                match = lv_has_tag (*lv_p, *spec_p + 1);
+            else
+                match = g_strcmp0 ((*lv_p)->vg_name, *spec_p) == 0;
+            if (match)
+                g_ptr_array_add (lv_ids, g_strdup_printf ("%s/%s", (*lv_p)->vg_name, (*lv_p)->lv_name));
+        }
+    }
+
+    if (lvs) {
+        for (lv_p = lvs; *lv_p; lv_p++)
+            bd_lvm_lvdata_free (*lv_p);
+        g_free (lvs);
+    }
+
+    return lv_ids;
+}
+
+/* runs the (de)activations of the @lv_specs LVs as concurrent method calls,
+ * reports the first error (if any) */
+static gboolean lvs_change_activation (const gchar **lv_specs, gboolean activate, gboolean ignore_skip, gboolean shared,
+                                       const BDExtraArg **extra, GError **error) {
+    GPtrArray *lv_ids = NULL;
+    LVActivateTask *tasks = NULL;
+    guint num_failed = 0;
+    guint i = 0;
+
+    if (!lv_specs || !(*lv_specs))
+        return TRUE;
+
+    lv_ids = expand_lv_specs (lv_specs, error);
+    if (!lv_ids)
+        return FALSE;
+
+    tasks = g_new0 (LVActivateTask, lv_ids->len);
+    for (i = 0; i < lv_ids->len; i++) {
+        tasks[i].lv_id = lv_ids->pdata[i];
+        tasks[i].activate = activate;
+        tasks[i].ignore_skip = ignore_skip;
+        tasks[i].shared = shared;
+        tasks[i].extra = extra;
+    }
+
+    bd_utils_parallel_run_array (lv_activate_thread, tasks, sizeof (LVActivateTask), lv_ids->len, 0, NULL);
+
+    for (i = 0; i < lv_ids->len; i++) {
+        if (!tasks[i].error)
+            continue;
+        if (num_failed == 0)
+            g_propagate_error (error, tasks[i].error);
+        else
+            g_clear_error (&(tasks[i].error));
+        num_failed++;
+    }
+    if (num_failed > 0)
+        g_prefix_error (error, "Failed to %s %u of %u LVs: ", activate ? "activate" : "deactivate",
+                        num_failed, lv_ids->len);
+
+    g_free (tasks);
+    g_ptr_array_free (lv_ids, TRUE);
+
+    return num_failed == 0;
+}
+
+/**
+ * bd_lvm_lvactivate_many:
+ * @lv_specs: (array zero-terminated=1): LVs to activate, each item can be a
+ *            "VG/LV" name of an LV, a name of a VG (all its LVs are activated)
+ *            or a tag prefixed with '@' (all LVs with the tag are activated)
+ * @ignore_skip: whether to ignore the skip flag or not
+ * @shared: whether to activate the LVs in shared mode (used for shared LVM setups with lvmlockd,
+ *          use %FALSE if not sure)
+ * @extra: (nullable) (array zero-terminated=1): extra options for the LV activation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Activates all the LVs specified by @lv_specs. The activations are run as
+ * concurrent method calls, a failure of one of them doesn't stop the others
+ * (the first error is reported). Nothing is done if @lv_specs is empty.
+ *
+ * Returns: whether the LVs were successfully activated or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_lvactivate_many (const gchar **lv_specs, gboolean ignore_skip, gboolean shared, const BDExtraArg **extra, GError **error) {
+    return lvs_change_activation (lv_specs, TRUE, ignore_skip, shared, extra, error);
+}
+
+/**
+ * bd_lvm_lvdeactivate_many:
+ * @lv_specs: (array zero-terminated=1): LVs to deactivate, each item can be a
+ *            "VG/LV" name of an LV, a name of a VG (all its LVs are deactivated)
+ *            or a tag prefixed with '@' (all LVs with the tag are deactivated)
+ * @extra: (nullable) (array zero-terminated=1): extra options for the LV deactivation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Deactivates all the LVs specified by @lv_specs. The deactivations are run as
+ * concurrent method calls, a failure of one of them doesn't stop the others
+ * (the first error is reported). Nothing is done if @lv_specs is empty.
+ *
+ * Returns: whether the LVs were successfully deactivated or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_lvdeactivate_many (const gchar **lv_specs, const BDExtraArg **extra, GError **error) {
+    return lvs_change_activation (lv_specs, FALSE, FALSE, FALSE, extra, error);
 }
 
 /**
@@ -2790,7 +3606,7 @@ gboolean bd_lvm_lvsnapshotcreate (const gchar *vg_name, const gchar *origin_name
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, NULL, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -2816,7 +3632,7 @@ gboolean bd_lvm_lvsnapshotmerge (const gchar *vg_name, const gchar *snapshot_nam
     if (!obj_path)
         return FALSE;
 
-    return call_lvm_method_sync (obj_path, SNAP_INTF, "Merge", NULL, NULL, extra, TRUE, error);
+    return call_lvm_method_sync (obj_path, SNAP_INTF, "Merge", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -2867,123 +3683,174 @@ gboolean bd_lvm_delete_lv_tags (const gchar *vg_name, const gchar *lv_name, cons
     return _manage_lvm_tags (obj_path, NULL, LV_INTF, tags, "TagsDel", error);
 }
 
+static gboolean run_batch_op (const BDLVMBatchOp *op, GError **error) {
+    if (!op->vg_name || !op->lv_name) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "The VG and LV names need to be specified for a batch operation");
+        return FALSE;
+    }
+
+    switch (op->type) {
+        case BD_LVM_BATCH_OP_LV_RENAME:
+            if (!op->new_name) {
+                g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                             "No new name specified for renaming '%s/%s'", op->vg_name, op->lv_name);
+                return FALSE;
+            }
+            return bd_lvm_lvrename (op->vg_name, op->lv_name, op->new_name, NULL, error);
+        case BD_LVM_BATCH_OP_LV_ADD_TAGS:
+        case BD_LVM_BATCH_OP_LV_DELETE_TAGS:
+            if (!op->tags) {
+                g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                             "No tags specified for '%s/%s'", op->vg_name, op->lv_name);
+                return FALSE;
+            }
+            if (op->type == BD_LVM_BATCH_OP_LV_ADD_TAGS)
+                return bd_lvm_add_lv_tags (op->vg_name, op->lv_name, (const gchar **) op->tags, error);
+            else
+                return bd_lvm_delete_lv_tags (op->vg_name, op->lv_name, (const gchar **) op->tags, error);
+        default:
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                         "Unknown batch operation type: %d", op->type);
+            return FALSE;
+    }
+}
+
+typedef struct BatchTask {
+    const BDLVMBatchOp *op;
+    BDLVMBatchResult *result;
+} BatchTask;
+
+static void batch_op_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    BatchTask *task = (BatchTask *) data;
+
+    task->result->success = run_batch_op (task->op, &(task->result->error));
+}
+
 /**
- * bd_lvm_lvinfo:
- * @vg_name: name of the VG that contains the LV to get information about
- * @lv_name: name of the LV to get information about
+ * bd_lvm_batch_run:
+ * @ops: (array zero-terminated=1): operations to run
+ * @max_workers: maximum number of operations to run in parallel or 0 for the default (16)
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: (transfer full): information about the @vg_name/@lv_name LV or %NULL in case
- * of error (the @error) gets populated in those cases)
+ * Runs all the independent operations from @ops. A failure of one of the
+ * operations doesn't affect the others, it is reported in the
+ * #BDLVMBatchResult.error field of the particular result.
  *
- * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ * The method calls are issued from multiple threads at the same time and so
+ * they are all in flight on the D-Bus connection together, the jobs started
+ * by lvmdbusd are waited for in parallel too.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the @ops (one
+ *                                                     entry per operation in the same
+ *                                                     order as in @ops) or %NULL in
+ *                                                     case of error
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
  */
-BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError **error) {
-    GVariant *props = NULL;
-    BDLVMLVdata* ret = NULL;
+BDLVMBatchResult** bd_lvm_batch_run (const BDLVMBatchOp **ops, guint max_workers, GError **error) {
+    BDLVMBatchResult **ret = NULL;
+    BatchTask *tasks = NULL;
+    guint num_ops = 0;
 
-    props = get_lv_properties (vg_name, lv_name, error);
-    if (!props)
-        /* the error is already populated */
+    if (!ops) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "No operations specified");
         return NULL;
+    }
 
-    ret = get_lv_data_from_props (props, error);
-    if (!ret)
-        return NULL;
-
-    if (g_strcmp0 (ret->segtype, "thin-pool") == 0 ||
-        g_strcmp0 (ret->segtype, "cache-pool") == 0) {
-        ret->data_lv = _lvm_data_lv_name (vg_name, lv_name, NULL);
-        ret->metadata_lv = _lvm_metadata_lv_name (vg_name, lv_name, NULL);
-    }
-    if (g_strcmp0 (ret->segtype, "vdo-pool") == 0) {
-        ret->data_lv = _lvm_data_lv_name (vg_name, lv_name, NULL);
+    for (num_ops = 0; ops[num_ops]; num_ops++);
+    ret = g_new0 (BDLVMBatchResult *, num_ops + 1);
+    tasks = g_new0 (BatchTask, num_ops);
+    for (guint i = 0; i < num_ops; i++) {
+        ret[i] = g_new0 (BDLVMBatchResult, 1);
+        tasks[i].op = ops[i];
+        tasks[i].result = ret[i];
     }
 
+    if (max_workers == 0)
+        max_workers = BATCH_DEFAULT_WORKERS;
+    bd_utils_parallel_run_array (batch_op_thread, tasks, sizeof (BatchTask), num_ops, max_workers, NULL);
+
+    g_free (tasks);
     return ret;
 }
 
-BDLVMLVdata* bd_lvm_lvinfo_tree (const gchar *vg_name, const gchar *lv_name, GError **error) {
+/**
+ * bd_lvm_lvinfo:
+ * @vg_name: name of the VG that contains the LV to get information about
+ * @lv_name: name of the LV to get information about
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): information about the @vg_name/@lv_name LV or %NULL in case
+ * of error (the @error) gets populated in those cases)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError **error) {
+    gchar *lv_spec = NULL;
+    gchar *obj_path = NULL;
     GVariant *props = NULL;
     BDLVMLVdata* ret = NULL;
 
-    props = get_lv_properties (vg_name, lv_name, error);
-    if (!props)
+    lv_spec = g_strdup_printf ("%s/%s", vg_name, lv_name);
+    obj_path = get_object_path (lv_spec, error);
+    g_free (lv_spec);
+    if (!obj_path)
         /* the error is already populated */
         return NULL;
 
-    ret = get_lv_data_from_props (props, error);
-    if (!ret)
+    props = get_object_properties (obj_path, LV_CMN_INTF, error);
+    if (!props) {
+        /* the error is already populated */
+        g_free (obj_path);
         return NULL;
-
-    if (g_strcmp0 (ret->segtype, "thin-pool") == 0 ||
-        g_strcmp0 (ret->segtype, "cache-pool") == 0) {
-        ret->data_lv = _lvm_data_lv_name (vg_name, lv_name, NULL);
-        ret->metadata_lv = _lvm_metadata_lv_name (vg_name, lv_name, NULL);
     }
-    if (g_strcmp0 (ret->segtype, "vdo-pool") == 0) {
-        ret->data_lv = _lvm_data_lv_name (vg_name, lv_name, NULL);
-    }
-    ret->segs = _lvm_segs (vg_name, lv_name, NULL);
-    _lvm_data_and_metadata_lvs (vg_name, lv_name, &ret->data_lvs, &ret->metadata_lvs, NULL);
 
-    return ret;
-}
-
-static gchar* get_lv_vg_name (const gchar *lv_obj_path, GError **error) {
-    GVariant *value = NULL;
-    gchar *vg_obj_path = NULL;
-    gchar *ret = NULL;
-
-    value = get_object_property (lv_obj_path, LV_CMN_INTF, "Vg", error);
-    g_variant_get (value, "o", &vg_obj_path);
-    g_variant_unref (value);
+    /* consumes (frees) the 'props' parameter */
+    ret = get_lv_data_from_props (props, NULL, error);
+    if (!ret) {
+        g_free (obj_path);
+        return NULL;
+    }
 
-    value = get_object_property (vg_obj_path, VG_INTF, "Name", error);
-    g_variant_get (value, "s", &ret);
-    g_free (vg_obj_path);
-    g_variant_unref (value);
+    add_lv_related_data (NULL, obj_path, ret, FALSE, NULL);
+    g_free (obj_path);
 
     return ret;
 }
 
-/**
- * filter_lvs_by_vg: (skip)
- *
- * Filter LVs by VG name and prepend the matching ones to the @out list.
- */
-static gboolean filter_lvs_by_vg (gchar **lvs, const gchar *vg_name, GSList **out, guint64 *n_lvs, GError **error) {
-    gchar **lv_p = NULL;
-    gchar *lv_vg_name = NULL;
-    gboolean success = TRUE;
-
-    if (!lvs)
-        /* nothing to do */
-        return TRUE;
+BDLVMLVdata* bd_lvm_lvinfo_tree (const gchar *vg_name, const gchar *lv_name, GError **error) {
+    gchar *lv_spec = NULL;
+    gchar *obj_path = NULL;
+    GVariant *props = NULL;
+    BDLVMLVdata* ret = NULL;
 
-    for (lv_p=lvs; *lv_p; lv_p++) {
-        if (vg_name) {
-            lv_vg_name = get_lv_vg_name (*lv_p, error);
-            if (!lv_vg_name) {
-                g_free (*lv_p);
-                success = FALSE;
-                continue;
-            }
+    lv_spec = g_strdup_printf ("%s/%s", vg_name, lv_name);
+    obj_path = get_object_path (lv_spec, error);
+    g_free (lv_spec);
+    if (!obj_path)
+        /* the error is already populated */
+        return NULL;
 
-            if (g_strcmp0 (lv_vg_name, vg_name) == 0) {
-                *out = g_slist_prepend (*out, *lv_p);
-                (*n_lvs)++;
-            } else {
-                g_free (*lv_p);
-            }
+    props = get_object_properties (obj_path, LV_CMN_INTF, error);
+    if (!props) {
+        /* the error is already populated */
+        g_free (obj_path);
+        return NULL;
+    }
 
-            g_free (lv_vg_name);
-        } else {
-            *out = g_slist_prepend (*out, *lv_p);
-            (*n_lvs)++;
-        }
+    /* consumes (frees) the 'props' parameter */
+    ret = get_lv_data_from_props (props, NULL, error);
+    if (!ret) {
+        g_free (obj_path);
+        return NULL;
     }
-    return success;
+
+    add_lv_related_data (NULL, obj_path, ret, TRUE, NULL);
+    g_free (obj_path);
+
+    return ret;
 }
 
 /**
@@ -2997,268 +3864,173 @@ static gboolean filter_lvs_by_vg (gchar **lvs, const gchar *vg_name, GSList **ou
  * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
  */
 BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error) {
-    gchar **lvs = NULL;
-    guint64 n_lvs = 0;
-    GVariant *props = NULL;
+    LVMObjects *objs = NULL;
     BDLVMLVdata **ret = NULL;
-    guint64 j = 0;
-    GSList *matched_lvs = NULL;
-    GSList *lv = NULL;
-    gboolean success = FALSE;
-    GError *l_error = NULL;
 
-    lvs = get_existing_objects (LV_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
+    objs = get_lvm_objects_snapshot (error);
+    if (!objs)
+        /* the error is already populated */
         return NULL;
-    }
 
-    lvs = get_existing_objects (THIN_POOL_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
+    ret = get_lvs_from_objects (objs, vg_name, FALSE, error);
+    lvm_objects_unref (objs);
 
-    lvs = get_existing_objects (CACHE_POOL_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
+    return ret;
+}
 
-    lvs = get_existing_objects (VDO_POOL_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
+BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
+    LVMObjects *objs = NULL;
+    BDLVMLVdata **ret = NULL;
 
-    lvs = get_existing_objects (HIDDEN_LV_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
+    objs = get_lvm_objects_snapshot (error);
+    if (!objs)
+        /* the error is already populated */
         return NULL;
-    }
 
-    if (n_lvs == 0) {
-        /* no LVs */
-        ret = g_new0 (BDLVMLVdata*, 1);
-        ret[0] = NULL;
-        g_slist_free_full (matched_lvs, g_free);
-        return ret;
-    }
+    ret = get_lvs_from_objects (objs, vg_name, TRUE, error);
+    lvm_objects_unref (objs);
 
-    /* we have been prepending to the list so far, but it will be nicer if we
-       reverse it (to get back the original order) */
-    matched_lvs = g_slist_reverse (matched_lvs);
+    return ret;
+}
 
-    /* now create the return value -- NULL-terminated array of BDLVMLVdata */
-    ret = g_new0 (BDLVMLVdata*, n_lvs + 1);
+/**
+ * bd_lvm_lvs_tree_result_set:
+ * @vg_name: (nullable): name of the VG to get information about LVs from
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets the same information as bd_lvm_lvs_tree(), but as one result set --
+ * all the records, arrays and strings live in one block of memory which is
+ * freed at once with the set. This is much cheaper than a list of separately
+ * allocated %BDLVMLVdata for big numbers of LVs. Use bd_lvm_lvdata_copy() on
+ * the items of the set to keep them around without the set.
+ *
+ * Returns: (transfer full): information about LVs found in the given @vg_name
+ * VG or in system if @vg_name is %NULL
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMLVResultSet* bd_lvm_lvs_tree_result_set (const gchar *vg_name, GError **error) {
+    BDLVMLVdata **lvs = NULL;
 
-    lv = matched_lvs;
-    while (lv) {
-        props = get_object_properties (lv->data, LV_CMN_INTF, &l_error);
-        if (!props) {
-            g_slist_free_full (matched_lvs, g_free);
-            g_free (ret);
-            g_propagate_error (error, l_error);
-            return NULL;
-        }
-        ret[j] = get_lv_data_from_props (props, &l_error);
-        if (!(ret[j])) {
-            g_slist_free_full (matched_lvs, g_free);
-            for (guint64 i = 0; i < j; i++)
-                bd_lvm_lvdata_free (ret[i]);
-            g_free (ret);
-            g_propagate_error (error, l_error);
-            return NULL;
-        } else if ((g_strcmp0 (ret[j]->segtype, "thin-pool") == 0) ||
-                   (g_strcmp0 (ret[j]->segtype, "cache-pool") == 0)) {
-            ret[j]->data_lv = _lvm_data_lv_name (ret[j]->vg_name, ret[j]->lv_name, &l_error);
-            ret[j]->metadata_lv = _lvm_metadata_lv_name (ret[j]->vg_name, ret[j]->lv_name, &l_error);
-        } else if (g_strcmp0 (ret[j]->segtype, "vdo-pool") == 0) {
-            ret[j]->data_lv = _lvm_data_lv_name (ret[j]->vg_name, ret[j]->lv_name, &l_error);
-        }
-        if (l_error) {
-            g_slist_free_full (matched_lvs, g_free);
-            for (guint64 i = 0; i <= j; i++)
-                bd_lvm_lvdata_free (ret[i]);
-            g_free (ret);
-            g_propagate_error (error, l_error);
-            return NULL;
-        }
-        j++;
-        lv = g_slist_next (lv);
-    }
-    g_slist_free_full (matched_lvs, g_free);
+    lvs = bd_lvm_lvs_tree (vg_name, error);
+    if (!lvs)
+        /* the error is already populated */
+        return NULL;
 
-    ret[j] = NULL;
-    return ret;
+    return lv_result_set_new (lvs);
 }
 
-BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
-    gchar **lvs = NULL;
-    guint64 n_lvs = 0;
+/**
+ * bd_lvm_lv_result_set_get:
+ * @set: result set to get the LV from
+ * @index: index of the LV in @set
+ *
+ * Returns: (transfer none) (nullable): information about the @index-th LV in
+ * @set or %NULL if @index is out of range, the data is owned by @set
+ *
+ * Tech category: always available
+ */
+const BDLVMLVdata* bd_lvm_lv_result_set_get (BDLVMLVResultSet *set, guint index) {
+    if (index >= set->n_lvs)
+        return NULL;
+
+    return set->lvs[index];
+}
+
+/**
+ * bd_lvm_lvs_foreach:
+ * @vg_name: (nullable): name of the VG to get information about LVs from
+ * @func: (scope call): function to call for every LV found
+ * @user_data: (closure): data to pass to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Calls @func for every LV found in the given @vg_name VG or in system if
+ * @vg_name is %NULL (the same LVs bd_lvm_lvs() returns) as soon as the
+ * information about it is parsed. The information is only valid during the
+ * call of @func, use bd_lvm_lvdata_copy() to keep it. If @func returns %FALSE,
+ * no more LVs are reported.
+ *
+ * Returns: whether the LVs were successfully listed or not (stopping the
+ *          listing from @func is not an error)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_lvs_foreach (const gchar *vg_name, BDLVMLVdataFunc func, gpointer user_data, GError **error) {
+    LVMObjects *objs = NULL;
+    GList *prefix_paths = NULL;
     GVariant *props = NULL;
-    BDLVMLVdata **ret = NULL;
-    guint64 j = 0;
-    GSList *matched_lvs = NULL;
-    GSList *lv = NULL;
-    gboolean success = FALSE;
-    GError *l_error = NULL;
+    BDLVMLVdata *lvdata = NULL;
+    gboolean cont = TRUE;
+    gboolean success = TRUE;
 
-    lvs = get_existing_objects (LV_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
+    objs = get_lvm_objects_snapshot (error);
+    if (!objs)
+        /* the error is already populated */
+        return FALSE;
 
-    lvs = get_existing_objects (THIN_POOL_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
+    /* the LVs' data are created one by one from the snapshot, no lock is held
+       when @func is called so it can use the other functions of the plugin */
+    for (const gchar *const *prefix = lv_obj_prefixes; cont && success && *prefix; prefix++) {
+        prefix_paths = lvm_objects_get_paths (objs, *prefix);
+        for (GList *path = prefix_paths; cont && success && path; path = g_list_next (path)) {
+            props = lvm_objects_get_props (objs, path->data, LV_CMN_INTF);
+            if (!props)
+                continue;
 
-    lvs = get_existing_objects (CACHE_POOL_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
+            /* consumes (frees) the 'props' parameter */
+            lvdata = get_lv_data_from_props (props, objs, error);
+            if (vg_name && g_strcmp0 (lvdata->vg_name, vg_name) != 0) {
+                bd_lvm_lvdata_free (lvdata);
+                continue;
+            }
 
-    lvs = get_existing_objects (VDO_POOL_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
+            success = add_lv_related_data (objs, path->data, lvdata, FALSE, error);
+            if (success)
+                cont = func (lvdata, user_data);
+            bd_lvm_lvdata_free (lvdata);
+        }
+        g_list_free (prefix_paths);
     }
+    lvm_objects_unref (objs);
 
-    lvs = get_existing_objects (HIDDEN_LV_OBJ_PREFIX, &l_error);
-    if (!lvs && l_error) {
-        g_propagate_error (error, l_error);
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
-    success = filter_lvs_by_vg (lvs, vg_name, &matched_lvs, &n_lvs, error);
-    g_free (lvs);
-    if (!success) {
-        g_slist_free_full (matched_lvs, g_free);
-        return NULL;
-    }
+    return success;
+}
 
-    if (n_lvs == 0) {
-        /* no LVs */
-        ret = g_new0 (BDLVMLVdata*, 1);
-        ret[0] = NULL;
-        g_slist_free_full (matched_lvs, g_free);
-        return ret;
-    }
+/**
+ * bd_lvm_report_all:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets information about all PVs, VGs and LVs (including their segments) in
+ * the system. The LVs have the data_lvs, metadata_lvs, and segs fields filled
+ * (see bd_lvm_lvs_tree()).
+ *
+ * Returns: (transfer full): information about all PVs, VGs and LVs found in
+ * the system or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMReportdata* bd_lvm_report_all (GError **error) {
+    LVMObjects *objs = NULL;
+    BDLVMReportdata *data = NULL;
 
-    /* we have been prepending to the list so far, but it will be nicer if we
-       reverse it (to get back the original order) */
-    matched_lvs = g_slist_reverse (matched_lvs);
+    /* all the data is taken from a single snapshot of the objects */
+    objs = get_lvm_objects_snapshot (error);
+    if (!objs)
+        /* the error is already populated */
+        return NULL;
 
-    /* now create the return value -- NULL-terminated array of BDLVMLVdata */
-    ret = g_new0 (BDLVMLVdata*, n_lvs + 1);
+    data = g_new0 (BDLVMReportdata, 1);
+    data->pvs = get_pvs_from_objects (objs, error);
+    data->vgs = get_vgs_from_objects (objs, error);
+    data->lvs = get_lvs_from_objects (objs, NULL, TRUE, error);
+    lvm_objects_unref (objs);
 
-    lv = matched_lvs;
-    while (lv) {
-        props = get_object_properties (lv->data, LV_CMN_INTF, &l_error);
-        if (!props) {
-            g_slist_free_full (matched_lvs, g_free);
-            g_free (ret);
-            g_propagate_error (error, l_error);
-            return NULL;
-        }
-        ret[j] = get_lv_data_from_props (props, &l_error);
-        if (!(ret[j])) {
-            g_slist_free_full (matched_lvs, g_free);
-            for (guint64 i = 0; i < j; i++)
-                bd_lvm_lvdata_free (ret[i]);
-            g_free (ret);
-            g_propagate_error (error, l_error);
-            return NULL;
-        } else if ((g_strcmp0 (ret[j]->segtype, "thin-pool") == 0) ||
-                   (g_strcmp0 (ret[j]->segtype, "cache-pool") == 0)) {
-            ret[j]->data_lv = _lvm_data_lv_name (ret[j]->vg_name, ret[j]->lv_name, &l_error);
-            ret[j]->metadata_lv = _lvm_metadata_lv_name (ret[j]->vg_name, ret[j]->lv_name, &l_error);
-        } else if (g_strcmp0 (ret[j]->segtype, "vdo-pool") == 0) {
-            ret[j]->data_lv = _lvm_data_lv_name (ret[j]->vg_name, ret[j]->lv_name, &l_error);
-        }
-        ret[j]->segs = _lvm_segs (ret[j]->vg_name, ret[j]->lv_name, &l_error);
-        _lvm_data_and_metadata_lvs (ret[j]->vg_name, ret[j]->lv_name, &ret[j]->data_lvs, &ret[j]->metadata_lvs,
-                                    &l_error);
-        if (l_error) {
-            g_slist_free_full (matched_lvs, g_free);
-            for (guint64 i = 0; i <= j; i++)
-                bd_lvm_lvdata_free (ret[i]);
-            g_free (ret);
-            g_propagate_error (error, l_error);
-            return NULL;
-        }
-        j++;
-        lv = g_slist_next (lv);
+    if (!data->lvs) {
+        bd_lvm_reportdata_free (data);
+        return NULL;
     }
-    g_slist_free_full (matched_lvs, g_free);
 
-    ret[j] = NULL;
-    return ret;
+    return data;
 }
 
 /**
@@ -3306,7 +4078,7 @@ gboolean bd_lvm_thpoolcreate (const gchar *vg_name, const gchar *lv_name, guint6
     extra_params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreateLinear", params, extra_params, extra, TRUE, error);
+    return call_lvm_obj_method_sync (vg_name, VG_INTF, "LvCreateLinear", params, extra_params, extra, NULL, error);
 }
 
 /**
@@ -3333,7 +4105,7 @@ gboolean bd_lvm_thlvcreate (const gchar *vg_name, const gchar *pool_name, const
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    return call_thpool_method_sync (vg_name, pool_name, "LvCreate", params, NULL, extra, TRUE, error);
+    return call_thpool_method_sync (vg_name, pool_name, "LvCreate", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -3413,108 +4185,277 @@ gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name
         g_variant_builder_clear (&builder);
     }
 
-    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, extra_params, extra, TRUE, error);
+    return call_lv_method_sync (vg_name, origin_name, "Snapshot", params, extra_params, extra, NULL, error);
+}
+
+/**
+ * bd_lvm_thsnapshotcreate_many:
+ * @vg_name: name of the VG containing the thin LVs new snapshots should be created of
+ * @origin_names: (array zero-terminated=1): names of the thin LVs new snapshots should be created of
+ * @snapshot_names: (array zero-terminated=1): names of the to-be-created snapshots (one for
+ *                                              each of @origin_names)
+ * @pool_name: (nullable): name of the thin pool to create the snapshots in or %NULL if not specified
+ * @extra: (nullable) (array zero-terminated=1): extra options for the thin LV snapshot creation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates the snapshots right one after another (see bd_lvm_thsnapshotcreate()).
+ * LVM cannot create multiple snapshots in one command so every snapshot is a
+ * separate change of the VG metadata, but the whole batch either succeeds or
+ * fails -- if creating one of the snapshots fails, the already created ones
+ * are removed. For crash-consistent snapshots of multiple LVs, freeze the file
+ * systems on them (see bd_fs_freeze()) before the call.
+ *
+ * Returns: whether all the snapshots were successfully created or not
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_CREATE
+ */
+gboolean bd_lvm_thsnapshotcreate_many (const gchar *vg_name, const gchar **origin_names, const gchar **snapshot_names, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
+    guint num_snapshots = origin_names ? g_strv_length ((gchar **) origin_names) : 0;
+    GError *l_error = NULL;
+    guint i = 0;
+
+    if (num_snapshots != (snapshot_names ? g_strv_length ((gchar **) snapshot_names) : 0)) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Number of the snapshot names doesn't match the number of the origin LVs");
+        return FALSE;
+    }
+
+    for (i = 0; i < num_snapshots; i++)
+        if (!bd_lvm_thsnapshotcreate (vg_name, origin_names[i], snapshot_names[i], pool_name, extra, error)) {
+            g_prefix_error (error, "Failed to create the snapshot '%s' of '%s/%s': ",
+                            snapshot_names[i], vg_name, origin_names[i]);
+            break;
+        }
+
+    if (i == num_snapshots)
+        return TRUE;
+
+    /* remove the snapshots created so far (in the reverse order) */
+    while (i > 0) {
+        i--;
+        if (!bd_lvm_lvremove (vg_name, snapshot_names[i], TRUE, NULL, &l_error)) {
+            bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to remove the snapshot '%s/%s': %s",
+                                 vg_name, snapshot_names[i], l_error->message);
+            g_clear_error (&l_error);
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * bd_lvm_set_global_config:
+ * @new_config: (nullable): string representation of the new global LVM
+ *                            configuration to set or %NULL to reset to default
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the new requested global config @new_config was successfully
+ *          set or not
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error G_GNUC_UNUSED) {
+    /* XXX: the error attribute will likely be used in the future when
+       some validation comes into the game */
+
+    /* calls already running keep using the old config */
+    lvm_config_set_global_config (new_config);
+    return TRUE;
+}
+
+/**
+ * bd_lvm_get_global_config:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): a copy of a string representation of the currently
+ *                           set LVM global configuration
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gchar* bd_lvm_get_global_config (GError **error G_GNUC_UNUSED) {
+    LVMConfig *cfg = lvm_config_get_global ();
+    gchar *ret = NULL;
+
+    ret = g_strdup (cfg->config ? cfg->config : "");
+    lvm_config_unref (cfg);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_set_devices_filter:
+ * @devices: (nullable) (array zero-terminated=1): list of devices for lvm commands to work on
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the devices filter was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
+ */
+gboolean bd_lvm_set_devices_filter (const gchar **devices, GError **error) {
+    gchar *devices_str = NULL;
+
+    if (!bd_lvm_is_tech_avail (BD_LVM_TECH_DEVICES, 0, error))
+        return FALSE;
+
+    if (!devices || !(*devices))
+        lvm_config_set_global_devices (NULL);
+    else {
+        devices_str = g_strjoinv (",", (gchar **) devices);
+        lvm_config_set_global_devices (devices_str);
+        g_free (devices_str);
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_lvm_get_devices_filter:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): a copy of a string representation of
+ *                                                     the currently set LVM devices filter
+ *
+ * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
+ */
+gchar** bd_lvm_get_devices_filter (GError **error G_GNUC_UNUSED) {
+    LVMConfig *cfg = lvm_config_get_global ();
+    gchar **ret = NULL;
+
+    if (cfg->devices)
+        ret = g_strsplit (cfg->devices, ",", -1);
+    else
+        ret = NULL;
+    lvm_config_unref (cfg);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_set_thread_config:
+ * @new_config: (nullable): string representation of the LVM configuration to
+ *                          use for calls from the current thread or %NULL for none
+ * @devices: (nullable) (array zero-terminated=1): list of devices for lvm commands
+ *                                                 called from the current thread to
+ *                                                 work on or %NULL for no filter
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Binds @new_config and @devices to the current thread. They are used instead
+ * of the global config (see bd_lvm_set_global_config()) and the global devices
+ * filter (see bd_lvm_set_devices_filter()) by all the LVM functions called from
+ * the current thread until bd_lvm_reset_thread_config() is called. This allows
+ * running operations with different configs and filters from multiple threads
+ * in parallel.
+ *
+ * Returns: whether the thread config was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_set_thread_config (const gchar *new_config, const gchar **devices, GError **error) {
+    LVMConfig *cfg = NULL;
+    gchar *devices_str = NULL;
+
+    if (devices && *devices) {
+        if (!bd_lvm_is_tech_avail (BD_LVM_TECH_DEVICES, 0, error))
+            return FALSE;
+        devices_str = g_strjoinv (",", (gchar **) devices);
+    }
+
+    cfg = lvm_config_new (new_config, devices_str);
+    lvm_config_set_thread (cfg);
+    lvm_config_unref (cfg);
+    g_free (devices_str);
+
+    return TRUE;
 }
 
 /**
- * bd_lvm_set_global_config:
- * @new_config: (nullable): string representation of the new global LVM
- *                            configuration to set or %NULL to reset to default
+ * bd_lvm_reset_thread_config:
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether the new requested global config @new_config was successfully
- *          set or not
+ * Makes the LVM functions called from the current thread use the global
+ * config and devices filter again (see bd_lvm_set_thread_config()).
+ *
+ * Returns: whether the thread config was successfully reset or not
  *
  * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
  */
-gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error G_GNUC_UNUSED) {
-    /* XXX: the error attribute will likely be used in the future when
-       some validation comes into the game */
-
-    g_mutex_lock (&global_config_lock);
-
-    /* first free the old value */
-    g_free (global_config_str);
-
-    /* now store the new one */
-    if (!new_config || g_strcmp0 (new_config, "") == 0)
-         global_config_str = NULL;
-    else
-        global_config_str = g_strdup (new_config);
-
-    g_mutex_unlock (&global_config_lock);
+gboolean bd_lvm_reset_thread_config (GError **error G_GNUC_UNUSED) {
+    lvm_config_set_thread (NULL);
     return TRUE;
 }
 
 /**
- * bd_lvm_get_global_config:
+ * bd_lvm_set_persistent_shell:
+ * @enable: whether to run LVM commands in a persistent 'lvm shell' process or not
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: (transfer full): a copy of a string representation of the currently
- *                           set LVM global configuration
+ * Returns: whether the persistent shell mode was successfully set or not
+ *
+ * The persistent shell is not supported by this plugin implementation (lvmdbusd
+ * already runs all LVM commands in its own persistent shell process) so only
+ * disabling it succeeds.
  *
  * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
  */
-gchar* bd_lvm_get_global_config (GError **error G_GNUC_UNUSED) {
-    gchar *ret = NULL;
+gboolean bd_lvm_set_persistent_shell (gboolean enable, GError **error) {
+    if (enable) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_TECH_UNAVAIL,
+                     "Persistent lvm shell is not supported by this plugin implementation.");
+        return FALSE;
+    }
 
-    g_mutex_lock (&global_config_lock);
-    ret = g_strdup (global_config_str ? global_config_str : "");
-    g_mutex_unlock (&global_config_lock);
+    return TRUE;
+}
 
-    return ret;
+/**
+ * bd_lvm_get_persistent_shell:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether LVM commands are run in a persistent 'lvm shell' process or not
+ *          (always %FALSE with this plugin implementation)
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_get_persistent_shell (GError **error G_GNUC_UNUSED) {
+    return FALSE;
 }
 
 /**
- * bd_lvm_set_devices_filter:
- * @devices: (nullable) (array zero-terminated=1): list of devices for lvm commands to work on
+ * bd_lvm_set_auto_devices:
+ * @enable: whether to automatically limit the devices LVM scans for queries
+ *          targeting a single PV, VG or LV or not
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether the devices filter was successfully set or not
+ * Returns: whether the automatic devices scoping was successfully set or not
+ *
+ * The automatic devices scoping is not supported by this plugin implementation
+ * (lvmdbusd answers the queries from its own state) so only disabling it
+ * succeeds.
  *
  * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
  */
-gboolean bd_lvm_set_devices_filter (const gchar **devices, GError **error) {
-    if (!bd_lvm_is_tech_avail (BD_LVM_TECH_DEVICES, 0, error))
+gboolean bd_lvm_set_auto_devices (gboolean enable, GError **error) {
+    if (enable) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_TECH_UNAVAIL,
+                     "Automatic devices scoping is not supported by this plugin implementation.");
         return FALSE;
+    }
 
-    g_mutex_lock (&global_config_lock);
-
-    /* first free the old value */
-    g_free (global_devices_str);
-
-    /* now store the new one */
-    if (!devices || !(*devices))
-        global_devices_str = NULL;
-    else
-        global_devices_str = g_strjoinv (",", (gchar **) devices);
-
-    g_mutex_unlock (&global_config_lock);
     return TRUE;
 }
 
 /**
- * bd_lvm_get_devices_filter:
+ * bd_lvm_get_auto_devices:
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: (transfer full) (array zero-terminated=1): a copy of a string representation of
- *                                                     the currently set LVM devices filter
+ * Returns: whether the automatic devices scoping (see bd_lvm_set_auto_devices())
+ *          is enabled or not (always %FALSE with this plugin implementation)
  *
  * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
  */
-gchar** bd_lvm_get_devices_filter (GError **error G_GNUC_UNUSED) {
-    gchar **ret = NULL;
-
-    g_mutex_lock (&global_config_lock);
-
-    if (global_devices_str)
-        ret = g_strsplit (global_devices_str, ",", -1);
-    else
-        ret = NULL;
-
-    g_mutex_unlock (&global_config_lock);
-
-    return ret;
+gboolean bd_lvm_get_auto_devices (GError **error G_GNUC_UNUSED) {
+    return FALSE;
 }
 
 /**
@@ -3719,7 +4660,7 @@ gboolean bd_lvm_cache_create_pool (const gchar *vg_name, const gchar *pool_name,
     extra = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    success = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, extra, NULL, TRUE, &l_error);
+    success = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, extra, NULL, NULL, &l_error);
     if (!success) {
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
@@ -3743,17 +4684,45 @@ gboolean bd_lvm_cache_create_pool (const gchar *vg_name, const gchar *pool_name,
  * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_cache_attach (const gchar *vg_name, const gchar *data_lv, const gchar *cache_pool_lv, const BDExtraArg **extra, GError **error) {
+    return bd_lvm_cache_attach_with_settings (vg_name, data_lv, cache_pool_lv, NULL, extra, error);
+}
+
+/**
+ * bd_lvm_cache_attach_with_settings:
+ * @vg_name: name of the VG containing the @data_lv and the @cache_pool_lv LVs
+ * @data_lv: data LV to attach the @cache_pool_lv to
+ * @cache_pool_lv: cache pool LV to attach to the @data_lv
+ * @settings: (nullable): settings of the cache or %NULL to use the defaults
+ * @extra: (nullable) (array zero-terminated=1): extra options for the cache attachment
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @cache_pool_lv was successfully attached to the @data_lv or not
+ *
+ * Only the chunk size, migration threshold, policy and policy settings from
+ * @settings can be used for a dm-cache, see #BDLVMCacheSettings.
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_cache_attach_with_settings (const gchar *vg_name, const gchar *data_lv, const gchar *cache_pool_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error) {
     GVariantBuilder builder;
     GVariant *params = NULL;
     gchar *lv_id = NULL;
     g_autofree gchar *lv_obj_path = NULL;
+    BDExtraArg **all_extra = NULL;
     gboolean ret = FALSE;
 
+    all_extra = cache_settings_to_extra (settings, CACHE_SETTINGS_CACHE, TRUE, extra, error);
+    if (!all_extra)
+        return FALSE;
+
     lv_id = g_strdup_printf ("%s/%s", vg_name, data_lv);
     lv_obj_path = get_object_path (lv_id, error);
     g_free (lv_id);
-    if (!lv_obj_path)
+    if (!lv_obj_path) {
+        bd_extra_arg_list_free (all_extra);
         return FALSE;
+    }
     g_variant_builder_init (&builder, G_VARIANT_TYPE_TUPLE);
     g_variant_builder_add_value (&builder, g_variant_new ("o", lv_obj_path));
     params = g_variant_builder_end (&builder);
@@ -3761,11 +4730,37 @@ gboolean bd_lvm_cache_attach (const gchar *vg_name, const gchar *data_lv, const
 
     lv_id = g_strdup_printf ("%s/%s", vg_name, cache_pool_lv);
 
-    ret = call_lvm_obj_method_sync (lv_id, CACHE_POOL_INTF, "CacheLv", params, NULL, extra, TRUE, error);
+    ret = call_lvm_obj_method_sync (lv_id, CACHE_POOL_INTF, "CacheLv", params, NULL, (const BDExtraArg **) all_extra, NULL, error);
     g_free (lv_id);
+    bd_extra_arg_list_free (all_extra);
     return ret;
 }
 
+/**
+ * bd_lvm_cache_set_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached (dm-cache or writecache) LV to change the cache settings of
+ * @settings: new settings of the cache, only the non-default (non-zero) ones are changed
+ * @extra: (nullable) (array zero-terminated=1): extra options for the change
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the cache settings of the @cached_lv were successfully changed or not
+ *
+ * The chunk size of an existing cache cannot be changed.
+ *
+ * Changing the settings of an existing cache is not supported by this plugin
+ * implementation (lvmdbusd has no method for it).
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_cache_set_settings (const gchar *vg_name G_GNUC_UNUSED, const gchar *cached_lv G_GNUC_UNUSED, const BDLVMCacheSettings *settings G_GNUC_UNUSED,
+                                    const BDExtraArg **extra G_GNUC_UNUSED, GError **error) {
+    g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_TECH_UNAVAIL,
+                 "Changing cache settings is not supported by this plugin implementation.");
+    return FALSE;
+}
+
 /**
  * bd_lvm_cache_detach:
  * @vg_name: name of the VG containing the @cached_lv
@@ -3796,7 +4791,7 @@ gboolean bd_lvm_cache_detach (const gchar *vg_name, const gchar *cached_lv, gboo
     if (!cache_pool_name)
         return FALSE;
     lv_id = g_strdup_printf ("%s/%s", vg_name, cached_lv);
-    return call_lvm_obj_method_sync (lv_id, CACHED_LV_INTF, "DetachCachePool", params, NULL, extra, TRUE, error);
+    return call_lvm_obj_method_sync (lv_id, CACHED_LV_INTF, "DetachCachePool", params, NULL, extra, NULL, error);
 }
 
 /**
@@ -3882,26 +4877,60 @@ gboolean bd_lvm_cache_create_cached_lv (const gchar *vg_name, const gchar *lv_na
  * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_writecache_attach (const gchar *vg_name, const gchar *data_lv, const gchar *cache_lv, const BDExtraArg **extra, GError **error) {
+    return bd_lvm_writecache_attach_with_settings (vg_name, data_lv, cache_lv, NULL, extra, error);
+}
+
+/**
+ * bd_lvm_writecache_attach_with_settings:
+ * @vg_name: name of the VG containing the @data_lv and the @cache_pool_lv LVs
+ * @data_lv: data LV to attach the @cache_lv to
+ * @cache_lv: cache (fast) LV to attach to the @data_lv
+ * @settings: (nullable): settings of the writecache or %NULL to use the defaults
+ * @extra: (nullable) (array zero-terminated=1): extra options for the cache attachment
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @cache_lv was successfully attached to the @data_lv or not
+ *
+ * Only the watermarks, number of writeback jobs, autocommit settings and policy
+ * settings from @settings can be used for a writecache, see #BDLVMCacheSettings.
+ *
+ * Note: Both @data_lv and @cache_lv will be deactivated before the operation.
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_writecache_attach_with_settings (const gchar *vg_name, const gchar *data_lv, const gchar *cache_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error) {
     GVariantBuilder builder;
     GVariant *params = NULL;
     gchar *lv_id = NULL;
     g_autofree gchar *lv_obj_path = NULL;
+    BDExtraArg **all_extra = NULL;
     gboolean success = FALSE;
 
+    all_extra = cache_settings_to_extra (settings, CACHE_SETTINGS_WRITECACHE, TRUE, extra, error);
+    if (!all_extra)
+        return FALSE;
+
     /* both LVs need to be inactive for the writecache convert to work */
     success = bd_lvm_lvdeactivate (vg_name, data_lv, NULL, error);
-    if (!success)
+    if (!success) {
+        bd_extra_arg_list_free (all_extra);
         return FALSE;
+    }
 
     success = bd_lvm_lvdeactivate (vg_name, cache_lv, NULL, error);
-    if (!success)
+    if (!success) {
+        bd_extra_arg_list_free (all_extra);
         return FALSE;
+    }
 
     lv_id = g_strdup_printf ("%s/%s", vg_name, data_lv);
     lv_obj_path = get_object_path (lv_id, error);
     g_free (lv_id);
-    if (!lv_obj_path)
+    if (!lv_obj_path) {
+        bd_extra_arg_list_free (all_extra);
         return FALSE;
+    }
     g_variant_builder_init (&builder, G_VARIANT_TYPE_TUPLE);
     g_variant_builder_add_value (&builder, g_variant_new ("o", lv_obj_path));
     params = g_variant_builder_end (&builder);
@@ -3909,8 +4938,9 @@ gboolean bd_lvm_writecache_attach (const gchar *vg_name, const gchar *data_lv, c
 
     lv_id = g_strdup_printf ("%s/%s", vg_name, cache_lv);
 
-    success = call_lvm_obj_method_sync (lv_id, LV_INTF, "WriteCacheLv", params, NULL, extra, TRUE, error);
+    success = call_lvm_obj_method_sync (lv_id, LV_INTF, "WriteCacheLv", params, NULL, (const BDExtraArg **) all_extra, NULL, error);
     g_free (lv_id);
+    bd_extra_arg_list_free (all_extra);
     return success;
 }
 
@@ -4054,27 +5084,11 @@ gchar* bd_lvm_cache_pool_name (const gchar *vg_name, const gchar *cached_lv, GEr
     return pool_name;
 }
 
-/**
- * bd_lvm_cache_stats:
- * @vg_name: name of the VG containing the @cached_lv
- * @cached_lv: cached LV to get stats for
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: stats for the @cached_lv or %NULL in case of error
- *
- * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
- */
-BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+/* translates the VG+LV name of a cached LV into the name of the DM map with
+   the cache target */
+static gchar* get_cache_map_name (const gchar *vg_name, const gchar *cached_lv, GError **error) {
     struct dm_pool *pool = NULL;
-    struct dm_task *task = NULL;
-    struct dm_info info;
-    struct dm_status_cache *status = NULL;
     gchar *map_name = NULL;
-    guint64 start = 0;
-    guint64 length = 0;
-    gchar *type = NULL;
-    gchar *params = NULL;
-    BDLVMCacheStats *ret = NULL;
     BDLVMLVdata *lvdata = NULL;
 
     if (geteuid () != 0) {
@@ -4090,59 +5104,52 @@ BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_l
     pool = dm_pool_create ("bd-pool", 20);
 
     if (g_strcmp0 (lvdata->segtype, "thin-pool") == 0)
-        map_name = dm_build_dm_name (pool, vg_name, lvdata->data_lv, NULL);
+        map_name = g_strdup (dm_build_dm_name (pool, vg_name, lvdata->data_lv, NULL));
     else
-        /* translate the VG+LV name into the DM map name */
-        map_name = dm_build_dm_name (pool, vg_name, cached_lv, NULL);
+        map_name = g_strdup (dm_build_dm_name (pool, vg_name, cached_lv, NULL));
 
     bd_lvm_lvdata_free (lvdata);
+    dm_pool_destroy (pool);
 
-    task = dm_task_create (DM_DEVICE_STATUS);
-    if (!task) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to create DM task for the cache map '%s': ", map_name);
-        dm_pool_destroy (pool);
-        return NULL;
-    }
-
-    if (dm_task_set_name (task, map_name) == 0) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to create DM task for the cache map '%s': ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
-        return NULL;
-    }
+    return map_name;
+}
 
-    if (dm_task_run (task) == 0) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to run the DM task for the cache map '%s': ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
-        return NULL;
-    }
+/**
+ * bd_lvm_cache_stats:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to get stats for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: stats for the @cached_lv or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    struct dm_pool *pool = NULL;
+    struct dm_status_cache *status = NULL;
+    DMSnapshotMap *map = NULL;
+    g_autofree gchar *map_name = NULL;
+    BDLVMCacheStats *ret = NULL;
 
-    if (dm_task_get_info (task, &info) == 0) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to get task info for the cache map '%s': ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
+    map_name = get_cache_map_name (vg_name, cached_lv, error);
+    if (!map_name)
         return NULL;
-    }
 
-    if (!info.exists) {
+    /* the counters need to be current (e.g. for sampling), always get the live
+       status of the map */
+    map = dm_snapshot_map_status (map_name);
+    if (!map) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_NOCACHE,
                      "The cache map '%s' doesn't exist: ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
         return NULL;
     }
 
-    dm_get_next_target (task, NULL, &start, &length, &type, &params);
+    pool = dm_pool_create ("bd-pool", 20);
 
-    if (dm_get_status_cache (pool, params, &status) == 0) {
+    if (g_strcmp0 (map->target_type, "cache") != 0 || dm_get_status_cache (pool, map->status, &status) == 0) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
                      "Failed to get status of the cache map '%s': ", map_name);
-        dm_task_destroy (task);
+        dm_snapshot_map_free (map);
         dm_pool_destroy (pool);
         return NULL;
     }
@@ -4169,18 +5176,143 @@ BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_l
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
                       "Failed to determine status of the cache from '%"G_GUINT64_FORMAT"': ",
                       status->feature_flags);
-        dm_task_destroy (task);
+        dm_snapshot_map_free (map);
         dm_pool_destroy (pool);
         bd_lvm_cache_stats_free (ret);
         return NULL;
     }
 
-    dm_task_destroy (task);
+    dm_snapshot_map_free (map);
     dm_pool_destroy (pool);
 
     return ret;
 }
 
+/**
+ * bd_lvm_cache_sampler_new:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached (dm-cache or writecache) LV to sample stats for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a sampler for periodic collection of the @cached_lv statistics. The
+ * DM map of the @cached_lv is resolved only once here, each call of
+ * bd_lvm_cache_sampler_sample() then just queries the current status of the
+ * map and computes the differences to the previous sample.
+ *
+ * Returns: (transfer full): a new sampler for @cached_lv or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheSampler* bd_lvm_cache_sampler_new (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    g_autofree gchar *map_name = NULL;
+
+    map_name = get_cache_map_name (vg_name, cached_lv, error);
+    if (!map_name)
+        return NULL;
+
+    return cache_sampler_new (vg_name, cached_lv, map_name, error);
+}
+
+/**
+ * bd_lvm_cache_sampler_sample:
+ * @sampler: a sampler created with bd_lvm_cache_sampler_new()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Takes a new sample of the cache statistics. The deltas and rates are computed
+ * against the previous sample (or the creation of @sampler for the first one).
+ *
+ * Returns: (transfer full): current cache statistics for the LV of @sampler or
+ *                           %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheSample* bd_lvm_cache_sampler_sample (BDLVMCacheSampler *sampler, GError **error) {
+    return cache_sampler_sample (sampler, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_new:
+ * @vg_name: name of the VG containing the @pool_name LV
+ * @pool_name: thin pool or VDO pool LV to monitor
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a monitor for periodic checks of the @pool_name usage. The DM map
+ * with the thin-pool or VDO target of the (active) pool is resolved only once
+ * here, each call of bd_lvm_pool_monitor_sample() then just queries the current
+ * status of the map without running any LVM command.
+ *
+ * Returns: (transfer full): a new monitor for @pool_name or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMPoolMonitor* bd_lvm_pool_monitor_new (const gchar *vg_name, const gchar *pool_name, GError **error) {
+    return pool_monitor_new (vg_name, pool_name, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_sample:
+ * @monitor: a monitor created with bd_lvm_pool_monitor_new()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets the current usage of the pool of @monitor. If the data or metadata usage
+ * gets over the thresholds set with bd_lvm_pool_monitor_set_thresholds(), the
+ * threshold function is called (from this function) before returning.
+ *
+ * Returns: (transfer full): current usage of the pool of @monitor or %NULL in
+ *                           case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMPoolUsage* bd_lvm_pool_monitor_sample (BDLVMPoolMonitor *monitor, GError **error) {
+    return pool_monitor_sample (monitor, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_set_thresholds:
+ * @monitor: a monitor created with bd_lvm_pool_monitor_new()
+ * @data_percent: data usage (in percents) to call @func at or 0 to disable
+ * @metadata_percent: metadata usage (in percents) to call @func at or 0 to disable
+ *                    (ignored for VDO pools)
+ * @func: (nullable) (scope forever): function to call when the usage gets over
+ *                                    @data_percent or @metadata_percent
+ * @user_data: (closure): data to pass to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * @func is called from bd_lvm_pool_monitor_sample() when the usage gets over
+ * one of the thresholds. It is only called again after the usage drops below
+ * the threshold and gets over it again.
+ *
+ * Returns: whether the thresholds were successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pool_monitor_set_thresholds (BDLVMPoolMonitor *monitor, gdouble data_percent, gdouble metadata_percent, BDLVMPoolThresholdFunc func, gpointer user_data, GError **error) {
+    return pool_monitor_set_thresholds (monitor, data_percent, metadata_percent, func, user_data, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_wait_event:
+ * @monitor: a monitor created with bd_lvm_pool_monitor_new()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Waits for a DM event of the pool of @monitor since the last sample (or the
+ * last wait). The kernel raises the events e.g. when a thin pool gets over its
+ * low water mark, runs out of space or changes its mode. This blocks until an
+ * event happens so it should only be used from a dedicated thread, with
+ * bd_lvm_pool_monitor_sample() called afterwards.
+ *
+ * Returns: whether an event happened or not (in case of error)
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pool_monitor_wait_event (BDLVMPoolMonitor *monitor, GError **error) {
+    return pool_monitor_wait_event (monitor, error);
+}
+
 /**
  * bd_lvm_thpool_convert:
  * @vg_name: name of the VG to create the new thin pool in
@@ -4225,7 +5357,7 @@ gboolean bd_lvm_thpool_convert (const gchar *vg_name, const gchar *data_lv, cons
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateThinPool", params, NULL, extra, TRUE, error);
+    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateThinPool", params, NULL, extra, NULL, error);
     if (ret && name)
         bd_lvm_lvrename (vg_name, data_lv, name, NULL, error);
     return ret;
@@ -4275,7 +5407,7 @@ gboolean bd_lvm_cache_pool_convert (const gchar *vg_name, const gchar *data_lv,
     params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, NULL, extra, TRUE, error);
+    ret = call_lvm_obj_method_sync (vg_name, VG_INTF, "CreateCachePool", params, NULL, extra, NULL, error);
 
     if (!ret && name)
         bd_lvm_lvrename (vg_name, data_lv, name, NULL, error);
@@ -4303,11 +5435,38 @@ gboolean bd_lvm_cache_pool_convert (const gchar *vg_name, const gchar *data_lv,
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_CREATE
  */
 gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, const gchar *pool_name, guint64 data_size, guint64 virtual_size, guint64 index_memory, gboolean compression, gboolean deduplication, BDLVMVDOWritePolicy write_policy, const BDExtraArg **extra, GError **error) {
+    return bd_lvm_vdo_pool_create_with_settings (vg_name, lv_name, pool_name, data_size, virtual_size, index_memory, compression, deduplication, write_policy, NULL, extra, error);
+}
+
+/**
+ * bd_lvm_vdo_pool_create_with_settings:
+ * @vg_name: name of the VG to create a new LV in
+ * @lv_name: name of the to-be-created VDO LV
+ * @pool_name: (nullable): name of the to-be-created VDO pool LV or %NULL for default name
+ * @data_size: requested size of the data VDO LV (physical size of the @pool_name VDO pool LV)
+ * @virtual_size: requested virtual_size of the @lv_name VDO LV
+ * @index_memory: amount of index memory (in bytes) or 0 for default
+ * @compression: whether to enable compression or not
+ * @deduplication: whether to enable deduplication or not
+ * @write_policy: write policy for the volume
+ * @settings: (nullable): tuning of the VDO pool or %NULL to use the defaults
+ * @extra: (nullable) (array zero-terminated=1): extra options for the VDO LV creation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the given @vg_name/@lv_name VDO LV was successfully created or not
+ *
+ * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_CREATE
+ */
+gboolean bd_lvm_vdo_pool_create_with_settings (const gchar *vg_name, const gchar *lv_name, const gchar *pool_name, guint64 data_size, guint64 virtual_size, guint64 index_memory, gboolean compression, gboolean deduplication, BDLVMVDOWritePolicy write_policy, const BDLVMVDOSettings *settings, const BDExtraArg **extra, GError **error) {
     GVariantBuilder builder;
     GVariant *params = NULL;
     GVariant *extra_params = NULL;
-    gchar *old_config = NULL;
+    LVMConfig *global_cfg = NULL;
+    LVMConfig *vdo_cfg = NULL;
+    gchar *vdo_config = NULL;
     const gchar *write_policy_str = NULL;
+    g_autofree gchar *settings_config = NULL;
     g_autofree gchar *name = NULL;
     gboolean ret = FALSE;
 
@@ -4315,6 +5474,10 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
     if (write_policy_str == NULL)
         return FALSE;
 
+    settings_config = vdo_settings_to_config (settings, error);
+    if (!settings_config)
+        return FALSE;
+
     /* build the params tuple */
     g_variant_builder_init (&builder, G_VARIANT_TYPE_TUPLE);
 
@@ -4337,22 +5500,22 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
     extra_params = g_variant_builder_end (&builder);
     g_variant_builder_clear (&builder);
 
-    /* index_memory and write_policy can be specified only using the config */
-    g_mutex_lock (&global_config_lock);
-    old_config = global_config_str;
+    /* index_memory, write_policy and the tuning can be specified only using the config
+       (the '--vdosettings' option is not supported by older versions of LVM) */
+    global_cfg = lvm_config_get ();
     if (index_memory != 0)
-        global_config_str = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                                                                     index_memory / (1024 * 1024),
-                                                                                                                                     write_policy_str);
+        vdo_config = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"%s}", global_cfg->config ? global_cfg->config : "",
+                                                                                                                                index_memory / (1024 * 1024),
+                                                                                                                                write_policy_str, settings_config);
     else
-        global_config_str = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                        write_policy_str);
+        vdo_config = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"%s}", global_cfg->config ? global_cfg->config : "",
+                                                                                   write_policy_str, settings_config);
+    vdo_cfg = lvm_config_new (vdo_config, global_cfg->devices);
+    lvm_config_unref (global_cfg);
+    g_free (vdo_config);
 
-    ret = call_lvm_obj_method_sync (vg_name, VG_VDO_INTF, "CreateVdoPoolandLv", params, extra_params, extra, FALSE, error);
-
-    g_free (global_config_str);
-    global_config_str = old_config;
-    g_mutex_unlock (&global_config_lock);
+    ret = call_lvm_obj_method_sync (vg_name, VG_VDO_INTF, "CreateVdoPoolandLv", params, extra_params, extra, vdo_cfg, error);
+    lvm_config_unref (vdo_cfg);
 
     return ret;
 }
@@ -4370,7 +5533,7 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_enable_compression (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "EnableCompression", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "EnableCompression", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -4386,7 +5549,7 @@ gboolean bd_lvm_vdo_enable_compression (const gchar *vg_name, const gchar *pool_
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_disable_compression (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "DisableCompression", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "DisableCompression", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -4402,7 +5565,7 @@ gboolean bd_lvm_vdo_disable_compression (const gchar *vg_name, const gchar *pool
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_enable_deduplication (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "EnableDeduplication", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "EnableDeduplication", NULL, NULL, extra, NULL, error);
 }
 
 /**
@@ -4418,7 +5581,34 @@ gboolean bd_lvm_vdo_enable_deduplication (const gchar *vg_name, const gchar *poo
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_vdo_disable_deduplication (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
-    return call_vdopool_method_sync (vg_name, pool_name, "DisableDeduplication", NULL, NULL, extra, TRUE, error);
+    return call_vdopool_method_sync (vg_name, pool_name, "DisableDeduplication", NULL, NULL, extra, NULL, error);
+}
+
+/**
+ * bd_lvm_vdo_pool_set_settings:
+ * @vg_name: name of the VG containing the to-be-changed VDO pool LV
+ * @pool_name: name of the VDO pool LV to change the settings of
+ * @settings: new settings of the VDO pool, only the non-default (non-zero) ones are changed
+ * @extra: (nullable) (array zero-terminated=1): extra options for the VDO change
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the settings of the @vg_name/@pool_name VDO pool LV were successfully changed or not
+ *
+ * The slab size of an existing VDO pool cannot be changed. The new settings
+ * are stored in the LVM metadata and may only be applied when the VDO pool is
+ * activated next time.
+ *
+ * Changing the settings of an existing VDO pool is not supported by this plugin
+ * implementation (lvmdbusd has no method for it).
+ *
+ * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_vdo_pool_set_settings (const gchar *vg_name G_GNUC_UNUSED, const gchar *pool_name G_GNUC_UNUSED, const BDLVMVDOSettings *settings G_GNUC_UNUSED,
+                                       const BDExtraArg **extra G_GNUC_UNUSED, GError **error) {
+    g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_TECH_UNAVAIL,
+                 "Changing VDO pool settings is not supported by this plugin implementation.");
+    return FALSE;
 }
 
 /**
@@ -4735,31 +5925,15 @@ GHashTable* bd_lvm_vdo_get_stats_full (const gchar *vg_name, const gchar *pool_n
  * In contrast to @bd_lvm_vdo_get_stats_full this function will only return selected statistics
  * in a fixed structure. In case a value is not available, -1 would be returned.
  *
+ * Only the counters needed for the structure are read and the statistics files
+ * are kept open between calls which makes this function suitable for periodic
+ * monitoring of the VDO pools.
+ *
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
  */
 BDLVMVDOStats* bd_lvm_vdo_get_stats (const gchar *vg_name, const gchar *pool_name, GError **error) {
-    GHashTable *full_stats = NULL;
-    BDLVMVDOStats *stats = NULL;
-
-    full_stats = bd_lvm_vdo_get_stats_full (vg_name, pool_name, error);
-    if (!full_stats)
-        return NULL;
-
-    stats = g_new0 (BDLVMVDOStats, 1);
-    get_stat_val64_default (full_stats, "block_size", &stats->block_size, -1);
-    get_stat_val64_default (full_stats, "logical_block_size", &stats->logical_block_size, -1);
-    get_stat_val64_default (full_stats, "physical_blocks", &stats->physical_blocks, -1);
-    get_stat_val64_default (full_stats, "data_blocks_used", &stats->data_blocks_used, -1);
-    get_stat_val64_default (full_stats, "overhead_blocks_used", &stats->overhead_blocks_used, -1);
-    get_stat_val64_default (full_stats, "logical_blocks_used", &stats->logical_blocks_used, -1);
-    get_stat_val64_default (full_stats, "usedPercent", &stats->used_percent, -1);
-    get_stat_val64_default (full_stats, "savingPercent", &stats->saving_percent, -1);
-    if (!get_stat_val_double (full_stats, "writeAmplificationRatio", &stats->write_amplification_ratio))
-        stats->write_amplification_ratio = -1;
-
-    g_hash_table_destroy (full_stats);
-
-    return stats;
+    g_autofree gchar *kvdo_name = g_strdup_printf ("%s-%s-%s", vg_name, pool_name, VDO_POOL_SUFFIX);
+    return vdo_get_stats (kvdo_name, error);
 }
 
 /* check whether the LVM devices file is enabled by LVM
@@ -4774,20 +5948,21 @@ static gboolean _lvm_devices_enabled () {
     gboolean enabled = FALSE;
     gint scanned = 0;
     g_autofree gchar *config_arg = NULL;
+    LVMConfig *cfg = NULL;
 
     /* try full config first -- if we get something from this it means the feature is
        explicitly enabled or disabled by system lvm.conf or using the --config option */
     args[2] = "full";
 
     /* make sure to include the global config from us when getting the current config value */
-    g_mutex_lock (&global_config_lock);
-    if (global_config_str) {
-        config_arg = g_strdup_printf ("--config=%s", global_config_str);
+    cfg = lvm_config_get ();
+    if (cfg->config) {
+        config_arg = g_strdup_printf ("--config=%s", cfg->config);
         args[4] = config_arg;
     }
 
     ret = bd_utils_exec_and_capture_output (args, NULL, &output, &loc_error);
-    g_mutex_unlock (&global_config_lock);
+    lvm_config_unref (cfg);
     if (ret) {
         scanned = sscanf (output, "use_devicesfile=%u", &enabled);
         g_free (output);
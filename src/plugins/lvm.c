@@ -28,6 +28,16 @@
 #include "check_deps.h"
 #include "dm_logging.h"
 #include "vdo_stats.h"
+#include "cache_stats.h"
+#include "cache_settings.h"
+#include "vdo_settings.h"
+#include "pool_monitor.h"
+#include "pvmove_job.h"
+#include "lv_result_set.h"
+#include "dm_snapshot.h"
+#include "lvm_shell.h"
+#include "lvm_config.h"
+#include "lvm_report.h"
 
 #define INT_FLOAT_EPS 1e-5
 #define SECTOR_SIZE 512
@@ -63,10 +73,7 @@
 #define LVM_MIN_VERSION "2.02.116"
 #define LVM_VERSION_FSRESIZE "2.03.19"
 
-static GMutex global_config_lock;
-static gchar *global_config_str = NULL;
-
-static gchar *global_devices_str = NULL;
+static gint use_persistent_shell = FALSE;
 
 /**
  * SECTION: lvm
@@ -247,6 +254,103 @@ void bd_lvm_lvdata_free (BDLVMLVdata *data) {
     g_free (data);
 }
 
+BDLVMBatchOp* bd_lvm_batch_op_new (BDLVMBatchOpType type, const gchar *vg_name, const gchar *lv_name, const gchar *new_name, const gchar **tags) {
+    BDLVMBatchOp *ret = g_new0 (BDLVMBatchOp, 1);
+
+    ret->type = type;
+    ret->vg_name = g_strdup (vg_name);
+    ret->lv_name = g_strdup (lv_name);
+    ret->new_name = g_strdup (new_name);
+    ret->tags = g_strdupv ((gchar **) tags);
+
+    return ret;
+}
+
+BDLVMBatchOp* bd_lvm_batch_op_copy (BDLVMBatchOp *data) {
+    if (data == NULL)
+        return NULL;
+
+    return bd_lvm_batch_op_new (data->type, data->vg_name, data->lv_name, data->new_name, (const gchar **) data->tags);
+}
+
+void bd_lvm_batch_op_free (BDLVMBatchOp *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->vg_name);
+    g_free (data->lv_name);
+    g_free (data->new_name);
+    g_strfreev (data->tags);
+    g_free (data);
+}
+
+BDLVMBatchResult* bd_lvm_batch_result_copy (BDLVMBatchResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDLVMBatchResult *ret = g_new0 (BDLVMBatchResult, 1);
+
+    ret->success = data->success;
+    ret->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return ret;
+}
+
+void bd_lvm_batch_result_free (BDLVMBatchResult *data) {
+    if (data == NULL)
+        return;
+
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+BDLVMReportdata* bd_lvm_reportdata_copy (BDLVMReportdata *data) {
+    guint64 i = 0;
+
+    if (data == NULL)
+        return NULL;
+
+    BDLVMReportdata *new_data = g_new0 (BDLVMReportdata, 1);
+
+    for (i = 0; data->pvs && data->pvs[i]; i++);
+    new_data->pvs = g_new0 (BDLVMPVdata *, i + 1);
+    for (i = 0; data->pvs && data->pvs[i]; i++)
+        new_data->pvs[i] = bd_lvm_pvdata_copy (data->pvs[i]);
+
+    for (i = 0; data->vgs && data->vgs[i]; i++);
+    new_data->vgs = g_new0 (BDLVMVGdata *, i + 1);
+    for (i = 0; data->vgs && data->vgs[i]; i++)
+        new_data->vgs[i] = bd_lvm_vgdata_copy (data->vgs[i]);
+
+    for (i = 0; data->lvs && data->lvs[i]; i++);
+    new_data->lvs = g_new0 (BDLVMLVdata *, i + 1);
+    for (i = 0; data->lvs && data->lvs[i]; i++)
+        new_data->lvs[i] = bd_lvm_lvdata_copy (data->lvs[i]);
+
+    return new_data;
+}
+
+void bd_lvm_reportdata_free (BDLVMReportdata *data) {
+    guint64 i = 0;
+
+    if (data == NULL)
+        return;
+
+    for (i = 0; data->pvs && data->pvs[i]; i++)
+        bd_lvm_pvdata_free (data->pvs[i]);
+    g_free (data->pvs);
+
+    for (i = 0; data->vgs && data->vgs[i]; i++)
+        bd_lvm_vgdata_free (data->vgs[i]);
+    g_free (data->vgs);
+
+    for (i = 0; data->lvs && data->lvs[i]; i++)
+        bd_lvm_lvdata_free (data->lvs[i]);
+    g_free (data->lvs);
+
+    g_free (data);
+}
+
 BDLVMVDOPooldata* bd_lvm_vdopooldata_copy (BDLVMVDOPooldata *data) {
     if (data == NULL)
         return NULL;
@@ -358,6 +462,8 @@ gboolean bd_lvm_init (void) {
  *
  */
 void bd_lvm_close (void) {
+    lvm_shell_stop ();
+    vdo_stats_close ();
     dm_log_with_errno_init (NULL);
     dm_log_init_verbose (0);
 }
@@ -402,19 +508,64 @@ gboolean bd_lvm_is_tech_avail (BDLVMTech tech, guint64 mode, GError **error) {
     }
 }
 
-static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg **extra, gboolean lock_config, GError **error) {
-    gboolean success = FALSE;
-    guint i = 0;
-    guint args_length = g_strv_length ((gchar **) args);
-    g_autofree gchar *config_arg = NULL;
-    g_autofree gchar *devices_arg = NULL;
+/**
+ * shell_usable: (skip)
+ *
+ * Returns: whether the command should be run in the persistent 'lvm shell' process
+ */
+static gboolean shell_usable (const gchar **argv, const BDExtraArg **extra) {
+    GError *l_error = NULL;
 
-    if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+    if (!g_atomic_int_get (&use_persistent_shell) || !lvm_shell_can_run (argv, extra))
+        return FALSE;
+
+    if (!lvm_shell_ensure_running (&l_error)) {
+        /* nothing has been run yet, safe to fall back to a separate process */
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to use the lvm shell, running lvm directly: %s",
+                             l_error->message);
+        g_clear_error (&l_error);
         return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Automatic --devices scoping for the queries targeting a single PV, VG or LV
+ * (see bd_lvm_set_auto_devices()). The mapping between PVs and VGs comes from
+ * one full 'pvs' scan, it is dropped after every modifying command run by the
+ * plugin and whenever a scoped query doesn't match it (the query is then run
+ * again without the scoping).
+ */
+static gint use_auto_devices = FALSE;
+static GMutex pv_map_lock;
+/* VG name -> NULL-terminated array of its PVs */
+static GHashTable *vg_pvs = NULL;
+/* PV name -> VG name */
+static GHashTable *pv_vgs = NULL;
+
+static void pv_map_clear (void) {
+    if (!g_atomic_int_get (&use_auto_devices))
+        return;
+
+    g_mutex_lock (&pv_map_lock);
+    if (vg_pvs) {
+        g_hash_table_destroy (vg_pvs);
+        vg_pvs = NULL;
+    }
+    if (pv_vgs) {
+        g_hash_table_destroy (pv_vgs);
+        pv_vgs = NULL;
+    }
+    g_mutex_unlock (&pv_map_lock);
+}
 
-    /* don't allow global config string changes during the run */
-    if (lock_config)
-        g_mutex_lock (&global_config_lock);
+/* builds the argv for running @args with "lvm" prepended and the @cfg config
+   and devices filter appended, @config_arg and @devices_arg are used to store
+   the respective arguments (to be freed by the caller) */
+static const gchar** build_lvm_argv (const gchar **args, const LVMConfig *cfg, gchar **config_arg, gchar **devices_arg) {
+    guint i = 0;
+    guint args_length = g_strv_length ((gchar **) args);
 
     /* allocate enough space for the args plus "lvm", "--config", "--devices" and NULL */
     const gchar **argv = g_new0 (const gchar*, args_length + 4);
@@ -423,231 +574,409 @@ static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg
     argv[0] = "lvm";
     for (i=0; i < args_length; i++)
         argv[i+1] = args[i];
-    if (global_config_str) {
-        config_arg = g_strdup_printf ("--config=%s", global_config_str);
-        argv[++args_length] = config_arg;
+    if (cfg->config) {
+        *config_arg = g_strdup_printf ("--config=%s", cfg->config);
+        argv[++args_length] = *config_arg;
     }
-    if (global_devices_str) {
-        devices_arg = g_strdup_printf ("--devices=%s", global_devices_str);
-        argv[++args_length] = devices_arg;
+    if (cfg->devices) {
+        *devices_arg = g_strdup_printf ("--devices=%s", cfg->devices);
+        argv[++args_length] = *devices_arg;
     }
     argv[++args_length] = NULL;
 
-    success = bd_utils_exec_and_report_error (argv, extra, error);
-    if (lock_config)
-        g_mutex_unlock (&global_config_lock);
+    return argv;
+}
+
+/* @cfg is the config to use or %NULL to use the thread or (a snapshot of) the global one */
+static gboolean call_lvm_and_report_error (const gchar **args, const BDExtraArg **extra, LVMConfig *cfg, GError **error) {
+    gboolean success = FALSE;
+    g_autofree gchar *config_arg = NULL;
+    g_autofree gchar *devices_arg = NULL;
+    const gchar **argv = NULL;
+
+    if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    /* the snapshot doesn't change during the run even if the global config does */
+    cfg = cfg ? lvm_config_ref (cfg) : lvm_config_get ();
+    argv = build_lvm_argv (args, cfg, &config_arg, &devices_arg);
+
+    if (shell_usable (argv, extra))
+        success = lvm_shell_run (argv, extra, NULL, error);
+    else
+        success = bd_utils_exec_and_report_error (argv, extra, error);
     g_free (argv);
+    lvm_config_unref (cfg);
+
+    /* the command may have changed which PVs belong to which VGs */
+    pv_map_clear ();
 
     return success;
 }
 
-static gboolean call_lvm_and_capture_output (const gchar **args, const BDExtraArg **extra, gchar **output, GError **error) {
+/* @cfg is the config to use or %NULL to use the thread or (a snapshot of) the global one */
+static gboolean call_lvm_and_capture_output (const gchar **args, const BDExtraArg **extra, LVMConfig *cfg, gchar **output, GError **error) {
     gboolean success = FALSE;
-    guint i = 0;
-    guint args_length = g_strv_length ((gchar **) args);
     g_autofree gchar *config_arg = NULL;
     g_autofree gchar *devices_arg = NULL;
+    const gchar **argv = NULL;
 
     if (!check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return FALSE;
 
-    /* don't allow global config string changes during the run */
-    g_mutex_lock (&global_config_lock);
+    /* the snapshot doesn't change during the run even if the global config does */
+    cfg = cfg ? lvm_config_ref (cfg) : lvm_config_get ();
+    argv = build_lvm_argv (args, cfg, &config_arg, &devices_arg);
 
-    /* allocate enough space for the args plus "lvm", "--config", "--devices" and NULL */
-    const gchar **argv = g_new0 (const gchar*, args_length + 4);
+    if (shell_usable (argv, extra))
+        success = lvm_shell_run (argv, extra, output, error);
+    else
+        success = bd_utils_exec_and_capture_output (argv, extra, output, error);
+    g_free (argv);
+    lvm_config_unref (cfg);
 
-    /* construct argv from args with "lvm" prepended */
-    argv[0] = "lvm";
-    for (i=0; i < args_length; i++)
-        argv[i+1] = args[i];
-    if (global_config_str) {
-        config_arg = g_strdup_printf ("--config=%s", global_config_str);
-        argv[++args_length] = config_arg;
+    return success;
+}
+
+/* returns the line @pos points to (terminating it in place) and moves @pos to
+   the next line, returns %NULL if there are no more lines */
+static gchar* next_line (gchar **pos) {
+    gchar *line = *pos;
+    gchar *end = NULL;
+
+    if (!line)
+        return NULL;
+
+    end = strchr (line, '\n');
+    if (end) {
+        *end = '\0';
+        *pos = end + 1;
+    } else
+        *pos = NULL;
+
+    return line;
+}
+
+/**
+ * parse_lvm_vars:
+ * @str: line of the 'basic' report (with --nameprefixes and --unquoted) to parse,
+ *       the string is modified in place
+ * @row: (out): place to store the parsed items
+ *
+ * The "LVM2_" prefix is removed from the keys and they are converted to lowercase
+ * to get the same field names the JSON report format uses.
+ *
+ * Returns: number of parsed items
+ */
+static guint parse_lvm_vars (gchar *str, ReportRow *row) {
+    gchar *pos = str;
+    gchar *item = NULL;
+    gchar *eq = NULL;
+
+    row->n_items = 0;
+
+    while (*pos) {
+        while (*pos == ' ' || *pos == '\t' || *pos == '\n')
+            pos++;
+        if (*pos == '\0')
+            break;
+
+        item = pos;
+        while (*pos && *pos != ' ' && *pos != '\t' && *pos != '\n')
+            pos++;
+        if (*pos)
+            *(pos++) = '\0';
+
+        eq = strchr (item, '=');
+        if (!eq)
+            /* we only want to process valid items (with the '=' character) */
+            continue;
+        *eq = '\0';
+
+        if (g_str_has_prefix (item, "LVM2_"))
+            item += 5;
+        for (gchar *c = item; *c; c++)
+            *c = g_ascii_tolower (*c);
+
+        row_add (row, item, eq + 1);
     }
-    if (global_devices_str) {
-        devices_arg = g_strdup_printf ("--devices=%s", global_devices_str);
-        argv[++args_length] = devices_arg;
+
+    return row->n_items;
+}
+
+/* runs a full 'pvs' scan to (re)create the PV -> VG mapping */
+static void pv_map_scan (void) {
+    const gchar *args[8] = {"pvs", "--noheadings", "--nameprefixes", "--unquoted",
+                            "-o", "pv_name,vg_name", NULL, NULL};
+    GHashTable *new_vg_pvs = NULL;
+    GHashTable *new_pv_vgs = NULL;
+    GHashTable *vg_lists = NULL;
+    GHashTableIter iter;
+    gpointer key = NULL;
+    gpointer value = NULL;
+    gchar *output = NULL;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    const gchar *pv_name = NULL;
+    const gchar *vg_name = NULL;
+    GPtrArray *list = NULL;
+    ReportRow row;
+
+    if (!call_lvm_and_capture_output (args, NULL, NULL, &output, NULL))
+        return;
+
+    vg_lists = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+    new_pv_vgs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) != 2)
+            continue;
+        pv_name = row_get (&row, "pv_name");
+        vg_name = row_get (&row, "vg_name");
+        if (!pv_name || !vg_name || *vg_name == '\0')
+            /* orphan PVs are not interesting */
+            continue;
+
+        list = g_hash_table_lookup (vg_lists, vg_name);
+        if (!list) {
+            list = g_ptr_array_new_with_free_func (g_free);
+            g_hash_table_insert (vg_lists, g_strdup (vg_name), list);
+        }
+        g_ptr_array_add (list, g_strdup (pv_name));
+        g_hash_table_insert (new_pv_vgs, g_strdup (pv_name), g_strdup (vg_name));
     }
-    argv[++args_length] = NULL;
+    g_free (output);
 
-    success = bd_utils_exec_and_capture_output (argv, extra, output, error);
-    g_mutex_unlock (&global_config_lock);
-    g_free (argv);
+    new_vg_pvs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_strfreev);
+    g_hash_table_iter_init (&iter, vg_lists);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        list = (GPtrArray *) value;
+        g_ptr_array_set_free_func (list, NULL);
+        g_ptr_array_add (list, NULL);
+        g_hash_table_insert (new_vg_pvs, g_strdup ((const gchar *) key), g_ptr_array_free (list, FALSE));
+        /* the array is freed, just remove it from the table */
+        g_hash_table_iter_steal (&iter);
+        g_free (key);
+    }
+    g_hash_table_destroy (vg_lists);
+
+    g_mutex_lock (&pv_map_lock);
+    if (vg_pvs)
+        g_hash_table_destroy (vg_pvs);
+    if (pv_vgs)
+        g_hash_table_destroy (pv_vgs);
+    vg_pvs = new_vg_pvs;
+    pv_vgs = new_pv_vgs;
+    g_mutex_unlock (&pv_map_lock);
+}
 
-    return success;
+/* pv_map_lock needs to be held, returns the comma separated PVs of @vg_name (or NULL) */
+static gchar* pv_map_lookup (const gchar *vg_name, guint *n_devices) {
+    gchar **pvs = NULL;
+
+    if (!vg_pvs || !vg_name)
+        return NULL;
+
+    pvs = g_hash_table_lookup (vg_pvs, vg_name);
+    if (!pvs)
+        return NULL;
+
+    *n_devices = g_strv_length (pvs);
+    return g_strjoinv (",", pvs);
 }
 
 /**
- * parse_lvm_vars:
- * @str: string to parse
- * @num_items: (out): number of parsed items
- *
- * Returns: (transfer full): a GHashTable containing key-value items parsed from the @string
- */
-static GHashTable* parse_lvm_vars (const gchar *str, guint *num_items) {
-    GHashTable *table = NULL;
-    gchar **items = NULL;
-    gchar **item_p = NULL;
-    gchar **key_val = NULL;
-
-    table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-    *num_items = 0;
-
-    items = g_strsplit_set (str, " \t\n", 0);
-    for (item_p=items; *item_p; item_p++) {
-        key_val = g_strsplit (*item_p, "=", 2);
-        if (g_strv_length (key_val) == 2) {
-            /* we only want to process valid lines (with the '=' character) */
-            g_hash_table_insert (table, key_val[0], key_val[1]);
-            g_free (key_val);
-            (*num_items)++;
-        } else
-            /* invalid line, just free key_val */
-            g_strfreev (key_val);
+ * auto_devices_config: (skip)
+ * @vg_name: (nullable): VG the query is for
+ * @device: (nullable): PV the query is for
+ * @n_devices: (out): number of the devices in the returned config
+ *
+ * Returns: (transfer full): config with the devices filter limited to the PVs of
+ *          @vg_name (or the VG @device belongs to or just @device) or %NULL if
+ *          the query shouldn't be scoped
+ */
+static LVMConfig* auto_devices_config (const gchar *vg_name, const gchar *device, guint *n_devices) {
+    LVMConfig *cfg = NULL;
+    LVMConfig *ret = NULL;
+    gchar *devices = NULL;
+    gboolean scanned = FALSE;
+
+    if (!g_atomic_int_get (&use_auto_devices))
+        return NULL;
+
+    cfg = lvm_config_get ();
+    if (cfg->devices) {
+        /* an explicit filter always wins */
+        lvm_config_unref (cfg);
+        return NULL;
     }
 
-    g_strfreev (items);
-    return table;
+    while (!devices) {
+        g_mutex_lock (&pv_map_lock);
+        if (device && pv_vgs)
+            devices = pv_map_lookup (g_hash_table_lookup (pv_vgs, device), n_devices);
+        else if (vg_name)
+            devices = pv_map_lookup (vg_name, n_devices);
+        g_mutex_unlock (&pv_map_lock);
+
+        if (devices || scanned)
+            break;
+        if (device && pv_vgs)
+            /* the mapping is there and doesn't know the device, it can only be an orphan PV */
+            break;
+        pv_map_scan ();
+        scanned = TRUE;
+    }
+
+    if (!devices && device) {
+        devices = g_strdup (device);
+        *n_devices = 1;
+    }
+
+    if (devices)
+        ret = lvm_config_new (cfg->config, devices);
+    g_free (devices);
+    lvm_config_unref (cfg);
+
+    return ret;
+}
+
+/* whether the LV is reported as partial (some of its PVs are missing) */
+static gboolean lv_attr_partial (const gchar *attr) {
+    return attr && strlen (attr) > 8 && attr[8] == 'p';
 }
 
-static BDLVMPVdata* get_pv_data_from_table (GHashTable *table, gboolean free_table) {
+static BDLVMPVdata* get_pv_data_from_row (const ReportRow *row) {
     BDLVMPVdata *data = g_new0 (BDLVMPVdata, 1);
-    gchar *value = NULL;
+    const gchar *value = NULL;
 
-    data->pv_name = g_strdup ((gchar*) g_hash_table_lookup (table, "LVM2_PV_NAME"));
-    data->pv_uuid = g_strdup ((gchar*) g_hash_table_lookup (table, "LVM2_PV_UUID"));
+    data->pv_name = g_strdup (row_get (row, "pv_name"));
+    data->pv_uuid = g_strdup (row_get (row, "pv_uuid"));
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_PV_FREE");
+    value = row_get (row, "pv_free");
     if (value)
         data->pv_free = g_ascii_strtoull (value, NULL, 0);
     else
         data->pv_free = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_PV_SIZE");
+    value = row_get (row, "pv_size");
     if (value)
         data->pv_size = g_ascii_strtoull (value, NULL, 0);
     else
         data->pv_size = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_PE_START");
+    value = row_get (row, "pe_start");
     if (value)
         data->pe_start = g_ascii_strtoull (value, NULL, 0);
     else
         data->pe_start = 0;
 
-    data->vg_name = g_strdup ((gchar*) g_hash_table_lookup (table, "LVM2_VG_NAME"));
-    data->vg_uuid = g_strdup ((gchar*) g_hash_table_lookup (table, "LVM2_VG_UUID"));
+    data->vg_name = g_strdup (row_get (row, "vg_name"));
+    data->vg_uuid = g_strdup (row_get (row, "vg_uuid"));
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_SIZE");
+    value = row_get (row, "vg_size");
     if (value)
         data->vg_size = g_ascii_strtoull (value, NULL, 0);
     else
         data->vg_size = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_FREE");
+    value = row_get (row, "vg_free");
     if (value)
         data->vg_free = g_ascii_strtoull (value, NULL, 0);
     else
         data->vg_free = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_EXTENT_SIZE");
+    value = row_get (row, "vg_extent_size");
     if (value)
         data->vg_extent_size = g_ascii_strtoull (value, NULL, 0);
     else
         data->vg_extent_size = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_EXTENT_COUNT");
+    value = row_get (row, "vg_extent_count");
     if (value)
         data->vg_extent_count = g_ascii_strtoull (value, NULL, 0);
     else
         data->vg_extent_count = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_FREE_COUNT");
+    value = row_get (row, "vg_free_count");
     if (value)
         data->vg_free_count = g_ascii_strtoull (value, NULL, 0);
     else
         data->vg_free_count = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_PV_COUNT");
+    value = row_get (row, "pv_count");
     if (value)
         data->vg_pv_count = g_ascii_strtoull (value, NULL, 0);
     else
         data->vg_pv_count = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_PV_TAGS");
+    value = row_get (row, "pv_tags");
     if (value)
         data->pv_tags = g_strsplit (value, ",", -1);
     else
         data->pv_tags = NULL;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_PV_MISSING");
+    value = row_get (row, "pv_missing");
     data->missing = (g_strcmp0 (value, "missing") == 0);
 
-    if (free_table)
-        g_hash_table_destroy (table);
-
     return data;
 }
 
-static BDLVMVGdata* get_vg_data_from_table (GHashTable *table, gboolean free_table) {
+static BDLVMVGdata* get_vg_data_from_row (const ReportRow *row) {
     BDLVMVGdata *data = g_new0 (BDLVMVGdata, 1);
-    gchar *value = NULL;
+    const gchar *value = NULL;
 
-    data->name = g_strdup (g_hash_table_lookup (table, "LVM2_VG_NAME"));
-    data->uuid = g_strdup (g_hash_table_lookup (table, "LVM2_VG_UUID"));
+    data->name = g_strdup (row_get (row, "vg_name"));
+    data->uuid = g_strdup (row_get (row, "vg_uuid"));
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_SIZE");
+    value = row_get (row, "vg_size");
     if (value)
         data->size = g_ascii_strtoull (value, NULL, 0);
     else
         data->size = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_FREE");
+    value = row_get (row, "vg_free");
     if (value)
         data->free = g_ascii_strtoull (value, NULL, 0);
     else
         data->free= 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_EXTENT_SIZE");
+    value = row_get (row, "vg_extent_size");
     if (value)
         data->extent_size = g_ascii_strtoull (value, NULL, 0);
     else
         data->extent_size = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_EXTENT_COUNT");
+    value = row_get (row, "vg_extent_count");
     if (value)
         data->extent_count = g_ascii_strtoull (value, NULL, 0);
     else
         data->extent_count = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_FREE_COUNT");
+    value = row_get (row, "vg_free_count");
     if (value)
         data->free_count = g_ascii_strtoull (value, NULL, 0);
     else
         data->free_count = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_PV_COUNT");
+    value = row_get (row, "pv_count");
     if (value)
         data->pv_count = g_ascii_strtoull (value, NULL, 0);
     else
         data->pv_count = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_EXPORTED");
+    value = row_get (row, "vg_exported");
     if (value && g_strcmp0 (value, "exported") == 0)
         data->exported = TRUE;
     else
         data->exported = FALSE;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VG_TAGS");
+    value = row_get (row, "vg_tags");
     if (value)
         data->vg_tags = g_strsplit (value, ",", -1);
     else
         data->vg_tags = NULL;
 
-    if (free_table)
-        g_hash_table_destroy (table);
-
     return data;
 }
 
@@ -675,23 +1004,23 @@ static gchar **prepare_sublvs (gchar **values, gchar *extra_value) {
   return values;
 }
 
-static BDLVMLVdata* get_lv_data_from_table (GHashTable *table, gboolean free_table) {
+static BDLVMLVdata* get_lv_data_from_row (const ReportRow *row) {
     BDLVMLVdata *data = g_new0 (BDLVMLVdata, 1);
-    gchar *value = NULL;
+    const gchar *value = NULL;
 
-    data->lv_name = g_strdup (g_hash_table_lookup (table, "LVM2_LV_NAME"));
-    data->vg_name = g_strdup (g_hash_table_lookup (table, "LVM2_VG_NAME"));
-    data->uuid = g_strdup (g_hash_table_lookup (table, "LVM2_LV_UUID"));
+    data->lv_name = g_strdup (row_get (row, "lv_name"));
+    data->vg_name = g_strdup (row_get (row, "vg_name"));
+    data->uuid = g_strdup (row_get (row, "lv_uuid"));
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_LV_SIZE");
+    value = row_get (row, "lv_size");
     if (value)
         data->size = g_ascii_strtoull (value, NULL, 0);
     else
         data->size = 0;
 
-    data->attr = g_strdup (g_hash_table_lookup (table, "LVM2_LV_ATTR"));
+    data->attr = g_strdup (row_get (row, "lv_attr"));
 
-    value = g_hash_table_lookup (table, "LVM2_SEGTYPE");
+    value = row_get (row, "segtype");
     if (g_strcmp0 (value, "error") == 0) {
       /* A segment type "error" appears when "vgreduce
        * --removemissing" replaces a missing PV with a device mapper
@@ -703,33 +1032,33 @@ static BDLVMLVdata* get_lv_data_from_table (GHashTable *table, gboolean free_tab
     }
     data->segtype = g_strdup (value);
 
-    data->origin = g_strdup (g_hash_table_lookup (table, "LVM2_ORIGIN"));
-    data->pool_lv = g_strdup (g_hash_table_lookup (table, "LVM2_POOL_LV"));
-    data->data_lv = g_strdup (g_hash_table_lookup (table, "LVM2_DATA_LV"));
-    data->metadata_lv = g_strdup (g_hash_table_lookup (table, "LVM2_METADATA_LV"));
-    data->roles = g_strdup (g_hash_table_lookup (table, "LVM2_LV_ROLE"));
+    data->origin = g_strdup (row_get (row, "origin"));
+    data->pool_lv = g_strdup (row_get (row, "pool_lv"));
+    data->data_lv = g_strdup (row_get (row, "data_lv"));
+    data->metadata_lv = g_strdup (row_get (row, "metadata_lv"));
+    data->roles = g_strdup (row_get (row, "lv_role"));
 
-    data->move_pv = g_strdup (g_hash_table_lookup (table, "LVM2_MOVE_PV"));
+    data->move_pv = g_strdup (row_get (row, "move_pv"));
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_DATA_PERCENT");
+    value = row_get (row, "data_percent");
     if (value)
         data->data_percent = g_ascii_strtoull (value, NULL, 0);
     else
         data->data_percent = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_METADATA_PERCENT");
+    value = row_get (row, "metadata_percent");
     if (value)
         data->metadata_percent = g_ascii_strtoull (value, NULL, 0);
     else
         data->metadata_percent = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_COPY_PERCENT");
+    value = row_get (row, "copy_percent");
     if (value)
         data->copy_percent = g_ascii_strtoull (value, NULL, 0);
     else
         data->copy_percent = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_LV_TAGS");
+    value = row_get (row, "lv_tags");
     if (value)
         data->lv_tags = g_strsplit (value, ",", -1);
     else
@@ -741,7 +1070,7 @@ static BDLVMLVdata* get_lv_data_from_table (GHashTable *table, gboolean free_tab
     g_strstrip (g_strdelimit (data->data_lv, "[]", ' '));
     g_strstrip (g_strdelimit (data->metadata_lv, "[]", ' '));
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_DEVICES");
+    value = row_get (row, "devices");
     if (value) {
       gchar **values = g_strsplit (value, ",", -1);
 
@@ -774,20 +1103,17 @@ static BDLVMLVdata* get_lv_data_from_table (GHashTable *table, gboolean free_tab
           *paren = '\0';
         }
         data->segs[0]->pvdev = g_strdup (values[0]);
-        value = (gchar*) g_hash_table_lookup (table, "LVM2_SEG_SIZE_PE");
+        value = row_get (row, "seg_size_pe");
         if (value)
           data->segs[0]->size_pe = g_ascii_strtoull (value, NULL, 0);
         g_strfreev (values);
       } else {
         data->data_lvs = prepare_sublvs (values, data->data_lv);
-        value = (gchar*) g_hash_table_lookup (table, "LVM2_METADATA_DEVICES");
+        value = row_get (row, "metadata_devices");
         data->metadata_lvs = prepare_sublvs (g_strsplit (value ?: "", ",", -1), data->metadata_lv);
       }
     }
 
-    if (free_table)
-        g_hash_table_destroy (table);
-
     return data;
 }
 
@@ -814,11 +1140,26 @@ static void merge_lv_data (BDLVMLVdata *data, BDLVMLVdata *more_data) {
   }
 }
 
-static BDLVMVDOPooldata* get_vdo_data_from_table (GHashTable *table, gboolean free_table) {
+/* hash and equal functions for a set of LVs identified by (vg_name, lv_name),
+   used to find entries for other segments of the same LV in the lvs output */
+static guint lv_data_hash (gconstpointer key) {
+    const BDLVMLVdata *data = key;
+
+    return g_str_hash (data->vg_name ? data->vg_name : "") * 31 + g_str_hash (data->lv_name ? data->lv_name : "");
+}
+
+static gboolean lv_data_equal (gconstpointer a, gconstpointer b) {
+    const BDLVMLVdata *data_a = a;
+    const BDLVMLVdata *data_b = b;
+
+    return g_strcmp0 (data_a->vg_name, data_b->vg_name) == 0 && g_strcmp0 (data_a->lv_name, data_b->lv_name) == 0;
+}
+
+static BDLVMVDOPooldata* get_vdo_data_from_row (const ReportRow *row) {
     BDLVMVDOPooldata *data = g_new0 (BDLVMVDOPooldata, 1);
-    gchar *value = NULL;
+    const gchar *value = NULL;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_OPERATING_MODE");
+    value = row_get (row, "vdo_operating_mode");
     if (g_strcmp0 (value, "recovering") == 0)
         data->operating_mode = BD_LVM_VDO_MODE_RECOVERING;
     else if (g_strcmp0 (value, "read-only") == 0)
@@ -830,7 +1171,7 @@ static BDLVMVDOPooldata* get_vdo_data_from_table (GHashTable *table, gboolean fr
         data->operating_mode = BD_LVM_VDO_MODE_UNKNOWN;
     }
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_COMPRESSION_STATE");
+    value = row_get (row, "vdo_compression_state");
     if (g_strcmp0 (value, "online") == 0)
         data->compression_state = BD_LVM_VDO_COMPRESSION_ONLINE;
     else if (g_strcmp0 (value, "offline") == 0)
@@ -840,7 +1181,7 @@ static BDLVMVDOPooldata* get_vdo_data_from_table (GHashTable *table, gboolean fr
         data->compression_state = BD_LVM_VDO_COMPRESSION_UNKNOWN;
     }
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_INDEX_STATE");
+    value = row_get (row, "vdo_index_state");
     if (g_strcmp0 (value, "error") == 0)
         data->index_state = BD_LVM_VDO_INDEX_ERROR;
     else if (g_strcmp0 (value, "closed") == 0)
@@ -858,7 +1199,7 @@ static BDLVMVDOPooldata* get_vdo_data_from_table (GHashTable *table, gboolean fr
         data->index_state = BD_LVM_VDO_INDEX_UNKNOWN;
     }
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_WRITE_POLICY");
+    value = row_get (row, "vdo_write_policy");
     if (g_strcmp0 (value, "auto") == 0)
         data->write_policy = BD_LVM_VDO_WRITE_POLICY_AUTO;
     else if (g_strcmp0 (value, "sync") == 0)
@@ -870,42 +1211,115 @@ static BDLVMVDOPooldata* get_vdo_data_from_table (GHashTable *table, gboolean fr
         data->write_policy = BD_LVM_VDO_WRITE_POLICY_UNKNOWN;
     }
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_INDEX_MEMORY_SIZE");
+    value = row_get (row, "vdo_index_memory_size");
     if (value)
         data->index_memory_size = g_ascii_strtoull (value, NULL, 0);
     else
         data->index_memory_size = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_USED_SIZE");
+    value = row_get (row, "vdo_used_size");
     if (value)
         data->used_size = g_ascii_strtoull (value, NULL, 0);
     else
         data->used_size = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_SAVING_PERCENT");
+    value = row_get (row, "vdo_saving_percent");
     if (value)
         data->saving_percent = g_ascii_strtoull (value, NULL, 0);
     else
         data->saving_percent = 0;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_COMPRESSION");
+    value = row_get (row, "vdo_compression");
     if (value && g_strcmp0 (value, "enabled") == 0)
         data->compression = TRUE;
     else
         data->compression = FALSE;
 
-    value = (gchar*) g_hash_table_lookup (table, "LVM2_VDO_DEDUPLICATION");
+    value = row_get (row, "vdo_deduplication");
     if (value && g_strcmp0 (value, "enabled") == 0)
         data->deduplication = TRUE;
     else
         data->deduplication = FALSE;
 
-    if (free_table)
-        g_hash_table_destroy (table);
-
     return data;
 }
 
+/* one item of the "report" array of a JSON report (rows of other reports are skipped) */
+typedef struct JSONReport {
+    GArray *vg;
+    GArray *pv;
+    GArray *lv;
+    GArray *seg;
+} JSONReport;
+
+static JSONReport* json_report_new (void) {
+    JSONReport *report = g_new0 (JSONReport, 1);
+
+    report->vg = g_array_new (FALSE, FALSE, sizeof (ReportRow));
+    report->pv = g_array_new (FALSE, FALSE, sizeof (ReportRow));
+    report->lv = g_array_new (FALSE, FALSE, sizeof (ReportRow));
+    report->seg = g_array_new (FALSE, FALSE, sizeof (ReportRow));
+
+    return report;
+}
+
+static void json_report_free (JSONReport *report) {
+    g_array_free (report->vg, TRUE);
+    g_array_free (report->pv, TRUE);
+    g_array_free (report->lv, TRUE);
+    g_array_free (report->seg, TRUE);
+    g_free (report);
+}
+
+static GArray* json_report_get_rows (JSONReport *report, const gchar *name) {
+    if (g_strcmp0 (name, "vg") == 0)
+        return report->vg;
+    else if (g_strcmp0 (name, "pv") == 0)
+        return report->pv;
+    else if (g_strcmp0 (name, "lv") == 0)
+        return report->lv;
+    else if (g_strcmp0 (name, "seg") == 0)
+        return report->seg;
+    else
+        return NULL;
+}
+
+static void add_json_report_row (const gchar *section, guint report_idx, const ReportRow *row, gpointer user_data) {
+    GPtrArray *reports = user_data;
+    GArray *rows = NULL;
+
+    /* not interested in the command log */
+    if (g_strcmp0 (section, "log") == 0)
+        return;
+
+    while (reports->len <= report_idx)
+        g_ptr_array_add (reports, json_report_new ());
+
+    rows = json_report_get_rows (g_ptr_array_index (reports, report_idx), section);
+    if (rows)
+        g_array_append_val (rows, *row);
+}
+
+/**
+ * parse_lvm_json_report: (skip)
+ * @json: the JSON report (--reportformat json) produced by LVM, the string is
+ *        modified in place and must not be freed before the result
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (element-type JSONReport): items of the "report"
+ *          array of the @json report or %NULL in case of error
+ */
+static GPtrArray* parse_lvm_json_report (gchar *json, GError **error) {
+    GPtrArray *reports = g_ptr_array_new_with_free_func ((GDestroyNotify) json_report_free);
+
+    if (!lvm_report_parse_json (json, add_json_report_row, reports, error)) {
+        g_ptr_array_free (reports, TRUE);
+        return NULL;
+    }
+
+    return reports;
+}
+
 /**
  * bd_lvm_is_supported_pe_size:
  * @size: size (in bytes) to test
@@ -1122,7 +1536,7 @@ gboolean bd_lvm_pvcreate (const gchar *device, guint64 data_alignment, guint64 m
         args[next_arg++] = metadata_str;
     }
 
-    ret = call_lvm_and_report_error (args, extra, TRUE, error);
+    ret = call_lvm_and_report_error (args, extra, NULL, error);
     g_free (dataalign_str);
     g_free (metadata_str);
 
@@ -1163,7 +1577,7 @@ gboolean bd_lvm_pvresize (const gchar *device, guint64 size, const BDExtraArg **
 
     args[next_pos] = device;
 
-    ret = call_lvm_and_report_error (args, extra, TRUE, error);
+    ret = call_lvm_and_report_error (args, extra, NULL, error);
     if (to_free_pos > 0)
         g_free ((gchar *) args[to_free_pos]);
 
@@ -1186,7 +1600,7 @@ gboolean bd_lvm_pvremove (const gchar *device, const BDExtraArg **extra, GError
        bug, at least not in this code) */
     const gchar *args[6] = {"pvremove", "--force", "--force", "--yes", device, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 static gboolean extract_pvmove_progress (const gchar *line, guint8 *completion) {
@@ -1230,6 +1644,116 @@ gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **
     return bd_utils_exec_and_report_progress (args, extra, extract_pvmove_progress, &status, error);
 }
 
+/**
+ * bd_lvm_pvmove_start:
+ * @src: the PV device to move extents off of
+ * @dest: (nullable): the PV device to move extents onto or %NULL
+ * @extra: (nullable) (array zero-terminated=1): extra options for the PV move
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Starts moving the extents from the @src PV in the background (see the
+ * '--background' option in pvmove(8)) and returns right after the move is set
+ * up. Use bd_lvm_pvmove_job_get_progress() to check the progress of the move
+ * and bd_lvm_pvmove_job_abort() to abort it. The speed of the move can be
+ * limited with bd_lvm_pvmove_set_throttle().
+ *
+ * If @dest is %NULL, VG allocation rules are used for the extents from the @src
+ * PV (see pvmove(8)).
+ *
+ * Returns: (transfer full): a job representing the running move or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+BDLVMPVMoveJob* bd_lvm_pvmove_start (const gchar *src, const gchar *dest, const BDExtraArg **extra, GError **error) {
+    const gchar *args[5] = {"pvmove", "--background", src, NULL, NULL};
+    BDLVMPVdata *pvdata = NULL;
+    BDLVMPVMoveJob *job = NULL;
+
+    pvdata = bd_lvm_pvinfo (src, error);
+    if (!pvdata)
+        return NULL;
+
+    if (!pvdata->vg_name || *(pvdata->vg_name) == '\0') {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "The PV '%s' is not part of any VG", src);
+        bd_lvm_pvdata_free (pvdata);
+        return NULL;
+    }
+
+    job = pvmove_job_new (src, dest, pvdata->vg_name, error);
+    bd_lvm_pvdata_free (pvdata);
+    if (!job)
+        return NULL;
+
+    if (dest)
+        args[3] = dest;
+
+    if (!call_lvm_and_report_error (args, extra, NULL, error)) {
+        bd_lvm_pvmove_job_free (job);
+        return NULL;
+    }
+
+    return job;
+}
+
+/**
+ * bd_lvm_pvmove_job_get_progress:
+ * @job: a job started with bd_lvm_pvmove_start()
+ * @progress: (out): place to store the progress of the move (in percents)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * The progress is taken directly from the status of the DM maps of the move,
+ * no LVM command is run. Once the move is not running anymore (finished or
+ * aborted, see #BDLVMPVMoveJob.aborted), the progress is 100.
+ *
+ * Returns: whether the progress was successfully determined or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pvmove_job_get_progress (BDLVMPVMoveJob *job, gdouble *progress, GError **error) {
+    return pvmove_job_get_progress (job, progress, error);
+}
+
+/**
+ * bd_lvm_pvmove_job_abort:
+ * @job: a job started with bd_lvm_pvmove_start()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Aborts the move, the extents moved so far stay on the destination PV(s).
+ *
+ * Returns: whether the move was successfully aborted or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_job_abort (BDLVMPVMoveJob *job, GError **error) {
+    const gchar *args[4] = {"pvmove", "--abort", job->src, NULL};
+
+    if (!call_lvm_and_report_error (args, NULL, NULL, error))
+        return FALSE;
+
+    job->aborted = TRUE;
+    return TRUE;
+}
+
+/**
+ * bd_lvm_pvmove_set_throttle:
+ * @percent: percentage of time (1 -- 100) the copying of the data is allowed to take
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Limits the share of time the kernel spends copying the data of the moves
+ * (and synchronizing mirrors) so that the other I/O is not affected too much.
+ * The limit is system-wide (it's the 'raid1_resync_throttle' parameter of the
+ * dm_mirror kernel module), use 100 to disable the throttling.
+ *
+ * Returns: whether the throttle was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_pvmove_set_throttle (guint percent, GError **error) {
+    return pvmove_set_throttle (percent, error);
+}
+
 /**
  * bd_lvm_pvscan:
  * @device: (nullable): the device to scan for PVs or %NULL
@@ -1255,7 +1779,7 @@ gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtr
         if (device)
             bd_utils_log_format (BD_UTILS_LOG_WARNING, "Ignoring the device argument in pvscan (cache update not requested)");
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 static gboolean _manage_lvm_tags (const gchar *devspec, const gchar **tags, const gchar *action, const gchar *cmd, GError **error) {
@@ -1272,7 +1796,7 @@ static gboolean _manage_lvm_tags (const gchar *devspec, const gchar **tags, cons
     argv[next_arg++] = devspec;
     argv[next_arg] = NULL;
 
-    success = call_lvm_and_report_error (argv, NULL, TRUE, error);
+    success = call_lvm_and_report_error (argv, NULL, NULL, error);
     g_free (argv);
     return success;
 }
@@ -1305,48 +1829,34 @@ gboolean bd_lvm_delete_pv_tags (const gchar *device, const gchar **tags, GError
     return _manage_lvm_tags (device, tags, "--deltag", "pvchange", error);
 }
 
-/**
- * bd_lvm_pvinfo:
- * @device: a PV to get information about or %NULL
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: (transfer full): information about the PV on the given @device or
- * %NULL in case of error (the @error) gets populated in those cases)
- *
- * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
- */
-BDLVMPVdata* bd_lvm_pvinfo (const gchar *device, GError **error) {
+static BDLVMPVdata* _pvinfo (const gchar *device, LVMConfig *cfg, GError **error) {
     const gchar *args[10] = {"pvs", "--unit=b", "--nosuffix", "--nameprefixes",
                        "--unquoted", "--noheadings",
                        "-o", "pv_name,pv_uuid,pv_free,pv_size,pe_start,vg_name,vg_uuid,vg_size," \
                        "vg_free,vg_extent_size,vg_extent_count,vg_free_count,pv_count,pv_tags,pv_missing",
                        device, NULL};
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
+    BDLVMPVdata *pvdata = NULL;
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, cfg, &output, error);
     if (!success)
         /* the error is already populated from the call */
         return NULL;
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 15)) {
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 15) {
             g_clear_error (error);
-            g_strfreev (lines);
-            return get_pv_data_from_table (table, TRUE);
-        } else
-            if (table)
-                g_hash_table_destroy (table);
+            pvdata = get_pv_data_from_row (&row);
+            g_free (output);
+            return pvdata;
+        }
     }
-    g_strfreev (lines);
+    g_free (output);
 
     /* getting here means no usable info was found */
     g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -1354,6 +1864,33 @@ BDLVMPVdata* bd_lvm_pvinfo (const gchar *device, GError **error) {
     return NULL;
 }
 
+/**
+ * bd_lvm_pvinfo:
+ * @device: a PV to get information about or %NULL
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): information about the PV on the given @device or
+ * %NULL in case of error (the @error) gets populated in those cases)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMPVdata* bd_lvm_pvinfo (const gchar *device, GError **error) {
+    BDLVMPVdata *pvdata = NULL;
+    LVMConfig *scoped = NULL;
+    guint n_devices = 0;
+
+    scoped = device ? auto_devices_config (NULL, device, &n_devices) : NULL;
+    if (scoped) {
+        pvdata = _pvinfo (device, scoped, NULL);
+        lvm_config_unref (scoped);
+        if (pvdata)
+            return pvdata;
+        pv_map_clear ();
+    }
+
+    return _pvinfo (device, NULL, error);
+}
+
 /**
  * bd_lvm_pvs:
  * @error: (out) (optional): place to store error (if any)
@@ -1368,18 +1905,17 @@ BDLVMPVdata** bd_lvm_pvs (GError **error) {
                        "-o", "pv_name,pv_uuid,pv_free,pv_size,pe_start,vg_name,vg_uuid,vg_size," \
                        "vg_free,vg_extent_size,vg_extent_count,vg_free_count,pv_count,pv_tags,pv_missing",
                        NULL};
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
     GPtrArray *pvs;
     BDLVMPVdata *pvdata = NULL;
 
     pvs = g_ptr_array_new ();
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, error);
     if (!success) {
         if (g_error_matches (*error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
             /* no output => no VGs, not an error */
@@ -1395,22 +1931,17 @@ BDLVMPVdata** bd_lvm_pvs (GError **error) {
         }
     }
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 15)) {
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 15) {
             /* valid line, try to parse and record it */
-            pvdata = get_pv_data_from_table (table, TRUE);
+            pvdata = get_pv_data_from_row (&row);
             if (pvdata)
                 g_ptr_array_add (pvs, pvdata);
-        } else
-            if (table)
-                g_hash_table_destroy (table);
+        }
     }
 
-    g_strfreev (lines);
+    g_free (output);
 
     if (pvs->len == 0) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -1453,7 +1984,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
     }
     argv[i] = NULL;
 
-    success = call_lvm_and_report_error (argv, extra, TRUE, error);
+    success = call_lvm_and_report_error (argv, extra, NULL, error);
     g_free ((gchar *) argv[2]);
     g_free (argv);
 
@@ -1474,7 +2005,7 @@ gboolean bd_lvm_vgcreate (const gchar *name, const gchar **pv_list, guint64 pe_s
 gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgremove", "--force", vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1492,7 +2023,7 @@ gboolean bd_lvm_vgremove (const gchar *vg_name, const BDExtraArg **extra, GError
 gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgrename", old_vg_name, new_vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1509,7 +2040,7 @@ gboolean bd_lvm_vgrename (const gchar *old_vg_name, const gchar *new_vg_name, co
 gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgchange", "-ay", vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1526,7 +2057,7 @@ gboolean bd_lvm_vgactivate (const gchar *vg_name, const BDExtraArg **extra, GErr
 gboolean bd_lvm_vgdeactivate (const gchar *vg_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgchange", "-an", vg_name, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1544,7 +2075,7 @@ gboolean bd_lvm_vgdeactivate (const gchar *vg_name, const BDExtraArg **extra, GE
 gboolean bd_lvm_vgextend (const gchar *vg_name, const gchar *device, const BDExtraArg **extra, GError **error) {
     const gchar *args[4] = {"vgextend", vg_name, device, NULL};
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1575,7 +2106,7 @@ gboolean bd_lvm_vgreduce (const gchar *vg_name, const gchar *device, const BDExt
         args[2] = device;
     }
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1614,7 +2145,7 @@ static gboolean _vglock_start_stop (const gchar *vg_name, gboolean start, const
     else
         args[1] = "--lockstop";
 
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 /**
@@ -1647,47 +2178,33 @@ gboolean bd_lvm_vglock_stop (const gchar *vg_name, const BDExtraArg **extra, GEr
     return _vglock_start_stop (vg_name, FALSE, extra, error);
 }
 
-/**
- * bd_lvm_vginfo:
- * @vg_name: a VG to get information about
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: (transfer full): information about the @vg_name VG or %NULL in case
- * of error (the @error) gets populated in those cases)
- *
- * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
- */
-BDLVMVGdata* bd_lvm_vginfo (const gchar *vg_name, GError **error) {
+static BDLVMVGdata* _vginfo (const gchar *vg_name, LVMConfig *cfg, GError **error) {
     const gchar *args[10] = {"vgs", "--noheadings", "--nosuffix", "--nameprefixes",
                        "--unquoted", "--units=b",
                        "-o", "name,uuid,size,free,extent_size,extent_count,free_count,pv_count,vg_exported,vg_tags",
                        vg_name, NULL};
 
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
+    BDLVMVGdata *vgdata = NULL;
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, cfg, &output, error);
     if (!success)
         /* the error is already populated from the call */
         return NULL;
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 10)) {
-            g_strfreev (lines);
-            return get_vg_data_from_table (table, TRUE);
-        } else
-            if (table)
-                g_hash_table_destroy (table);
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 10) {
+            vgdata = get_vg_data_from_row (&row);
+            g_free (output);
+            return vgdata;
+        }
     }
-    g_strfreev (lines);
+    g_free (output);
 
     /* getting here means no usable info was found */
     g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -1695,6 +2212,35 @@ BDLVMVGdata* bd_lvm_vginfo (const gchar *vg_name, GError **error) {
     return NULL;
 }
 
+/**
+ * bd_lvm_vginfo:
+ * @vg_name: a VG to get information about
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): information about the @vg_name VG or %NULL in case
+ * of error (the @error) gets populated in those cases)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMVGdata* bd_lvm_vginfo (const gchar *vg_name, GError **error) {
+    BDLVMVGdata *vgdata = NULL;
+    LVMConfig *scoped = NULL;
+    guint n_devices = 0;
+
+    scoped = auto_devices_config (vg_name, NULL, &n_devices);
+    if (scoped) {
+        vgdata = _vginfo (vg_name, scoped, NULL);
+        lvm_config_unref (scoped);
+        /* PVs added to the VG behind our back would be missing in the scoped report */
+        if (vgdata && vgdata->pv_count == n_devices)
+            return vgdata;
+        bd_lvm_vgdata_free (vgdata);
+        pv_map_clear ();
+    }
+
+    return _vginfo (vg_name, NULL, error);
+}
+
 /**
  * bd_lvm_vgs:
  * @error: (out) (optional): place to store error (if any)
@@ -1708,19 +2254,18 @@ BDLVMVGdata** bd_lvm_vgs (GError **error) {
                       "--unquoted", "--units=b",
                       "-o", "name,uuid,size,free,extent_size,extent_count,free_count,pv_count,vg_tags",
                       NULL};
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
     GPtrArray *vgs;
     BDLVMVGdata *vgdata = NULL;
     GError *l_error = NULL;
 
     vgs = g_ptr_array_new ();
 
-    success = call_lvm_and_capture_output (args, NULL, &output, &l_error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, &l_error);
     if (!success) {
         if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
             /* no output => no VGs, not an error */
@@ -1736,22 +2281,17 @@ BDLVMVGdata** bd_lvm_vgs (GError **error) {
        }
     }
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 9)) {
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 9) {
             /* valid line, try to parse and record it */
-            vgdata = get_vg_data_from_table (table, TRUE);
+            vgdata = get_vg_data_from_row (&row);
             if (vgdata)
                 g_ptr_array_add (vgs, vgdata);
-        } else
-            if (table)
-                g_hash_table_destroy (table);
+        }
     }
 
-    g_strfreev (lines);
+    g_free (output);
 
     if (vgs->len == 0) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -1782,7 +2322,7 @@ gchar* bd_lvm_lvorigin (const gchar *vg_name, const gchar *lv_name, GError **err
     const gchar *args[6] = {"lvs", "--noheadings", "-o", "origin", NULL, NULL};
     args[4] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, error);
     g_free ((gchar *) args[4]);
 
     if (!success)
@@ -1841,7 +2381,7 @@ gboolean bd_lvm_lvcreate (const gchar *vg_name, const gchar *lv_name, guint64 si
 
     args[i] = NULL;
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free (size_str);
     g_free (type_str);
     g_free (args);
@@ -1875,7 +2415,7 @@ gboolean bd_lvm_lvremove (const gchar *vg_name, const gchar *lv_name, gboolean f
 
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[next_arg]);
 
     return success;
@@ -1897,7 +2437,7 @@ gboolean bd_lvm_lvremove (const gchar *vg_name, const gchar *lv_name, gboolean f
  */
 gboolean bd_lvm_lvrename (const gchar *vg_name, const gchar *lv_name, const gchar *new_name, const BDExtraArg **extra, GError **error) {
     const gchar *args[5] = {"lvrename", vg_name, lv_name, new_name, NULL};
-    return call_lvm_and_report_error (args, extra, TRUE, error);
+    return call_lvm_and_report_error (args, extra, NULL, error);
 }
 
 
@@ -1935,7 +2475,7 @@ gboolean bd_lvm_lvresize (const gchar *vg_name, const gchar *lv_name, guint64 si
     lvspec = g_strdup_printf ("%s/%s", vg_name, lv_name);
     args[next_arg++] = lvspec;
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
 
     return success;
@@ -1969,7 +2509,7 @@ gboolean bd_lvm_lvrepair (const gchar *vg_name, const gchar *lv_name, const gcha
     }
     argv[i] = NULL;
 
-    success = call_lvm_and_report_error (argv, extra, TRUE, error);
+    success = call_lvm_and_report_error (argv, extra, NULL, error);
     g_free ((gchar *) argv[3]);
     g_free (argv);
 
@@ -2007,7 +2547,7 @@ gboolean bd_lvm_lvactivate (const gchar *vg_name, const gchar *lv_name, gboolean
     }
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[next_arg]);
 
     return success;
@@ -2031,12 +2571,96 @@ gboolean bd_lvm_lvdeactivate (const gchar *vg_name, const gchar *lv_name, const
 
     args[2] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[2]);
 
     return success;
 }
 
+/**
+ * bd_lvm_lvactivate_many:
+ * @lv_specs: (array zero-terminated=1): LVs to activate, each item can be a
+ *            "VG/LV" name of an LV, a name of a VG (all its LVs are activated)
+ *            or a tag prefixed with '@' (all LVs with the tag are activated)
+ * @ignore_skip: whether to ignore the skip flag or not
+ * @shared: whether to activate the LVs in shared mode (used for shared LVM setups with lvmlockd,
+ *          use %FALSE if not sure)
+ * @extra: (nullable) (array zero-terminated=1): extra options for the LV activation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Activates all the LVs specified by @lv_specs with a single 'lvchange' call
+ * so that the metadata of the VGs is only scanned and locked once. Nothing is
+ * done if @lv_specs is empty.
+ *
+ * Returns: whether the LVs were successfully activated or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_lvactivate_many (const gchar **lv_specs, gboolean ignore_skip, gboolean shared, const BDExtraArg **extra, GError **error) {
+    const gchar **args = NULL;
+    guint num_specs = lv_specs ? g_strv_length ((gchar **) lv_specs) : 0;
+    guint next_arg = 0;
+    guint i = 0;
+    gboolean success = FALSE;
+
+    if (num_specs == 0)
+        return TRUE;
+
+    args = g_new0 (const gchar*, num_specs + 4);
+    args[next_arg++] = "lvchange";
+    args[next_arg++] = shared ? "-asy" : "-ay";
+    if (ignore_skip)
+        args[next_arg++] = "-K";
+    for (i = 0; i < num_specs; i++)
+        args[next_arg++] = lv_specs[i];
+    args[next_arg] = NULL;
+
+    success = call_lvm_and_report_error (args, extra, NULL, error);
+    g_free (args);
+
+    return success;
+}
+
+/**
+ * bd_lvm_lvdeactivate_many:
+ * @lv_specs: (array zero-terminated=1): LVs to deactivate, each item can be a
+ *            "VG/LV" name of an LV, a name of a VG (all its LVs are deactivated)
+ *            or a tag prefixed with '@' (all LVs with the tag are deactivated)
+ * @extra: (nullable) (array zero-terminated=1): extra options for the LV deactivation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Deactivates all the LVs specified by @lv_specs with a single 'lvchange' call
+ * so that the metadata of the VGs is only scanned and locked once. Nothing is
+ * done if @lv_specs is empty.
+ *
+ * Returns: whether the LVs were successfully deactivated or not
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_lvdeactivate_many (const gchar **lv_specs, const BDExtraArg **extra, GError **error) {
+    const gchar **args = NULL;
+    guint num_specs = lv_specs ? g_strv_length ((gchar **) lv_specs) : 0;
+    guint i = 0;
+    gboolean success = FALSE;
+
+    if (num_specs == 0)
+        return TRUE;
+
+    args = g_new0 (const gchar*, num_specs + 3);
+    args[0] = "lvchange";
+    args[1] = "-an";
+    for (i = 0; i < num_specs; i++)
+        args[i + 2] = lv_specs[i];
+    args[num_specs + 2] = NULL;
+
+    success = call_lvm_and_report_error (args, extra, NULL, error);
+    g_free (args);
+
+    return success;
+}
+
 /**
  * bd_lvm_lvsnapshotcreate:
  * @vg_name: name of the VG containing the LV a new snapshot should be created of
@@ -2059,7 +2683,7 @@ gboolean bd_lvm_lvsnapshotcreate (const gchar *vg_name, const gchar *origin_name
     args[3] = g_strdup_printf ("%"G_GUINT64_FORMAT"K", size / 1024);
     args[6] = g_strdup_printf ("%s/%s", vg_name, origin_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
     g_free ((gchar *) args[6]);
 
@@ -2084,7 +2708,7 @@ gboolean bd_lvm_lvsnapshotmerge (const gchar *vg_name, const gchar *snapshot_nam
 
     args[2] = g_strdup_printf ("%s/%s", vg_name, snapshot_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[2]);
 
     return success;
@@ -2122,52 +2746,111 @@ gboolean bd_lvm_delete_lv_tags (const gchar *vg_name, const gchar *lv_name, cons
     return _manage_lvm_tags (lvspec, tags, "--deltag", "lvchange", error);
 }
 
+static gboolean run_batch_op (const BDLVMBatchOp *op, GError **error) {
+    if (!op->vg_name || !op->lv_name) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "The VG and LV names need to be specified for a batch operation");
+        return FALSE;
+    }
+
+    switch (op->type) {
+        case BD_LVM_BATCH_OP_LV_RENAME:
+            if (!op->new_name) {
+                g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                             "No new name specified for renaming '%s/%s'", op->vg_name, op->lv_name);
+                return FALSE;
+            }
+            return bd_lvm_lvrename (op->vg_name, op->lv_name, op->new_name, NULL, error);
+        case BD_LVM_BATCH_OP_LV_ADD_TAGS:
+        case BD_LVM_BATCH_OP_LV_DELETE_TAGS:
+            if (!op->tags) {
+                g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                             "No tags specified for '%s/%s'", op->vg_name, op->lv_name);
+                return FALSE;
+            }
+            if (op->type == BD_LVM_BATCH_OP_LV_ADD_TAGS)
+                return bd_lvm_add_lv_tags (op->vg_name, op->lv_name, (const gchar **) op->tags, error);
+            else
+                return bd_lvm_delete_lv_tags (op->vg_name, op->lv_name, (const gchar **) op->tags, error);
+        default:
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                         "Unknown batch operation type: %d", op->type);
+            return FALSE;
+    }
+}
+
 /**
- * bd_lvm_lvinfo:
- * @vg_name: name of the VG that contains the LV to get information about
- * @lv_name: name of the LV to get information about
+ * bd_lvm_batch_run:
+ * @ops: (array zero-terminated=1): operations to run
+ * @max_workers: maximum number of operations to run in parallel or 0 for the default
+ *               (ignored, see below)
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: (transfer full): information about the @vg_name/@lv_name LV or %NULL in case
- * of error (the @error) gets populated in those cases)
+ * Runs all the independent operations from @ops. A failure of one of the
+ * operations doesn't affect the others, it is reported in the
+ * #BDLVMBatchResult.error field of the particular result.
  *
- * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ * The operations are run one after another, LVM commands modifying the same VG
+ * would wait for each other anyway.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the @ops (one
+ *                                                     entry per operation in the same
+ *                                                     order as in @ops) or %NULL in
+ *                                                     case of error
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_MODIFY
  */
-BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError **error) {
+BDLVMBatchResult** bd_lvm_batch_run (const BDLVMBatchOp **ops, guint max_workers G_GNUC_UNUSED, GError **error) {
+    BDLVMBatchResult **ret = NULL;
+    guint num_ops = 0;
+
+    if (!ops) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "No operations specified");
+        return NULL;
+    }
+
+    for (num_ops = 0; ops[num_ops]; num_ops++);
+    ret = g_new0 (BDLVMBatchResult *, num_ops + 1);
+    for (guint i = 0; i < num_ops; i++) {
+        ret[i] = g_new0 (BDLVMBatchResult, 1);
+        ret[i]->success = run_batch_op (ops[i], &(ret[i]->error));
+    }
+
+    return ret;
+}
+
+static BDLVMLVdata* _lvinfo (const gchar *vg_name, const gchar *lv_name, LVMConfig *cfg, GError **error) {
     const gchar *args[11] = {"lvs", "--noheadings", "--nosuffix", "--nameprefixes",
                        "--unquoted", "--units=b", "-a",
                        "-o", "vg_name,lv_name,lv_uuid,lv_size,lv_attr,segtype,origin,pool_lv,data_lv,metadata_lv,role,move_pv,data_percent,metadata_percent,copy_percent,lv_tags",
                        NULL, NULL};
 
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
+    BDLVMLVdata *lvdata = NULL;
 
     args[9] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, cfg, &output, error);
     g_free ((gchar *) args[9]);
 
     if (!success)
         /* the error is already populated from the call */
         return NULL;
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 16)) {
-            g_strfreev (lines);
-            return get_lv_data_from_table (table, TRUE);
-        } else
-            if (table)
-                g_hash_table_destroy (table);
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 16) {
+            lvdata = get_lv_data_from_row (&row);
+            g_free (output);
+            return lvdata;
+        }
     }
-    g_strfreev (lines);
+    g_free (output);
 
     /* getting here means no usable info was found */
     g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -2175,47 +2858,69 @@ BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError *
     return NULL;
 }
 
-BDLVMLVdata* bd_lvm_lvinfo_tree (const gchar *vg_name, const gchar *lv_name, GError **error) {
+/**
+ * bd_lvm_lvinfo:
+ * @vg_name: name of the VG that contains the LV to get information about
+ * @lv_name: name of the LV to get information about
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): information about the @vg_name/@lv_name LV or %NULL in case
+ * of error (the @error) gets populated in those cases)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError **error) {
+    BDLVMLVdata *lvdata = NULL;
+    LVMConfig *scoped = NULL;
+    guint n_devices = 0;
+
+    scoped = auto_devices_config (vg_name, NULL, &n_devices);
+    if (scoped) {
+        lvdata = _lvinfo (vg_name, lv_name, scoped, NULL);
+        lvm_config_unref (scoped);
+        if (lvdata && !lv_attr_partial (lvdata->attr))
+            return lvdata;
+        bd_lvm_lvdata_free (lvdata);
+        pv_map_clear ();
+    }
+
+    return _lvinfo (vg_name, lv_name, NULL, error);
+}
+
+static BDLVMLVdata* _lvinfo_tree (const gchar *vg_name, const gchar *lv_name, LVMConfig *cfg, GError **error) {
     const gchar *args[11] = {"lvs", "--noheadings", "--nosuffix", "--nameprefixes",
                        "--unquoted", "--units=b", "-a",
                        "-o", "vg_name,lv_name,lv_uuid,lv_size,lv_attr,segtype,origin,pool_lv,data_lv,metadata_lv,role,move_pv,data_percent,metadata_percent,copy_percent,lv_tags,devices,metadata_devices,seg_size_pe",
                        NULL, NULL};
 
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
     BDLVMLVdata *result = NULL;
 
     args[9] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, cfg, &output, error);
     g_free ((gchar *) args[9]);
 
     if (!success)
         /* the error is already populated from the call */
         return NULL;
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 19)) {
-            BDLVMLVdata *lvdata = get_lv_data_from_table (table, TRUE);
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 19) {
+            BDLVMLVdata *lvdata = get_lv_data_from_row (&row);
             if (result) {
                 merge_lv_data (result, lvdata);
                 bd_lvm_lvdata_free (lvdata);
             } else
                 result = lvdata;
-        } else {
-            if (table)
-                g_hash_table_destroy (table);
         }
     }
-    g_strfreev (lines);
+    g_free (output);
 
     if (result == NULL)
       g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -2223,6 +2928,24 @@ BDLVMLVdata* bd_lvm_lvinfo_tree (const gchar *vg_name, const gchar *lv_name, GEr
     return result;
 }
 
+BDLVMLVdata* bd_lvm_lvinfo_tree (const gchar *vg_name, const gchar *lv_name, GError **error) {
+    BDLVMLVdata *lvdata = NULL;
+    LVMConfig *scoped = NULL;
+    guint n_devices = 0;
+
+    scoped = auto_devices_config (vg_name, NULL, &n_devices);
+    if (scoped) {
+        lvdata = _lvinfo_tree (vg_name, lv_name, scoped, NULL);
+        lvm_config_unref (scoped);
+        if (lvdata && !lv_attr_partial (lvdata->attr))
+            return lvdata;
+        bd_lvm_lvdata_free (lvdata);
+        pv_map_clear ();
+    }
+
+    return _lvinfo_tree (vg_name, lv_name, NULL, error);
+}
+
 /**
  * bd_lvm_lvs:
  * @vg_name: (nullable): name of the VG to get information about LVs from
@@ -2239,14 +2962,14 @@ BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error) {
                        "-o", "vg_name,lv_name,lv_uuid,lv_size,lv_attr,segtype,origin,pool_lv,data_lv,metadata_lv,role,move_pv,data_percent,metadata_percent,copy_percent,lv_tags",
                        NULL, NULL};
 
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
     GPtrArray *lvs;
     BDLVMLVdata *lvdata = NULL;
+    GHashTable *lvs_index = NULL;
     GError *l_error = NULL;
 
     lvs = g_ptr_array_new ();
@@ -2254,7 +2977,7 @@ BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error) {
     if (vg_name)
         args[9] = vg_name;
 
-    success = call_lvm_and_capture_output (args, NULL, &output, &l_error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, &l_error);
     if (!success) {
         if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
             /* no output => no LVs, not an error */
@@ -2271,36 +2994,31 @@ BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error) {
         }
     }
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
+    /* the index doesn't own the LVs, they are owned by the lvs array */
+    lvs_index = g_hash_table_new (lv_data_hash, lv_data_equal);
 
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 16)) {
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 16) {
             /* valid line, try to parse and record it */
-            lvdata = get_lv_data_from_table (table, TRUE);
+            lvdata = get_lv_data_from_row (&row);
             if (lvdata) {
                 /* ignore duplicate entries in lvs output, these are caused by multi segments LVs */
-                for (gsize i = 0; i < lvs->len; i++) {
-                    if (g_strcmp0 (((BDLVMLVdata *) g_ptr_array_index (lvs, i))->lv_name, lvdata->lv_name) == 0) {
-                        bd_utils_log_format (BD_UTILS_LOG_DEBUG,
-                                             "Duplicate LV entry for '%s' found in lvs output",
-                                             lvdata->lv_name);
-                        bd_lvm_lvdata_free (lvdata);
-                        lvdata = NULL;
-                        break;
-                    }
-                }
-
-                if (lvdata)
+                if (g_hash_table_contains (lvs_index, lvdata)) {
+                    bd_utils_log_format (BD_UTILS_LOG_DEBUG,
+                                         "Duplicate LV entry for '%s' found in lvs output",
+                                         lvdata->lv_name);
+                    bd_lvm_lvdata_free (lvdata);
+                } else {
+                    g_hash_table_add (lvs_index, lvdata);
                     g_ptr_array_add (lvs, lvdata);
+                }
             }
-        } else
-            if (table)
-                g_hash_table_destroy (table);
+        }
     }
 
-    g_strfreev (lines);
+    g_hash_table_destroy (lvs_index);
+    g_free (output);
 
     if (lvs->len == 0) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -2320,14 +3038,15 @@ BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
                        "-o", "vg_name,lv_name,lv_uuid,lv_size,lv_attr,segtype,origin,pool_lv,data_lv,metadata_lv,role,move_pv,data_percent,metadata_percent,copy_percent,lv_tags,devices,metadata_devices,seg_size_pe",
                        NULL, NULL};
 
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
     GPtrArray *lvs;
     BDLVMLVdata *lvdata = NULL;
+    BDLVMLVdata *other = NULL;
+    GHashTable *lvs_index = NULL;
     GError *l_error = NULL;
 
     lvs = g_ptr_array_new ();
@@ -2335,7 +3054,7 @@ BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
     if (vg_name)
         args[9] = vg_name;
 
-    success = call_lvm_and_capture_output (args, NULL, &output, &l_error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, &l_error);
     if (!success) {
         if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
             /* no output => no LVs, not an error */
@@ -2352,34 +3071,29 @@ BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
         }
     }
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
+    /* the index doesn't own the LVs, they are owned by the lvs array */
+    lvs_index = g_hash_table_new (lv_data_hash, lv_data_equal);
 
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 19)) {
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 19) {
             /* valid line, try to parse and record it */
-            lvdata = get_lv_data_from_table (table, TRUE);
+            lvdata = get_lv_data_from_row (&row);
             if (lvdata) {
-                for (gsize i = 0; i < lvs->len; i++) {
-                    BDLVMLVdata *other = (BDLVMLVdata *) g_ptr_array_index (lvs, i);
-                    if (g_strcmp0 (other->lv_name, lvdata->lv_name) == 0) {
-                        merge_lv_data (other, lvdata);
-                        bd_lvm_lvdata_free (lvdata);
-                        lvdata = NULL;
-                        break;
-                    }
-                }
-
-                if (lvdata)
+                other = g_hash_table_lookup (lvs_index, lvdata);
+                if (other) {
+                    merge_lv_data (other, lvdata);
+                    bd_lvm_lvdata_free (lvdata);
+                } else {
+                    g_hash_table_add (lvs_index, lvdata);
                     g_ptr_array_add (lvs, lvdata);
+                }
             }
-        } else
-            if (table)
-                g_hash_table_destroy (table);
+        }
     }
 
-    g_strfreev (lines);
+    g_hash_table_destroy (lvs_index);
+    g_free (output);
 
     if (lvs->len == 0) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -2393,6 +3107,281 @@ BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error) {
     return (BDLVMLVdata **) g_ptr_array_free (lvs, FALSE);
 }
 
+/**
+ * bd_lvm_lvs_tree_result_set:
+ * @vg_name: (nullable): name of the VG to get information about LVs from
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets the same information as bd_lvm_lvs_tree(), but as one result set --
+ * all the records, arrays and strings live in one block of memory which is
+ * freed at once with the set. This is much cheaper than a list of separately
+ * allocated %BDLVMLVdata for big numbers of LVs. Use bd_lvm_lvdata_copy() on
+ * the items of the set to keep them around without the set.
+ *
+ * Returns: (transfer full): information about LVs found in the given @vg_name
+ * VG or in system if @vg_name is %NULL
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMLVResultSet* bd_lvm_lvs_tree_result_set (const gchar *vg_name, GError **error) {
+    BDLVMLVdata **lvs = NULL;
+
+    lvs = bd_lvm_lvs_tree (vg_name, error);
+    if (!lvs)
+        /* the error is already populated */
+        return NULL;
+
+    return lv_result_set_new (lvs);
+}
+
+/**
+ * bd_lvm_lv_result_set_get:
+ * @set: result set to get the LV from
+ * @index: index of the LV in @set
+ *
+ * Returns: (transfer none) (nullable): information about the @index-th LV in
+ * @set or %NULL if @index is out of range, the data is owned by @set
+ *
+ * Tech category: always available
+ */
+const BDLVMLVdata* bd_lvm_lv_result_set_get (BDLVMLVResultSet *set, guint index) {
+    if (index >= set->n_lvs)
+        return NULL;
+
+    return set->lvs[index];
+}
+
+static void process_full_report (JSONReport *report, GPtrArray *pvs, GPtrArray *vgs, GPtrArray *lvs) {
+    GPtrArray *lv_segs = NULL;
+    GHashTable *segs_by_lv = NULL;
+    ReportRow *vg_row = NULL;
+    ReportRow *row = NULL;
+    ReportRow merged;
+    BDLVMLVdata *lvdata = NULL;
+    BDLVMLVdata *more_data = NULL;
+    const gchar *uuid = NULL;
+
+    /* every item of the full report covers (at most) one VG */
+    for (guint i = 0; i < report->vg->len; i++) {
+        vg_row = &g_array_index (report->vg, ReportRow, i);
+        g_ptr_array_add (vgs, get_vg_data_from_row (vg_row));
+    }
+
+    /* VG information for the PVs is taken from the VG report */
+    for (guint i = 0; i < report->pv->len; i++) {
+        row = &g_array_index (report->pv, ReportRow, i);
+        if (vg_row && g_strcmp0 (row_get (row, "vg_uuid"), row_get (vg_row, "vg_uuid")) == 0) {
+            merged = *row;
+            row_merge (&merged, vg_row);
+            g_ptr_array_add (pvs, get_pv_data_from_row (&merged));
+        } else
+            g_ptr_array_add (pvs, get_pv_data_from_row (row));
+    }
+
+    segs_by_lv = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_ptr_array_unref);
+    for (guint i = 0; i < report->seg->len; i++) {
+        row = &g_array_index (report->seg, ReportRow, i);
+        uuid = row_get (row, "lv_uuid");
+        if (!uuid)
+            continue;
+        lv_segs = g_hash_table_lookup (segs_by_lv, uuid);
+        if (!lv_segs) {
+            lv_segs = g_ptr_array_new ();
+            g_hash_table_insert (segs_by_lv, (gpointer) uuid, lv_segs);
+        }
+        g_ptr_array_add (lv_segs, row);
+    }
+
+    /* every segment row together with its LV row gives the same data as one
+       line of the bd_lvm_lvs_tree() output */
+    for (guint i = 0; i < report->lv->len; i++) {
+        row = &g_array_index (report->lv, ReportRow, i);
+        uuid = row_get (row, "lv_uuid");
+        lv_segs = uuid ? g_hash_table_lookup (segs_by_lv, uuid) : NULL;
+        if (!lv_segs) {
+            g_ptr_array_add (lvs, get_lv_data_from_row (row));
+            continue;
+        }
+
+        lvdata = NULL;
+        for (guint j = 0; j < lv_segs->len; j++) {
+            merged = *row;
+            row_merge (&merged, g_ptr_array_index (lv_segs, j));
+            more_data = get_lv_data_from_row (&merged);
+            if (!lvdata)
+                lvdata = more_data;
+            else {
+                merge_lv_data (lvdata, more_data);
+                bd_lvm_lvdata_free (more_data);
+            }
+        }
+        g_ptr_array_add (lvs, lvdata);
+    }
+
+    g_hash_table_destroy (segs_by_lv);
+}
+
+/**
+ * bd_lvm_lvs_foreach:
+ * @vg_name: (nullable): name of the VG to get information about LVs from
+ * @func: (scope call): function to call for every LV found
+ * @user_data: (closure): data to pass to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Calls @func for every LV found in the given @vg_name VG or in system if
+ * @vg_name is %NULL (the same LVs bd_lvm_lvs() returns) as soon as the
+ * information about it is parsed. The information is only valid during the
+ * call of @func, use bd_lvm_lvdata_copy() to keep it. If @func returns %FALSE,
+ * no more LVs are reported.
+ *
+ * Returns: whether the LVs were successfully listed or not (stopping the
+ *          listing from @func is not an error)
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_lvs_foreach (const gchar *vg_name, BDLVMLVdataFunc func, gpointer user_data, GError **error) {
+    /* sorted so that duplicate entries (see bd_lvm_lvs()) are next to each other */
+    const gchar *args[12] = {"lvs", "--noheadings", "--nosuffix", "--nameprefixes",
+                       "--unquoted", "--units=b", "-a", "--sort=vg_name,lv_name",
+                       "-o", "vg_name,lv_name,lv_uuid,lv_size,lv_attr,segtype,origin,pool_lv,data_lv,metadata_lv,role,move_pv,data_percent,metadata_percent,copy_percent,lv_tags",
+                       NULL, NULL};
+
+    gboolean success = FALSE;
+    gchar *output = NULL;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
+    BDLVMLVdata *lvdata = NULL;
+    BDLVMLVdata *prev = NULL;
+    gboolean parsed = FALSE;
+    gboolean cont = TRUE;
+    GError *l_error = NULL;
+
+    if (vg_name)
+        args[10] = vg_name;
+
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, &l_error);
+    if (!success) {
+        if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
+            /* no output => no LVs, not an error */
+            g_clear_error (&l_error);
+            return TRUE;
+        }
+        /* the error is already populated from the call */
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    pos = output;
+    while (cont && (line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) != 16)
+            continue;
+
+        lvdata = get_lv_data_from_row (&row);
+        if (!lvdata)
+            continue;
+        parsed = TRUE;
+
+        /* only the previous LV needs to be kept to skip the duplicate entries */
+        if (prev && lv_data_equal (prev, lvdata)) {
+            bd_utils_log_format (BD_UTILS_LOG_DEBUG,
+                                 "Duplicate LV entry for '%s' found in lvs output",
+                                 lvdata->lv_name);
+            bd_lvm_lvdata_free (lvdata);
+            continue;
+        }
+        bd_lvm_lvdata_free (prev);
+        prev = lvdata;
+
+        cont = func (lvdata, user_data);
+    }
+    bd_lvm_lvdata_free (prev);
+    g_free (output);
+
+    if (!parsed) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                     "Failed to parse information about LVs");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_lvm_report_all:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets information about all PVs, VGs and LVs (including their segments) in
+ * the system with a single scan of the devices. The LVs have the data_lvs,
+ * metadata_lvs, and segs fields filled (see bd_lvm_lvs_tree()).
+ *
+ * Returns: (transfer full): information about all PVs, VGs and LVs found in
+ * the system or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_BASIC-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMReportdata* bd_lvm_report_all (GError **error) {
+    const gchar *args[27] = {"fullreport", "-a", "--units=b", "--nosuffix", "--reportformat", "json",
+                       "--configreport", "pv", "-o", "pv_name,pv_uuid,pv_free,pv_size,pe_start,vg_name,vg_uuid,pv_tags,pv_missing",
+                       "--configreport", "vg", "-o", "vg_name,vg_uuid,vg_size,vg_free,vg_extent_size,vg_extent_count,vg_free_count,pv_count,vg_exported,vg_tags",
+                       "--configreport", "lv", "-o", "vg_name,lv_name,lv_uuid,lv_size,lv_attr,origin,pool_lv,data_lv,metadata_lv,lv_role,move_pv,data_percent,metadata_percent,copy_percent,lv_tags",
+                       "--configreport", "seg", "-o", "lv_uuid,segtype,devices,metadata_devices,seg_size_pe",
+                       "--configreport", "pvseg", "-o", "pvseg_start",
+                       NULL};
+    gboolean success = FALSE;
+    gchar *output = NULL;
+    GPtrArray *reports = NULL;
+    GPtrArray *pvs = NULL;
+    GPtrArray *vgs = NULL;
+    GPtrArray *lvs = NULL;
+    BDLVMReportdata *data = NULL;
+    GError *l_error = NULL;
+
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, &l_error);
+    if (!success) {
+        if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT))
+            /* no output => nothing found (handled below), not an error */
+            g_clear_error (&l_error);
+        else {
+            /* the error is already populated from the call */
+            g_propagate_error (error, l_error);
+            return NULL;
+        }
+    }
+
+    if (output) {
+        reports = parse_lvm_json_report (output, error);
+        if (!reports) {
+            g_free (output);
+            g_prefix_error (error, "Failed to parse information about PVs, VGs and LVs: ");
+            return NULL;
+        }
+    }
+
+    pvs = g_ptr_array_new ();
+    vgs = g_ptr_array_new ();
+    lvs = g_ptr_array_new ();
+
+    for (guint i = 0; reports && i < reports->len; i++)
+        process_full_report (g_ptr_array_index (reports, i), pvs, vgs, lvs);
+    if (reports)
+        g_ptr_array_free (reports, TRUE);
+    /* the rows of the reports point into the output */
+    g_free (output);
+
+    /* returning NULL-terminated arrays */
+    g_ptr_array_add (pvs, NULL);
+    g_ptr_array_add (vgs, NULL);
+    g_ptr_array_add (lvs, NULL);
+
+    data = g_new0 (BDLVMReportdata, 1);
+    data->pvs = (BDLVMPVdata **) g_ptr_array_free (pvs, FALSE);
+    data->vgs = (BDLVMVGdata **) g_ptr_array_free (vgs, FALSE);
+    data->lvs = (BDLVMLVdata **) g_ptr_array_free (lvs, FALSE);
+
+    return data;
+}
+
 /**
  * bd_lvm_thpoolcreate:
  * @vg_name: name of the VG to create a thin pool in
@@ -2434,7 +3423,7 @@ gboolean bd_lvm_thpoolcreate (const gchar *vg_name, const gchar *lv_name, guint6
 
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
     g_free ((gchar *) args[4]);
     g_free ((gchar *) args[5]);
@@ -2465,7 +3454,7 @@ gboolean bd_lvm_thlvcreate (const gchar *vg_name, const gchar *pool_name, const
     args[2] = g_strdup_printf ("%s/%s", vg_name, pool_name);
     args[4] = g_strdup_printf ("%"G_GUINT64_FORMAT"K", size / 1024);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[2]);
     g_free ((gchar *) args[4]);
 
@@ -2489,7 +3478,7 @@ gchar* bd_lvm_thlvpoolname (const gchar *vg_name, const gchar *lv_name, GError *
     const gchar *args[6] = {"lvs", "--noheadings", "-o", "pool_lv", NULL, NULL};
     args[4] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, error);
     g_free ((gchar *) args[4]);
 
     if (!success)
@@ -2528,111 +3517,292 @@ gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name
 
     args[next_arg] = g_strdup_printf ("%s/%s", vg_name, origin_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[next_arg]);
 
     return success;
 }
 
 /**
- * bd_lvm_set_global_config:
- * @new_config: (nullable): string representation of the new global LVM
- *                            configuration to set or %NULL to reset to default
+ * bd_lvm_thsnapshotcreate_many:
+ * @vg_name: name of the VG containing the thin LVs new snapshots should be created of
+ * @origin_names: (array zero-terminated=1): names of the thin LVs new snapshots should be created of
+ * @snapshot_names: (array zero-terminated=1): names of the to-be-created snapshots (one for
+ *                                              each of @origin_names)
+ * @pool_name: (nullable): name of the thin pool to create the snapshots in or %NULL if not specified
+ * @extra: (nullable) (array zero-terminated=1): extra options for the thin LV snapshot creation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates the snapshots right one after another (see bd_lvm_thsnapshotcreate()).
+ * LVM cannot create multiple snapshots in one command so every snapshot is a
+ * separate change of the VG metadata, but the whole batch either succeeds or
+ * fails -- if creating one of the snapshots fails, the already created ones
+ * are removed. For crash-consistent snapshots of multiple LVs, freeze the file
+ * systems on them (see bd_fs_freeze()) before the call. Enable the persistent
+ * lvm shell (see bd_lvm_set_persistent_shell()) to avoid starting a new LVM
+ * process for every snapshot.
+ *
+ * Returns: whether all the snapshots were successfully created or not
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_CREATE
+ */
+gboolean bd_lvm_thsnapshotcreate_many (const gchar *vg_name, const gchar **origin_names, const gchar **snapshot_names, const gchar *pool_name, const BDExtraArg **extra, GError **error) {
+    guint num_snapshots = origin_names ? g_strv_length ((gchar **) origin_names) : 0;
+    GError *l_error = NULL;
+    guint i = 0;
+
+    if (num_snapshots != (snapshot_names ? g_strv_length ((gchar **) snapshot_names) : 0)) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Number of the snapshot names doesn't match the number of the origin LVs");
+        return FALSE;
+    }
+
+    for (i = 0; i < num_snapshots; i++)
+        if (!bd_lvm_thsnapshotcreate (vg_name, origin_names[i], snapshot_names[i], pool_name, extra, error)) {
+            g_prefix_error (error, "Failed to create the snapshot '%s' of '%s/%s': ",
+                            snapshot_names[i], vg_name, origin_names[i]);
+            break;
+        }
+
+    if (i == num_snapshots)
+        return TRUE;
+
+    /* remove the snapshots created so far (in the reverse order) */
+    while (i > 0) {
+        i--;
+        if (!bd_lvm_lvremove (vg_name, snapshot_names[i], TRUE, NULL, &l_error)) {
+            bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to remove the snapshot '%s/%s': %s",
+                                 vg_name, snapshot_names[i], l_error->message);
+            g_clear_error (&l_error);
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * bd_lvm_set_global_config:
+ * @new_config: (nullable): string representation of the new global LVM
+ *                            configuration to set or %NULL to reset to default
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the new requested global config @new_config was successfully
+ *          set or not
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error G_GNUC_UNUSED) {
+    /* XXX: the error attribute will likely be used in the future when
+       some validation comes into the game */
+
+    /* calls already running keep using the old config */
+    lvm_config_set_global_config (new_config);
+    return TRUE;
+}
+
+/**
+ * bd_lvm_get_global_config:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): a copy of a string representation of the currently
+ *                           set LVM global configuration
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gchar* bd_lvm_get_global_config (GError **error G_GNUC_UNUSED) {
+    LVMConfig *cfg = lvm_config_get_global ();
+    gchar *ret = NULL;
+
+    ret = g_strdup (cfg->config ? cfg->config : "");
+    lvm_config_unref (cfg);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_set_devices_filter:
+ * @devices: (nullable) (array zero-terminated=1): list of devices for lvm commands to work on
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the devices filter was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
+ */
+gboolean bd_lvm_set_devices_filter (const gchar **devices, GError **error) {
+    gchar *devices_str = NULL;
+
+    if (!bd_lvm_is_tech_avail (BD_LVM_TECH_DEVICES, 0, error))
+        return FALSE;
+
+    if (!devices || !(*devices))
+        lvm_config_set_global_devices (NULL);
+    else {
+        devices_str = g_strjoinv (",", (gchar **) devices);
+        lvm_config_set_global_devices (devices_str);
+        g_free (devices_str);
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_lvm_get_devices_filter:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): a copy of a string representation of
+ *                                                     the currently set LVM devices filter
+ *
+ * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
+ */
+gchar** bd_lvm_get_devices_filter (GError **error G_GNUC_UNUSED) {
+    LVMConfig *cfg = lvm_config_get_global ();
+    gchar **ret = NULL;
+
+    if (cfg->devices)
+        ret = g_strsplit (cfg->devices, ",", -1);
+    else
+        ret = NULL;
+    lvm_config_unref (cfg);
+
+    return ret;
+}
+
+/**
+ * bd_lvm_set_thread_config:
+ * @new_config: (nullable): string representation of the LVM configuration to
+ *                          use for calls from the current thread or %NULL for none
+ * @devices: (nullable) (array zero-terminated=1): list of devices for lvm commands
+ *                                                 called from the current thread to
+ *                                                 work on or %NULL for no filter
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Binds @new_config and @devices to the current thread. They are used instead
+ * of the global config (see bd_lvm_set_global_config()) and the global devices
+ * filter (see bd_lvm_set_devices_filter()) by all the LVM functions called from
+ * the current thread until bd_lvm_reset_thread_config() is called. This allows
+ * running operations with different configs and filters from multiple threads
+ * in parallel.
+ *
+ * Returns: whether the thread config was successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_set_thread_config (const gchar *new_config, const gchar **devices, GError **error) {
+    LVMConfig *cfg = NULL;
+    gchar *devices_str = NULL;
+
+    if (devices && *devices) {
+        if (!bd_lvm_is_tech_avail (BD_LVM_TECH_DEVICES, 0, error))
+            return FALSE;
+        devices_str = g_strjoinv (",", (gchar **) devices);
+    }
+
+    cfg = lvm_config_new (new_config, devices_str);
+    lvm_config_set_thread (cfg);
+    lvm_config_unref (cfg);
+    g_free (devices_str);
+
+    return TRUE;
+}
+
+/**
+ * bd_lvm_reset_thread_config:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Makes the LVM functions called from the current thread use the global
+ * config and devices filter again (see bd_lvm_set_thread_config()).
+ *
+ * Returns: whether the thread config was successfully reset or not
+ *
+ * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
+ */
+gboolean bd_lvm_reset_thread_config (GError **error G_GNUC_UNUSED) {
+    lvm_config_set_thread (NULL);
+    return TRUE;
+}
+
+/**
+ * bd_lvm_set_persistent_shell:
+ * @enable: whether to run LVM commands in a persistent 'lvm shell' process or not
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether the new requested global config @new_config was successfully
- *          set or not
+ * Returns: whether the persistent shell mode was successfully set or not
+ *
+ * When enabled, LVM commands are written to a single long-living 'lvm shell'
+ * process (started on the first use) instead of running a new 'lvm' process
+ * for every call. The global config, the devices filter and the extra
+ * arguments are still applied to every command. Commands that cannot be run
+ * in the shell (e.g. #bd_lvm_pvmove reporting progress or commands with
+ * arguments the shell cannot parse) are still run as separate processes.
+ * Disabling the mode stops the shell process.
  *
  * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
  */
-gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error G_GNUC_UNUSED) {
-    /* XXX: the error attribute will likely be used in the future when
-       some validation comes into the game */
-
-    g_mutex_lock (&global_config_lock);
-
-    /* first free the old value */
-    g_free (global_config_str);
+gboolean bd_lvm_set_persistent_shell (gboolean enable, GError **error) {
+    if (enable && !check_deps (&avail_deps, DEPS_LVM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
 
-    /* now store the new one */
-    if (!new_config || g_strcmp0 (new_config, "") == 0)
-         global_config_str = NULL;
-    else
-        global_config_str = g_strdup (new_config);
+    g_atomic_int_set (&use_persistent_shell, enable ? TRUE : FALSE);
+    if (!enable)
+        lvm_shell_stop ();
 
-    g_mutex_unlock (&global_config_lock);
     return TRUE;
 }
 
 /**
- * bd_lvm_get_global_config:
+ * bd_lvm_get_persistent_shell:
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: (transfer full): a copy of a string representation of the currently
- *                           set LVM global configuration
+ * Returns: whether LVM commands are run in a persistent 'lvm shell' process or not
  *
  * Tech category: %BD_LVM_TECH_GLOB_CONF no mode (it is ignored)
  */
-gchar* bd_lvm_get_global_config (GError **error G_GNUC_UNUSED) {
-    gchar *ret = NULL;
-
-    g_mutex_lock (&global_config_lock);
-    ret = g_strdup (global_config_str ? global_config_str : "");
-    g_mutex_unlock (&global_config_lock);
-
-    return ret;
+gboolean bd_lvm_get_persistent_shell (GError **error G_GNUC_UNUSED) {
+    return g_atomic_int_get (&use_persistent_shell);
 }
 
 /**
- * bd_lvm_set_devices_filter:
- * @devices: (nullable) (array zero-terminated=1): list of devices for lvm commands to work on
+ * bd_lvm_set_auto_devices:
+ * @enable: whether to automatically limit the devices LVM scans for queries
+ *          targeting a single PV, VG or LV or not
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: whether the devices filter was successfully set or not
+ * With the automatic devices scoping enabled, bd_lvm_pvinfo(), bd_lvm_vginfo(),
+ * bd_lvm_lvinfo() and bd_lvm_lvinfo_tree() pass the PVs of the target VG to LVM
+ * with '--devices' so that it doesn't need to scan all the block devices in
+ * the system. The mapping between PVs and VGs comes from a single full scan
+ * which is repeated after changes made by this plugin or when a scoped query
+ * doesn't match it (in which case the query is also run again without the
+ * scoping). The scoping is not used if a devices filter is set (see
+ * bd_lvm_set_devices_filter() and bd_lvm_set_thread_config()).
+ *
+ * Returns: whether the automatic devices scoping was successfully set or not
  *
  * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
  */
-gboolean bd_lvm_set_devices_filter (const gchar **devices, GError **error) {
-    if (!bd_lvm_is_tech_avail (BD_LVM_TECH_DEVICES, 0, error))
+gboolean bd_lvm_set_auto_devices (gboolean enable, GError **error) {
+    if (enable && !bd_lvm_is_tech_avail (BD_LVM_TECH_DEVICES, 0, error))
         return FALSE;
 
-    g_mutex_lock (&global_config_lock);
-
-    /* first free the old value */
-    g_free (global_devices_str);
-
-    /* now store the new one */
-    if (!devices || !(*devices))
-        global_devices_str = NULL;
-    else
-        global_devices_str = g_strjoinv (",", (gchar **) devices);
+    /* drop the mapping (if any) first, it is not kept up to date while disabled */
+    pv_map_clear ();
+    g_atomic_int_set (&use_auto_devices, enable ? TRUE : FALSE);
 
-    g_mutex_unlock (&global_config_lock);
     return TRUE;
 }
 
 /**
- * bd_lvm_get_devices_filter:
+ * bd_lvm_get_auto_devices:
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: (transfer full) (array zero-terminated=1): a copy of a string representation of
- *                                                     the currently set LVM devices filter
+ * Returns: whether the automatic devices scoping (see bd_lvm_set_auto_devices())
+ *          is enabled or not
  *
  * Tech category: %BD_LVM_TECH_DEVICES no mode (it is ignored)
  */
-gchar** bd_lvm_get_devices_filter (GError **error G_GNUC_UNUSED) {
-    gchar **ret = NULL;
-
-    g_mutex_lock (&global_config_lock);
-
-    if (global_devices_str)
-        ret = g_strsplit (global_devices_str, ",", -1);
-    else
-        ret = NULL;
-
-    g_mutex_unlock (&global_config_lock);
-
-    return ret;
+gboolean bd_lvm_get_auto_devices (GError **error G_GNUC_UNUSED) {
+    return g_atomic_int_get (&use_auto_devices);
 }
 
 /**
@@ -2810,7 +3980,7 @@ gboolean bd_lvm_cache_create_pool (const gchar *vg_name, const gchar *pool_name,
     }
     name = g_strdup_printf ("%s/%s", vg_name, pool_name);
     args[8] = name;
-    success = call_lvm_and_report_error (args, NULL, TRUE, &l_error);
+    success = call_lvm_and_report_error (args, NULL, NULL, &l_error);
     g_free ((gchar *) args[5]);
     g_free ((gchar *) args[8]);
 
@@ -2843,15 +4013,74 @@ gboolean bd_lvm_cache_create_pool (const gchar *vg_name, const gchar *pool_name,
  * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_cache_attach (const gchar *vg_name, const gchar *data_lv, const gchar *cache_pool_lv, const BDExtraArg **extra, GError **error) {
+    return bd_lvm_cache_attach_with_settings (vg_name, data_lv, cache_pool_lv, NULL, extra, error);
+}
+
+/**
+ * bd_lvm_cache_attach_with_settings:
+ * @vg_name: name of the VG containing the @data_lv and the @cache_pool_lv LVs
+ * @data_lv: data LV to attach the @cache_pool_lv to
+ * @cache_pool_lv: cache pool LV to attach to the @data_lv
+ * @settings: (nullable): settings of the cache or %NULL to use the defaults
+ * @extra: (nullable) (array zero-terminated=1): extra options for the cache attachment
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @cache_pool_lv was successfully attached to the @data_lv or not
+ *
+ * Only the chunk size, migration threshold, policy and policy settings from
+ * @settings can be used for a dm-cache, see #BDLVMCacheSettings.
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_cache_attach_with_settings (const gchar *vg_name, const gchar *data_lv, const gchar *cache_pool_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error) {
     const gchar *args[8] = {"lvconvert", "-y", "--type", "cache", "--cachepool", NULL, NULL, NULL};
+    BDExtraArg **all_extra = NULL;
     gboolean success = FALSE;
 
+    all_extra = cache_settings_to_extra (settings, CACHE_SETTINGS_CACHE, TRUE, extra, error);
+    if (!all_extra)
+        return FALSE;
+
     args[5] = g_strdup_printf ("%s/%s", vg_name, cache_pool_lv);
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, (const BDExtraArg **) all_extra, NULL, error);
 
     g_free ((gchar *) args[5]);
     g_free ((gchar *) args[6]);
+    bd_extra_arg_list_free (all_extra);
+    return success;
+}
+
+/**
+ * bd_lvm_cache_set_settings:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached (dm-cache or writecache) LV to change the cache settings of
+ * @settings: new settings of the cache, only the non-default (non-zero) ones are changed
+ * @extra: (nullable) (array zero-terminated=1): extra options for the change
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the cache settings of the @cached_lv were successfully changed or not
+ *
+ * The chunk size of an existing cache cannot be changed.
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_cache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error) {
+    const gchar *args[3] = {"lvchange", NULL, NULL};
+    BDExtraArg **all_extra = NULL;
+    gboolean success = FALSE;
+
+    all_extra = cache_settings_to_extra (settings, CACHE_SETTINGS_ANY, FALSE, extra, error);
+    if (!all_extra)
+        return FALSE;
+
+    args[1] = g_strdup_printf ("%s/%s", vg_name, cached_lv);
+    success = call_lvm_and_report_error (args, (const BDExtraArg **) all_extra, NULL, error);
+
+    g_free ((gchar *) args[1]);
+    bd_extra_arg_list_free (all_extra);
     return success;
 }
 
@@ -2878,7 +4107,7 @@ gboolean bd_lvm_cache_detach (const gchar *vg_name, const gchar *cached_lv, gboo
 
     args[3] = destroy ? "--uncache" : "--splitcache";
     args[4] = g_strdup_printf ("%s/%s", vg_name, cached_lv);
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
 
     g_free ((gchar *) args[4]);
     return success;
@@ -2966,24 +4195,57 @@ gboolean bd_lvm_cache_create_cached_lv (const gchar *vg_name, const gchar *lv_na
  * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_MODIFY
  */
 gboolean bd_lvm_writecache_attach (const gchar *vg_name, const gchar *data_lv, const gchar *cache_lv, const BDExtraArg **extra, GError **error) {
+    return bd_lvm_writecache_attach_with_settings (vg_name, data_lv, cache_lv, NULL, extra, error);
+}
+
+/**
+ * bd_lvm_writecache_attach_with_settings:
+ * @vg_name: name of the VG containing the @data_lv and the @cache_pool_lv LVs
+ * @data_lv: data LV to attach the @cache_lv to
+ * @cache_lv: cache (fast) LV to attach to the @data_lv
+ * @settings: (nullable): settings of the writecache or %NULL to use the defaults
+ * @extra: (nullable) (array zero-terminated=1): extra options for the cache attachment
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the @cache_lv was successfully attached to the @data_lv or not
+ *
+ * Only the watermarks, number of writeback jobs, autocommit settings and policy
+ * settings from @settings can be used for a writecache, see #BDLVMCacheSettings.
+ *
+ * Note: Both @data_lv and @cache_lv will be deactivated before the operation.
+ *
+ * Tech category: %BD_LVM_TECH_WRITECACHE-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_writecache_attach_with_settings (const gchar *vg_name, const gchar *data_lv, const gchar *cache_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error) {
     const gchar *args[8] = {"lvconvert", "-y", "--type", "writecache", "--cachevol", NULL, NULL, NULL};
+    BDExtraArg **all_extra = NULL;
     gboolean success = FALSE;
 
+    all_extra = cache_settings_to_extra (settings, CACHE_SETTINGS_WRITECACHE, TRUE, extra, error);
+    if (!all_extra)
+        return FALSE;
+
     /* both LVs need to be inactive for the writecache convert to work */
     success = bd_lvm_lvdeactivate (vg_name, data_lv, NULL, error);
-    if (!success)
+    if (!success) {
+        bd_extra_arg_list_free (all_extra);
         return FALSE;
+    }
 
     success = bd_lvm_lvdeactivate (vg_name, cache_lv, NULL, error);
-    if (!success)
+    if (!success) {
+        bd_extra_arg_list_free (all_extra);
         return FALSE;
+    }
 
     args[5] = g_strdup_printf ("%s/%s", vg_name, cache_lv);
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, (const BDExtraArg **) all_extra, NULL, error);
 
     g_free ((gchar *) args[5]);
     g_free ((gchar *) args[6]);
+    bd_extra_arg_list_free (all_extra);
     return success;
 }
 
@@ -3115,27 +4377,11 @@ gchar* bd_lvm_cache_pool_name (const gchar *vg_name, const gchar *cached_lv, GEr
     return pool_name;
 }
 
-/**
- * bd_lvm_cache_stats:
- * @vg_name: name of the VG containing the @cached_lv
- * @cached_lv: cached LV to get stats for
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: stats for the @cached_lv or %NULL in case of error
- *
- * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
- */
-BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+/* translates the VG+LV name of a cached LV into the name of the DM map with
+   the cache target */
+static gchar* get_cache_map_name (const gchar *vg_name, const gchar *cached_lv, GError **error) {
     struct dm_pool *pool = NULL;
-    struct dm_task *task = NULL;
-    struct dm_info info;
-    struct dm_status_cache *status = NULL;
     gchar *map_name = NULL;
-    guint64 start = 0;
-    guint64 length = 0;
-    gchar *type = NULL;
-    gchar *params = NULL;
-    BDLVMCacheStats *ret = NULL;
     BDLVMLVdata *lvdata = NULL;
 
     if (geteuid () != 0) {
@@ -3151,59 +4397,52 @@ BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_l
     pool = dm_pool_create ("bd-pool", 20);
 
     if (g_strcmp0 (lvdata->segtype, "thin-pool") == 0)
-        map_name = dm_build_dm_name (pool, vg_name, lvdata->data_lv, NULL);
+        map_name = g_strdup (dm_build_dm_name (pool, vg_name, lvdata->data_lv, NULL));
     else
-        /* translate the VG+LV name into the DM map name */
-        map_name = dm_build_dm_name (pool, vg_name, cached_lv, NULL);
+        map_name = g_strdup (dm_build_dm_name (pool, vg_name, cached_lv, NULL));
 
     bd_lvm_lvdata_free (lvdata);
+    dm_pool_destroy (pool);
 
-    task = dm_task_create (DM_DEVICE_STATUS);
-    if (!task) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to create DM task for the cache map '%s': ", map_name);
-        dm_pool_destroy (pool);
-        return NULL;
-    }
-
-    if (dm_task_set_name (task, map_name) == 0) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to create DM task for the cache map '%s': ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
-        return NULL;
-    }
+    return map_name;
+}
 
-    if (dm_task_run (task) == 0) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to run the DM task for the cache map '%s': ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
-        return NULL;
-    }
+/**
+ * bd_lvm_cache_stats:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached LV to get stats for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: stats for the @cached_lv or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    struct dm_pool *pool = NULL;
+    struct dm_status_cache *status = NULL;
+    DMSnapshotMap *map = NULL;
+    g_autofree gchar *map_name = NULL;
+    BDLVMCacheStats *ret = NULL;
 
-    if (dm_task_get_info (task, &info) == 0) {
-        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
-                     "Failed to get task info for the cache map '%s': ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
+    map_name = get_cache_map_name (vg_name, cached_lv, error);
+    if (!map_name)
         return NULL;
-    }
 
-    if (!info.exists) {
+    /* the counters need to be current (e.g. for sampling), always get the live
+       status of the map */
+    map = dm_snapshot_map_status (map_name);
+    if (!map) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_NOCACHE,
                      "The cache map '%s' doesn't exist: ", map_name);
-        dm_task_destroy (task);
-        dm_pool_destroy (pool);
         return NULL;
     }
 
-    dm_get_next_target (task, NULL, &start, &length, &type, &params);
+    pool = dm_pool_create ("bd-pool", 20);
 
-    if (dm_get_status_cache (pool, params, &status) == 0) {
+    if (g_strcmp0 (map->target_type, "cache") != 0 || dm_get_status_cache (pool, map->status, &status) == 0) {
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
                      "Failed to get status of the cache map '%s': ", map_name);
-        dm_task_destroy (task);
+        dm_snapshot_map_free (map);
         dm_pool_destroy (pool);
         return NULL;
     }
@@ -3230,18 +4469,143 @@ BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_l
         g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_CACHE_INVAL,
                       "Failed to determine status of the cache from '%"G_GUINT64_FORMAT"': ",
                       status->feature_flags);
-        dm_task_destroy (task);
+        dm_snapshot_map_free (map);
         dm_pool_destroy (pool);
         bd_lvm_cache_stats_free (ret);
         return NULL;
     }
 
-    dm_task_destroy (task);
+    dm_snapshot_map_free (map);
     dm_pool_destroy (pool);
 
     return ret;
 }
 
+/**
+ * bd_lvm_cache_sampler_new:
+ * @vg_name: name of the VG containing the @cached_lv
+ * @cached_lv: cached (dm-cache or writecache) LV to sample stats for
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a sampler for periodic collection of the @cached_lv statistics. The
+ * DM map of the @cached_lv is resolved only once here, each call of
+ * bd_lvm_cache_sampler_sample() then just queries the current status of the
+ * map and computes the differences to the previous sample.
+ *
+ * Returns: (transfer full): a new sampler for @cached_lv or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheSampler* bd_lvm_cache_sampler_new (const gchar *vg_name, const gchar *cached_lv, GError **error) {
+    g_autofree gchar *map_name = NULL;
+
+    map_name = get_cache_map_name (vg_name, cached_lv, error);
+    if (!map_name)
+        return NULL;
+
+    return cache_sampler_new (vg_name, cached_lv, map_name, error);
+}
+
+/**
+ * bd_lvm_cache_sampler_sample:
+ * @sampler: a sampler created with bd_lvm_cache_sampler_new()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Takes a new sample of the cache statistics. The deltas and rates are computed
+ * against the previous sample (or the creation of @sampler for the first one).
+ *
+ * Returns: (transfer full): current cache statistics for the LV of @sampler or
+ *                           %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_CACHE-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMCacheSample* bd_lvm_cache_sampler_sample (BDLVMCacheSampler *sampler, GError **error) {
+    return cache_sampler_sample (sampler, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_new:
+ * @vg_name: name of the VG containing the @pool_name LV
+ * @pool_name: thin pool or VDO pool LV to monitor
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates a monitor for periodic checks of the @pool_name usage. The DM map
+ * with the thin-pool or VDO target of the (active) pool is resolved only once
+ * here, each call of bd_lvm_pool_monitor_sample() then just queries the current
+ * status of the map without running any LVM command.
+ *
+ * Returns: (transfer full): a new monitor for @pool_name or %NULL in case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMPoolMonitor* bd_lvm_pool_monitor_new (const gchar *vg_name, const gchar *pool_name, GError **error) {
+    return pool_monitor_new (vg_name, pool_name, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_sample:
+ * @monitor: a monitor created with bd_lvm_pool_monitor_new()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Gets the current usage of the pool of @monitor. If the data or metadata usage
+ * gets over the thresholds set with bd_lvm_pool_monitor_set_thresholds(), the
+ * threshold function is called (from this function) before returning.
+ *
+ * Returns: (transfer full): current usage of the pool of @monitor or %NULL in
+ *                           case of error
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+BDLVMPoolUsage* bd_lvm_pool_monitor_sample (BDLVMPoolMonitor *monitor, GError **error) {
+    return pool_monitor_sample (monitor, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_set_thresholds:
+ * @monitor: a monitor created with bd_lvm_pool_monitor_new()
+ * @data_percent: data usage (in percents) to call @func at or 0 to disable
+ * @metadata_percent: metadata usage (in percents) to call @func at or 0 to disable
+ *                    (ignored for VDO pools)
+ * @func: (nullable) (scope forever): function to call when the usage gets over
+ *                                    @data_percent or @metadata_percent
+ * @user_data: (closure): data to pass to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * @func is called from bd_lvm_pool_monitor_sample() when the usage gets over
+ * one of the thresholds. It is only called again after the usage drops below
+ * the threshold and gets over it again.
+ *
+ * Returns: whether the thresholds were successfully set or not
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pool_monitor_set_thresholds (BDLVMPoolMonitor *monitor, gdouble data_percent, gdouble metadata_percent, BDLVMPoolThresholdFunc func, gpointer user_data, GError **error) {
+    return pool_monitor_set_thresholds (monitor, data_percent, metadata_percent, func, user_data, error);
+}
+
+/**
+ * bd_lvm_pool_monitor_wait_event:
+ * @monitor: a monitor created with bd_lvm_pool_monitor_new()
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Waits for a DM event of the pool of @monitor since the last sample (or the
+ * last wait). The kernel raises the events e.g. when a thin pool gets over its
+ * low water mark, runs out of space or changes its mode. This blocks until an
+ * event happens so it should only be used from a dedicated thread, with
+ * bd_lvm_pool_monitor_sample() called afterwards.
+ *
+ * Returns: whether an event happened or not (in case of error)
+ *
+ * Tech category: %BD_LVM_TECH_THIN-%BD_LVM_TECH_MODE_QUERY or
+ *                %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
+ */
+gboolean bd_lvm_pool_monitor_wait_event (BDLVMPoolMonitor *monitor, GError **error) {
+    return pool_monitor_wait_event (monitor, error);
+}
+
 /**
  * bd_lvm_thpool_convert:
  * @vg_name: name of the VG to create the new thin pool in
@@ -3266,7 +4630,7 @@ gboolean bd_lvm_thpool_convert (const gchar *vg_name, const gchar *data_lv, cons
 
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[6]);
 
     if (success && name)
@@ -3299,7 +4663,7 @@ gboolean bd_lvm_cache_pool_convert (const gchar *vg_name, const gchar *data_lv,
 
     args[6] = g_strdup_printf ("%s/%s", vg_name, data_lv);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[6]);
 
     if (success && name)
@@ -3328,18 +4692,49 @@ gboolean bd_lvm_cache_pool_convert (const gchar *vg_name, const gchar *data_lv,
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_CREATE
  */
 gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, const gchar *pool_name, guint64 data_size, guint64 virtual_size, guint64 index_memory, gboolean compression, gboolean deduplication, BDLVMVDOWritePolicy write_policy, const BDExtraArg **extra, GError **error) {
+    return bd_lvm_vdo_pool_create_with_settings (vg_name, lv_name, pool_name, data_size, virtual_size, index_memory, compression, deduplication, write_policy, NULL, extra, error);
+}
+
+/**
+ * bd_lvm_vdo_pool_create_with_settings:
+ * @vg_name: name of the VG to create a new LV in
+ * @lv_name: name of the to-be-created VDO LV
+ * @pool_name: (nullable): name of the to-be-created VDO pool LV or %NULL for default name
+ * @data_size: requested size of the data VDO LV (physical size of the @pool_name VDO pool LV)
+ * @virtual_size: requested virtual_size of the @lv_name VDO LV
+ * @index_memory: amount of index memory (in bytes) or 0 for default
+ * @compression: whether to enable compression or not
+ * @deduplication: whether to enable deduplication or not
+ * @write_policy: write policy for the volume
+ * @settings: (nullable): tuning of the VDO pool or %NULL to use the defaults
+ * @extra: (nullable) (array zero-terminated=1): extra options for the VDO LV creation
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the given @vg_name/@lv_name VDO LV was successfully created or not
+ *
+ * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_CREATE
+ */
+gboolean bd_lvm_vdo_pool_create_with_settings (const gchar *vg_name, const gchar *lv_name, const gchar *pool_name, guint64 data_size, guint64 virtual_size, guint64 index_memory, gboolean compression, gboolean deduplication, BDLVMVDOWritePolicy write_policy, const BDLVMVDOSettings *settings, const BDExtraArg **extra, GError **error) {
     const gchar *args[16] = {"lvcreate", "--type", "vdo", "-n", lv_name, "-L", NULL, "-V", NULL,
                              "--compression", compression ? "y" : "n",
                              "--deduplication", deduplication ? "y" : "n",
                              "-y", NULL, NULL};
     gboolean success = FALSE;
-    gchar *old_config = NULL;
+    LVMConfig *global_cfg = NULL;
+    LVMConfig *vdo_cfg = NULL;
+    gchar *vdo_config = NULL;
     const gchar *write_policy_str = NULL;
+    g_autofree gchar *settings_config = NULL;
 
     write_policy_str = bd_lvm_get_vdo_write_policy_str (write_policy, error);
     if (!write_policy_str)
         return FALSE;
 
+    settings_config = vdo_settings_to_config (settings, error);
+    if (!settings_config)
+        return FALSE;
+
     args[6] = g_strdup_printf ("%"G_GUINT64_FORMAT"K", data_size / 1024);
     args[8] = g_strdup_printf ("%"G_GUINT64_FORMAT"K", virtual_size / 1024);
 
@@ -3348,22 +4743,22 @@ gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, con
     } else
         args[14] = vg_name;
 
-    /* index_memory and write_policy can be specified only using the config */
-    g_mutex_lock (&global_config_lock);
-    old_config = global_config_str;
+    /* index_memory, write_policy and the tuning can be specified only using the config
+       (the '--vdosettings' option is not supported by older versions of LVM) */
+    global_cfg = lvm_config_get ();
     if (index_memory != 0)
-        global_config_str = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                                                                     index_memory / (1024 * 1024),
-                                                                                                                                     write_policy_str);
+        vdo_config = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"%s}", global_cfg->config ? global_cfg->config : "",
+                                                                                                                                index_memory / (1024 * 1024),
+                                                                                                                                write_policy_str, settings_config);
     else
-        global_config_str = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                        write_policy_str);
-
-    success = call_lvm_and_report_error (args, extra, FALSE, error);
+        vdo_config = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"%s}", global_cfg->config ? global_cfg->config : "",
+                                                                                   write_policy_str, settings_config);
+    vdo_cfg = lvm_config_new (vdo_config, global_cfg->devices);
+    lvm_config_unref (global_cfg);
+    g_free (vdo_config);
 
-    g_free (global_config_str);
-    global_config_str = old_config;
-    g_mutex_unlock (&global_config_lock);
+    success = call_lvm_and_report_error (args, extra, vdo_cfg, error);
+    lvm_config_unref (vdo_cfg);
 
     g_free ((gchar *) args[6]);
     g_free ((gchar *) args[8]);
@@ -3380,7 +4775,7 @@ static gboolean _vdo_set_compression_deduplication (const gchar *vg_name, const
 
     args[3] = g_strdup_printf ("%s/%s", vg_name, pool_name);
 
-    success = call_lvm_and_report_error (args, extra, TRUE, error);
+    success = call_lvm_and_report_error (args, extra, NULL, error);
     g_free ((gchar *) args[3]);
 
     return success;
@@ -3450,6 +4845,40 @@ gboolean bd_lvm_vdo_disable_deduplication (const gchar *vg_name, const gchar *po
     return _vdo_set_compression_deduplication (vg_name, pool_name, "--deduplication", FALSE, extra, error);
 }
 
+/**
+ * bd_lvm_vdo_pool_set_settings:
+ * @vg_name: name of the VG containing the to-be-changed VDO pool LV
+ * @pool_name: name of the VDO pool LV to change the settings of
+ * @settings: new settings of the VDO pool, only the non-default (non-zero) ones are changed
+ * @extra: (nullable) (array zero-terminated=1): extra options for the VDO change
+ *                                                 (just passed to LVM as is)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the settings of the @vg_name/@pool_name VDO pool LV were successfully changed or not
+ *
+ * The slab size of an existing VDO pool cannot be changed. The new settings
+ * are stored in the LVM metadata and may only be applied when the VDO pool is
+ * activated next time.
+ *
+ * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_MODIFY
+ */
+gboolean bd_lvm_vdo_pool_set_settings (const gchar *vg_name, const gchar *pool_name, const BDLVMVDOSettings *settings, const BDExtraArg **extra, GError **error) {
+    const gchar *args[3] = {"lvchange", NULL, NULL};
+    BDExtraArg **all_extra = NULL;
+    gboolean success = FALSE;
+
+    all_extra = vdo_settings_to_extra (settings, extra, error);
+    if (!all_extra)
+        return FALSE;
+
+    args[1] = g_strdup_printf ("%s/%s", vg_name, pool_name);
+    success = call_lvm_and_report_error (args, (const BDExtraArg **) all_extra, NULL, error);
+
+    g_free ((gchar *) args[1]);
+    bd_extra_arg_list_free (all_extra);
+    return success;
+}
+
 /**
  * bd_lvm_vdo_info:
  * @vg_name: name of the VG that contains the LV to get information about
@@ -3467,34 +4896,31 @@ BDLVMVDOPooldata* bd_lvm_vdo_info (const gchar *vg_name, const gchar *lv_name, G
                        "-o", "vdo_operating_mode,vdo_compression_state,vdo_index_state,vdo_write_policy,vdo_index_memory_size,vdo_used_size,vdo_saving_percent,vdo_compression,vdo_deduplication",
                        NULL, NULL};
 
-    GHashTable *table = NULL;
     gboolean success = FALSE;
     gchar *output = NULL;
-    gchar **lines = NULL;
-    gchar **lines_p = NULL;
-    guint num_items;
+    gchar *pos = NULL;
+    gchar *line = NULL;
+    ReportRow row;
+    BDLVMVDOPooldata *vdodata = NULL;
 
     args[9] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, error);
     g_free ((gchar *) args[9]);
 
     if (!success)
         /* the error is already populated from the call */
         return NULL;
 
-    lines = g_strsplit (output, "\n", 0);
-    g_free (output);
-
-    for (lines_p = lines; *lines_p; lines_p++) {
-        table = parse_lvm_vars ((*lines_p), &num_items);
-        if (table && (num_items == 9)) {
-            g_strfreev (lines);
-            return get_vdo_data_from_table (table, TRUE);
-        } else if (table)
-            g_hash_table_destroy (table);
+    pos = output;
+    while ((line = next_line (&pos))) {
+        if (parse_lvm_vars (line, &row) == 9) {
+            vdodata = get_vdo_data_from_row (&row);
+            g_free (output);
+            return vdodata;
+        }
     }
-    g_strfreev (lines);
+    g_free (output);
 
     /* getting here means no usable info was found */
     g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
@@ -3588,7 +5014,9 @@ gboolean bd_lvm_vdo_pool_convert (const gchar *vg_name, const gchar *pool_lv, co
     guint next_arg = 4;
     gchar *size_str = NULL;
     gchar *lv_spec = NULL;
-    gchar *old_config = NULL;
+    LVMConfig *global_cfg = NULL;
+    LVMConfig *vdo_cfg = NULL;
+    gchar *vdo_config = NULL;
     const gchar *write_policy_str = NULL;
 
     write_policy_str = bd_lvm_get_vdo_write_policy_str (write_policy, error);
@@ -3607,21 +5035,20 @@ gboolean bd_lvm_vdo_pool_convert (const gchar *vg_name, const gchar *pool_lv, co
     args[next_arg++] = lv_spec;
 
     /* index_memory and write_policy can be specified only using the config */
-    g_mutex_lock (&global_config_lock);
-    old_config = global_config_str;
+    global_cfg = lvm_config_get ();
     if (index_memory != 0)
-        global_config_str = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                                                                     index_memory / (1024 * 1024),
-                                                                                                                                     write_policy_str);
+        vdo_config = g_strdup_printf ("%s allocation {vdo_index_memory_size_mb=%"G_GUINT64_FORMAT" vdo_write_policy=\"%s\"}", global_cfg->config ? global_cfg->config : "",
+                                                                                                                              index_memory / (1024 * 1024),
+                                                                                                                              write_policy_str);
     else
-        global_config_str = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"}", old_config ? old_config : "",
-                                                                                        write_policy_str);
+        vdo_config = g_strdup_printf ("%s allocation {vdo_write_policy=\"%s\"}", global_cfg->config ? global_cfg->config : "",
+                                                                                 write_policy_str);
+    vdo_cfg = lvm_config_new (vdo_config, global_cfg->devices);
+    lvm_config_unref (global_cfg);
+    g_free (vdo_config);
 
-    success = call_lvm_and_report_error (args, extra, FALSE, error);
-
-    g_free (global_config_str);
-    global_config_str = old_config;
-    g_mutex_unlock (&global_config_lock);
+    success = call_lvm_and_report_error (args, extra, vdo_cfg, error);
+    lvm_config_unref (vdo_cfg);
 
     g_free (size_str);
     g_free (lv_spec);
@@ -3646,7 +5073,7 @@ gchar* bd_lvm_vdolvpoolname (const gchar *vg_name, const gchar *lv_name, GError
     const gchar *args[6] = {"lvs", "--noheadings", "-o", "pool_lv", NULL, NULL};
     args[4] = g_strdup_printf ("%s/%s", vg_name, lv_name);
 
-    success = call_lvm_and_capture_output (args, NULL, &output, error);
+    success = call_lvm_and_capture_output (args, NULL, NULL, &output, error);
     g_free ((gchar *) args[4]);
 
     if (!success)
@@ -3822,31 +5249,15 @@ GHashTable* bd_lvm_vdo_get_stats_full (const gchar *vg_name, const gchar *pool_n
  * In contrast to @bd_lvm_vdo_get_stats_full this function will only return selected statistics
  * in a fixed structure. In case a value is not available, -1 would be returned.
  *
+ * Only the counters needed for the structure are read and the statistics files
+ * are kept open between calls which makes this function suitable for periodic
+ * monitoring of the VDO pools.
+ *
  * Tech category: %BD_LVM_TECH_VDO-%BD_LVM_TECH_MODE_QUERY
  */
 BDLVMVDOStats* bd_lvm_vdo_get_stats (const gchar *vg_name, const gchar *pool_name, GError **error) {
-    GHashTable *full_stats = NULL;
-    BDLVMVDOStats *stats = NULL;
-
-    full_stats = bd_lvm_vdo_get_stats_full (vg_name, pool_name, error);
-    if (!full_stats)
-        return NULL;
-
-    stats = g_new0 (BDLVMVDOStats, 1);
-    get_stat_val64_default (full_stats, "block_size", &stats->block_size, -1);
-    get_stat_val64_default (full_stats, "logical_block_size", &stats->logical_block_size, -1);
-    get_stat_val64_default (full_stats, "physical_blocks", &stats->physical_blocks, -1);
-    get_stat_val64_default (full_stats, "data_blocks_used", &stats->data_blocks_used, -1);
-    get_stat_val64_default (full_stats, "overhead_blocks_used", &stats->overhead_blocks_used, -1);
-    get_stat_val64_default (full_stats, "logical_blocks_used", &stats->logical_blocks_used, -1);
-    get_stat_val64_default (full_stats, "usedPercent", &stats->used_percent, -1);
-    get_stat_val64_default (full_stats, "savingPercent", &stats->saving_percent, -1);
-    if (!get_stat_val_double (full_stats, "writeAmplificationRatio", &stats->write_amplification_ratio))
-        stats->write_amplification_ratio = -1;
-
-    g_hash_table_destroy (full_stats);
-
-    return stats;
+    g_autofree gchar *kvdo_name = g_strdup_printf ("%s-%s-%s", vg_name, pool_name, VDO_POOL_SUFFIX);
+    return vdo_get_stats (kvdo_name, error);
 }
 
 /* check whether the LVM devices file is enabled by LVM
@@ -3864,7 +5275,7 @@ static gboolean _lvm_devices_enabled () {
     /* try full config first -- if we get something from this it means the feature is
        explicitly enabled or disabled by system lvm.conf or using the --config option */
     args[2] = "full";
-    ret = call_lvm_and_capture_output (args, NULL, &output, &loc_error);
+    ret = call_lvm_and_capture_output (args, NULL, NULL, &output, &loc_error);
     if (ret) {
         scanned = sscanf (output, "use_devicesfile=%u", &enabled);
         g_free (output);
@@ -3881,7 +5292,7 @@ static gboolean _lvm_devices_enabled () {
 
     /* now try default */
     args[2] = "default";
-    ret = call_lvm_and_capture_output (args, NULL, &output, &loc_error);
+    ret = call_lvm_and_capture_output (args, NULL, NULL, &output, &loc_error);
     if (ret) {
         scanned = sscanf (output, "# use_devicesfile=%u", &enabled);
         g_free (output);
@@ -141,6 +141,17 @@ typedef struct BDLVMLVdata {
 void bd_lvm_lvdata_free (BDLVMLVdata *data);
 BDLVMLVdata* bd_lvm_lvdata_copy (BDLVMLVdata *data);
 
+typedef gboolean (*BDLVMLVdataFunc) (BDLVMLVdata *data, gpointer user_data);
+
+typedef struct BDLVMReportdata {
+    BDLVMPVdata **pvs;
+    BDLVMVGdata **vgs;
+    BDLVMLVdata **lvs;
+} BDLVMReportdata;
+
+void bd_lvm_reportdata_free (BDLVMReportdata *data);
+BDLVMReportdata* bd_lvm_reportdata_copy (BDLVMReportdata *data);
+
 typedef struct BDLVMVDOPooldata {
     BDLVMVDOOperatingMode operating_mode;
     BDLVMVDOCompressionState compression_state;
@@ -171,6 +182,22 @@ typedef struct BDLVMVDOStats {
 void bd_lvm_vdo_stats_free (BDLVMVDOStats *stats);
 BDLVMVDOStats* bd_lvm_vdo_stats_copy (BDLVMVDOStats *stats);
 
+typedef struct BDLVMVDOSettings {
+    guint ack_threads;
+    guint bio_threads;
+    guint bio_rotation;
+    guint cpu_threads;
+    guint hash_zone_threads;
+    guint logical_threads;
+    guint physical_threads;
+    guint64 slab_size;
+    guint64 block_map_cache_size;
+    guint64 max_discard;
+} BDLVMVDOSettings;
+
+void bd_lvm_vdo_settings_free (BDLVMVDOSettings *settings);
+BDLVMVDOSettings* bd_lvm_vdo_settings_copy (BDLVMVDOSettings *settings);
+
 typedef struct BDLVMCacheStats {
     guint64 block_size;
     guint64 cache_size;
@@ -188,6 +215,139 @@ typedef struct BDLVMCacheStats {
 void bd_lvm_cache_stats_free (BDLVMCacheStats *data);
 BDLVMCacheStats* bd_lvm_cache_stats_copy (BDLVMCacheStats *data);
 
+typedef struct BDLVMCacheSettings {
+    guint64 chunk_size;
+    guint64 migration_threshold;
+    gchar *policy;
+    gchar *policy_settings;
+    guint high_watermark;
+    guint low_watermark;
+    guint64 writeback_jobs;
+    guint64 autocommit_blocks;
+    guint64 autocommit_time;
+} BDLVMCacheSettings;
+
+void bd_lvm_cache_settings_free (BDLVMCacheSettings *settings);
+BDLVMCacheSettings* bd_lvm_cache_settings_copy (BDLVMCacheSettings *settings);
+
+typedef struct BDLVMCacheSample {
+    gboolean writecache;
+    gdouble interval;
+    guint64 read_hits;
+    guint64 read_misses;
+    guint64 write_hits;
+    guint64 write_misses;
+    guint64 promotions;
+    guint64 demotions;
+    guint64 dirty_blocks;
+    guint64 read_hits_delta;
+    guint64 read_misses_delta;
+    guint64 write_hits_delta;
+    guint64 write_misses_delta;
+    guint64 promotions_delta;
+    guint64 demotions_delta;
+    gdouble read_hits_rate;
+    gdouble read_misses_rate;
+    gdouble write_hits_rate;
+    gdouble write_misses_rate;
+    gdouble promotions_rate;
+    gdouble demotions_rate;
+    gdouble read_hit_ratio;
+    gdouble write_hit_ratio;
+} BDLVMCacheSample;
+
+void bd_lvm_cache_sample_free (BDLVMCacheSample *sample);
+BDLVMCacheSample* bd_lvm_cache_sample_copy (BDLVMCacheSample *sample);
+
+typedef struct BDLVMCacheSampler {
+    gchar *vg_name;
+    gchar *lv_name;
+    gchar *map_name;
+    gint ref_count;
+    GMutex lock;
+    gpointer last;
+} BDLVMCacheSampler;
+
+void bd_lvm_cache_sampler_free (BDLVMCacheSampler *sampler);
+BDLVMCacheSampler* bd_lvm_cache_sampler_copy (BDLVMCacheSampler *sampler);
+
+typedef struct BDLVMPoolUsage {
+    gboolean vdo;
+    guint64 data_used;
+    guint64 data_total;
+    guint64 metadata_used;
+    guint64 metadata_total;
+    gdouble data_percent;
+    gdouble metadata_percent;
+    gboolean read_only;
+    gboolean out_of_space;
+} BDLVMPoolUsage;
+
+void bd_lvm_pool_usage_free (BDLVMPoolUsage *usage);
+BDLVMPoolUsage* bd_lvm_pool_usage_copy (BDLVMPoolUsage *usage);
+
+typedef struct BDLVMPoolMonitor {
+    gchar *vg_name;
+    gchar *pool_name;
+    gchar *map_name;
+    gboolean vdo;
+    gint ref_count;
+    GMutex lock;
+    gpointer priv;
+} BDLVMPoolMonitor;
+
+void bd_lvm_pool_monitor_free (BDLVMPoolMonitor *monitor);
+BDLVMPoolMonitor* bd_lvm_pool_monitor_copy (BDLVMPoolMonitor *monitor);
+
+typedef void (*BDLVMPoolThresholdFunc) (BDLVMPoolMonitor *monitor, BDLVMPoolUsage *usage, gpointer user_data);
+
+typedef struct BDLVMPVMoveJob {
+    gchar *src;
+    gchar *dest;
+    gchar *vg_name;
+    guint64 src_devno;
+    gboolean aborted;
+    gint ref_count;
+} BDLVMPVMoveJob;
+
+void bd_lvm_pvmove_job_free (BDLVMPVMoveJob *job);
+BDLVMPVMoveJob* bd_lvm_pvmove_job_copy (BDLVMPVMoveJob *job);
+
+typedef struct BDLVMLVResultSet {
+    BDLVMLVdata **lvs;
+    guint n_lvs;
+    gint ref_count;
+} BDLVMLVResultSet;
+
+void bd_lvm_lv_result_set_free (BDLVMLVResultSet *set);
+BDLVMLVResultSet* bd_lvm_lv_result_set_copy (BDLVMLVResultSet *set);
+
+typedef enum {
+    BD_LVM_BATCH_OP_LV_RENAME,
+    BD_LVM_BATCH_OP_LV_ADD_TAGS,
+    BD_LVM_BATCH_OP_LV_DELETE_TAGS,
+} BDLVMBatchOpType;
+
+typedef struct BDLVMBatchOp {
+    BDLVMBatchOpType type;
+    gchar *vg_name;
+    gchar *lv_name;
+    gchar *new_name;
+    gchar **tags;
+} BDLVMBatchOp;
+
+BDLVMBatchOp* bd_lvm_batch_op_new (BDLVMBatchOpType type, const gchar *vg_name, const gchar *lv_name, const gchar *new_name, const gchar **tags);
+BDLVMBatchOp* bd_lvm_batch_op_copy (BDLVMBatchOp *data);
+void bd_lvm_batch_op_free (BDLVMBatchOp *data);
+
+typedef struct BDLVMBatchResult {
+    gboolean success;
+    GError *error;
+} BDLVMBatchResult;
+
+BDLVMBatchResult* bd_lvm_batch_result_copy (BDLVMBatchResult *data);
+void bd_lvm_batch_result_free (BDLVMBatchResult *data);
+
 typedef enum {
     BD_LVM_TECH_BASIC = 0,
     BD_LVM_TECH_BASIC_SNAP,
@@ -238,6 +398,10 @@ gboolean bd_lvm_pvcreate (const gchar *device, guint64 data_alignment, guint64 m
 gboolean bd_lvm_pvresize (const gchar *device, guint64 size, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_pvremove (const gchar *device, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_pvmove (const gchar *src, const gchar *dest, const BDExtraArg **extra, GError **error);
+BDLVMPVMoveJob* bd_lvm_pvmove_start (const gchar *src, const gchar *dest, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_pvmove_job_get_progress (BDLVMPVMoveJob *job, gdouble *progress, GError **error);
+gboolean bd_lvm_pvmove_job_abort (BDLVMPVMoveJob *job, GError **error);
+gboolean bd_lvm_pvmove_set_throttle (guint percent, GError **error);
 gboolean bd_lvm_pvscan (const gchar *device, gboolean update_cache, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_add_pv_tags (const gchar *device, const gchar **tags, GError **error);
 gboolean bd_lvm_delete_pv_tags (const gchar *device, const gchar **tags, GError **error);
@@ -266,42 +430,67 @@ gboolean bd_lvm_lvresize (const gchar *vg_name, const gchar *lv_name, guint64 si
 gboolean bd_lvm_lvrepair (const gchar *vg_name, const gchar *lv_name, const gchar **pv_list, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_lvactivate (const gchar *vg_name, const gchar *lv_name, gboolean ignore_skip, gboolean shared, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_lvdeactivate (const gchar *vg_name, const gchar *lv_name, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_lvactivate_many (const gchar **lv_specs, gboolean ignore_skip, gboolean shared, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_lvdeactivate_many (const gchar **lv_specs, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_lvsnapshotcreate (const gchar *vg_name, const gchar *origin_name, const gchar *snapshot_name, guint64 size, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_lvsnapshotmerge (const gchar *vg_name, const gchar *snapshot_name, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_add_lv_tags (const gchar *vg_name, const gchar *lv_name, const gchar **tags, GError **error);
 gboolean bd_lvm_delete_lv_tags (const gchar *vg_name, const gchar *lv_name, const gchar **tags, GError **error);
+BDLVMBatchResult** bd_lvm_batch_run (const BDLVMBatchOp **ops, guint max_workers, GError **error);
 BDLVMLVdata* bd_lvm_lvinfo (const gchar *vg_name, const gchar *lv_name, GError **error);
 BDLVMLVdata* bd_lvm_lvinfo_tree (const gchar *vg_name, const gchar *lv_name, GError **error);
 BDLVMLVdata** bd_lvm_lvs (const gchar *vg_name, GError **error);
 BDLVMLVdata** bd_lvm_lvs_tree (const gchar *vg_name, GError **error);
+BDLVMLVResultSet* bd_lvm_lvs_tree_result_set (const gchar *vg_name, GError **error);
+const BDLVMLVdata* bd_lvm_lv_result_set_get (BDLVMLVResultSet *set, guint index);
+gboolean bd_lvm_lvs_foreach (const gchar *vg_name, BDLVMLVdataFunc func, gpointer user_data, GError **error);
+BDLVMReportdata* bd_lvm_report_all (GError **error);
 
 gboolean bd_lvm_thpoolcreate (const gchar *vg_name, const gchar *lv_name, guint64 size, guint64 md_size, guint64 chunk_size, const gchar *profile, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_thlvcreate (const gchar *vg_name, const gchar *pool_name, const gchar *lv_name, guint64 size, const BDExtraArg **extra, GError **error);
 gchar* bd_lvm_thlvpoolname (const gchar *vg_name, const gchar *lv_name, GError **error);
 gboolean bd_lvm_thsnapshotcreate (const gchar *vg_name, const gchar *origin_name, const gchar *snapshot_name, const gchar *pool_name, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_thsnapshotcreate_many (const gchar *vg_name, const gchar **origin_names, const gchar **snapshot_names, const gchar *pool_name, const BDExtraArg **extra, GError **error);
 
 gboolean bd_lvm_set_global_config (const gchar *new_config, GError **error);
 gchar* bd_lvm_get_global_config (GError **error);
 
 gboolean bd_lvm_set_devices_filter (const gchar **devices, GError **error);
 gchar** bd_lvm_get_devices_filter (GError **error);
+gboolean bd_lvm_set_thread_config (const gchar *new_config, const gchar **devices, GError **error);
+gboolean bd_lvm_reset_thread_config (GError **error);
+
+gboolean bd_lvm_set_persistent_shell (gboolean enable, GError **error);
+gboolean bd_lvm_get_persistent_shell (GError **error);
+gboolean bd_lvm_set_auto_devices (gboolean enable, GError **error);
+gboolean bd_lvm_get_auto_devices (GError **error);
 
 guint64 bd_lvm_cache_get_default_md_size (guint64 cache_size, GError **error);
 const gchar* bd_lvm_cache_get_mode_str (BDLVMCacheMode mode, GError **error);
 BDLVMCacheMode bd_lvm_cache_get_mode_from_str (const gchar *mode_str, GError **error);
 gboolean bd_lvm_cache_create_pool (const gchar *vg_name, const gchar *pool_name, guint64 pool_size, guint64 md_size, BDLVMCacheMode mode, BDLVMCachePoolFlags flags, const gchar **fast_pvs, GError **error);
 gboolean bd_lvm_cache_attach (const gchar *vg_name, const gchar *data_lv, const gchar *cache_pool_lv, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_cache_attach_with_settings (const gchar *vg_name, const gchar *data_lv, const gchar *cache_pool_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_cache_set_settings (const gchar *vg_name, const gchar *cached_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_cache_detach (const gchar *vg_name, const gchar *cached_lv, gboolean destroy, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_cache_create_cached_lv (const gchar *vg_name, const gchar *lv_name, guint64 data_size, guint64 cache_size, guint64 md_size, BDLVMCacheMode mode, BDLVMCachePoolFlags flags,
                                         const gchar **slow_pvs, const gchar **fast_pvs, GError **error);
 gchar* bd_lvm_cache_pool_name (const gchar *vg_name, const gchar *cached_lv, GError **error);
 BDLVMCacheStats* bd_lvm_cache_stats (const gchar *vg_name, const gchar *cached_lv, GError **error);
+BDLVMCacheSampler* bd_lvm_cache_sampler_new (const gchar *vg_name, const gchar *cached_lv, GError **error);
+BDLVMCacheSample* bd_lvm_cache_sampler_sample (BDLVMCacheSampler *sampler, GError **error);
+BDLVMPoolMonitor* bd_lvm_pool_monitor_new (const gchar *vg_name, const gchar *pool_name, GError **error);
+BDLVMPoolUsage* bd_lvm_pool_monitor_sample (BDLVMPoolMonitor *monitor, GError **error);
+gboolean bd_lvm_pool_monitor_set_thresholds (BDLVMPoolMonitor *monitor, gdouble data_percent, gdouble metadata_percent, BDLVMPoolThresholdFunc func, gpointer user_data, GError **error);
+gboolean bd_lvm_pool_monitor_wait_event (BDLVMPoolMonitor *monitor, GError **error);
 
 gboolean bd_lvm_writecache_attach (const gchar *vg_name, const gchar *data_lv, const gchar *cache_lv, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_writecache_attach_with_settings (const gchar *vg_name, const gchar *data_lv, const gchar *cache_lv, const BDLVMCacheSettings *settings, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_writecache_detach (const gchar *vg_name, const gchar *cached_lv, gboolean destroy, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_writecache_create_cached_lv (const gchar *vg_name, const gchar *lv_name, guint64 data_size, guint64 cache_size, const gchar **slow_pvs, const gchar **fast_pvs, GError **error);
 
 gboolean bd_lvm_vdo_pool_create (const gchar *vg_name, const gchar *lv_name, const gchar *pool_name, guint64 data_size, guint64 virtual_size, guint64 index_memory, gboolean compression, gboolean deduplication, BDLVMVDOWritePolicy write_policy, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_vdo_pool_create_with_settings (const gchar *vg_name, const gchar *lv_name, const gchar *pool_name, guint64 data_size, guint64 virtual_size, guint64 index_memory, gboolean compression, gboolean deduplication, BDLVMVDOWritePolicy write_policy, const BDLVMVDOSettings *settings, const BDExtraArg **extra, GError **error);
 BDLVMVDOPooldata *bd_lvm_vdo_info (const gchar *vg_name, const gchar *lv_name, GError **error);
 
 gboolean bd_lvm_vdo_resize (const gchar *vg_name, const gchar *lv_name, guint64 size, const BDExtraArg **extra, GError **error);
@@ -311,6 +500,7 @@ gboolean bd_lvm_vdo_enable_compression (const gchar *vg_name, const gchar *pool_
 gboolean bd_lvm_vdo_disable_compression (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_vdo_enable_deduplication (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_vdo_disable_deduplication (const gchar *vg_name, const gchar *pool_name, const BDExtraArg **extra, GError **error);
+gboolean bd_lvm_vdo_pool_set_settings (const gchar *vg_name, const gchar *pool_name, const BDLVMVDOSettings *settings, const BDExtraArg **extra, GError **error);
 
 gboolean bd_lvm_thpool_convert (const gchar *vg_name, const gchar *data_lv, const gchar *metadata_lv, const gchar *name, const BDExtraArg **extra, GError **error);
 gboolean bd_lvm_cache_pool_convert (const gchar *vg_name, const gchar *data_lv, const gchar *metadata_lv, const gchar *name, const BDExtraArg **extra, GError **error);
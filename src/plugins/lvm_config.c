@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "lvm_config.h"
+
+/*
+ * The global config and devices filter are kept in an immutable snapshot that
+ * is replaced as a whole when either of them changes. LVM calls take a
+ * reference to the current snapshot when they start and use it for the whole
+ * run so the lock is only held for swapping/referencing the pointer and calls
+ * running in parallel don't block each other (or the setters).
+ */
+static GMutex global_lock;
+static LVMConfig *global_cfg = NULL;
+
+/* config bound to the current thread, overrides the global one */
+static GPrivate thread_cfg = G_PRIVATE_INIT ((GDestroyNotify) lvm_config_unref);
+
+/**
+ * lvm_config_new: (skip)
+ * @config: (nullable): LVM config string or %NULL (or "") for none
+ * @devices: (nullable): comma separated list of devices or %NULL (or "") for none
+ *
+ * Returns: (transfer full): a new config snapshot
+ */
+LVMConfig* lvm_config_new (const gchar *config, const gchar *devices) {
+    LVMConfig *cfg = g_new0 (LVMConfig, 1);
+
+    cfg->ref_count = 1;
+    cfg->config = (config && *config) ? g_strdup (config) : NULL;
+    cfg->devices = (devices && *devices) ? g_strdup (devices) : NULL;
+
+    return cfg;
+}
+
+LVMConfig* lvm_config_ref (LVMConfig *cfg) {
+    g_atomic_int_inc (&(cfg->ref_count));
+    return cfg;
+}
+
+void lvm_config_unref (LVMConfig *cfg) {
+    if (!cfg || !g_atomic_int_dec_and_test (&(cfg->ref_count)))
+        return;
+
+    g_free (cfg->config);
+    g_free (cfg->devices);
+    g_free (cfg);
+}
+
+/**
+ * lvm_config_get: (skip)
+ *
+ * Returns: (transfer full): the config bound to the current thread (see
+ *                           lvm_config_set_thread()) or the current global
+ *                           config snapshot (never %NULL)
+ */
+LVMConfig* lvm_config_get (void) {
+    LVMConfig *cfg = g_private_get (&thread_cfg);
+
+    if (cfg)
+        return lvm_config_ref (cfg);
+
+    return lvm_config_get_global ();
+}
+
+/**
+ * lvm_config_set_thread: (skip)
+ * @cfg: (nullable): config to bind to the current thread or %NULL to use the
+ *                   global config again
+ */
+void lvm_config_set_thread (LVMConfig *cfg) {
+    g_private_replace (&thread_cfg, cfg ? lvm_config_ref (cfg) : NULL);
+}
+
+/**
+ * lvm_config_get_global: (skip)
+ *
+ * Returns: (transfer full): the current global config snapshot (never %NULL)
+ */
+LVMConfig* lvm_config_get_global (void) {
+    LVMConfig *ret = NULL;
+
+    g_mutex_lock (&global_lock);
+    if (!global_cfg)
+        global_cfg = lvm_config_new (NULL, NULL);
+    ret = lvm_config_ref (global_cfg);
+    g_mutex_unlock (&global_lock);
+
+    return ret;
+}
+
+/* replaces the global snapshot with a new one with @config and/or @devices
+   changed (unless the respective set_* is FALSE) */
+static void replace_global (gboolean set_config, const gchar *config, gboolean set_devices, const gchar *devices) {
+    LVMConfig *old_cfg = NULL;
+
+    g_mutex_lock (&global_lock);
+    old_cfg = global_cfg;
+    global_cfg = lvm_config_new (set_config ? config : (old_cfg ? old_cfg->config : NULL),
+                                 set_devices ? devices : (old_cfg ? old_cfg->devices : NULL));
+    g_mutex_unlock (&global_lock);
+
+    /* calls still running with the old snapshot keep their reference */
+    lvm_config_unref (old_cfg);
+}
+
+void lvm_config_set_global_config (const gchar *config) {
+    replace_global (TRUE, config, FALSE, NULL);
+}
+
+void lvm_config_set_global_devices (const gchar *devices) {
+    replace_global (FALSE, NULL, TRUE, devices);
+}
+
+void lvm_config_clear_global (void) {
+    LVMConfig *old_cfg = NULL;
+
+    g_mutex_lock (&global_lock);
+    old_cfg = global_cfg;
+    global_cfg = NULL;
+    g_mutex_unlock (&global_lock);
+
+    lvm_config_unref (old_cfg);
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_LVM_CONFIG
+#define BD_LVM_CONFIG
+
+/**
+ * LVMConfig: (skip)
+ * @config: (nullable): the LVM config string (passed with '--config')
+ * @devices: (nullable): comma separated list of devices (passed with '--devices')
+ *
+ * An immutable, reference counted snapshot of the config used for LVM calls.
+ */
+typedef struct LVMConfig {
+    gint ref_count;
+    gchar *config;
+    gchar *devices;
+} LVMConfig;
+
+LVMConfig* lvm_config_new (const gchar *config, const gchar *devices);
+LVMConfig* lvm_config_ref (LVMConfig *cfg);
+void lvm_config_unref (LVMConfig *cfg);
+
+LVMConfig* lvm_config_get (void);
+void lvm_config_set_thread (LVMConfig *cfg);
+
+LVMConfig* lvm_config_get_global (void);
+void lvm_config_set_global_config (const gchar *config);
+void lvm_config_set_global_devices (const gchar *devices);
+void lvm_config_clear_global (void);
+
+#endif  /* BD_LVM_CONFIG */
@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <blockdev/utils.h>
+
+#include "lvm.h"
+#include "lvm_report.h"
+
+/*
+ * The JSON report format (--reportformat json) used by LVM for both the
+ * regular reports and the command log. LVM only uses objects with string
+ * values for rows and arrays of objects for the report structure so a tiny
+ * parser modifying the report in place is enough here:
+ *
+ *   {"report": [{"vg": [{...}, ...], "lv": [{...}, ...]}, ...], "log": [{...}, ...]}
+ */
+
+const gchar* row_get (const ReportRow *row, const gchar *key) {
+    for (guint i = 0; i < row->n_items; i++)
+        if (strcmp (row->keys[i], key) == 0)
+            return row->values[i];
+
+    return NULL;
+}
+
+void row_add (ReportRow *row, const gchar *key, const gchar *value) {
+    if (row->n_items == MAX_REPORT_FIELDS) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Too many fields in the LVM report, ignoring '%s'", key);
+        return;
+    }
+
+    row->keys[row->n_items] = key;
+    row->values[row->n_items] = value;
+    row->n_items++;
+}
+
+/* adds all items from @more_row that are not in @row to @row */
+void row_merge (ReportRow *row, const ReportRow *more_row) {
+    for (guint i = 0; i < more_row->n_items; i++)
+        if (!row_get (row, more_row->keys[i]))
+            row_add (row, more_row->keys[i], more_row->values[i]);
+}
+
+static void json_skip_whitespace (gchar **pos) {
+    while (g_ascii_isspace (**pos))
+        (*pos)++;
+}
+
+static void set_json_parse_error (const gchar *pos, GError **error) {
+    if (*pos == '\0')
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                     "Failed to parse the JSON report: unexpected end of data");
+    else
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                     "Failed to parse the JSON report: unexpected data at '%.20s'", pos);
+}
+
+/* parses (and unescapes) the JSON string @pos points to in place, returns
+   the resulting string (pointing into the original buffer) */
+static gchar* json_parse_string (gchar **pos, GError **error) {
+    gchar *c = *pos;
+    gchar *out = NULL;
+    gchar *ret = NULL;
+    gunichar uc = 0;
+
+    if (*c != '"') {
+        set_json_parse_error (c, error);
+        return NULL;
+    }
+
+    c++;
+    ret = out = c;
+    for (; *c && *c != '"'; c++) {
+        if (*c != '\\') {
+            *(out++) = *c;
+            continue;
+        }
+
+        c++;
+        switch (*c) {
+            case 'n':
+                *(out++) = '\n';
+                break;
+            case 't':
+                *(out++) = '\t';
+                break;
+            case 'r':
+                *(out++) = '\r';
+                break;
+            case 'b':
+                *(out++) = '\b';
+                break;
+            case 'f':
+                *(out++) = '\f';
+                break;
+            case 'u':
+                if (!g_ascii_isxdigit (c[1]) || !g_ascii_isxdigit (c[2]) ||
+                    !g_ascii_isxdigit (c[3]) || !g_ascii_isxdigit (c[4])) {
+                    set_json_parse_error (c, error);
+                    return NULL;
+                }
+                uc = (g_ascii_xdigit_value (c[1]) << 12) | (g_ascii_xdigit_value (c[2]) << 8) |
+                     (g_ascii_xdigit_value (c[3]) << 4) | g_ascii_xdigit_value (c[4]);
+                /* the UTF-8 sequence (at most 3 bytes) is never longer than the
+                   escape sequence (6 bytes) */
+                out += g_unichar_to_utf8 (uc, out);
+                c += 4;
+                break;
+            case '\0':
+                set_json_parse_error (c, error);
+                return NULL;
+            default:
+                /* '"', '\\' and '/' */
+                *(out++) = *c;
+        }
+    }
+
+    if (*c != '"') {
+        set_json_parse_error (c, error);
+        return NULL;
+    }
+
+    *pos = c + 1;
+    *out = '\0';
+    return ret;
+}
+
+static gboolean json_skip_value (gchar **pos, GError **error) {
+    guint depth = 0;
+
+    json_skip_whitespace (pos);
+    if (**pos == '"')
+        return json_parse_string (pos, error) != NULL;
+
+    if (**pos != '{' && **pos != '[') {
+        /* number, true, false or null */
+        while (**pos && !strchr (",}] \t\r\n", **pos))
+            (*pos)++;
+        return TRUE;
+    }
+
+    do {
+        switch (**pos) {
+            case '"':
+                if (!json_parse_string (pos, error))
+                    return FALSE;
+                break;
+            case '{':
+            case '[':
+                depth++;
+                (*pos)++;
+                break;
+            case '}':
+            case ']':
+                depth--;
+                (*pos)++;
+                break;
+            case '\0':
+                set_json_parse_error (*pos, error);
+                return FALSE;
+            default:
+                (*pos)++;
+        }
+    } while (depth > 0);
+
+    return TRUE;
+}
+
+/* parses an array of report rows (objects with string values) passing them to @func */
+static gboolean json_parse_rows (gchar **pos, const gchar *section, guint report_idx,
+                                 ReportRowFunc func, gpointer user_data, GError **error) {
+    ReportRow row;
+    gchar *key = NULL;
+    gchar *value = NULL;
+
+    json_skip_whitespace (pos);
+    if (**pos != '[') {
+        set_json_parse_error (*pos, error);
+        return FALSE;
+    }
+    (*pos)++;
+
+    json_skip_whitespace (pos);
+    while (**pos == '{') {
+        (*pos)++;
+        row.n_items = 0;
+
+        json_skip_whitespace (pos);
+        while (**pos == '"') {
+            key = json_parse_string (pos, error);
+            if (!key)
+                return FALSE;
+
+            json_skip_whitespace (pos);
+            if (**pos != ':') {
+                set_json_parse_error (*pos, error);
+                return FALSE;
+            }
+            (*pos)++;
+            json_skip_whitespace (pos);
+
+            /* all values are strings in the "json" report format */
+            value = json_parse_string (pos, error);
+            if (!value)
+                return FALSE;
+            row_add (&row, key, value);
+
+            json_skip_whitespace (pos);
+            if (**pos == ',') {
+                (*pos)++;
+                json_skip_whitespace (pos);
+            }
+        }
+
+        if (**pos != '}') {
+            set_json_parse_error (*pos, error);
+            return FALSE;
+        }
+        (*pos)++;
+        func (section, report_idx, &row, user_data);
+
+        json_skip_whitespace (pos);
+        if (**pos == ',') {
+            (*pos)++;
+            json_skip_whitespace (pos);
+        }
+    }
+
+    if (**pos != ']') {
+        set_json_parse_error (*pos, error);
+        return FALSE;
+    }
+    (*pos)++;
+
+    return TRUE;
+}
+
+/* parses one item of the "report" array: {"vg": [...], "pv": [...], ...} */
+static gboolean json_parse_report (gchar **pos, guint report_idx, ReportRowFunc func, gpointer user_data, GError **error) {
+    gchar *key = NULL;
+
+    if (**pos != '{') {
+        set_json_parse_error (*pos, error);
+        return FALSE;
+    }
+    (*pos)++;
+
+    json_skip_whitespace (pos);
+    while (**pos == '"') {
+        key = json_parse_string (pos, error);
+        if (!key)
+            return FALSE;
+
+        json_skip_whitespace (pos);
+        if (**pos != ':') {
+            set_json_parse_error (*pos, error);
+            return FALSE;
+        }
+        (*pos)++;
+
+        if (!json_parse_rows (pos, key, report_idx, func, user_data, error))
+            return FALSE;
+
+        json_skip_whitespace (pos);
+        if (**pos == ',') {
+            (*pos)++;
+            json_skip_whitespace (pos);
+        }
+    }
+
+    if (**pos != '}') {
+        set_json_parse_error (*pos, error);
+        return FALSE;
+    }
+    (*pos)++;
+
+    return TRUE;
+}
+
+/**
+ * lvm_report_parse_json: (skip)
+ * @json: the JSON report (--reportformat json) produced by LVM, the string is
+ *        modified in place and must not be freed while the rows are used
+ * @func: (scope call): function to call for every row of the report
+ * @user_data: (closure): data to pass to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Calls @func for the rows of all the items of the "report" array and for the
+ * rows of the "log" report (if any). Other sections are skipped.
+ *
+ * Returns: whether the @json report was successfully parsed or not
+ */
+gboolean lvm_report_parse_json (gchar *json, ReportRowFunc func, gpointer user_data, GError **error) {
+    gchar *pos = json;
+    gchar *key = NULL;
+    guint report_idx = 0;
+
+    json_skip_whitespace (&pos);
+    if (*pos != '{') {
+        set_json_parse_error (pos, error);
+        return FALSE;
+    }
+    pos++;
+
+    json_skip_whitespace (&pos);
+    while (*pos == '"') {
+        key = json_parse_string (&pos, error);
+        if (!key)
+            return FALSE;
+
+        json_skip_whitespace (&pos);
+        if (*pos != ':') {
+            set_json_parse_error (pos, error);
+            return FALSE;
+        }
+        pos++;
+        json_skip_whitespace (&pos);
+
+        if (g_strcmp0 (key, "log") == 0) {
+            if (!json_parse_rows (&pos, key, 0, func, user_data, error))
+                return FALSE;
+        } else if (g_strcmp0 (key, "report") != 0) {
+            /* not interested in anything else */
+            if (!json_skip_value (&pos, error))
+                return FALSE;
+        } else {
+            if (*pos != '[') {
+                set_json_parse_error (pos, error);
+                return FALSE;
+            }
+            pos++;
+
+            json_skip_whitespace (&pos);
+            while (*pos == '{') {
+                if (!json_parse_report (&pos, report_idx++, func, user_data, error))
+                    return FALSE;
+
+                json_skip_whitespace (&pos);
+                if (*pos == ',') {
+                    pos++;
+                    json_skip_whitespace (&pos);
+                }
+            }
+
+            if (*pos != ']') {
+                set_json_parse_error (pos, error);
+                return FALSE;
+            }
+            pos++;
+        }
+
+        json_skip_whitespace (&pos);
+        if (*pos == ',') {
+            pos++;
+            json_skip_whitespace (&pos);
+        }
+    }
+
+    if (*pos != '}') {
+        set_json_parse_error (pos, error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
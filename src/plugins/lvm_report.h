@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_LVM_REPORT
+#define BD_LVM_REPORT
+
+/* maximum number of fields in a row of any report we use (including merged rows) */
+#define MAX_REPORT_FIELDS 32
+
+/**
+ * ReportRow: (skip)
+ *
+ * One row of an LVM report. The keys are the field names as LVM reports them
+ * in the JSON format (e.g. "lv_name"), both keys and values point directly into
+ * the (modified) output of the LVM command so no copies of the data are made
+ * until the final data structures are created.
+ */
+typedef struct ReportRow {
+    const gchar *keys[MAX_REPORT_FIELDS];
+    const gchar *values[MAX_REPORT_FIELDS];
+    guint n_items;
+} ReportRow;
+
+const gchar* row_get (const ReportRow *row, const gchar *key);
+void row_add (ReportRow *row, const gchar *key, const gchar *value);
+void row_merge (ReportRow *row, const ReportRow *more_row);
+
+/**
+ * ReportRowFunc: (skip)
+ * @section: name of the section the row belongs to ("vg", "pv", "lv", "seg",...
+ *           for the items of the "report" array, "log" for the command log)
+ * @report_idx: index of the item of the "report" array the row belongs to
+ *              (always 0 for the command log)
+ * @row: the row (only valid during the call)
+ * @user_data: user data passed to lvm_report_parse_json()
+ */
+typedef void (*ReportRowFunc) (const gchar *section, guint report_idx, const ReportRow *row, gpointer user_data);
+
+gboolean lvm_report_parse_json (gchar *json, ReportRowFunc func, gpointer user_data, GError **error);
+
+#endif  /* BD_LVM_REPORT */
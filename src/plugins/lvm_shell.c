@@ -0,0 +1,715 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <blockdev/utils.h>
+
+#include "lvm_shell.h"
+#include "lvm_report.h"
+
+/*
+ * A persistent 'lvm shell' co-process used instead of running a new 'lvm'
+ * process for every call. The protocol is the same one lvmdbusd uses --
+ * commands are written to the shell's standard input, reports (in JSON) are
+ * written by LVM to the file descriptor given by the LVM_REPORT_FD environment
+ * variable and the shell prints its prompt to the standard output once the
+ * command is finished. The shell doesn't report exit codes so we enable the
+ * command log report and check the return codes in it.
+ */
+
+#define SHELL_PROMPT "lvm> "
+#define SHELL_BUF_SIZE 64*1024
+
+/* how long (in seconds) to wait for the shell to finish a command, a report
+   command is run in a separate 'lvm' process if it takes longer, any other
+   command is left to finish in the background (not to apply it twice) */
+#define SHELL_TIMEOUT 60
+
+/* make the command log part of the report */
+#define SHELL_LOG_CONFIG "log{report_command_log=1}"
+
+/* ECMD_PROCESSED and ECMD_FAILED in LVM */
+#define SHELL_RET_CODE_OK 1
+#define SHELL_RET_CODE_FAILED 5
+
+#define OPT_NAMEPREFIXES "--nameprefixes"
+#define OPT_UNQUOTED "--unquoted"
+#define OPT_NOHEADINGS "--noheadings"
+#define OPT_CONFIG "--config="
+
+typedef struct LVMShell {
+    GPid pid;
+    gint in_fd;
+    gint out_fd;
+    gint err_fd;
+    gint report_fd;
+} LVMShell;
+
+static GMutex shell_lock;
+static LVMShell *shell = NULL;
+
+/* commands that support '--reportformat json' and need no special treatment
+   of their output (e.g. progress reporting) */
+static const gchar *const shell_commands[] = {
+    "pvs", "vgs", "lvs", "fullreport",
+    "pvcreate", "pvremove", "pvresize", "pvchange", "pvscan",
+    "vgcreate", "vgremove", "vgrename", "vgchange", "vgextend", "vgreduce",
+    "lvcreate", "lvremove", "lvrename", "lvresize", "lvextend", "lvreduce", "lvchange", "lvconvert",
+    NULL
+};
+
+/* commands that don't change anything and so can be safely run again */
+static const gchar *const report_commands[] = {
+    "pvs", "vgs", "lvs", "fullreport", NULL
+};
+
+static gboolean is_in_commands (const gchar *const *commands, const gchar *cmd) {
+    for (const gchar *const *cmd_p = commands; *cmd_p; cmd_p++)
+        if (g_strcmp0 (*cmd_p, cmd) == 0)
+            return TRUE;
+    return FALSE;
+}
+
+static gboolean is_shell_command (const gchar *cmd) {
+    return is_in_commands (shell_commands, cmd);
+}
+
+static GPtrArray* get_shell_args (const gchar **argv, const BDExtraArg **extra) {
+    GPtrArray *args = g_ptr_array_new ();
+    const gchar **arg_p = NULL;
+    const BDExtraArg **extra_p = NULL;
+
+    /* skip the "lvm" in argv[0] */
+    for (arg_p = argv + 1; *arg_p; arg_p++)
+        g_ptr_array_add (args, (gpointer) *arg_p);
+
+    if (extra) {
+        for (extra_p = extra; *extra_p; extra_p++) {
+            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0))
+                g_ptr_array_add (args, (*extra_p)->opt);
+            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0))
+                g_ptr_array_add (args, (*extra_p)->val);
+        }
+    }
+
+    return args;
+}
+
+/* whether @arg can be passed through the shell's very simple command line
+   splitting (whitespace separated, optionally double-quoted, no escaping) */
+static gboolean arg_representable (const gchar *arg) {
+    gboolean has_space = FALSE;
+
+    if (!arg || *arg == '\0')
+        return FALSE;
+
+    for (const gchar *c = arg; *c; c++) {
+        if (*c == '\n')
+            return FALSE;
+        if (g_ascii_isspace (*c))
+            has_space = TRUE;
+    }
+
+    if (strchr (arg, '"') && (has_space || *arg == '"'))
+        return FALSE;
+
+    return TRUE;
+}
+
+/**
+ * lvm_shell_can_run: (skip)
+ * @argv: (array zero-terminated=1): the argv array for the call (starting with "lvm")
+ * @extra: (nullable) (array zero-terminated=1): extra arguments
+ *
+ * Returns: whether the command can be run in the persistent shell or not
+ */
+gboolean lvm_shell_can_run (const gchar **argv, const BDExtraArg **extra) {
+    GPtrArray *args = NULL;
+    gboolean ret = TRUE;
+
+    if (!argv || !argv[0] || !argv[1] || !is_shell_command (argv[1]))
+        return FALSE;
+
+    args = get_shell_args (argv, extra);
+    for (guint i = 0; ret && i < args->len; i++) {
+        const gchar *arg = g_ptr_array_index (args, i);
+        /* the report format is controlled by us */
+        if (g_str_has_prefix (arg, "--reportformat"))
+            ret = FALSE;
+        else if (g_str_has_prefix (arg, OPT_CONFIG))
+            /* our log config is appended with a space to the user config */
+            ret = !strchr (arg, '"');
+        else
+            ret = arg_representable (arg);
+    }
+    g_ptr_array_free (args, TRUE);
+
+    return ret;
+}
+
+static void shell_child_setup (gpointer user_data) {
+    gint fd = GPOINTER_TO_INT (user_data);
+    gint flags = 0;
+
+    /* keep the report pipe open in the shell */
+    flags = fcntl (fd, F_GETFD);
+    if (flags >= 0)
+        fcntl (fd, F_SETFD, flags & ~FD_CLOEXEC);
+}
+
+static void shell_free (LVMShell *sh) {
+    if (!sh)
+        return;
+
+    /* closing stdin makes the shell exit */
+    if (sh->in_fd >= 0)
+        close (sh->in_fd);
+    if (sh->out_fd >= 0)
+        close (sh->out_fd);
+    if (sh->err_fd >= 0)
+        close (sh->err_fd);
+    if (sh->report_fd >= 0)
+        close (sh->report_fd);
+    if (sh->pid > 0) {
+        waitpid (sh->pid, NULL, 0);
+        g_spawn_close_pid (sh->pid);
+    }
+    g_free (sh);
+}
+
+/* for a shell in an unknown state (e.g. stuck in a command), closing its stdin
+   is not enough to make it exit */
+static void shell_kill (LVMShell *sh) {
+    if (!sh)
+        return;
+
+    if (sh->pid > 0)
+        kill (sh->pid, SIGKILL);
+    shell_free (sh);
+}
+
+static void set_nonblocking (gint fd) {
+    gint flags = fcntl (fd, F_GETFL, 0);
+
+    if (fcntl (fd, F_SETFL, flags | O_NONBLOCK))
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to set lvm shell fd non-blocking: %m");
+}
+
+/* returns -1 on error, 0 on EOF and 1 otherwise */
+static gint read_available (gint fd, GString *buffer) {
+    gchar buf[SHELL_BUF_SIZE];
+    ssize_t num_read = 0;
+
+    while ((num_read = read (fd, buf, SHELL_BUF_SIZE)) > 0)
+        g_string_append_len (buffer, buf, num_read);
+
+    if (num_read == 0)
+        return 0;
+    if (errno == EAGAIN || errno == EINTR)
+        return 1;
+    return -1;
+}
+
+/* the output of the shell needs to be consumed until it exits, otherwise it
+   could be killed by SIGPIPE in the middle of the command */
+static gpointer shell_drain (gpointer user_data) {
+    LVMShell *sh = (LVMShell *) user_data;
+    GString *buffer = g_string_new (NULL);
+    struct pollfd fds[3];
+    guint n_open = 3;
+
+    fds[0].fd = sh->out_fd;
+    fds[1].fd = sh->err_fd;
+    fds[2].fd = sh->report_fd;
+    for (guint i = 0; i < 3; i++)
+        fds[i].events = POLLIN;
+
+    while (n_open > 0) {
+        if (poll (fds, 3, -1) < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            break;
+        }
+        for (guint i = 0; i < 3; i++) {
+            if (fds[i].fd < 0 || !fds[i].revents)
+                continue;
+            if (read_available (fds[i].fd, buffer) <= 0) {
+                fds[i].fd = -1;
+                n_open--;
+            }
+            g_string_truncate (buffer, 0);
+        }
+    }
+    g_string_free (buffer, TRUE);
+
+    shell_free (sh);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "The timed out lvm shell process finished");
+
+    return NULL;
+}
+
+/* for a shell busy with a command that must not be interrupted, the shell is
+   left to finish the command and exit in a separate thread */
+static void shell_detach (LVMShell *sh) {
+    GThread *thread = NULL;
+    GError *l_error = NULL;
+
+    /* closing stdin makes the shell exit once the command is finished */
+    close (sh->in_fd);
+    sh->in_fd = -1;
+
+    thread = g_thread_try_new ("lvm-shell-drain", shell_drain, sh, &l_error);
+    if (thread)
+        g_thread_unref (thread);
+    else {
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create a thread for the timed out lvm shell, "
+                             "waiting for it: %s", l_error->message);
+        g_clear_error (&l_error);
+        shell_drain (sh);
+    }
+}
+
+/**
+ * read_response: (skip)
+ *
+ * Reads everything the shell produces up to the next prompt. If the prompt
+ * doesn't come in %SHELL_TIMEOUT seconds, %FALSE is returned and @timed_out is
+ * set to %TRUE.
+ */
+static gboolean read_response (LVMShell *sh, GString *report, GString *err_out, gboolean *timed_out, GError **error) {
+    GString *out = g_string_new (NULL);
+    struct pollfd fds[3];
+    gint64 deadline = g_get_monotonic_time () + SHELL_TIMEOUT * G_USEC_PER_SEC;
+    gint64 remaining = 0;
+    gint poll_status = 0;
+    gint ret = 0;
+
+    *timed_out = FALSE;
+
+    fds[0].fd = sh->out_fd;
+    fds[1].fd = sh->err_fd;
+    fds[2].fd = sh->report_fd;
+    for (guint i = 0; i < 3; i++)
+        fds[i].events = POLLIN;
+
+    while (!g_str_has_suffix (out->str, SHELL_PROMPT)) {
+        remaining = deadline - g_get_monotonic_time ();
+        if (remaining <= 0) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "The lvm shell didn't respond in %d seconds", SHELL_TIMEOUT);
+            g_string_free (out, TRUE);
+            *timed_out = TRUE;
+            return FALSE;
+        }
+
+        /* rounded up to not spin with a zero timeout in the last millisecond */
+        poll_status = poll (fds, 3, (gint) ((remaining + 999) / 1000));
+        if (poll_status == 0)
+            continue;
+        if (poll_status < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Failed to poll lvm shell FDs: %m");
+            g_string_free (out, TRUE);
+            return FALSE;
+        }
+
+        /* read stderr and the report first, LVM may be blocked writing them */
+        if (fds[1].revents) {
+            ret = read_available (fds[1].fd, err_out);
+            if (ret <= 0)
+                fds[1].fd = -1;
+        }
+        if (fds[2].revents) {
+            ret = read_available (fds[2].fd, report);
+            if (ret <= 0)
+                fds[2].fd = -1;
+        }
+        if (fds[0].revents) {
+            ret = read_available (fds[0].fd, out);
+            if (ret <= 0) {
+                g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                             "The lvm shell process exited unexpectedly: %s", err_out->str);
+                g_string_free (out, TRUE);
+                return FALSE;
+            }
+        }
+    }
+
+    /* everything is written before the prompt, just get the rest */
+    if (fds[1].fd >= 0)
+        read_available (fds[1].fd, err_out);
+    if (fds[2].fd >= 0)
+        read_available (fds[2].fd, report);
+
+    g_string_free (out, TRUE);
+    return TRUE;
+}
+
+static gboolean write_command (gint fd, const gchar *cmd, GError **error) {
+    sigset_t pipe_mask;
+    sigset_t old_mask;
+    sigset_t pending;
+    gboolean was_pending = FALSE;
+    struct timespec no_wait = { 0, 0 };
+    gsize len = strlen (cmd);
+    gsize written = 0;
+    ssize_t ret = 0;
+    gint errno_saved = 0;
+
+    /* don't get killed by SIGPIPE if the shell is gone, we get EPIPE instead */
+    sigemptyset (&pipe_mask);
+    sigaddset (&pipe_mask, SIGPIPE);
+    pthread_sigmask (SIG_BLOCK, &pipe_mask, &old_mask);
+    sigpending (&pending);
+    was_pending = sigismember (&pending, SIGPIPE);
+
+    while (written < len) {
+        ret = write (fd, cmd + written, len - written);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            errno_saved = errno;
+            break;
+        }
+        written += ret;
+    }
+
+    if (errno_saved == EPIPE && !was_pending)
+        /* consume the SIGPIPE we caused */
+        sigtimedwait (&pipe_mask, NULL, &no_wait);
+    pthread_sigmask (SIG_SETMASK, &old_mask, NULL);
+
+    if (written < len) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Failed to write to the lvm shell: %s", g_strerror (errno_saved));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static LVMShell* shell_start (GError **error) {
+    const gchar *argv[3] = {"lvm", "shell", NULL};
+    LVMShell *sh = NULL;
+    gint report_pipe[2] = {-1, -1};
+    gchar **env = NULL;
+    gchar *report_fd_str = NULL;
+    GString *report = NULL;
+    GString *err_out = NULL;
+    gboolean ret = FALSE;
+    gboolean timed_out = FALSE;
+
+    if (!g_unix_open_pipe (report_pipe, FD_CLOEXEC, error)) {
+        g_prefix_error (error, "Failed to create a pipe for the lvm shell: ");
+        return NULL;
+    }
+
+    report_fd_str = g_strdup_printf ("%d", report_pipe[1]);
+    env = g_get_environ ();
+    env = g_environ_setenv (env, "LC_ALL", "C.UTF-8", TRUE);
+    env = g_environ_unsetenv (env, "LANGUAGE");
+    env = g_environ_setenv (env, "LVM_REPORT_FD", report_fd_str, TRUE);
+    g_free (report_fd_str);
+
+    sh = g_new0 (LVMShell, 1);
+    sh->in_fd = sh->out_fd = sh->err_fd = -1;
+    sh->report_fd = report_pipe[0];
+
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "Starting the lvm shell process");
+    ret = g_spawn_async_with_pipes (NULL, (gchar **) argv, env,
+                                    G_SPAWN_SEARCH_PATH|G_SPAWN_DO_NOT_REAP_CHILD,
+                                    shell_child_setup, GINT_TO_POINTER (report_pipe[1]),
+                                    &(sh->pid), &(sh->in_fd), &(sh->out_fd), &(sh->err_fd), error);
+    g_strfreev (env);
+    close (report_pipe[1]);
+    if (!ret) {
+        /* error is already populated */
+        sh->pid = 0;
+        shell_free (sh);
+        return NULL;
+    }
+
+    set_nonblocking (sh->out_fd);
+    set_nonblocking (sh->err_fd);
+    set_nonblocking (sh->report_fd);
+
+    /* wait for the first prompt */
+    report = g_string_new (NULL);
+    err_out = g_string_new (NULL);
+    ret = read_response (sh, report, err_out, &timed_out, error);
+    g_string_free (report, TRUE);
+    g_string_free (err_out, TRUE);
+    if (!ret) {
+        g_prefix_error (error, "Failed to start the lvm shell: ");
+        shell_kill (sh);
+        return NULL;
+    }
+
+    return sh;
+}
+
+/**
+ * lvm_shell_ensure_running: (skip)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the persistent shell is running (was started if needed) or not
+ */
+gboolean lvm_shell_ensure_running (GError **error) {
+    gboolean ret = TRUE;
+
+    g_mutex_lock (&shell_lock);
+    if (!shell) {
+        shell = shell_start (error);
+        ret = shell != NULL;
+    }
+    g_mutex_unlock (&shell_lock);
+
+    return ret;
+}
+
+/**
+ * lvm_shell_stop: (skip)
+ *
+ * Stops the persistent shell (if running).
+ */
+void lvm_shell_stop (void) {
+    g_mutex_lock (&shell_lock);
+    shell_free (shell);
+    shell = NULL;
+    g_mutex_unlock (&shell_lock);
+}
+
+typedef struct ShellReport {
+    GString *out;
+    gboolean prefixes;
+    gint ret_code;
+} ShellReport;
+
+/* converts the report rows to the 'basic' report format and gets the LVM
+   return code of the command from the command log rows */
+static void process_report_row (const gchar *section, guint report_idx G_GNUC_UNUSED, const ReportRow *row, gpointer user_data) {
+    ShellReport *report = user_data;
+    const gchar *value = NULL;
+    gchar *key_up = NULL;
+    gint64 code = 0;
+
+    if (g_strcmp0 (section, "log") == 0) {
+        value = row_get (row, "log_type");
+        if (g_strcmp0 (value, "error") == 0 && report->ret_code == SHELL_RET_CODE_OK)
+            report->ret_code = SHELL_RET_CODE_FAILED;
+        else if (g_strcmp0 (value, "status") == 0) {
+            value = row_get (row, "log_ret_code");
+            code = value ? g_ascii_strtoll (value, NULL, 0) : SHELL_RET_CODE_OK;
+            if (code != SHELL_RET_CODE_OK)
+                report->ret_code = (gint) code;
+        }
+        return;
+    }
+
+    if (row->n_items == 0)
+        return;
+
+    g_string_append (report->out, " ");
+    for (guint i = 0; i < row->n_items; i++) {
+        if (report->prefixes) {
+            key_up = g_ascii_strup (row->keys[i], -1);
+            g_string_append_printf (report->out, " LVM2_%s=%s", key_up, row->values[i]);
+            g_free (key_up);
+        } else
+            g_string_append_printf (report->out, " %s", row->values[i]);
+    }
+    g_string_append_c (report->out, '\n');
+}
+
+static gchar* build_command_line (GPtrArray *args, gboolean *prefixes) {
+    GString *cmd = g_string_new (NULL);
+    gboolean config_found = FALSE;
+
+    *prefixes = FALSE;
+    for (guint i = 0; i < args->len; i++) {
+        const gchar *arg = g_ptr_array_index (args, i);
+
+        /* options only applicable to the 'basic' report format are emulated */
+        if (g_strcmp0 (arg, OPT_NAMEPREFIXES) == 0) {
+            *prefixes = TRUE;
+            continue;
+        }
+        if (g_strcmp0 (arg, OPT_UNQUOTED) == 0 || g_strcmp0 (arg, OPT_NOHEADINGS) == 0)
+            continue;
+
+        if (g_str_has_prefix (arg, OPT_CONFIG)) {
+            g_string_append_printf (cmd, "\"%s " SHELL_LOG_CONFIG "\" ", arg);
+            config_found = TRUE;
+        } else if (strpbrk (arg, " \t") || *arg == '#')
+            g_string_append_printf (cmd, "\"%s\" ", arg);
+        else
+            g_string_append_printf (cmd, "%s ", arg);
+    }
+
+    if (!config_found)
+        g_string_append (cmd, OPT_CONFIG SHELL_LOG_CONFIG " ");
+    g_string_append (cmd, "--reportformat json\n");
+
+    return g_string_free (cmd, FALSE);
+}
+
+/**
+ * lvm_shell_run: (skip)
+ * @argv: (array zero-terminated=1): the argv array for the call (starting with "lvm")
+ * @extra: (nullable) (array zero-terminated=1): extra arguments
+ * @output: (out) (optional): place to store the output of the command (in the
+ *                            'basic' report format) or %NULL if not needed
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Runs the command in the persistent shell. Errors are reported the same way
+ * bd_utils_exec_and_report_error() and bd_utils_exec_and_capture_output() report
+ * them. The shell must be running (see lvm_shell_ensure_running()) and
+ * lvm_shell_can_run() must return %TRUE for the command. If the shell doesn't
+ * finish the command in time, a new shell is started by the next
+ * lvm_shell_ensure_running() call. A report command is then run in a separate
+ * 'lvm' process instead (the stuck shell is killed), any other command is left
+ * to finish in the old shell in the background and an error is returned.
+ *
+ * Returns: whether the command was successfully run or not
+ */
+gboolean lvm_shell_run (const gchar **argv, const BDExtraArg **extra, gchar **output, GError **error) {
+    GPtrArray *args = NULL;
+    GString *report = NULL;
+    GString *err_out = NULL;
+    gchar *cmd = NULL;
+    gchar *args_str = NULL;
+    gboolean prefixes = FALSE;
+    gboolean success = FALSE;
+    gboolean timed_out = FALSE;
+    gboolean report_cmd = FALSE;
+    guint64 task_id = 0;
+    ShellReport parsed = {NULL, FALSE, SHELL_RET_CODE_OK};
+    GError *l_error = NULL;
+
+    report_cmd = is_in_commands (report_commands, argv[1]);
+    args = get_shell_args (argv, extra);
+    cmd = build_command_line (args, &prefixes);
+    g_ptr_array_add (args, NULL);
+    args_str = g_strjoinv (" ", (gchar **) args->pdata);
+    g_ptr_array_free (args, TRUE);
+
+    task_id = bd_utils_get_next_task_id ();
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "Running [%"G_GUINT64_FORMAT"] lvm shell: %s ...", task_id, args_str);
+    g_free (args_str);
+
+    report = g_string_new (NULL);
+    err_out = g_string_new (NULL);
+
+    g_mutex_lock (&shell_lock);
+    if (!shell) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "The lvm shell is not running");
+        g_mutex_unlock (&shell_lock);
+        g_free (cmd);
+        g_string_free (report, TRUE);
+        g_string_free (err_out, TRUE);
+        return FALSE;
+    }
+
+    success = write_command (shell->in_fd, cmd, &l_error) &&
+              read_response (shell, report, err_out, &timed_out, &l_error);
+    if (!success) {
+        /* the shell is gone or in an unknown state, start a new one next time */
+        if (timed_out && !report_cmd)
+            /* never kill LVM in the middle of a change (possibly holding locks) */
+            shell_detach (shell);
+        else
+            shell_kill (shell);
+        shell = NULL;
+    }
+    g_mutex_unlock (&shell_lock);
+    g_free (cmd);
+
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "stdout[%"G_GUINT64_FORMAT"]: %s", task_id, report->str);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "stderr[%"G_GUINT64_FORMAT"]: %s", task_id, err_out->str);
+
+    if (!success) {
+        g_string_free (report, TRUE);
+        g_string_free (err_out, TRUE);
+        if (timed_out && !report_cmd) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "%s, the command is left to finish in the background", l_error->message);
+            g_clear_error (&l_error);
+            return FALSE;
+        } else if (timed_out) {
+            bd_utils_log_format (BD_UTILS_LOG_WARNING, "...timed out [%"G_GUINT64_FORMAT"], running lvm directly: %s",
+                                 task_id, l_error->message);
+            g_clear_error (&l_error);
+            if (output)
+                return bd_utils_exec_and_capture_output (argv, extra, output, error);
+            else
+                return bd_utils_exec_and_report_error (argv, extra, error);
+        }
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    parsed.out = g_string_new (NULL);
+    parsed.prefixes = prefixes;
+    /* no report at all (not even the command log) means no problems reported */
+    if (report->len > 0)
+        success = lvm_report_parse_json (report->str, process_report_row, &parsed, error);
+    g_string_free (report, TRUE);
+    if (!success) {
+        g_prefix_error (error, "Failed to parse the lvm shell output: ");
+        g_string_free (parsed.out, TRUE);
+        g_string_free (err_out, TRUE);
+        return FALSE;
+    }
+
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "...done [%"G_GUINT64_FORMAT"] (return code: %d)", task_id, parsed.ret_code);
+
+    if (parsed.ret_code != SHELL_RET_CODE_OK) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Process reported exit code %d: %s", parsed.ret_code, err_out->str);
+        success = FALSE;
+    } else if (output) {
+        if (parsed.out->len == 0) {
+            g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT,
+                         "Process didn't provide any data on standard output. "
+                         "Error output: %s", err_out->str);
+            g_string_free (parsed.out, TRUE);
+            success = FALSE;
+        } else
+            *output = g_string_free (parsed.out, FALSE);
+        parsed.out = NULL;
+    }
+
+    if (parsed.out)
+        g_string_free (parsed.out, TRUE);
+    g_string_free (err_out, TRUE);
+
+    return success;
+}
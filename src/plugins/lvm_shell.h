@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#ifndef BD_LVM_SHELL
+#define BD_LVM_SHELL
+
+gboolean lvm_shell_can_run (const gchar **argv, const BDExtraArg **extra);
+gboolean lvm_shell_ensure_running (GError **error);
+gboolean lvm_shell_run (const gchar **argv, const BDExtraArg **extra, gchar **output, GError **error);
+void lvm_shell_stop (void);
+
+#endif  /* BD_LVM_SHELL */
@@ -23,12 +23,16 @@
 #include <unistd.h>
 #include <blockdev/utils.h>
 #include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
 #include <glob.h>
 #include <time.h>
 #include <bs_size.h>
 
 #include "mdraid.h"
 #include "check_deps.h"
+#include "../utils/parallel.h"
 
 #define MDADM_MIN_VERSION "3.3.2"
 
@@ -144,6 +148,44 @@ void bd_md_detail_data_free (BDMDDetailData *data) {
 }
 
 
+/**
+ * bd_md_activate_result_copy: (skip)
+ * @data: (nullable): %BDMDActivateResult to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDMDActivateResult* bd_md_activate_result_copy (BDMDActivateResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDMDActivateResult *new_data = g_new0 (BDMDActivateResult, 1);
+
+    new_data->uuid = g_strdup (data->uuid);
+    new_data->device = g_strdup (data->device);
+    new_data->members = g_strdupv (data->members);
+    new_data->success = data->success;
+    new_data->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return new_data;
+}
+
+/**
+ * bd_md_activate_result_free: (skip)
+ * @data: (nullable): %BDMDActivateResult to free
+ *
+ * Frees @data.
+ */
+void bd_md_activate_result_free (BDMDActivateResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->uuid);
+    g_free (data->device);
+    g_strfreev (data->members);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
 static volatile guint avail_deps = 0;
 static GMutex deps_check_lock;
 
@@ -499,6 +541,370 @@ static gchar* get_mdadm_spec_from_input (const gchar *input, GError **error) {
   return mdadm_spec;
 }
 
+/* v1.x superblock (struct mdp_superblock_1 in the kernel), little-endian */
+#define MD_SB1_MAGIC 0xa92b4efc
+#define MD_SB1_SIZE 256
+#define MD_SB1_MAGIC_OFFSET 0
+#define MD_SB1_MAJOR_OFFSET 4
+#define MD_SB1_UUID_OFFSET 16
+#define MD_SB1_NAME_OFFSET 32
+#define MD_SB1_NAME_SIZE 32
+#define MD_SB1_CTIME_OFFSET 64
+#define MD_SB1_LEVEL_OFFSET 72
+#define MD_SB1_LAYOUT_OFFSET 76
+#define MD_SB1_SIZE_OFFSET 80
+#define MD_SB1_CHUNK_OFFSET 88
+#define MD_SB1_RAID_DISKS_OFFSET 92
+#define MD_SB1_DEV_UUID_OFFSET 168
+#define MD_SB1_UTIME_OFFSET 192
+#define MD_SB1_EVENTS_OFFSET 200
+#define MD_SB1_SUPER_OFFSET_OFFSET 136
+#define MD_SB1_CSUM_OFFSET 216
+#define MD_SB1_MAX_DEV_OFFSET 220
+/* the superblock is followed by a 16-bit role for each of the (at most
+   MD_SB1_MAX_DEVS) devices, the checksum covers them too */
+#define MD_SB1_MAX_DEVS 1920
+#define MD_SB1_MAX_SIZE (MD_SB1_SIZE + 2 * MD_SB1_MAX_DEVS)
+
+/* times in the superblock have seconds in the lower 40 bits */
+#define MD_SB1_TIME_MASK 0xFFFFFFFFFFULL
+
+static guint32 sb1_get_le32 (const guint8 *sb, gsize offset) {
+    guint32 val = 0;
+    memcpy (&val, sb + offset, sizeof (val));
+    return GUINT32_FROM_LE (val);
+}
+
+static guint64 sb1_get_le64 (const guint8 *sb, gsize offset) {
+    guint64 val = 0;
+    memcpy (&val, sb + offset, sizeof (val));
+    return GUINT64_FROM_LE (val);
+}
+
+/* same as calc_sb_1_csum() in mdadm, @sb needs to be at least %MD_SB1_MAX_SIZE bytes */
+static gboolean sb1_check_csum (const guint8 *sb) {
+    guint32 max_dev = sb1_get_le32 (sb, MD_SB1_MAX_DEV_OFFSET);
+    gsize size = 0;
+    guint64 sum = 0;
+    guint16 word = 0;
+    guint32 csum = 0;
+
+    if (max_dev > MD_SB1_MAX_DEVS)
+        return FALSE;
+
+    size = MD_SB1_SIZE + max_dev * 2;
+    for (gsize offset = 0; offset + 4 <= size; offset += 4)
+        /* the checksum field itself counts as 0 */
+        if (offset != MD_SB1_CSUM_OFFSET)
+            sum += sb1_get_le32 (sb, offset);
+    if (size % 4 == 2) {
+        memcpy (&word, sb + size - 2, sizeof (word));
+        sum += GUINT16_FROM_LE (word);
+    }
+    csum = (guint32) ((sum & 0xFFFFFFFF) + (sum >> 32));
+
+    return csum == sb1_get_le32 (sb, MD_SB1_CSUM_OFFSET);
+}
+
+/**
+ * read_superblock1: (skip)
+ * @device: device to read the superblock from
+ * @minor: minor version of the superblock (0, 1 or 2) or -1 to try all of them
+ * @sb: (out): place to store the superblock (at least %MD_SB1_SIZE bytes)
+ *
+ * Only superblocks with a valid checksum that were found at the offset they
+ * were written to (not e.g. a v1.0 superblock of a whole disk member seen at
+ * the end of its last partition) are accepted, same as in mdadm.
+ *
+ * Returns: minor version of the superblock read or -1 if no valid v1.x
+ *          superblock was found on @device
+ */
+static gint read_superblock1 (const gchar *device, gint minor, guint8 *sb) {
+    /* version 1.1 is at the start of the device, 1.2 at 4 KiB from the start
+       and 1.0 at least 8 KiB (4 KiB aligned) from the end */
+    const gint minors[] = {1, 2, 0};
+    guint8 buf[MD_SB1_MAX_SIZE];
+    off_t offset = 0;
+    off_t dev_size = 0;
+    gint found = -1;
+    gint fd = -1;
+
+    fd = open (device, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    for (guint i = 0; found < 0 && i < G_N_ELEMENTS (minors); i++) {
+        if (minor >= 0 && minors[i] != minor)
+            continue;
+
+        if (minors[i] == 1)
+            offset = 0;
+        else if (minors[i] == 2)
+            offset = 4096;
+        else {
+            dev_size = lseek (fd, 0, SEEK_END);
+            if (dev_size < (16 * 512))
+                continue;
+            offset = ((dev_size / 512 - 16) & ~((off_t) 7)) * 512;
+        }
+
+        if (lseek (fd, offset, SEEK_SET) != offset || read (fd, buf, MD_SB1_MAX_SIZE) != MD_SB1_MAX_SIZE)
+            continue;
+
+        if (sb1_get_le32 (buf, MD_SB1_MAGIC_OFFSET) == MD_SB1_MAGIC && sb1_get_le32 (buf, MD_SB1_MAJOR_OFFSET) == 1 &&
+            sb1_get_le64 (buf, MD_SB1_SUPER_OFFSET_OFFSET) == (guint64) offset / 512 && sb1_check_csum (buf)) {
+            memcpy (sb, buf, MD_SB1_SIZE);
+            found = minors[i];
+        }
+    }
+    close (fd);
+
+    return found;
+}
+
+static gchar* sb1_get_uuid (const guint8 *sb, gsize offset) {
+    const guint8 *u = sb + offset;
+
+    /* same as bd_md_canonicalize_uuid() produces from the mdadm output */
+    return g_strdup_printf ("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                            u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7],
+                            u[8], u[9], u[10], u[11], u[12], u[13], u[14], u[15]);
+}
+
+static gchar* sb1_get_level (const guint8 *sb) {
+    gint32 level = (gint32) sb1_get_le32 (sb, MD_SB1_LEVEL_OFFSET);
+
+    switch (level) {
+        case -5:
+            return g_strdup ("faulty");
+        case -4:
+            return g_strdup ("multipath");
+        case -1:
+            return g_strdup ("linear");
+        case 0:
+        case 1:
+        case 4:
+        case 5:
+        case 6:
+        case 10:
+            return g_strdup_printf ("raid%d", level);
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * get_examine_data_native: (skip)
+ * @device: device (a member of an MD RAID) to examine
+ *
+ * Returns: (transfer full): information about the MD RAID read directly from
+ *                           the v1.x superblock on @device or %NULL if @device
+ *                           doesn't have a v1.x superblock (or it cannot be read)
+ */
+static BDMDExamineData* get_examine_data_native (const gchar *device) {
+    BDMDExamineData *data = NULL;
+    guint8 sb[MD_SB1_SIZE];
+    gchar *level = NULL;
+    gchar *short_name = NULL;
+    guint32 layout = 0;
+    guint64 data_disks = 0;
+    guint64 denom = 1;
+    gint minor = -1;
+
+    minor = read_superblock1 (device, -1, sb);
+    if (minor < 0)
+        return NULL;
+
+    level = sb1_get_level (sb);
+    if (!level)
+        /* something we don't know, let mdadm deal with it */
+        return NULL;
+
+    data = g_new0 (BDMDExamineData, 1);
+    data->level = level;
+    data->metadata = g_strdup_printf ("1.%d", minor);
+    data->num_devices = sb1_get_le32 (sb, MD_SB1_RAID_DISKS_OFFSET);
+    data->name = g_strndup ((const gchar *) sb + MD_SB1_NAME_OFFSET, MD_SB1_NAME_SIZE);
+    data->uuid = sb1_get_uuid (sb, MD_SB1_UUID_OFFSET);
+    data->dev_uuid = sb1_get_uuid (sb, MD_SB1_DEV_UUID_OFFSET);
+    data->update_time = sb1_get_le64 (sb, MD_SB1_UTIME_OFFSET) & MD_SB1_TIME_MASK;
+    data->events = sb1_get_le64 (sb, MD_SB1_EVENTS_OFFSET);
+    data->chunk_size = (guint64) sb1_get_le32 (sb, MD_SB1_CHUNK_OFFSET) * 512;
+
+    /* mdadm only reports array size for the levels with redundancy (computed
+       from the per-device size in 512B sectors) */
+    if (g_strcmp0 (level, "raid1") == 0)
+        data_disks = 1;
+    else if (g_strcmp0 (level, "raid4") == 0 || g_strcmp0 (level, "raid5") == 0)
+        data_disks = data->num_devices - 1;
+    else if (g_strcmp0 (level, "raid6") == 0)
+        data_disks = data->num_devices - 2;
+    else if (g_strcmp0 (level, "raid10") == 0) {
+        layout = sb1_get_le32 (sb, MD_SB1_LAYOUT_OFFSET);
+        data_disks = data->num_devices;
+        denom = (layout & 255) * ((layout >> 8) & 255);
+    }
+    if (data_disks > 0 && denom > 0)
+        data->size = (((sb1_get_le64 (sb, MD_SB1_SIZE_OFFSET) * 512) * data_disks / denom) / 1024) * 1024;
+
+    /* the same as the ARRAY line from 'mdadm --examine --brief' (name without
+       the 'host:' part) */
+    if (*(data->name) != '\0') {
+        short_name = strchr (data->name, ':');
+        data->device = g_strdup_printf ("/dev/md/%s", short_name ? short_name + 1 : data->name);
+    }
+
+    return data;
+}
+
+static gchar* read_md_attr (const gchar *md_dir, const gchar *attr) {
+    gchar *path = NULL;
+    gchar *contents = NULL;
+    gboolean success = FALSE;
+
+    path = g_build_filename (md_dir, attr, NULL);
+    success = g_file_get_contents (path, &contents, NULL, NULL);
+    g_free (path);
+    if (!success)
+        return NULL;
+
+    return g_strstrip (contents);
+}
+
+static guint64 read_md_attr_uint (const gchar *md_dir, const gchar *attr) {
+    gchar *value = NULL;
+    guint64 ret = 0;
+
+    value = read_md_attr (md_dir, attr);
+    if (value)
+        ret = g_ascii_strtoull (value, NULL, 0);
+    g_free (value);
+
+    return ret;
+}
+
+/**
+ * get_detail_data_native: (skip)
+ * @raid_spec: specification of the RAID device (name, node or path)
+ *
+ * Returns: (transfer full): information about the MD RAID @raid_spec read
+ *                           from sysfs and the v1.x superblock of one of its
+ *                           members or %NULL if @raid_spec doesn't use v1.x
+ *                           metadata (or the information cannot be read)
+ */
+static BDMDDetailData* get_detail_data_native (const gchar *raid_spec) {
+    BDMDDetailData *data = NULL;
+    g_autofree gchar *node = NULL;
+    g_autofree gchar *md_dir = NULL;
+    g_autofree gchar *metadata = NULL;
+    g_autofree gchar *array_state = NULL;
+    g_autofree gchar *sync_action = NULL;
+    g_autofree gchar *member = NULL;
+    g_autofree gchar *size_path = NULL;
+    g_autofree gchar *size_str = NULL;
+    GDir *dir = NULL;
+    const gchar *entry = NULL;
+    gchar *dev_dir = NULL;
+    gchar *state = NULL;
+    gchar **states = NULL;
+    gboolean faulty = FALSE;
+    gboolean in_sync = FALSE;
+    guint8 sb[MD_SB1_SIZE];
+    gint minor = -1;
+    GDateTime *ctime = NULL;
+
+    node = get_sysfs_name_from_input (raid_spec, NULL);
+    if (!node)
+        return NULL;
+
+    md_dir = g_strdup_printf ("/sys/class/block/%s/md", node);
+    metadata = read_md_attr (md_dir, "metadata_version");
+    if (!metadata || !g_str_has_prefix (metadata, "1."))
+        /* no or external metadata or the old 0.90 format, let mdadm deal with it */
+        return NULL;
+    minor = (gint) g_ascii_strtoll (metadata + 2, NULL, 10);
+
+    dir = g_dir_open (md_dir, 0, NULL);
+    if (!dir)
+        return NULL;
+
+    data = g_new0 (BDMDDetailData, 1);
+    while ((entry = g_dir_read_name (dir))) {
+        if (!g_str_has_prefix (entry, "dev-"))
+            continue;
+
+        dev_dir = g_build_filename (md_dir, entry, NULL);
+        state = read_md_attr (dev_dir, "state");
+        g_free (dev_dir);
+        if (!state)
+            continue;
+
+        states = g_strsplit (state, ",", 0);
+        g_free (state);
+        faulty = FALSE;
+        in_sync = FALSE;
+        for (gchar **state_p = states; *state_p; state_p++) {
+            if (g_strcmp0 (*state_p, "faulty") == 0)
+                faulty = TRUE;
+            else if (g_strcmp0 (*state_p, "in_sync") == 0)
+                in_sync = TRUE;
+        }
+        g_strfreev (states);
+
+        data->total_devices++;
+        if (faulty)
+            data->failed_devices++;
+        else {
+            data->working_devices++;
+            if (in_sync)
+                data->active_devices++;
+            if (!member) {
+                /* '/' in device names is replaced with '!' in sysfs */
+                member = g_strdup_printf ("/dev/%s", entry + 4);
+                g_strdelimit (member, "!", '/');
+            }
+        }
+    }
+    g_dir_close (dir);
+    data->spare_devices = data->working_devices - data->active_devices;
+
+    if (!member || read_superblock1 (member, minor, sb) != minor) {
+        bd_md_detail_data_free (data);
+        return NULL;
+    }
+
+    data->metadata = g_strdup (metadata);
+    data->level = read_md_attr (md_dir, "level");
+    data->raid_devices = read_md_attr_uint (md_dir, "raid_disks");
+    data->name = g_strndup ((const gchar *) sb + MD_SB1_NAME_OFFSET, MD_SB1_NAME_SIZE);
+    data->uuid = sb1_get_uuid (sb, MD_SB1_UUID_OFFSET);
+
+    /* the same format as mdadm uses (ctime()) */
+    ctime = g_date_time_new_from_unix_local (sb1_get_le64 (sb, MD_SB1_CTIME_OFFSET) & MD_SB1_TIME_MASK);
+    if (ctime) {
+        data->creation_time = g_date_time_format (ctime, "%a %b %e %H:%M:%S %Y");
+        g_date_time_unref (ctime);
+    }
+
+    /* sizes are in KiB (like in the mdadm output), the size of the array
+       in sysfs is in 512B sectors */
+    size_path = g_strdup_printf ("/sys/class/block/%s", node);
+    size_str = read_md_attr (size_path, "size");
+    if (size_str)
+        data->array_size = g_ascii_strtoull (size_str, NULL, 0) / 2;
+    if (g_strcmp0 (data->level, "raid0") != 0 && g_strcmp0 (data->level, "linear") != 0)
+        data->use_dev_size = read_md_attr_uint (md_dir, "component_size");
+
+    /* mdadm reports just "clean" only if there's nothing else going on */
+    array_state = read_md_attr (md_dir, "array_state");
+    sync_action = read_md_attr (md_dir, "sync_action");
+    data->clean = (g_strcmp0 (array_state, "clean") == 0) &&
+                  (read_md_attr_uint (md_dir, "degraded") == 0) &&
+                  (!sync_action || g_strcmp0 (sync_action, "idle") == 0);
+
+    return data;
+}
+
 /**
  * bd_md_get_superblock_size:
  * @member_size: size of an array member
@@ -743,6 +1149,132 @@ gboolean bd_md_activate (const gchar *raid_spec, const gchar **members, const gc
     return ret;
 }
 
+typedef struct ExamineTask {
+    const gchar *member;
+    BDMDExamineData *data;
+} ExamineTask;
+
+static void examine_member_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    ExamineTask *task = (ExamineTask *) data;
+
+    /* not being an MD RAID member is fine here */
+    task->data = bd_md_examine (task->member, NULL);
+}
+
+typedef struct ActivateTask {
+    BDMDActivateResult *result;
+    gboolean start_degraded;
+    const BDExtraArg **extra;
+} ActivateTask;
+
+static void activate_array_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    ActivateTask *task = (ActivateTask *) data;
+    BDMDActivateResult *result = task->result;
+    g_autofree gchar *md_uuid = NULL;
+
+    md_uuid = bd_md_get_md_uuid (result->uuid, &(result->error));
+    if (!md_uuid)
+        return;
+
+    /* without a name for the array mdadm needs to search for the members itself */
+    result->success = bd_md_activate (result->device, (const gchar **) result->members, md_uuid,
+                                      task->start_degraded, task->extra, &(result->error));
+}
+
+/**
+ * bd_md_activate_many:
+ * @members: (array zero-terminated=1): candidate member devices of the MD RAIDs to activate
+ * @start_degraded: whether to start the arrays even if they are degraded
+ * @max_workers: maximum number of devices to examine and arrays to activate in parallel
+ *               or 0 for the default (number of CPUs)
+ * @extra: (nullable) (array zero-terminated=1): extra options for the activations (right now
+ *                                                 passed to the 'mdadm' utility)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Examines all the @members in parallel, groups them by the UUID of the MD RAID
+ * they belong to and activates the arrays in parallel (the same way
+ * bd_md_activate() does). Devices from @members that are not MD RAID members
+ * are ignored. A failure to activate one of the arrays doesn't affect the
+ * other arrays, it is reported in the #BDMDActivateResult.error field of the
+ * particular entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the activations (one entry
+ *                                                     per MD RAID found on @members)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+BDMDActivateResult** bd_md_activate_many (const gchar **members, gboolean start_degraded, guint max_workers, const BDExtraArg **extra, GError **error) {
+    ExamineTask *ex_tasks = NULL;
+    ActivateTask *act_tasks = NULL;
+    guint num_members = 0;
+    GHashTable *arrays = NULL;
+    GPtrArray *array_members = NULL;
+    GPtrArray *results = NULL;
+    BDMDActivateResult *result = NULL;
+    BDMDExamineData *ex_data = NULL;
+    guint64 i = 0;
+
+    if (!members) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "No member devices specified");
+        return NULL;
+    }
+
+    if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    num_members = g_strv_length ((gchar **) members);
+    ex_tasks = g_new0 (ExamineTask, num_members);
+    for (i = 0; i < num_members; i++)
+        ex_tasks[i].member = members[i];
+    bd_utils_parallel_run_array (examine_member_thread, ex_tasks, sizeof (ExamineTask), num_members, max_workers, NULL);
+
+    /* group the members by array UUID (keeping the order of @members) */
+    arrays = g_hash_table_new (g_str_hash, g_str_equal);
+    results = g_ptr_array_new ();
+    for (i = 0; i < num_members; i++) {
+        ex_data = ex_tasks[i].data;
+        if (!ex_data || !ex_data->uuid)
+            continue;
+
+        array_members = g_hash_table_lookup (arrays, ex_data->uuid);
+        if (!array_members) {
+            result = g_new0 (BDMDActivateResult, 1);
+            result->uuid = g_strdup (ex_data->uuid);
+            result->device = g_strdup (ex_data->device);
+            g_ptr_array_add (results, result);
+
+            array_members = g_ptr_array_new ();
+            g_hash_table_insert (arrays, result->uuid, array_members);
+        }
+        g_ptr_array_add (array_members, g_strdup (members[i]));
+    }
+
+    act_tasks = g_new0 (ActivateTask, results->len);
+    for (i = 0; i < results->len; i++) {
+        result = results->pdata[i];
+        array_members = g_hash_table_lookup (arrays, result->uuid);
+        g_ptr_array_add (array_members, NULL);
+        result->members = (gchar **) g_ptr_array_free (array_members, FALSE);
+
+        act_tasks[i].result = result;
+        act_tasks[i].start_degraded = start_degraded;
+        act_tasks[i].extra = extra;
+    }
+    g_hash_table_destroy (arrays);
+
+    bd_utils_parallel_run_array (activate_array_thread, act_tasks, sizeof (ActivateTask), results->len, max_workers, NULL);
+    g_free (act_tasks);
+
+    for (i = 0; i < num_members; i++)
+        bd_md_examine_data_free (ex_tasks[i].data);
+    g_free (ex_tasks);
+
+    g_ptr_array_add (results, NULL);
+    return (BDMDActivateResult **) g_ptr_array_free (results, FALSE);
+}
+
 /**
  * bd_md_run:
  * @raid_spec: specification of the (possibly degraded) RAID device (name, node or path) to be started
@@ -946,6 +1478,12 @@ BDMDExamineData* bd_md_examine (const gchar *device, GError **error) {
     guint i = 0;
     gboolean found_array_line = FALSE;
 
+    /* v1.x superblocks are read directly, mdadm is only needed for the other
+       metadata formats */
+    ret = get_examine_data_native (device);
+    if (ret)
+        return ret;
+
     if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
         return NULL;
 
@@ -1097,14 +1635,22 @@ BDMDDetailData* bd_md_detail (const gchar *raid_spec, GError **error) {
     guint i = 0;
     BDMDDetailData *ret = NULL;
 
-    if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
-        return NULL;
-
     mdadm_spec = get_mdadm_spec_from_input (raid_spec, error);
     if (!mdadm_spec)
         /* error is already populated */
         return NULL;
 
+    /* arrays with v1.x metadata are described by sysfs and the superblocks
+       of their members, mdadm is only needed for the other metadata formats */
+    ret = get_detail_data_native (raid_spec);
+    if (ret) {
+        ret->device = g_strdup (mdadm_spec);
+        return ret;
+    }
+
+    if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
     argv[2] = mdadm_spec;
 
     success = bd_utils_exec_and_capture_output (argv, NULL, &output, error);
@@ -1501,6 +2047,425 @@ gchar* bd_md_get_bitmap_location (const gchar *raid_spec, GError **error) {
     return g_strstrip (ret);
 }
 
+static gchar* get_md_attr (const gchar *raid_spec, const gchar *attr, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *sys_path = NULL;
+    gchar *ret = NULL;
+    gboolean success = FALSE;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return NULL;
+
+    sys_path = g_strdup_printf ("/sys/class/block/%s/md/%s", raid_node, attr);
+    g_free (raid_node);
+
+    success = g_file_get_contents (sys_path, &ret, NULL, error);
+    g_free (sys_path);
+    if (!success) {
+        g_prefix_error (error, "Failed to get '%s' for '%s': ", attr, raid_spec);
+        return NULL;
+    }
+
+    return g_strstrip (ret);
+}
+
+static guint64 get_md_attr_uint (const gchar *raid_spec, const gchar *attr, GError **error) {
+    gchar *value = NULL;
+    gchar *endptr = NULL;
+    guint64 ret = 0;
+
+    value = get_md_attr (raid_spec, attr, error);
+    if (!value)
+        /* error is already populated */
+        return 0;
+
+    /* some attributes have a suffix (e.g. "1000 (system)") */
+    ret = g_ascii_strtoull (value, &endptr, 10);
+    if (endptr == value) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_PARSE,
+                     "Failed to parse '%s' value '%s' for '%s'", attr, value, raid_spec);
+        g_free (value);
+        return 0;
+    }
+
+    g_free (value);
+    return ret;
+}
+
+static gboolean set_md_attr (const gchar *raid_spec, const gchar *attr, const gchar *value, GError **error) {
+    gchar *raid_node = NULL;
+    gchar *sys_path = NULL;
+    gboolean success = FALSE;
+
+    raid_node = get_sysfs_name_from_input (raid_spec, error);
+    if (!raid_node)
+        /* error is already populated */
+        return FALSE;
+
+    sys_path = g_strdup_printf ("/sys/class/block/%s/md/%s", raid_node, attr);
+    g_free (raid_node);
+
+    success = bd_utils_echo_str_to_file (value, sys_path, error);
+    g_free (sys_path);
+    if (!success) {
+        g_prefix_error (error, "Failed to set '%s' to '%s' for '%s': ", attr, value, raid_spec);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean set_md_attr_uint (const gchar *raid_spec, const gchar *attr, guint64 value, GError **error) {
+    gchar *str_value = NULL;
+    gboolean ret = FALSE;
+
+    str_value = g_strdup_printf ("%"G_GUINT64_FORMAT, value);
+    ret = set_md_attr (raid_spec, attr, str_value, error);
+    g_free (str_value);
+
+    return ret;
+}
+
+/**
+ * bd_md_get_stripe_cache_size:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the stripe cache size of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: size of the stripe cache (in pages per member device) of @raid_spec or 0 in
+ *          case of error (only RAID 4/5/6 arrays have a stripe cache)
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+guint64 bd_md_get_stripe_cache_size (const gchar *raid_spec, GError **error) {
+    return get_md_attr_uint (raid_spec, "stripe_cache_size", error);
+}
+
+/**
+ * bd_md_set_stripe_cache_size:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the stripe cache size of
+ * @size: size of the stripe cache (in pages per member device, 17-32768)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the stripe cache size was successfully set for @raid_spec or not
+ *          (only RAID 4/5/6 arrays have a stripe cache)
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_stripe_cache_size (const gchar *raid_spec, guint64 size, GError **error) {
+    if (size < 17 || size > 32768) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Stripe cache size must be between 17 and 32768.");
+        return FALSE;
+    }
+
+    return set_md_attr_uint (raid_spec, "stripe_cache_size", size, error);
+}
+
+/**
+ * bd_md_get_group_thread_cnt:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the number of worker threads of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: number of the worker threads handling the stripes of @raid_spec
+ *          (0 means the stripes are handled in the array's thread only, or error)
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+guint64 bd_md_get_group_thread_cnt (const gchar *raid_spec, GError **error) {
+    return get_md_attr_uint (raid_spec, "group_thread_cnt", error);
+}
+
+/**
+ * bd_md_set_group_thread_cnt:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the number of worker threads of
+ * @count: number of worker threads (per NUMA node group) to handle the stripes, 0 to disable them
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the number of worker threads was successfully set for @raid_spec or not
+ *          (only RAID 4/5/6 arrays support worker threads)
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_group_thread_cnt (const gchar *raid_spec, guint64 count, GError **error) {
+    return set_md_attr_uint (raid_spec, "group_thread_cnt", count, error);
+}
+
+/**
+ * bd_md_get_sync_speed_limits:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the sync speed limits of
+ * @speed_min: (out): place to store the minimum sync speed (in KiB/s)
+ * @speed_max: (out): place to store the maximum sync speed (in KiB/s)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the sync speed limits (the array specific ones or the system-wide
+ *          ones if not set for the array) were successfully read or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+gboolean bd_md_get_sync_speed_limits (const gchar *raid_spec, guint64 *speed_min, guint64 *speed_max, GError **error) {
+    GError *l_error = NULL;
+
+    *speed_min = get_md_attr_uint (raid_spec, "sync_speed_min", &l_error);
+    if (l_error) {
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    *speed_max = get_md_attr_uint (raid_spec, "sync_speed_max", &l_error);
+    if (l_error) {
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_md_set_sync_speed_limits:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the sync speed limits for
+ * @speed_min: minimum sync speed (in KiB/s) or 0 to use the system-wide limit
+ * @speed_max: maximum sync speed (in KiB/s) or 0 to use the system-wide limit
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the sync speed limits were successfully set for @raid_spec or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_sync_speed_limits (const gchar *raid_spec, guint64 speed_min, guint64 speed_max, GError **error) {
+    if (speed_min != 0 && speed_max != 0 && speed_min > speed_max) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Minimum sync speed cannot be bigger than the maximum sync speed.");
+        return FALSE;
+    }
+
+    /* raise the maximum first so that the minimum is never above it */
+    if (speed_max == 0) {
+        if (!set_md_attr (raid_spec, "sync_speed_max", "system", error))
+            return FALSE;
+    } else if (!set_md_attr_uint (raid_spec, "sync_speed_max", speed_max, error))
+        return FALSE;
+
+    if (speed_min == 0)
+        return set_md_attr (raid_spec, "sync_speed_min", "system", error);
+    else
+        return set_md_attr_uint (raid_spec, "sync_speed_min", speed_min, error);
+}
+
+/**
+ * bd_md_get_consistency_policy:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the consistency policy of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): consistency policy of @raid_spec (e.g. "resync", "bitmap",
+ *                           "journal" or "ppl") or %NULL in case of error
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+gchar* bd_md_get_consistency_policy (const gchar *raid_spec, GError **error) {
+    return get_md_attr (raid_spec, "consistency_policy", error);
+}
+
+/**
+ * bd_md_set_consistency_policy:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the consistency policy of
+ * @policy: consistency policy to set ("resync" or "ppl")
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Switches a running RAID 5 array between the "resync" and the Partial Parity Log
+ * ("ppl") consistency policies. The "bitmap" and "journal" policies are set by
+ * adding a bitmap (see %bd_md_set_bitmap_location) or a journal device.
+ *
+ * Returns: whether the consistency policy was successfully set for @raid_spec or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_consistency_policy (const gchar *raid_spec, const gchar *policy, GError **error) {
+    if ((g_strcmp0 (policy, "resync") != 0) && (g_strcmp0 (policy, "ppl") != 0)) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Consistency policy must be either resync or ppl.");
+        return FALSE;
+    }
+
+    return set_md_attr (raid_spec, "consistency_policy", policy, error);
+}
+
+/**
+ * bd_md_get_bitmap_chunk_size:
+ * @raid_spec: specification of the RAID device (name, node or path) to get the bitmap chunk size of
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: chunk size (in bytes) of the bitmap of @raid_spec or 0 in case of error
+ *          (or if @raid_spec has no bitmap)
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+guint64 bd_md_get_bitmap_chunk_size (const gchar *raid_spec, GError **error) {
+    return get_md_attr_uint (raid_spec, "bitmap/chunksize", error);
+}
+
+/**
+ * bd_md_set_bitmap_chunk_size:
+ * @raid_spec: specification of the RAID device (name, node or path) to set the bitmap chunk size of
+ * @chunk_size: chunk size (in bytes) of the bitmap, bigger chunks mean less bitmap
+ *              updates on writes but more data to resync after a crash
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * The chunk size of an existing bitmap cannot be changed so the internal bitmap
+ * of @raid_spec is removed and created again with the new chunk size. If the
+ * new bitmap cannot be created, the bitmap with the old chunk size is created
+ * again.
+ *
+ * Returns: whether the bitmap chunk size was successfully set for @raid_spec or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_set_bitmap_chunk_size (const gchar *raid_spec, guint64 chunk_size, GError **error) {
+    const gchar *argv[] = {"mdadm", "--grow", NULL, "--bitmap", "internal", NULL, NULL};
+    gchar *mdadm_spec = NULL;
+    gchar *location = NULL;
+    gchar *old_chunk_str = NULL;
+    guint64 old_chunk_size = 0;
+    gboolean ret = FALSE;
+    GError *l_error = NULL;
+    GError *restore_error = NULL;
+
+    if (chunk_size < 4 KiB || (chunk_size & (chunk_size - 1)) != 0) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Bitmap chunk size must be a power of two and at least 4 KiB.");
+        return FALSE;
+    }
+
+    if (!check_deps (&avail_deps, DEPS_MDADM_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return FALSE;
+
+    location = bd_md_get_bitmap_location (raid_spec, error);
+    if (!location)
+        /* error is already populated */
+        return FALSE;
+
+    /* internal bitmap location is an offset from the superblock (e.g. "+8") */
+    if (location[0] != '+' && location[0] != '-') {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Bitmap chunk size can be changed only for internal bitmaps, '%s' has bitmap '%s'.",
+                     raid_spec, location);
+        g_free (location);
+        return FALSE;
+    }
+    g_free (location);
+
+    /* everything needed to create the bitmap again is resolved before the
+       old one is removed */
+    old_chunk_str = get_md_attr (raid_spec, "bitmap/chunksize", error);
+    if (!old_chunk_str)
+        /* error is already populated */
+        return FALSE;
+    old_chunk_size = g_ascii_strtoull (old_chunk_str, NULL, 10);
+    g_free (old_chunk_str);
+
+    mdadm_spec = get_mdadm_spec_from_input (raid_spec, error);
+    if (!mdadm_spec)
+        /* error is already populated */
+        return FALSE;
+
+    if (!bd_md_set_bitmap_location (raid_spec, "none", error)) {
+        g_prefix_error (error, "Failed to remove the old bitmap: ");
+        g_free (mdadm_spec);
+        return FALSE;
+    }
+
+    argv[2] = mdadm_spec;
+    argv[5] = g_strdup_printf ("--bitmap-chunk=%"G_GUINT64_FORMAT"K", chunk_size / 1024);
+
+    ret = bd_utils_exec_and_report_error (argv, NULL, &l_error);
+    g_free ((gchar *) argv[5]);
+    argv[5] = NULL;
+
+    if (!ret) {
+        /* don't leave the array without a bitmap */
+        if (old_chunk_size >= 4 KiB)
+            argv[5] = g_strdup_printf ("--bitmap-chunk=%"G_GUINT64_FORMAT"K", old_chunk_size / 1024);
+        if (bd_utils_exec_and_report_error (argv, NULL, &restore_error))
+            g_propagate_prefixed_error (error, l_error,
+                                        "Failed to create the new bitmap (the old one was restored): ");
+        else {
+            g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_FAIL,
+                         "Failed to create the new bitmap: %s. Failed to restore the old bitmap: %s",
+                         l_error->message, restore_error->message);
+            g_clear_error (&l_error);
+            g_clear_error (&restore_error);
+        }
+        g_free ((gchar *) argv[5]);
+    }
+
+    g_free (mdadm_spec);
+
+    return ret;
+}
+
+/* recommended values for the tuning profiles */
+#define TUNE_HDD_STRIPE_CACHE_SIZE 8192
+#define TUNE_NVME_STRIPE_CACHE_SIZE 4096
+#define TUNE_NVME_MAX_GROUP_THREADS 8
+#define TUNE_NVME_SYNC_SPEED_MIN (50 * 1024)
+
+/**
+ * bd_md_tune:
+ * @raid_spec: specification of the RAID device (name, node or path) to tune
+ * @profile: tuning profile to apply
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Sets the recommended stripe cache size, number of worker threads and sync speed
+ * limits of a RAID 4/5/6 array for its type of member devices:
+ *
+ * - %BD_MD_TUNE_PROFILE_HDD: big stripe cache (to make full stripe writes more likely),
+ *   no worker threads (the disks are the bottleneck), system sync speed limits
+ * - %BD_MD_TUNE_PROFILE_NVME: smaller stripe cache, worker threads to spread the parity
+ *   calculations over multiple CPUs (at most 8 threads), higher minimum sync speed
+ *
+ * The settings are not persistent and need to be applied again after the array
+ * is assembled.
+ *
+ * Returns: whether the @profile was successfully applied to @raid_spec or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_MODIFY
+ */
+gboolean bd_md_tune (const gchar *raid_spec, BDMDTuneProfile profile, GError **error) {
+    gchar *level = NULL;
+    guint threads = 0;
+
+    level = get_md_attr (raid_spec, "level", error);
+    if (!level)
+        /* error is already populated */
+        return FALSE;
+
+    if ((g_strcmp0 (level, "raid4") != 0) && (g_strcmp0 (level, "raid5") != 0) &&
+        (g_strcmp0 (level, "raid6") != 0)) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "Tuning profiles are available only for RAID 4/5/6 arrays, '%s' is %s.", raid_spec, level);
+        g_free (level);
+        return FALSE;
+    }
+    g_free (level);
+
+    switch (profile) {
+        case BD_MD_TUNE_PROFILE_HDD:
+            return bd_md_set_stripe_cache_size (raid_spec, TUNE_HDD_STRIPE_CACHE_SIZE, error) &&
+                   bd_md_set_group_thread_cnt (raid_spec, 0, error) &&
+                   bd_md_set_sync_speed_limits (raid_spec, 0, 0, error);
+        case BD_MD_TUNE_PROFILE_NVME:
+            threads = CLAMP (g_get_num_processors () / 2, 1, TUNE_NVME_MAX_GROUP_THREADS);
+            return bd_md_set_stripe_cache_size (raid_spec, TUNE_NVME_STRIPE_CACHE_SIZE, error) &&
+                   bd_md_set_group_thread_cnt (raid_spec, threads, error) &&
+                   bd_md_set_sync_speed_limits (raid_spec, TUNE_NVME_SYNC_SPEED_MIN, 0, error);
+        default:
+            g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                         "Invalid tuning profile %d", profile);
+            return FALSE;
+    }
+}
+
 /**
  * bd_md_request_sync_action:
  * @raid_spec: specification of the RAID device (name, node or path) to request sync action on
@@ -1543,3 +2508,220 @@ gboolean bd_md_request_sync_action (const gchar *raid_spec, const gchar *action,
 
     return TRUE;
 }
+
+/* the sysfs attributes we get notified about (sysfs_notify()) */
+static const gchar* const monitor_attrs[] = {"sync_action", "sync_completed", "array_state"};
+#define N_MONITOR_ATTRS G_N_ELEMENTS (monitor_attrs)
+
+#define MONITOR_ATTR_BUF_SIZE 64
+
+typedef struct MDMonitorItem {
+    gchar *node;
+    gint fds[N_MONITOR_ATTRS];
+    gchar values[N_MONITOR_ATTRS][MONITOR_ATTR_BUF_SIZE];
+    gchar *action;
+    guint64 task_id;
+    guint64 completion;
+} MDMonitorItem;
+
+static gboolean read_monitor_attr (gint fd, gchar *buf) {
+    gssize len = 0;
+
+    /* sysfs attributes need to be read from the start to re-arm the notification */
+    if (lseek (fd, 0, SEEK_SET) != 0)
+        return FALSE;
+    len = read (fd, buf, MONITOR_ATTR_BUF_SIZE - 1);
+    if (len < 0)
+        return FALSE;
+    buf[len] = '\0';
+    g_strstrip (buf);
+
+    return TRUE;
+}
+
+static gboolean sync_action_running (const gchar *action) {
+    return action && (g_strcmp0 (action, "idle") != 0) && (g_strcmp0 (action, "frozen") != 0);
+}
+
+static void update_monitor_item (MDMonitorItem *item) {
+    gchar old_state[MONITOR_ATTR_BUF_SIZE];
+    gchar *msg = NULL;
+    gchar **fields = NULL;
+    guint64 done = 0;
+    guint64 total = 0;
+    guint64 completion = 0;
+
+    /* 0 - sync_action, 1 - sync_completed, 2 - array_state */
+    memcpy (old_state, item->values[2], MONITOR_ATTR_BUF_SIZE);
+    for (guint i = 0; i < N_MONITOR_ATTRS; i++)
+        if (!read_monitor_attr (item->fds[i], item->values[i]))
+            item->values[i][0] = '\0';
+
+    if (item->task_id != 0 && g_strcmp0 (item->action, item->values[0]) != 0) {
+        /* the previous action finished (or was replaced by a different one) */
+        msg = g_strdup_printf ("%s: %s finished", item->node, item->action);
+        bd_utils_report_finished (item->task_id, msg);
+        g_free (msg);
+        item->task_id = 0;
+    }
+    g_free (item->action);
+    item->action = g_strdup (item->values[0]);
+
+    if (!sync_action_running (item->action))
+        return;
+
+    if (item->task_id == 0) {
+        msg = g_strdup_printf ("%s: %s started", item->node, item->action);
+        item->task_id = bd_utils_report_started (msg);
+        g_free (msg);
+        item->completion = 0;
+    }
+
+    /* "done / total" in sectors or "none" or "delayed" */
+    fields = g_strsplit (item->values[1], "/", 2);
+    if (g_strv_length (fields) == 2) {
+        done = g_ascii_strtoull (fields[0], NULL, 10);
+        total = g_ascii_strtoull (fields[1], NULL, 10);
+        if (total > 0)
+            completion = MIN (done * 100 / total, 100);
+    }
+    g_strfreev (fields);
+
+    if (old_state[0] != '\0' && g_strcmp0 (old_state, item->values[2]) != 0) {
+        msg = g_strdup_printf ("%s: array state changed to %s", item->node, item->values[2]);
+        bd_utils_report_progress (item->task_id, MAX (completion, item->completion), msg);
+        g_free (msg);
+    } else if (completion > item->completion)
+        bd_utils_report_progress (item->task_id, completion, NULL);
+    item->completion = MAX (completion, item->completion);
+}
+
+/**
+ * bd_md_monitor_sync:
+ * @raid_specs: (array zero-terminated=1): specifications of the RAID devices (names, nodes or paths)
+ *                                         to monitor
+ * @timeout: maximum time (in seconds) to wait for the sync actions to finish or 0 to wait
+ *           without a time limit
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Waits for the sync actions (resync, recovery, check, repair or reshape) running
+ * on all the @raid_specs RAIDs to finish. Instead of polling the status the
+ * `sync_action`, `sync_completed` and `array_state` sysfs attributes are watched
+ * for change notifications from the kernel. Every sync action is reported
+ * as a separate task via the progress reporting functions (see
+ * bd_utils_init_prog_reporting()) with progress updates for the changes of
+ * the completion and array state.
+ *
+ * Returns: whether all the sync actions finished (in @timeout) or not
+ *
+ * Tech category: %BD_MD_TECH_MDRAID-%BD_MD_TECH_MODE_QUERY
+ */
+gboolean bd_md_monitor_sync (const gchar **raid_specs, guint timeout, GError **error) {
+    MDMonitorItem *items = NULL;
+    guint n_items = 0;
+    struct pollfd *fds = NULL;
+    gchar *sys_path = NULL;
+    gint64 deadline = 0;
+    gint64 now = 0;
+    gint poll_timeout = -1;
+    gint rc = 0;
+    gboolean running = FALSE;
+    gboolean ret = FALSE;
+    gchar *msg = NULL;
+
+    if (!raid_specs || !raid_specs[0]) {
+        g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_INVAL,
+                     "No RAID devices specified");
+        return FALSE;
+    }
+
+    n_items = g_strv_length ((gchar **) raid_specs);
+    items = g_new0 (MDMonitorItem, n_items);
+    fds = g_new0 (struct pollfd, n_items * N_MONITOR_ATTRS);
+    for (guint i = 0; i < n_items; i++)
+        for (guint j = 0; j < N_MONITOR_ATTRS; j++)
+            items[i].fds[j] = -1;
+
+    for (guint i = 0; i < n_items; i++) {
+        items[i].node = get_sysfs_name_from_input (raid_specs[i], error);
+        if (!items[i].node)
+            /* error is already populated */
+            goto out;
+
+        for (guint j = 0; j < N_MONITOR_ATTRS; j++) {
+            sys_path = g_strdup_printf ("/sys/class/block/%s/md/%s", items[i].node, monitor_attrs[j]);
+            items[i].fds[j] = open (sys_path, O_RDONLY);
+            if (items[i].fds[j] < 0) {
+                g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_FAIL,
+                             "Failed to open '%s': %m", sys_path);
+                g_free (sys_path);
+                goto out;
+            }
+            g_free (sys_path);
+
+            fds[i * N_MONITOR_ATTRS + j].fd = items[i].fds[j];
+            fds[i * N_MONITOR_ATTRS + j].events = POLLPRI | POLLERR;
+        }
+    }
+
+    if (timeout > 0)
+        deadline = g_get_monotonic_time () + ((gint64) timeout * G_USEC_PER_SEC);
+
+    /* initial state (also arms the notifications) */
+    for (guint i = 0; i < n_items; i++)
+        update_monitor_item (&(items[i]));
+
+    while (TRUE) {
+        running = FALSE;
+        for (guint i = 0; !running && i < n_items; i++)
+            running = sync_action_running (items[i].action);
+        if (!running) {
+            ret = TRUE;
+            break;
+        }
+
+        if (deadline > 0) {
+            now = g_get_monotonic_time ();
+            if (now >= deadline) {
+                g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_FAIL,
+                             "Timed out waiting for the sync actions to finish");
+                break;
+            }
+            poll_timeout = (gint) ((deadline - now + 999) / 1000);
+        }
+
+        rc = poll (fds, n_items * N_MONITOR_ATTRS, poll_timeout);
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            g_set_error (error, BD_MD_ERROR, BD_MD_ERROR_FAIL,
+                         "Failed to wait for MD RAID changes: %m");
+            break;
+        }
+
+        for (guint i = 0; rc > 0 && i < n_items; i++)
+            for (guint j = 0; j < N_MONITOR_ATTRS; j++)
+                if (fds[i * N_MONITOR_ATTRS + j].revents != 0) {
+                    update_monitor_item (&(items[i]));
+                    break;
+                }
+    }
+
+ out:
+    for (guint i = 0; i < n_items; i++) {
+        if (items[i].task_id != 0) {
+            msg = g_strdup_printf ("%s: %s not finished", items[i].node, items[i].action);
+            bd_utils_report_finished (items[i].task_id, msg);
+            g_free (msg);
+        }
+        for (guint j = 0; j < N_MONITOR_ATTRS; j++)
+            if (items[i].fds[j] >= 0)
+                close (items[i].fds[j]);
+        g_free (items[i].node);
+        g_free (items[i].action);
+    }
+    g_free (items);
+    g_free (fds);
+
+    return ret;
+}
@@ -58,6 +58,17 @@ typedef struct BDMDDetailData {
 void bd_md_detail_data_free (BDMDDetailData *data);
 BDMDDetailData* bd_md_detail_data_copy (BDMDDetailData *data);
 
+typedef struct BDMDActivateResult {
+    gchar *uuid;
+    gchar *device;
+    gchar **members;
+    gboolean success;
+    GError *error;
+} BDMDActivateResult;
+
+BDMDActivateResult* bd_md_activate_result_copy (BDMDActivateResult *data);
+void bd_md_activate_result_free (BDMDActivateResult *data);
+
 typedef enum {
     BD_MD_TECH_MDRAID = 0,
 } BDMDTech;
@@ -69,6 +80,11 @@ typedef enum {
     BD_MD_TECH_MODE_QUERY  = 1 << 3,
 } BDMDTechMode;
 
+typedef enum {
+    BD_MD_TUNE_PROFILE_HDD = 0,
+    BD_MD_TUNE_PROFILE_NVME,
+} BDMDTuneProfile;
+
 
 /*
  * If using the plugin as a standalone library, the following functions should
@@ -88,6 +104,7 @@ gboolean bd_md_create (const gchar *device_name, const gchar *level, const gchar
 gboolean bd_md_destroy (const gchar *device, GError **error);
 gboolean bd_md_deactivate (const gchar *raid_spec, GError **error);
 gboolean bd_md_activate (const gchar *raid_spec, const gchar **members, const gchar *uuid, gboolean start_degraded, const BDExtraArg **extra, GError **error);
+BDMDActivateResult** bd_md_activate_many (const gchar **members, gboolean start_degraded, guint max_workers, const BDExtraArg **extra, GError **error);
 gboolean bd_md_run (const gchar *raid_spec, GError **error);
 gboolean bd_md_nominate (const gchar *device, GError **error);
 gboolean bd_md_denominate (const gchar *device, GError **error);
@@ -102,6 +119,18 @@ gchar* bd_md_name_from_node (const gchar *node, GError **error);
 gchar* bd_md_get_status (const gchar *raid_spec, GError **error);
 gboolean bd_md_set_bitmap_location (const gchar *raid_spec, const gchar *location, GError **error);
 gchar* bd_md_get_bitmap_location (const gchar *raid_spec, GError **error);
+guint64 bd_md_get_stripe_cache_size (const gchar *raid_spec, GError **error);
+gboolean bd_md_set_stripe_cache_size (const gchar *raid_spec, guint64 size, GError **error);
+guint64 bd_md_get_group_thread_cnt (const gchar *raid_spec, GError **error);
+gboolean bd_md_set_group_thread_cnt (const gchar *raid_spec, guint64 count, GError **error);
+gboolean bd_md_get_sync_speed_limits (const gchar *raid_spec, guint64 *speed_min, guint64 *speed_max, GError **error);
+gboolean bd_md_set_sync_speed_limits (const gchar *raid_spec, guint64 speed_min, guint64 speed_max, GError **error);
+gchar* bd_md_get_consistency_policy (const gchar *raid_spec, GError **error);
+gboolean bd_md_set_consistency_policy (const gchar *raid_spec, const gchar *policy, GError **error);
+guint64 bd_md_get_bitmap_chunk_size (const gchar *raid_spec, GError **error);
+gboolean bd_md_set_bitmap_chunk_size (const gchar *raid_spec, guint64 chunk_size, GError **error);
+gboolean bd_md_tune (const gchar *raid_spec, BDMDTuneProfile profile, GError **error);
 gboolean bd_md_request_sync_action (const gchar *raid_spec, const gchar *action, GError **error);
+gboolean bd_md_monitor_sync (const gchar **raid_specs, guint timeout, GError **error);
 
 #endif  /* BD_MD */
@@ -20,12 +20,13 @@
 #include <glib.h>
 /* provides major and minor macros */
 #include <sys/sysmacros.h>
-#include <libdevmapper.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <blockdev/utils.h>
 
 #include "mpath.h"
 #include "check_deps.h"
+#include "dm_snapshot.h"
 
 #define MULTIPATH_MIN_VERSION "0.4.9"
 
@@ -49,6 +50,12 @@ GQuark bd_mpath_error_quark (void)
 static volatile guint avail_deps = 0;
 static GMutex deps_check_lock;
 
+/* index of the multipath members (dev_t -> name of the multipath map), built
+ * from a DM maps snapshot and rebuilt only when a new snapshot is taken */
+static GMutex members_index_lock;
+static DMSnapshot *members_index_snapshot = NULL;
+static GHashTable *members_index = NULL;
+
 #define DEPS_MPATH 0
 #define DEPS_MPATH_MASK (1 << DEPS_MPATH)
 #define DEPS_MPATHCONF 1
@@ -81,7 +88,16 @@ gboolean bd_mpath_init (void) {
  *
  */
 void bd_mpath_close (void) {
-    /* nothing to do here */
+    g_mutex_lock (&members_index_lock);
+    if (members_index) {
+        g_hash_table_destroy (members_index);
+        members_index = NULL;
+    }
+    dm_snapshot_unref (members_index_snapshot);
+    members_index_snapshot = NULL;
+    g_mutex_unlock (&members_index_lock);
+
+    dm_snapshot_invalidate ();
 }
 
 /**
@@ -187,63 +203,11 @@ static gchar* get_device_name (const gchar *major_minor, GError **error) {
     return ret;
 }
 
-static gboolean map_is_multipath (const gchar *map_name, GError **error) {
-    struct dm_task *task = NULL;
-    struct dm_info info;
-    guint64 start = 0;
-    guint64 length = 0;
-    gchar *type = NULL;
-    gchar *params = NULL;
-    gboolean ret = FALSE;
-
-    if (geteuid () != 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_NOT_ROOT,
-                     "Not running as root, cannot query DM maps");
-        return FALSE;
-    }
-
-    task = dm_task_create (DM_DEVICE_STATUS);
-    if (!task) {
-        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create DM task");
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to create DM task");
-        return FALSE;
-    }
-
-    if (dm_task_set_name (task, map_name) == 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to create DM task");
-        dm_task_destroy (task);
-        return FALSE;
-    }
-
-    if (dm_task_run (task) == 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to run DM task");
-        dm_task_destroy (task);
-        return FALSE;
-    }
-
-    if (dm_task_get_info (task, &info) == 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to get task info");
-        dm_task_destroy (task);
-        return FALSE;
-    }
-
-    dm_get_next_target (task, NULL, &start, &length, &type, &params);
-    if (g_strcmp0 (type, "multipath") == 0)
-        ret = TRUE;
-    else
-        ret = FALSE;
-    dm_task_destroy (task);
-
-    return ret;
+static gboolean map_is_multipath (const DMSnapshotMap *map) {
+    return g_strcmp0 (map->target_type, "multipath") == 0;
 }
 
-static gchar** get_map_deps (const gchar *map_name, guint64 *n_deps, GError **error) {
-    struct dm_task *task;
-    struct dm_deps *deps;
+static gchar** get_map_deps (const DMSnapshotMap *map, guint64 *n_deps, GError **error) {
     guint64 dev_major = 0;
     guint64 dev_minor = 0;
     guint64 i = 0;
@@ -251,67 +215,99 @@ static gchar** get_map_deps (const gchar *map_name, guint64 *n_deps, GError **er
     gchar *major_minor = NULL;
     GError *l_error = NULL;
 
-    if (geteuid () != 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_NOT_ROOT,
-                     "Not running as root, cannot query DM maps");
-        return NULL;
-    }
-
-    task = dm_task_create (DM_DEVICE_DEPS);
-    if (!task) {
-        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create DM task");
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to create DM task");
-        return NULL;
-    }
-
-    if (dm_task_set_name (task, map_name) == 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to create DM task");
-        dm_task_destroy (task);
-        return NULL;
-    }
-
-    if (dm_task_run (task) == 0) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to run DM task");
-        dm_task_destroy (task);
-        return NULL;
-    }
-
-    deps = dm_task_get_deps (task);
-    if (!deps) {
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to device dependencies");
-        dm_task_destroy (task);
-        return NULL;
-    }
-
     /* allocate space for the dependencies */
-    dep_devs = g_new0 (gchar*, deps->count + 1);
+    dep_devs = g_new0 (gchar*, map->n_deps + 1);
 
-    for (i = 0; i < deps->count; i++) {
-        dev_major = (guint64) major (deps->device[i]);
-        dev_minor = (guint64) minor (deps->device[i]);
+    for (i = 0; i < map->n_deps; i++) {
+        dev_major = (guint64) major (map->deps[i]);
+        dev_minor = (guint64) minor (map->deps[i]);
         major_minor = g_strdup_printf ("%"G_GUINT64_FORMAT":%"G_GUINT64_FORMAT, dev_major, dev_minor);
         dep_devs[i] = get_device_name (major_minor, &l_error);
         if (l_error) {
             g_propagate_prefixed_error (error, l_error, "Failed to resolve '%s' to device name",
                                         major_minor);
-            g_free (dep_devs);
+            g_strfreev (dep_devs);
             g_free (major_minor);
             return NULL;
         }
         g_free (major_minor);
     }
-    dep_devs[deps->count] = NULL;
+    dep_devs[map->n_deps] = NULL;
     if (n_deps)
-        *n_deps = deps->count;
+        *n_deps = map->n_deps;
 
-    dm_task_destroy (task);
     return dep_devs;
 }
 
+static guint dev_hash (gconstpointer key) {
+    const dev_t dev = *((const dev_t *) key);
+    return (guint) (dev ^ (dev >> 32));
+}
+
+static gboolean dev_equal (gconstpointer a, gconstpointer b) {
+    return *((const dev_t *) a) == *((const dev_t *) b);
+}
+
+/* must be called with members_index_lock held, returns %FALSE in case of error */
+static gboolean update_members_index (GError **error) {
+    DMSnapshot *snapshot = NULL;
+    const DMSnapshotMap *map = NULL;
+    guint i = 0;
+    guint j = 0;
+
+    snapshot = dm_snapshot_get (FALSE);
+    if (!snapshot) {
+        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
+                     "Failed to get the list of DM maps");
+        return FALSE;
+    }
+
+    if (snapshot == members_index_snapshot) {
+        /* still the same maps, nothing to do */
+        dm_snapshot_unref (snapshot);
+        return TRUE;
+    }
+
+    if (members_index)
+        g_hash_table_destroy (members_index);
+    dm_snapshot_unref (members_index_snapshot);
+
+    /* keys and values point to the snapshot's data which we keep a reference to */
+    members_index = g_hash_table_new (dev_hash, dev_equal);
+    for (i = 0; i < snapshot->maps->len; i++) {
+        map = snapshot->maps->pdata[i];
+        if (!map_is_multipath (map))
+            continue;
+        for (j = 0; j < map->n_deps; j++)
+            g_hash_table_insert (members_index, &(map->deps[j]), map->name);
+    }
+    members_index_snapshot = snapshot;
+
+    return TRUE;
+}
+
+/* "sda", "/dev/sda", "/dev/mapper/foo",... -> dev_t, returns %FALSE if the
+ * device doesn't exist (is not a block device) */
+static gboolean get_device_devno (const gchar *device, dev_t *devno) {
+    gchar *path = NULL;
+    struct stat st;
+    gint ret = 0;
+
+    if (g_str_has_prefix (device, "/"))
+        ret = stat (device, &st);
+    else {
+        path = g_strdup_printf ("/dev/%s", device);
+        ret = stat (path, &st);
+        g_free (path);
+    }
+
+    if (ret != 0 || !S_ISBLK (st.st_mode))
+        return FALSE;
+
+    *devno = st.st_rdev;
+    return TRUE;
+}
+
 /**
  * bd_mpath_is_mpath_member:
  * @device: device to test
@@ -323,14 +319,8 @@ static gchar** get_map_deps (const gchar *map_name, guint64 *n_deps, GError **er
  * Tech category: %BD_MPATH_TECH_BASE-%BD_MPATH_TECH_MODE_QUERY
  */
 gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error) {
-    struct dm_task *task_names = NULL;
-    struct dm_names *names = NULL;
-    gchar *dev_path = NULL;
-    guint64 next = 0;
-    gchar **deps = NULL;
-    gchar **dev_name = NULL;
+    dev_t devno = 0;
     gboolean ret = FALSE;
-    GError *l_error = NULL;
 
     if (geteuid () != 0) {
         g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_NOT_ROOT,
@@ -338,74 +328,59 @@ gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error) {
         return FALSE;
     }
 
-    /* we check if the 'device' is a dependency of any multipath map  */
-    /* get maps */
-    task_names = dm_task_create (DM_DEVICE_LIST);
-    if (!task_names) {
-        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create DM task");
-        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to create DM task");
+    if (!get_device_devno (device, &devno))
+        /* the device doesn't exist and thus is not an mpath member */
         return FALSE;
-    }
 
-    dm_task_run (task_names);
-    names = dm_task_get_names (task_names);
+    g_mutex_lock (&members_index_lock);
+    if (update_members_index (error))
+        ret = g_hash_table_contains (members_index, &devno);
+    g_mutex_unlock (&members_index_lock);
 
-    if (!names || !names->dev)
-        return FALSE;
+    return ret;
+}
 
-    /* in case the device is dev_path, we need to resolve it because maps's deps
-       are devices and not their dev_paths */
-    if (g_str_has_prefix (device, "/dev/mapper/") || g_str_has_prefix (device, "/dev/md/")) {
-        dev_path = bd_utils_resolve_device (device, NULL);
-        if (!dev_path) {
-            /* the device doesn't exist and thus is not an mpath member */
-            dm_task_destroy (task_names);
-            return FALSE;
-        }
+/**
+ * bd_mpath_filter_mpath_members:
+ * @devices: (array zero-terminated=1): devices to test
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * The same as bd_mpath_is_mpath_member() but for multiple devices at once. The
+ * index of all multipath members is built only once so this is much faster
+ * than calling bd_mpath_is_mpath_member() for every device.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): devices from @devices that
+ *                                                     are multipath members (in
+ *                                                     the same order) or %NULL in
+ *                                                     case of error
+ *
+ * Tech category: %BD_MPATH_TECH_BASE-%BD_MPATH_TECH_MODE_QUERY
+ */
+gchar** bd_mpath_filter_mpath_members (const gchar **devices, GError **error) {
+    GPtrArray *ret = NULL;
+    const gchar **device = NULL;
+    dev_t devno = 0;
 
-        /* the dev_path starts with "../" */
-        device = dev_path + 3;
+    if (geteuid () != 0) {
+        g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_NOT_ROOT,
+                     "Not running as root, cannot query DM maps");
+        return NULL;
     }
 
-    if (g_str_has_prefix (device, "/dev/"))
-        device += 5;
+    g_mutex_lock (&members_index_lock);
+    if (!update_members_index (error)) {
+        g_mutex_unlock (&members_index_lock);
+        return NULL;
+    }
 
-    /* check all maps */
-    do {
-        names = (void *)names + next;
-        next = names->next;
+    ret = g_ptr_array_new ();
+    for (device = devices; device && *device; device++)
+        if (get_device_devno (*device, &devno) && g_hash_table_contains (members_index, &devno))
+            g_ptr_array_add (ret, g_strdup (*device));
+    g_mutex_unlock (&members_index_lock);
 
-        /* we are only interested in multipath maps */
-        if (map_is_multipath (names->name, &l_error)) {
-            deps = get_map_deps (names->name, NULL, &l_error);
-            if (!deps) {
-                if (l_error)
-                    g_propagate_prefixed_error (error, l_error, "Failed to determine deps for '%s'",
-                                                names->name);
-                else
-                    g_set_error (error, BD_MPATH_ERROR, BD_MPATH_ERROR_NOT_ROOT,
-                                 "No deps found for '%s'", names->name);
-                g_free (dev_path);
-                dm_task_destroy (task_names);
-                g_strfreev (deps);
-                return FALSE;
-            }
-            for (dev_name = deps; !ret && *dev_name; dev_name++)
-                ret = (g_strcmp0 (*dev_name, device) == 0);
-            g_strfreev (deps);
-        } else if (l_error) {
-            g_propagate_prefixed_error (error, l_error, "Failed to determine map's target for '%s'",
-                                        names->name);
-            g_free (dev_path);
-            dm_task_destroy (task_names);
-            return FALSE;
-        }
-    } while (!ret && next);
-
-    g_free (dev_path);
-    dm_task_destroy (task_names);
-    return ret;
+    g_ptr_array_add (ret, NULL);
+    return (gchar **) g_ptr_array_free (ret, FALSE);
 }
 
 /**
@@ -419,17 +394,14 @@ gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error) {
  * Tech category: %BD_MPATH_TECH_BASE-%BD_MPATH_TECH_MODE_QUERY
  */
 gchar** bd_mpath_get_mpath_members (GError **error) {
-    struct dm_task *task_names = NULL;
-    struct dm_names *names = NULL;
-    guint64 next = 0;
+    DMSnapshot *snapshot = NULL;
+    const DMSnapshotMap *map = NULL;
     gchar **deps = NULL;
     gchar **dev_name = NULL;
-    guint64 n_deps = 0;
-    guint64 n_devs = 0;
-    guint64 top_dev = 0;
-    gchar **ret = NULL;
+    GPtrArray *ret = NULL;
     guint64 progress_id = 0;
     GError *l_error = NULL;
+    guint i = 0;
 
     progress_id = bd_utils_report_started ("Started getting mpath members");
 
@@ -443,60 +415,51 @@ gchar** bd_mpath_get_mpath_members (GError **error) {
 
     /* we check if the 'device' is a dependency of any multipath map  */
     /* get maps */
-    task_names = dm_task_create (DM_DEVICE_LIST);
-    if (!task_names) {
-        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create DM task");
+    snapshot = dm_snapshot_get (FALSE);
+    if (!snapshot) {
         g_set_error (&l_error, BD_MPATH_ERROR, BD_MPATH_ERROR_DM_ERROR,
-                     "Failed to create DM task");
+                     "Failed to get the list of DM maps");
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
         return NULL;
     }
 
-    dm_task_run (task_names);
-    names = dm_task_get_names (task_names);
-
-    if (!names || !names->dev) {
+    if (snapshot->maps->len == 0) {
+        dm_snapshot_unref (snapshot);
         bd_utils_report_finished (progress_id, "Completed");
         return NULL;
     }
 
-    ret = g_new0 (gchar*, 1);
-    n_devs = 1;
+    ret = g_ptr_array_new ();
 
     /* check all maps */
-    do {
-        names = (void *)names + next;
-        next = names->next;
+    for (i = 0; i < snapshot->maps->len; i++) {
+        map = snapshot->maps->pdata[i];
 
         /* we are only interested in multipath maps */
-        if (map_is_multipath (names->name, NULL)) {
-            deps = get_map_deps (names->name, &n_deps, &l_error);
-            if (l_error) {
-                g_prefix_error (&l_error, "Failed to determine deps for '%s'", names->name);
-                dm_task_destroy (task_names);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
-                g_free (deps);
-                g_free (ret);
-                return NULL;
-            }
-            if (deps) {
-                n_devs += n_deps;
-                ret = g_renew (gchar*, ret, n_devs);
-                for (dev_name=deps; *dev_name; dev_name++) {
-                    ret[top_dev] = *dev_name;
-                    top_dev += 1;
-                }
-                g_free (deps);
-            }
+        if (!map_is_multipath (map))
+            continue;
+
+        deps = get_map_deps (map, NULL, &l_error);
+        if (!deps) {
+            g_prefix_error (&l_error, "Failed to determine deps for '%s'", map->name);
+            dm_snapshot_unref (snapshot);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            g_ptr_array_set_free_func (ret, g_free);
+            g_ptr_array_free (ret, TRUE);
+            return NULL;
         }
-    } while (next);
+        for (dev_name = deps; *dev_name; dev_name++)
+            g_ptr_array_add (ret, *dev_name);
+        g_free (deps);
+    }
 
-    ret[top_dev] = NULL;
+    dm_snapshot_unref (snapshot);
+    g_ptr_array_add (ret, NULL);
     bd_utils_report_finished (progress_id, "Completed");
 
-    return ret;
+    return (gchar **) g_ptr_array_free (ret, FALSE);
 }
 
 
@@ -39,6 +39,7 @@ gboolean bd_mpath_is_tech_avail (BDMpathTech tech, guint64 mode, GError **error)
 
 gboolean bd_mpath_flush_mpaths (GError **error);
 gboolean bd_mpath_is_mpath_member (const gchar *device, GError **error);
+gchar** bd_mpath_filter_mpath_members (const gchar **devices, GError **error);
 gchar** bd_mpath_get_mpath_members (GError **error);
 gboolean bd_mpath_set_friendly_names (gboolean enabled, GError **error);
 
@@ -83,6 +83,99 @@ static const UtilDep deps[DEPS_LAST] = {
     {"ndctl", NULL, NULL, NULL},
 };
 
+/* The ndctl context is kept for the whole plugin lifetime together with an
+ * index of the namespaces so that the queries don't need to create a new
+ * context and walk the whole bus/region/namespace topology again and again.
+ * The context is refreshed (with ndctl_invalidate()) when it's older than
+ * NDCTL_CTX_TTL, when a namespace is not found in the index and after the
+ * namespaces are reconfigured. The context is not thread-safe, ctx_lock needs
+ * to be held whenever it (or the namespaces from it) is used. */
+#define NDCTL_CTX_TTL (2 * G_USEC_PER_SEC)
+
+static GMutex ctx_lock;
+static struct ndctl_ctx *ndctl_ctx = NULL;
+static gint64 ctx_timestamp = 0;
+/* namespaces in the topology order and indexed by their device name */
+static GPtrArray *namespaces_list = NULL;
+static GHashTable *namespaces_index = NULL;
+
+/* ctx_lock needs to be held */
+static void namespaces_index_build (void) {
+    struct ndctl_namespace *ndns = NULL;
+    struct ndctl_region *region = NULL;
+    struct ndctl_bus *bus = NULL;
+
+    namespaces_list = g_ptr_array_new ();
+    namespaces_index = g_hash_table_new (g_str_hash, g_str_equal);
+
+    ndctl_bus_foreach (ndctl_ctx, bus) {
+        ndctl_region_foreach (bus, region) {
+            ndctl_namespace_foreach (region, ndns) {
+                g_ptr_array_add (namespaces_list, ndns);
+                g_hash_table_insert (namespaces_index, (gpointer) ndctl_namespace_get_devname (ndns), ndns);
+            }
+        }
+    }
+
+    ctx_timestamp = g_get_monotonic_time ();
+}
+
+/* ctx_lock needs to be held */
+static void namespaces_index_drop (void) {
+    if (namespaces_index) {
+        g_hash_table_destroy (namespaces_index);
+        namespaces_index = NULL;
+    }
+    if (namespaces_list) {
+        g_ptr_array_free (namespaces_list, TRUE);
+        namespaces_list = NULL;
+    }
+}
+
+/* ctx_lock needs to be held, makes sure the context and the namespaces index
+   are available and up to date (or refreshed if @refresh is %TRUE) */
+static gboolean ensure_ctx (gboolean refresh, GError **error) {
+    gint ret = 0;
+
+    if (!ndctl_ctx) {
+        ret = ndctl_new (&ndctl_ctx);
+        if (ret != 0) {
+            g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
+                         "Failed to create ndctl context");
+            ndctl_ctx = NULL;
+            return FALSE;
+        }
+        namespaces_index_build ();
+    } else if (refresh || (g_get_monotonic_time () - ctx_timestamp) >= NDCTL_CTX_TTL) {
+        /* the namespace objects are freed by ndctl_invalidate() */
+        namespaces_index_drop ();
+        ndctl_invalidate (ndctl_ctx);
+        namespaces_index_build ();
+    }
+
+    return TRUE;
+}
+
+/* ctx_lock needs to be held */
+static struct ndctl_namespace* get_namespace_by_name (const gchar *namespace) {
+    struct ndctl_namespace *ndns = NULL;
+
+    ndns = g_hash_table_lookup (namespaces_index, namespace);
+    if (!ndns) {
+        /* may be a new namespace, try again with a fresh context */
+        ensure_ctx (TRUE, NULL);
+        ndns = g_hash_table_lookup (namespaces_index, namespace);
+    }
+
+    return ndns;
+}
+
+static void ctx_invalidate (void) {
+    g_mutex_lock (&ctx_lock);
+    ctx_timestamp = 0;
+    g_mutex_unlock (&ctx_lock);
+}
+
 /**
  * bd_nvdimm_init:
  *
@@ -105,8 +198,13 @@ gboolean bd_nvdimm_init (void) {
  * Deprecated: 3.1: NVDIMM plugin will be removed in the next major release
  */
 void bd_nvdimm_close (void) {
-    /* nothing to do here */
-    return;
+    g_mutex_lock (&ctx_lock);
+    namespaces_index_drop ();
+    if (ndctl_ctx) {
+        ndctl_unref (ndctl_ctx);
+        ndctl_ctx = NULL;
+    }
+    g_mutex_unlock (&ctx_lock);
 }
 
 
@@ -190,23 +288,6 @@ const gchar* bd_nvdimm_namespace_get_mode_str (BDNVDIMMNamespaceMode mode, GErro
     }
 }
 
-static struct ndctl_namespace* get_namespace_by_name (const gchar *namespace, struct ndctl_ctx *ctx) {
-    struct ndctl_namespace *ndns = NULL;
-    struct ndctl_region *region = NULL;
-    struct ndctl_bus *bus = NULL;
-
-    ndctl_bus_foreach (ctx, bus) {
-        ndctl_region_foreach (bus, region) {
-            ndctl_namespace_foreach (region, ndns) {
-                if (g_strcmp0 (namespace, ndctl_namespace_get_devname (ndns)) == 0)
-                    return ndns;
-            }
-        }
-    }
-
-    return NULL;
-}
-
 /**
  * bd_nvdimm_namespace_get_devname:
  * @device: name or path of a block device (e.g. "/dev/pmem0")
@@ -221,55 +302,46 @@ static struct ndctl_namespace* get_namespace_by_name (const gchar *namespace, st
  * Deprecated: 3.1: NVDIMM plugin will be removed in the next major release
  */
 gchar* bd_nvdimm_namespace_get_devname (const gchar *device, GError **error) {
-    struct ndctl_ctx *ctx = NULL;
     struct ndctl_namespace *ndns = NULL;
-    struct ndctl_region *region = NULL;
-    struct ndctl_bus *bus = NULL;
-    gint success = 0;
     gchar *ret = NULL;
 
     /* get rid of the "/dev/" prefix (if any) */
     if (g_str_has_prefix (device, "/dev/"))
         device = device + 5;
 
-    success = ndctl_new (&ctx);
-    if (success != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    g_mutex_lock (&ctx_lock);
+    if (!ensure_ctx (FALSE, error)) {
+        g_mutex_unlock (&ctx_lock);
         return NULL;
     }
 
-    ndctl_bus_foreach (ctx, bus) {
-        ndctl_region_foreach (bus, region) {
-            ndctl_namespace_foreach (region, ndns) {
-                if (!ndctl_namespace_is_active (ndns))
-                    continue;
-
-                struct ndctl_btt *btt = ndctl_namespace_get_btt (ndns);
-                struct ndctl_dax *dax = ndctl_namespace_get_dax (ndns);
-                struct ndctl_pfn *pfn = ndctl_namespace_get_pfn (ndns);
-                const gchar *blockdev = NULL;
-
-                if (dax)
-                    continue;
-                else if (btt)
-                    blockdev = ndctl_btt_get_block_device (btt);
-                else if (pfn)
-                    blockdev = ndctl_pfn_get_block_device (pfn);
-                else
-                    blockdev = ndctl_namespace_get_block_device (ndns);
-
-                if (g_strcmp0 (blockdev, device) == 0) {
-                    ret = g_strdup (ndctl_namespace_get_devname (ndns));
-                    ndctl_unref (ctx);
-                    return ret;
-                }
-            }
+    for (guint i = 0; i < namespaces_list->len; i++) {
+        ndns = g_ptr_array_index (namespaces_list, i);
+        if (!ndctl_namespace_is_active (ndns))
+            continue;
+
+        struct ndctl_btt *btt = ndctl_namespace_get_btt (ndns);
+        struct ndctl_dax *dax = ndctl_namespace_get_dax (ndns);
+        struct ndctl_pfn *pfn = ndctl_namespace_get_pfn (ndns);
+        const gchar *blockdev = NULL;
+
+        if (dax)
+            continue;
+        else if (btt)
+            blockdev = ndctl_btt_get_block_device (btt);
+        else if (pfn)
+            blockdev = ndctl_pfn_get_block_device (pfn);
+        else
+            blockdev = ndctl_namespace_get_block_device (ndns);
+
+        if (g_strcmp0 (blockdev, device) == 0) {
+            ret = g_strdup (ndctl_namespace_get_devname (ndns));
+            break;
         }
     }
+    g_mutex_unlock (&ctx_lock);
 
-    ndctl_unref (ctx);
-    return NULL;
+    return ret;
 }
 
 /**
@@ -285,33 +357,31 @@ gchar* bd_nvdimm_namespace_get_devname (const gchar *device, GError **error) {
  * Deprecated: 3.1: NVDIMM plugin will be removed in the next major release
  */
 gboolean bd_nvdimm_namespace_enable (const gchar *namespace, const BDExtraArg **extra G_GNUC_UNUSED, GError **error) {
-    struct ndctl_ctx *ctx = NULL;
     struct ndctl_namespace *ndns = NULL;
     gint ret = 0;
 
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    g_mutex_lock (&ctx_lock);
+    if (!ensure_ctx (FALSE, error)) {
+        g_mutex_unlock (&ctx_lock);
         return FALSE;
     }
 
-    ndns = get_namespace_by_name (namespace, ctx);
+    ndns = get_namespace_by_name (namespace);
     if (!ndns) {
         g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_NOEXIST,
                      "Failed to enable namespace: namespace '%s' not found.", namespace);
+        g_mutex_unlock (&ctx_lock);
         return FALSE;
     }
 
     ret = ndctl_namespace_enable (ndns);
+    g_mutex_unlock (&ctx_lock);
     if (ret < 0) {
         g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
                      "Failed to enable namespace: %s", strerror (-ret));
-        ndctl_unref (ctx);
         return FALSE;
     }
 
-    ndctl_unref (ctx);
     return TRUE;
 }
 
@@ -328,33 +398,31 @@ gboolean bd_nvdimm_namespace_enable (const gchar *namespace, const BDExtraArg **
  * Deprecated: 3.1: NVDIMM plugin will be removed in the next major release
  */
 gboolean bd_nvdimm_namespace_disable (const gchar *namespace, const BDExtraArg **extra G_GNUC_UNUSED, GError **error) {
-    struct ndctl_ctx *ctx = NULL;
     struct ndctl_namespace *ndns = NULL;
     gint ret = 0;
 
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    g_mutex_lock (&ctx_lock);
+    if (!ensure_ctx (FALSE, error)) {
+        g_mutex_unlock (&ctx_lock);
         return FALSE;
     }
 
-    ndns = get_namespace_by_name (namespace, ctx);
+    ndns = get_namespace_by_name (namespace);
     if (!ndns) {
         g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_NOEXIST,
                      "Failed to disable namespace: namespace '%s' not found.", namespace);
+        g_mutex_unlock (&ctx_lock);
         return FALSE;
     }
 
     ret = ndctl_namespace_disable_safe (ndns);
+    g_mutex_unlock (&ctx_lock);
     if (ret != 0) {
         g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
                      "Failed to disable namespace: %s", strerror (-ret));
-        ndctl_unref (ctx);
         return FALSE;
     }
 
-    ndctl_unref (ctx);
     return TRUE;
 }
 
@@ -492,27 +560,21 @@ static BDNVDIMMNamespaceInfo* get_nvdimm_namespace_info (struct ndctl_namespace
  * Deprecated: 3.1: NVDIMM plugin will be removed in the next major release
  */
 BDNVDIMMNamespaceInfo* bd_nvdimm_namespace_info (const gchar *namespace, const BDExtraArg **extra G_GNUC_UNUSED, GError **error) {
-    struct ndctl_ctx *ctx = NULL;
     struct ndctl_namespace *ndns = NULL;
     BDNVDIMMNamespaceInfo *info = NULL;
-    gint ret = 0;
 
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    g_mutex_lock (&ctx_lock);
+    if (!ensure_ctx (FALSE, error)) {
+        g_mutex_unlock (&ctx_lock);
         return NULL;
     }
 
-    ndns = get_namespace_by_name (namespace, ctx);
-    if (ndns) {
+    ndns = get_namespace_by_name (namespace);
+    if (ndns)
         info = get_nvdimm_namespace_info (ndns, error);
-        ndctl_unref (ctx);
-        return info;
-    }
+    g_mutex_unlock (&ctx_lock);
 
-    ndctl_unref (ctx);
-    return NULL;
+    return info;
 }
 
 /**
@@ -534,56 +596,53 @@ BDNVDIMMNamespaceInfo* bd_nvdimm_namespace_info (const gchar *namespace, const B
  */
 BDNVDIMMNamespaceInfo** bd_nvdimm_list_namespaces (const gchar *bus_name, const gchar *region_name, gboolean idle,
                                                    const BDExtraArg **extra G_GNUC_UNUSED, GError **error) {
-    struct ndctl_ctx *ctx = NULL;
     struct ndctl_namespace *ndns = NULL;
     struct ndctl_region *region = NULL;
     struct ndctl_bus *bus = NULL;
-    gint ret = 0;
     BDNVDIMMNamespaceInfo **info = NULL;
+    GPtrArray *namespaces = NULL;
 
-    GPtrArray *namespaces = g_ptr_array_new ();
-
-    ret = ndctl_new (&ctx);
-    if (ret != 0) {
-        g_set_error (error, BD_NVDIMM_ERROR, BD_NVDIMM_ERROR_NAMESPACE_FAIL,
-                     "Failed to create ndctl context");
+    g_mutex_lock (&ctx_lock);
+    if (!ensure_ctx (FALSE, error)) {
+        g_mutex_unlock (&ctx_lock);
         return NULL;
     }
 
-    ndctl_bus_foreach (ctx, bus) {
+    namespaces = g_ptr_array_new ();
+    for (guint i = 0; i < namespaces_list->len; i++) {
+        ndns = g_ptr_array_index (namespaces_list, i);
+        region = ndctl_namespace_get_region (ndns);
+        bus = ndctl_region_get_bus (region);
+
         if (bus_name && g_strcmp0 (bus_name, ndctl_bus_get_devname (bus)) != 0)
             continue;
 
-        ndctl_region_foreach (bus, region) {
-            if (region_name && g_strcmp0 (bus_name, ndctl_region_get_devname (region)) != 0)
-                continue;
+        if (region_name && g_strcmp0 (region_name, ndctl_region_get_devname (region)) != 0)
+            continue;
 
-            ndctl_namespace_foreach (region, ndns) {
-                if (!idle && !ndctl_namespace_is_active (ndns))
-                    continue;
-
-                BDNVDIMMNamespaceInfo *info = get_nvdimm_namespace_info (ndns, error);
-                if (!info) {
-                    g_ptr_array_foreach (namespaces, (GFunc) (void *) bd_nvdimm_namespace_info_free, NULL);
-                    g_ptr_array_free (namespaces, FALSE);
-                    ndctl_unref (ctx);
-                    return NULL;
-                }
-
-                g_ptr_array_add (namespaces, info);
-            }
+        if (!idle && !ndctl_namespace_is_active (ndns))
+            continue;
+
+        BDNVDIMMNamespaceInfo *info = get_nvdimm_namespace_info (ndns, error);
+        if (!info) {
+            g_ptr_array_foreach (namespaces, (GFunc) (void *) bd_nvdimm_namespace_info_free, NULL);
+            g_ptr_array_free (namespaces, FALSE);
+            g_mutex_unlock (&ctx_lock);
+            return NULL;
         }
+
+        g_ptr_array_add (namespaces, info);
     }
+    g_mutex_unlock (&ctx_lock);
 
     if (namespaces->len == 0) {
-        ndctl_unref (ctx);
+        g_ptr_array_free (namespaces, TRUE);
         return NULL;
     }
 
     g_ptr_array_add (namespaces, NULL);
 
     info = (BDNVDIMMNamespaceInfo **) g_ptr_array_free (namespaces, FALSE);
-    ndctl_unref (ctx);
 
     return info;
 }
@@ -623,6 +682,9 @@ gboolean bd_nvdimm_namespace_reconfigure (const gchar* namespace, BDNVDIMMNamesp
 
     ret = bd_utils_exec_and_report_error (args, extra, error);
 
+    /* the namespace was changed outside of our ndctl context */
+    ctx_invalidate ();
+
     g_free ((gchar *) args[5]);
     return ret;
 }
@@ -35,6 +35,7 @@
 #include <check_deps.h>
 #include "nvme.h"
 #include "nvme-private.h"
+#include "../../utils/parallel.h"
 
 
 /* nvme-cli defaults */
@@ -151,6 +152,48 @@ static void parse_extra_args (const BDExtraArg **extra, struct nvme_fabrics_conf
 }
 
 
+/* fills in the HostNQN and HostID values, using the system ones if not specified */
+static gboolean _get_host_ids (const gchar *host_nqn, const gchar *host_id, gchar **host_nqn_val, gchar **host_id_val, GError **error) {
+    gchar *nqn;
+    gchar *id;
+
+    /* HostNQN checks */
+    nqn = g_strdup (host_nqn);
+    id = g_strdup (host_id);
+    if (nqn == NULL)
+        nqn = nvmf_hostnqn_from_file ();
+    if (id == NULL)
+        id = nvmf_hostid_from_file ();
+    if (nqn == NULL)
+        nqn = nvmf_hostnqn_generate ();
+    if (nqn == NULL) {
+        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                             "Could not determine HostNQN");
+        g_free (nqn);
+        g_free (id);
+        return FALSE;
+    }
+    if (id == NULL) {
+        /* derive hostid from hostnqn, newer kernels refuse empty hostid */
+        id = g_strrstr (nqn, "uuid:");
+        if (id)
+            id = g_strdup (id + strlen ("uuid:"));
+        /* TODO: in theory generating arbitrary uuid might work as a fallback */
+    }
+    if (id == NULL) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                     "Could not determine HostID value from HostNQN '%s'",
+                     nqn);
+        g_free (nqn);
+        return FALSE;
+    }
+
+    *host_nqn_val = nqn;
+    *host_id_val = id;
+    return TRUE;
+}
+
+
 /**
  * bd_nvme_connect:
  * @subsysnqn: The name for the NVMe subsystem to connect to.
@@ -244,37 +287,8 @@ gboolean bd_nvme_connect (const gchar *subsysnqn, const gchar *transport, const
         return FALSE;
     }
 
-    /* HostNQN checks */
-    host_nqn_val = g_strdup (host_nqn);
-    host_id_val = g_strdup (host_id);
-    if (host_nqn_val == NULL)
-        host_nqn_val = nvmf_hostnqn_from_file ();
-    if (host_id_val == NULL)
-        host_id_val = nvmf_hostid_from_file ();
-    if (host_nqn_val == NULL)
-        host_nqn_val = nvmf_hostnqn_generate ();
-    if (host_nqn_val == NULL) {
-        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
-                             "Could not determine HostNQN");
-        g_free (host_nqn_val);
-        g_free (host_id_val);
+    if (!_get_host_ids (host_nqn, host_id, &host_nqn_val, &host_id_val, error))
         return FALSE;
-    }
-    if (host_id_val == NULL) {
-        /* derive hostid from hostnqn, newer kernels refuse empty hostid */
-        host_id_val = g_strrstr (host_nqn_val, "uuid:");
-        if (host_id_val)
-            host_id_val = g_strdup (host_id_val + strlen ("uuid:"));
-        /* TODO: in theory generating arbitrary uuid might work as a fallback */
-    }
-    if (host_id_val == NULL) {
-        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
-                     "Could not determine HostID value from HostNQN '%s'",
-                     host_nqn_val);
-        g_free (host_nqn_val);
-        g_free (host_id_val);
-        return FALSE;
-    }
 
     /* parse extra arguments */
     nvmf_default_config (&cfg);
@@ -324,6 +338,545 @@ gboolean bd_nvme_connect (const gchar *subsysnqn, const gchar *transport, const
     return TRUE;
 }
 
+/**
+ * bd_nvme_discovery_log_entry_free: (skip)
+ * @entry: (nullable): %BDNVMEDiscoveryLogEntry to free
+ *
+ * Frees @entry.
+ */
+void bd_nvme_discovery_log_entry_free (BDNVMEDiscoveryLogEntry *entry) {
+    if (entry == NULL)
+        return;
+
+    g_free (entry->transport);
+    g_free (entry->transport_addr);
+    g_free (entry->transport_svcid);
+    g_free (entry->subsysnqn);
+    g_free (entry);
+}
+
+/**
+ * bd_nvme_discovery_log_entry_copy: (skip)
+ * @entry: (nullable): %BDNVMEDiscoveryLogEntry to copy
+ *
+ * Creates a new copy of @entry.
+ */
+BDNVMEDiscoveryLogEntry * bd_nvme_discovery_log_entry_copy (BDNVMEDiscoveryLogEntry *entry) {
+    BDNVMEDiscoveryLogEntry *new_entry;
+
+    if (entry == NULL)
+        return NULL;
+
+    new_entry = g_new0 (BDNVMEDiscoveryLogEntry, 1);
+    new_entry->transport = g_strdup (entry->transport);
+    new_entry->transport_addr = g_strdup (entry->transport_addr);
+    new_entry->transport_svcid = g_strdup (entry->transport_svcid);
+    new_entry->subsysnqn = g_strdup (entry->subsysnqn);
+    new_entry->discovery = entry->discovery;
+    new_entry->port_id = entry->port_id;
+    new_entry->ctrl_id = entry->ctrl_id;
+
+    return new_entry;
+}
+
+/**
+ * bd_nvme_connect_result_free: (skip)
+ * @result: (nullable): %BDNVMEConnectResult to free
+ *
+ * Frees @result.
+ */
+void bd_nvme_connect_result_free (BDNVMEConnectResult *result) {
+    if (result == NULL)
+        return;
+
+    g_free (result->subsysnqn);
+    g_free (result->transport_addr);
+    g_free (result->transport_svcid);
+    g_clear_error (&(result->error));
+    g_free (result);
+}
+
+/**
+ * bd_nvme_connect_result_copy: (skip)
+ * @result: (nullable): %BDNVMEConnectResult to copy
+ *
+ * Creates a new copy of @result.
+ */
+BDNVMEConnectResult * bd_nvme_connect_result_copy (BDNVMEConnectResult *result) {
+    BDNVMEConnectResult *new_result;
+
+    if (result == NULL)
+        return NULL;
+
+    new_result = g_new0 (BDNVMEConnectResult, 1);
+    new_result->subsysnqn = g_strdup (result->subsysnqn);
+    new_result->transport_addr = g_strdup (result->transport_addr);
+    new_result->transport_svcid = g_strdup (result->transport_svcid);
+    new_result->attempts = result->attempts;
+    new_result->error = result->error ? g_error_copy (result->error) : NULL;
+
+    return new_result;
+}
+
+
+/* discovery log pages cached per discovery controller and host, see bd_nvme_discover() */
+static GHashTable *disc_cache = NULL;
+G_LOCK_DEFINE_STATIC (disc_cache);
+
+void _nvme_discovery_cache_clear (void) {
+    G_LOCK (disc_cache);
+    g_clear_pointer (&disc_cache, g_hash_table_destroy);
+    G_UNLOCK (disc_cache);
+}
+
+static BDNVMEDiscoveryLogEntry ** _copy_disc_entries (GPtrArray *entries) {
+    GPtrArray *ptr_array;
+    guint i;
+
+    ptr_array = g_ptr_array_new ();
+    for (i = 0; i < entries->len; i++)
+        g_ptr_array_add (ptr_array, bd_nvme_discovery_log_entry_copy (entries->pdata[i]));
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+
+    return (BDNVMEDiscoveryLogEntry **) g_ptr_array_free (ptr_array, FALSE);
+}
+
+/* the fixed size fields of the discovery log entries are padded with spaces */
+static gchar * _disc_log_field (const char *field, gsize len) {
+    gchar *ret;
+
+    ret = g_strndup (field, len);
+    g_strchomp (ret);
+    if (*ret == '\0') {
+        g_free (ret);
+        return NULL;
+    }
+    return ret;
+}
+
+/* creates a host object in a new (not scanned) topology tree */
+static nvme_host_t _create_host (nvme_root_t *root, const gchar *config_file, const gchar *host_nqn, const gchar *host_id, const gchar *hostkey, const gchar *hostsymname, GError **error) {
+    nvme_host_t host;
+
+    *root = nvme_create_root (NULL, -1);
+    if (*root == NULL) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                     "Failed to create topology root: %s",
+                     strerror_l (errno, _C_LOCALE));
+        return NULL;
+    }
+    nvme_init_logging (*root, -1, false, false);
+    /* missing configuration file is not an error */
+    if (config_file)
+        nvme_read_config (*root, config_file);
+
+    host = nvme_lookup_host (*root, host_nqn, host_id);
+    if (host == NULL) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                     "Unable to lookup host for HostNQN '%s' and HostID '%s'",
+                     host_nqn, host_id);
+        nvme_free_tree (*root);
+        *root = NULL;
+        return NULL;
+    }
+    if (hostkey)
+        nvme_host_set_dhchap_key (host, hostkey);
+    if (hostsymname)
+        nvme_host_set_hostsymname (host, hostsymname);
+
+    return host;
+}
+
+static GPtrArray * _get_discovery_log (const gchar *transport, const gchar *transport_addr, const gchar *transport_svcid, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, const BDExtraArg **extra, GError **error) {
+    const gchar *config_file = PATH_NVMF_CONFIG;
+    const gchar *hostkey = NULL;
+    const gchar *ctrlkey = NULL;
+    const gchar *hostsymname = NULL;
+    nvme_root_t root;
+    nvme_host_t host;
+    nvme_ctrl_t ctrl;
+    struct nvme_fabrics_config cfg;
+    struct nvmf_discovery_log *log = NULL;
+    struct nvmf_disc_log_entry *e;
+    BDNVMEDiscoveryLogEntry *entry;
+    GPtrArray *entries;
+    guint64 numrec;
+    guint64 i;
+    int ret;
+
+    nvmf_default_config (&cfg);
+    parse_extra_args (extra, &cfg, &config_file, &hostkey, &ctrlkey, &hostsymname);
+
+    host = _create_host (&root, config_file, host_nqn, host_id, hostkey, hostsymname, error);
+    if (host == NULL)
+        return NULL;
+
+    ctrl = nvme_create_ctrl (root, NVME_DISC_SUBSYS_NAME, transport, transport_addr, host_traddr, host_iface, transport_svcid);
+    if (ctrl == NULL) {
+        _nvme_fabrics_errno_to_gerror (-1, errno, error);
+        g_prefix_error (error, "Error creating the discovery controller: ");
+        nvme_free_tree (root);
+        return NULL;
+    }
+    if (ctrlkey)
+        nvme_ctrl_set_dhchap_key (ctrl, ctrlkey);
+
+    ret = nvmf_add_ctrl (host, ctrl, &cfg);
+    if (ret != 0) {
+        _nvme_fabrics_errno_to_gerror (ret, errno, error);
+        g_prefix_error (error, "Error connecting the discovery controller: ");
+        nvme_free_ctrl (ctrl);
+        nvme_free_tree (root);
+        return NULL;
+    }
+
+    ret = nvmf_get_discovery_log (ctrl, &log, MAX_DISC_RETRIES);
+    nvme_disconnect_ctrl (ctrl);
+    nvme_free_ctrl (ctrl);
+    nvme_free_tree (root);
+    if (ret != 0) {
+        _nvme_status_to_error (ret, TRUE, error);
+        g_prefix_error (error, "Error getting the discovery log page: ");
+        free (log);
+        return NULL;
+    }
+
+    entries = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_nvme_discovery_log_entry_free);
+    numrec = le64_to_cpu (log->numrec);
+    for (i = 0; i < numrec; i++) {
+        e = &log->entries[i];
+        entry = g_new0 (BDNVMEDiscoveryLogEntry, 1);
+        entry->transport = g_strdup (nvmf_trtype_str (e->trtype));
+        entry->transport_addr = _disc_log_field (e->traddr, sizeof (e->traddr));
+        entry->transport_svcid = _disc_log_field (e->trsvcid, sizeof (e->trsvcid));
+        entry->subsysnqn = _disc_log_field (e->subnqn, sizeof (e->subnqn));
+        entry->discovery = e->subtype == NVME_NQN_DISC || e->subtype == NVME_NQN_CURR;
+        entry->port_id = le16_to_cpu (e->portid);
+        entry->ctrl_id = le16_to_cpu (e->cntlid);
+        g_ptr_array_add (entries, entry);
+    }
+    free (log);
+
+    return entries;
+}
+
+/**
+ * bd_nvme_discover:
+ * @transport: The network fabric used for a NVMe-over-Fabrics network.
+ * @transport_addr: (nullable): The network address of the Discovery Controller.
+ * @transport_svcid: (nullable): The transport service id of the Discovery Controller.
+ * @host_traddr: (nullable): The network address used on the host to connect to the Discovery Controller.
+ * @host_iface: (nullable): The network interface used on the host to connect to the Discovery Controller.
+ * @host_nqn: (nullable): Overrides the default Host NQN that identifies the NVMe Host.
+ * @host_id: (nullable): User-defined host UUID or %NULL to use default (as defined in `/etc/nvme/hostid`).
+ * @refresh: Whether to ignore the cached Discovery Log Page and retrieve it from the Discovery Controller again.
+ * @extra: (nullable) (array zero-terminated=1): Additional arguments, see bd_nvme_connect().
+ * @error: (out) (nullable): Place to store error (if any).
+ *
+ * Connects to the Discovery Controller specified by @transport_addr and @transport_svcid,
+ * retrieves its Discovery Log Page and disconnects. The arguments have the same meaning
+ * as in bd_nvme_connect().
+ *
+ * The Discovery Log Page is cached for the particular Discovery Controller and host
+ * so that subsequent calls (e.g. when connecting the subsystems at boot) don't need
+ * to connect to the Discovery Controller again unless @refresh is %TRUE. Use @refresh
+ * to pick up changes in the fabric (e.g. after an Asynchronous Event Notification).
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the Discovery Log Page entries
+ *          (may be empty) or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_FABRICS-%BD_NVME_TECH_MODE_INITIATOR
+ */
+BDNVMEDiscoveryLogEntry ** bd_nvme_discover (const gchar *transport, const gchar *transport_addr, const gchar *transport_svcid, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, gboolean refresh, const BDExtraArg **extra, GError **error) {
+    gchar *host_nqn_val;
+    gchar *host_id_val;
+    gchar *key;
+    GPtrArray *entries;
+    BDNVMEDiscoveryLogEntry **ret = NULL;
+
+    if (transport == NULL) {
+        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                             "Invalid value specified for the transport argument");
+        return NULL;
+    }
+    if (transport_addr == NULL && !g_str_equal (transport, "loop") && !g_str_equal (transport, "pcie")) {
+        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                             "Invalid value specified for the transport address argument");
+        return NULL;
+    }
+
+    if (!_get_host_ids (host_nqn, host_id, &host_nqn_val, &host_id_val, error))
+        return NULL;
+
+    key = g_strdup_printf ("%s|%s|%s|%s|%s|%s|%s", transport,
+                           transport_addr ? transport_addr : "", transport_svcid ? transport_svcid : "",
+                           host_traddr ? host_traddr : "", host_iface ? host_iface : "",
+                           host_nqn_val, host_id_val);
+
+    if (!refresh) {
+        G_LOCK (disc_cache);
+        if (disc_cache) {
+            entries = g_hash_table_lookup (disc_cache, key);
+            if (entries)
+                ret = _copy_disc_entries (entries);
+        }
+        G_UNLOCK (disc_cache);
+        if (ret) {
+            g_free (key);
+            g_free (host_nqn_val);
+            g_free (host_id_val);
+            return ret;
+        }
+    }
+
+    entries = _get_discovery_log (transport, transport_addr, transport_svcid, host_traddr, host_iface,
+                                  host_nqn_val, host_id_val, extra, error);
+    g_free (host_nqn_val);
+    g_free (host_id_val);
+    if (entries == NULL) {
+        g_free (key);
+        return NULL;
+    }
+
+    ret = _copy_disc_entries (entries);
+
+    G_LOCK (disc_cache);
+    if (disc_cache == NULL)
+        disc_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+    /* takes over the key */
+    g_hash_table_replace (disc_cache, key, entries);
+    G_UNLOCK (disc_cache);
+
+    return ret;
+}
+
+
+/* initial delay between the connection attempts (in microseconds), doubled with every retry */
+#define CONNECT_RETRY_DELAY      (100 * 1000)
+#define CONNECT_RETRY_MAX_DELAY  (5 * G_USEC_PER_SEC)
+
+typedef struct ConnectData {
+    const gchar *config_file;
+    const gchar *host_traddr;
+    const gchar *host_iface;
+    const gchar *host_nqn;
+    const gchar *host_id;
+    const gchar *hostkey;
+    const gchar *ctrlkey;
+    const gchar *hostsymname;
+    struct nvme_fabrics_config *cfg;
+    guint max_retries;
+} ConnectData;
+
+typedef struct ConnectJob {
+    BDNVMEConnectResult *result;
+    const gchar *transport;
+} ConnectJob;
+
+/* whether another connection attempt may succeed after the @error */
+static gboolean _connect_error_is_transient (GError *error) {
+    return !g_error_matches (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT) &&
+           !g_error_matches (error, BD_NVME_ERROR, BD_NVME_ERROR_CONNECT_ALREADY) &&
+           !g_error_matches (error, BD_NVME_ERROR, BD_NVME_ERROR_CONNECT_INVALID) &&
+           !g_error_matches (error, BD_NVME_ERROR, BD_NVME_ERROR_CONNECT_OPNOTSUPP);
+}
+
+static gboolean _connect_one (ConnectData *data, ConnectJob *job, GError **error) {
+    BDNVMEConnectResult *result = job->result;
+    nvme_root_t root;
+    nvme_host_t host;
+    nvme_ctrl_t ctrl;
+    struct nvme_fabrics_config cfg;
+    int ret;
+
+    /* every connection uses its own (not scanned) tree, libnvme trees are not thread-safe */
+    host = _create_host (&root, data->config_file, data->host_nqn, data->host_id, data->hostkey, data->hostsymname, error);
+    if (host == NULL)
+        return FALSE;
+
+    ctrl = nvme_create_ctrl (root, result->subsysnqn, job->transport, result->transport_addr,
+                             data->host_traddr, data->host_iface, result->transport_svcid);
+    if (ctrl == NULL) {
+        _nvme_fabrics_errno_to_gerror (-1, errno, error);
+        g_prefix_error (error, "Error creating the controller: ");
+        nvme_free_tree (root);
+        return FALSE;
+    }
+    if (data->ctrlkey)
+        nvme_ctrl_set_dhchap_key (ctrl, data->ctrlkey);
+
+    /* nvmf_add_ctrl() may modify the configuration */
+    memcpy (&cfg, data->cfg, sizeof (cfg));
+    ret = nvmf_add_ctrl (host, ctrl, &cfg);
+    if (ret != 0) {
+        _nvme_fabrics_errno_to_gerror (ret, errno, error);
+        g_prefix_error (error, "Error connecting the controller: ");
+        nvme_free_ctrl (ctrl);
+        nvme_free_tree (root);
+        return FALSE;
+    }
+    nvme_free_ctrl (ctrl);
+    nvme_free_tree (root);
+
+    return TRUE;
+}
+
+static void _connect_thread (gpointer job_p, gpointer data_p) {
+    ConnectData *data = (ConnectData *) data_p;
+    ConnectJob *job = (ConnectJob *) job_p;
+    BDNVMEConnectResult *result = job->result;
+    gulong delay = CONNECT_RETRY_DELAY;
+
+    while (TRUE) {
+        result->attempts++;
+        g_clear_error (&(result->error));
+        if (_connect_one (data, job, &(result->error)))
+            return;
+        if (result->attempts > data->max_retries || !_connect_error_is_transient (result->error))
+            return;
+        g_usleep (delay);
+        delay = MIN (delay * 2, CONNECT_RETRY_MAX_DELAY);
+    }
+}
+
+/* whether a live controller for the @entry already exists in the @root tree */
+static gboolean _is_connected (nvme_root_t root, const gchar *host_nqn, const BDNVMEDiscoveryLogEntry *entry) {
+    nvme_host_t host;
+    nvme_subsystem_t subsys;
+    nvme_ctrl_t ctrl;
+    const gchar *name;
+
+    nvme_for_each_host (root, host) {
+        if (g_strcmp0 (nvme_host_get_hostnqn (host), host_nqn) != 0)
+            continue;
+        nvme_for_each_subsystem (host, subsys) {
+            if (g_strcmp0 (nvme_subsystem_get_nqn (subsys), entry->subsysnqn) != 0)
+                continue;
+            nvme_subsystem_for_each_ctrl (subsys, ctrl) {
+                name = nvme_ctrl_get_name (ctrl);
+                if (!name || *name == '\0')
+                    continue;
+                if (g_strcmp0 (nvme_ctrl_get_transport (ctrl), entry->transport) == 0 &&
+                    g_strcmp0 (nvme_ctrl_get_traddr (ctrl), entry->transport_addr) == 0 &&
+                    g_strcmp0 (nvme_ctrl_get_trsvcid (ctrl), entry->transport_svcid) == 0)
+                    return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * bd_nvme_connect_many:
+ * @targets: (array zero-terminated=1): The subsystems to connect to, typically the entries returned by bd_nvme_discover().
+ * @host_traddr: (nullable): The network address used on the host to connect to the Controllers.
+ * @host_iface: (nullable): The network interface used on the host to connect to the Controllers.
+ * @host_nqn: (nullable): Overrides the default Host NQN that identifies the NVMe Host.
+ * @host_id: (nullable): User-defined host UUID or %NULL to use default (as defined in `/etc/nvme/hostid`).
+ * @max_workers: maximum number of controllers to connect in parallel or 0 for the default (number of CPUs)
+ * @max_retries: maximum number of retries of a failed connection attempt
+ * @extra: (nullable) (array zero-terminated=1): Additional arguments, see bd_nvme_connect().
+ * @error: (out) (nullable): Place to store error (if any).
+ *
+ * Connects the NVMe subsystems specified by @targets in parallel, creating a NVMe over Fabrics
+ * controller for each of them. The arguments and @extra have the same meaning as in bd_nvme_connect()
+ * and are used for all the @targets. The NVMe topology is scanned only once and @targets that
+ * already have a live controller (for the same host, transport address and service id) are not
+ * connected again unless the `"duplicate_connect"` @extra argument is set. Entries describing
+ * Discovery Controllers (see #BDNVMEDiscoveryLogEntry.discovery) are skipped.
+ *
+ * Failed connection attempts are retried (up to @max_retries times) with an exponential
+ * backoff unless the error indicates that another attempt cannot succeed (e.g. an invalid
+ * argument). A failure to connect one of the @targets doesn't affect the other targets,
+ * it is reported in the #BDNVMEConnectResult.error field of the particular result.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the connections to @targets
+ *          or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_FABRICS-%BD_NVME_TECH_MODE_INITIATOR
+ */
+BDNVMEConnectResult ** bd_nvme_connect_many (const BDNVMEDiscoveryLogEntry **targets, const gchar *host_traddr, const gchar *host_iface, const gchar *host_nqn, const gchar *host_id, guint max_workers, guint max_retries, const BDExtraArg **extra, GError **error) {
+    const BDNVMEDiscoveryLogEntry **target;
+    gchar *host_nqn_val;
+    gchar *host_id_val;
+    nvme_root_t root;
+    struct nvme_fabrics_config cfg;
+    ConnectData data = ZERO_INIT;
+    ConnectJob *jobs;
+    GPtrArray *results;
+    BDNVMEConnectResult *result;
+    guint n_targets = 0;
+    guint n_jobs = 0;
+
+    if (targets == NULL) {
+        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                             "Invalid value specified for the targets argument");
+        return NULL;
+    }
+    for (target = targets; *target; target++) {
+        if (!(*target)->discovery && ((*target)->subsysnqn == NULL || (*target)->transport == NULL)) {
+            g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                                 "Both the subsystem NQN and the transport need to be specified for all targets");
+            return NULL;
+        }
+        n_targets++;
+    }
+
+    if (!_get_host_ids (host_nqn, host_id, &host_nqn_val, &host_id_val, error))
+        return NULL;
+
+    data.config_file = PATH_NVMF_CONFIG;
+    nvmf_default_config (&cfg);
+    parse_extra_args (extra, &cfg, &data.config_file, &data.hostkey, &data.ctrlkey, &data.hostsymname);
+    data.cfg = &cfg;
+    data.host_traddr = host_traddr;
+    data.host_iface = host_iface;
+    data.host_nqn = host_nqn_val;
+    data.host_id = host_id_val;
+    data.max_retries = max_retries;
+
+    /* a single scan of the topology for all the targets */
+    root = nvme_scan (NULL);
+    if (root == NULL) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                     "Failed to scan topology: %s",
+                     strerror_l (errno, _C_LOCALE));
+        g_free (host_nqn_val);
+        g_free (host_id_val);
+        return NULL;
+    }
+
+    results = g_ptr_array_new ();
+    jobs = g_new0 (ConnectJob, MAX (n_targets, 1));
+    for (target = targets; *target; target++) {
+        if ((*target)->discovery)
+            continue;
+
+        result = g_new0 (BDNVMEConnectResult, 1);
+        result->subsysnqn = g_strdup ((*target)->subsysnqn);
+        result->transport_addr = g_strdup ((*target)->transport_addr);
+        result->transport_svcid = g_strdup ((*target)->transport_svcid);
+        g_ptr_array_add (results, result);
+
+        if (!cfg.duplicate_connect && _is_connected (root, host_nqn_val, *target))
+            continue;
+
+        jobs[n_jobs].result = result;
+        jobs[n_jobs].transport = (*target)->transport;
+        n_jobs++;
+    }
+    nvme_free_tree (root);
+
+    bd_utils_parallel_run_array (_connect_thread, jobs, sizeof (ConnectJob), n_jobs, max_workers, &data);
+
+    g_free (jobs);
+    g_free (host_nqn_val);
+    g_free (host_id_val);
+
+    g_ptr_array_add (results, NULL);  /* trailing NULL element */
+    return (BDNVMEConnectResult **) g_ptr_array_free (results, FALSE);
+}
+
 static gboolean _disconnect (const gchar *subsysnqn, const gchar *path, GError **error, gboolean *found) {
     nvme_root_t root;
     nvme_host_t host;
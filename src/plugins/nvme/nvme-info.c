@@ -18,6 +18,7 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -33,6 +34,7 @@
 #include <check_deps.h>
 #include "nvme.h"
 #include "nvme-private.h"
+#include "../../utils/parallel.h"
 
 
 /**
@@ -417,6 +419,98 @@ void *_nvme_alloc (size_t len)
     return p;
 }
 
+/**
+ * bd_nvme_handle_free: (skip)
+ * @handle: (nullable): %BDNVMEHandle to free
+ *
+ * Drops a reference to @handle, the device is closed when the last reference
+ * is dropped.
+ */
+void bd_nvme_handle_free (BDNVMEHandle *handle) {
+    if (handle == NULL)
+        return;
+
+    if (!g_atomic_int_dec_and_test (&(handle->ref_count)))
+        return;
+
+    if (handle->fd >= 0)
+        g_close (handle->fd, NULL);
+    g_free (handle->ctrl_id);
+    g_mutex_clear (&(handle->lock));
+    g_free (handle->device);
+    g_free (handle);
+}
+
+/**
+ * bd_nvme_handle_copy: (skip)
+ * @handle: (nullable): %BDNVMEHandle to copy
+ *
+ * Adds a reference to @handle (handles are shared, not copied).
+ */
+BDNVMEHandle * bd_nvme_handle_copy (BDNVMEHandle *handle) {
+    if (handle == NULL)
+        return NULL;
+
+    g_atomic_int_inc (&(handle->ref_count));
+    return handle;
+}
+
+/**
+ * bd_nvme_handle_open:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0` or `/dev/nvme0n1`)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Opens @device for repeated queries. The device stays open until the handle
+ * is freed and the Identify Controller data is only retrieved once (on first
+ * use) and cached in the handle, so getting multiple logs and information
+ * from the same device with the `bd_nvme_handle_get_*` functions doesn't
+ * repeat the commands that are otherwise needed by every `bd_nvme_get_*` call.
+ * Note that the cached data (e.g. the unallocated capacity) is not refreshed.
+ *
+ * Returns: (transfer full): a new handle for @device or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEHandle * bd_nvme_handle_open (const gchar *device, GError **error) {
+    BDNVMEHandle *handle;
+    int fd;
+
+    fd = _open_dev (device, error);
+    if (fd < 0)
+        return NULL;
+
+    handle = g_new0 (BDNVMEHandle, 1);
+    handle->device = g_strdup (device);
+    handle->fd = fd;
+    handle->ref_count = 1;
+    g_mutex_init (&(handle->lock));
+
+    return handle;
+}
+
+/* Identify Controller data of the device, retrieved on first use */
+static int _handle_identify_ctrl (BDNVMEHandle *handle, const struct nvme_id_ctrl **ctrl_id) {
+    struct nvme_id_ctrl *buf;
+    int ret = 0;
+
+    g_mutex_lock (&(handle->lock));
+    if (handle->ctrl_id == NULL) {
+        /* send the NVME_IDENTIFY_CNS_CTRL ioctl */
+        buf = _nvme_alloc (sizeof (struct nvme_id_ctrl));
+        g_warn_if_fail (buf != NULL);
+        ret = nvme_identify_ctrl (handle->fd, buf);
+        if (ret == 0) {
+            handle->ctrl_id = g_malloc (sizeof (struct nvme_id_ctrl));
+            memcpy (handle->ctrl_id, buf, sizeof (struct nvme_id_ctrl));
+        }
+        free (buf);
+    }
+    *ctrl_id = handle->ctrl_id;
+    g_mutex_unlock (&(handle->lock));
+
+    return ret;
+}
+
 static gchar *decode_nvme_rev (guint32 ver) {
     guint16 mjr;
     guint8 mnr, ter = 0;
@@ -453,40 +547,28 @@ static gboolean _nvme_a_is_zero (const __u8 a[], int len) {
 }
 
 /**
- * bd_nvme_get_controller_info:
- * @device: a NVMe controller device (e.g. `/dev/nvme0`)
+ * bd_nvme_handle_get_controller_info:
+ * @handle: an opened NVMe device handle (see bd_nvme_handle_open())
  * @error: (out) (nullable): place to store error (if any)
  *
- * Retrieves information about the NVMe controller (the Identify Controller command)
- * as specified by the @device block device path.
+ * The same as bd_nvme_get_controller_info() but uses the already opened @handle.
  *
  * Returns: (transfer full): information about given controller or %NULL in case of an error (with @error set).
  *
  * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
  */
-BDNVMEControllerInfo * bd_nvme_get_controller_info (const gchar *device, GError **error) {
+BDNVMEControllerInfo * bd_nvme_handle_get_controller_info (BDNVMEHandle *handle, GError **error) {
     int ret;
-    int fd;
-    struct nvme_id_ctrl *ctrl_id;
+    const struct nvme_id_ctrl *ctrl_id;
     BDNVMEControllerInfo *info;
 
-    /* open the block device */
-    fd = _open_dev (device, error);
-    if (fd < 0)
-        return NULL;
-
-    ctrl_id = _nvme_alloc (sizeof (struct nvme_id_ctrl));
-    g_warn_if_fail (ctrl_id != NULL);
     /* send the NVME_IDENTIFY_CNS_CTRL ioctl */
-    ret = nvme_identify_ctrl (fd, ctrl_id);
+    ret = _handle_identify_ctrl (handle, &ctrl_id);
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "NVMe Identify Controller command error: ");
-        close (fd);
-        free (ctrl_id);
         return NULL;
     }
-    close (fd);
 
     info = g_new0 (BDNVMEControllerInfo, 1);
     if ((ctrl_id->cmic & NVME_CTRL_CMIC_MULTI_PORT) == NVME_CTRL_CMIC_MULTI_PORT)
@@ -567,31 +649,55 @@ BDNVMEControllerInfo * bd_nvme_get_controller_info (const gchar *device, GError
     info->subsysnqn = g_strndup (ctrl_id->subnqn, sizeof (ctrl_id->subnqn));
     g_strstrip (info->subsysnqn);
 
-    free (ctrl_id);
     return info;
 }
 
-
 /**
- * bd_nvme_get_namespace_info:
- * @device: a NVMe namespace device (e.g. `/dev/nvme0n1`)
+ * bd_nvme_get_controller_info:
+ * @device: a NVMe controller device (e.g. `/dev/nvme0`)
  * @error: (out) (nullable): place to store error (if any)
  *
- * Retrieves information about the NVMe namespace (the Identify Namespace command)
+ * Retrieves information about the NVMe controller (the Identify Controller command)
  * as specified by the @device block device path.
  *
+ * Returns: (transfer full): information about given controller or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEControllerInfo * bd_nvme_get_controller_info (const gchar *device, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMEControllerInfo *ret;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return NULL;
+
+    ret = bd_nvme_handle_get_controller_info (handle, error);
+    bd_nvme_handle_free (handle);
+
+    return ret;
+}
+
+
+/**
+ * bd_nvme_handle_get_namespace_info:
+ * @handle: an opened NVMe device handle (see bd_nvme_handle_open())
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * The same as bd_nvme_get_namespace_info() but uses the already opened @handle.
+ *
  * Returns: (transfer full): information about given namespace or %NULL in case of an error (with @error set).
  *
  * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
  */
-BDNVMENamespaceInfo *bd_nvme_get_namespace_info (const gchar *device, GError **error) {
+BDNVMENamespaceInfo *bd_nvme_handle_get_namespace_info (BDNVMEHandle *handle, GError **error) {
     int ret;
     int ret_ctrl;
     int ret_desc = -1;
     int ret_ns_ind = -1;
     int fd;
     __u32 nsid = 0;
-    struct nvme_id_ctrl *ctrl_id;
+    const struct nvme_id_ctrl *ctrl_id;
     struct nvme_id_ns *ns_info;
     struct nvme_id_independent_id_ns *ns_info_ind = NULL;
     struct nvme_ns_id_desc *descs = NULL;
@@ -601,17 +707,13 @@ BDNVMENamespaceInfo *bd_nvme_get_namespace_info (const gchar *device, GError **e
     BDNVMENamespaceInfo *info;
     GPtrArray *ptr_array;
 
-    /* open the block device */
-    fd = _open_dev (device, error);
-    if (fd < 0)
-        return NULL;
+    fd = handle->fd;
 
     /* get Namespace Identifier (NSID) for the @device (NVME_IOCTL_ID) */
     ret = nvme_get_nsid (fd, &nsid);
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "Error getting Namespace Identifier (NSID): ");
-        close (fd);
         return NULL;
     }
 
@@ -622,15 +724,12 @@ BDNVMENamespaceInfo *bd_nvme_get_namespace_info (const gchar *device, GError **e
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "NVMe Identify Namespace command error: ");
-        close (fd);
         free (ns_info);
         return NULL;
     }
 
     /* send the NVME_IDENTIFY_CNS_CTRL ioctl */
-    ctrl_id = _nvme_alloc (sizeof (struct nvme_id_ctrl));
-    g_warn_if_fail (ctrl_id != NULL);
-    ret_ctrl = nvme_identify_ctrl (fd, ctrl_id);
+    ret_ctrl = _handle_identify_ctrl (handle, &ctrl_id);
 
     /* send the NVME_IDENTIFY_CNS_NS_DESC_LIST ioctl, NVMe 1.3 */
     if (ret_ctrl == 0 && GUINT32_FROM_LE (ctrl_id->ver) >= 0x10300) {
@@ -645,7 +744,6 @@ BDNVMENamespaceInfo *bd_nvme_get_namespace_info (const gchar *device, GError **e
         g_warn_if_fail (ns_info_ind != NULL);
         ret_ns_ind = nvme_identify_independent_identify_ns (fd, nsid, ns_info_ind);
     }
-    close (fd);
 
     info = g_new0 (BDNVMENamespaceInfo, 1);
     info->nsid = nsid;
@@ -724,49 +822,66 @@ BDNVMENamespaceInfo *bd_nvme_get_namespace_info (const gchar *device, GError **e
     g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
     info->lba_formats = (BDNVMELBAFormat **) g_ptr_array_free (ptr_array, FALSE);
 
-    free (ctrl_id);
     free (ns_info);
     free (ns_info_ind);
     free (descs);
     return info;
 }
 
+/**
+ * bd_nvme_get_namespace_info:
+ * @device: a NVMe namespace device (e.g. `/dev/nvme0n1`)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves information about the NVMe namespace (the Identify Namespace command)
+ * as specified by the @device block device path.
+ *
+ * Returns: (transfer full): information about given namespace or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMENamespaceInfo *bd_nvme_get_namespace_info (const gchar *device, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMENamespaceInfo *ret;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return NULL;
+
+    ret = bd_nvme_handle_get_namespace_info (handle, error);
+    bd_nvme_handle_free (handle);
+
+    return ret;
+}
+
 
 /**
- * bd_nvme_get_smart_log:
- * @device: a NVMe controller device (e.g. `/dev/nvme0`)
+ * bd_nvme_handle_get_smart_log:
+ * @handle: an opened NVMe device handle (see bd_nvme_handle_open())
  * @error: (out) (nullable): place to store error (if any)
  *
- * Retrieves drive SMART and general health information (Log Identifier `02h`).
- * The information provided is over the life of the controller and is retained across power cycles.
+ * The same as bd_nvme_get_smart_log() but uses the already opened @handle.
  *
  * Returns: (transfer full): health log data or %NULL in case of an error (with @error set).
  *
  * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
  */
-BDNVMESmartLog * bd_nvme_get_smart_log (const gchar *device, GError **error) {
+BDNVMESmartLog * bd_nvme_handle_get_smart_log (BDNVMEHandle *handle, GError **error) {
     int ret;
     int ret_identify;
     int fd;
-    struct nvme_id_ctrl *ctrl_id;
+    const struct nvme_id_ctrl *ctrl_id;
     struct nvme_smart_log *smart_log;
     BDNVMESmartLog *log;
     guint i;
 
-    /* open the block device */
-    fd = _open_dev (device, error);
-    if (fd < 0)
-        return NULL;
+    fd = handle->fd;
 
     /* send the NVME_IDENTIFY_CNS_CTRL ioctl */
-    ctrl_id = _nvme_alloc (sizeof (struct nvme_id_ctrl));
-    g_warn_if_fail (ctrl_id != NULL);
-    ret_identify = nvme_identify_ctrl (fd, ctrl_id);
+    ret_identify = _handle_identify_ctrl (handle, &ctrl_id);
     if (ret_identify != 0) {
         _nvme_status_to_error (ret_identify, FALSE, error);
         g_prefix_error (error, "NVMe Identify Controller command error: ");
-        close (fd);
-        free (ctrl_id);
         return NULL;
     }
 
@@ -777,12 +892,9 @@ BDNVMESmartLog * bd_nvme_get_smart_log (const gchar *device, GError **error) {
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "NVMe Get Log Page - SMART / Health Information Log command error: ");
-        close (fd);
-        free (ctrl_id);
         free (smart_log);
         return NULL;
     }
-    close (fd);
 
     log = g_new0 (BDNVMESmartLog, 1);
     if ((smart_log->critical_warning & NVME_SMART_CRIT_SPARE) == NVME_SMART_CRIT_SPARE)
@@ -825,58 +937,60 @@ BDNVMESmartLog * bd_nvme_get_smart_log (const gchar *device, GError **error) {
      *        Power State attributes. Subject to re-evaluation in the future.
      */
 
-    free (ctrl_id);
     free (smart_log);
     return log;
 }
 
-
 /**
- * bd_nvme_get_error_log_entries:
+ * bd_nvme_get_smart_log:
  * @device: a NVMe controller device (e.g. `/dev/nvme0`)
  * @error: (out) (nullable): place to store error (if any)
  *
- * Retrieves Error Information Log (Log Identifier `01h`) entries, used to describe
- * extended error information for a command that completed with error or to report
- * an error that is not specific to a particular command. This log is global to the
- * controller. The ordering of the entries is based on the time when the error
- * occurred, with the most recent error being returned as the first log entry.
- * As the number of entries is typically limited by the drive implementation, only
- * most recent entries are provided.
+ * Retrieves drive SMART and general health information (Log Identifier `02h`).
+ * The information provided is over the life of the controller and is retained across power cycles.
  *
- * Returns: (transfer full) (array zero-terminated=1): null-terminated list
- *          of error entries or %NULL in case of an error (with @error set).
+ * Returns: (transfer full): health log data or %NULL in case of an error (with @error set).
  *
  * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
  */
-BDNVMEErrorLogEntry ** bd_nvme_get_error_log_entries (const gchar *device, GError **error) {
+BDNVMESmartLog * bd_nvme_get_smart_log (const gchar *device, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMESmartLog *ret;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return NULL;
+
+    ret = bd_nvme_handle_get_smart_log (handle, error);
+    bd_nvme_handle_free (handle);
+
+    return ret;
+}
+
+
+/* Reads the whole Error Information Log with a single command and calls @func
+   for every valid entry, parsing it only right before the call. */
+static gboolean handle_foreach_error_log_entry (BDNVMEHandle *handle, BDNVMEErrorLogEntryFunc func, gpointer user_data, GError **error) {
     int ret;
     int fd;
     guint elpe;
-    struct nvme_id_ctrl *ctrl_id;
+    const struct nvme_id_ctrl *ctrl_id;
     struct nvme_error_log_page *err_log;
-    GPtrArray *ptr_array;
+    BDNVMEErrorLogEntry entry;
+    gboolean cont = TRUE;
     guint i;
 
-    /* open the block device */
-    fd = _open_dev (device, error);
-    if (fd < 0)
-        return NULL;
+    fd = handle->fd;
 
     /* find out the maximum number of error log entries as reported by the controller */
-    ctrl_id = _nvme_alloc (sizeof (struct nvme_id_ctrl));
-    g_warn_if_fail (ctrl_id != NULL);
-    ret = nvme_identify_ctrl (fd, ctrl_id);
+    ret = _handle_identify_ctrl (handle, &ctrl_id);
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "NVMe Identify Controller command error: ");
-        close (fd);
-        free (ctrl_id);
-        return NULL;
+        return FALSE;
     }
 
     elpe = ctrl_id->elpe + 1;
-    free (ctrl_id);
 
     /* send the NVME_LOG_LID_ERROR ioctl */
     err_log = _nvme_alloc (sizeof (struct nvme_error_log_page) * elpe);
@@ -885,53 +999,139 @@ BDNVMEErrorLogEntry ** bd_nvme_get_error_log_entries (const gchar *device, GErro
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "NVMe Get Log Page - Error Information Log Entry command error: ");
-        close (fd);
         free (err_log);
-        return NULL;
+        return FALSE;
     }
-    close (fd);
 
     /* parse the log */
-    ptr_array = g_ptr_array_new ();
-    for (i = 0; i < elpe; i++) {
+    for (i = 0; cont && i < elpe; i++) {
         if (GUINT64_FROM_LE (err_log[i].error_count) > 0) {
-            BDNVMEErrorLogEntry *entry;
-
-            entry = g_new0 (BDNVMEErrorLogEntry, 1);
-            entry->error_count = GUINT64_FROM_LE (err_log[i].error_count);
-            entry->command_id = err_log[i].cmdid;
-            entry->command_specific = GUINT64_FROM_LE (err_log[i].cs);
-            entry->command_status = GUINT16_FROM_LE (err_log[i].status_field) >> 1;
-            _nvme_status_to_error (GUINT16_FROM_LE (err_log[i].status_field) >> 1, FALSE, &entry->command_error);
-            entry->lba = GUINT64_FROM_LE (err_log[i].lba);
-            entry->nsid = err_log[i].nsid;
-            entry->transport_type = err_log[i].trtype;
+            memset (&entry, 0, sizeof (entry));
+            entry.error_count = GUINT64_FROM_LE (err_log[i].error_count);
+            entry.command_id = err_log[i].cmdid;
+            entry.command_specific = GUINT64_FROM_LE (err_log[i].cs);
+            entry.command_status = GUINT16_FROM_LE (err_log[i].status_field) >> 1;
+            _nvme_status_to_error (GUINT16_FROM_LE (err_log[i].status_field) >> 1, FALSE, &entry.command_error);
+            entry.lba = GUINT64_FROM_LE (err_log[i].lba);
+            entry.nsid = err_log[i].nsid;
+            entry.transport_type = err_log[i].trtype;
             /* not providing Transport Type Specific Information here on purpose */
 
-            g_ptr_array_add (ptr_array, entry);
+            cont = func (&entry, user_data);
+            g_clear_error (&entry.command_error);
         }
     }
-    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
     free (err_log);
 
+    return TRUE;
+}
+
+static gboolean collect_error_log_entry (BDNVMEErrorLogEntry *entry, gpointer user_data) {
+    g_ptr_array_add ((GPtrArray *) user_data, bd_nvme_error_log_entry_copy (entry));
+    return TRUE;
+}
+
+/**
+ * bd_nvme_handle_get_error_log_entries:
+ * @handle: an opened NVMe device handle (see bd_nvme_handle_open())
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * The same as bd_nvme_get_error_log_entries() but uses the already opened @handle.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): null-terminated list
+ *          of error entries or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEErrorLogEntry ** bd_nvme_handle_get_error_log_entries (BDNVMEHandle *handle, GError **error) {
+    GPtrArray *ptr_array;
+
+    ptr_array = g_ptr_array_new ();
+    if (!handle_foreach_error_log_entry (handle, collect_error_log_entry, ptr_array, error)) {
+        g_ptr_array_free (ptr_array, TRUE);
+        return NULL;
+    }
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+
     return (BDNVMEErrorLogEntry **) g_ptr_array_free (ptr_array, FALSE);
 }
+/**
+ * bd_nvme_get_error_log_entries:
+ * @device: a NVMe controller device (e.g. `/dev/nvme0`)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves Error Information Log (Log Identifier `01h`) entries, used to describe
+ * extended error information for a command that completed with error or to report
+ * an error that is not specific to a particular command. This log is global to the
+ * controller. The ordering of the entries is based on the time when the error
+ * occurred, with the most recent error being returned as the first log entry.
+ * As the number of entries is typically limited by the drive implementation, only
+ * most recent entries are provided.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): null-terminated list
+ *          of error entries or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEErrorLogEntry ** bd_nvme_get_error_log_entries (const gchar *device, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMEErrorLogEntry **ret;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return NULL;
 
+    ret = bd_nvme_handle_get_error_log_entries (handle, error);
+    bd_nvme_handle_free (handle);
+
+    return ret;
+}
 
 /**
- * bd_nvme_get_self_test_log:
+ * bd_nvme_get_error_log_entries_foreach:
  * @device: a NVMe controller device (e.g. `/dev/nvme0`)
+ * @func: (scope call): function to call for every error log entry
+ * @user_data: (closure): data to pass to @func
  * @error: (out) (nullable): place to store error (if any)
  *
- * Retrieves drive self-test log (Log Identifier `06h`). Provides the status of a self-test operation
- * in progress and the percentage complete of that operation, along with the results of the last
- * 20 device self-test operations.
+ * Calls @func for every Error Information Log entry (see
+ * bd_nvme_get_error_log_entries()) without creating the list of all the
+ * entries. The entry is only valid during the call of @func, use
+ * bd_nvme_error_log_entry_copy() to keep it. If @func returns %FALSE, no more
+ * entries are reported.
+ *
+ * Returns: whether the log was successfully retrieved or not (stopping the
+ *          listing from @func is not an error)
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+gboolean bd_nvme_get_error_log_entries_foreach (const gchar *device, BDNVMEErrorLogEntryFunc func, gpointer user_data, GError **error) {
+    BDNVMEHandle *handle;
+    gboolean ret;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return FALSE;
+
+    ret = handle_foreach_error_log_entry (handle, func, user_data, error);
+    bd_nvme_handle_free (handle);
+
+    return ret;
+}
+
+
+/**
+ * bd_nvme_handle_get_self_test_log:
+ * @handle: an opened NVMe device handle (see bd_nvme_handle_open())
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * The same as bd_nvme_get_self_test_log() but uses the already opened @handle.
  *
  * Returns: (transfer full): self-test log data or %NULL in case of an error (with @error set).
  *
  * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
  */
-BDNVMESelfTestLog * bd_nvme_get_self_test_log (const gchar *device, GError **error) {
+BDNVMESelfTestLog * bd_nvme_handle_get_self_test_log (BDNVMEHandle *handle, GError **error) {
     int ret;
     int fd;
     struct nvme_self_test_log *self_test_log;
@@ -939,10 +1139,7 @@ BDNVMESelfTestLog * bd_nvme_get_self_test_log (const gchar *device, GError **err
     GPtrArray *ptr_array;
     guint i;
 
-    /* open the block device */
-    fd = _open_dev (device, error);
-    if (fd < 0)
-        return NULL;
+    fd = handle->fd;
 
     /* send the NVME_LOG_LID_DEVICE_SELF_TEST ioctl */
     self_test_log = _nvme_alloc (sizeof (struct nvme_self_test_log));
@@ -951,11 +1148,9 @@ BDNVMESelfTestLog * bd_nvme_get_self_test_log (const gchar *device, GError **err
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "NVMe Get Log Page - Device Self-test Log command error: ");
-        close (fd);
         free (self_test_log);
         return NULL;
     }
-    close (fd);
 
     log = g_new0 (BDNVMESelfTestLog, 1);
     switch (self_test_log->current_operation & NVME_ST_CURR_OP_MASK) {
@@ -1059,34 +1254,53 @@ BDNVMESelfTestLog * bd_nvme_get_self_test_log (const gchar *device, GError **err
     return log;
 }
 
-
 /**
- * bd_nvme_get_sanitize_log:
+ * bd_nvme_get_self_test_log:
  * @device: a NVMe controller device (e.g. `/dev/nvme0`)
  * @error: (out) (nullable): place to store error (if any)
  *
- * Retrieves the drive sanitize status log (Log Identifier `81h`) that includes information
- * about the most recent sanitize operation and the sanitize operation time estimates.
+ * Retrieves drive self-test log (Log Identifier `06h`). Provides the status of a self-test operation
+ * in progress and the percentage complete of that operation, along with the results of the last
+ * 20 device self-test operations.
  *
- * As advised in the NVMe specification whitepaper the host should limit polling
- * to retrieve progress of a running sanitize operations (e.g. to at most once every
- * several minutes) to avoid interfering with the progress of the sanitize operation itself.
+ * Returns: (transfer full): self-test log data or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMESelfTestLog * bd_nvme_get_self_test_log (const gchar *device, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMESelfTestLog *ret;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return NULL;
+
+    ret = bd_nvme_handle_get_self_test_log (handle, error);
+    bd_nvme_handle_free (handle);
+
+    return ret;
+}
+
+
+/**
+ * bd_nvme_handle_get_sanitize_log:
+ * @handle: an opened NVMe device handle (see bd_nvme_handle_open())
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * The same as bd_nvme_get_sanitize_log() but uses the already opened @handle.
  *
  * Returns: (transfer full): sanitize log data or %NULL in case of an error (with @error set).
  *
  * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
  */
-BDNVMESanitizeLog * bd_nvme_get_sanitize_log (const gchar *device, GError **error) {
+BDNVMESanitizeLog * bd_nvme_handle_get_sanitize_log (BDNVMEHandle *handle, GError **error) {
     int ret;
     int fd;
     struct nvme_sanitize_log_page *sanitize_log;
     BDNVMESanitizeLog *log;
     __u16 sstat;
 
-    /* open the block device */
-    fd = _open_dev (device, error);
-    if (fd < 0)
-        return NULL;
+    fd = handle->fd;
 
     /* send the NVME_LOG_LID_SANITIZE ioctl */
     sanitize_log = _nvme_alloc (sizeof (struct nvme_sanitize_log_page));
@@ -1095,11 +1309,9 @@ BDNVMESanitizeLog * bd_nvme_get_sanitize_log (const gchar *device, GError **erro
     if (ret != 0) {
         _nvme_status_to_error (ret, FALSE, error);
         g_prefix_error (error, "NVMe Get Log Page - Sanitize Status Log command error: ");
-        close (fd);
         free (sanitize_log);
         return NULL;
     }
-    close (fd);
 
     log = g_new0 (BDNVMESanitizeLog, 1);
     log->sanitize_progress = 0;
@@ -1138,3 +1350,157 @@ BDNVMESanitizeLog * bd_nvme_get_sanitize_log (const gchar *device, GError **erro
     free (sanitize_log);
     return log;
 }
+
+/**
+ * bd_nvme_get_sanitize_log:
+ * @device: a NVMe controller device (e.g. `/dev/nvme0`)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Retrieves the drive sanitize status log (Log Identifier `81h`) that includes information
+ * about the most recent sanitize operation and the sanitize operation time estimates.
+ *
+ * As advised in the NVMe specification whitepaper the host should limit polling
+ * to retrieve progress of a running sanitize operations (e.g. to at most once every
+ * several minutes) to avoid interfering with the progress of the sanitize operation itself.
+ *
+ * Returns: (transfer full): sanitize log data or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMESanitizeLog * bd_nvme_get_sanitize_log (const gchar *device, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMESanitizeLog *ret;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return NULL;
+
+    ret = bd_nvme_handle_get_sanitize_log (handle, error);
+    bd_nvme_handle_free (handle);
+
+    return ret;
+}
+
+
+/**
+ * bd_nvme_health_info_free: (skip)
+ * @info: (nullable): %BDNVMEHealthInfo to free
+ *
+ * Frees @info.
+ */
+void bd_nvme_health_info_free (BDNVMEHealthInfo *info) {
+    BDNVMEErrorLogEntry **entry;
+
+    if (info == NULL)
+        return;
+
+    g_free (info->device);
+    bd_nvme_smart_log_free (info->smart_log);
+    if (info->error_log_entries) {
+        for (entry = info->error_log_entries; *entry; entry++)
+            bd_nvme_error_log_entry_free (*entry);
+        g_free (info->error_log_entries);
+    }
+    g_clear_error (&(info->error));
+    g_free (info);
+}
+
+/**
+ * bd_nvme_health_info_copy: (skip)
+ * @info: (nullable): %BDNVMEHealthInfo to copy
+ *
+ * Creates a new copy of @info.
+ */
+BDNVMEHealthInfo * bd_nvme_health_info_copy (BDNVMEHealthInfo *info) {
+    BDNVMEHealthInfo *new_info;
+    BDNVMEErrorLogEntry **entry;
+    GPtrArray *ptr_array;
+
+    if (info == NULL)
+        return NULL;
+
+    new_info = g_new0 (BDNVMEHealthInfo, 1);
+    new_info->device = g_strdup (info->device);
+    new_info->smart_log = bd_nvme_smart_log_copy (info->smart_log);
+    if (info->error_log_entries) {
+        ptr_array = g_ptr_array_new ();
+        for (entry = info->error_log_entries; *entry; entry++)
+            g_ptr_array_add (ptr_array, bd_nvme_error_log_entry_copy (*entry));
+        g_ptr_array_add (ptr_array, NULL);
+        new_info->error_log_entries = (BDNVMEErrorLogEntry **) g_ptr_array_free (ptr_array, FALSE);
+    }
+    new_info->error = info->error ? g_error_copy (info->error) : NULL;
+
+    return new_info;
+}
+
+static void _collect_health_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    BDNVMEHealthInfo *info = (BDNVMEHealthInfo *) data;
+    BDNVMEHandle *handle;
+
+    handle = bd_nvme_handle_open (info->device, &(info->error));
+    if (!handle)
+        return;
+
+    /* the Identify Controller data is retrieved only once for both the logs */
+    info->smart_log = bd_nvme_handle_get_smart_log (handle, &(info->error));
+    if (info->smart_log)
+        info->error_log_entries = bd_nvme_handle_get_error_log_entries (handle, &(info->error));
+    bd_nvme_handle_free (handle);
+}
+
+/**
+ * bd_nvme_get_health_all:
+ * @max_workers: maximum number of controllers to query in parallel or 0 for
+ *               the default (number of CPUs)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Enumerates all NVMe controllers present in the system (using a single scan
+ * of the NVMe topology) and retrieves their SMART health logs and Error
+ * Information Log entries (see bd_nvme_get_smart_log() and
+ * bd_nvme_get_error_log_entries()). The controllers are queried in parallel
+ * so the total time is given by the slowest controller, not by the sum of all
+ * of them. A failure to query one of the controllers doesn't affect the other
+ * controllers, it is reported in the #BDNVMEHealthInfo.error field of the
+ * particular entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): health information for all
+ *          the NVMe controllers (may be empty) or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMEHealthInfo ** bd_nvme_get_health_all (guint max_workers, GError **error) {
+    nvme_root_t root;
+    nvme_host_t host;
+    nvme_subsystem_t subsys;
+    nvme_ctrl_t ctrl;
+    const gchar *name;
+    GPtrArray *ptr_array;
+    BDNVMEHealthInfo *info;
+
+    root = nvme_scan (NULL);
+    if (root == NULL) {
+        g_set_error (error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                     "Failed to scan topology: %s",
+                     strerror_l (errno, _C_LOCALE));
+        return NULL;
+    }
+
+    ptr_array = g_ptr_array_new ();
+    nvme_for_each_host (root, host)
+        nvme_for_each_subsystem (host, subsys)
+            nvme_subsystem_for_each_ctrl (subsys, ctrl) {
+                name = nvme_ctrl_get_name (ctrl);
+                if (!name || *name == '\0')
+                    continue;
+                info = g_new0 (BDNVMEHealthInfo, 1);
+                info->device = g_strdup_printf ("/dev/%s", name);
+                g_ptr_array_add (ptr_array, info);
+            }
+    nvme_free_tree (root);
+
+    bd_utils_parallel_run (_collect_health_thread, ptr_array->pdata, ptr_array->len, max_workers, NULL);
+
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+    return (BDNVMEHealthInfo **) g_ptr_array_free (ptr_array, FALSE);
+}
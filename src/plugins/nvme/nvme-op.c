@@ -34,6 +34,7 @@
 #include <check_deps.h>
 #include "nvme.h"
 #include "nvme-private.h"
+#include "../../utils/parallel.h"
 
 
 /**
@@ -49,6 +50,7 @@
  * To abort a running operation, pass #BD_NVME_SELF_TEST_ACTION_ABORT as @action.
  * To retrieve progress of a current running operation, check the self-test log using
  * bd_nvme_get_self_test_log().
+ * Use bd_nvme_device_self_test_wait() to wait for the operation to finish.
  *
  * Returns: %TRUE if the device self-test command was issued successfully,
  *          %FALSE otherwise with @error set.
@@ -112,6 +114,115 @@ gboolean bd_nvme_device_self_test (const gchar *device, BDNVMESelfTestAction act
     return TRUE;
 }
 
+/* polling intervals (in microseconds) used when waiting for background operations */
+#define POLL_INTERVAL_MIN (1 * G_USEC_PER_SEC)
+#define SELF_TEST_POLL_INTERVAL_MAX (10 * G_USEC_PER_SEC)
+#define SANITIZE_POLL_INTERVAL_MAX (120 * G_USEC_PER_SEC)
+
+/* Poll more often when the operation makes progress and back off exponentially
+ * when it doesn't so that slow operations don't cause too many commands. */
+static gint64 next_poll_interval (gint64 interval, gboolean progressed, gint64 max_interval) {
+    if (progressed)
+        return MAX (interval / 2, POLL_INTERVAL_MIN);
+    else
+        return MIN (interval * 2, max_interval);
+}
+
+/* sleeps for @interval or less if @deadline comes sooner, returns %FALSE if @deadline has passed */
+static gboolean poll_sleep (gint64 interval, gint64 deadline) {
+    gint64 now = g_get_monotonic_time ();
+
+    if (deadline > 0) {
+        if (now >= deadline)
+            return FALSE;
+        interval = MIN (interval, deadline - now);
+    }
+    g_usleep (interval);
+
+    return TRUE;
+}
+
+/**
+ * bd_nvme_device_self_test_wait:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @timeout: maximum number of seconds to wait for or 0 to wait until the operation finishes
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Waits for the Device Self-test operation started by bd_nvme_device_self_test()
+ * to finish. The device is opened only once and the self-test log is checked
+ * at an adaptive interval -- more often when the operation makes progress and
+ * less often when it doesn't. The progress of the operation is reported using
+ * the libblockdev progress reporting.
+ *
+ * Returns: %TRUE if the self-test operation finished successfully (or no operation
+ *          was running), %FALSE if it failed, was aborted or @timeout expired (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_device_self_test_wait (const gchar *device, guint timeout, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMESelfTestLog *log;
+    BDNVMESelfTestResult result;
+    gint64 deadline = 0;
+    gint64 interval = POLL_INTERVAL_MIN;
+    gint completion = -1;
+    guint64 progress_id;
+    gchar *msg;
+    gboolean ret = FALSE;
+    GError *l_error = NULL;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return FALSE;
+
+    if (timeout > 0)
+        deadline = g_get_monotonic_time () + (gint64) timeout * G_USEC_PER_SEC;
+
+    msg = g_strdup_printf ("Waiting for the device self-test operation on %s to finish", device);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    while (TRUE) {
+        log = bd_nvme_handle_get_self_test_log (handle, &l_error);
+        if (!log)
+            break;
+
+        if (log->current_operation == BD_NVME_SELF_TEST_ACTION_NOT_RUNNING) {
+            /* the most recent result is the first entry */
+            result = (log->entries && log->entries[0]) ? log->entries[0]->result : BD_NVME_SELF_TEST_RESULT_NO_ERROR;
+            if (result == BD_NVME_SELF_TEST_RESULT_NO_ERROR)
+                ret = TRUE;
+            else
+                g_set_error (&l_error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                             "Device self-test operation failed: %s",
+                             bd_nvme_self_test_result_to_string (result, NULL));
+            bd_nvme_self_test_log_free (log);
+            break;
+        }
+
+        interval = next_poll_interval (interval, log->current_operation_completion != completion,
+                                       SELF_TEST_POLL_INTERVAL_MAX);
+        if (log->current_operation_completion != completion) {
+            completion = log->current_operation_completion;
+            bd_utils_report_progress (progress_id, completion, NULL);
+        }
+        bd_nvme_self_test_log_free (log);
+
+        if (!poll_sleep (interval, deadline)) {
+            g_set_error (&l_error, BD_NVME_ERROR, BD_NVME_ERROR_BUSY,
+                         "Timed out waiting for the device self-test operation to finish");
+            break;
+        }
+    }
+
+    bd_utils_report_finished (progress_id, ret ? "Completed" : l_error->message);
+    bd_nvme_handle_free (handle);
+    if (l_error)
+        g_propagate_error (error, l_error);
+
+    return ret;
+}
+
 
 /* returns 0xff in case of error (the NVMe standard defines total of 16 flba records) */
 static __u8 find_lbaf_for_size (int fd, __u32 nsid, guint16 lba_data_size, guint16 metadata_size, GError **error) {
@@ -305,6 +416,198 @@ gboolean bd_nvme_format (const gchar *device, guint16 lba_data_size, guint16 met
     return TRUE;
 }
 
+/* lower is better, formats not reporting the relative performance are considered the worst */
+static guint lba_format_perf_rank (const BDNVMELBAFormat *fmt) {
+    if (fmt->relative_performance == BD_NVME_LBA_FORMAT_RELATIVE_PERFORMANCE_UNKNOWN)
+        return BD_NVME_LBA_FORMAT_RELATIVE_PERFORMANCE_DEGRADED + 1;
+    return fmt->relative_performance;
+}
+
+/* whether @a performs better than @b */
+static gboolean lba_format_is_better (const BDNVMELBAFormat *a, const BDNVMELBAFormat *b) {
+    if (lba_format_perf_rank (a) != lba_format_perf_rank (b))
+        return lba_format_perf_rank (a) < lba_format_perf_rank (b);
+    /* bigger sectors mean less per-command overhead */
+    if (a->data_size != b->data_size)
+        return a->data_size > b->data_size;
+    return a->metadata_size < b->metadata_size;
+}
+
+static BDNVMELBAFormat * select_lba_format (BDNVMENamespaceInfo *info, guint16 lba_data_size, guint16 max_metadata_size, GError **error) {
+    BDNVMELBAFormat **fmt;
+    BDNVMELBAFormat *best = NULL;
+
+    for (fmt = info->lba_formats; fmt && *fmt; fmt++) {
+        if (lba_data_size != 0 && (*fmt)->data_size != lba_data_size)
+            continue;
+        if ((*fmt)->metadata_size > max_metadata_size)
+            continue;
+        if (!best || lba_format_is_better (*fmt, best))
+            best = *fmt;
+    }
+
+    if (!best) {
+        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                             "No supported LBA format matches the requested LBA data size and metadata size");
+        return NULL;
+    }
+    return bd_nvme_lba_format_copy (best);
+}
+
+/**
+ * bd_nvme_select_lba_format:
+ * @device: NVMe namespace device (e.g. `/dev/nvme0n1`)
+ * @lba_data_size: required LBA data size (i.e. a sector size) in bytes or `0` for any size
+ * @max_metadata_size: maximum metadata size in bytes, `0` to only allow formats without metadata
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Selects the best performing LBA format supported by the @device namespace that
+ * matches the @lba_data_size and @max_metadata_size constraints. The formats are
+ * compared by their Relative Performance (see #BDNVMELBAFormatRelativePerformance,
+ * formats not reporting it are considered the worst), then by the LBA data size
+ * (bigger is preferred) and then by the metadata size (smaller is preferred).
+ *
+ * The result can be passed to bd_nvme_format() to reformat the namespace.
+ *
+ * Returns: (transfer full): the selected LBA format or %NULL in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_INFO
+ */
+BDNVMELBAFormat * bd_nvme_select_lba_format (const gchar *device, guint16 lba_data_size, guint16 max_metadata_size, GError **error) {
+    BDNVMENamespaceInfo *info;
+    BDNVMELBAFormat *ret;
+
+    info = bd_nvme_get_namespace_info (device, error);
+    if (!info)
+        return NULL;
+
+    ret = select_lba_format (info, lba_data_size, max_metadata_size, error);
+    bd_nvme_namespace_info_free (info);
+    return ret;
+}
+
+/**
+ * bd_nvme_format_result_free: (skip)
+ * @result: (nullable): %BDNVMEFormatResult to free
+ *
+ * Frees @result.
+ */
+void bd_nvme_format_result_free (BDNVMEFormatResult *result) {
+    if (result == NULL)
+        return;
+
+    g_free (result->device);
+    bd_nvme_lba_format_free (result->lba_format);
+    g_clear_error (&(result->error));
+    g_free (result);
+}
+
+/**
+ * bd_nvme_format_result_copy: (skip)
+ * @result: (nullable): %BDNVMEFormatResult to copy
+ *
+ * Creates a new copy of @result.
+ */
+BDNVMEFormatResult * bd_nvme_format_result_copy (BDNVMEFormatResult *result) {
+    BDNVMEFormatResult *new_result;
+
+    if (result == NULL)
+        return NULL;
+
+    new_result = g_new0 (BDNVMEFormatResult, 1);
+    new_result->device = g_strdup (result->device);
+    new_result->lba_format = bd_nvme_lba_format_copy (result->lba_format);
+    new_result->formatted = result->formatted;
+    new_result->error = result->error ? g_error_copy (result->error) : NULL;
+
+    return new_result;
+}
+
+typedef struct FormatData {
+    guint16 lba_data_size;
+    guint16 max_metadata_size;
+    BDNVMEFormatSecureErase secure_erase;
+} FormatData;
+
+static void format_for_performance_thread (gpointer result_p, gpointer data_p) {
+    BDNVMEFormatResult *result = (BDNVMEFormatResult *) result_p;
+    FormatData *data = (FormatData *) data_p;
+    BDNVMENamespaceInfo *info;
+
+    info = bd_nvme_get_namespace_info (result->device, &(result->error));
+    if (!info)
+        return;
+
+    result->lba_format = select_lba_format (info, data->lba_data_size, data->max_metadata_size, &(result->error));
+    if (!result->lba_format) {
+        bd_nvme_namespace_info_free (info);
+        return;
+    }
+
+    /* nothing to do if the namespace already uses the selected format */
+    if (data->secure_erase == BD_NVME_FORMAT_SECURE_ERASE_NONE &&
+        info->current_lba_format.data_size == result->lba_format->data_size &&
+        info->current_lba_format.metadata_size == result->lba_format->metadata_size) {
+        bd_nvme_namespace_info_free (info);
+        return;
+    }
+    bd_nvme_namespace_info_free (info);
+
+    result->formatted = bd_nvme_format (result->device, result->lba_format->data_size,
+                                        result->lba_format->metadata_size, data->secure_erase,
+                                        &(result->error));
+}
+
+/**
+ * bd_nvme_format_for_performance:
+ * @devices: (array zero-terminated=1): NVMe namespace devices to format (e.g. `/dev/nvme0n1`)
+ * @lba_data_size: required LBA data size (i.e. a sector size) in bytes or `0` for any size
+ * @max_metadata_size: maximum metadata size in bytes, `0` to only allow formats without metadata
+ * @secure_erase: optional secure erase action to take.
+ * @max_workers: maximum number of namespaces to format in parallel or 0 for the default (number of CPUs)
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Formats all the @devices namespaces to their best performing LBA format matching
+ * the @lba_data_size and @max_metadata_size constraints (see bd_nvme_select_lba_format()),
+ * destroying all data and metadata on them. Namespaces that already use the selected format
+ * are not formatted unless @secure_erase is requested.
+ *
+ * The namespaces are formatted in parallel. A failure to format one of the @devices doesn't
+ * affect the other devices, it is reported in the #BDNVMEFormatResult.error field of the
+ * particular result. See bd_nvme_format() for details about the format operation, note
+ * that namespaces of controllers that would format all namespaces fail with the
+ * #BD_NVME_ERROR_WOULD_FORMAT_ALL_NS error.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results for all the @devices or %NULL
+ *          in case of an error (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+BDNVMEFormatResult ** bd_nvme_format_for_performance (const gchar **devices, guint16 lba_data_size, guint16 max_metadata_size, BDNVMEFormatSecureErase secure_erase, guint max_workers, GError **error) {
+    const gchar **device;
+    GPtrArray *ptr_array;
+    BDNVMEFormatResult *result;
+    FormatData data = { lba_data_size, max_metadata_size, secure_erase };
+
+    if (devices == NULL) {
+        g_set_error_literal (error, BD_NVME_ERROR, BD_NVME_ERROR_INVALID_ARGUMENT,
+                             "Invalid value specified for the devices argument");
+        return NULL;
+    }
+
+    ptr_array = g_ptr_array_new ();
+    for (device = devices; *device; device++) {
+        result = g_new0 (BDNVMEFormatResult, 1);
+        result->device = g_strdup (*device);
+        g_ptr_array_add (ptr_array, result);
+    }
+
+    bd_utils_parallel_run (format_for_performance_thread, ptr_array->pdata, ptr_array->len, max_workers, &data);
+
+    g_ptr_array_add (ptr_array, NULL);  /* trailing NULL element */
+    return (BDNVMEFormatResult **) g_ptr_array_free (ptr_array, FALSE);
+}
+
 /**
  * bd_nvme_sanitize:
  * @device: NVMe namespace or controller device to format (e.g. `/dev/nvme0n1`)
@@ -334,8 +637,9 @@ gboolean bd_nvme_format (const gchar *device, guint16 lba_data_size, guint16 met
  *
  * This call returns immediately and the actual sanitize operation is performed
  * in the background. Use bd_nvme_get_sanitize_log() to retrieve status and progress
- * of a running sanitize operation. In case a sanitize operation fails the controller
- * may restrict its operation until a subsequent sanitize operation is started
+ * of a running sanitize operation or bd_nvme_sanitize_wait() to wait for it to finish.
+ * In case a sanitize operation fails the controller may restrict its operation
+ * until a subsequent sanitize operation is started
  * (i.e. retried) or an #BD_NVME_SANITIZE_ACTION_EXIT_FAILURE action is used
  * to acknowledge the failure explicitly.
  *
@@ -397,3 +701,94 @@ gboolean bd_nvme_sanitize (const gchar *device, BDNVMESanitizeAction action, gbo
     close (args.fd);
     return TRUE;
 }
+
+/**
+ * bd_nvme_sanitize_wait:
+ * @device: a NVMe controller or namespace device (e.g. `/dev/nvme0`)
+ * @timeout: maximum number of seconds to wait for or 0 to wait until the operation finishes
+ * @error: (out) (nullable): place to store error (if any)
+ *
+ * Waits for the sanitize operation started by bd_nvme_sanitize() to finish.
+ * The device is opened only once and the sanitize status log is checked
+ * at an adaptive interval -- more often when the operation makes progress and
+ * less often (up to once every two minutes, as advised by the NVMe specification)
+ * when it doesn't. The progress of the operation is reported using the libblockdev
+ * progress reporting.
+ *
+ * Returns: %TRUE if the most recent sanitize operation finished successfully,
+ *          %FALSE if it failed, the device has never been sanitized or @timeout
+ *          expired (with @error set).
+ *
+ * Tech category: %BD_NVME_TECH_NVME-%BD_NVME_TECH_MODE_MANAGE
+ */
+gboolean bd_nvme_sanitize_wait (const gchar *device, guint timeout, GError **error) {
+    BDNVMEHandle *handle;
+    BDNVMESanitizeLog *log;
+    gint64 deadline = 0;
+    gint64 interval = POLL_INTERVAL_MIN;
+    gint completion = -1;
+    gboolean progressed;
+    guint64 progress_id;
+    gchar *msg;
+    gboolean done = FALSE;
+    gboolean ret = FALSE;
+    GError *l_error = NULL;
+
+    handle = bd_nvme_handle_open (device, error);
+    if (!handle)
+        return FALSE;
+
+    if (timeout > 0)
+        deadline = g_get_monotonic_time () + (gint64) timeout * G_USEC_PER_SEC;
+
+    msg = g_strdup_printf ("Waiting for the sanitize operation on %s to finish", device);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    while (!done) {
+        log = bd_nvme_handle_get_sanitize_log (handle, &l_error);
+        if (!log)
+            break;
+
+        switch (log->sanitize_status) {
+            case BD_NVME_SANITIZE_STATUS_IN_PROGESS:
+                progressed = (gint) log->sanitize_progress != completion;
+                interval = next_poll_interval (interval, progressed, SANITIZE_POLL_INTERVAL_MAX);
+                if (progressed) {
+                    completion = (gint) log->sanitize_progress;
+                    bd_utils_report_progress (progress_id, completion, NULL);
+                }
+                break;
+            case BD_NVME_SANITIZE_STATUS_SUCCESS:
+            case BD_NVME_SANITIZE_STATUS_SUCCESS_NO_DEALLOC:
+                ret = TRUE;
+                done = TRUE;
+                break;
+            case BD_NVME_SANITIZE_STATUS_FAILED:
+                g_set_error (&l_error, BD_NVME_ERROR, BD_NVME_ERROR_FAILED,
+                             "Sanitize operation failed");
+                done = TRUE;
+                break;
+            case BD_NVME_SANITIZE_STATUS_NEVER_SANITIZED:
+            default:
+                g_set_error (&l_error, BD_NVME_ERROR, BD_NVME_ERROR_NO_MATCH,
+                             "No sanitize operation has been performed on the device");
+                done = TRUE;
+                break;
+        }
+        bd_nvme_sanitize_log_free (log);
+
+        if (!done && !poll_sleep (interval, deadline)) {
+            g_set_error (&l_error, BD_NVME_ERROR, BD_NVME_ERROR_BUSY,
+                         "Timed out waiting for the sanitize operation to finish");
+            break;
+        }
+    }
+
+    bd_utils_report_finished (progress_id, ret ? "Completed" : l_error->message);
+    bd_nvme_handle_free (handle);
+    if (l_error)
+        g_propagate_error (error, l_error);
+
+    return ret;
+}
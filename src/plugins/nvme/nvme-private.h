@@ -27,4 +27,8 @@ gint _open_dev (const gchar *device, GError **error);
 G_GNUC_INTERNAL
 void *_nvme_alloc (size_t len);
 
+/* nvme-fabrics.c */
+G_GNUC_INTERNAL
+void _nvme_discovery_cache_clear (void);
+
 #endif  /* BD_NVME_PRIVATE */
@@ -375,6 +375,15 @@ typedef struct BDNVMEErrorLogEntry {
     BDNVMETransportType transport_type;
 } BDNVMEErrorLogEntry;
 
+/**
+ * BDNVMEErrorLogEntryFunc:
+ * @entry: (transfer none): an Error Information Log entry
+ * @user_data: (closure): user data passed to bd_nvme_get_error_log_entries_foreach()
+ *
+ * Returns: whether to continue with the next entry or not
+ */
+typedef gboolean (*BDNVMEErrorLogEntryFunc) (BDNVMEErrorLogEntry *entry, gpointer user_data);
+
 /**
  * BDNVMESelfTestAction:
  * Action taken by the Device Self-test command.
@@ -560,6 +569,61 @@ BDNVMESelfTestLog * bd_nvme_self_test_log_copy (BDNVMESelfTestLog *log);
 void bd_nvme_sanitize_log_free (BDNVMESanitizeLog *log);
 BDNVMESanitizeLog * bd_nvme_sanitize_log_copy (BDNVMESanitizeLog *log);
 
+typedef struct BDNVMEHandle {
+    gchar *device;
+    gint fd;
+    gint ref_count;
+    GMutex lock;
+    gpointer ctrl_id;
+} BDNVMEHandle;
+
+void bd_nvme_handle_free (BDNVMEHandle *handle);
+BDNVMEHandle * bd_nvme_handle_copy (BDNVMEHandle *handle);
+
+typedef struct BDNVMEHealthInfo {
+    gchar *device;
+    BDNVMESmartLog *smart_log;
+    BDNVMEErrorLogEntry **error_log_entries;
+    GError *error;
+} BDNVMEHealthInfo;
+
+void bd_nvme_health_info_free (BDNVMEHealthInfo *info);
+BDNVMEHealthInfo * bd_nvme_health_info_copy (BDNVMEHealthInfo *info);
+
+typedef struct BDNVMEDiscoveryLogEntry {
+    gchar *transport;
+    gchar *transport_addr;
+    gchar *transport_svcid;
+    gchar *subsysnqn;
+    gboolean discovery;
+    guint16 port_id;
+    guint16 ctrl_id;
+} BDNVMEDiscoveryLogEntry;
+
+void bd_nvme_discovery_log_entry_free (BDNVMEDiscoveryLogEntry *entry);
+BDNVMEDiscoveryLogEntry * bd_nvme_discovery_log_entry_copy (BDNVMEDiscoveryLogEntry *entry);
+
+typedef struct BDNVMEConnectResult {
+    gchar *subsysnqn;
+    gchar *transport_addr;
+    gchar *transport_svcid;
+    guint attempts;
+    GError *error;
+} BDNVMEConnectResult;
+
+void bd_nvme_connect_result_free (BDNVMEConnectResult *result);
+BDNVMEConnectResult * bd_nvme_connect_result_copy (BDNVMEConnectResult *result);
+
+typedef struct BDNVMEFormatResult {
+    gchar *device;
+    BDNVMELBAFormat *lba_format;
+    gboolean formatted;
+    GError *error;
+} BDNVMEFormatResult;
+
+void bd_nvme_format_result_free (BDNVMEFormatResult *result);
+BDNVMEFormatResult * bd_nvme_format_result_copy (BDNVMEFormatResult *result);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -578,18 +642,42 @@ BDNVMEControllerInfo * bd_nvme_get_controller_info   (const gchar *device, GErro
 BDNVMENamespaceInfo *  bd_nvme_get_namespace_info    (const gchar *device, GError **error);
 BDNVMESmartLog *       bd_nvme_get_smart_log         (const gchar *device, GError **error);
 BDNVMEErrorLogEntry ** bd_nvme_get_error_log_entries (const gchar *device, GError **error);
+gboolean bd_nvme_get_error_log_entries_foreach (const gchar *device, BDNVMEErrorLogEntryFunc func, gpointer user_data, GError **error);
 BDNVMESelfTestLog *    bd_nvme_get_self_test_log     (const gchar *device, GError **error);
 BDNVMESanitizeLog *    bd_nvme_get_sanitize_log      (const gchar *device, GError **error);
 
+BDNVMEHandle *         bd_nvme_handle_open                  (const gchar *device, GError **error);
+BDNVMEControllerInfo * bd_nvme_handle_get_controller_info   (BDNVMEHandle *handle, GError **error);
+BDNVMENamespaceInfo *  bd_nvme_handle_get_namespace_info    (BDNVMEHandle *handle, GError **error);
+BDNVMESmartLog *       bd_nvme_handle_get_smart_log         (BDNVMEHandle *handle, GError **error);
+BDNVMEErrorLogEntry ** bd_nvme_handle_get_error_log_entries (BDNVMEHandle *handle, GError **error);
+BDNVMESelfTestLog *    bd_nvme_handle_get_self_test_log     (BDNVMEHandle *handle, GError **error);
+BDNVMESanitizeLog *    bd_nvme_handle_get_sanitize_log      (BDNVMEHandle *handle, GError **error);
+
+BDNVMEHealthInfo **    bd_nvme_get_health_all        (guint max_workers, GError **error);
+
 gboolean               bd_nvme_device_self_test      (const gchar                  *device,
                                                       BDNVMESelfTestAction          action,
                                                       GError                      **error);
+gboolean               bd_nvme_device_self_test_wait (const gchar                  *device,
+                                                      guint                         timeout,
+                                                      GError                      **error);
 
 gboolean               bd_nvme_format                (const gchar                  *device,
                                                       guint16                       lba_data_size,
                                                       guint16                       metadata_size,
                                                       BDNVMEFormatSecureErase       secure_erase,
                                                       GError                      **error);
+BDNVMELBAFormat *      bd_nvme_select_lba_format     (const gchar                  *device,
+                                                      guint16                       lba_data_size,
+                                                      guint16                       max_metadata_size,
+                                                      GError                      **error);
+BDNVMEFormatResult **  bd_nvme_format_for_performance (const gchar                **devices,
+                                                      guint16                       lba_data_size,
+                                                      guint16                       max_metadata_size,
+                                                      BDNVMEFormatSecureErase       secure_erase,
+                                                      guint                         max_workers,
+                                                      GError                      **error);
 gboolean               bd_nvme_sanitize              (const gchar                  *device,
                                                       BDNVMESanitizeAction          action,
                                                       gboolean                      no_dealloc,
@@ -597,6 +685,9 @@ gboolean               bd_nvme_sanitize              (const gchar
                                                       guint32                       overwrite_pattern,
                                                       gboolean                      overwrite_invert_pattern,
                                                       GError                      **error);
+gboolean               bd_nvme_sanitize_wait         (const gchar                  *device,
+                                                      guint                         timeout,
+                                                      GError                      **error);
 
 gchar *                bd_nvme_get_host_nqn          (GError           **error);
 gchar *                bd_nvme_generate_host_nqn     (GError           **error);
@@ -616,6 +707,25 @@ gboolean               bd_nvme_connect               (const gchar       *subsysn
                                                       const gchar       *host_id,
                                                       const BDExtraArg **extra,
                                                       GError           **error);
+BDNVMEDiscoveryLogEntry ** bd_nvme_discover        (const gchar       *transport,
+                                                      const gchar       *transport_addr,
+                                                      const gchar       *transport_svcid,
+                                                      const gchar       *host_traddr,
+                                                      const gchar       *host_iface,
+                                                      const gchar       *host_nqn,
+                                                      const gchar       *host_id,
+                                                      gboolean           refresh,
+                                                      const BDExtraArg **extra,
+                                                      GError           **error);
+BDNVMEConnectResult ** bd_nvme_connect_many          (const BDNVMEDiscoveryLogEntry **targets,
+                                                      const gchar       *host_traddr,
+                                                      const gchar       *host_iface,
+                                                      const gchar       *host_nqn,
+                                                      const gchar       *host_id,
+                                                      guint              max_workers,
+                                                      guint              max_retries,
+                                                      const BDExtraArg **extra,
+                                                      GError           **error);
 gboolean               bd_nvme_disconnect            (const gchar       *subsysnqn,
                                                       GError           **error);
 gboolean               bd_nvme_disconnect_by_path    (const gchar       *path,
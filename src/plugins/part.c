@@ -19,12 +19,16 @@
 
 #include <ctype.h>
 #include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <fcntl.h>
 #include <blockdev/utils.h>
 #include <libfdisk.h>
 #include <locale.h>
 
 #include "part.h"
+#include "part_reader.h"
+#include "../utils/parallel.h"
 
 /**
  * SECTION: part
@@ -39,7 +43,9 @@
  * is subject to future development and enhancements.
  *
  * This particular implementation of the part plugin uses libfdisk for
- * manipulations of both the MBR and GPT disk label types.
+ * manipulations of both the MBR and GPT disk label types. Simple queries on
+ * plain MBR and GPT tables are answered by reading the tables directly without
+ * libfdisk.
  */
 
 /**
@@ -82,6 +88,48 @@ void bd_part_spec_free (BDPartSpec *data) {
     g_free (data);
 }
 
+BDPartCreateSpec* bd_part_create_spec_copy (BDPartCreateSpec *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDPartCreateSpec *ret = g_new0 (BDPartCreateSpec, 1);
+
+    ret->type = data->type;
+    ret->start = data->start;
+    ret->size = data->size;
+    ret->align = data->align;
+    ret->name = g_strdup (data->name);
+    ret->type_guid = g_strdup (data->type_guid);
+    ret->uuid = g_strdup (data->uuid);
+
+    return ret;
+}
+
+void bd_part_create_spec_free (BDPartCreateSpec *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->name);
+    g_free (data->type_guid);
+    g_free (data->uuid);
+    g_free (data);
+}
+
+BDPartCreateSpec* bd_part_create_spec_new (BDPartTypeReq type, guint64 start, guint64 size, BDPartAlign align,
+                                           const gchar *name, const gchar *type_guid, const gchar *uuid) {
+    BDPartCreateSpec *ret = g_new0 (BDPartCreateSpec, 1);
+
+    ret->type = type;
+    ret->start = start;
+    ret->size = size;
+    ret->align = align;
+    ret->name = g_strdup (name);
+    ret->type_guid = g_strdup (type_guid);
+    ret->uuid = g_strdup (uuid);
+
+    return ret;
+}
+
 BDPartDiskSpec* bd_part_disk_spec_copy (BDPartDiskSpec *data) {
     if (data == NULL)
         return NULL;
@@ -104,6 +152,42 @@ void bd_part_disk_spec_free (BDPartDiskSpec *data) {
     g_free (data);
 }
 
+BDPartDiskParts* bd_part_disk_parts_copy (BDPartDiskParts *data) {
+    guint64 i = 0;
+
+    if (data == NULL)
+        return NULL;
+
+    BDPartDiskParts *ret = g_new0 (BDPartDiskParts, 1);
+
+    ret->disk = g_strdup (data->disk);
+    if (data->parts) {
+        for (i = 0; data->parts[i]; i++);
+        ret->parts = g_new0 (BDPartSpec *, i + 1);
+        for (i = 0; data->parts[i]; i++)
+            ret->parts[i] = bd_part_spec_copy (data->parts[i]);
+    }
+    if (data->error)
+        ret->error = g_error_copy (data->error);
+
+    return ret;
+}
+
+void bd_part_disk_parts_free (BDPartDiskParts *data) {
+    guint64 i = 0;
+
+    if (data == NULL)
+        return;
+
+    g_free (data->disk);
+    for (i = 0; data->parts && data->parts[i]; i++)
+        bd_part_spec_free (data->parts[i]);
+    g_free (data->parts);
+    if (data->error)
+        g_error_free (data->error);
+    g_free (data);
+}
+
 /* "C" locale to get the locale-agnostic error messages */
 static locale_t c_locale = (locale_t) 0;
 
@@ -189,6 +273,7 @@ static int fdisk_ask_callback (struct fdisk_context *cxt G_GNUC_UNUSED, struct f
 
 static struct fdisk_context* get_device_context (const gchar *disk, gboolean read_only, GError **error) {
     struct fdisk_context *cxt = fdisk_new_context ();
+    BDUtilsTimingSpan span;
     gint ret = 0;
 
     if (!cxt) {
@@ -197,7 +282,9 @@ static struct fdisk_context* get_device_context (const gchar *disk, gboolean rea
         return NULL;
     }
 
+    bd_utils_timing_span_begin (&span, "part", G_STRFUNC);
     ret = fdisk_assign_device (cxt, disk, read_only);
+    bd_utils_timing_span_end (&span, 0, "fdisk_assign_device", 0, ret == 0 ? 0 : -1);
     if (ret != 0) {
         g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to assign the new context to disk '%s': %s", disk, strerror_l (-ret, c_locale));
@@ -224,30 +311,33 @@ static void close_context (struct fdisk_context *cxt) {
     fdisk_unref_context (cxt);
 }
 
+#define LOCK_TIMEOUT_MS 500
+
+static gboolean lock_attempt (gpointer user_data) {
+    return flock (*((gint *) user_data), LOCK_EX|LOCK_NB) == 0;
+}
+
 static gboolean write_label (struct fdisk_context *cxt, struct fdisk_table *orig, const gchar *disk, gboolean force, GError **error) {
     gint ret = 0;
     gint dev_fd = 0;
-    guint num_tries = 1;
+    BDUtilsTimingSpan span;
 
     /* XXX: try to grab a lock for the device so that udev doesn't step in
        between the two operations we need to perform (see below) with its
        BLKRRPART ioctl() call which makes the device busy
        see https://systemd.io/BLOCK_DEVICE_LOCKING */
     dev_fd = open (disk, O_RDONLY|O_CLOEXEC);
-    if (dev_fd >= 0) {
-        ret = flock (dev_fd, LOCK_EX|LOCK_NB);
-        while ((ret != 0) && (num_tries <= 5)) {
-            g_usleep (100 * 1000); /* microseconds */
-            ret = flock (dev_fd, LOCK_EX|LOCK_NB);
-            num_tries++;
-        }
-    }
+    if (dev_fd >= 0)
+        /* udev closes the device when it's done with it */
+        bd_utils_dev_retry (disk, LOCK_TIMEOUT_MS, lock_attempt, &dev_fd);
 
     /* Just continue even in case we don't get the lock, there's still a
        chance things will just work. If not, an error will be reported
        anyway with no harm. */
 
+    bd_utils_timing_span_begin (&span, "part", G_STRFUNC);
     ret = fdisk_write_disklabel (cxt);
+    bd_utils_timing_span_end (&span, 0, "fdisk_write_disklabel", 0, ret == 0 ? 0 : -1);
     if (ret != 0) {
         g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to write the new disklabel to disk '%s': %s", disk, strerror_l (-ret, c_locale));
@@ -570,11 +660,21 @@ BDPartSpec* bd_part_get_part_spec (const gchar *disk, const gchar *part, GError
     gint status = 0;
     gint part_num = 0;
     BDPartSpec *ret = NULL;
+    PartReaderTable *rtable = NULL;
 
     part_num = get_part_num (part, error);
     if (part_num == -1)
         return NULL;
 
+    rtable = part_reader_read (disk, TRUE);
+    if (rtable) {
+        ret = bd_part_spec_copy (part_reader_get_part (rtable, part_num));
+        part_reader_table_free (rtable);
+        if (ret)
+            return ret;
+        /* let libfdisk deal with (or report) the nonexistent partition */
+    }
+
     /* first partition in fdisk is 0 */
     part_num--;
 
@@ -609,6 +709,22 @@ static BDPartSpec** get_disk_parts (const gchar *disk, gboolean parts, gboolean
     BDPartSpec *prev_spec = NULL;
     GPtrArray *array = NULL;
     gint status = 0;
+    PartReaderTable *rtable = NULL;
+    BDPartSpec **ret = NULL;
+    guint i = 0;
+
+    if (parts && !freespaces && !metadata) {
+        /* just the partitions -- no need for libfdisk if the table is simple enough */
+        rtable = part_reader_read (disk, TRUE);
+        if (rtable) {
+            for (i = 0; rtable->parts[i]; i++);
+            ret = g_new0 (BDPartSpec *, i + 1);
+            for (i = 0; rtable->parts[i]; i++)
+                ret[i] = bd_part_spec_copy (rtable->parts[i]);
+            part_reader_table_free (rtable);
+            return ret;
+        }
+    }
 
     cxt = get_device_context (disk, TRUE, error);
     if (!cxt) {
@@ -778,6 +894,18 @@ BDPartDiskSpec* bd_part_get_disk_spec (const gchar *disk, GError **error) {
     const gchar *label_name = NULL;
     BDPartTableType type = BD_PART_TABLE_UNDEF;
     gboolean found = FALSE;
+    PartReaderTable *rtable = NULL;
+
+    rtable = part_reader_read (disk, FALSE);
+    if (rtable) {
+        ret = g_new0 (BDPartDiskSpec, 1);
+        ret->path = g_strdup (disk);
+        ret->table_type = rtable->table_type;
+        ret->sector_size = rtable->sector_size;
+        ret->size = rtable->size;
+        part_reader_table_free (rtable);
+        return ret;
+    }
 
     cxt = get_device_context (disk, TRUE, error);
     if (!cxt) {
@@ -822,6 +950,148 @@ BDPartSpec** bd_part_get_disk_parts (const gchar *disk, GError **error) {
     return get_disk_parts (disk, TRUE, FALSE, FALSE, error);
 }
 
+/**
+ * bd_part_get_disk_parts_foreach:
+ * @disk: disk to get information about partitions for
+ * @func: (scope call): function to call for every partition found
+ * @user_data: (closure): data to pass to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Calls @func for every partition from @disk (in the same order as
+ * bd_part_get_disk_parts() returns them) without creating the list of all the
+ * partitions. The spec is only valid during the call of @func, use
+ * bd_part_spec_copy() to keep it. If @func returns %FALSE, no more partitions
+ * are reported.
+ *
+ * Returns: whether the partitions were successfully listed or not (stopping
+ *          the listing from @func is not an error)
+ *
+ * Tech category: %BD_PART_TECH_MODE_QUERY_TABLE + the tech according to the partition table type
+ */
+gboolean bd_part_get_disk_parts_foreach (const gchar *disk, BDPartSpecFunc func, gpointer user_data, GError **error) {
+    struct fdisk_context *cxt = NULL;
+    struct fdisk_table *table = NULL;
+    struct fdisk_partition *pa = NULL;
+    struct fdisk_iter *itr = NULL;
+    BDPartSpec *spec = NULL;
+    PartReaderTable *rtable = NULL;
+    gboolean cont = TRUE;
+    gint status = 0;
+    guint i = 0;
+
+    rtable = part_reader_read (disk, TRUE);
+    if (rtable) {
+        for (i = 0; cont && rtable->parts[i]; i++)
+            cont = func (rtable->parts[i], user_data);
+        part_reader_table_free (rtable);
+        return TRUE;
+    }
+
+    cxt = get_device_context (disk, TRUE, error);
+    if (!cxt) {
+        /* error is already populated */
+        return FALSE;
+    }
+
+    table = fdisk_new_table ();
+    if (!table) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to create a new table");
+        close_context (cxt);
+        return FALSE;
+    }
+
+    itr = fdisk_new_iter (FDISK_ITER_FORWARD);
+    if (!itr) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to create a new iterator");
+        fdisk_unref_table (table);
+        close_context (cxt);
+        return FALSE;
+    }
+
+    status = fdisk_get_partitions (cxt, &table);
+    if (status == 0)
+        status = fdisk_table_sort_partitions (table, fdisk_partition_cmp_start);
+    if (status != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to get partitions");
+        fdisk_free_iter (itr);
+        fdisk_unref_table (table);
+        close_context (cxt);
+        return FALSE;
+    }
+
+    while (cont && fdisk_table_next_partition (table, itr, &pa) == 0) {
+        spec = get_part_spec_fdisk (cxt, pa, error);
+        if (!spec) {
+            fdisk_free_iter (itr);
+            fdisk_unref_table (table);
+            close_context (cxt);
+            return FALSE;
+        }
+
+        cont = func (spec, user_data);
+        bd_part_spec_free (spec);
+    }
+
+    fdisk_free_iter (itr);
+    fdisk_unref_table (table);
+    close_context (cxt);
+
+    return TRUE;
+}
+
+/* disk reads are latency-bound, so more workers than CPUs make sense here */
+#define DEFAULT_DISKS_WORKERS 16
+
+static void get_disks_parts_thread (gpointer data, gpointer user_data) {
+    BDPartDiskParts *entry = (BDPartDiskParts *) data;
+
+    entry->parts = get_disk_parts (entry->disk, TRUE, FALSE, FALSE, &(entry->error));
+}
+
+/**
+ * bd_part_get_disks_parts:
+ * @disks: (array zero-terminated=1): disks to get information about partitions for
+ * @max_workers: maximum number of disks to read in parallel or 0 for the default
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Reads the partition tables of all the @disks in parallel. A failure to read
+ * one of the tables doesn't affect the others, it is reported in the
+ * #BDPartDiskParts.error field of the particular entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): partitions of the @disks (one
+ *                                                     entry per disk in the same order as in @disks)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_PART_TECH_MODE_QUERY_TABLE + the tech according to the partition table type
+ */
+BDPartDiskParts** bd_part_get_disks_parts (const gchar **disks, guint max_workers, GError **error) {
+    BDPartDiskParts **ret = NULL;
+    guint num_disks = 0;
+    guint i = 0;
+
+    if (!disks) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                     "No disks specified");
+        return NULL;
+    }
+
+    num_disks = g_strv_length ((gchar **) disks);
+    ret = g_new0 (BDPartDiskParts *, num_disks + 1);
+    for (i = 0; i < num_disks; i++) {
+        ret[i] = g_new0 (BDPartDiskParts, 1);
+        ret[i]->disk = g_strdup (disks[i]);
+    }
+
+    if (max_workers == 0)
+        max_workers = DEFAULT_DISKS_WORKERS;
+    bd_utils_parallel_run (get_disks_parts_thread, (gpointer *) ret, num_disks, max_workers, NULL);
+
+    return ret;
+}
+
 /**
  * bd_part_get_disk_free_regions:
  * @disk: disk to get free regions for
@@ -913,37 +1183,109 @@ BDPartSpec* bd_part_get_best_free_region (const gchar *disk, BDPartType type, gu
     return ret;
 }
 
-/**
- * bd_part_create_part:
- * @disk: disk to create partition on
- * @type: type of the partition to create (if %BD_PART_TYPE_REQ_NEXT, the
- *        partition type will be determined automatically based on the existing
- *        partitions)
- * @start: where the partition should start (i.e. offset from the disk start)
- * @size: desired size of the partition (if 0, a max-sized partition is created)
- * @align: alignment to use for the partition
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: (transfer full): specification of the created partition or %NULL in case of error
- *
- * NOTE: The resulting partition may start at a different position than given by
- *       @start and can have different size than @size due to alignment.
- *
- * Tech category: %BD_PART_TECH_MODE_MODIFY_TABLE + the tech according to the partition table type
- */
-BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64 start, guint64 size, BDPartAlign align, GError **error) {
-    struct fdisk_context *cxt = NULL;
+/* reads a numeric attribute from the queue directory of the block device
+   with the @st_rdev device number, returns 0 if not available */
+static guint64 get_queue_attr (dev_t st_rdev, const gchar *attr) {
+    g_autofree gchar *path = NULL;
+    g_autofree gchar *contents = NULL;
+
+    path = g_strdup_printf ("/sys/dev/block/%u:%u/queue/%s", major (st_rdev), minor (st_rdev), attr);
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        return 0;
+
+    return g_ascii_strtoull (contents, NULL, 10);
+}
+
+static guint64 gcd (guint64 a, guint64 b) {
+    guint64 tmp;
+
+    while (b != 0) {
+        tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+    return a;
+}
+
+static guint64 lcm (guint64 a, guint64 b) {
+    if (a == 0 || b == 0)
+        return MAX (a, b);
+    return (a / gcd (a, b)) * b;
+}
+
+/* alignment (in bytes) satisfying the I/O topology of the device opened in @cxt:
+   the full stripe of RAID devices (optimal I/O size), the minimum I/O size and
+   physical block size and the zone size of zoned (SMR) devices, @default_grain
+   is returned if the topology information is not available, like libfdisk and
+   parted, the optimal I/O size is only used if it's a multiple of the other two
+   (many USB bridges report bogus values like 33553920) */
+static guint64 get_topology_grain (struct fdisk_context *cxt, guint64 sector_size, guint64 default_grain) {
+    struct stat st;
+    g_autofree gchar *zoned = NULL;
+    g_autofree gchar *zoned_path = NULL;
+    guint64 grain = 0;
+    guint64 optimal_io_size = 0;
+    guint64 zone_size = 0;
+
+    if (fstat (fdisk_get_devfd (cxt), &st) != 0 || !S_ISBLK (st.st_mode))
+        return default_grain;
+
+    grain = lcm (sector_size, get_queue_attr (st.st_rdev, "physical_block_size"));
+    grain = lcm (grain, get_queue_attr (st.st_rdev, "minimum_io_size"));
+    optimal_io_size = get_queue_attr (st.st_rdev, "optimal_io_size");
+    if (optimal_io_size > 0 && optimal_io_size % grain == 0)
+        grain = optimal_io_size;
+
+    /* partitions on zoned devices need to start and end on zone boundaries */
+    zoned_path = g_strdup_printf ("/sys/dev/block/%u:%u/queue/zoned", major (st.st_rdev), minor (st.st_rdev));
+    if (g_file_get_contents (zoned_path, &zoned, NULL, NULL) && !g_str_has_prefix (zoned, "none")) {
+        /* zone size is reported in 512 B sectors */
+        zone_size = get_queue_attr (st.st_rdev, "chunk_sectors") * 512;
+        grain = lcm (grain, zone_size);
+    }
+
+    if (grain <= sector_size)
+        return default_grain;
+
+    /* keep at least the usual 1 MiB alignment for devices with small I/O sizes */
+    if (grain < 1 MiB)
+        grain = ((1 MiB + grain - 1) / grain) * grain;
+
+    return grain;
+}
+
+/* returns @size (in sectors) of the partition starting at @start (in sectors)
+   shrunk so that its end is aligned the same way libfdisk aligns the ends of
+   new partitions, which doesn't know about our grain in case of
+   %BD_PART_ALIGN_TOPOLOGY */
+static guint64 align_part_end (struct fdisk_context *cxt, BDPartAlign align, guint64 sector_size, guint64 grain_size,
+                               guint64 start, guint64 size) {
+    guint64 grain_sectors = grain_size / sector_size;
+    guint64 end = start + size;
+
+    if (align == BD_PART_ALIGN_TOPOLOGY && grain_sectors > 0) {
+        end = (end / grain_sectors) * grain_sectors;
+        /* too small to be aligned */
+        return end > start ? end - start : size;
+    } else if (fdisk_version >= 2380 && align != BD_PART_ALIGN_NONE) {
+        end = fdisk_align_lba_in_range (cxt, end, start, end);
+        return end - start;
+    }
+
+    return size;
+}
+
+/* adds a new partition to the in-memory table of @cxt, @table is the current
+   table (including the partitions added before), returns the new partition */
+static struct fdisk_partition* add_part (struct fdisk_context *cxt, struct fdisk_table *table, BDPartTypeReq type, guint64 start, guint64 size,
+                                         BDPartAlign align, gboolean *new_extended, GError **error) {
     struct fdisk_partition *npa = NULL;
     gint status = 0;
-    BDPartSpec *ret = NULL;
-    guint64 progress_id = 0;
-    gchar *msg = NULL;
     guint64 sector_size = 0;
     guint64 grain_size = 0;
     guint64 end = 0;
     struct fdisk_parttype *ptype = NULL;
     struct fdisk_label *lbl = NULL;
-    struct fdisk_table *table = NULL;
     struct fdisk_iter *iter = NULL;
     struct fdisk_partition *pa = NULL;
     struct fdisk_partition *epa = NULL;
@@ -952,41 +1294,11 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
     guint n_parts = 0;
     gboolean on_gpt = FALSE;
     size_t partno = 0;
-    gchar *ppath = NULL;
-    gboolean new_extended = FALSE;
-    GError *l_error = NULL;
-
-    msg = g_strdup_printf ("Started adding partition to '%s'", disk);
-    progress_id = bd_utils_report_started (msg);
-    g_free (msg);
-
-    cxt = get_device_context (disk, FALSE, &l_error);
-    if (!cxt) {
-        /* error is already populated */
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return NULL;
-    }
-
-    status = fdisk_get_partitions (cxt, &table);
-    if (status != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
-                     "Failed to get existing partitions on the device: %s", strerror_l (-status, c_locale));
-        fdisk_unref_partition (npa);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return NULL;
-   }
 
     npa = fdisk_new_partition ();
     if (!npa) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to create new partition object");
-        fdisk_unref_table (table);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return NULL;
     }
 
@@ -997,16 +1309,15 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
         grain_size = sector_size;
     else if (align == BD_PART_ALIGN_MINIMAL)
         grain_size = (guint64) fdisk_get_minimal_iosize (cxt);
+    else if (align == BD_PART_ALIGN_TOPOLOGY)
+        grain_size = get_topology_grain (cxt, sector_size, grain_size);
     /* else OPTIMAL or unknown -> nothing to do */
 
     status = fdisk_save_user_grain (cxt, grain_size);
     if (status != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to setup alignment");
-        fdisk_unref_table (table);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
+        fdisk_unref_partition (npa);
         return NULL;
     }
 
@@ -1014,12 +1325,9 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
      * effective */
     status = fdisk_reset_device_properties (cxt);
     if (status != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to setup alignment");
-        fdisk_unref_table (table);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
+        fdisk_unref_partition (npa);
         return NULL;
     }
 
@@ -1055,13 +1363,9 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
         size = end - start;
 
         if (fdisk_partition_set_size (npa, size) != 0) {
-            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                          "Failed to set partition size");
-            fdisk_unref_table (table);
             fdisk_unref_partition (npa);
-            close_context (cxt);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return NULL;
         }
     }
@@ -1075,13 +1379,9 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
       type = BD_PART_TYPE_REQ_NORMAL;
 
     if (on_gpt && type != BD_PART_TYPE_REQ_NORMAL) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Only normal partitions are supported on GPT.");
-        fdisk_unref_table (table);
         fdisk_unref_partition (npa);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return NULL;
     }
 
@@ -1106,14 +1406,10 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
             else {
                 /* trying to create a partition inside an existing one, but not
                    an extended one -> error */
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
                              "Cannot create a partition inside an existing non-extended one");
                 fdisk_unref_partition (npa);
                 fdisk_free_iter (iter);
-                fdisk_unref_table (table);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
                 return NULL;
             }
         } else if (epa)
@@ -1124,27 +1420,21 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
             /* already 3 primary partitions -> create an extended partition of
                the biggest possible size and a logical partition as requested in
                it */
-            new_extended = TRUE;
+            *new_extended = TRUE;
             n_epa = fdisk_new_partition ();
             if (!n_epa) {
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Failed to create new partition object");
                 fdisk_unref_partition (npa);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
+                fdisk_free_iter (iter);
                 return NULL;
             }
             if (fdisk_partition_set_start (n_epa, start) != 0) {
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Failed to set partition start");
                 fdisk_unref_partition (n_epa);
                 fdisk_unref_partition (npa);
                 fdisk_free_iter (iter);
-                fdisk_unref_table (table);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
                 return NULL;
             }
 
@@ -1152,23 +1442,21 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
 
             status = fdisk_partition_next_partno (npa, cxt, &partno);
             if (status != 0) {
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Failed to get new extended partition number");
+                fdisk_unref_partition (n_epa);
                 fdisk_unref_partition (npa);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
+                fdisk_free_iter (iter);
                 return NULL;
             }
 
             status = fdisk_partition_set_partno (npa, partno);
             if (status != 0) {
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Failed to set new extended partition number");
+                fdisk_unref_partition (n_epa);
                 fdisk_unref_partition (npa);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
+                fdisk_free_iter (iter);
                 return NULL;
             }
 
@@ -1178,15 +1466,11 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
             /* "05" for extended partition */
             ptype = fdisk_label_parse_parttype (fdisk_get_label (cxt, NULL), "05");
             if (fdisk_partition_set_type (n_epa, ptype) != 0) {
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Failed to set partition type");
                 fdisk_unref_partition (n_epa);
                 fdisk_unref_partition (npa);
                 fdisk_free_iter (iter);
-                fdisk_unref_table (table);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
                 return NULL;
             }
             fdisk_unref_parttype (ptype);
@@ -1194,14 +1478,10 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
             status = fdisk_add_partition (cxt, n_epa, NULL);
             fdisk_unref_partition (n_epa);
             if (status != 0) {
-                g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Failed to add new partition to the table: %s", strerror_l (-status, c_locale));
                 fdisk_unref_partition (npa);
                 fdisk_free_iter (iter);
-                fdisk_unref_table (table);
-                close_context (cxt);
-                bd_utils_report_finished (progress_id, l_error->message);
-                g_propagate_error (error, l_error);
                 return NULL;
             }
             /* shift the start 2 MiB further as that's where the first logical
@@ -1217,17 +1497,13 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
     }
 
     if (type == BD_PART_TYPE_REQ_EXTENDED) {
-        new_extended = TRUE;
+        *new_extended = TRUE;
         /* "05" for extended partition */
         ptype = fdisk_label_parse_parttype (fdisk_get_label (cxt, NULL), "05");
         if (fdisk_partition_set_type (npa, ptype) != 0) {
-            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                          "Failed to set partition type");
-            fdisk_unref_table (table);
             fdisk_unref_partition (npa);
-            close_context (cxt);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return NULL;
         }
 
@@ -1235,13 +1511,9 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
     }
 
     if (fdisk_partition_set_start (npa, start) != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to set partition start");
-        fdisk_unref_table (table);
         fdisk_unref_partition (npa);
-        close_context (cxt);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return NULL;
     }
 
@@ -1254,35 +1526,101 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
     } else {
         status = fdisk_partition_next_partno (npa, cxt, &partno);
         if (status != 0) {
-            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                          "Failed to get new partition number");
-            fdisk_unref_table (table);
             fdisk_unref_partition (npa);
-            close_context (cxt);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return NULL;
         }
     }
 
     status = fdisk_partition_set_partno (npa, partno);
     if (status != 0) {
-        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                      "Failed to set new partition number");
-        fdisk_unref_table (table);
         fdisk_unref_partition (npa);
-        close_context (cxt);
+        return NULL;
+    }
+
+    status = fdisk_add_partition (cxt, npa, NULL);
+    if (status != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to add new partition to the table: %s", strerror_l (-status, c_locale));
+        fdisk_unref_partition (npa);
+        return NULL;
+    }
+
+    return npa;
+}
+
+static gchar* get_part_path (const gchar *disk, size_t partno) {
+    if (isdigit (disk[strlen (disk) - 1]))
+        return g_strdup_printf ("%sp%zu", disk, partno + 1);
+    else
+        return g_strdup_printf ("%s%zu", disk, partno + 1);
+}
+
+/**
+ * bd_part_create_part:
+ * @disk: disk to create partition on
+ * @type: type of the partition to create (if %BD_PART_TYPE_REQ_NEXT, the
+ *        partition type will be determined automatically based on the existing
+ *        partitions)
+ * @start: where the partition should start (i.e. offset from the disk start)
+ * @size: desired size of the partition (if 0, a max-sized partition is created)
+ * @align: alignment to use for the partition
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): specification of the created partition or %NULL in case of error
+ *
+ * NOTE: The resulting partition may start at a different position than given by
+ *       @start and can have different size than @size due to alignment.
+ *
+ * With %BD_PART_ALIGN_TOPOLOGY the start and size of the partition are aligned
+ * to the I/O topology of @disk reported by the kernel -- the full stripe width
+ * (optimal I/O size) of RAID devices, the minimum I/O size, the physical block
+ * size and the zone size of zoned (SMR) devices -- to avoid read-modify-write
+ * cycles, but at least to 1 MiB. The alignment offset of the device is taken
+ * into account by libfdisk.
+ *
+ * Tech category: %BD_PART_TECH_MODE_MODIFY_TABLE + the tech according to the partition table type
+ */
+BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64 start, guint64 size, BDPartAlign align, GError **error) {
+    struct fdisk_context *cxt = NULL;
+    struct fdisk_partition *npa = NULL;
+    gint status = 0;
+    BDPartSpec *ret = NULL;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    struct fdisk_table *table = NULL;
+    gchar *ppath = NULL;
+    gboolean new_extended = FALSE;
+    GError *l_error = NULL;
+
+    msg = g_strdup_printf ("Started adding partition to '%s'", disk);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    cxt = get_device_context (disk, FALSE, &l_error);
+    if (!cxt) {
+        /* error is already populated */
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
         return NULL;
     }
 
-    status = fdisk_add_partition (cxt, npa, NULL);
+    status = fdisk_get_partitions (cxt, &table);
     if (status != 0) {
         g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
-                     "Failed to add new partition to the table: %s", strerror_l (-status, c_locale));
+                     "Failed to get existing partitions on the device: %s", strerror_l (-status, c_locale));
+        close_context (cxt);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+   }
+
+    npa = add_part (cxt, table, type, start, size, align, &new_extended, &l_error);
+    if (!npa) {
         fdisk_unref_table (table);
-        fdisk_unref_partition (npa);
         close_context (cxt);
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
@@ -1300,12 +1638,8 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
         return NULL;
     }
 
-    if (fdisk_partition_has_partno (npa)) {
-        if (isdigit (disk[strlen (disk) - 1]))
-            ppath = g_strdup_printf ("%sp%zu", disk, fdisk_partition_get_partno (npa) + 1);
-        else
-            ppath = g_strdup_printf ("%s%zu", disk, fdisk_partition_get_partno (npa) + 1);
-    }
+    if (fdisk_partition_has_partno (npa))
+        ppath = get_part_path (disk, fdisk_partition_get_partno (npa));
 
     /* close the context now, we no longer need it */
     fdisk_unref_table (table);
@@ -1323,6 +1657,301 @@ BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64
     return ret;
 }
 
+static gboolean set_part_type (struct fdisk_context *cxt, gint part_num, const gchar *type_str, BDPartTableType table_type, GError **error) {
+    struct fdisk_label *lb = NULL;
+    struct fdisk_partition *pa = NULL;
+    struct fdisk_parttype *ptype = NULL;
+    const gchar *label_name = NULL;
+    gint status = 0;
+    gint part_id_int = 0;
+
+    /* check if part type/id is valid for MBR */
+    if (table_type == BD_PART_TABLE_MSDOS) {
+        part_id_int = g_ascii_strtoull (type_str, NULL, 0);
+
+        if (part_id_int == 0) {
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                         "Invalid partition id given: '%s'.", type_str);
+            return FALSE;
+        }
+
+        if (part_id_int == 0x05 || part_id_int == 0x0f || part_id_int == 0x85) {
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                         "Cannot change partition id to extended.");
+            return FALSE;
+        }
+    }
+
+    lb = fdisk_get_label (cxt, NULL);
+    if (!lb) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to read partition table.");
+        return FALSE;
+    }
+
+    label_name = fdisk_label_get_name (lb);
+    if (g_strcmp0 (label_name, table_type_str[table_type]) != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                     "Setting partition type is not supported on '%s' partition table", label_name);
+        return FALSE;
+    }
+
+    status = fdisk_get_partition (cxt, part_num, &pa);
+    if (status != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                     "Failed to get partition %d.", part_num);
+        return FALSE;
+    }
+
+    ptype = fdisk_label_parse_parttype (lb, type_str);
+    if (!ptype) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                     "Failed to parse partition type.");
+        fdisk_unref_partition (pa);
+        return FALSE;
+    }
+
+    status = fdisk_set_partition_type (cxt, part_num, ptype);
+    if (status != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to set partition type for partition %d.", part_num);
+        fdisk_unref_parttype (ptype);
+        fdisk_unref_partition (pa);
+        return FALSE;
+    }
+
+    fdisk_unref_parttype (ptype);
+    fdisk_unref_partition (pa);
+    return TRUE;
+}
+
+/* sets the GPT name and/or UUID of the partition in the in-memory table of @cxt */
+static gboolean set_part_name_uuid (struct fdisk_context *cxt, gint part_num, const gchar *name, const gchar *uuid, GError **error) {
+    struct fdisk_partition *pa = NULL;
+    gint status = 0;
+
+    status = fdisk_get_partition (cxt, part_num, &pa);
+    if (status != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to get partition %d: %s", part_num, strerror_l (-status, c_locale));
+        return FALSE;
+    }
+
+    if (name) {
+        status = fdisk_partition_set_name (pa, name);
+        if (status != 0) {
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                         "Failed to set name on the partition %d: %s", part_num, strerror_l (-status, c_locale));
+            fdisk_unref_partition (pa);
+            return FALSE;
+        }
+    }
+
+    if (uuid) {
+        status = fdisk_partition_set_uuid (pa, uuid);
+        if (status != 0) {
+            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                         "Failed to set UUID on the partition %d: %s", part_num, strerror_l (-status, c_locale));
+            fdisk_unref_partition (pa);
+            return FALSE;
+        }
+    }
+
+    status = fdisk_set_partition (cxt, part_num, pa);
+    fdisk_unref_partition (pa);
+    if (status != 0) {
+        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to update the partition %d: %s", part_num, strerror_l (-status, c_locale));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_part_create_parts:
+ * @disk: disk to create the partitions on
+ * @parts: (array zero-terminated=1): specifications of the partitions to create
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Creates all the partitions specified by @parts (in the given order) and sets
+ * their GPT names, types and UUIDs (if specified). Unlike with repeated calls
+ * of bd_part_create_part() and bd_part_set_part_*(), the partition table is
+ * written only once and the kernel is informed about the changes only once. If
+ * any of the partitions cannot be created, no changes are written to @disk.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): specifications of the
+ *          created partitions (in the order of @parts) or %NULL in case of error
+ *
+ * NOTE: The resulting partitions may start at different positions than given by
+ *       the specifications and can have different sizes due to alignment.
+ *
+ * Tech category: %BD_PART_TECH_MODE_MODIFY_TABLE + the tech according to the partition table type
+ */
+BDPartSpec** bd_part_create_parts (const gchar *disk, BDPartCreateSpec **parts, GError **error) {
+    struct fdisk_context *cxt = NULL;
+    struct fdisk_table *orig_table = NULL;
+    struct fdisk_table *table = NULL;
+    struct fdisk_partition *npa = NULL;
+    struct fdisk_label *lb = NULL;
+    BDPartCreateSpec **spec_p = NULL;
+    BDPartSpec **disk_parts = NULL;
+    BDPartSpec **part_p = NULL;
+    BDPartSpec **ret = NULL;
+    GPtrArray *paths = NULL;
+    gboolean on_gpt = FALSE;
+    gboolean new_extended = FALSE;
+    gint part_num = 0;
+    gint status = 0;
+    guint num_disk_parts = 0;
+    guint i = 0;
+    guint j = 0;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    msg = g_strdup_printf ("Started adding partitions to '%s'", disk);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    cxt = get_device_context (disk, FALSE, &l_error);
+    if (!cxt) {
+        /* error is already populated */
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    lb = fdisk_get_label (cxt, NULL);
+    if (!lb) {
+        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to read partition table on device '%s'", disk);
+        close_context (cxt);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+    on_gpt = g_strcmp0 (fdisk_label_get_name (lb), table_type_str[BD_PART_TABLE_GPT]) == 0;
+
+    for (spec_p=parts; *spec_p; spec_p++)
+        if (!on_gpt && ((*spec_p)->name || (*spec_p)->uuid || (*spec_p)->type_guid)) {
+            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
+                         "Partition names, types and UUIDs unsupported on the device '%s' ('%s')",
+                         disk, fdisk_label_get_name (lb));
+            close_context (cxt);
+            bd_utils_report_finished (progress_id, l_error->message);
+            g_propagate_error (error, l_error);
+            return NULL;
+        }
+
+    status = fdisk_get_partitions (cxt, &orig_table);
+    if (status != 0) {
+        g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                     "Failed to get existing partitions on the device: %s", strerror_l (-status, c_locale));
+        close_context (cxt);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    paths = g_ptr_array_new_with_free_func (g_free);
+    for (spec_p=parts; *spec_p; spec_p++) {
+        /* the table needs to include the partitions added so far */
+        status = fdisk_get_partitions (cxt, &table);
+        if (status != 0) {
+            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                         "Failed to get existing partitions on the device: %s", strerror_l (-status, c_locale));
+            break;
+        }
+
+        npa = add_part (cxt, table, (*spec_p)->type, (*spec_p)->start, (*spec_p)->size, (*spec_p)->align,
+                        &new_extended, &l_error);
+        fdisk_unref_table (table);
+        table = NULL;
+        if (!npa)
+            break;
+
+        part_num = (gint) fdisk_partition_get_partno (npa);
+        g_ptr_array_add (paths, get_part_path (disk, part_num));
+        fdisk_unref_partition (npa);
+
+        if (((*spec_p)->name || (*spec_p)->uuid) &&
+            !set_part_name_uuid (cxt, part_num, (*spec_p)->name, (*spec_p)->uuid, &l_error))
+            break;
+
+        if ((*spec_p)->type_guid &&
+            !set_part_type (cxt, part_num, (*spec_p)->type_guid, BD_PART_TABLE_GPT, &l_error))
+            break;
+    }
+
+    if (l_error) {
+        g_prefix_error (&l_error, "Failed to create partition %u: ", (guint) (spec_p - parts) + 1);
+        g_ptr_array_free (paths, TRUE);
+        fdisk_unref_table (orig_table);
+        /* nothing written yet so closing the context just drops the changes */
+        close_context (cxt);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    /* for new extended partition we need to force reread whole partition table with
+       libfdisk < 2.36.1 */
+    if (!write_label (cxt, orig_table, disk, new_extended && fdisk_version < 2361, &l_error)) {
+        g_ptr_array_free (paths, TRUE);
+        fdisk_unref_table (orig_table);
+        close_context (cxt);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    fdisk_unref_table (orig_table);
+    close_context (cxt);
+
+    /* read all the new partitions at once */
+    disk_parts = get_disk_parts (disk, TRUE, FALSE, FALSE, &l_error);
+    if (!disk_parts) {
+        g_ptr_array_free (paths, TRUE);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    for (num_disk_parts=0; disk_parts[num_disk_parts]; num_disk_parts++);
+
+    ret = g_new0 (BDPartSpec*, paths->len + 1);
+    for (i=0; !l_error && i < paths->len; i++) {
+        for (j=0; !ret[i] && j < num_disk_parts; j++)
+            if (disk_parts[j] && g_strcmp0 (disk_parts[j]->path, g_ptr_array_index (paths, i)) == 0) {
+                ret[i] = disk_parts[j];
+                disk_parts[j] = NULL;
+            }
+        if (!ret[i])
+            g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
+                         "Failed to get information about the new partition '%s'",
+                         (const gchar *) g_ptr_array_index (paths, i));
+    }
+
+    for (j=0; j < num_disk_parts; j++)
+        bd_part_spec_free (disk_parts[j]);
+    g_free (disk_parts);
+    g_ptr_array_free (paths, TRUE);
+
+    if (l_error) {
+        for (part_p=ret; *part_p; part_p++)
+            bd_part_spec_free (*part_p);
+        g_free (ret);
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return NULL;
+    }
+
+    bd_utils_report_finished (progress_id, "Completed");
+
+    return ret;
+}
+
 /**
  * bd_part_delete_part:
  * @disk: disk to remove the partition from
@@ -1500,7 +2129,6 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
     guint64 max_size = 0;
     guint64 start = 0;
     guint64 end = 0;
-    gint version = 0;
     gchar *msg = NULL;
     GError *l_error = NULL;
 
@@ -1582,6 +2210,8 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
         grain_size = sector_size;
     else if (align == BD_PART_ALIGN_MINIMAL)
         grain_size = (guint64) fdisk_get_minimal_iosize (cxt);
+    else if (align == BD_PART_ALIGN_TOPOLOGY)
+        grain_size = get_topology_grain (cxt, sector_size, grain_size);
     /* else OPTIMAL or unknown -> nothing to do */
 
     if (!get_max_part_size (table, part_num, &max_size, &l_error)) {
@@ -1606,13 +2236,8 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
 
         /* latest libfdisk introduces default end alignment for new partitions, we should
            do the same for resizes where we calculate the size ourselves */
-        version = fdisk_get_library_version (NULL);
-        if (version >= 2380 && align != BD_PART_ALIGN_NONE) {
-            start = fdisk_partition_get_start (pa);
-            end = start + max_size;
-            end = fdisk_align_lba_in_range (cxt, end, start, end);
-            max_size = end - start;
-        }
+        start = fdisk_partition_get_start (pa);
+        max_size = align_part_end (cxt, align, sector_size, grain_size, start, max_size);
 
         if (fdisk_partition_set_size (pa, max_size) != 0) {
             g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
@@ -1625,10 +2250,19 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
             return FALSE;
         }
     } else {
-        /* align size up */
-        if (size % grain_size != 0)
-            size = ((size + grain_size) / grain_size) * grain_size;
-        size = size / sector_size;
+        start = fdisk_partition_get_start (pa);
+        if (align == BD_PART_ALIGN_TOPOLOGY) {
+            /* align the end (not just the size) up */
+            end = start * sector_size + size;
+            if (end % grain_size != 0)
+                end = ((end + grain_size) / grain_size) * grain_size;
+            size = end / sector_size - start;
+        } else {
+            /* align size up */
+            if (size % grain_size != 0)
+                size = ((size + grain_size) / grain_size) * grain_size;
+            size = size / sector_size;
+        }
 
         if (size == old_size) {
             bd_utils_log_format (BD_UTILS_LOG_INFO, "Not resizing, new size after alignment is the same as the old size.");
@@ -1644,7 +2278,7 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
                 bd_utils_log_format (BD_UTILS_LOG_INFO,
                                      "Requested size %"G_GUINT64_FORMAT" is bigger than max size for partition '%s', adjusting to %"G_GUINT64_FORMAT".",
                                      size * sector_size, part, max_size * sector_size);
-                size = max_size;
+                size = align_part_end (cxt, align, sector_size, grain_size, start, max_size);
             } else {
                 g_set_error (&l_error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
                              "Requested size %"G_GUINT64_FORMAT" is bigger than max size (%"G_GUINT64_FORMAT") for partition '%s'",
@@ -1702,74 +2336,6 @@ gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size
     return TRUE;
 }
 
-static gboolean set_part_type (struct fdisk_context *cxt, gint part_num, const gchar *type_str, BDPartTableType table_type, GError **error) {
-    struct fdisk_label *lb = NULL;
-    struct fdisk_partition *pa = NULL;
-    struct fdisk_parttype *ptype = NULL;
-    const gchar *label_name = NULL;
-    gint status = 0;
-    gint part_id_int = 0;
-
-    /* check if part type/id is valid for MBR */
-    if (table_type == BD_PART_TABLE_MSDOS) {
-        part_id_int = g_ascii_strtoull (type_str, NULL, 0);
-
-        if (part_id_int == 0) {
-            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
-                         "Invalid partition id given: '%s'.", type_str);
-            return FALSE;
-        }
-
-        if (part_id_int == 0x05 || part_id_int == 0x0f || part_id_int == 0x85) {
-            g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
-                         "Cannot change partition id to extended.");
-            return FALSE;
-        }
-    }
-
-    lb = fdisk_get_label (cxt, NULL);
-    if (!lb) {
-        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
-                     "Failed to read partition table.");
-        return FALSE;
-    }
-
-    label_name = fdisk_label_get_name (lb);
-    if (g_strcmp0 (label_name, table_type_str[table_type]) != 0) {
-        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
-                     "Setting partition type is not supported on '%s' partition table", label_name);
-        return FALSE;
-    }
-
-    status = fdisk_get_partition (cxt, part_num, &pa);
-    if (status != 0) {
-        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
-                     "Failed to get partition %d.", part_num);
-        return FALSE;
-    }
-
-    ptype = fdisk_label_parse_parttype (lb, type_str);
-    if (!ptype) {
-        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_INVAL,
-                     "Failed to parse partition type.");
-        fdisk_unref_partition (pa);
-        return FALSE;
-    }
-
-    status = fdisk_set_partition_type (cxt, part_num, ptype);
-    if (status != 0) {
-        g_set_error (error, BD_PART_ERROR, BD_PART_ERROR_FAIL,
-                     "Failed to set partition type for partition %d.", part_num);
-        fdisk_unref_parttype (ptype);
-        fdisk_unref_partition (pa);
-        return FALSE;
-    }
-
-    fdisk_unref_parttype (ptype);
-    fdisk_unref_partition (pa);
-    return TRUE;
-}
-
 /**
  * bd_part_set_part_name:
  * @disk: device the partition belongs to
@@ -38,6 +38,7 @@ typedef enum {
     BD_PART_ALIGN_NONE,
     BD_PART_ALIGN_MINIMAL,
     BD_PART_ALIGN_OPTIMAL,
+    BD_PART_ALIGN_TOPOLOGY,
 } BDPartAlign;
 
 typedef struct BDPartSpec {
@@ -56,6 +57,8 @@ typedef struct BDPartSpec {
 BDPartSpec* bd_part_spec_copy (BDPartSpec *data);
 void bd_part_spec_free (BDPartSpec *data);
 
+typedef gboolean (*BDPartSpecFunc) (BDPartSpec *spec, gpointer user_data);
+
 typedef struct BDPartDiskSpec {
     gchar *path;
     BDPartTableType table_type;
@@ -66,6 +69,30 @@ typedef struct BDPartDiskSpec {
 BDPartDiskSpec* bd_part_disk_spec_copy (BDPartDiskSpec *data);
 void bd_part_disk_spec_free (BDPartDiskSpec *data);
 
+typedef struct BDPartDiskParts {
+    gchar *disk;
+    BDPartSpec **parts;
+    GError *error;
+} BDPartDiskParts;
+
+BDPartDiskParts* bd_part_disk_parts_copy (BDPartDiskParts *data);
+void bd_part_disk_parts_free (BDPartDiskParts *data);
+
+typedef struct BDPartCreateSpec {
+    BDPartTypeReq type;
+    guint64 start;
+    guint64 size;
+    BDPartAlign align;
+    gchar *name;
+    gchar *type_guid;
+    gchar *uuid;
+} BDPartCreateSpec;
+
+BDPartCreateSpec* bd_part_create_spec_copy (BDPartCreateSpec *data);
+void bd_part_create_spec_free (BDPartCreateSpec *data);
+BDPartCreateSpec* bd_part_create_spec_new (BDPartTypeReq type, guint64 start, guint64 size, BDPartAlign align,
+                                           const gchar *name, const gchar *type_guid, const gchar *uuid);
+
 typedef enum {
     BD_PART_TECH_MBR = 0,
     BD_PART_TECH_GPT,
@@ -98,10 +125,13 @@ BDPartSpec* bd_part_get_part_spec (const gchar *disk, const gchar *part, GError
 BDPartSpec* bd_part_get_part_by_pos (const gchar *disk, guint64 position, GError **error);
 BDPartDiskSpec* bd_part_get_disk_spec (const gchar *disk, GError **error);
 BDPartSpec** bd_part_get_disk_parts (const gchar *disk, GError **error);
+gboolean bd_part_get_disk_parts_foreach (const gchar *disk, BDPartSpecFunc func, gpointer user_data, GError **error);
+BDPartDiskParts** bd_part_get_disks_parts (const gchar **disks, guint max_workers, GError **error);
 BDPartSpec** bd_part_get_disk_free_regions (const gchar *disk, GError **error);
 BDPartSpec* bd_part_get_best_free_region (const gchar *disk, BDPartType type, guint64 size, GError **error);
 
 BDPartSpec* bd_part_create_part (const gchar *disk, BDPartTypeReq type, guint64 start, guint64 size, BDPartAlign align, GError **error);
+BDPartSpec** bd_part_create_parts (const gchar *disk, BDPartCreateSpec **parts, GError **error);
 gboolean bd_part_delete_part (const gchar *disk, const gchar *part, GError **error);
 gboolean bd_part_resize_part (const gchar *disk, const gchar *part, guint64 size, BDPartAlign align, GError **error);
 
@@ -0,0 +1,501 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <ctype.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include <blockdev/utils.h>
+
+#include "part_reader.h"
+
+/*
+ * A minimal read-only parser of the MBR and GPT partition tables used by the
+ * query functions instead of a full libfdisk context. It only handles the
+ * simple and most common cases -- a valid primary GPT header with valid
+ * partition entries or an MBR without an extended partition. Everything
+ * else (damaged GPT, hybrid setups, logical partitions, other disk labels,
+ * boot sectors of filesystems on whole disks,...) makes part_reader_read()
+ * return %NULL and the callers then fall back to libfdisk, which also takes
+ * care of reporting errors.
+ *
+ * In the common case the whole table is read with a single pread() of the
+ * beginning of the disk which covers the MBR, the GPT header and the default
+ * placement of the GPT partition entries for both 512 and 4096 bytes sectors.
+ */
+
+#define READ_SIZE (32 * 1024)
+/* no sane GPT has more than this in its partition entries array */
+#define MAX_GPT_ENTRIES_SIZE (1024 * 1024)
+
+#define MBR_MAGIC_OFFSET 510
+#define MBR_PARTS_OFFSET 446
+#define MBR_PART_ENTRY_SIZE 16
+#define MBR_NUM_PARTS 4
+#define MBR_GPT_PROTECTIVE 0xee
+
+#define GPT_SIGNATURE "EFI PART"
+#define GPT_HEADER_MIN_SIZE 92
+#define GPT_ENTRY_MIN_SIZE 128
+#define GPT_NAME_OFFSET 56
+#define GPT_NAME_LEN 36
+
+static const guint8 aix_magic[4] = {0xc9, 0xc2, 0xd4, 0xc1};
+
+/* boot sectors of filesystems that have the MBR signature too, a whole disk
+   filesystem is not a partition table (libblkid and libfdisk ignore the DOS
+   label in such cases) */
+static const struct {
+    gsize offset;
+    const gchar *magic;
+} fs_boot_magics[] = {
+    {3, "NTFS    "},
+    {3, "EXFAT   "},
+    {3, "MSDOS"},
+    {3, "MSWIN"},
+    {54, "FAT12   "},
+    {54, "FAT16   "},
+    {82, "FAT32   "},
+};
+
+typedef struct PartEntry {
+    guint part_num;
+    BDPartSpec *spec;
+} PartEntry;
+
+static guint16 get_le16 (const guint8 *buf) {
+    guint16 val;
+
+    memcpy (&val, buf, sizeof (val));
+    return GUINT16_FROM_LE (val);
+}
+
+static guint32 get_le32 (const guint8 *buf) {
+    guint32 val;
+
+    memcpy (&val, buf, sizeof (val));
+    return GUINT32_FROM_LE (val);
+}
+
+static guint64 get_le64 (const guint8 *buf) {
+    guint64 val;
+
+    memcpy (&val, buf, sizeof (val));
+    return GUINT64_FROM_LE (val);
+}
+
+/* the same CRC32 (IEEE 802.3, reflected) as used by the UEFI specification */
+static guint32 crc32 (const guint8 *buf, gsize len, gsize skip_start, gsize skip_len) {
+    guint32 crc = 0xffffffff;
+    guint8 byte = 0;
+    gint bit = 0;
+
+    for (gsize i = 0; i < len; i++) {
+        /* the checksum field itself is taken as zero */
+        byte = (i >= skip_start && i < skip_start + skip_len) ? 0 : buf[i];
+        crc ^= byte;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+
+    return ~crc;
+}
+
+static gchar* guid_to_str (const guint8 *guid) {
+    return g_strdup_printf ("%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+                            get_le32 (guid), get_le16 (guid + 4), get_le16 (guid + 6),
+                            guid[8], guid[9], guid[10], guid[11], guid[12], guid[13], guid[14], guid[15]);
+}
+
+static gboolean guid_is_zero (const guint8 *guid) {
+    for (gint i = 0; i < 16; i++)
+        if (guid[i] != 0)
+            return FALSE;
+    return TRUE;
+}
+
+static gchar* get_gpt_name (const guint8 *buf) {
+    gunichar2 name[GPT_NAME_LEN];
+    glong len = 0;
+
+    for (len = 0; len < GPT_NAME_LEN; len++) {
+        name[len] = get_le16 (buf + 2 * len);
+        if (name[len] == 0)
+            break;
+    }
+
+    return g_utf16_to_utf8 (name, len, NULL, NULL, NULL);
+}
+
+/* the same naming scheme libfdisk uses (see get_part_spec_fdisk() in part.c) */
+static gchar* get_part_path (const gchar *disk, guint part_num) {
+    if (isdigit (disk[strlen (disk) - 1]))
+        return g_strdup_printf ("%sp%u", disk, part_num);
+    else
+        return g_strdup_printf ("%s%u", disk, part_num);
+}
+
+static gboolean read_at (gint fd, guint8 *buf, gsize len, guint64 offset) {
+    gssize ret = 0;
+    gsize done = 0;
+
+    while (done < len) {
+        ret = pread (fd, buf + done, len - done, offset + done);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return FALSE;
+        done += ret;
+    }
+
+    return TRUE;
+}
+
+static gboolean get_disk_geometry (gint fd, guint64 *size, guint64 *sector_size) {
+    struct stat st;
+    gint ssz = 0;
+
+    if (fstat (fd, &st) != 0)
+        return FALSE;
+
+    if (S_ISBLK (st.st_mode)) {
+        if (ioctl (fd, BLKGETSIZE64, size) != 0 || ioctl (fd, BLKSSZGET, &ssz) != 0 || ssz <= 0)
+            return FALSE;
+        *sector_size = (guint64) ssz;
+    } else if (S_ISREG (st.st_mode)) {
+        *size = (guint64) st.st_size;
+        *sector_size = 512;
+    } else
+        return FALSE;
+
+    return TRUE;
+}
+
+static gint part_entry_cmp (gconstpointer a, gconstpointer b) {
+    const PartEntry *entry_a = *((PartEntry **) a);
+    const PartEntry *entry_b = *((PartEntry **) b);
+
+    if (entry_a->spec->start < entry_b->spec->start)
+        return -1;
+    else if (entry_a->spec->start > entry_b->spec->start)
+        return 1;
+    return 0;
+}
+
+static gboolean parts_overlap (GPtrArray *entries) {
+    BDPartSpec *spec_a = NULL;
+    BDPartSpec *spec_b = NULL;
+
+    for (guint i = 0; i < entries->len; i++) {
+        spec_a = ((PartEntry *) g_ptr_array_index (entries, i))->spec;
+        for (guint j = i + 1; j < entries->len; j++) {
+            spec_b = ((PartEntry *) g_ptr_array_index (entries, j))->spec;
+            if (spec_a->start < spec_b->start + spec_b->size && spec_b->start < spec_a->start + spec_a->size)
+                return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static gboolean is_fs_boot_sector (const guint8 *mbr) {
+    for (guint i = 0; i < G_N_ELEMENTS (fs_boot_magics); i++)
+        if (memcmp (mbr + fs_boot_magics[i].offset, fs_boot_magics[i].magic, strlen (fs_boot_magics[i].magic)) == 0)
+            return TRUE;
+    return FALSE;
+}
+
+static gboolean read_mbr_parts (const gchar *disk, const guint8 *mbr, guint64 sector_size, guint64 size,
+                                GPtrArray *entries) {
+    const guint8 *part = NULL;
+    guint8 type = 0;
+    guint32 start = 0;
+    guint32 nsectors = 0;
+    PartEntry *entry = NULL;
+
+    for (guint i = 0; i < MBR_NUM_PARTS; i++) {
+        part = mbr + MBR_PARTS_OFFSET + i * MBR_PART_ENTRY_SIZE;
+        type = part[4];
+        start = get_le32 (part + 8);
+        nsectors = get_le32 (part + 12);
+
+        if (type == 0 && nsectors == 0)
+            /* unused */
+            continue;
+
+        /* logical partitions need more reads (and half-defined entries
+           are better left to libfdisk) */
+        if (type == 0 || nsectors == 0 || type == 0x05 || type == 0x0f || type == 0x85)
+            return FALSE;
+
+        /* only the boot flag is valid here */
+        if (part[0] != 0 && part[0] != 0x80)
+            return FALSE;
+
+        /* the MBR itself can't be part of a partition and garbage (not a
+           partition table) often doesn't fit the disk */
+        if (start == 0 || ((guint64) start + nsectors) * sector_size > size)
+            return FALSE;
+
+        entry = g_new0 (PartEntry, 1);
+        entry->part_num = i + 1;
+        entry->spec = g_new0 (BDPartSpec, 1);
+        entry->spec->path = get_part_path (disk, entry->part_num);
+        entry->spec->id = g_strdup_printf ("0x%02x", type);
+        entry->spec->type = BD_PART_TYPE_NORMAL;
+        entry->spec->start = (guint64) start * sector_size;
+        entry->spec->size = (guint64) nsectors * sector_size;
+        entry->spec->bootable = part[0] == 0x80;
+        g_ptr_array_add (entries, entry);
+    }
+
+    return !parts_overlap (entries);
+}
+
+static gboolean read_gpt_parts (gint fd, const gchar *disk, const guint8 *buf, gsize buf_len, guint64 sector_size,
+                                guint64 size, gboolean read_parts, GPtrArray *entries) {
+    const guint8 *hdr = buf + sector_size;
+    const guint8 *ents = NULL;
+    const guint8 *ent = NULL;
+    guint8 *ents_buf = NULL;
+    guint32 hdr_size = 0;
+    guint64 ents_lba = 0;
+    guint32 num_ents = 0;
+    guint32 ent_size = 0;
+    gsize ents_len = 0;
+    guint64 first_lba = 0;
+    guint64 last_lba = 0;
+    PartEntry *entry = NULL;
+    gboolean ret = TRUE;
+
+    if (buf_len < 2 * sector_size || memcmp (hdr, GPT_SIGNATURE, strlen (GPT_SIGNATURE)) != 0)
+        return FALSE;
+
+    hdr_size = get_le32 (hdr + 12);
+    if (hdr_size < GPT_HEADER_MIN_SIZE || hdr_size > sector_size)
+        return FALSE;
+    if (crc32 (hdr, hdr_size, 16, 4) != get_le32 (hdr + 16))
+        return FALSE;
+    if (get_le64 (hdr + 24) != 1)
+        /* not the primary header */
+        return FALSE;
+
+    if (!read_parts)
+        return TRUE;
+
+    ents_lba = get_le64 (hdr + 72);
+    num_ents = get_le32 (hdr + 80);
+    ent_size = get_le32 (hdr + 84);
+    if (ent_size < GPT_ENTRY_MIN_SIZE || ent_size % 8 != 0 || num_ents == 0 ||
+        (guint64) num_ents * ent_size > MAX_GPT_ENTRIES_SIZE)
+        return FALSE;
+    ents_len = (gsize) num_ents * ent_size;
+
+    if (ents_lba * sector_size + ents_len <= buf_len)
+        ents = buf + ents_lba * sector_size;
+    else {
+        /* not at the usual place, one more read needed */
+        ents_buf = g_malloc (ents_len);
+        if (!read_at (fd, ents_buf, ents_len, ents_lba * sector_size)) {
+            g_free (ents_buf);
+            return FALSE;
+        }
+        ents = ents_buf;
+    }
+
+    if (crc32 (ents, ents_len, 0, 0) != get_le32 (hdr + 88)) {
+        g_free (ents_buf);
+        return FALSE;
+    }
+
+    for (guint32 i = 0; ret && i < num_ents; i++) {
+        ent = ents + (gsize) i * ent_size;
+        if (guid_is_zero (ent))
+            /* unused */
+            continue;
+
+        first_lba = get_le64 (ent + 32);
+        last_lba = get_le64 (ent + 40);
+        if (last_lba < first_lba || last_lba >= size / sector_size) {
+            ret = FALSE;
+            break;
+        }
+
+        entry = g_new0 (PartEntry, 1);
+        entry->part_num = i + 1;
+        entry->spec = g_new0 (BDPartSpec, 1);
+        entry->spec->path = get_part_path (disk, entry->part_num);
+        entry->spec->type_guid = guid_to_str (ent);
+        entry->spec->uuid = guid_to_str (ent + 16);
+        entry->spec->name = get_gpt_name (ent + GPT_NAME_OFFSET);
+        entry->spec->type = BD_PART_TYPE_NORMAL;
+        entry->spec->start = first_lba * sector_size;
+        entry->spec->size = (last_lba - first_lba + 1) * sector_size;
+        entry->spec->attrs = get_le64 (ent + 48);
+        g_ptr_array_add (entries, entry);
+
+        if (!entry->spec->name)
+            /* invalid UTF-16 */
+            ret = FALSE;
+    }
+
+    g_free (ents_buf);
+    return ret;
+}
+
+static void part_entry_free (PartEntry *entry) {
+    bd_part_spec_free (entry->spec);
+    g_free (entry);
+}
+
+/**
+ * part_reader_read: (skip)
+ * @disk: disk to read the partition table from
+ * @read_parts: whether to read the partitions or just the table type
+ *
+ * Returns: (transfer full): partition table of @disk or %NULL if it cannot be
+ *                           read without libfdisk
+ *
+ * Note: The returned table has %BD_PART_TABLE_UNDEF as @table_type if there's no MBR
+ *       signature on the disk at all (and thus no MBR nor GPT). Its @parts are
+ *       never set in such a case because the disk may still contain some other
+ *       table type only libfdisk knows about.
+ */
+PartReaderTable* part_reader_read (const gchar *disk, gboolean read_parts) {
+    PartReaderTable *ret = NULL;
+    GPtrArray *entries = NULL;
+    PartEntry *entry = NULL;
+    guint8 *buf = NULL;
+    gsize buf_len = 0;
+    guint64 size = 0;
+    guint64 sector_size = 0;
+    gboolean protective = FALSE;
+    gboolean success = FALSE;
+    gint fd = -1;
+
+    fd = open (disk, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    if (!get_disk_geometry (fd, &size, &sector_size) || size < sector_size || sector_size < 512) {
+        close (fd);
+        return NULL;
+    }
+
+    buf_len = MIN (MAX (READ_SIZE, 2 * sector_size), size);
+    buf = g_malloc (buf_len);
+    if (!read_at (fd, buf, buf_len, 0)) {
+        g_free (buf);
+        close (fd);
+        return NULL;
+    }
+
+    ret = g_new0 (PartReaderTable, 1);
+    ret->sector_size = sector_size;
+    /* libfdisk only works with whole sectors */
+    ret->size = (size / sector_size) * sector_size;
+
+    if (buf[MBR_MAGIC_OFFSET] != 0x55 || buf[MBR_MAGIC_OFFSET + 1] != 0xaa) {
+        ret->table_type = BD_PART_TABLE_UNDEF;
+        if (read_parts) {
+            part_reader_table_free (ret);
+            ret = NULL;
+        }
+        g_free (buf);
+        close (fd);
+        return ret;
+    }
+
+    if (memcmp (buf, aix_magic, sizeof (aix_magic)) == 0) {
+        g_free (buf);
+        close (fd);
+        g_free (ret);
+        return NULL;
+    }
+
+    for (guint i = 0; !protective && i < MBR_NUM_PARTS; i++)
+        protective = buf[MBR_PARTS_OFFSET + i * MBR_PART_ENTRY_SIZE + 4] == MBR_GPT_PROTECTIVE;
+
+    entries = g_ptr_array_new_with_free_func ((GDestroyNotify) part_entry_free);
+    if (protective) {
+        ret->table_type = BD_PART_TABLE_GPT;
+        success = read_gpt_parts (fd, disk, buf, buf_len, sector_size, ret->size, read_parts, entries);
+    } else {
+        ret->table_type = BD_PART_TABLE_MSDOS;
+        /* the entries are checked even if not requested, the signature alone
+           doesn't mean there's a partition table */
+        success = !is_fs_boot_sector (buf) && read_mbr_parts (disk, buf, sector_size, ret->size, entries);
+    }
+
+    g_free (buf);
+    close (fd);
+
+    if (!success) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG,
+                             "Cannot read the partition table of '%s' directly, falling back to libfdisk", disk);
+        g_ptr_array_free (entries, TRUE);
+        g_free (ret);
+        return NULL;
+    }
+
+    if (read_parts) {
+        g_ptr_array_sort (entries, part_entry_cmp);
+        ret->parts = g_new0 (BDPartSpec *, entries->len + 1);
+        ret->part_nums = g_new0 (guint, entries->len + 1);
+        for (guint i = 0; i < entries->len; i++) {
+            entry = g_ptr_array_index (entries, i);
+            ret->parts[i] = entry->spec;
+            ret->part_nums[i] = entry->part_num;
+            /* now owned by the table */
+            entry->spec = NULL;
+        }
+    }
+    g_ptr_array_free (entries, TRUE);
+
+    return ret;
+}
+
+/**
+ * part_reader_get_part: (skip)
+ * @table: table read by part_reader_read() with partitions
+ * @part_num: number of the partition to get
+ *
+ * Returns: (transfer none): spec of the partition number @part_num or %NULL if
+ *                           there is no such partition in @table
+ */
+BDPartSpec* part_reader_get_part (PartReaderTable *table, guint part_num) {
+    for (guint i = 0; table->parts && table->parts[i]; i++)
+        if (table->part_nums[i] == part_num)
+            return table->parts[i];
+    return NULL;
+}
+
+void part_reader_table_free (PartReaderTable *table) {
+    if (!table)
+        return;
+
+    for (guint i = 0; table->parts && table->parts[i]; i++)
+        bd_part_spec_free (table->parts[i]);
+    g_free (table->parts);
+    g_free (table->part_nums);
+    g_free (table);
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "part.h"
+
+#ifndef BD_PART_READER
+#define BD_PART_READER
+
+typedef struct PartReaderTable {
+    BDPartTableType table_type;
+    guint64 sector_size;
+    guint64 size;
+    /* sorted by start, NULL-terminated, only set if requested */
+    BDPartSpec **parts;
+    /* partition numbers of the items in @parts */
+    guint *part_nums;
+} PartReaderTable;
+
+PartReaderTable* part_reader_read (const gchar *disk, gboolean read_parts);
+BDPartSpec* part_reader_get_part (PartReaderTable *table, guint part_num);
+void part_reader_table_free (PartReaderTable *table);
+
+#endif  /* BD_PART_READER */
@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libdevmapper.h>
+#include <blockdev/utils.h>
+
+#include "pool_monitor.h"
+#include "dm_snapshot.h"
+
+/* Monitoring of the thin and VDO pools usage, the DM map with the thin-pool or
+ * VDO target is resolved only once when the monitor is created (without running
+ * any LVM command) and every sample then means just a single DM_DEVICE_STATUS
+ * call for the map. The event counter of the map is remembered with every
+ * sample so that pool_monitor_wait_event() only waits for new events. */
+
+#define SECTOR_SIZE 512
+/* thin pool metadata blocks are always 4 KiB */
+#define THIN_METADATA_BLOCK_SIZE 4096
+/* VDO always uses 4 KiB blocks */
+#define VDO_BLOCK_SIZE 4096
+
+typedef struct PoolMonitorState {
+    guint64 block_size;
+    guint32 event_nr;
+    gdouble data_threshold;
+    gdouble metadata_threshold;
+    BDLVMPoolThresholdFunc func;
+    gpointer user_data;
+    /* whether the usage was above the thresholds in the previous sample */
+    gboolean data_above;
+    gboolean metadata_above;
+} PoolMonitorState;
+
+/* gets the data block size (in bytes) of the thin pool from its table:
+ * <metadata dev> <data dev> <data block size> <low water mark> ... */
+static guint64 get_thin_pool_block_size (const gchar *map_name) {
+    struct dm_task *task = NULL;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *type = NULL;
+    gchar *params = NULL;
+    gchar **fields = NULL;
+    guint64 block_size = 0;
+
+    task = dm_task_create (DM_DEVICE_TABLE);
+    if (!task)
+        return 0;
+
+    if (dm_task_set_name (task, map_name) == 0 || dm_task_run (task) == 0) {
+        dm_task_destroy (task);
+        return 0;
+    }
+
+    dm_get_next_target (task, NULL, &start, &length, &type, &params);
+    if (g_strcmp0 (type, "thin-pool") == 0 && params) {
+        fields = g_strsplit (params, " ", 4);
+        if (g_strv_length (fields) >= 3)
+            block_size = g_ascii_strtoull (fields[2], NULL, 10) * SECTOR_SIZE;
+        g_strfreev (fields);
+    }
+
+    dm_task_destroy (task);
+    return block_size;
+}
+
+/* VDO status: <device> <operating mode> <in recovery> <index state>
+ * <compression state> <physical blocks used> <total physical blocks> */
+static gboolean parse_vdo_status (const gchar *status, BDLVMPoolUsage *usage) {
+    gchar **fields = NULL;
+
+    fields = g_strsplit (status, " ", -1);
+    if (g_strv_length (fields) < 7) {
+        g_strfreev (fields);
+        return FALSE;
+    }
+
+    usage->data_used = g_ascii_strtoull (fields[5], NULL, 10) * VDO_BLOCK_SIZE;
+    usage->data_total = g_ascii_strtoull (fields[6], NULL, 10) * VDO_BLOCK_SIZE;
+    usage->read_only = g_strcmp0 (fields[1], "read-only") == 0;
+    usage->out_of_space = usage->data_total > 0 && usage->data_used >= usage->data_total;
+
+    g_strfreev (fields);
+    return TRUE;
+}
+
+static gboolean parse_thin_pool_status (const gchar *status, guint64 block_size, BDLVMPoolUsage *usage) {
+    struct dm_pool *pool = NULL;
+    struct dm_status_thin_pool *thin_status = NULL;
+
+    pool = dm_pool_create ("bd-pool", 20);
+    if (dm_get_status_thin_pool (pool, status, &thin_status) == 0 || thin_status->fail) {
+        dm_pool_destroy (pool);
+        return FALSE;
+    }
+
+    usage->data_used = thin_status->used_data_blocks * block_size;
+    usage->data_total = thin_status->total_data_blocks * block_size;
+    usage->metadata_used = thin_status->used_metadata_blocks * THIN_METADATA_BLOCK_SIZE;
+    usage->metadata_total = thin_status->total_metadata_blocks * THIN_METADATA_BLOCK_SIZE;
+    usage->read_only = thin_status->read_only;
+    usage->out_of_space = thin_status->out_of_data_space;
+
+    dm_pool_destroy (pool);
+    return TRUE;
+}
+
+static gdouble usage_percent (guint64 used, guint64 total) {
+    return total > 0 ? (gdouble) used * 100.0 / (gdouble) total : 0.0;
+}
+
+/* reads the current usage of the pool, @event_nr is set to the event counter
+ * of the map */
+static BDLVMPoolUsage* read_usage (const gchar *map_name, gboolean vdo, guint64 block_size,
+                                   guint32 *event_nr, GError **error) {
+    DMSnapshotMap *map = NULL;
+    BDLVMPoolUsage *usage = NULL;
+    gboolean success = FALSE;
+
+    map = dm_snapshot_map_status (map_name);
+    if (!map) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
+                     "The pool map '%s' doesn't exist", map_name);
+        return NULL;
+    }
+
+    if (g_strcmp0 (map->target_type, vdo ? "vdo" : "thin-pool") != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
+                     "The map '%s' is not a %s pool map", map_name, vdo ? "VDO" : "thin");
+        dm_snapshot_map_free (map);
+        return NULL;
+    }
+
+    usage = g_new0 (BDLVMPoolUsage, 1);
+    usage->vdo = vdo;
+    if (vdo)
+        success = parse_vdo_status (map->status, usage);
+    else
+        success = parse_thin_pool_status (map->status, block_size, usage);
+    if (!success) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                     "Failed to get status of the pool map '%s'", map_name);
+        dm_snapshot_map_free (map);
+        g_free (usage);
+        return NULL;
+    }
+
+    usage->data_percent = usage_percent (usage->data_used, usage->data_total);
+    usage->metadata_percent = usage_percent (usage->metadata_used, usage->metadata_total);
+    *event_nr = map->event_nr;
+
+    dm_snapshot_map_free (map);
+    return usage;
+}
+
+BDLVMPoolMonitor* pool_monitor_new (const gchar *vg_name, const gchar *pool_name, GError **error) {
+    /* the pool target is in the "-tpool"/"-vpool" layer of the pool LV if it
+       is used by other LVs, in the top-level map otherwise */
+    const gchar *layers[] = {"tpool", "vpool", NULL};
+    struct dm_pool *pool = NULL;
+    DMSnapshotMap *map = NULL;
+    BDLVMPoolMonitor *monitor = NULL;
+    PoolMonitorState *state = NULL;
+    BDLVMPoolUsage *usage = NULL;
+    gchar *map_name = NULL;
+    gboolean vdo = FALSE;
+    guint64 block_size = 0;
+    guint32 event_nr = 0;
+    guint i = 0;
+
+    if (geteuid () != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOT_ROOT,
+                     "Not running as root, cannot query DM maps");
+        return NULL;
+    }
+
+    pool = dm_pool_create ("bd-pool", 20);
+    for (i = 0; i < G_N_ELEMENTS (layers); i++) {
+        map_name = dm_build_dm_name (pool, vg_name, pool_name, layers[i]);
+        map = map_name ? dm_snapshot_map_status (map_name) : NULL;
+        if (map && (g_strcmp0 (map->target_type, "thin-pool") == 0 || g_strcmp0 (map->target_type, "vdo") == 0))
+            break;
+        if (map)
+            dm_snapshot_map_free (map);
+        map = NULL;
+    }
+
+    if (!map) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
+                     "Failed to find an active thin or VDO pool map for '%s/%s'", vg_name, pool_name);
+        dm_pool_destroy (pool);
+        return NULL;
+    }
+
+    map_name = g_strdup (map->name);
+    vdo = g_strcmp0 (map->target_type, "vdo") == 0;
+    dm_snapshot_map_free (map);
+    dm_pool_destroy (pool);
+
+    if (!vdo) {
+        block_size = get_thin_pool_block_size (map_name);
+        if (block_size == 0) {
+            g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_PARSE,
+                         "Failed to get the block size of the thin pool map '%s'", map_name);
+            g_free (map_name);
+            return NULL;
+        }
+    }
+
+    /* take the first status to check it can be parsed and to get the current
+       event counter */
+    usage = read_usage (map_name, vdo, block_size, &event_nr, error);
+    if (!usage) {
+        g_free (map_name);
+        return NULL;
+    }
+    bd_lvm_pool_usage_free (usage);
+
+    state = g_new0 (PoolMonitorState, 1);
+    state->block_size = block_size;
+    state->event_nr = event_nr;
+
+    monitor = g_new0 (BDLVMPoolMonitor, 1);
+    monitor->vg_name = g_strdup (vg_name);
+    monitor->pool_name = g_strdup (pool_name);
+    monitor->map_name = map_name;
+    monitor->vdo = vdo;
+    monitor->ref_count = 1;
+    g_mutex_init (&(monitor->lock));
+    monitor->priv = state;
+
+    return monitor;
+}
+
+static gboolean threshold_crossed (gdouble threshold, gdouble percent, gboolean *above) {
+    gboolean was_above = *above;
+
+    if (threshold <= 0.0) {
+        *above = FALSE;
+        return FALSE;
+    }
+
+    *above = percent >= threshold;
+    return *above && !was_above;
+}
+
+BDLVMPoolUsage* pool_monitor_sample (BDLVMPoolMonitor *monitor, GError **error) {
+    PoolMonitorState *state = NULL;
+    BDLVMPoolUsage *usage = NULL;
+    BDLVMPoolThresholdFunc func = NULL;
+    gpointer user_data = NULL;
+    gboolean crossed = FALSE;
+    guint32 event_nr = 0;
+
+    g_mutex_lock (&(monitor->lock));
+    state = (PoolMonitorState *) monitor->priv;
+    usage = read_usage (monitor->map_name, monitor->vdo, state->block_size, &event_nr, error);
+    if (!usage) {
+        g_mutex_unlock (&(monitor->lock));
+        return NULL;
+    }
+    state->event_nr = event_nr;
+
+    /* both need to be evaluated to keep track of the state */
+    crossed = threshold_crossed (state->data_threshold, usage->data_percent, &(state->data_above));
+    crossed = threshold_crossed (state->metadata_threshold, usage->metadata_percent, &(state->metadata_above)) || crossed;
+    func = state->func;
+    user_data = state->user_data;
+    g_mutex_unlock (&(monitor->lock));
+
+    /* the callback is called without the lock so that it can use the monitor */
+    if (crossed && func)
+        func (monitor, usage, user_data);
+
+    return usage;
+}
+
+gboolean pool_monitor_set_thresholds (BDLVMPoolMonitor *monitor, gdouble data_percent, gdouble metadata_percent,
+                                      BDLVMPoolThresholdFunc func, gpointer user_data, GError **error) {
+    PoolMonitorState *state = NULL;
+
+    if (data_percent < 0.0 || data_percent > 100.0 || metadata_percent < 0.0 || metadata_percent > 100.0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid usage thresholds %.2f%% and %.2f%%, need to be between 0 and 100",
+                     data_percent, metadata_percent);
+        return FALSE;
+    }
+
+    g_mutex_lock (&(monitor->lock));
+    state = (PoolMonitorState *) monitor->priv;
+    state->data_threshold = data_percent;
+    state->metadata_threshold = metadata_percent;
+    state->func = func;
+    state->user_data = user_data;
+    /* start over, the next sample above the new thresholds is reported */
+    state->data_above = FALSE;
+    state->metadata_above = FALSE;
+    g_mutex_unlock (&(monitor->lock));
+
+    return TRUE;
+}
+
+gboolean pool_monitor_wait_event (BDLVMPoolMonitor *monitor, GError **error) {
+    PoolMonitorState *state = NULL;
+    struct dm_task *task = NULL;
+    struct dm_info info;
+    guint32 event_nr = 0;
+
+    g_mutex_lock (&(monitor->lock));
+    state = (PoolMonitorState *) monitor->priv;
+    event_nr = state->event_nr;
+    g_mutex_unlock (&(monitor->lock));
+
+    /* the lock is not held while waiting, the wait may take very long */
+    task = dm_task_create (DM_DEVICE_WAITEVENT);
+    if (!task) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to create DM task");
+        return FALSE;
+    }
+
+    if (dm_task_set_name (task, monitor->map_name) == 0 ||
+        dm_task_set_event_nr (task, event_nr) == 0 ||
+        dm_task_run (task) == 0 ||
+        dm_task_get_info (task, &info) == 0 ||
+        !info.exists) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to wait for an event of the pool map '%s'", monitor->map_name);
+        dm_task_destroy (task);
+        return FALSE;
+    }
+    dm_task_destroy (task);
+
+    g_mutex_lock (&(monitor->lock));
+    if (info.event_nr > state->event_nr)
+        state->event_nr = info.event_nr;
+    g_mutex_unlock (&(monitor->lock));
+
+    return TRUE;
+}
+
+void bd_lvm_pool_monitor_free (BDLVMPoolMonitor *monitor) {
+    if (monitor == NULL)
+        return;
+
+    if (!g_atomic_int_dec_and_test (&(monitor->ref_count)))
+        return;
+
+    g_free (monitor->vg_name);
+    g_free (monitor->pool_name);
+    g_free (monitor->map_name);
+    g_free (monitor->priv);
+    g_mutex_clear (&(monitor->lock));
+    g_free (monitor);
+}
+
+BDLVMPoolMonitor* bd_lvm_pool_monitor_copy (BDLVMPoolMonitor *monitor) {
+    if (monitor == NULL)
+        return NULL;
+
+    g_atomic_int_inc (&(monitor->ref_count));
+    return monitor;
+}
+
+void bd_lvm_pool_usage_free (BDLVMPoolUsage *usage) {
+    g_free (usage);
+}
+
+BDLVMPoolUsage* bd_lvm_pool_usage_copy (BDLVMPoolUsage *usage) {
+    BDLVMPoolUsage *new_usage = NULL;
+
+    if (usage == NULL)
+        return NULL;
+
+    new_usage = g_new0 (BDLVMPoolUsage, 1);
+    *new_usage = *usage;
+
+    return new_usage;
+}
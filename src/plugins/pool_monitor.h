@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "lvm.h"
+
+#ifndef BD_POOL_MONITOR
+#define BD_POOL_MONITOR
+
+BDLVMPoolMonitor* pool_monitor_new (const gchar *vg_name, const gchar *pool_name, GError **error);
+BDLVMPoolUsage* pool_monitor_sample (BDLVMPoolMonitor *monitor, GError **error);
+gboolean pool_monitor_set_thresholds (BDLVMPoolMonitor *monitor, gdouble data_percent, gdouble metadata_percent,
+                                      BDLVMPoolThresholdFunc func, gpointer user_data, GError **error);
+gboolean pool_monitor_wait_event (BDLVMPoolMonitor *monitor, GError **error);
+
+#endif  /* BD_POOL_MONITOR */
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <libdevmapper.h>
+#include <blockdev/utils.h>
+
+#include "pvmove_job.h"
+
+/* Progress of the background 'pvmove' operations taken directly from the DM
+ * maps of the temporary pvmove LVs ("<VG>-pvmove<N>"). LVM moves the segments
+ * one after another, the table of the pvmove LV has a mirror target for the
+ * segment being moved (with its sync ratio in the status) and linear targets
+ * for the other segments -- mapped to the source PV if they haven't been moved
+ * yet, to the destination PV(s) otherwise. */
+
+#define MIRROR_THROTTLE_PARAM "/sys/module/dm_mirror/parameters/raid1_resync_throttle"
+
+BDLVMPVMoveJob* pvmove_job_new (const gchar *src, const gchar *dest, const gchar *vg_name, GError **error) {
+    BDLVMPVMoveJob *job = NULL;
+    struct stat st;
+
+    if (stat (src, &st) != 0 || !S_ISBLK (st.st_mode)) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_NOEXIST,
+                     "The source PV '%s' is not a block device", src);
+        return NULL;
+    }
+
+    job = g_new0 (BDLVMPVMoveJob, 1);
+    job->src = g_strdup (src);
+    job->dest = g_strdup (dest);
+    job->vg_name = g_strdup (vg_name);
+    job->src_devno = (guint64) st.st_rdev;
+    job->ref_count = 1;
+
+    return job;
+}
+
+/* gets the tables and the statuses of the all the pvmove maps in the VG, the
+ * items of @tables and @statuses are the tasks with the results */
+static gboolean get_pvmove_maps (const gchar *vg_name, GPtrArray *tables, GPtrArray *statuses, GError **error) {
+    struct dm_task *task_names = NULL;
+    struct dm_task *task = NULL;
+    struct dm_names *names = NULL;
+    struct dm_pool *pool = NULL;
+    const gchar *prefix = NULL;
+    const gchar *suffix = NULL;
+    gsize prefix_len = 0;
+    guint64 next = 0;
+    gint task_types[2] = {DM_DEVICE_TABLE, DM_DEVICE_STATUS};
+    GPtrArray *results[2] = {tables, statuses};
+    guint i = 0;
+
+    task_names = dm_task_create (DM_DEVICE_LIST);
+    if (!task_names || dm_task_run (task_names) == 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_DM_ERROR,
+                     "Failed to list DM maps");
+        if (task_names)
+            dm_task_destroy (task_names);
+        return FALSE;
+    }
+
+    pool = dm_pool_create ("bd-pool", 20);
+    prefix = dm_build_dm_name (pool, vg_name, "pvmove", NULL);
+    prefix_len = strlen (prefix);
+
+    names = dm_task_get_names (task_names);
+    if (names && names->dev) {
+        do {
+            names = (void *)names + next;
+            next = names->next;
+
+            if (strncmp (names->name, prefix, prefix_len) != 0)
+                continue;
+            for (suffix = names->name + prefix_len; g_ascii_isdigit (*suffix); suffix++);
+            if (*suffix != '\0')
+                continue;
+
+            for (i = 0; i < 2; i++) {
+                task = dm_task_create (task_types[i]);
+                if (!task)
+                    break;
+                if (dm_task_set_name (task, names->name) == 0 || dm_task_run (task) == 0) {
+                    /* the move may have finished in the meantime */
+                    dm_task_destroy (task);
+                    break;
+                }
+                g_ptr_array_add (results[i], task);
+            }
+            /* keep the two arrays in sync */
+            if (i == 1)
+                g_ptr_array_remove_index (tables, tables->len - 1);
+        } while (next);
+    }
+
+    dm_pool_destroy (pool);
+    dm_task_destroy (task_names);
+    return TRUE;
+}
+
+/* mirror status: <#devs> <dev>... <in sync>/<total regions> <#health> <health> ... */
+static gdouble mirror_sync_ratio (const gchar *status) {
+    gchar **fields = NULL;
+    guint64 n_devs = 0;
+    guint64 in_sync = 0;
+    guint64 total = 0;
+    gdouble ratio = 0.0;
+
+    fields = g_strsplit (status, " ", -1);
+    n_devs = g_ascii_strtoull (fields[0] ? fields[0] : "0", NULL, 10);
+    if (n_devs + 1 < g_strv_length (fields) &&
+        sscanf (fields[n_devs + 1], "%"G_GUINT64_FORMAT"/%"G_GUINT64_FORMAT, &in_sync, &total) == 2 &&
+        total > 0)
+        ratio = (gdouble) in_sync / (gdouble) total;
+
+    g_strfreev (fields);
+    return ratio;
+}
+
+/* whether @params of a target reference the @devno device ("major:minor") */
+static gboolean refs_device (const gchar *params, const gchar *devno) {
+    gchar **fields = NULL;
+    gchar **field_p = NULL;
+    gboolean ret = FALSE;
+
+    fields = g_strsplit (params, " ", -1);
+    for (field_p = fields; *field_p && !ret; field_p++)
+        ret = g_strcmp0 (*field_p, devno) == 0;
+    g_strfreev (fields);
+
+    return ret;
+}
+
+gboolean pvmove_job_get_progress (BDLVMPVMoveJob *job, gdouble *progress, GError **error) {
+    GPtrArray *tables = g_ptr_array_new_with_free_func ((GDestroyNotify) dm_task_destroy);
+    GPtrArray *statuses = g_ptr_array_new_with_free_func ((GDestroyNotify) dm_task_destroy);
+    g_autofree gchar *src_devno = NULL;
+    gpointer table_next = NULL;
+    gpointer status_next = NULL;
+    guint64 start = 0;
+    guint64 length = 0;
+    gchar *type = NULL;
+    gchar *params = NULL;
+    gchar *status_type = NULL;
+    gchar *status = NULL;
+    gdouble done = 0.0;
+    gdouble total = 0.0;
+    gdouble map_done = 0.0;
+    gdouble map_total = 0.0;
+    gboolean map_of_job = FALSE;
+    guint i = 0;
+
+    if (!get_pvmove_maps (job->vg_name, tables, statuses, error)) {
+        g_ptr_array_free (tables, TRUE);
+        g_ptr_array_free (statuses, TRUE);
+        return FALSE;
+    }
+
+    src_devno = g_strdup_printf ("%u:%u", major ((dev_t) job->src_devno), minor ((dev_t) job->src_devno));
+    for (i = 0; i < tables->len; i++) {
+        map_done = 0.0;
+        map_total = 0.0;
+        map_of_job = FALSE;
+        table_next = NULL;
+        status_next = NULL;
+        do {
+            table_next = dm_get_next_target (tables->pdata[i], table_next, &start, &length, &type, &params);
+            status_next = dm_get_next_target (statuses->pdata[i], status_next, &start, &length, &status_type, &status);
+            if (!type || !params)
+                continue;
+
+            map_total += length;
+            if (g_strcmp0 (type, "mirror") == 0) {
+                map_of_job = map_of_job || refs_device (params, src_devno);
+                if (g_strcmp0 (status_type, "mirror") == 0 && status)
+                    map_done += length * mirror_sync_ratio (status);
+            } else if (refs_device (params, src_devno))
+                /* not moved yet */
+                map_of_job = TRUE;
+            else
+                map_done += length;
+        } while (table_next);
+
+        /* other moves (from other PVs) may be running in the same VG */
+        if (map_of_job) {
+            done += map_done;
+            total += map_total;
+        }
+    }
+
+    g_ptr_array_free (tables, TRUE);
+    g_ptr_array_free (statuses, TRUE);
+
+    /* no pvmove map for the source PV means the move is not running anymore */
+    *progress = total > 0 ? done * 100.0 / total : 100.0;
+    return TRUE;
+}
+
+gboolean pvmove_set_throttle (guint percent, GError **error) {
+    g_autofree gchar *value = NULL;
+
+    if (percent == 0 || percent > 100) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid throttle %u%%, needs to be between 1 and 100", percent);
+        return FALSE;
+    }
+
+    /* pvmove uses the mirror target, make sure the module (and so the parameter) is there */
+    if (!g_file_test (MIRROR_THROTTLE_PARAM, G_FILE_TEST_EXISTS) &&
+        !bd_utils_load_kernel_module ("dm_mirror", NULL, error)) {
+        g_prefix_error (error, "Failed to load the dm_mirror kernel module: ");
+        return FALSE;
+    }
+
+    value = g_strdup_printf ("%u", percent);
+    if (!bd_utils_echo_str_to_file (value, MIRROR_THROTTLE_PARAM, error)) {
+        g_prefix_error (error, "Failed to set the pvmove throttle: ");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void bd_lvm_pvmove_job_free (BDLVMPVMoveJob *job) {
+    if (job == NULL)
+        return;
+
+    if (!g_atomic_int_dec_and_test (&(job->ref_count)))
+        return;
+
+    g_free (job->src);
+    g_free (job->dest);
+    g_free (job->vg_name);
+    g_free (job);
+}
+
+BDLVMPVMoveJob* bd_lvm_pvmove_job_copy (BDLVMPVMoveJob *job) {
+    if (job == NULL)
+        return NULL;
+
+    g_atomic_int_inc (&(job->ref_count));
+    return job;
+}
@@ -22,14 +22,17 @@
 #include <linux/fs.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <blockdev/utils.h>
 #include <asm/dasd.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/sysmacros.h>
 
 #include "s390.h"
 #include "check_deps.h"
+#include "../utils/parallel.h"
 
 /**
  * SECTION: s390
@@ -48,6 +51,79 @@ GQuark bd_s390_error_quark (void) {
 }
 
 
+/**
+ * bd_s390_dasd_result_copy: (skip)
+ * @data: (nullable): %BDS390DasdResult to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDS390DasdResult* bd_s390_dasd_result_copy (BDS390DasdResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDS390DasdResult *new_data = g_new0 (BDS390DasdResult, 1);
+
+    new_data->dasd = g_strdup (data->dasd);
+    new_data->success = data->success;
+    new_data->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return new_data;
+}
+
+/**
+ * bd_s390_dasd_result_free: (skip)
+ * @data: (nullable): %BDS390DasdResult to free
+ *
+ * Frees @data.
+ */
+void bd_s390_dasd_result_free (BDS390DasdResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->dasd);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+/**
+ * bd_s390_zfcp_result_copy: (skip)
+ * @data: (nullable): %BDS390ZfcpResult to copy
+ *
+ * Creates a new copy of @data.
+ */
+BDS390ZfcpResult* bd_s390_zfcp_result_copy (BDS390ZfcpResult *data) {
+    if (data == NULL)
+        return NULL;
+
+    BDS390ZfcpResult *new_data = g_new0 (BDS390ZfcpResult, 1);
+
+    new_data->devno = g_strdup (data->devno);
+    new_data->wwpn = g_strdup (data->wwpn);
+    new_data->lun = g_strdup (data->lun);
+    new_data->success = data->success;
+    new_data->error = data->error ? g_error_copy (data->error) : NULL;
+
+    return new_data;
+}
+
+/**
+ * bd_s390_zfcp_result_free: (skip)
+ * @data: (nullable): %BDS390ZfcpResult to free
+ *
+ * Frees @data.
+ */
+void bd_s390_zfcp_result_free (BDS390ZfcpResult *data) {
+    if (data == NULL)
+        return;
+
+    g_free (data->devno);
+    g_free (data->wwpn);
+    g_free (data->lun);
+    g_clear_error (&(data->error));
+    g_free (data);
+}
+
+
 static volatile guint avail_deps = 0;
 static GMutex deps_check_lock;
 
@@ -135,6 +211,206 @@ gboolean bd_s390_dasd_format (const gchar *dasd, const BDExtraArg **extra, GErro
     return rc;
 }
 
+typedef struct DasdBatch {
+    GMutex lock;
+    guint64 progress_id;
+    const gchar *action;
+    guint n_items;
+    guint n_done;
+    guint n_failed;
+    /* per-device completion and the sum of them */
+    guint8 *completions;
+    guint64 total;
+    guint8 reported;
+} DasdBatch;
+
+typedef struct DasdTask {
+    DasdBatch *batch;
+    guint idx;
+    BDS390DasdResult *result;
+    const BDExtraArg **extra;
+} DasdTask;
+
+/* task the current (worker) thread is running, used to aggregate the
+   progress extracted from the dasdfmt output */
+static GPrivate current_task = G_PRIVATE_INIT (NULL);
+
+static void batch_report (DasdBatch *batch, guint idx, guint8 completion, const gchar *msg) {
+    guint8 overall = 0;
+
+    g_mutex_lock (&(batch->lock));
+    if (completion > batch->completions[idx]) {
+        batch->total += completion - batch->completions[idx];
+        batch->completions[idx] = completion;
+    }
+    overall = (guint8) (batch->total / batch->n_items);
+    if (overall > batch->reported || msg) {
+        batch->reported = MAX (overall, batch->reported);
+        bd_utils_report_progress (batch->progress_id, batch->reported, msg);
+    }
+    g_mutex_unlock (&(batch->lock));
+}
+
+static void batch_task_done (DasdTask *task) {
+    DasdBatch *batch = task->batch;
+    BDS390DasdResult *result = task->result;
+    gchar *msg = NULL;
+
+    g_mutex_lock (&(batch->lock));
+    batch->n_done++;
+    if (!result->success)
+        batch->n_failed++;
+    if (result->success)
+        msg = g_strdup_printf ("Finished %s '%s' (%u of %u done)", batch->action,
+                               result->dasd, batch->n_done, batch->n_items);
+    else
+        msg = g_strdup_printf ("Failed %s '%s' (%u of %u done): %s", batch->action,
+                               result->dasd, batch->n_done, batch->n_items,
+                               result->error ? result->error->message : "unknown error");
+    g_mutex_unlock (&(batch->lock));
+
+    batch_report (batch, task->idx, 100, msg);
+    g_free (msg);
+}
+
+/* Runs @func for every DASD from @dasds in a pool of (at most) @max_workers
+ * threads, reporting the aggregated progress of all of them as a single task.
+ */
+static BDS390DasdResult** run_dasd_batch (const gchar **dasds, guint max_workers, const BDExtraArg **extra,
+                                          GFunc func, const gchar *action) {
+    DasdBatch batch;
+    DasdTask *tasks = NULL;
+    BDS390DasdResult **results = NULL;
+    gchar *msg = NULL;
+    guint n_items = 0;
+    guint i = 0;
+
+    n_items = g_strv_length ((gchar **) dasds);
+    results = g_new0 (BDS390DasdResult*, n_items + 1);
+    if (n_items == 0)
+        return results;
+
+    memset (&batch, 0, sizeof (batch));
+    g_mutex_init (&(batch.lock));
+    batch.action = action;
+    batch.n_items = n_items;
+    batch.completions = g_new0 (guint8, n_items);
+
+    msg = g_strdup_printf ("Started %s %u DASDs", action, n_items);
+    batch.progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    tasks = g_new0 (DasdTask, n_items);
+    for (i = 0; i < n_items; i++) {
+        results[i] = g_new0 (BDS390DasdResult, 1);
+        results[i]->dasd = g_strdup (dasds[i]);
+        tasks[i].batch = &batch;
+        tasks[i].idx = i;
+        tasks[i].result = results[i];
+        tasks[i].extra = extra;
+    }
+
+    bd_utils_parallel_run_array (func, tasks, sizeof (DasdTask), n_items, max_workers, NULL);
+
+    if (batch.n_failed == 0)
+        bd_utils_report_finished (batch.progress_id, "Completed");
+    else {
+        msg = g_strdup_printf ("Failed %s %u of %u DASDs", action, batch.n_failed, n_items);
+        bd_utils_report_finished (batch.progress_id, msg);
+        g_free (msg);
+    }
+
+    g_free (tasks);
+    g_free (batch.completions);
+    g_mutex_clear (&(batch.lock));
+
+    return results;
+}
+
+static gboolean extract_dasdfmt_progress (const gchar *line, guint8 *completion) {
+    const gchar *bar = NULL;
+    gchar *end = NULL;
+    guint64 perc = 0;
+    DasdTask *task = NULL;
+
+    /* with '-P' dasdfmt prints 'cyl <N> of <M> |<P>%' for every formatted cylinder */
+    while (g_ascii_isspace (*line))
+        line++;
+    if (!g_str_has_prefix (line, "cyl "))
+        return FALSE;
+
+    bar = strchr (line, '|');
+    if (!bar)
+        return FALSE;
+
+    perc = g_ascii_strtoull (bar + 1, &end, 10);
+    if (end == bar + 1 || *end != '%' || perc > 100)
+        return FALSE;
+
+    *completion = (guint8) perc;
+
+    task = g_private_get (&current_task);
+    if (task)
+        batch_report (task->batch, task->idx, *completion, NULL);
+
+    return TRUE;
+}
+
+static void format_dasd_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    DasdTask *task = (DasdTask *) data;
+    BDS390DasdResult *result = task->result;
+    const gchar *argv[9] = {"dasdfmt", "-y", "-P", "-d", "cdl", "-b", "4096", NULL, NULL};
+    gint status = 0;
+
+    argv[7] = g_strdup_printf ("/dev/%s", result->dasd);
+
+    g_private_set (&current_task, task);
+    result->success = bd_utils_exec_and_report_progress (argv, task->extra, extract_dasdfmt_progress,
+                                                         &status, &(result->error));
+    g_private_set (&current_task, NULL);
+    g_free ((gchar *) argv[7]);
+
+    batch_task_done (task);
+}
+
+/**
+ * bd_s390_dasd_format_many:
+ * @dasds: (array zero-terminated=1): dasds to format
+ * @max_workers: maximum number of dasds to format in parallel or 0 for the
+ *               default (number of CPUs)
+ * @extra: (nullable) (array zero-terminated=1): extra options for the formatting (right now
+ *                                                 passed to every 'dasdfmt' call)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Formats all the @dasds the same way bd_s390_dasd_format() does, running
+ * up to @max_workers 'dasdfmt' processes in parallel. The progress of all
+ * the formatting processes is aggregated and reported as a single task
+ * (together with a message whenever one of the @dasds is done). A failure to
+ * format one of the @dasds doesn't affect the other ones, it is reported in
+ * the #BDS390DasdResult.error field of the particular entry.
+ *
+ * Note: 'dasdfmt' is run with the '-P' option to get the progress information,
+ *       @extra must not contain any other progress option ('-p', '-m').
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the formatting (one entry
+ *                                                     per dasd in @dasds, in the same order)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_S390_TECH_DASD-%BD_S390_TECH_MODE_MODIFY
+ */
+BDS390DasdResult** bd_s390_dasd_format_many (const gchar **dasds, guint max_workers, const BDExtraArg **extra, GError **error) {
+    if (!dasds) {
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+                     "No DASDs specified");
+        return NULL;
+    }
+
+    if (!check_deps (&avail_deps, DEPS_DASDFMT_MASK, deps, DEPS_LAST, &deps_check_lock, error))
+        return NULL;
+
+    return run_dasd_batch (dasds, max_workers, extra, format_dasd_thread, "formatting");
+}
+
 /**
  * bd_s390_dasd_needs_format:
  * @dasd: dasd to check, given as device number
@@ -271,6 +547,45 @@ gboolean bd_s390_dasd_online (const gchar *dasd, GError **error) {
     return TRUE;
 }
 
+static void online_dasd_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    DasdTask *task = (DasdTask *) data;
+    BDS390DasdResult *result = task->result;
+
+    result->success = bd_s390_dasd_online (result->dasd, &(result->error));
+
+    batch_task_done (task);
+}
+
+/**
+ * bd_s390_dasd_online_many:
+ * @dasds: (array zero-terminated=1): dasds to switch online, given as device numbers
+ * @max_workers: maximum number of dasds to switch online in parallel or 0 for
+ *               the default (number of CPUs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Switches all the @dasds online the same way bd_s390_dasd_online() does,
+ * up to @max_workers of them in parallel (the kernel blocks the write to the
+ * 'online' attribute until the device is ready so this is where the time is
+ * spent). A failure to switch one of the @dasds online doesn't affect the
+ * other ones, it is reported in the #BDS390DasdResult.error field of the
+ * particular entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the operation (one entry
+ *                                                     per dasd in @dasds, in the same order)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_S390_TECH_DASD-%BD_S390_TECH_MODE_MODIFY
+ */
+BDS390DasdResult** bd_s390_dasd_online_many (const gchar **dasds, guint max_workers, GError **error) {
+    if (!dasds) {
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+                     "No DASDs specified");
+        return NULL;
+    }
+
+    return run_dasd_batch (dasds, max_workers, NULL, online_dasd_thread, "switching online");
+}
+
 /**
  * bd_s390_dasd_is_ldl:
  * @dasd: dasd to check, whether it is LDL formatted
@@ -537,37 +852,17 @@ gchar* bd_s390_zfcp_sanitize_lun_input (const gchar *lun, GError **error) {
     return fulllun;
 }
 
-/**
- * bd_s390_zfcp_online:
- * @devno: zfcp device number
- * @wwpn: zfcp WWPN (World Wide Port Number)
- * @lun: zfcp LUN (Logical Unit Number)
- * @error: (out) (optional): place to store error (if any)
- *
- * Returns: whether a zfcp device was successfully switched online
- *
- * Tech category: %BD_S390_TECH_ZFCP-%BD_S390_TECH_MODE_MODIFY
- */
-gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar *lun, GError **error) {
+#define ZFCP_SYSFS "/sys/bus/ccw/drivers/zfcp"
+
+/* makes sure the @devno zFCP device is available (not on the device ignore
+ * list) and online */
+static gboolean zfcp_ccw_online (const gchar *devno, GError **error) {
     gboolean boolrc = FALSE;
     gint rc = 0;
     FILE *fd = NULL;
-    DIR *pdfd = NULL;
     const gchar *zfcp_cio_free[4] = {"zfcp_cio_free", "-d", devno, NULL};
     const gchar *chccwdev[4] = {"chccwdev", "-e", devno, NULL};
-
-    gchar *zfcpsysfs = "/sys/bus/ccw/drivers/zfcp";
-    gchar *online = g_strdup_printf ("%s/%s/online", zfcpsysfs, devno);
-    gchar *portdir = NULL;
-    gchar *unitadd = NULL;
-    gchar *failed = NULL;
-    guint64 progress_id = 0;
-    gchar *msg = NULL;
-    GError *l_error = NULL;
-
-    msg = g_strdup_printf ("Started switching zfcp '%s' online", devno);
-    progress_id = bd_utils_report_started (msg);
-    g_free (msg);
+    gchar *online = g_strdup_printf ("%s/%s/online", ZFCP_SYSFS, devno);
 
     /* part 01: make sure device is available/not on device ignore list */
     fd = fopen (online, "r");
@@ -575,10 +870,8 @@ gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar
         boolrc = bd_utils_exec_and_report_error_no_progress (zfcp_cio_free, NULL, NULL);
         if (!boolrc) {
             g_free (online);
-            g_set_error (&l_error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+            g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
                          "Could not remove device %s from device ignore list.", devno);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return FALSE;
         }
         /* fd is NULL at this point, so try to open it again */
@@ -586,11 +879,9 @@ gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar
 
         /* still no luck, fail */
         if (!fd) {
-            g_set_error (&l_error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+            g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
                          "Could not open device %s even after removing it from" " the device ignore list.", devno);
             g_free (online);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return FALSE;
         }
     }
@@ -600,11 +891,9 @@ gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar
     rc = fgetc (fd);
     if (rc == EOF) {
         /* there was some error checking the 'online' status */
-        g_set_error (&l_error, BD_S390_ERROR, BD_S390_ERROR_IO,
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_IO,
                      "Error checking if device %s is online", devno);
         fclose (fd);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
         return FALSE;
     }
     if (rc == 1) {
@@ -620,17 +909,87 @@ gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar
         fclose (fd);
         boolrc = bd_utils_exec_and_report_error_no_progress (chccwdev, NULL, NULL);
         if (!boolrc) {
-            g_set_error (&l_error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+            g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
                          "Could not set zFCP device %s online", devno);
-            bd_utils_report_finished (progress_id, l_error->message);
-            g_propagate_error (error, l_error);
             return FALSE;
         }
     }
 
+    return TRUE;
+}
+
+/* checks that the @lun added to the @wwpn port of the @devno zFCP device
+ * (@portdir) didn't fail */
+static gboolean zfcp_lun_check (const gchar *portdir, const gchar *devno, const gchar *wwpn, const gchar *lun, GError **error) {
+    gint rc = 0;
+    FILE *fd = NULL;
+    gchar *failed = NULL;
+
+    /* part 04: other error checking to verify device turned on properly */
+    failed = g_strdup_printf ("%s/%s/failed", portdir, lun);
+    fd = fopen (failed, "r");
+    if (!fd) {
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_IO,
+                     "Could not open %s", failed);
+        g_free (failed);
+        return FALSE;
+    }
+    g_free (failed);
+
+    rc = fgetc (fd);
+    fclose (fd);
+    if (rc == EOF) {
+        /* there was some error checking the 'failed' status */
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_IO,
+                     "Could not read failed attribute of LUN %s at WWPN %s on" " zFCP device %s", lun, wwpn, devno);
+        return FALSE;
+    }
+    /* read value here is either 0 or 1; fgetc casts this from char->int, so
+       subtract '0' here to get the literal read value */
+    rc -= '0';
+    if (rc != 0) {
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+                     "Failed LUN %s at WWPN %s on zFCP device %s removed again", lun, wwpn, devno);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * bd_s390_zfcp_online:
+ * @devno: zfcp device number
+ * @wwpn: zfcp WWPN (World Wide Port Number)
+ * @lun: zfcp LUN (Logical Unit Number)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether a zfcp device was successfully switched online
+ *
+ * Tech category: %BD_S390_TECH_ZFCP-%BD_S390_TECH_MODE_MODIFY
+ */
+gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar *lun, GError **error) {
+    gint rc = 0;
+    FILE *fd = NULL;
+    DIR *pdfd = NULL;
+    gchar *portdir = NULL;
+    gchar *unitadd = NULL;
+    guint64 progress_id = 0;
+    gchar *msg = NULL;
+    GError *l_error = NULL;
+
+    msg = g_strdup_printf ("Started switching zfcp '%s' online", devno);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    if (!zfcp_ccw_online (devno, &l_error)) {
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        return FALSE;
+    }
+
     /* part 03: set other properties to use the device */
     /* check this dir exists */
-    portdir = g_strdup_printf ("%s/%s/%s", zfcpsysfs, devno, wwpn);
+    portdir = g_strdup_printf ("%s/%s/%s", ZFCP_SYSFS, devno, wwpn);
     pdfd = opendir (portdir);
     if (!pdfd) {
         g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
@@ -666,52 +1025,386 @@ gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar
     g_free (unitadd);
     fclose (fd);
 
-    /* part 04: other error checking to verify device turned on properly */
-    failed = g_strdup_printf ("%s/%s/failed", portdir, lun);
-    fd = fopen (failed, "r");
-    if (!fd) {
-        g_set_error (&l_error, BD_S390_ERROR, BD_S390_ERROR_IO,
-                     "Could not open %s", failed);
-        g_free (failed);
+    if (!zfcp_lun_check (portdir, devno, wwpn, lun, &l_error)) {
         g_free (portdir);
         bd_utils_report_finished (progress_id, l_error->message);
         g_propagate_error (error, l_error);
         return FALSE;
     }
 
-    rc = fgetc (fd);
-    if (rc == EOF) {
-        /* there was some error checking the 'failed' status */
-        g_set_error (&l_error, BD_S390_ERROR, BD_S390_ERROR_IO,
-                     "Could not read failed attribute of LUN %s at WWPN %s on" " zFCP device %s", lun, wwpn, devno);
-        g_free (failed);
-        g_free (portdir);
-        fclose (fd);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
-    /* read value here is either 0 or 1; fgetc casts this from char->int, so
-       subtract '0' here to get the literal read value */
-    rc -= '0';
-    if (rc != 0) {
-        g_set_error (&l_error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
-                     "Failed LUN %s at WWPN %s on zFCP device %s removed again", lun, wwpn, devno);
-        g_free (failed);
-        g_free (portdir);
-        fclose (fd);
-        bd_utils_report_finished (progress_id, l_error->message);
-        g_propagate_error (error, l_error);
-        return FALSE;
-    }
     /* if you haven't failed yet, you deserve this */
-    g_free (failed);
     g_free (portdir);
-    fclose (fd);
     bd_utils_report_finished (progress_id, "Completed");
     return TRUE;
 }
 
+/* how long to wait for the SCSI devices of the added LUNs to appear */
+#define ZFCP_SCSI_TIMEOUT_MS 30000
+/* how often to check the LUNs without a SCSI device (yet) for being failed */
+#define ZFCP_FAILED_CHECK_MS 1000
+
+typedef struct ZfcpBatch {
+    BDS390ZfcpResult **results;
+    guint n_items;
+    /* whether the SCSI device for the given LUN is being waited for */
+    gboolean *waiting;
+    guint n_waiting;
+    GMutex lock;
+    GCond cond;
+    /* device numbers of the (block) devices added since the subscription */
+    GArray *added;
+} ZfcpBatch;
+
+typedef struct ZfcpCcwTask {
+    const gchar *devno;
+    GError *error;
+} ZfcpCcwTask;
+
+typedef struct ZfcpPortTask {
+    ZfcpBatch *batch;
+    const gchar *devno;
+    const gchar *wwpn;
+    /* indices of the results for the LUNs to add to the port */
+    GArray *idxs;
+} ZfcpPortTask;
+
+static void zfcp_ccw_online_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    ZfcpCcwTask *task = (ZfcpCcwTask *) data;
+
+    zfcp_ccw_online (task->devno, &(task->error));
+}
+
+/* adds all the LUNs of the port in one pass (the 'unit_add' attribute is only
+ * opened once) */
+static void zfcp_port_add_thread (gpointer data, gpointer user_data G_GNUC_UNUSED) {
+    ZfcpPortTask *task = (ZfcpPortTask *) data;
+    ZfcpBatch *batch = task->batch;
+    BDS390ZfcpResult *result = NULL;
+    gchar *portdir = NULL;
+    gchar *unitadd = NULL;
+    gint fd = -1;
+    guint idx = 0;
+    guint i = 0;
+
+    portdir = g_strdup_printf ("%s/%s/%s", ZFCP_SYSFS, task->devno, task->wwpn);
+    unitadd = g_strdup_printf ("%s/unit_add", portdir);
+    if (!g_file_test (portdir, G_FILE_TEST_IS_DIR)) {
+        for (i = 0; i < task->idxs->len; i++)
+            g_set_error (&(batch->results[g_array_index (task->idxs, guint, i)]->error), BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+                         "WWPN %s not found for zFCP device %s", task->wwpn, task->devno);
+        goto out;
+    }
+
+    fd = open (unitadd, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        for (i = 0; i < task->idxs->len; i++)
+            g_set_error (&(batch->results[g_array_index (task->idxs, guint, i)]->error), BD_S390_ERROR, BD_S390_ERROR_IO,
+                         "Could not open %s: %m", unitadd);
+        goto out;
+    }
+
+    for (i = 0; i < task->idxs->len; i++) {
+        idx = g_array_index (task->idxs, guint, i);
+        result = batch->results[idx];
+        /* the kernel takes one LUN per write */
+        if (pwrite (fd, result->lun, strlen (result->lun), 0) < 0) {
+            if (errno == EEXIST) {
+                /* added before, nothing to wait for */
+                bd_utils_log_format (BD_UTILS_LOG_WARNING, "LUN %s at WWPN %s on zFCP device %s already added",
+                                     result->lun, result->wwpn, result->devno);
+                continue;
+            }
+            g_set_error (&(result->error), BD_S390_ERROR, BD_S390_ERROR_IO,
+                         "Could not add LUN %s to WWPN %s on zFCP device %s: %m", result->lun, result->wwpn, result->devno);
+            continue;
+        }
+
+        g_mutex_lock (&(batch->lock));
+        batch->waiting[idx] = TRUE;
+        batch->n_waiting++;
+        g_mutex_unlock (&(batch->lock));
+    }
+    close (fd);
+
+ out:
+    g_free (unitadd);
+    g_free (portdir);
+}
+
+static void zfcp_scsi_event (const gchar *action, const gchar *device G_GNUC_UNUSED, guint64 devnum,
+                             const gchar *dm_name G_GNUC_UNUSED, gpointer user_data) {
+    ZfcpBatch *batch = (ZfcpBatch *) user_data;
+
+    if (g_strcmp0 (action, "add") != 0)
+        return;
+
+    /* just record the device, it is matched with the LUNs in the waiting thread */
+    g_mutex_lock (&(batch->lock));
+    g_array_append_val (batch->added, devnum);
+    g_cond_broadcast (&(batch->cond));
+    g_mutex_unlock (&(batch->lock));
+}
+
+static gchar* read_scsi_attr (guint64 devnum, const gchar *attr) {
+    gchar *path = NULL;
+    gchar *contents = NULL;
+
+    path = g_strdup_printf ("/sys/dev/block/%u:%u/device/%s", major ((dev_t) devnum), minor ((dev_t) devnum), attr);
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        contents = NULL;
+    g_free (path);
+
+    return contents ? g_strstrip (contents) : NULL;
+}
+
+/* marks the LUN the SCSI (block) device @devnum is for as not being waited for,
+ * must be called with the lock held */
+static void zfcp_match_device (ZfcpBatch *batch, guint64 devnum) {
+    gchar *hba_id = NULL;
+    gchar *wwpn = NULL;
+    gchar *fcp_lun = NULL;
+    BDS390ZfcpResult *result = NULL;
+    guint i = 0;
+
+    /* partitions and other devices don't have these */
+    hba_id = read_scsi_attr (devnum, "hba_id");
+    wwpn = read_scsi_attr (devnum, "wwpn");
+    fcp_lun = read_scsi_attr (devnum, "fcp_lun");
+
+    if (hba_id && wwpn && fcp_lun) {
+        for (i = 0; i < batch->n_items; i++) {
+            result = batch->results[i];
+            if (batch->waiting[i] && g_ascii_strcasecmp (result->devno, hba_id) == 0 &&
+                g_ascii_strcasecmp (result->wwpn, wwpn) == 0 && g_ascii_strcasecmp (result->lun, fcp_lun) == 0) {
+                batch->waiting[i] = FALSE;
+                batch->n_waiting--;
+            }
+        }
+    }
+
+    g_free (hba_id);
+    g_free (wwpn);
+    g_free (fcp_lun);
+}
+
+/* 'failed' LUNs never get a SCSI device, stop waiting for them, must be called
+ * with the lock held */
+static void zfcp_check_failed (ZfcpBatch *batch) {
+    BDS390ZfcpResult *result = NULL;
+    gchar *failed = NULL;
+    gchar *contents = NULL;
+    guint i = 0;
+
+    for (i = 0; i < batch->n_items; i++) {
+        if (!batch->waiting[i])
+            continue;
+        result = batch->results[i];
+        failed = g_strdup_printf ("%s/%s/%s/%s/failed", ZFCP_SYSFS, result->devno, result->wwpn, result->lun);
+        if (g_file_get_contents (failed, &contents, NULL, NULL) && contents[0] != '0') {
+            batch->waiting[i] = FALSE;
+            batch->n_waiting--;
+        }
+        g_free (contents);
+        contents = NULL;
+        g_free (failed);
+    }
+}
+
+/* waits for the SCSI devices of the LUNs being waited for to appear (or to
+ * fail), without the udev events there's nothing to wait for */
+static void zfcp_wait_for_devices (ZfcpBatch *batch) {
+    gint64 deadline = 0;
+    gint64 check = 0;
+    guint processed = 0;
+
+    deadline = g_get_monotonic_time () + ZFCP_SCSI_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND;
+    g_mutex_lock (&(batch->lock));
+    while (batch->n_waiting > 0) {
+        while (processed < batch->added->len)
+            zfcp_match_device (batch, g_array_index (batch->added, guint64, processed++));
+        if (batch->n_waiting == 0)
+            break;
+
+        check = MIN (deadline, g_get_monotonic_time () + ZFCP_FAILED_CHECK_MS * G_TIME_SPAN_MILLISECOND);
+        if (!g_cond_wait_until (&(batch->cond), &(batch->lock), check)) {
+            zfcp_check_failed (batch);
+            if (g_get_monotonic_time () >= deadline)
+                break;
+        }
+    }
+    if (batch->n_waiting > 0)
+        bd_utils_log_format (BD_UTILS_LOG_WARNING, "Timed out waiting for SCSI devices of %u zFCP LUNs",
+                             batch->n_waiting);
+    g_mutex_unlock (&(batch->lock));
+}
+
+/**
+ * bd_s390_zfcp_online_many:
+ * @devnos: (array zero-terminated=1): zFCP device numbers
+ * @wwpns: (array zero-terminated=1): zFCP WWPNs (World Wide Port Numbers), one
+ *         per device number in @devnos
+ * @luns: (array zero-terminated=1): zFCP LUNs (Logical Unit Numbers), one per
+ *        device number in @devnos
+ * @max_workers: maximum number of zFCP devices (ports) to switch online (add
+ *               the LUNs to) in parallel or 0 for the default (number of CPUs)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Switches the zFCP LUNs given by the (@devnos[i], @wwpns[i], @luns[i])
+ * triples online the same way bd_s390_zfcp_online() does for each of them,
+ * but every zFCP device is only switched online once and all the LUNs of a
+ * port are added in one pass, up to @max_workers devices (ports) in parallel.
+ * The appearance of the SCSI devices of all the LUNs is then waited for
+ * together, based on the udev events. A failure to switch one of the LUNs
+ * online doesn't affect the other ones, it is reported in the
+ * #BDS390ZfcpResult.error field of the particular entry.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): results of the operation (one entry
+ *                                                     per LUN, in the same order)
+ *                                                     or %NULL in case of error
+ *
+ * Tech category: %BD_S390_TECH_ZFCP-%BD_S390_TECH_MODE_MODIFY
+ */
+BDS390ZfcpResult** bd_s390_zfcp_online_many (const gchar **devnos, const gchar **wwpns, const gchar **luns, guint max_workers, GError **error) {
+    ZfcpBatch batch;
+    GHashTable *ccw_tasks = NULL;
+    GHashTable *port_tasks = NULL;
+    GPtrArray *items = NULL;
+    ZfcpCcwTask *ccw_task = NULL;
+    ZfcpPortTask *port_task = NULL;
+    BDS390ZfcpResult *result = NULL;
+    GHashTableIter iter;
+    gpointer value = NULL;
+    gchar *key = NULL;
+    gchar *msg = NULL;
+    guint64 progress_id = 0;
+    guint events_id = 0;
+    guint n_failed = 0;
+    guint i = 0;
+
+    if (!devnos || !wwpns || !luns) {
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+                     "No zFCP LUNs specified");
+        return NULL;
+    }
+
+    memset (&batch, 0, sizeof (batch));
+    batch.n_items = g_strv_length ((gchar **) devnos);
+    if (g_strv_length ((gchar **) wwpns) != batch.n_items || g_strv_length ((gchar **) luns) != batch.n_items) {
+        g_set_error (error, BD_S390_ERROR, BD_S390_ERROR_DEVICE,
+                     "The same number of device numbers, WWPNs and LUNs needs to be specified");
+        return NULL;
+    }
+
+    batch.results = g_new0 (BDS390ZfcpResult*, batch.n_items + 1);
+    if (batch.n_items == 0)
+        return batch.results;
+
+    g_mutex_init (&(batch.lock));
+    g_cond_init (&(batch.cond));
+    batch.waiting = g_new0 (gboolean, batch.n_items);
+    batch.added = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+    msg = g_strdup_printf ("Started switching %u zFCP LUNs online", batch.n_items);
+    progress_id = bd_utils_report_started (msg);
+    g_free (msg);
+
+    for (i = 0; i < batch.n_items; i++) {
+        batch.results[i] = g_new0 (BDS390ZfcpResult, 1);
+        batch.results[i]->devno = g_strdup (devnos[i]);
+        batch.results[i]->wwpn = g_strdup (wwpns[i]);
+        batch.results[i]->lun = g_strdup (luns[i]);
+    }
+
+    /* every zFCP device only once */
+    ccw_tasks = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+    items = g_ptr_array_new ();
+    for (i = 0; i < batch.n_items; i++) {
+        if (g_hash_table_contains (ccw_tasks, devnos[i]))
+            continue;
+        ccw_task = g_new0 (ZfcpCcwTask, 1);
+        ccw_task->devno = devnos[i];
+        g_hash_table_insert (ccw_tasks, (gpointer) devnos[i], ccw_task);
+        g_ptr_array_add (items, ccw_task);
+    }
+    bd_utils_parallel_run (zfcp_ccw_online_thread, items->pdata, items->len, max_workers, NULL);
+    msg = g_strdup_printf ("Switched %u zFCP devices online", items->len);
+    bd_utils_report_progress (progress_id, 33, msg);
+    g_free (msg);
+    g_ptr_array_free (items, TRUE);
+
+    /* subscribe before adding any LUN so that no event is missed */
+    events_id = bd_utils_dev_events_subscribe (zfcp_scsi_event, &batch, NULL);
+
+    /* all the LUNs of a port together */
+    port_tasks = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    items = g_ptr_array_new ();
+    for (i = 0; i < batch.n_items; i++) {
+        ccw_task = g_hash_table_lookup (ccw_tasks, devnos[i]);
+        if (ccw_task->error) {
+            batch.results[i]->error = g_error_copy (ccw_task->error);
+            continue;
+        }
+        key = g_strdup_printf ("%s/%s", devnos[i], wwpns[i]);
+        port_task = g_hash_table_lookup (port_tasks, key);
+        if (!port_task) {
+            port_task = g_new0 (ZfcpPortTask, 1);
+            port_task->batch = &batch;
+            port_task->devno = devnos[i];
+            port_task->wwpn = wwpns[i];
+            port_task->idxs = g_array_new (FALSE, FALSE, sizeof (guint));
+            g_hash_table_insert (port_tasks, key, port_task);
+            g_ptr_array_add (items, port_task);
+        } else
+            g_free (key);
+        g_array_append_val (port_task->idxs, i);
+    }
+    bd_utils_parallel_run (zfcp_port_add_thread, items->pdata, items->len, max_workers, NULL);
+    bd_utils_report_progress (progress_id, 66, "Added the LUNs");
+
+    if (events_id != 0) {
+        bd_utils_report_progress (progress_id, 66, "Waiting for the SCSI devices");
+        zfcp_wait_for_devices (&batch);
+        bd_utils_dev_events_unsubscribe (events_id);
+    }
+
+    /* the final check of all the LUNs that were added */
+    for (i = 0; i < batch.n_items; i++) {
+        result = batch.results[i];
+        if (!result->error) {
+            key = g_strdup_printf ("%s/%s/%s", ZFCP_SYSFS, result->devno, result->wwpn);
+            result->success = zfcp_lun_check (key, result->devno, result->wwpn, result->lun, &(result->error));
+            g_free (key);
+        }
+        if (!result->success)
+            n_failed++;
+    }
+
+    if (n_failed == 0)
+        bd_utils_report_finished (progress_id, "Completed");
+    else {
+        msg = g_strdup_printf ("Failed switching %u of %u zFCP LUNs online", n_failed, batch.n_items);
+        bd_utils_report_finished (progress_id, msg);
+        g_free (msg);
+    }
+
+    for (i = 0; i < items->len; i++) {
+        port_task = items->pdata[i];
+        g_array_free (port_task->idxs, TRUE);
+        g_free (port_task);
+    }
+    g_ptr_array_free (items, TRUE);
+    g_hash_table_iter_init (&iter, ccw_tasks);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+        g_clear_error (&(((ZfcpCcwTask *) value)->error));
+    g_hash_table_destroy (ccw_tasks);
+    g_hash_table_destroy (port_tasks);
+    g_array_free (batch.added, TRUE);
+    g_free (batch.waiting);
+    g_cond_clear (&(batch.cond));
+    g_mutex_clear (&(batch.lock));
+
+    return batch.results;
+}
 /**
  * bd_s390_zfcp_scsi_offline
  *
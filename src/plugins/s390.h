@@ -14,6 +14,26 @@ typedef enum {
     BD_S390_ERROR_IO,
 } BDS390Error;
 
+typedef struct BDS390DasdResult {
+    gchar *dasd;
+    gboolean success;
+    GError *error;
+} BDS390DasdResult;
+
+BDS390DasdResult* bd_s390_dasd_result_copy (BDS390DasdResult *data);
+void bd_s390_dasd_result_free (BDS390DasdResult *data);
+
+typedef struct BDS390ZfcpResult {
+    gchar *devno;
+    gchar *wwpn;
+    gchar *lun;
+    gboolean success;
+    GError *error;
+} BDS390ZfcpResult;
+
+BDS390ZfcpResult* bd_s390_zfcp_result_copy (BDS390ZfcpResult *data);
+void bd_s390_zfcp_result_free (BDS390ZfcpResult *data);
+
 typedef enum {
     BD_S390_TECH_DASD = 0,
     BD_S390_TECH_ZFCP,
@@ -38,8 +58,10 @@ void bd_s390_close (void);
 gboolean bd_s390_is_tech_avail (BDS390Tech tech, guint64 mode, GError **error);
 
 gboolean bd_s390_dasd_format (const gchar *dasd, const BDExtraArg **extra, GError **error);
+BDS390DasdResult** bd_s390_dasd_format_many (const gchar **dasds, guint max_workers, const BDExtraArg **extra, GError **error);
 gboolean bd_s390_dasd_needs_format (const gchar *dasd, GError **error);
 gboolean bd_s390_dasd_online (const gchar *dasd, GError **error);
+BDS390DasdResult** bd_s390_dasd_online_many (const gchar **dasds, guint max_workers, GError **error);
 gboolean bd_s390_dasd_is_ldl (const gchar *dasd, GError **error);
 gboolean bd_s390_dasd_is_fba (const gchar *dasd, GError **error);
 
@@ -48,6 +70,7 @@ gchar* bd_s390_sanitize_dev_input (const gchar *dev, GError **error);
 gchar* bd_s390_zfcp_sanitize_wwpn_input (const gchar *wwpn, GError **error);
 gchar* bd_s390_zfcp_sanitize_lun_input (const gchar *lun, GError **error);
 gboolean bd_s390_zfcp_online (const gchar *devno, const gchar *wwpn, const gchar *lun, GError **error);
+BDS390ZfcpResult** bd_s390_zfcp_online_many (const gchar **devnos, const gchar **wwpns, const gchar **luns, guint max_workers, GError **error);
 gboolean bd_s390_zfcp_scsi_offline(const gchar *devno, const gchar *wwpn, const gchar *lun, GError **error);
 gboolean bd_s390_zfcp_offline(const gchar *devno, const gchar *wwpn, const gchar *lun, GError **error);
 
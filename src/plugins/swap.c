@@ -21,6 +21,11 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/swap.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <linux/magic.h>
+#include <poll.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <blkid.h>
 #include <uuid.h>
@@ -28,6 +33,7 @@
 
 #include "swap.h"
 #include "check_deps.h"
+#include "../utils/probe.h"
 
 #define MKSWAP_MIN_VERSION "2.23.2"
 
@@ -64,6 +70,205 @@ static const UtilDep deps[DEPS_LAST] = {
 };
 
 
+void bd_swap_info_free (BDSwapInfo *info) {
+    if (info == NULL)
+        return;
+
+    g_free (info->device);
+    g_free (info->type);
+    g_free (info);
+}
+
+BDSwapInfo* bd_swap_info_copy (BDSwapInfo *info) {
+    if (info == NULL)
+        return NULL;
+
+    BDSwapInfo *new_info = g_new0 (BDSwapInfo, 1);
+
+    new_info->device = g_strdup (info->device);
+    new_info->dev = info->dev;
+    new_info->type = g_strdup (info->type);
+    new_info->size = info->size;
+    new_info->used = info->used;
+    new_info->priority = info->priority;
+
+    return new_info;
+}
+
+/* cache of the parsed /proc/swaps, the file supports poll() to notify about
+   changes (POLLERR|POLLPRI) so we keep it open and only parse it again when
+   the set of active swaps changes */
+static GMutex swaps_lock;
+static gint swaps_fd = -1;
+static gboolean swaps_pollable = FALSE;
+static GPtrArray *swaps_table = NULL;
+static GHashTable *swaps_index = NULL;
+
+/* key identifying the swap device (block devices by their devno, files by the
+   filesystem devno and the inode) */
+static gchar* swap_stat_key (const struct stat *st) {
+    if (S_ISBLK (st->st_mode))
+        return g_strdup_printf ("b:%"G_GUINT64_FORMAT, (guint64) st->st_rdev);
+    else
+        return g_strdup_printf ("f:%"G_GUINT64_FORMAT":%"G_GUINT64_FORMAT,
+                                (guint64) st->st_dev, (guint64) st->st_ino);
+}
+
+static gchar* read_swaps (gint fd, GError **error) {
+    GString *content = NULL;
+    gchar buf[4096];
+    gssize n_read = 0;
+
+    if (lseek (fd, 0, SEEK_SET) < 0) {
+        g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_UNKNOWN_STATE,
+                     "Failed to read /proc/swaps: %m");
+        return NULL;
+    }
+
+    content = g_string_new (NULL);
+    while ((n_read = read (fd, buf, sizeof (buf))) != 0) {
+        if (n_read < 0) {
+            if (errno == EINTR)
+                continue;
+            g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_UNKNOWN_STATE,
+                         "Failed to read /proc/swaps: %m");
+            g_string_free (content, TRUE);
+            return NULL;
+        }
+        g_string_append_len (content, buf, n_read);
+    }
+
+    return g_string_free (content, FALSE);
+}
+
+/* parses the content of /proc/swaps (sizes are in KiB there) */
+static GPtrArray* parse_swaps (const gchar *content) {
+    GPtrArray *table = g_ptr_array_new_with_free_func ((GDestroyNotify) bd_swap_info_free);
+    gchar **lines = NULL;
+    gchar **fields = NULL;
+    gchar **line_p = NULL;
+    guint n_fields = 0;
+    struct stat st;
+    BDSwapInfo *info = NULL;
+
+    lines = g_strsplit (content, "\n", -1);
+    /* first line is the header */
+    for (line_p = lines; *line_p; line_p++) {
+        if (line_p == lines || **line_p == '\0')
+            continue;
+
+        /* the fields are separated by whitespace, whitespace in the filename
+           is escaped */
+        fields = g_strsplit_set (*line_p, " \t", -1);
+        n_fields = 0;
+        for (guint i = 0; fields[i]; i++)
+            if (*fields[i] != '\0')
+                fields[n_fields++] = fields[i];
+            else
+                g_free (fields[i]);
+        fields[n_fields] = NULL;
+
+        if (n_fields < 5) {
+            g_strfreev (fields);
+            continue;
+        }
+
+        info = g_new0 (BDSwapInfo, 1);
+        info->device = g_strcompress (fields[0]);
+        info->type = g_strdup (fields[1]);
+        info->size = g_ascii_strtoull (fields[2], NULL, 10) * 1024;
+        info->used = g_ascii_strtoull (fields[3], NULL, 10) * 1024;
+        info->priority = (gint) g_ascii_strtoll (fields[4], NULL, 10);
+        if (stat (info->device, &st) == 0 && S_ISBLK (st.st_mode))
+            info->dev = (guint64) st.st_rdev;
+        g_ptr_array_add (table, info);
+        g_strfreev (fields);
+    }
+    g_strfreev (lines);
+
+    return table;
+}
+
+/* swaps_lock needs to be held */
+static void swaps_cache_drop (void) {
+    if (swaps_index) {
+        g_hash_table_destroy (swaps_index);
+        swaps_index = NULL;
+    }
+    if (swaps_table) {
+        g_ptr_array_free (swaps_table, TRUE);
+        swaps_table = NULL;
+    }
+}
+
+/* swaps_lock needs to be held, returns whether the set of active swaps has
+   (or may have) changed since the last check */
+static gboolean swaps_changed (void) {
+    struct pollfd pfd;
+
+    /* not on procfs (e.g. provided by LXCFS in a container), change
+       notifications cannot be relied on */
+    if (!swaps_pollable)
+        return TRUE;
+
+    pfd.fd = swaps_fd;
+    pfd.events = POLLPRI;
+    pfd.revents = 0;
+    if (poll (&pfd, 1, 0) < 0)
+        return TRUE;
+
+    return (pfd.revents & (POLLERR | POLLPRI)) != 0;
+}
+
+/* swaps_lock needs to be held, @force forces reading /proc/swaps even if the
+   cached table is still valid (e.g. to get the current usage) */
+static gboolean swaps_cache_update (gboolean force, GError **error) {
+    gchar *content = NULL;
+    struct stat st;
+    struct statfs stfs;
+    gboolean changed = FALSE;
+    BDSwapInfo *info = NULL;
+
+    if (swaps_fd < 0) {
+        swaps_fd = open ("/proc/swaps", O_RDONLY|O_CLOEXEC);
+        if (swaps_fd < 0) {
+            g_set_error (error, BD_SWAP_ERROR, BD_SWAP_ERROR_UNKNOWN_STATE,
+                         "Failed to open /proc/swaps: %m");
+            return FALSE;
+        }
+        swaps_pollable = fstatfs (swaps_fd, &stfs) == 0 && stfs.f_type == PROC_SUPER_MAGIC;
+    }
+
+    /* always check to consume a possible change notification */
+    changed = swaps_changed ();
+    if (swaps_table && !changed && !force)
+        return TRUE;
+
+    content = read_swaps (swaps_fd, error);
+    if (!content)
+        return FALSE;
+
+    swaps_cache_drop ();
+    swaps_table = parse_swaps (content);
+    g_free (content);
+
+    swaps_index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    for (guint i = 0; i < swaps_table->len; i++) {
+        info = g_ptr_array_index (swaps_table, i);
+        if (stat (info->device, &st) == 0)
+            g_hash_table_insert (swaps_index, swap_stat_key (&st), info);
+    }
+
+    return TRUE;
+}
+
+static void swaps_cache_invalidate (void) {
+    g_mutex_lock (&swaps_lock);
+    swaps_cache_drop ();
+    g_mutex_unlock (&swaps_lock);
+}
+
+
 /**
  * bd_swap_init:
  *
@@ -84,7 +289,13 @@ gboolean bd_swap_init (void) {
  *
  */
 void bd_swap_close (void) {
-    /* nothing to do here */
+    g_mutex_lock (&swaps_lock);
+    swaps_cache_drop ();
+    if (swaps_fd >= 0) {
+        close (swaps_fd);
+        swaps_fd = -1;
+    }
+    g_mutex_unlock (&swaps_lock);
 }
 
 
@@ -151,6 +362,8 @@ gboolean bd_swap_mkswap (const gchar *device, const gchar *label, const gchar *u
     return bd_utils_exec_and_report_error (argv, extra, error);
 }
 
+#define PROBE_TIMEOUT_MS 500
+
 /**
  * bd_swap_swapon:
  * @device: swap device to activate
@@ -165,7 +378,6 @@ gboolean bd_swap_swapon (const gchar *device, gint priority, GError **error) {
     blkid_probe probe = NULL;
     gint fd = 0;
     gint status = 0;
-    guint n_try = 0;
     const gchar *value = NULL;
     gint64 status_len = 0;
     gint64 swap_pagesize = 0;
@@ -201,13 +413,9 @@ gboolean bd_swap_swapon (const gchar *device, gint priority, GError **error) {
         return FALSE;
     }
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; (status != 0) && (n_try > 0); n_try--) {
-        status = blkid_probe_set_device (probe, fd, 0, 0);
-        if (status != 0)
-            g_usleep (100 * 1000); /* microseconds */
-    }
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = bd_utils_probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SET_DEVICE, PROBE_TIMEOUT_MS);
     if (status != 0) {
         g_set_error (&l_error, BD_SWAP_ERROR, BD_SWAP_ERROR_UNKNOWN_STATE,
                      "Failed to create a probe for the device '%s'", device);
@@ -221,13 +429,9 @@ gboolean bd_swap_swapon (const gchar *device, gint priority, GError **error) {
     blkid_probe_enable_superblocks (probe, 1);
     blkid_probe_set_superblocks_flags (probe, BLKID_SUBLKS_TYPE | BLKID_SUBLKS_MAGIC);
 
-    /* we may need to try multiple times with some delays in case the device is
-       busy at the very moment */
-    for (n_try=5, status=-1; !(status == 0 || status == 1) && (n_try > 0); n_try--) {
-        status = blkid_do_safeprobe (probe);
-        if (status < 0)
-            g_usleep (100 * 1000); /* microseconds */
-    }
+    /* we may need to try multiple times in case the device is busy at the
+       very moment */
+    status = bd_utils_probe_with_retry (device, probe, fd, BD_UTILS_PROBE_SAFEPROBE, PROBE_TIMEOUT_MS);
     if (status < 0) {
         /* -1 or -2 = error during probing*/
         g_set_error (&l_error, BD_SWAP_ERROR, BD_SWAP_ERROR_UNKNOWN_STATE,
@@ -342,6 +546,7 @@ gboolean bd_swap_swapon (const gchar *device, gint priority, GError **error) {
     }
 
     ret = swapon (device, flags);
+    swaps_cache_invalidate ();
     if (ret != 0) {
         g_set_error (&l_error, BD_SWAP_ERROR, BD_SWAP_ERROR_ACTIVATE,
                      "Failed to activate swap on %s: %m", device);
@@ -373,6 +578,7 @@ gboolean bd_swap_swapoff (const gchar *device, GError **error) {
     g_free (msg);
 
     ret = swapoff (device);
+    swaps_cache_invalidate ();
     if (ret != 0) {
         g_set_error (&l_error, BD_SWAP_ERROR, BD_SWAP_ERROR_ACTIVATE,
                      "Failed to deactivate swap on %s: %m", device);
@@ -392,52 +598,61 @@ gboolean bd_swap_swapoff (const gchar *device, GError **error) {
  * Returns: %TRUE if the swap device is active, %FALSE if not active or failed
  * to determine (@error) is set not a non-NULL value in such case)
  *
+ * The @device is compared with the active swaps by its device number (or
+ * inode for swap files) so any path pointing to the device (e.g. a symlink in
+ * `/dev/mapper/`) can be used. The list of active swaps is cached and only
+ * parsed again when it changes making this cheap for checking many devices.
+ *
  * Tech category: %BD_SWAP_TECH_SWAP-%BD_SWAP_TECH_MODE_QUERY
  */
 gboolean bd_swap_swapstatus (const gchar *device, GError **error) {
-    gchar *file_content = NULL;
-    gchar *real_device = NULL;
-    gsize length;
-    gchar *next_line;
-    gboolean success;
-
-    success = g_file_get_contents ("/proc/swaps", &file_content, &length, error);
-    if (!success) {
-        /* error is already populated */
+    struct stat st;
+    gchar *key = NULL;
+    gboolean ret = FALSE;
+
+    if (stat (device, &st) != 0)
+        /* the device doesn't exist and thus is not an active swap */
         return FALSE;
-    }
 
-    /* get the real device node for device-mapper devices since the ones
-       with meaningful names are just dev_paths */
-    if (g_str_has_prefix (device, "/dev/mapper/") || g_str_has_prefix (device, "/dev/md/")) {
-        real_device = bd_utils_resolve_device (device, NULL);
-        if (!real_device) {
-            /* the device doesn't exist and thus is not an active swap */
-            g_free (file_content);
-            return FALSE;
-        }
+    g_mutex_lock (&swaps_lock);
+    if (!swaps_cache_update (FALSE, error)) {
+        g_mutex_unlock (&swaps_lock);
+        return FALSE;
     }
 
-    if (g_str_has_prefix (file_content, real_device ? real_device : device)) {
-        g_free (real_device);
-        g_free (file_content);
-        return TRUE;
-    }
+    key = swap_stat_key (&st);
+    ret = g_hash_table_contains (swaps_index, key);
+    g_mutex_unlock (&swaps_lock);
+    g_free (key);
 
-    next_line = (strchr (file_content, '\n') + 1);
-    while (next_line && ((gsize)(next_line - file_content) < length)) {
-        if (g_str_has_prefix (next_line, real_device ? real_device : device)) {
-            g_free (real_device);
-            g_free (file_content);
-            return TRUE;
-        }
+    return ret;
+}
 
-        next_line = (strchr (next_line, '\n') + 1);
+/**
+ * bd_swap_list:
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (array zero-terminated=1) (transfer full): information about all
+ *          the active swaps or %NULL in case of error (with @error set)
+ *
+ * Tech category: %BD_SWAP_TECH_SWAP-%BD_SWAP_TECH_MODE_QUERY
+ */
+BDSwapInfo** bd_swap_list (GError **error) {
+    BDSwapInfo **ret = NULL;
+
+    g_mutex_lock (&swaps_lock);
+    /* usage changes all the time, always read the current state */
+    if (!swaps_cache_update (TRUE, error)) {
+        g_mutex_unlock (&swaps_lock);
+        return NULL;
     }
 
-    g_free (real_device);
-    g_free (file_content);
-    return FALSE;
+    ret = g_new0 (BDSwapInfo*, swaps_table->len + 1);
+    for (guint i = 0; i < swaps_table->len; i++)
+        ret[i] = bd_swap_info_copy (g_ptr_array_index (swaps_table, i));
+    g_mutex_unlock (&swaps_lock);
+
+    return ret;
 }
 
 /**
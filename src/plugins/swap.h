@@ -30,6 +30,27 @@ typedef enum {
     BD_SWAP_TECH_MODE_SET_UUID            = 1 << 3,
 } BDSwapTechMode;
 
+/**
+ * BDSwapInfo:
+ * @device: path of the swap device (or file) as reported by the kernel
+ * @dev: device number of the swap device (0 for swap files)
+ * @type: type of the swap space ("partition" or "file")
+ * @size: size of the swap space (in bytes)
+ * @used: used swap space (in bytes)
+ * @priority: priority of the swap space
+ */
+typedef struct BDSwapInfo {
+    gchar *device;
+    guint64 dev;
+    gchar *type;
+    guint64 size;
+    guint64 used;
+    gint priority;
+} BDSwapInfo;
+
+void bd_swap_info_free (BDSwapInfo *info);
+BDSwapInfo* bd_swap_info_copy (BDSwapInfo *info);
+
 /*
  * If using the plugin as a standalone library, the following functions should
  * be called to:
@@ -47,6 +68,7 @@ gboolean bd_swap_mkswap (const gchar *device, const gchar *label, const gchar *u
 gboolean bd_swap_swapon (const gchar *device, gint priority, GError **error);
 gboolean bd_swap_swapoff (const gchar *device, GError **error);
 gboolean bd_swap_swapstatus (const gchar *device, GError **error);
+BDSwapInfo** bd_swap_list (GError **error);
 gboolean bd_swap_set_label (const gchar *device, const gchar *label, GError **error);
 gboolean bd_swap_check_label (const gchar *label, GError **error);
 gboolean bd_swap_set_uuid (const gchar *device, const gchar *uuid, GError **error);
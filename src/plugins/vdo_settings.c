@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "vdo_settings.h"
+
+/* Translation of the typed VDO settings to the LVM configuration (the
+ * 'allocation/vdo_*' options, used for the new VDO pools the same way as the
+ * index memory and write policy, older versions of LVM don't support the
+ * '--vdosettings' option) and to the '--vdosettings' option used for changing
+ * the settings of an existing VDO pool. LVM accepts the same names (with or
+ * without the 'vdo_' prefix) in both. */
+
+#define MIN_SLAB_SIZE (128 MiB)
+#define MAX_SLAB_SIZE (32 GiB)
+#define MIN_BLOCK_MAP_CACHE_SIZE (128 MiB)
+#define VDO_BLOCK_SIZE 4096
+
+void bd_lvm_vdo_settings_free (BDLVMVDOSettings *settings) {
+    g_free (settings);
+}
+
+BDLVMVDOSettings* bd_lvm_vdo_settings_copy (BDLVMVDOSettings *settings) {
+    BDLVMVDOSettings *new_settings = NULL;
+
+    if (settings == NULL)
+        return NULL;
+
+    new_settings = g_new0 (BDLVMVDOSettings, 1);
+    *new_settings = *settings;
+
+    return new_settings;
+}
+
+static gboolean check_threads (const gchar *name, guint threads, guint max, GError **error) {
+    if (threads > max) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid number of VDO %s threads %u: needs to be at most %u", name, threads, max);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean check_settings (const BDLVMVDOSettings *settings, GError **error) {
+    if (!check_threads ("ack", settings->ack_threads, 100, error) ||
+        !check_threads ("bio", settings->bio_threads, 100, error) ||
+        !check_threads ("cpu", settings->cpu_threads, 100, error) ||
+        !check_threads ("hash zone", settings->hash_zone_threads, 100, error) ||
+        !check_threads ("logical", settings->logical_threads, 60, error) ||
+        !check_threads ("physical", settings->physical_threads, 16, error))
+        return FALSE;
+
+    if (settings->bio_rotation > 1024) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid VDO bio rotation %u: needs to be at most 1024", settings->bio_rotation);
+        return FALSE;
+    }
+
+    if (settings->slab_size != 0 &&
+        (settings->slab_size < MIN_SLAB_SIZE || settings->slab_size > MAX_SLAB_SIZE ||
+         (settings->slab_size & (settings->slab_size - 1)) != 0)) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid VDO slab size %"G_GUINT64_FORMAT": needs to be a power of 2 between 128 MiB and 32 GiB",
+                     settings->slab_size);
+        return FALSE;
+    }
+
+    if (settings->block_map_cache_size != 0 &&
+        (settings->block_map_cache_size < MIN_BLOCK_MAP_CACHE_SIZE || settings->block_map_cache_size % (1 MiB) != 0)) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid VDO block map cache size %"G_GUINT64_FORMAT": needs to be a multiple of 1 MiB and at least 128 MiB",
+                     settings->block_map_cache_size);
+        return FALSE;
+    }
+
+    if (settings->max_discard % VDO_BLOCK_SIZE != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Invalid VDO maximum discard size %"G_GUINT64_FORMAT": needs to be a multiple of 4 KiB",
+                     settings->max_discard);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* appends " <prefix>key=value" for all the non-default settings to @str */
+static void append_settings (GString *str, const BDLVMVDOSettings *settings, const gchar *prefix) {
+    if (settings->ack_threads != 0)
+        g_string_append_printf (str, " %sack_threads=%u", prefix, settings->ack_threads);
+    if (settings->bio_threads != 0)
+        g_string_append_printf (str, " %sbio_threads=%u", prefix, settings->bio_threads);
+    if (settings->bio_rotation != 0)
+        g_string_append_printf (str, " %sbio_rotation=%u", prefix, settings->bio_rotation);
+    if (settings->cpu_threads != 0)
+        g_string_append_printf (str, " %scpu_threads=%u", prefix, settings->cpu_threads);
+    if (settings->hash_zone_threads != 0)
+        g_string_append_printf (str, " %shash_zone_threads=%u", prefix, settings->hash_zone_threads);
+    if (settings->logical_threads != 0)
+        g_string_append_printf (str, " %slogical_threads=%u", prefix, settings->logical_threads);
+    if (settings->physical_threads != 0)
+        g_string_append_printf (str, " %sphysical_threads=%u", prefix, settings->physical_threads);
+    if (settings->slab_size != 0)
+        g_string_append_printf (str, " %sslab_size_mb=%"G_GUINT64_FORMAT, prefix, settings->slab_size / (1 MiB));
+    if (settings->block_map_cache_size != 0)
+        g_string_append_printf (str, " %sblock_map_cache_size_mb=%"G_GUINT64_FORMAT, prefix, settings->block_map_cache_size / (1 MiB));
+    if (settings->max_discard != 0)
+        /* in VDO blocks */
+        g_string_append_printf (str, " %smax_discard=%"G_GUINT64_FORMAT, prefix, settings->max_discard / VDO_BLOCK_SIZE);
+}
+
+/**
+ * vdo_settings_to_config: (skip)
+ * @settings: (nullable): settings of a new VDO pool to translate
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): the options for the 'allocation' section of the
+ *          LVM configuration for @settings (an empty string for %NULL or all
+ *          default @settings) or %NULL in case of error
+ */
+gchar* vdo_settings_to_config (const BDLVMVDOSettings *settings, GError **error) {
+    GString *config = NULL;
+
+    if (!settings)
+        return g_strdup ("");
+
+    if (!check_settings (settings, error))
+        return NULL;
+
+    config = g_string_new (NULL);
+    append_settings (config, settings, "vdo_");
+
+    return g_string_free (config, FALSE);
+}
+
+/**
+ * vdo_settings_to_extra: (skip)
+ * @settings: settings of an existing VDO pool to translate
+ * @extra: (nullable) (array zero-terminated=1): extra options to append
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the LVM options for
+ *          @settings followed by (copies of) @extra or %NULL in case of error
+ */
+BDExtraArg** vdo_settings_to_extra (const BDLVMVDOSettings *settings, const BDExtraArg **extra, GError **error) {
+    GPtrArray *args = NULL;
+    GString *vdo_settings = NULL;
+    const BDExtraArg **extra_p = NULL;
+
+    if (settings->slab_size != 0) {
+        g_set_error (error, BD_LVM_ERROR, BD_LVM_ERROR_FAIL,
+                     "Slab size of an existing VDO pool cannot be changed");
+        return NULL;
+    }
+
+    if (!check_settings (settings, error))
+        return NULL;
+
+    args = g_ptr_array_new ();
+    vdo_settings = g_string_new (NULL);
+    append_settings (vdo_settings, settings, "");
+    if (vdo_settings->len > 0)
+        g_ptr_array_add (args, bd_extra_arg_new ("--vdosettings", vdo_settings->str + 1));
+    g_string_free (vdo_settings, TRUE);
+
+    if (extra)
+        for (extra_p = extra; *extra_p; extra_p++)
+            g_ptr_array_add (args, bd_extra_arg_copy ((BDExtraArg *) *extra_p));
+    g_ptr_array_add (args, NULL);
+
+    return (BDExtraArg **) g_ptr_array_free (args, FALSE);
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "lvm.h"
+
+#ifndef BD_VDO_SETTINGS
+#define BD_VDO_SETTINGS
+
+gchar* vdo_settings_to_config (const BDLVMVDOSettings *settings, GError **error);
+BDExtraArg** vdo_settings_to_extra (const BDLVMVDOSettings *settings, const BDExtraArg **extra, GError **error);
+
+#endif  /* BD_VDO_SETTINGS */
@@ -18,12 +18,51 @@
  */
 
 #include <glib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <blockdev/utils.h>
 
 #include "vdo_stats.h"
 
 #define VDO_SYS_PATH "/sys/kvdo"
 
+/* counters needed for the BDLVMVDOStats */
+typedef enum {
+    STAT_BLOCK_SIZE = 0,
+    STAT_LOGICAL_BLOCK_SIZE,
+    STAT_PHYSICAL_BLOCKS,
+    STAT_DATA_BLOCKS_USED,
+    STAT_OVERHEAD_BLOCKS_USED,
+    STAT_LOGICAL_BLOCKS_USED,
+    STAT_BIOS_META_WRITE,
+    STAT_BIOS_OUT_WRITE,
+    STAT_BIOS_IN_WRITE,
+    STAT_LAST,
+} StatsKey;
+
+/* file names of the counters, in the same order as StatsKey */
+static const gchar *const stats_keys[STAT_LAST] = {
+    "block_size",
+    "logical_block_size",
+    "physical_blocks",
+    "data_blocks_used",
+    "overhead_blocks_used",
+    "logical_blocks_used",
+    "bios_meta_write",
+    "bios_out_write",
+    "bios_in_write",
+};
+
+/* open statistics files of a VDO pool, sysfs attributes are regenerated when
+   read from the start so the files can be kept open and just read again */
+typedef struct StatsReader {
+    gint fds[STAT_LAST];
+} StatsReader;
+
+static GMutex readers_lock;
+static GHashTable *readers = NULL;
+
 
 G_GNUC_INTERNAL gboolean
 get_stat_val64 (GHashTable *stats, const gchar *key, gint64 *val) {
@@ -149,6 +188,38 @@ static gchar* _dm_node_from_name (const gchar *map_name, GError **error) {
     return ret;
 }
 
+/* returns path to the statistics directory for the @name VDO pool */
+static gchar* _get_stats_dir (const gchar *name, GError **error) {
+    gchar *stats_dir = NULL;
+    g_autofree gchar *dm_node = NULL;
+
+    /* try "new" (kvdo >= 8) path first -- /sys/block/dm-X/vdo/statistics */
+    dm_node = _dm_node_from_name (name, error);
+    if (dm_node == NULL) {
+        g_prefix_error (error, "Failed to get DM node for %s: ", name);
+        return NULL;
+    }
+
+    stats_dir = g_build_path (G_DIR_SEPARATOR_S, "/sys/block", dm_node, "vdo/statistics", NULL);
+    if (g_file_test (stats_dir, G_FILE_TEST_IS_DIR))
+        return stats_dir;
+
+    bd_utils_log_format (BD_UTILS_LOG_INFO,
+                         "Failed to read VDO stats using the new API, falling back to %s: %s doesn't exist",
+                         VDO_SYS_PATH, stats_dir);
+    g_free (stats_dir);
+
+    /* lets try /sys/kvdo */
+    stats_dir = g_build_path (G_DIR_SEPARATOR_S, VDO_SYS_PATH, name, "statistics", NULL);
+    if (g_file_test (stats_dir, G_FILE_TEST_IS_DIR))
+        return stats_dir;
+
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT,
+                 "Error reading statistics from %s: No such directory", stats_dir);
+    g_free (stats_dir);
+    return NULL;
+}
+
 G_GNUC_INTERNAL GHashTable *
 vdo_get_stats_full (const gchar *name, GError **error) {
     GHashTable *stats;
@@ -157,33 +228,16 @@ vdo_get_stats_full (const gchar *name, GError **error) {
     const gchar *direntry;
     gchar *s;
     gchar *val = NULL;
-    g_autofree gchar *dm_node = NULL;
-    GError *l_error = NULL;
 
-    /* try "new" (kvdo >= 8) path first -- /sys/block/dm-X/vdo/statistics */
-    dm_node = _dm_node_from_name (name, error);
-    if (dm_node == NULL) {
-        g_prefix_error (error, "Failed to get DM node for %s: ", name);
+    stats_dir = _get_stats_dir (name, error);
+    if (stats_dir == NULL)
         return NULL;
-    }
 
-    stats_dir = g_build_path (G_DIR_SEPARATOR_S, "/sys/block", dm_node, "vdo/statistics", NULL);
-    dir = g_dir_open (stats_dir, 0, &l_error);
+    dir = g_dir_open (stats_dir, 0, error);
     if (dir == NULL) {
-        bd_utils_log_format (BD_UTILS_LOG_INFO,
-                             "Failed to read VDO stats using the new API, falling back to %s: %s",
-                             VDO_SYS_PATH, l_error->message);
+        g_prefix_error (error, "Error reading statistics from %s: ", stats_dir);
         g_free (stats_dir);
-        g_clear_error (&l_error);
-
-        /* lets try /sys/kvdo */
-        stats_dir = g_build_path (G_DIR_SEPARATOR_S, VDO_SYS_PATH, name, "statistics", NULL);
-        dir = g_dir_open (stats_dir, 0, error);
-        if (dir == NULL) {
-            g_prefix_error (error, "Error reading statistics from %s: ", stats_dir);
-            g_free (stats_dir);
-            return NULL;
-        }
+        return NULL;
     }
 
     stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
@@ -208,3 +262,143 @@ vdo_get_stats_full (const gchar *name, GError **error) {
 
     return stats;
 }
+
+static void _stats_reader_free (StatsReader *reader) {
+    for (guint i = 0; i < STAT_LAST; i++)
+        if (reader->fds[i] >= 0)
+            close (reader->fds[i]);
+    g_free (reader);
+}
+
+static StatsReader* _stats_reader_new (const gchar *name, GError **error) {
+    StatsReader *reader = NULL;
+    gchar *stats_dir = NULL;
+    gchar *path = NULL;
+
+    stats_dir = _get_stats_dir (name, error);
+    if (stats_dir == NULL)
+        return NULL;
+
+    reader = g_new0 (StatsReader, 1);
+    for (guint i = 0; i < STAT_LAST; i++) {
+        path = g_build_filename (stats_dir, stats_keys[i], NULL);
+        /* not all counters are available with all kvdo versions */
+        reader->fds[i] = open (path, O_RDONLY|O_CLOEXEC);
+        g_free (path);
+    }
+    g_free (stats_dir);
+
+    return reader;
+}
+
+/* reads all the counters, -1 is used for those not available, returns
+   FALSE if some of the files cannot be read anymore (e.g. the pool was
+   removed) */
+static gboolean _stats_reader_read (StatsReader *reader, gint64 *values) {
+    gchar buf[32];
+    gssize len = 0;
+    gchar *endptr = NULL;
+
+    for (guint i = 0; i < STAT_LAST; i++) {
+        values[i] = -1;
+        if (reader->fds[i] < 0)
+            continue;
+
+        len = pread (reader->fds[i], buf, sizeof (buf) - 1, 0);
+        if (len < 0)
+            return FALSE;
+        buf[len] = '\0';
+
+        values[i] = g_ascii_strtoll (buf, &endptr, 0);
+        if (endptr == buf || (*endptr != '\0' && *endptr != '\n'))
+            values[i] = -1;
+    }
+
+    return TRUE;
+}
+
+/* reads only the counters needed for BDLVMVDOStats and computes the derived
+   values from them directly, the statistics files are kept open between calls
+   (until vdo_stats_close() is called) */
+G_GNUC_INTERNAL BDLVMVDOStats *
+vdo_get_stats (const gchar *name, GError **error) {
+    StatsReader *reader = NULL;
+    BDLVMVDOStats *stats = NULL;
+    gint64 values[STAT_LAST];
+    gint64 used_blocks = 0;
+    gint64 savings = 0;
+    gboolean success = FALSE;
+
+    g_mutex_lock (&readers_lock);
+    if (!readers)
+        readers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) _stats_reader_free);
+
+    /* an already open reader may belong to a removed (or recreated) pool,
+       try again with a new one if reading fails */
+    reader = g_hash_table_lookup (readers, name);
+    if (reader) {
+        success = _stats_reader_read (reader, values);
+        if (!success)
+            g_hash_table_remove (readers, name);
+    }
+
+    if (!success) {
+        reader = _stats_reader_new (name, error);
+        if (!reader) {
+            g_mutex_unlock (&readers_lock);
+            return NULL;
+        }
+
+        success = _stats_reader_read (reader, values);
+        if (!success) {
+            g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                         "Error reading statistics for %s: %m", name);
+            _stats_reader_free (reader);
+            g_mutex_unlock (&readers_lock);
+            return NULL;
+        }
+        g_hash_table_insert (readers, g_strdup (name), reader);
+    }
+    g_mutex_unlock (&readers_lock);
+
+    stats = g_new0 (BDLVMVDOStats, 1);
+    stats->block_size = values[STAT_BLOCK_SIZE];
+    stats->logical_block_size = values[STAT_LOGICAL_BLOCK_SIZE];
+    stats->physical_blocks = values[STAT_PHYSICAL_BLOCKS];
+    stats->data_blocks_used = values[STAT_DATA_BLOCKS_USED];
+    stats->overhead_blocks_used = values[STAT_OVERHEAD_BLOCKS_USED];
+    stats->logical_blocks_used = values[STAT_LOGICAL_BLOCKS_USED];
+
+    /* the same values as computed by add_computed_stats() */
+    stats->used_percent = -1;
+    stats->saving_percent = -1;
+    if (stats->physical_blocks > 0 && stats->data_blocks_used >= 0 &&
+        stats->overhead_blocks_used >= 0 && stats->logical_blocks_used >= 0) {
+        used_blocks = stats->data_blocks_used + stats->overhead_blocks_used;
+        stats->used_percent = (gint64) (100.0 * (gfloat) used_blocks / (gfloat) stats->physical_blocks + 1.0);
+        savings = (stats->logical_blocks_used > 0) ? (gint64) (100.0 * (gfloat) (stats->logical_blocks_used - stats->data_blocks_used) / (gfloat) stats->logical_blocks_used) : 100;
+        if (savings >= 0)
+            stats->saving_percent = savings;
+    }
+
+    stats->write_amplification_ratio = -1;
+    if (values[STAT_BIOS_META_WRITE] >= 0 && values[STAT_BIOS_OUT_WRITE] >= 0 && values[STAT_BIOS_IN_WRITE] >= 0) {
+        if (values[STAT_BIOS_IN_WRITE] == 0)
+            stats->write_amplification_ratio = 0;
+        else
+            /* rounded to two decimal places like the string value */
+            stats->write_amplification_ratio = (gint64) (100.0 * (gfloat) (values[STAT_BIOS_META_WRITE] + values[STAT_BIOS_OUT_WRITE]) / (gfloat) values[STAT_BIOS_IN_WRITE] + 0.5) / 100.0;
+    }
+
+    return stats;
+}
+
+G_GNUC_INTERNAL void
+vdo_stats_close (void) {
+    g_mutex_lock (&readers_lock);
+    if (readers) {
+        g_hash_table_destroy (readers);
+        readers = NULL;
+    }
+    g_mutex_unlock (&readers_lock);
+}
@@ -25,12 +25,20 @@ the :class:`ErrorProxy` class and makes sure the exception transformation
 happens. It of course calls the ``swap_swapon`` function internally so there's
 no code duplication and it propagates non-callable objects directly.
 
+Long-running functions can be awaited from :mod:`asyncio` code using
+:func:`run_async` which runs them in a separate thread and returns an
+:class:`AsyncOperation` instance. Awaiting it gives the result of the function,
+iterating over it asynchronously gives the progress reported by the function
+and cancelling it terminates the external utility the function is running.
+
 """
 
+import asyncio
 import copy
 import inspect
 import os
 import re
+import threading
 from collections import namedtuple, defaultdict
 
 from bytesize import Size
@@ -39,6 +47,7 @@ from gi.module import FunctionInfo
 from gi.overrides import override
 from gi.repository import GLib
 from gi.repository import GObject
+from gi.repository import Gio
 
 BlockDev = modules['BlockDev']._introspection_module
 __all__ = []
@@ -135,7 +144,9 @@ def _get_extra(extra, kwargs, cmd_extra=True):
 
 
 class FSMkfsOptions(BlockDev.FSMkfsOptions):
-    def __new__(cls, label=None, uuid=None, dry_run=False, no_discard=False, force=False, no_pt=False):
+    def __new__(cls, label=None, uuid=None, dry_run=False, no_discard=False, force=False, no_pt=False,
+                lazy_init=False, stripe_from_topology=False, stripe_unit=0, stripe_width=0, log_size=0,
+                inode_size=0, log_device=None):
         ret = BlockDev.FSMkfsOptions()
         ret.__class__ = cls
 
@@ -145,12 +156,62 @@ class FSMkfsOptions(BlockDev.FSMkfsOptions):
         ret.no_discard = no_discard
         ret.force = force
         ret.no_pt = no_pt
+        ret.lazy_init = lazy_init
+        ret.stripe_from_topology = stripe_from_topology
+        ret.stripe_unit = stripe_unit
+        ret.stripe_width = stripe_width
+        ret.log_size = log_size
+        ret.inode_size = inode_size
+        ret.log_device = log_device
 
         return ret
 FSMkfsOptions = override(FSMkfsOptions)
 __all__.append("FSMkfsOptions")
 
 
+class LVMCacheSettings(BlockDev.LVMCacheSettings):
+    def __new__(cls, chunk_size=0, migration_threshold=0, policy=None, policy_settings=None,
+                high_watermark=0, low_watermark=0, writeback_jobs=0, autocommit_blocks=0, autocommit_time=0):
+        ret = BlockDev.LVMCacheSettings()
+        ret.__class__ = cls
+
+        ret.chunk_size = chunk_size
+        ret.migration_threshold = migration_threshold
+        ret.policy = policy
+        ret.policy_settings = policy_settings
+        ret.high_watermark = high_watermark
+        ret.low_watermark = low_watermark
+        ret.writeback_jobs = writeback_jobs
+        ret.autocommit_blocks = autocommit_blocks
+        ret.autocommit_time = autocommit_time
+
+        return ret
+LVMCacheSettings = override(LVMCacheSettings)
+__all__.append("LVMCacheSettings")
+
+
+class LVMVDOSettings(BlockDev.LVMVDOSettings):
+    def __new__(cls, ack_threads=0, bio_threads=0, bio_rotation=0, cpu_threads=0, hash_zone_threads=0,
+                logical_threads=0, physical_threads=0, slab_size=0, block_map_cache_size=0, max_discard=0):
+        ret = BlockDev.LVMVDOSettings()
+        ret.__class__ = cls
+
+        ret.ack_threads = ack_threads
+        ret.bio_threads = bio_threads
+        ret.bio_rotation = bio_rotation
+        ret.cpu_threads = cpu_threads
+        ret.hash_zone_threads = hash_zone_threads
+        ret.logical_threads = logical_threads
+        ret.physical_threads = physical_threads
+        ret.slab_size = slab_size
+        ret.block_map_cache_size = block_map_cache_size
+        ret.max_discard = max_discard
+
+        return ret
+LVMVDOSettings = override(LVMVDOSettings)
+__all__.append("LVMVDOSettings")
+
+
 _init = BlockDev.init
 @override(BlockDev.init)
 def init(require_plugins=None, log_func=None):
@@ -280,6 +341,16 @@ class CryptoLUKSExtra(BlockDev.CryptoLUKSExtra):
 CryptoLUKSExtra = override(CryptoLUKSExtra)
 __all__.append("CryptoLUKSExtra")
 
+class CryptoLUKSReencryptParams(BlockDev.CryptoLUKSReencryptParams):
+    def __new__(cls, key_size=0, cipher=None, cipher_mode=None, resilience=None, hash=None, max_hotzone_size=0, max_bandwidth=0, offline=False, pbkdf=None):  # pylint: disable=redefined-builtin
+        ret = BlockDev.CryptoLUKSReencryptParams.new(key_size, cipher, cipher_mode, resilience, hash, max_hotzone_size, max_bandwidth, offline, pbkdf)
+        ret.__class__ = cls
+        return ret
+    def __init__(self, *args, **kwargs):   # pylint: disable=unused-argument
+        super(CryptoLUKSReencryptParams, self).__init__()  #pylint: disable=bad-super-call
+CryptoLUKSReencryptParams = override(CryptoLUKSReencryptParams)
+__all__.append("CryptoLUKSReencryptParams")
+
 class CryptoKeyslotContext(BlockDev.CryptoKeyslotContext):
     def __new__(cls, passphrase=None, keyfile=None, keyfile_offset=0, key_size=0, keyring=None, volume_key=None):
         if sum(bool(x) for x in (passphrase, keyfile, keyring, volume_key)) != 1:
@@ -322,6 +393,12 @@ def crypto_luks_resize(luks_device, size=0, context=None):
     return _crypto_luks_resize(luks_device, size, context)
 __all__.append("crypto_luks_resize")
 
+_crypto_luks_resume = BlockDev.crypto_luks_resume
+@override(BlockDev.crypto_luks_resume)
+def crypto_luks_resume(luks_device, context=None):
+    return _crypto_luks_resume(luks_device, context)
+__all__.append("crypto_luks_resume")
+
 _crypto_escrow_device = BlockDev.crypto_escrow_device
 @override(BlockDev.crypto_escrow_device)
 def crypto_escrow_device(device, passphrase, cert_data, directory, backup_passphrase=None):
@@ -363,8 +440,11 @@ __all__.append("crypto_keyring_add_key")
 
 
 class CryptoIntegrityExtra(BlockDev.CryptoIntegrityExtra):
-    def __new__(cls, sector_size=0, journal_size=0, journal_watermark=0, journal_commit_time=0, interleave_sectors=0, tag_size=0, buffer_sectors=0):
+    def __new__(cls, sector_size=0, journal_size=0, journal_watermark=0, journal_commit_time=0, interleave_sectors=0, tag_size=0, buffer_sectors=0,
+                bitmap_sectors_per_bit=0, bitmap_flush_time=0):
         ret = BlockDev.CryptoIntegrityExtra.new(sector_size, journal_size, journal_watermark, journal_commit_time, interleave_sectors, tag_size, buffer_sectors)
+        ret.bitmap_sectors_per_bit = bitmap_sectors_per_bit
+        ret.bitmap_flush_time = bitmap_flush_time
         ret.__class__ = cls
         return ret
     def __init__(self, *args, **kwargs):   # pylint: disable=unused-argument
@@ -405,6 +485,24 @@ def loop_setup(file, offset=0, size=0, read_only=False, part_scan=True, sector_s
     return _loop_setup(file, offset, size, read_only, part_scan, sector_size)
 __all__.append("loop_setup")
 
+_loop_setup_with_flags = BlockDev.loop_setup_with_flags
+@override(BlockDev.loop_setup_with_flags)
+def loop_setup_with_flags(file, offset=0, size=0, flags=BlockDev.LoopSetupFlags.PART_SCAN, sector_size=0):
+    return _loop_setup_with_flags(file, offset, size, flags, sector_size)
+__all__.append("loop_setup_with_flags")
+
+_loop_setup_many = BlockDev.loop_setup_many
+@override(BlockDev.loop_setup_many)
+def loop_setup_many(files, flags=BlockDev.LoopSetupFlags.PART_SCAN, sector_size=0, max_workers=0):
+    return _loop_setup_many(files, flags, sector_size, max_workers)
+__all__.append("loop_setup_many")
+
+_loop_teardown_many = BlockDev.loop_teardown_many
+@override(BlockDev.loop_teardown_many)
+def loop_teardown_many(loops, max_workers=0):
+    return _loop_teardown_many(loops, max_workers)
+__all__.append("loop_teardown_many")
+
 
 # XXX enums with just one member are broken with GI
 class LoopTech():
@@ -424,6 +522,18 @@ def fs_clean(spec, force=False):
     return _fs_clean(spec, force)
 __all__.append("fs_clean")
 
+_fs_clean_device = BlockDev.fs_clean_device
+@override(BlockDev.fs_clean_device)
+def fs_clean_device(device, mode, force=False):
+    return _fs_clean_device(device, mode, force)
+__all__.append("fs_clean_device")
+
+_fs_clean_many = BlockDev.fs_clean_many
+@override(BlockDev.fs_clean_many)
+def fs_clean_many(devices, mode, force=False, max_workers=0):
+    return _fs_clean_many(devices, mode, force, max_workers)
+__all__.append("fs_clean_many")
+
 _fs_unmount = BlockDev.fs_unmount
 @override(BlockDev.fs_unmount)
 def fs_unmount(spec, lazy=False, force=False, extra=None, **kwargs):
@@ -447,6 +557,15 @@ def fs_mkfs(device, fstype, options=None, extra=None, **kwargs):
     return _fs_mkfs(device, fstype, options, extra)
 __all__.append("fs_mkfs")
 
+_fs_mkfs_many = BlockDev.fs_mkfs_many
+@override(BlockDev.fs_mkfs_many)
+def fs_mkfs_many(devices, fstype, options=None, extra=None, max_workers=0, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    if options is None:
+        options = FSMkfsOptions()
+    return _fs_mkfs_many(devices, fstype, options, extra, max_workers)
+__all__.append("fs_mkfs_many")
+
 _fs_ext2_mkfs = BlockDev.fs_ext2_mkfs
 @override(BlockDev.fs_ext2_mkfs)
 def fs_ext2_mkfs(device, extra=None, **kwargs):
@@ -906,6 +1025,27 @@ def lvm_cache_attach(vg_name, data_lv, cache_pool_lv, extra=None, **kwargs):
     return _lvm_cache_attach(vg_name, data_lv, cache_pool_lv, extra)
 __all__.append("lvm_cache_attach")
 
+_lvm_cache_attach_with_settings = BlockDev.lvm_cache_attach_with_settings
+@override(BlockDev.lvm_cache_attach_with_settings)
+def lvm_cache_attach_with_settings(vg_name, data_lv, cache_pool_lv, settings=None, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _lvm_cache_attach_with_settings(vg_name, data_lv, cache_pool_lv, settings, extra)
+__all__.append("lvm_cache_attach_with_settings")
+
+_lvm_cache_set_settings = BlockDev.lvm_cache_set_settings
+@override(BlockDev.lvm_cache_set_settings)
+def lvm_cache_set_settings(vg_name, cached_lv, settings, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _lvm_cache_set_settings(vg_name, cached_lv, settings, extra)
+__all__.append("lvm_cache_set_settings")
+
+_lvm_writecache_attach_with_settings = BlockDev.lvm_writecache_attach_with_settings
+@override(BlockDev.lvm_writecache_attach_with_settings)
+def lvm_writecache_attach_with_settings(vg_name, data_lv, cache_lv, settings=None, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _lvm_writecache_attach_with_settings(vg_name, data_lv, cache_lv, settings, extra)
+__all__.append("lvm_writecache_attach_with_settings")
+
 _lvm_cache_detach = BlockDev.lvm_cache_detach
 @override(BlockDev.lvm_cache_detach)
 def lvm_cache_detach(vg_name, cached_lv, destroy=True, extra=None, **kwargs):
@@ -946,6 +1086,13 @@ def lvm_vdo_pool_create(vg_name, lv_name, pool_name, data_size, virtual_size, in
     return _lvm_vdo_pool_create(vg_name, lv_name, pool_name, data_size,virtual_size, index_memory, compression, deduplication, write_policy, extra)
 __all__.append("lvm_vdo_pool_create")
 
+_lvm_vdo_pool_create_with_settings = BlockDev.lvm_vdo_pool_create_with_settings
+@override(BlockDev.lvm_vdo_pool_create_with_settings)
+def lvm_vdo_pool_create_with_settings(vg_name, lv_name, pool_name, data_size, virtual_size, index_memory=0, compression=True, deduplication=True, write_policy=BlockDev.LVMVDOWritePolicy.AUTO, settings=None, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _lvm_vdo_pool_create_with_settings(vg_name, lv_name, pool_name, data_size, virtual_size, index_memory, compression, deduplication, write_policy, settings, extra)
+__all__.append("lvm_vdo_pool_create_with_settings")
+
 _lvm_vdo_resize = BlockDev.lvm_vdo_resize
 @override(BlockDev.lvm_vdo_resize)
 def lvm_vdo_resize(vg_name, lv_name, size, extra=None, **kwargs):
@@ -988,6 +1135,13 @@ def lvm_vdo_disable_deduplication(vg_name, pool_name, extra=None, **kwargs):
     return _lvm_vdo_disable_deduplication(vg_name, pool_name, extra)
 __all__.append("lvm_vdo_disable_deduplication")
 
+_lvm_vdo_pool_set_settings = BlockDev.lvm_vdo_pool_set_settings
+@override(BlockDev.lvm_vdo_pool_set_settings)
+def lvm_vdo_pool_set_settings(vg_name, pool_name, settings, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _lvm_vdo_pool_set_settings(vg_name, pool_name, settings, extra)
+__all__.append("lvm_vdo_pool_set_settings")
+
 _lvm_vdo_pool_convert = BlockDev.lvm_vdo_pool_convert
 @override(BlockDev.lvm_vdo_pool_convert)
 def lvm_vdo_pool_convert(vg_name, lv_name, pool_name, virtual_size, index_memory=0, compression=True, deduplication=True, write_policy=BlockDev.LVMVDOWritePolicy.AUTO, extra=None, **kwargs):
@@ -1059,6 +1213,13 @@ if os.uname()[4].startswith('s390'):
         return _s390_dasd_format(dasd, extra)
     __all__.append("s390_dasd_format")
 
+    _s390_dasd_format_many = BlockDev.s390_dasd_format_many
+    @override(BlockDev.s390_dasd_format_many)
+    def s390_dasd_format_many(dasds, max_workers=0, extra=None, **kwargs):
+        extra = _get_extra(extra, kwargs)
+        return _s390_dasd_format_many(dasds, max_workers, extra)
+    __all__.append("s390_dasd_format_many")
+
 
 _swap_mkswap = BlockDev.swap_mkswap
 @override(BlockDev.swap_mkswap)
@@ -1080,6 +1241,16 @@ class SwapTech():
 __all__.append("SwapTech")
 
 
+class PartCreateSpec(BlockDev.PartCreateSpec):
+    def __new__(cls, type=BlockDev.PartTypeReq.NORMAL, start=0, size=0, align=BlockDev.PartAlign.OPTIMAL, name=None, type_guid=None, uuid=None):  # pylint: disable=redefined-builtin
+        ret = BlockDev.PartCreateSpec.new(type, start, size, align, name, type_guid, uuid)
+        ret.__class__ = cls
+        return ret
+    def __init__(self, *args, **kwargs):  # pylint: disable=unused-argument
+        super(PartCreateSpec, self).__init__()  #pylint: disable=bad-super-call
+PartCreateSpec = override(PartCreateSpec)
+__all__.append("PartCreateSpec")
+
 _part_create_table = BlockDev.part_create_table
 @override(BlockDev.part_create_table)
 def part_create_table(disk, type, ignore_existing=True):
@@ -1136,6 +1307,20 @@ def nvme_connect(subsysnqn, transport, transport_addr, transport_svcid, host_tra
     return _nvme_connect(subsysnqn, transport, transport_addr, transport_svcid, host_traddr, host_iface, host_nqn, host_id, extra)
 __all__.append("nvme_connect")
 
+_nvme_discover = BlockDev.nvme_discover
+@override(BlockDev.nvme_discover)
+def nvme_discover(transport, transport_addr=None, transport_svcid=None, host_traddr=None, host_iface=None, host_nqn=None, host_id=None, refresh=False, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _nvme_discover(transport, transport_addr, transport_svcid, host_traddr, host_iface, host_nqn, host_id, refresh, extra)
+__all__.append("nvme_discover")
+
+_nvme_connect_many = BlockDev.nvme_connect_many
+@override(BlockDev.nvme_connect_many)
+def nvme_connect_many(targets, host_traddr=None, host_iface=None, host_nqn=None, host_id=None, max_workers=0, max_retries=3, extra=None, **kwargs):
+    extra = _get_extra(extra, kwargs)
+    return _nvme_connect_many(targets, host_traddr, host_iface, host_nqn, host_id, max_workers, max_retries, extra)
+__all__.append("nvme_connect_many")
+
 
 ## defined in this overrides only!
 def plugin_specs_from_names(plugin_names):
@@ -1395,3 +1580,119 @@ __all__.append("s390")
 
 utils = ErrorProxy("utils", BlockDev, [(GLib.Error, UtilsError)])
 __all__.append("utils")
+
+
+ProgressReport = namedtuple("ProgressReport", ["task_id", "status", "completion", "msg"])
+__all__.append("ProgressReport")
+
+class AsyncOperation(object):
+    """Awaitable running a (blocking) libblockdev function in a separate thread
+
+    Awaiting the object gives the result of the function or raises the
+    exception raised by the function. The progress reported by the function
+    (and the functions it calls) is available as :class:`ProgressReport`
+    instances by iterating over the object asynchronously (``async for report
+    in operation``), the iteration ends when the function returns.
+
+    Cancelling the task awaiting the object (or using :meth:`cancel`) raises
+    :exc:`asyncio.CancelledError` from the ``await`` right away and terminates
+    the external utility the function is running (with ``SIGTERM``, see
+    ``bd_utils_exec_set_thread_cancellable()``). Functions not running any
+    external utility can't be interrupted, they finish in the background.
+
+    Instances are meant to be created using :func:`run_async`.
+
+    """
+
+    def __init__(self, func, args, kwargs):
+        self._func = func
+        self._args = args
+        self._kwargs = kwargs
+        self._loop = asyncio.get_running_loop()
+        self._future = self._loop.create_future()
+        self._future.add_done_callback(self._future_done)
+        self._progress = asyncio.Queue()
+        self._progress_done = False
+        self._cancellable = Gio.Cancellable()
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+
+    def _call_in_loop(self, func, *args):
+        try:
+            self._loop.call_soon_threadsafe(func, *args)
+        except RuntimeError:
+            # the loop is closed, nobody is waiting for the results anymore
+            pass
+
+    def _report(self, task_id, status, completion, msg):
+        self._call_in_loop(self._progress.put_nowait, ProgressReport(task_id, status, completion, msg))
+
+    def _run(self):
+        BlockDev.utils_init_prog_reporting_thread(self._report)
+        BlockDev.utils_exec_set_thread_cancellable(self._cancellable)
+        try:
+            ret = self._func(*self._args, **self._kwargs)
+        except Exception as e:  # pylint: disable=broad-except
+            self._call_in_loop(self._finish, None, e)
+        else:
+            self._call_in_loop(self._finish, ret, None)
+        finally:
+            BlockDev.utils_exec_set_thread_cancellable(None)
+            BlockDev.utils_init_prog_reporting_thread(None)
+
+    def _finish(self, ret, exc):
+        if not self._future.done():
+            if exc is not None:
+                self._future.set_exception(exc)
+            else:
+                self._future.set_result(ret)
+        self._progress.put_nowait(None)
+
+    def _future_done(self, future):
+        if future.cancelled():
+            self._cancellable.cancel()
+
+    def cancel(self):
+        """Cancel the operation
+
+        :returns: whether the operation was cancelled or not (finished already)
+
+        """
+        return self._future.cancel()
+
+    def done(self):
+        """:returns: whether the operation is done (finished or cancelled) or not"""
+        return self._future.done()
+
+    def __await__(self):
+        return self._future.__await__()
+
+    def __aiter__(self):
+        return self
+
+    async def __anext__(self):
+        if self._progress_done:
+            raise StopAsyncIteration
+        report = await self._progress.get()
+        if report is None:
+            self._progress_done = True
+            raise StopAsyncIteration
+        return report
+__all__.append("AsyncOperation")
+
+def run_async(func, *args, **kwargs):
+    """Run a libblockdev function without blocking the running :mod:`asyncio` loop
+
+    :param func: the function to run (e.g. ``BlockDev.fs_mkfs`` or ``BlockDev.lvm.pvmove``)
+    :param args: positional arguments for :param:`func`
+    :param kwargs: keyword arguments for :param:`func`
+    :returns: the operation running :param:`func`
+    :rtype: :class:`AsyncOperation`
+
+    Needs to be called from a coroutine (or a callback) running in the loop.
+    Every operation gets its own thread so the number of parallel operations
+    is not limited by a thread pool.
+
+    """
+    return AsyncOperation(func, args, kwargs)
+__all__.append("run_async")
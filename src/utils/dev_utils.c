@@ -18,10 +18,81 @@
  */
 
 #include <glib.h>
+#include <glib-unix.h>
 #include <libudev.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
 
 #include "dev_utils.h"
 
+/* cached results of the device resolution and the symlink lookups, an entry is
+   only used if the node it was created for didn't change since then */
+typedef struct DevCacheEntry {
+    dev_t rdev;
+    ino_t ino;
+    mode_t mode;
+    time_t ctime_sec;
+    glong ctime_nsec;
+    gchar *resolved;
+    gchar **symlinks;
+} DevCacheEntry;
+
+/* udev monitor thread, one instance per start of the event hub */
+typedef struct DevEventsMonitor {
+    struct udev *udev;
+    struct udev_monitor *monitor;
+    gint wakeup[2];
+    GThread *thread;
+} DevEventsMonitor;
+
+typedef struct DevEventsSubscriber {
+    guint id;
+    BDUtilsDevEventFunc func;
+    gpointer user_data;
+} DevEventsSubscriber;
+
+static GMutex dev_events_lock;
+static GSList *dev_events_subscribers = NULL;
+static guint dev_events_next_id = 1;
+static DevEventsMonitor *dev_events_monitor = NULL;
+
+static gint dev_cache_on = 0;
+static GMutex dev_cache_lock;
+static guint dev_cache_subscription = 0;
+/* full path -> DevCacheEntry with the resolved path */
+static GHashTable *resolve_cache = NULL;
+/* resolved path -> DevCacheEntry with the symlinks */
+static GHashTable *symlinks_cache = NULL;
+
+static void dev_cache_entry_free (DevCacheEntry *entry) {
+    if (!entry)
+        return;
+    g_free (entry->resolved);
+    g_strfreev (entry->symlinks);
+    g_free (entry);
+}
+
+static DevCacheEntry* dev_cache_entry_new (const struct stat *st) {
+    DevCacheEntry *entry = g_new0 (DevCacheEntry, 1);
+
+    entry->rdev = st->st_rdev;
+    entry->ino = st->st_ino;
+    entry->mode = st->st_mode;
+    entry->ctime_sec = st->st_ctim.tv_sec;
+    entry->ctime_nsec = st->st_ctim.tv_nsec;
+
+    return entry;
+}
+
+static gboolean dev_cache_entry_valid (const DevCacheEntry *entry, const struct stat *st) {
+    return entry->rdev == st->st_rdev && entry->ino == st->st_ino && entry->mode == st->st_mode &&
+           entry->ctime_sec == st->st_ctim.tv_sec && entry->ctime_nsec == st->st_ctim.tv_nsec;
+}
+
 /**
  * bd_utils_dev_utils_error_quark: (skip)
  */
@@ -30,27 +101,347 @@ GQuark bd_utils_dev_utils_error_quark (void)
     return g_quark_from_static_string ("g-bd-utils-dev_utils-error-quark");
 }
 
+static void dev_events_dispatch (struct udev_device *device) {
+    const gchar *action = NULL;
+    const gchar *node = NULL;
+    const gchar *dm_name = NULL;
+    guint64 devnum = 0;
+    GSList *item = NULL;
+
+    action = udev_device_get_action (device);
+    node = udev_device_get_devnode (device);
+    if (!action || !node)
+        return;
+    devnum = (guint64) udev_device_get_devnum (device);
+    dm_name = udev_device_get_property_value (device, "DM_NAME");
+
+    g_mutex_lock (&dev_events_lock);
+    for (item = dev_events_subscribers; item; item = item->next) {
+        DevEventsSubscriber *sub = (DevEventsSubscriber *) item->data;
+        sub->func (action, node, devnum, dm_name, sub->user_data);
+    }
+    g_mutex_unlock (&dev_events_lock);
+}
+
+static gpointer dev_events_thread_func (gpointer data) {
+    DevEventsMonitor *mon = (DevEventsMonitor *) data;
+    struct udev_device *device = NULL;
+    struct pollfd fds[2];
+
+    fds[0].fd = udev_monitor_get_fd (mon->monitor);
+    fds[0].events = POLLIN;
+    fds[1].fd = mon->wakeup[0];
+    fds[1].events = POLLIN;
+
+    while (TRUE) {
+        if (poll (fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents != 0)
+            /* asked to stop */
+            break;
+        if (fds[0].revents & POLLIN) {
+            device = udev_monitor_receive_device (mon->monitor);
+            if (device) {
+                dev_events_dispatch (device);
+                udev_device_unref (device);
+            }
+        } else if (fds[0].revents != 0)
+            break;
+    }
+
+    return NULL;
+}
+
+static void dev_events_monitor_free (DevEventsMonitor *mon) {
+    if (mon->wakeup[0] >= 0)
+        close (mon->wakeup[0]);
+    if (mon->wakeup[1] >= 0)
+        close (mon->wakeup[1]);
+    if (mon->monitor)
+        udev_monitor_unref (mon->monitor);
+    if (mon->udev)
+        udev_unref (mon->udev);
+    g_free (mon);
+}
+
+static DevEventsMonitor* dev_events_monitor_start (GError **error) {
+    DevEventsMonitor *mon = g_new0 (DevEventsMonitor, 1);
+
+    mon->wakeup[0] = -1;
+    mon->wakeup[1] = -1;
+
+    mon->udev = udev_new ();
+    if (mon->udev)
+        mon->monitor = udev_monitor_new_from_netlink (mon->udev, "udev");
+    if (!mon->monitor) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to create udev monitor");
+        dev_events_monitor_free (mon);
+        return NULL;
+    }
+
+    /* DM devices are block devices too, their uevents come with the DM_* properties */
+    if (udev_monitor_filter_add_match_subsystem_devtype (mon->monitor, "block", NULL) < 0 ||
+        udev_monitor_enable_receiving (mon->monitor) < 0) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Failed to start receiving udev events for block devices");
+        dev_events_monitor_free (mon);
+        return NULL;
+    }
+
+    if (!g_unix_open_pipe (mon->wakeup, FD_CLOEXEC, error)) {
+        g_prefix_error (error, "Failed to create udev monitor: ");
+        mon->wakeup[0] = -1;
+        mon->wakeup[1] = -1;
+        dev_events_monitor_free (mon);
+        return NULL;
+    }
+
+    mon->thread = g_thread_try_new ("bd-udev-events", dev_events_thread_func, mon, error);
+    if (!mon->thread) {
+        dev_events_monitor_free (mon);
+        return NULL;
+    }
+
+    return mon;
+}
+
+static void dev_events_monitor_stop (DevEventsMonitor *mon) {
+    gssize ret = 0;
+
+    do
+        ret = write (mon->wakeup[1], "x", 1);
+    while (ret < 0 && errno == EINTR);
+    g_thread_join (mon->thread);
+    dev_events_monitor_free (mon);
+}
+
 /**
- * bd_utils_resolve_device:
- * @dev_spec: specification of the device (e.g. "/dev/sda", any symlink, or the name of a file
- *            under "/dev")
+ * bd_utils_dev_events_subscribe:
+ * @func: (scope forever): function to call for udev events for block devices
+ * @user_data: (closure): data to pass to @func
  * @error: (out) (optional): place to store error (if any)
  *
- * Returns: (transfer full): the full real path of the device (e.g. "/dev/md126"
- *                           for "/dev/md/my_raid") or %NULL in case of error
+ * Subscribes @func to udev events for block devices (including DM devices). The
+ * events are received by a thread (and a udev monitor) shared by all the
+ * subscribers which is started with the first subscription and stopped with
+ * the last bd_utils_dev_events_unsubscribe(). This is meant for invalidating
+ * cached information about particular devices as soon as they change.
+ *
+ * Returns: ID of the subscription (to be passed to bd_utils_dev_events_unsubscribe())
+ *          or 0 in case of error
  */
-gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error) {
+guint bd_utils_dev_events_subscribe (BDUtilsDevEventFunc func, gpointer user_data, GError **error) {
+    DevEventsSubscriber *sub = NULL;
+    guint ret = 0;
+
+    g_mutex_lock (&dev_events_lock);
+    if (!dev_events_monitor) {
+        dev_events_monitor = dev_events_monitor_start (error);
+        if (!dev_events_monitor) {
+            g_mutex_unlock (&dev_events_lock);
+            return 0;
+        }
+    }
+
+    sub = g_new0 (DevEventsSubscriber, 1);
+    sub->id = dev_events_next_id++;
+    sub->func = func;
+    sub->user_data = user_data;
+    dev_events_subscribers = g_slist_prepend (dev_events_subscribers, sub);
+    ret = sub->id;
+    g_mutex_unlock (&dev_events_lock);
+
+    return ret;
+}
+
+/**
+ * bd_utils_dev_events_unsubscribe:
+ * @id: ID of the subscription as returned by bd_utils_dev_events_subscribe()
+ *
+ * Cancels the subscription @id. The subscribed function is not called anymore
+ * once this function returns.
+ */
+void bd_utils_dev_events_unsubscribe (guint id) {
+    DevEventsMonitor *mon = NULL;
+    GSList *item = NULL;
+
+    g_mutex_lock (&dev_events_lock);
+    for (item = dev_events_subscribers; item; item = item->next) {
+        if (((DevEventsSubscriber *) item->data)->id == id) {
+            g_free (item->data);
+            dev_events_subscribers = g_slist_delete_link (dev_events_subscribers, item);
+            break;
+        }
+    }
+    if (!dev_events_subscribers) {
+        mon = dev_events_monitor;
+        dev_events_monitor = NULL;
+    }
+    g_mutex_unlock (&dev_events_lock);
+
+    /* the thread may be waiting for the lock to dispatch an event, stop it without the lock */
+    if (mon)
+        dev_events_monitor_stop (mon);
+}
+
+/**
+ * bd_utils_dev_events_running:
+ *
+ * Returns: whether the udev events for block devices are being received (i.e.
+ *          there is at least one subscriber) or not
+ */
+gboolean bd_utils_dev_events_running (void) {
+    gboolean ret = FALSE;
+
+    g_mutex_lock (&dev_events_lock);
+    ret = dev_events_monitor != NULL;
+    g_mutex_unlock (&dev_events_lock);
+
+    return ret;
+}
+
+static void dev_cache_event (const gchar *action G_GNUC_UNUSED, const gchar *device, guint64 devnum G_GNUC_UNUSED,
+                             const gchar *dm_name, gpointer user_data G_GNUC_UNUSED) {
+    gchar *mapper_path = NULL;
+
+    bd_utils_dev_cache_invalidate (device);
+    if (dm_name) {
+        mapper_path = g_strdup_printf ("/dev/mapper/%s", dm_name);
+        bd_utils_dev_cache_invalidate (mapper_path);
+        g_free (mapper_path);
+    }
+}
+
+/**
+ * bd_utils_dev_cache_enable:
+ * @enable: whether to enable or disable the cache
+ *
+ * Enables or disables caching of the results of bd_utils_resolve_device() and
+ * bd_utils_get_device_symlinks(). A cached result is only used if the device
+ * node (or the symlink) it was obtained for still has the same inode, device
+ * number and change time. Changes of the symlinks udev maintains for a device
+ * don't change the device node so the cache also subscribes to the udev events
+ * (see bd_utils_dev_events_subscribe()) and drops the entries for the devices
+ * the events are for. If the events cannot be received, the caller is
+ * responsible for calling bd_utils_dev_cache_invalidate() when it learns about
+ * such changes.
+ *
+ * Disabling the cache drops all the cached results. The cache is disabled by
+ * default.
+ */
+void bd_utils_dev_cache_enable (gboolean enable) {
+    GHashTable *old_resolve = NULL;
+    GHashTable *old_symlinks = NULL;
+    guint subscription = 0;
+
+    /* subscriptions are made and cancelled without the cache lock, the
+       subscriber takes it */
+    if (enable && !g_atomic_int_get (&dev_cache_on))
+        /* not being able to receive events is not fatal, entries are validated anyway */
+        subscription = bd_utils_dev_events_subscribe (dev_cache_event, NULL, NULL);
+
+    g_mutex_lock (&dev_cache_lock);
+    if (enable && !resolve_cache) {
+        resolve_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                               (GDestroyNotify) dev_cache_entry_free);
+        symlinks_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                (GDestroyNotify) dev_cache_entry_free);
+    } else if (!enable) {
+        old_resolve = resolve_cache;
+        old_symlinks = symlinks_cache;
+        resolve_cache = NULL;
+        symlinks_cache = NULL;
+    }
+    if (subscription != 0) {
+        if (dev_cache_subscription == 0) {
+            dev_cache_subscription = subscription;
+            subscription = 0;
+        }
+    } else if (!enable) {
+        subscription = dev_cache_subscription;
+        dev_cache_subscription = 0;
+    }
+    g_atomic_int_set (&dev_cache_on, enable);
+    g_mutex_unlock (&dev_cache_lock);
+
+    /* either the cancelled subscription or a redundant new one (concurrent enable) */
+    if (subscription != 0)
+        bd_utils_dev_events_unsubscribe (subscription);
+
+    if (old_resolve)
+        g_hash_table_destroy (old_resolve);
+    if (old_symlinks)
+        g_hash_table_destroy (old_symlinks);
+}
+
+/**
+ * bd_utils_dev_cache_enabled:
+ *
+ * Returns: whether the device resolution cache is enabled or not
+ */
+gboolean bd_utils_dev_cache_enabled (void) {
+    return g_atomic_int_get (&dev_cache_on);
+}
+
+static gboolean dev_cache_entry_matches (gpointer key, gpointer value, gpointer user_data) {
+    DevCacheEntry *entry = (DevCacheEntry *) value;
+    const gchar *dev = (const gchar *) user_data;
+
+    return g_strcmp0 ((const gchar *) key, dev) == 0 || g_strcmp0 (entry->resolved, dev) == 0;
+}
+
+/**
+ * bd_utils_dev_cache_invalidate:
+ * @dev_spec: (nullable): specification of the device (e.g. "/dev/sda", any symlink,
+ *                        or the name of a file under "/dev") or %NULL to drop all
+ *                        the cached results
+ *
+ * Drops the cached results for @dev_spec, i.e. the resolution of @dev_spec itself,
+ * the resolutions of all the symlinks known to point to @dev_spec and its symlinks.
+ */
+void bd_utils_dev_cache_invalidate (const gchar *dev_spec) {
     gchar *path = NULL;
-    gchar *symlink = NULL;
-    GError *l_error = NULL;
 
-    /* TODO: check that the resulting path is a block device? */
+    if (!g_atomic_int_get (&dev_cache_on))
+        return;
 
-    if (!g_str_has_prefix (dev_spec, "/dev/"))
+    if (dev_spec && !g_str_has_prefix (dev_spec, "/dev/"))
         path = g_strdup_printf ("/dev/%s", dev_spec);
     else
         path = g_strdup (dev_spec);
 
+    g_mutex_lock (&dev_cache_lock);
+    if (resolve_cache) {
+        if (!path) {
+            g_hash_table_remove_all (resolve_cache);
+            g_hash_table_remove_all (symlinks_cache);
+        } else {
+            DevCacheEntry *entry = g_hash_table_lookup (resolve_cache, path);
+            gchar *resolved = entry ? g_strdup (entry->resolved) : NULL;
+
+            g_hash_table_foreach_remove (resolve_cache, dev_cache_entry_matches, path);
+            g_hash_table_remove (symlinks_cache, path);
+            if (resolved) {
+                /* other symlinks pointing to the same device */
+                g_hash_table_foreach_remove (resolve_cache, dev_cache_entry_matches, resolved);
+                g_hash_table_remove (symlinks_cache, resolved);
+                g_free (resolved);
+            }
+        }
+    }
+    g_mutex_unlock (&dev_cache_lock);
+
+    g_free (path);
+}
+
+static gchar* resolve_device (gchar *path, GError **error) {
+    gchar *symlink = NULL;
+    GError *l_error = NULL;
+
     symlink = g_file_read_link (path, &l_error);
     if (!symlink) {
         if (g_error_matches (l_error, G_FILE_ERROR, G_FILE_ERROR_INVAL)) {
@@ -75,6 +466,125 @@ gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error) {
     return path;
 }
 
+/* resolves @dev_spec using the cache, @locked says whether the cache lock is
+   held by the caller (batch resolution) */
+static gchar* resolve_device_cached (const gchar *dev_spec, gboolean locked, GError **error) {
+    gchar *path = NULL;
+    gchar *ret = NULL;
+    DevCacheEntry *entry = NULL;
+    struct stat st;
+    gboolean have_stat = FALSE;
+
+    /* TODO: check that the resulting path is a block device? */
+
+    if (!g_str_has_prefix (dev_spec, "/dev/"))
+        path = g_strdup_printf ("/dev/%s", dev_spec);
+    else
+        path = g_strdup (dev_spec);
+
+    if (!g_atomic_int_get (&dev_cache_on))
+        return resolve_device (path, error);
+
+    /* stat before resolving so that a change in between makes the entry stale */
+    have_stat = lstat (path, &st) == 0;
+    if (have_stat) {
+        if (!locked)
+            g_mutex_lock (&dev_cache_lock);
+        if (resolve_cache) {
+            entry = g_hash_table_lookup (resolve_cache, path);
+            if (entry && dev_cache_entry_valid (entry, &st))
+                ret = g_strdup (entry->resolved);
+        }
+        if (!locked)
+            g_mutex_unlock (&dev_cache_lock);
+        if (ret) {
+            g_free (path);
+            return ret;
+        }
+    }
+
+    if (have_stat) {
+        gchar *key = g_strdup (path);
+
+        ret = resolve_device (path, error);
+        if (ret) {
+            entry = dev_cache_entry_new (&st);
+            entry->resolved = g_strdup (ret);
+            if (!locked)
+                g_mutex_lock (&dev_cache_lock);
+            if (resolve_cache)
+                g_hash_table_replace (resolve_cache, key, entry);
+            else {
+                dev_cache_entry_free (entry);
+                g_free (key);
+            }
+            if (!locked)
+                g_mutex_unlock (&dev_cache_lock);
+        } else
+            g_free (key);
+        return ret;
+    }
+
+    return resolve_device (path, error);
+}
+
+/**
+ * bd_utils_resolve_device:
+ * @dev_spec: specification of the device (e.g. "/dev/sda", any symlink, or the name of a file
+ *            under "/dev")
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): the full real path of the device (e.g. "/dev/md126"
+ *                           for "/dev/md/my_raid") or %NULL in case of error
+ */
+gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error) {
+    return resolve_device_cached (dev_spec, FALSE, error);
+}
+
+/**
+ * bd_utils_resolve_devices:
+ * @dev_specs: (array zero-terminated=1): specifications of the devices (e.g. "/dev/sda",
+ *                                        any symlink, or the name of a file under "/dev")
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * The same as bd_utils_resolve_device() but for multiple devices at once. With
+ * the cache enabled (see bd_utils_dev_cache_enable()) the cache is only locked
+ * once for all the devices.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the full real paths of
+ * the devices (in the same order as @dev_specs) or %NULL in case of error (if
+ * any of the devices cannot be resolved)
+ */
+gchar** bd_utils_resolve_devices (const gchar **dev_specs, GError **error) {
+    gchar **ret = NULL;
+    gboolean locked = FALSE;
+    guint n_specs = 0;
+    guint i = 0;
+
+    n_specs = dev_specs ? g_strv_length ((gchar **) dev_specs) : 0;
+    ret = g_new0 (gchar*, n_specs + 1);
+
+    if (g_atomic_int_get (&dev_cache_on)) {
+        g_mutex_lock (&dev_cache_lock);
+        locked = TRUE;
+    }
+
+    for (i = 0; i < n_specs; i++) {
+        ret[i] = resolve_device_cached (dev_specs[i], locked, error);
+        if (!ret[i]) {
+            g_prefix_error (error, "Failed to resolve '%s': ", dev_specs[i]);
+            g_strfreev (ret);
+            ret = NULL;
+            break;
+        }
+    }
+
+    if (locked)
+        g_mutex_unlock (&dev_cache_lock);
+
+    return ret;
+}
+
 /**
  * bd_utils_get_device_symlinks:
  * @dev_spec: specification of the device (e.g. "/dev/sda", any symlink, or the name of a file
@@ -94,11 +604,31 @@ gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error) {
     guint64 n_links = 0;
     guint64 i = 0;
     gchar **ret = NULL;
+    DevCacheEntry *cached = NULL;
+    struct stat st;
+    gboolean have_stat = FALSE;
 
     dev_path = bd_utils_resolve_device (dev_spec, error);
     if (!dev_path)
         return NULL;
 
+    if (g_atomic_int_get (&dev_cache_on)) {
+        have_stat = stat (dev_path, &st) == 0;
+        if (have_stat) {
+            g_mutex_lock (&dev_cache_lock);
+            if (symlinks_cache) {
+                cached = g_hash_table_lookup (symlinks_cache, dev_path);
+                if (cached && dev_cache_entry_valid (cached, &st))
+                    ret = g_strdupv (cached->symlinks);
+            }
+            g_mutex_unlock (&dev_cache_lock);
+            if (ret) {
+                g_free (dev_path);
+                return ret;
+            }
+        }
+    }
+
     context = udev_new ();
     /* dev_path is the full path like "/dev/sda", we only need the device name ("sda") */
     device = udev_device_new_from_subsystem_sysname (context, "block", dev_path + 5);
@@ -121,7 +651,6 @@ gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error) {
         udev_unref (context);
         return NULL;
     }
-    g_free (dev_path);
 
     ent_it = entry;
     while (ent_it) {
@@ -140,5 +669,135 @@ gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error) {
     udev_device_unref (device);
     udev_unref (context);
 
+    if (have_stat) {
+        cached = dev_cache_entry_new (&st);
+        cached->resolved = g_strdup (dev_path);
+        cached->symlinks = g_strdupv (ret);
+        g_mutex_lock (&dev_cache_lock);
+        if (symlinks_cache) {
+            g_hash_table_replace (symlinks_cache, dev_path, cached);
+            dev_path = NULL;
+        } else
+            dev_cache_entry_free (cached);
+        g_mutex_unlock (&dev_cache_lock);
+    }
+    g_free (dev_path);
+
+    return ret;
+}
+
+#define DEV_RETRY_DELAY_MIN_US 50
+#define DEV_RETRY_DELAY_MAX_US (100 * 1000)
+
+/* adds an inotify watch for @device being closed by somebody else or changed,
+   if it doesn't exist (yet), watches its directory for new entries instead */
+static gboolean add_dev_watch (gint inotify_fd, const gchar *device) {
+    gchar *dir = NULL;
+
+    if (inotify_add_watch (inotify_fd, device, IN_CLOSE_WRITE | IN_CLOSE_NOWRITE | IN_ATTRIB) >= 0)
+        return TRUE;
+
+    dir = g_path_get_dirname (device);
+    inotify_add_watch (inotify_fd, dir, IN_CREATE | IN_MOVED_TO | IN_ATTRIB);
+    g_free (dir);
+
+    return FALSE;
+}
+
+/**
+ * bd_utils_dev_retry:
+ * @device: (nullable): device node the attempts depend on
+ * @timeout_ms: how long (in milliseconds) to keep retrying
+ * @attempt: (scope call): function to run until it succeeds
+ * @user_data: (closure): data to pass to @attempt
+ *
+ * Runs @attempt until it succeeds or @timeout_ms passes. Attempts on devices
+ * usually fail because somebody else (udev) has the device open at the moment
+ * or because the device node doesn't exist yet so instead of sleeping for a
+ * fixed time between the attempts, this waits for @device to be closed or
+ * changed (or created) with an exponentially growing limit for the wait
+ * (starting at 50 µs). If @device is %NULL, only the exponential backoff is
+ * used.
+ *
+ * Returns: whether @attempt succeeded or not
+ */
+gboolean bd_utils_dev_retry (const gchar *device, guint timeout_ms, BDUtilsDevRetryFunc attempt, gpointer user_data) {
+    gboolean ret = FALSE;
+    gint64 deadline = 0;
+    gint64 now = 0;
+    gint64 delay = DEV_RETRY_DELAY_MIN_US;
+    gint inotify_fd = -1;
+    gboolean dev_watched = FALSE;
+    struct pollfd pfd;
+    gchar buf[4096];
+
+    if (attempt (user_data))
+        return TRUE;
+
+    deadline = g_get_monotonic_time () + (gint64) timeout_ms * 1000;
+
+    if (device) {
+        inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd >= 0)
+            dev_watched = add_dev_watch (inotify_fd, device);
+    }
+
+    for (now = g_get_monotonic_time (); now < deadline; now = g_get_monotonic_time ()) {
+        delay = MIN (delay, deadline - now);
+        if (inotify_fd >= 0) {
+            pfd.fd = inotify_fd;
+            pfd.events = POLLIN;
+            if (poll (&pfd, 1, (gint) ((delay + 999) / 1000)) > 0)
+                /* just drain the events, we only care that something happened */
+                while (read (inotify_fd, buf, sizeof (buf)) > 0);
+        } else
+            g_usleep (delay);
+
+        if (attempt (user_data)) {
+            ret = TRUE;
+            break;
+        }
+
+        /* the device may have appeared in the meantime */
+        if (inotify_fd >= 0 && !dev_watched)
+            dev_watched = add_dev_watch (inotify_fd, device);
+        delay = MIN (delay * 2, DEV_RETRY_DELAY_MAX_US);
+    }
+
+    if (inotify_fd >= 0)
+        close (inotify_fd);
+
     return ret;
 }
+
+static gboolean dev_open_attempt (gpointer user_data) {
+    gint fd = open ((const gchar *) user_data, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd < 0)
+        return FALSE;
+
+    close (fd);
+    return TRUE;
+}
+
+/**
+ * bd_utils_wait_for_device:
+ * @device: device node to wait for
+ * @timeout_ms: how long (in milliseconds) to wait at most
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Waits for @device to appear and become openable. The wait is driven by
+ * inotify events for the device node (and its directory), see
+ * bd_utils_dev_retry().
+ *
+ * Returns: whether @device is ready (can be opened) or not
+ */
+gboolean bd_utils_wait_for_device (const gchar *device, guint timeout_ms, GError **error) {
+    if (!bd_utils_dev_retry (device, timeout_ms, dev_open_attempt, (gpointer) device)) {
+        g_set_error (error, BD_UTILS_DEV_UTILS_ERROR, BD_UTILS_DEV_UTILS_ERROR_FAILED,
+                     "Device '%s' didn't become ready in %u ms", device, timeout_ms);
+        return FALSE;
+    }
+
+    return TRUE;
+}
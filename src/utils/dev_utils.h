@@ -30,6 +30,42 @@ typedef enum {
 } BDUtilsDevUtilsError;
 
 gchar* bd_utils_resolve_device (const gchar *dev_spec, GError **error);
+gchar** bd_utils_resolve_devices (const gchar **dev_specs, GError **error);
 gchar** bd_utils_get_device_symlinks (const gchar *dev_spec, GError **error);
 
+/**
+ * BDUtilsDevEventFunc:
+ * @action: the udev action (e.g. "add", "change" or "remove")
+ * @device: the device node of the device the event is for (e.g. "/dev/dm-0")
+ * @devnum: the device number of the device
+ * @dm_name: (nullable): the device mapper name of the device (if it is a DM device)
+ * @user_data: (closure): user data given to bd_utils_dev_events_subscribe()
+ *
+ * Function called for udev events for block devices. It is called from the
+ * thread receiving the events so it has to be thread-safe, cheap and it must
+ * not subscribe or unsubscribe.
+ */
+typedef void (*BDUtilsDevEventFunc) (const gchar *action, const gchar *device, guint64 devnum, const gchar *dm_name, gpointer user_data);
+
+guint bd_utils_dev_events_subscribe (BDUtilsDevEventFunc func, gpointer user_data, GError **error);
+void bd_utils_dev_events_unsubscribe (guint id);
+gboolean bd_utils_dev_events_running (void);
+
+void bd_utils_dev_cache_enable (gboolean enable);
+gboolean bd_utils_dev_cache_enabled (void);
+void bd_utils_dev_cache_invalidate (const gchar *dev_spec);
+
+/**
+ * BDUtilsDevRetryFunc:
+ * @user_data: (closure): user data given to bd_utils_dev_retry()
+ *
+ * Function doing an attempt of an operation on a device.
+ *
+ * Returns: whether the attempt succeeded (%FALSE to retry)
+ */
+typedef gboolean (*BDUtilsDevRetryFunc) (gpointer user_data);
+
+gboolean bd_utils_dev_retry (const gchar *device, guint timeout_ms, BDUtilsDevRetryFunc attempt, gpointer user_data);
+gboolean bd_utils_wait_for_device (const gchar *device, guint timeout_ms, GError **error);
+
 #endif  /* BD_UTILS_DEV_UTILS */
@@ -17,7 +17,10 @@
  * Author: Vratislav Podzimek <vpodzime@redhat.com>
  */
 
+#define _GNU_SOURCE
 #include <glib.h>
+#include <glib-unix.h>
+#include <gio/gio.h>
 #include "exec.h"
 #include "extra_arg.h"
 #include "logging.h"
@@ -25,9 +28,13 @@
 #include <poll.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <signal.h>
+#include <spawn.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <string.h>
 
 #ifdef __clang__
 #define ZERO_INIT {}
@@ -45,6 +52,36 @@ static GMutex task_id_counter_lock;
 static guint64 task_id_counter = 0;
 static BDUtilsProgFunc prog_func = NULL;
 static __thread BDUtilsProgFunc thread_prog_func = NULL;
+static __thread GCancellable *thread_cancellable = NULL;
+
+static gint timing_on = 0;
+static GMutex timing_lock;
+static BDUtilsTimingFunc timing_func = NULL;
+/* ring buffer of the last timing_ring_size records */
+static BDUtilsTimingRecord **timing_ring = NULL;
+static guint timing_ring_size = 0;
+static guint timing_ring_next = 0;
+static guint timing_ring_len = 0;
+static __thread BDUtilsTimingSpan *timing_current_span = NULL;
+
+/* canned results of commands used instead of running them */
+typedef struct ExecReplay {
+    GPatternSpec *pattern;
+    /* the utility the pattern is for (first word of the pattern, if not a glob) */
+    gchar *util;
+    gchar *stdout_data;
+    gchar *stderr_data;
+    gint exit_status;
+} ExecReplay;
+
+static gint replay_on = 0;
+static GMutex replay_lock;
+static GPtrArray *replay_table = NULL;
+static gboolean replay_strict = FALSE;
+
+#if !GLIB_CHECK_VERSION(2, 70, 0)
+#define g_pattern_spec_match_string(x,y) (g_pattern_match_string (x,y))
+#endif
 
 /**
  * bd_utils_exec_error_quark: (skip)
@@ -74,11 +111,399 @@ guint64 bd_utils_get_next_task_id (void) {
  * @msg: log message
  */
 void bd_utils_log_task_status (guint64 task_id, const gchar *msg) {
-    gchar *log_msg = NULL;
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "[%"G_GUINT64_FORMAT"] %s", task_id, msg);
+}
+
+/**
+ * bd_utils_timing_record_copy: (skip)
+ * @record: (nullable): %BDUtilsTimingRecord to copy
+ *
+ * Creates a new copy of @record.
+ */
+BDUtilsTimingRecord* bd_utils_timing_record_copy (BDUtilsTimingRecord *record) {
+    BDUtilsTimingRecord *ret = NULL;
+
+    if (record == NULL)
+        return NULL;
+
+    ret = g_new0 (BDUtilsTimingRecord, 1);
+    *ret = *record;
+    ret->plugin = g_strdup (record->plugin);
+    ret->function = g_strdup (record->function);
+    ret->command = g_strdup (record->command);
+
+    return ret;
+}
+
+/**
+ * bd_utils_timing_record_free: (skip)
+ * @record: (nullable): %BDUtilsTimingRecord to free
+ *
+ * Frees @record.
+ */
+void bd_utils_timing_record_free (BDUtilsTimingRecord *record) {
+    if (record == NULL)
+        return;
+
+    g_free (record->plugin);
+    g_free (record->function);
+    g_free (record->command);
+    g_free (record);
+}
+
+GType bd_utils_timing_record_get_type (void) {
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type))
+        type = g_boxed_type_register_static ("BDUtilsTimingRecord",
+                                             (GBoxedCopyFunc) bd_utils_timing_record_copy,
+                                             (GBoxedFreeFunc) bd_utils_timing_record_free);
+
+    return type;
+}
+
+/**
+ * bd_utils_init_timing:
+ * @new_timing_func: (nullable) (scope notified): function to call for every finished
+ *                                                  operation or %NULL
+ * @ring_size: number of the last timing records to keep for bd_utils_timing_get_records()
+ *             or 0 to keep none
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Sets up timing instrumentation of the operations done by the library -- the
+ * external commands it runs and some of the expensive operations done by the
+ * plugins (D-Bus calls, dependency checks, partition table and LUKS operations,
+ * signature probing). Use %NULL and 0 to disable the instrumentation again
+ * (the default), in which case it costs next to nothing.
+ *
+ * Returns: whether timing instrumentation was successfully initialized or not
+ */
+gboolean bd_utils_init_timing (BDUtilsTimingFunc new_timing_func, guint ring_size, GError **error G_GNUC_UNUSED) {
+    BDUtilsTimingRecord **old_ring = NULL;
+    guint old_size = 0;
+    guint i = 0;
+
+    g_mutex_lock (&timing_lock);
+    old_ring = timing_ring;
+    old_size = timing_ring_size;
+
+    timing_func = new_timing_func;
+    timing_ring = ring_size > 0 ? g_new0 (BDUtilsTimingRecord*, ring_size) : NULL;
+    timing_ring_size = ring_size;
+    timing_ring_next = 0;
+    timing_ring_len = 0;
+    g_atomic_int_set (&timing_on, (new_timing_func != NULL || ring_size > 0));
+    g_mutex_unlock (&timing_lock);
+
+    for (i = 0; i < old_size; i++)
+        bd_utils_timing_record_free (old_ring[i]);
+    g_free (old_ring);
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_timing_enabled:
+ *
+ * Returns: whether timing instrumentation is enabled or not
+ */
+gboolean bd_utils_timing_enabled (void) {
+    return g_atomic_int_get (&timing_on);
+}
+
+/**
+ * bd_utils_timing_get_records:
+ * @clear: whether to remove the returned records from the ring buffer or not
+ *
+ * Returns: (transfer full) (array zero-terminated=1): the timing records kept
+ *          in the ring buffer (see bd_utils_init_timing()), oldest first
+ */
+BDUtilsTimingRecord** bd_utils_timing_get_records (gboolean clear) {
+    BDUtilsTimingRecord **ret = NULL;
+    guint first = 0;
+    guint i = 0;
+
+    g_mutex_lock (&timing_lock);
+    ret = g_new0 (BDUtilsTimingRecord*, timing_ring_len + 1);
+    first = timing_ring_size > 0 ? (timing_ring_next + timing_ring_size - timing_ring_len) % timing_ring_size : 0;
+    for (i = 0; i < timing_ring_len; i++) {
+        guint idx = (first + i) % timing_ring_size;
+
+        if (clear) {
+            ret[i] = timing_ring[idx];
+            timing_ring[idx] = NULL;
+        } else
+            ret[i] = bd_utils_timing_record_copy (timing_ring[idx]);
+    }
+    if (clear)
+        timing_ring_len = 0;
+    g_mutex_unlock (&timing_lock);
+
+    return ret;
+}
+
+static void timing_span_start (BDUtilsTimingSpan *span, const gchar *plugin, const gchar *function) {
+    BDUtilsTimingSpan *parent = timing_current_span;
+
+    span->start_mono = 0;
+    span->spawn_time = -1;
+    span->parent = NULL;
+    if (!g_atomic_int_get (&timing_on))
+        return;
+
+    span->plugin = plugin ? plugin : (parent ? parent->plugin : NULL);
+    span->function = function ? function : (parent ? parent->function : NULL);
+    span->start_time = g_get_real_time ();
+    span->start_mono = g_get_monotonic_time ();
+}
+
+static void timing_span_mark_spawned (BDUtilsTimingSpan *span) {
+    if (span->start_mono != 0)
+        span->spawn_time = g_get_monotonic_time () - span->start_mono;
+}
+
+static void timing_span_finish (BDUtilsTimingSpan *span, guint64 task_id, const gchar *command, guint64 output_bytes, gint exit_code) {
+    BDUtilsTimingRecord record;
+    BDUtilsTimingFunc func = NULL;
+
+    if (span->start_mono == 0 || !g_atomic_int_get (&timing_on))
+        return;
+
+    record.task_id = task_id ? task_id : bd_utils_get_next_task_id ();
+    record.plugin = (gchar *) span->plugin;
+    record.function = (gchar *) span->function;
+    record.command = (gchar *) command;
+    record.start_time = span->start_time;
+    record.spawn_time = span->spawn_time;
+    record.wall_time = g_get_monotonic_time () - span->start_mono;
+    record.output_bytes = output_bytes;
+    record.exit_code = exit_code;
+
+    g_mutex_lock (&timing_lock);
+    func = timing_func;
+    if (timing_ring_size > 0) {
+        bd_utils_timing_record_free (timing_ring[timing_ring_next]);
+        timing_ring[timing_ring_next] = bd_utils_timing_record_copy (&record);
+        timing_ring_next = (timing_ring_next + 1) % timing_ring_size;
+        timing_ring_len = MIN (timing_ring_len + 1, timing_ring_size);
+    }
+    g_mutex_unlock (&timing_lock);
+
+    if (func)
+        func (&record);
+}
+
+/**
+ * bd_utils_timing_span_begin: (skip)
+ * @span: span to begin (usually allocated on the stack)
+ * @plugin: (nullable): name of the plugin running the operation or %NULL to
+ *                      inherit it from the enclosing span
+ * @function: (nullable): name of the function running the operation or %NULL
+ *                        to inherit it from the enclosing span
+ *
+ * Starts timing of an operation. Spans nest (per thread) and external commands
+ * run while a span is active are recorded with its @plugin and @function.
+ * Every span has to be ended with bd_utils_timing_span_end() in the same thread,
+ * in the reverse order of beginning.
+ */
+void bd_utils_timing_span_begin (BDUtilsTimingSpan *span, const gchar *plugin, const gchar *function) {
+    timing_span_start (span, plugin, function);
+    if (span->start_mono == 0)
+        return;
+
+    span->parent = timing_current_span;
+    timing_current_span = span;
+}
 
-    log_msg = g_strdup_printf ("[%"G_GUINT64_FORMAT"] %s", task_id, msg);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
+/**
+ * bd_utils_timing_span_end: (skip)
+ * @span: span to end
+ * @task_id: ID of the task the operation was run as or 0 to get a new one
+ * @command: (nullable): external command or library call run by the operation
+ * @output_bytes: number of bytes of output the operation produced
+ * @exit_code: exit code of the operation (0 for success, -1 for failure)
+ *
+ * Ends timing of an operation started by bd_utils_timing_span_begin() and
+ * records the result (if timing instrumentation is enabled).
+ */
+void bd_utils_timing_span_end (BDUtilsTimingSpan *span, guint64 task_id, const gchar *command, guint64 output_bytes, gint exit_code) {
+    if (span->start_mono == 0)
+        return;
+
+    if (timing_current_span == span)
+        timing_current_span = span->parent;
+
+    timing_span_finish (span, task_id, command, output_bytes, exit_code);
+}
+
+/* Returns the command string for the timing record of @argv or %NULL if the
+   operation is not being timed. */
+static gchar* timing_command (BDUtilsTimingSpan *span, const gchar **argv) {
+    if (span->start_mono == 0)
+        return NULL;
+    return g_strjoinv (" ", (gchar **) argv);
+}
+
+static gint timing_exit_code (gint wait_status) {
+    return WIFEXITED (wait_status) ? WEXITSTATUS (wait_status) : -1;
+}
+
+static void exec_replay_free (ExecReplay *replay) {
+    if (!replay)
+        return;
+    if (replay->pattern)
+        g_pattern_spec_free (replay->pattern);
+    g_free (replay->util);
+    g_free (replay->stdout_data);
+    g_free (replay->stderr_data);
+    g_free (replay);
+}
+
+/**
+ * bd_utils_exec_replay_add:
+ * @pattern: glob pattern (see #GPatternSpec) matching the command line (the
+ *           arguments separated by single spaces, including the extra
+ *           arguments) of the commands to replay
+ * @stdout_data: (nullable): standard output of the replayed commands
+ * @stderr_data: (nullable): standard error output of the replayed commands
+ * @exit_status: exit status of the replayed commands
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Registers a canned result for the commands matching @pattern. Instead of
+ * running such commands, the library passes @stdout_data and @stderr_data to
+ * the same processing the output of a real process would go through, and
+ * reports @exit_status as the process's exit status. This makes it possible to
+ * test, benchmark and profile the parsing and orchestration done by the
+ * CLI-based plugins without any real devices and without creating any
+ * processes. The patterns are tried in the order they were added, and the
+ * first matching one is used. The utility a pattern starts with (e.g. 'lvm'
+ * for 'lvm lvs *') is also considered available (see
+ * bd_utils_check_util_version()) even if it is not installed.
+ *
+ * Only the synchronous functions running commands use the replays, the
+ * asynchronous ones (e.g. bd_utils_exec_and_report_progress_async()) always
+ * run the commands.
+ *
+ * Returns: whether the replay was successfully registered or not
+ */
+gboolean bd_utils_exec_replay_add (const gchar *pattern, const gchar *stdout_data, const gchar *stderr_data, gint exit_status, GError **error) {
+    ExecReplay *replay = NULL;
+    const gchar *space = NULL;
+
+    if (!pattern || !(*pattern)) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Invalid pattern for the replay specified");
+        return FALSE;
+    }
+
+    replay = g_new0 (ExecReplay, 1);
+    replay->pattern = g_pattern_spec_new (pattern);
+    space = strchr (pattern, ' ');
+    replay->util = space ? g_strndup (pattern, space - pattern) : g_strdup (pattern);
+    if (strpbrk (replay->util, "*?")) {
+        g_free (replay->util);
+        replay->util = NULL;
+    }
+    replay->stdout_data = g_strdup (stdout_data ? stdout_data : "");
+    replay->stderr_data = g_strdup (stderr_data ? stderr_data : "");
+    replay->exit_status = exit_status;
+
+    g_mutex_lock (&replay_lock);
+    if (!replay_table)
+        replay_table = g_ptr_array_new_with_free_func ((GDestroyNotify) exec_replay_free);
+    g_ptr_array_add (replay_table, replay);
+    g_atomic_int_set (&replay_on, 1);
+    g_mutex_unlock (&replay_lock);
+
+    return TRUE;
+}
+
+/**
+ * bd_utils_exec_replay_set_strict:
+ * @strict: whether commands without a matching replay should fail instead of
+ *          being run
+ *
+ * In the strict mode, commands that don't match any pattern registered with
+ * bd_utils_exec_replay_add() fail with an error instead of being run which
+ * makes sure no processes are created. The strict mode is only effective if
+ * some replays are registered. It's disabled by default.
+ */
+void bd_utils_exec_replay_set_strict (gboolean strict) {
+    g_mutex_lock (&replay_lock);
+    replay_strict = strict;
+    g_mutex_unlock (&replay_lock);
+}
+
+/**
+ * bd_utils_exec_replay_clear:
+ *
+ * Removes all the replays registered with bd_utils_exec_replay_add() and
+ * disables the strict mode so that all commands are run again.
+ */
+void bd_utils_exec_replay_clear (void) {
+    GPtrArray *old_table = NULL;
+
+    g_mutex_lock (&replay_lock);
+    old_table = replay_table;
+    replay_table = NULL;
+    replay_strict = FALSE;
+    g_atomic_int_set (&replay_on, 0);
+    g_mutex_unlock (&replay_lock);
+
+    if (old_table)
+        g_ptr_array_free (old_table, TRUE);
+}
+
+/* Returns a copy of the replay matching @argv (%NULL if there is none, with
+ * @error set if there is none and the strict mode is enabled). */
+static ExecReplay* exec_replay_find (const gchar **argv, GError **error) {
+    ExecReplay *ret = NULL;
+    ExecReplay *replay = NULL;
+    gchar *cmd = NULL;
+
+    if (G_LIKELY (!g_atomic_int_get (&replay_on)))
+        return NULL;
+
+    cmd = g_strjoinv (" ", (gchar **) argv);
+
+    g_mutex_lock (&replay_lock);
+    for (guint i = 0; replay_table && i < replay_table->len; i++) {
+        replay = g_ptr_array_index (replay_table, i);
+        if (g_pattern_spec_match_string (replay->pattern, cmd)) {
+            /* the table may be cleared while the command is being "run" */
+            ret = g_new0 (ExecReplay, 1);
+            ret->stdout_data = g_strdup (replay->stdout_data);
+            ret->stderr_data = g_strdup (replay->stderr_data);
+            ret->exit_status = replay->exit_status;
+            break;
+        }
+    }
+    if (!ret && replay_strict && replay_table)
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "No replay registered for '%s'", cmd);
+    g_mutex_unlock (&replay_lock);
+
+    g_free (cmd);
+
+    return ret;
+}
+
+/* Whether there is a replay for some command running @util. */
+static gboolean exec_replay_has_util (const gchar *util) {
+    gboolean ret = FALSE;
+    ExecReplay *replay = NULL;
+
+    if (G_LIKELY (!g_atomic_int_get (&replay_on)))
+        return FALSE;
+
+    g_mutex_lock (&replay_lock);
+    for (guint i = 0; !ret && replay_table && i < replay_table->len; i++) {
+        replay = g_ptr_array_index (replay_table, i);
+        ret = g_strcmp0 (replay->util, util) == 0;
+    }
+    g_mutex_unlock (&replay_lock);
+
+    return ret;
 }
 
 /**
@@ -89,35 +514,57 @@ void bd_utils_log_task_status (guint64 task_id, const gchar *msg) {
 static guint64 log_running (const gchar **argv) {
     guint64 task_id = 0;
     gchar *str_argv = NULL;
-    gchar *log_msg = NULL;
 
     task_id = bd_utils_get_next_task_id ();
 
+    if (!bd_utils_log_enabled (BD_UTILS_LOG_INFO))
+        return task_id;
+
     str_argv = g_strjoinv (" ", (gchar **) argv);
-    log_msg = g_strdup_printf ("Running [%"G_GUINT64_FORMAT"] %s ...", task_id, str_argv);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "Running [%"G_GUINT64_FORMAT"] %s ...", task_id, str_argv);
     g_free (str_argv);
-    g_free (log_msg);
 
     return task_id;
 }
 
 /**
- * log_out: (skip)
+ * log_out_data: (skip)
  *
+ * Logs @data (standard output or standard error output of a process) or just
+ * its beginning if the output log limit is set.
  */
-static void log_out (guint64 task_id, const gchar *stdout, const gchar *stderr) {
-    gchar *log_msg = NULL;
+static void log_out_data (guint64 task_id, const gchar *name, const gchar *data) {
+    guint64 limit = bd_utils_get_log_output_limit ();
+    gsize len = 0;
+    gsize cut = 0;
+
+    if (limit > 0 && data)
+        len = strlen (data);
+
+    if (limit == 0 || len <= limit) {
+        bd_utils_log_format (BD_UTILS_LOG_INFO, "%s[%"G_GUINT64_FORMAT"]: %s", name, task_id, data);
+        return;
+    }
 
-    log_msg = g_strdup_printf ("stdout[%"G_GUINT64_FORMAT"]: %s", task_id, stdout);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
+    /* do not split a multi-byte UTF-8 character */
+    cut = (gsize) limit;
+    while (cut > 0 && (data[cut] & 0xC0) == 0x80)
+        cut--;
 
-    log_msg = g_strdup_printf ("stderr[%"G_GUINT64_FORMAT"]: %s", task_id, stderr);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "%s[%"G_GUINT64_FORMAT"]: %.*s... (truncated, %"G_GSIZE_FORMAT" bytes in total)",
+                         name, task_id, (gint) cut, data, len);
+}
+
+/**
+ * log_out: (skip)
+ *
+ */
+static void log_out (guint64 task_id, const gchar *stdout, const gchar *stderr) {
+    if (!bd_utils_log_enabled (BD_UTILS_LOG_INFO))
+        return;
 
-    return;
+    log_out_data (task_id, "stdout", stdout);
+    log_out_data (task_id, "stderr", stderr);
 }
 
 /**
@@ -125,16 +572,238 @@ static void log_out (guint64 task_id, const gchar *stdout, const gchar *stderr)
  *
  */
 static void log_done (guint64 task_id, gint exit_code) {
-    gchar *log_msg = NULL;
+    bd_utils_log_format (BD_UTILS_LOG_INFO, "...done [%"G_GUINT64_FORMAT"] (exit code: %d)", task_id, exit_code);
+}
+
+/**
+ * add_extra_args: (skip)
+ *
+ * Returns: (transfer container): @argv with the @extra arguments appended or
+ *                                %NULL if there are no @extra arguments
+ */
+static const gchar** add_extra_args (const gchar **argv, const BDExtraArg **extra) {
+    const gchar **args = NULL;
+    guint args_len = 0;
+    const gchar **arg_p = NULL;
+    const BDExtraArg **extra_p = NULL;
+    guint i = 0;
+
+    if (extra) {
+        args_len = g_strv_length ((gchar **) argv);
+        for (extra_p=extra; *extra_p; extra_p++) {
+            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0))
+                args_len++;
+            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0))
+                args_len++;
+        }
+        args = g_new0 (const gchar*, args_len + 1);
+        for (arg_p=argv; *arg_p; arg_p++, i++)
+            args[i] = *arg_p;
+        for (extra_p=extra; *extra_p; extra_p++) {
+            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0)) {
+                args[i] = (*extra_p)->opt;
+                i++;
+            }
+            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0)) {
+                args[i] = (*extra_p)->val;
+                i++;
+            }
+        }
+        args[i] = NULL;
+    }
+
+    return args;
+}
+
+/* environment used for the spawned processes, built from the environment of
+   the process only when it changes */
+typedef struct ExecEnv {
+    gint ref_count;
+    gchar **envp;
+} ExecEnv;
+
+static GMutex exec_env_lock;
+static ExecEnv *exec_env = NULL;
+/* copy of the environ array exec_env was built from */
+static gchar **exec_env_source = NULL;
+
+static void exec_env_unref (ExecEnv *env) {
+    if (g_atomic_int_dec_and_test (&(env->ref_count))) {
+        g_strfreev (env->envp);
+        g_free (env);
+    }
+}
+
+/* the strings in environ can be reused (e.g. by setenv() or a string passed to
+   putenv() modified later) so their contents need to be compared, that is
+   still much cheaper than building the environment for every process */
+static gboolean environ_changed (void) {
+    guint i = 0;
+
+    if (!exec_env_source)
+        return TRUE;
+
+    for (i=0; environ[i] && exec_env_source[i]; i++)
+        if (strcmp (environ[i], exec_env_source[i]) != 0)
+            return TRUE;
+
+    return environ[i] || exec_env_source[i];
+}
+
+/* returns (transfer full) environment to run the processes with (LC_ALL=C.UTF-8, no LANGUAGE) */
+static ExecEnv* get_exec_env (void) {
+    ExecEnv *ret = NULL;
+    gchar **envp = NULL;
+    guint len = 0;
+
+    g_mutex_lock (&exec_env_lock);
+    if (!exec_env || environ_changed ()) {
+        if (exec_env)
+            exec_env_unref (exec_env);
+        g_strfreev (exec_env_source);
+
+        envp = g_get_environ ();
+        envp = g_environ_setenv (envp, "LC_ALL", "C.UTF-8", TRUE);
+        envp = g_environ_unsetenv (envp, "LANGUAGE");
+
+        exec_env = g_new0 (ExecEnv, 1);
+        exec_env->ref_count = 1;
+        exec_env->envp = envp;
+
+        for (len=0; environ[len]; len++);
+        exec_env_source = g_new (gchar *, len + 1);
+        for (guint i=0; i < len; i++)
+            exec_env_source[i] = g_strdup (environ[i]);
+        exec_env_source[len] = NULL;
+    }
+    ret = exec_env;
+    g_atomic_int_inc (&(ret->ref_count));
+    g_mutex_unlock (&exec_env_lock);
+
+    return ret;
+}
+
+static void close_pipe (gint pipe_fds[2]) {
+    if (pipe_fds[0] >= 0)
+        close (pipe_fds[0]);
+    if (pipe_fds[1] >= 0)
+        close (pipe_fds[1]);
+    pipe_fds[0] = pipe_fds[1] = -1;
+}
+
+/* used if posix_spawnp() cannot be set up */
+static gboolean spawn_with_glib (const gchar **argv, gchar **envp, GPid *pid, gint *in_fd, gint *out_fd, gint *err_fd, GError **error) {
+    return g_spawn_async_with_pipes (NULL, (gchar **) argv, envp, G_SPAWN_DO_NOT_REAP_CHILD|G_SPAWN_SEARCH_PATH,
+                                     NULL, NULL, pid, in_fd, out_fd, err_fd, error);
+}
+
+/* spawns the process with posix_spawnp() which uses a vfork()-like clone() and
+   so, unlike fork(), doesn't need to copy the page tables of the whole
+   (potentially big) process, the process needs to be reaped by the caller */
+static gboolean spawn_with_pipes (const gchar **argv, gchar **envp, GPid *pid, gint *in_fd, gint *out_fd, gint *err_fd, GError **error) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    gboolean attr_initialized = FALSE;
+    gint in_pipe[2] = {-1, -1};
+    gint out_pipe[2] = {-1, -1};
+    gint err_pipe[2] = {-1, -1};
+    pid_t child = 0;
+    gint ret = 0;
+
+    if ((in_fd && pipe2 (in_pipe, O_CLOEXEC) != 0) || pipe2 (out_pipe, O_CLOEXEC) != 0 || pipe2 (err_pipe, O_CLOEXEC) != 0) {
+        g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+                     "Failed to create pipe for communicating with child process: %m");
+        close_pipe (in_pipe);
+        close_pipe (out_pipe);
+        close_pipe (err_pipe);
+        return FALSE;
+    }
+
+    ret = posix_spawn_file_actions_init (&actions);
+    if (ret != 0) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to set up posix_spawn() (%s), using g_spawn()", g_strerror (ret));
+        close_pipe (in_pipe);
+        close_pipe (out_pipe);
+        close_pipe (err_pipe);
+        return spawn_with_glib (argv, envp, pid, in_fd, out_fd, err_fd, error);
+    }
+
+    if (in_fd)
+        ret = posix_spawn_file_actions_adddup2 (&actions, in_pipe[0], STDIN_FILENO);
+    else
+        /* same as g_spawn*() */
+        ret = posix_spawn_file_actions_addopen (&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    if (ret == 0)
+        ret = posix_spawn_file_actions_adddup2 (&actions, out_pipe[1], STDOUT_FILENO);
+    if (ret == 0)
+        ret = posix_spawn_file_actions_adddup2 (&actions, err_pipe[1], STDERR_FILENO);
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 34)
+    /* don't leak file descriptors opened without O_CLOEXEC to the child */
+    if (ret == 0)
+        ret = posix_spawn_file_actions_addclosefrom_np (&actions, STDERR_FILENO + 1);
+#endif
+#endif
+
+    if (ret == 0) {
+        ret = posix_spawnattr_init (&attr);
+        attr_initialized = (ret == 0);
+    }
+#ifdef POSIX_SPAWN_USEVFORK
+    if (ret == 0)
+        ret = posix_spawnattr_setflags (&attr, POSIX_SPAWN_USEVFORK);
+#endif
+
+    if (ret != 0) {
+        /* the child would run with wrong standard streams */
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to set up posix_spawn() (%s), using g_spawn()", g_strerror (ret));
+        posix_spawn_file_actions_destroy (&actions);
+        if (attr_initialized)
+            posix_spawnattr_destroy (&attr);
+        close_pipe (in_pipe);
+        close_pipe (out_pipe);
+        close_pipe (err_pipe);
+        return spawn_with_glib (argv, envp, pid, in_fd, out_fd, err_fd, error);
+    }
 
-    log_msg = g_strdup_printf ("...done [%"G_GUINT64_FORMAT"] (exit code: %d)", task_id, exit_code);
-    bd_utils_log (BD_UTILS_LOG_INFO, log_msg);
-    g_free (log_msg);
+    ret = posix_spawnp (&child, argv[0], &actions, &attr, (gchar * const *) argv, envp);
 
+    posix_spawn_file_actions_destroy (&actions);
+    posix_spawnattr_destroy (&attr);
 
-    return;
+    /* close the child's ends of the pipes */
+    if (in_fd) {
+        close (in_pipe[0]);
+        in_pipe[0] = -1;
+    }
+    close (out_pipe[1]);
+    out_pipe[1] = -1;
+    close (err_pipe[1]);
+    err_pipe[1] = -1;
+
+    if (ret != 0) {
+        g_set_error (error, G_SPAWN_ERROR,
+                     ret == ENOENT ? G_SPAWN_ERROR_NOENT : (ret == EACCES ? G_SPAWN_ERROR_ACCES : G_SPAWN_ERROR_FAILED),
+                     "Failed to execute child process \"%s\" (%s)", argv[0], g_strerror (ret));
+        close_pipe (in_pipe);
+        close_pipe (out_pipe);
+        close_pipe (err_pipe);
+        return FALSE;
+    }
+
+    *pid = child;
+    if (in_fd)
+        *in_fd = in_pipe[1];
+    *out_fd = out_pipe[0];
+    *err_fd = err_pipe[0];
+
+    return TRUE;
 }
 
+static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract,
+                                                 BDUtilsLineFunc line_func, gpointer line_data,
+                                                 const gchar *input, gint *proc_status, gchar **stdout, gchar **stderr, GError **error);
+
 /**
  * bd_utils_exec_and_report_error:
  * @argv: (array zero-terminated=1): the argv array for the call
@@ -179,54 +848,54 @@ gboolean bd_utils_exec_and_report_status_error (const gchar **argv, const BDExtr
     gchar *stderr_data = NULL;
     guint64 task_id = 0;
     const gchar **args = NULL;
-    guint args_len = 0;
-    const gchar **arg_p = NULL;
-    const BDExtraArg **extra_p = NULL;
     gint exit_status = 0;
-    guint i = 0;
-    gchar **old_env = NULL;
-    gchar **new_env = NULL;
+    ExecEnv *env = NULL;
+    BDUtilsTimingSpan span;
+    gchar *timing_cmd = NULL;
+    ExecReplay *replay = NULL;
     GError *l_error = NULL;
 
-    if (extra) {
-        args_len = g_strv_length ((gchar **) argv);
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0))
-                args_len++;
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0))
-                args_len++;
-        }
-        args = g_new0 (const gchar*, args_len + 1);
-        for (arg_p=argv; *arg_p; arg_p++, i++)
-            args[i] = *arg_p;
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0)) {
-                args[i] = (*extra_p)->opt;
-                i++;
-            }
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0)) {
-                args[i] = (*extra_p)->val;
-                i++;
-            }
-        }
-        args[i] = NULL;
-    }
+    /* g_spawn_sync() cannot be interrupted, the process needs to be watched
+       together with the cancellable of the thread */
+    if (thread_cancellable)
+        return _utils_exec_and_report_progress (argv, extra, NULL, NULL, NULL, NULL, status, NULL, NULL, error);
+
+    args = add_extra_args (argv, extra);
+
+    env = get_exec_env ();
 
-    old_env = g_get_environ ();
-    new_env = g_environ_setenv (old_env, "LC_ALL", "C.UTF-8", TRUE);
-    new_env = g_environ_unsetenv (new_env, "LANGUAGE");
+    timing_span_start (&span, NULL, NULL);
+    timing_cmd = timing_command (&span, args ? args : argv);
 
     task_id = log_running (args ? args : argv);
-    success = g_spawn_sync (NULL, args ? (gchar **) args : (gchar **) argv, new_env, G_SPAWN_SEARCH_PATH,
-                            NULL, NULL, &stdout_data, &stderr_data, &exit_status, error);
+    replay = exec_replay_find (args ? args : argv, &l_error);
+    if (replay) {
+        stdout_data = g_strdup (replay->stdout_data);
+        stderr_data = g_strdup (replay->stderr_data);
+        /* same as a wait status of a process that exited with the status */
+        exit_status = (replay->exit_status & 0xff) << 8;
+        exec_replay_free (replay);
+        success = TRUE;
+    } else if (l_error) {
+        g_propagate_error (error, l_error);
+        success = FALSE;
+    } else
+        success = g_spawn_sync (NULL, args ? (gchar **) args : (gchar **) argv, env->envp, G_SPAWN_SEARCH_PATH,
+                                NULL, NULL, &stdout_data, &stderr_data, &exit_status, error);
+    exec_env_unref (env);
+
+    /* g_spawn_sync() doesn't tell us how long spawning took */
+    timing_span_finish (&span, task_id, timing_cmd,
+                        (stdout_data ? strlen (stdout_data) : 0) + (stderr_data ? strlen (stderr_data) : 0),
+                        success ? timing_exit_code (exit_status) : -1);
+    g_free (timing_cmd);
+
     if (!success) {
         /* error is already populated from the call */
-        g_strfreev (new_env);
         g_free (stdout_data);
         g_free (stderr_data);
         return FALSE;
     }
-    g_strfreev (new_env);
 
     /* g_spawn_sync set the status in the same way waitpid() does, we need
        to get the process exit code manually (this is similar to calling
@@ -291,39 +960,110 @@ static gchar *bd_strchr_len_null (const gchar *haystack, gssize haystack_len, co
         return MAX (ret, ret_null);
 }
 
+/* What to do with the lines read from the outputs of a process. */
+typedef struct ExecLineContext {
+    BDUtilsProgExtract prog_extract;
+    guint64 progress_id;
+    guint8 completion;
+    BDUtilsLineFunc line_func;
+    gpointer line_data;
+} ExecLineContext;
+
+/* Fixed-size buffer the output of a process is read into. Complete lines are
+ * processed in place right after every read, only the last (incomplete) line
+ * is moved to the beginning of the buffer to be completed by the next read. */
+typedef struct ExecLineReader {
+    gchar buf[_EXEC_BUF_SIZE + 1];
+    gsize len;
+    gboolean from_stderr;
+    /* number of bytes read */
+    guint64 total;
+    /* lines not consumed by the callbacks are appended here (if not NULL) */
+    GString *data;
+} ExecLineReader;
+
+static ExecLineReader* line_reader_new (gboolean from_stderr, gboolean accumulate) {
+    ExecLineReader *reader = g_new (ExecLineReader, 1);
+
+    reader->len = 0;
+    reader->from_stderr = from_stderr;
+    reader->total = 0;
+    reader->data = accumulate ? g_string_new (NULL) : NULL;
+
+    return reader;
+}
+
+static void line_reader_free (ExecLineReader *reader) {
+    if (!reader)
+        return;
+    if (reader->data)
+        g_string_free (reader->data, TRUE);
+    g_free (reader);
+}
+
+/* @line is @len bytes long including the separator (if any) */
+static void line_reader_handle_line (ExecLineReader *reader, ExecLineContext *ctx, gchar *line, gsize len) {
+    gchar saved = line[len];
+    gchar sep = line[len - 1];
+    gboolean consumed = FALSE;
+
+    /* the buffer has one extra byte so this is always possible */
+    line[len] = '\0';
+
+    if (ctx->prog_extract && ctx->prog_extract (line, &(ctx->completion))) {
+        bd_utils_report_progress (ctx->progress_id, ctx->completion, NULL);
+        consumed = TRUE;
+    } else if (ctx->line_func) {
+        /* the line function gets the line without the separator */
+        if (sep == '\n')
+            line[len - 1] = '\0';
+        consumed = ctx->line_func (line, reader->from_stderr, ctx->line_data);
+        line[len - 1] = sep;
+    }
+
+    if (!consumed && reader->data)
+        g_string_append (reader->data, line);
+
+    line[len] = saved;
+}
+
+static void line_reader_process (ExecLineReader *reader, ExecLineContext *ctx, gboolean eof) {
+    gchar *start = reader->buf;
+    gchar *end = reader->buf + reader->len;
+    gchar *sep = NULL;
+
+    while (start < end && (sep = bd_strchr_len_null (start, end - start, '\n'))) {
+        line_reader_handle_line (reader, ctx, start, sep - start + 1);
+        start = sep + 1;
+    }
+
+    /* the last line without a separator or a line that doesn't fit into the
+       buffer (passed in parts then) */
+    if (start < end && (eof || (start == reader->buf && reader->len == _EXEC_BUF_SIZE))) {
+        line_reader_handle_line (reader, ctx, start, end - start);
+        start = end;
+    }
+
+    reader->len = end - start;
+    if (reader->len > 0 && start != reader->buf)
+        memmove (reader->buf, start, reader->len);
+}
+
 static gboolean
-_process_fd_event (gint fd, struct pollfd *poll_fd, GString *read_buffer, GString *filtered_buffer, gsize *read_buffer_pos, gboolean *done,
-                   guint64 progress_id, guint8 *progress, BDUtilsProgExtract prog_extract, GError **error) {
-    gchar buf[_EXEC_BUF_SIZE] = { 0 };
-    ssize_t num_read;
-    gchar *line;
-    gchar *newline_pos;
+_process_fd_event (gint fd, struct pollfd *poll_fd, ExecLineReader *reader, gboolean *done, ExecLineContext *ctx, GError **error) {
+    ssize_t num_read = -1;
     int errno_saved;
     gboolean eof = FALSE;
 
     if (! *done && (poll_fd->revents & POLLIN)) {
-        /* read until we get EOF (0) or error (-1), expecting EAGAIN */
-        while ((num_read = read (fd, buf, _EXEC_BUF_SIZE)) > 0)
-            g_string_append_len (read_buffer, buf, num_read);
-        errno_saved = errno;
-
-        /* process the fresh data by lines */
-        if (read_buffer->len > *read_buffer_pos) {
-            gchar *buf_ptr;
-            gsize buf_len;
-
-            while ((buf_ptr = read_buffer->str + *read_buffer_pos,
-                    buf_len = read_buffer->len - *read_buffer_pos,
-                    newline_pos = bd_strchr_len_null (buf_ptr, buf_len, '\n'))) {
-                line = g_strndup (buf_ptr, newline_pos - buf_ptr + 1);
-                if (prog_extract && prog_extract (line, progress))
-                    bd_utils_report_progress (progress_id, *progress, NULL);
-                else
-                    g_string_append (filtered_buffer, line);
-                g_free (line);
-                *read_buffer_pos = newline_pos - read_buffer->str + 1;
-            }
+        /* read until we get EOF (0) or error (-1), expecting EAGAIN, and process
+           the fresh data by lines after every read */
+        while ((num_read = read (fd, reader->buf + reader->len, _EXEC_BUF_SIZE - reader->len)) > 0) {
+            reader->len += num_read;
+            reader->total += num_read;
+            line_reader_process (reader, ctx, FALSE);
         }
+        errno_saved = errno;
 
         /* read error */
         if (num_read < 0 && errno_saved != EAGAIN && errno_saved != EINTR) {
@@ -343,25 +1083,37 @@ _process_fd_event (gint fd, struct pollfd *poll_fd, GString *read_buffer, GStrin
     if (eof) {
         *done = TRUE;
         /* process the remaining buffer */
-        line = read_buffer->str + *read_buffer_pos;
-        /* GString guarantees the buffer is always NULL-terminated. */
-        if (strlen (line) > 0) {
-            if (prog_extract && prog_extract (line, progress))
-                bd_utils_report_progress (progress_id, *progress, NULL);
-            else
-                g_string_append (filtered_buffer, line);
-        }
+        line_reader_process (reader, ctx, TRUE);
     }
 
     return TRUE;
 }
 
-static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, const gchar *input, gint *proc_status, gchar **stdout, gchar **stderr, GError **error) {
+/* Processes @data (canned output of a replayed command) as if it was read
+   from the process. */
+static void line_reader_feed (ExecLineReader *reader, ExecLineContext *ctx, const gchar *data) {
+    gsize len = strlen (data);
+    gsize chunk = 0;
+
+    while (len > 0) {
+        chunk = MIN (len, _EXEC_BUF_SIZE - reader->len);
+        memcpy (reader->buf + reader->len, data, chunk);
+        reader->len += chunk;
+        reader->total += chunk;
+        data += chunk;
+        len -= chunk;
+        line_reader_process (reader, ctx, FALSE);
+    }
+    line_reader_process (reader, ctx, TRUE);
+}
+
+/* If @line_func is given and @stdout is %NULL, the standard output is not
+   accumulated. */
+static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract,
+                                                 BDUtilsLineFunc line_func, gpointer line_data,
+                                                 const gchar *input, gint *proc_status, gchar **stdout, gchar **stderr, GError **error) {
     const gchar **args = NULL;
-    guint args_len = 0;
-    const gchar **arg_p = NULL;
     gchar *args_str = NULL;
-    const BDExtraArg **extra_p = NULL;
     guint64 task_id = 0;
     guint64 progress_id = 0;
     gchar *msg = NULL;
@@ -373,65 +1125,54 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     gint status = 0;
     gboolean ret = FALSE;
     gint poll_status = 0;
-    guint i = 0;
-    guint8 completion = 0;
-    struct pollfd fds[2] = { ZERO_INIT, ZERO_INIT };
+    struct pollfd fds[3] = { ZERO_INIT, ZERO_INIT, ZERO_INIT };
+    gboolean cancel_fd = FALSE;
+    gboolean cancelled = FALSE;
     int flags;
     gboolean out_done = FALSE;
     gboolean err_done = FALSE;
-    GString *stdout_data;
-    GString *stdout_buffer;
-    GString *stderr_data;
-    GString *stderr_buffer;
-    gsize stdout_buffer_pos = 0;
-    gsize stderr_buffer_pos = 0;
-    gchar **old_env = NULL;
-    gchar **new_env = NULL;
+    ExecLineContext ctx = ZERO_INIT;
+    ExecLineReader *out_reader = NULL;
+    ExecLineReader *err_reader = NULL;
+    const gchar *stdout_str = NULL;
+    const gchar *stderr_str = NULL;
+    ExecEnv *env = NULL;
     gboolean success = TRUE;
+    BDUtilsTimingSpan span;
+    gchar *timing_cmd = NULL;
+    ExecReplay *replay = NULL;
     GError *l_error = NULL;
 
-    /* TODO: share this code between functions */
-    if (extra) {
-        args_len = g_strv_length ((gchar **) argv);
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0))
-                args_len++;
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0))
-                args_len++;
-        }
-        args = g_new0 (const gchar*, args_len + 1);
-        for (arg_p=argv; *arg_p; arg_p++, i++)
-            args[i] = *arg_p;
-        for (extra_p=extra; *extra_p; extra_p++) {
-            if ((*extra_p)->opt && (g_strcmp0 ((*extra_p)->opt, "") != 0)) {
-                args[i] = (*extra_p)->opt;
-                i++;
-            }
-            if ((*extra_p)->val && (g_strcmp0 ((*extra_p)->val, "") != 0)) {
-                args[i] = (*extra_p)->val;
-                i++;
-            }
-        }
-        args[i] = NULL;
-    }
+    if (thread_cancellable && g_cancellable_set_error_if_cancelled (thread_cancellable, error))
+        return FALSE;
 
-    task_id = log_running (args ? args : argv);
+    args = add_extra_args (argv, extra);
 
-    old_env = g_get_environ ();
-    new_env = g_environ_setenv (old_env, "LC_ALL", "C.UTF-8", TRUE);
-    new_env = g_environ_unsetenv (new_env, "LANGUAGE");
+    timing_span_start (&span, NULL, NULL);
+    timing_cmd = timing_command (&span, args ? args : argv);
 
-    ret = g_spawn_async_with_pipes (NULL, args ? (gchar**) args : (gchar**) argv, new_env,
-                                    G_SPAWN_DEFAULT|G_SPAWN_SEARCH_PATH|G_SPAWN_DO_NOT_REAP_CHILD,
-                                    NULL, NULL, &pid, input ? &in_fd : NULL, &out_fd, &err_fd, error);
+    task_id = log_running (args ? args : argv);
 
-    g_strfreev (new_env);
+    replay = exec_replay_find (args ? args : argv, &l_error);
+    if (replay)
+        ret = TRUE;
+    else if (l_error) {
+        g_propagate_error (error, l_error);
+        ret = FALSE;
+    } else {
+        env = get_exec_env ();
+        ret = spawn_with_pipes (args ? args : argv, env->envp, &pid, input ? &in_fd : NULL, &out_fd, &err_fd, error);
+        exec_env_unref (env);
+    }
 
     if (!ret) {
         /* error is already populated */
+        timing_span_finish (&span, task_id, timing_cmd, 0, -1);
+        g_free (timing_cmd);
         g_free (args);
         return FALSE;
     }
+    timing_span_mark_spawned (&span);
 
     args_str = g_strjoinv (" ", args ? (gchar **) args : (gchar **) argv);
     msg = g_strdup_printf ("Started '%s'", args_str);
@@ -440,6 +1181,25 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
     g_free (args);
     g_free (msg);
 
+    ctx.prog_extract = prog_extract;
+    ctx.progress_id = progress_id;
+    ctx.line_func = line_func;
+    ctx.line_data = line_data;
+
+    if (replay) {
+        /* no process, the canned outputs are processed the same way the
+           outputs of a real process would be (@input is ignored) */
+        out_reader = line_reader_new (FALSE, !line_func || stdout);
+        err_reader = line_reader_new (TRUE, TRUE);
+        line_reader_feed (out_reader, &ctx, replay->stdout_data);
+        line_reader_feed (err_reader, &ctx, replay->stderr_data);
+        /* same as a wait status of a process that exited with the status */
+        status = (replay->exit_status & 0xff) << 8;
+        child_ret = 1;
+        exec_replay_free (replay);
+        goto process_status;
+    }
+
     /* set both fds for non-blocking read */
     flags = fcntl (out_fd, F_GETFL, 0);
     if (fcntl (out_fd, F_SETFL, flags | O_NONBLOCK))
@@ -463,6 +1223,8 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
                          "Failed to write to stdin of the process: %m");
             bd_utils_report_finished (progress_id, l_error->message);
             g_propagate_error (error, l_error);
+            timing_span_finish (&span, task_id, timing_cmd, 0, -1);
+            g_free (timing_cmd);
             /* would overwrite errno, need to close as a last step */
             close (in_fd);
             return FALSE;
@@ -471,17 +1233,19 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
         g_warn_if_fail (len - num_written_total == 0);
     }
 
-    stdout_data = g_string_new (NULL);
-    stdout_buffer = g_string_new (NULL);
-    stderr_data = g_string_new (NULL);
-    stderr_buffer = g_string_new (NULL);
+    out_reader = line_reader_new (FALSE, !line_func || stdout);
+    err_reader = line_reader_new (TRUE, TRUE);
 
     fds[0].fd = out_fd;
     fds[1].fd = err_fd;
     fds[0].events = POLLIN | POLLHUP | POLLERR;
     fds[1].events = POLLIN | POLLHUP | POLLERR;
+    /* negative FDs are ignored by poll() */
+    fds[2].fd = thread_cancellable ? g_cancellable_get_fd (thread_cancellable) : -1;
+    fds[2].events = POLLIN;
+    cancel_fd = fds[2].fd >= 0;
     while (! (out_done && err_done)) {
-        poll_status = poll (fds, 2, -1 /* timeout */);
+        poll_status = poll (fds, 3, -1 /* timeout */);
         g_warn_if_fail (poll_status != 0);  /* no timeout specified, zero should never be returned */
         if (poll_status < 0) {
             if (errno == EAGAIN || errno == EINTR)
@@ -494,8 +1258,15 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
             break;
         }
 
+        if (fds[2].revents & POLLIN) {
+            /* keep reading the outputs until the process exits */
+            kill (pid, SIGTERM);
+            cancelled = TRUE;
+            fds[2].fd = -1;
+        }
+
         if (!out_done) {
-            if (! _process_fd_event (out_fd, &fds[0], stdout_buffer, stdout_data, &stdout_buffer_pos, &out_done, progress_id, &completion, prog_extract, &l_error)) {
+            if (! _process_fd_event (out_fd, &fds[0], out_reader, &out_done, &ctx, &l_error)) {
                 bd_utils_report_finished (progress_id, l_error->message);
                 g_propagate_error (error, l_error);
                 success = FALSE;
@@ -504,7 +1275,7 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
         }
 
         if (!err_done) {
-            if (! _process_fd_event (err_fd, &fds[1], stderr_buffer, stderr_data, &stderr_buffer_pos, &err_done, progress_id, &completion, prog_extract, &l_error)) {
+            if (! _process_fd_event (err_fd, &fds[1], err_reader, &err_done, &ctx, &l_error)) {
                 bd_utils_report_finished (progress_id, l_error->message);
                 g_propagate_error (error, l_error);
                 success = FALSE;
@@ -513,17 +1284,31 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
         }
     }
 
-    g_string_free (stdout_buffer, TRUE);
-    g_string_free (stderr_buffer, TRUE);
     close (out_fd);
     close (err_fd);
+    if (cancel_fd)
+        g_cancellable_release_fd (thread_cancellable);
 
     child_ret = waitpid (pid, &status, 0);
+
+process_status:
+    stdout_str = out_reader->data ? out_reader->data->str : "";
+    stderr_str = err_reader->data->str;
+
     *proc_status = WEXITSTATUS (status);
-    if (success) {
+    timing_span_finish (&span, task_id, timing_cmd, out_reader->total + err_reader->total,
+                        child_ret > 0 ? timing_exit_code (status) : -1);
+    g_free (timing_cmd);
+    if (success && cancelled) {
+        g_set_error (&l_error, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                     "Operation was cancelled");
+        bd_utils_report_finished (progress_id, l_error->message);
+        g_propagate_error (error, l_error);
+        success = FALSE;
+    } else if (success) {
         if (child_ret > 0) {
             if (*proc_status != 0) {
-                msg = stderr_data->len > 0 ? stderr_data->str : stdout_data->str;
+                msg = (gchar *) (*stderr_str ? stderr_str : stdout_str);
                 g_set_error (&l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
                              "Process reported exit code %d: %s", *proc_status, msg);
                 bd_utils_report_finished (progress_id, l_error->message);
@@ -552,17 +1337,19 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
         if (success)
             bd_utils_report_finished (progress_id, "Completed");
     }
-    log_out (task_id, stdout_data->str, stderr_data->str);
+    log_out (task_id, stdout_str, stderr_str);
     log_done (task_id, *proc_status);
 
-    if (success && stdout)
-        *stdout = g_string_free (stdout_data, FALSE);
-    else
-        g_string_free (stdout_data, TRUE);
-    if (success && stderr)
-        *stderr = g_string_free (stderr_data, FALSE);
-    else
-        g_string_free (stderr_data, TRUE);
+    if (success && stdout) {
+        *stdout = g_string_free (out_reader->data, FALSE);
+        out_reader->data = NULL;
+    }
+    if (success && stderr) {
+        *stderr = g_string_free (err_reader->data, FALSE);
+        err_reader->data = NULL;
+    }
+    line_reader_free (out_reader);
+    line_reader_free (err_reader);
 
     return success;
 }
@@ -582,7 +1369,39 @@ static gboolean _utils_exec_and_report_progress (const gchar **argv, const BDExt
  * Returns: whether the @argv was successfully executed (no error and exit code 0) or not
  */
 gboolean bd_utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, gint *proc_status, GError **error) {
-    return _utils_exec_and_report_progress (argv, extra, prog_extract, NULL, proc_status, NULL, NULL, error);
+    return _utils_exec_and_report_progress (argv, extra, prog_extract, NULL, NULL, NULL, proc_status, NULL, NULL, error);
+}
+
+/**
+ * bd_utils_exec_and_process_lines:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (nullable) (array zero-terminated=1): extra arguments
+ * @line_func: (scope call): function to call for every line of the output
+ * @user_data: (closure): data to pass to @line_func
+ * @proc_status: (out) (optional): place to store the process exit status
+ * @output: (out) (optional): place to store the lines of the standard output not
+ *                            consumed by @line_func (if requested)
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Runs @argv calling @line_func for every line of its standard output and
+ * standard error output as soon as the line is read. The lines are read into
+ * a fixed-size buffer and passed to @line_func without being copied, so unless
+ * @output is requested, the memory needed doesn't depend on the size of the
+ * output (lines longer than the buffer are passed in multiple parts). Only the
+ * standard error output lines not consumed by @line_func are kept to be
+ * reported in @error if the process fails.
+ *
+ * Note that any NULL bytes read from standard output and standard error
+ * output are treated as separators similar to newlines.
+ *
+ * Returns: whether the @argv was successfully executed (no error and exit code 0) or not
+ */
+gboolean bd_utils_exec_and_process_lines (const gchar **argv, const BDExtraArg **extra, BDUtilsLineFunc line_func, gpointer user_data,
+                                          gint *proc_status, gchar **output, GError **error) {
+    gint status = 0;
+
+    return _utils_exec_and_report_progress (argv, extra, NULL, line_func, user_data, NULL,
+                                            proc_status ? proc_status : &status, output, NULL, error);
 }
 
 /**
@@ -598,7 +1417,7 @@ gboolean bd_utils_exec_with_input (const gchar **argv, const gchar *input, const
     gint status = 0;
     /* just use the "stronger" function providing dumb progress reporting (just
        'started' and 'finished') and throw away the returned status */
-    return _utils_exec_and_report_progress (argv, extra, NULL, input, &status, NULL, NULL, error);
+    return _utils_exec_and_report_progress (argv, extra, NULL, NULL, NULL, input, &status, NULL, NULL, error);
 }
 
 /**
@@ -619,7 +1438,7 @@ gboolean bd_utils_exec_and_capture_output (const gchar **argv, const BDExtraArg
     gchar *stderr = NULL;
     gboolean ret = FALSE;
 
-    ret = _utils_exec_and_report_progress (argv, extra, NULL, NULL, &status, &stdout, &stderr, error);
+    ret = _utils_exec_and_report_progress (argv, extra, NULL, NULL, NULL, NULL, &status, &stdout, &stderr, error);
     if (!ret)
         return ret;
 
@@ -643,6 +1462,330 @@ gboolean bd_utils_exec_and_capture_output (const gchar **argv, const BDExtraArg
     }
 }
 
+typedef struct ExecAsyncData {
+    guint64 task_id;
+    BDUtilsTimingSpan span;
+    gchar *timing_cmd;
+    ExecLineContext ctx;
+    GPid pid;
+    gint out_fd;
+    gint err_fd;
+    gboolean out_done;
+    gboolean err_done;
+    gint child_done;
+    gint wait_status;
+    gint proc_status;
+    ExecLineReader *out_reader;
+    ExecLineReader *err_reader;
+    GSource *out_source;
+    GSource *err_source;
+    GSource *child_source;
+    GCancellable *cancellable;
+    gulong cancel_id;
+    GError *error;
+} ExecAsyncData;
+
+static void exec_async_data_free (ExecAsyncData *data) {
+    if (data->cancel_id)
+        g_cancellable_disconnect (data->cancellable, data->cancel_id);
+    if (data->out_source) {
+        g_source_destroy (data->out_source);
+        g_source_unref (data->out_source);
+    }
+    if (data->err_source) {
+        g_source_destroy (data->err_source);
+        g_source_unref (data->err_source);
+    }
+    if (data->child_source) {
+        g_source_destroy (data->child_source);
+        g_source_unref (data->child_source);
+    }
+    if (data->out_fd >= 0)
+        close (data->out_fd);
+    if (data->err_fd >= 0)
+        close (data->err_fd);
+    line_reader_free (data->out_reader);
+    line_reader_free (data->err_reader);
+    g_clear_error (&(data->error));
+    g_free (data->timing_cmd);
+    g_free (data);
+}
+
+/* returns the result once both outputs are closed and the process exited */
+static void exec_async_try_complete (GTask *task) {
+    ExecAsyncData *data = g_task_get_task_data (task);
+    const gchar *msg = NULL;
+
+    if (!data->out_done || !data->err_done || !g_atomic_int_get (&(data->child_done)))
+        return;
+
+    data->proc_status = WEXITSTATUS (data->wait_status);
+    if (!data->error) {
+        if (g_cancellable_is_cancelled (data->cancellable))
+            g_set_error (&(data->error), G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                         "Operation was cancelled");
+        else if (data->proc_status != 0) {
+            msg = data->err_reader->data->len > 0 ? data->err_reader->data->str : data->out_reader->data->str;
+            g_set_error (&(data->error), BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Process reported exit code %d: %s", data->proc_status, msg);
+        } else if (WIFSIGNALED (data->wait_status))
+            g_set_error (&(data->error), BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                         "Process killed with a signal");
+    }
+
+    timing_span_finish (&(data->span), data->task_id, data->timing_cmd,
+                        data->out_reader->total + data->err_reader->total,
+                        timing_exit_code (data->wait_status));
+
+    log_out (data->task_id, data->out_reader->data->str, data->err_reader->data->str);
+    log_done (data->task_id, data->proc_status);
+
+    if (data->error) {
+        bd_utils_report_finished (data->ctx.progress_id, data->error->message);
+        g_task_return_error (task, data->error);
+        data->error = NULL;
+    } else {
+        bd_utils_report_finished (data->ctx.progress_id, "Completed");
+        g_task_return_boolean (task, TRUE);
+    }
+}
+
+static gboolean exec_async_fd_ready (gint fd, GIOCondition condition, gpointer user_data) {
+    GTask *task = G_TASK (user_data);
+    ExecAsyncData *data = g_task_get_task_data (task);
+    gboolean is_out = (fd == data->out_fd);
+    struct pollfd poll_fd = ZERO_INIT;
+    GError *l_error = NULL;
+
+    poll_fd.fd = fd;
+    /* GIOCondition values are the same as the poll() ones */
+    poll_fd.revents = (short) condition;
+
+    if (!_process_fd_event (fd, &poll_fd,
+                            is_out ? data->out_reader : data->err_reader,
+                            is_out ? &(data->out_done) : &(data->err_done),
+                            &(data->ctx), &l_error)) {
+        if (!data->error)
+            data->error = l_error;
+        else
+            g_clear_error (&l_error);
+        /* stop reading from the fd, we still need to wait for the process */
+        if (is_out)
+            data->out_done = TRUE;
+        else
+            data->err_done = TRUE;
+    }
+
+    if (is_out ? data->out_done : data->err_done) {
+        exec_async_try_complete (task);
+        return G_SOURCE_REMOVE;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void exec_async_child_exited (GPid pid, gint wait_status, gpointer user_data) {
+    GTask *task = G_TASK (user_data);
+    ExecAsyncData *data = g_task_get_task_data (task);
+
+    data->wait_status = wait_status;
+    g_spawn_close_pid (pid);
+    g_atomic_int_set (&(data->child_done), TRUE);
+
+    exec_async_try_complete (task);
+}
+
+/* may be called from any thread */
+static void exec_async_cancelled (GCancellable *cancellable G_GNUC_UNUSED, gpointer user_data) {
+    ExecAsyncData *data = user_data;
+
+    if (!g_atomic_int_get (&(data->child_done)))
+        kill (data->pid, SIGTERM);
+}
+
+static GSource* exec_async_attach_fd (GTask *task, gint fd) {
+    GSource *source = NULL;
+
+    source = g_unix_fd_source_new (fd, G_IO_IN | G_IO_HUP | G_IO_ERR);
+    g_source_set_callback (source, (GSourceFunc) (void (*) (void)) exec_async_fd_ready,
+                           g_object_ref (task), g_object_unref);
+    g_source_attach (source, g_task_get_context (task));
+
+    return source;
+}
+
+static void _utils_exec_async (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract,
+                               gpointer source_tag, GCancellable *cancellable,
+                               GAsyncReadyCallback callback, gpointer user_data) {
+    const gchar **args = NULL;
+    gchar *args_str = NULL;
+    gchar *msg = NULL;
+    ExecEnv *env = NULL;
+    GTask *task = NULL;
+    ExecAsyncData *data = NULL;
+    int flags;
+    gboolean ret = FALSE;
+    GError *l_error = NULL;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, source_tag);
+
+    if (g_task_return_error_if_cancelled (task)) {
+        g_object_unref (task);
+        return;
+    }
+
+    data = g_new0 (ExecAsyncData, 1);
+    data->ctx.prog_extract = prog_extract;
+    data->out_fd = -1;
+    data->err_fd = -1;
+    data->out_reader = line_reader_new (FALSE, TRUE);
+    data->err_reader = line_reader_new (TRUE, TRUE);
+    g_task_set_task_data (task, data, (GDestroyNotify) exec_async_data_free);
+
+    args = add_extra_args (argv, extra);
+
+    /* not pushed to the span stack, the process finishes in the main loop */
+    timing_span_start (&(data->span), NULL, NULL);
+    data->timing_cmd = timing_command (&(data->span), args ? args : argv);
+
+    data->task_id = log_running (args ? args : argv);
+
+    env = get_exec_env ();
+    ret = spawn_with_pipes (args ? args : argv, env->envp, &(data->pid), NULL, &(data->out_fd), &(data->err_fd), &l_error);
+    exec_env_unref (env);
+
+    if (!ret) {
+        timing_span_finish (&(data->span), data->task_id, data->timing_cmd, 0, -1);
+        g_free (args);
+        g_task_return_error (task, l_error);
+        g_object_unref (task);
+        return;
+    }
+    timing_span_mark_spawned (&(data->span));
+
+    args_str = g_strjoinv (" ", args ? (gchar **) args : (gchar **) argv);
+    msg = g_strdup_printf ("Started '%s'", args_str);
+    data->ctx.progress_id = bd_utils_report_started (msg);
+    g_free (args_str);
+    g_free (args);
+    g_free (msg);
+
+    /* set both fds for non-blocking read */
+    flags = fcntl (data->out_fd, F_GETFL, 0);
+    if (fcntl (data->out_fd, F_SETFL, flags | O_NONBLOCK))
+        bd_utils_log_format (BD_UTILS_LOG_WARNING,
+                             "_utils_exec_async: Failed to set out_fd non-blocking: %m");
+    flags = fcntl (data->err_fd, F_GETFL, 0);
+    if (fcntl (data->err_fd, F_SETFL, flags | O_NONBLOCK))
+        bd_utils_log_format (BD_UTILS_LOG_WARNING,
+                             "_utils_exec_async: Failed to set err_fd non-blocking: %m");
+
+    data->out_source = exec_async_attach_fd (task, data->out_fd);
+    data->err_source = exec_async_attach_fd (task, data->err_fd);
+
+    data->child_source = g_child_watch_source_new (data->pid);
+    g_source_set_callback (data->child_source, (GSourceFunc) (void (*) (void)) exec_async_child_exited,
+                           g_object_ref (task), g_object_unref);
+    g_source_attach (data->child_source, g_task_get_context (task));
+
+    if (cancellable) {
+        data->cancellable = cancellable;
+        data->cancel_id = g_cancellable_connect (cancellable, G_CALLBACK (exec_async_cancelled), data, NULL);
+    }
+
+    /* the sources hold references to the task now */
+    g_object_unref (task);
+}
+
+/**
+ * bd_utils_exec_and_report_progress_async:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (nullable) (array zero-terminated=1): extra arguments
+ * @prog_extract: (scope notified) (nullable): function for extracting progress information
+ * @cancellable: (nullable): object to cancel the operation (terminates the process)
+ * @callback: (scope async): callback to call when the process finishes
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Asynchronous version of bd_utils_exec_and_report_progress(). The output of
+ * the process is processed in the thread-default main context of the caller
+ * and @callback is called from it once the process finishes. Use
+ * bd_utils_exec_and_report_progress_finish() to get the result.
+ */
+void bd_utils_exec_and_report_progress_async (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract,
+                                              GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data) {
+    _utils_exec_async (argv, extra, prog_extract, bd_utils_exec_and_report_progress_async,
+                       cancellable, callback, user_data);
+}
+
+/**
+ * bd_utils_exec_and_report_progress_finish:
+ * @result: the result passed to the callback of bd_utils_exec_and_report_progress_async()
+ * @proc_status: (out): place to store the process exit status
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the process was successfully executed (no error and exit code 0) or not
+ */
+gboolean bd_utils_exec_and_report_progress_finish (GAsyncResult *result, gint *proc_status, GError **error) {
+    ExecAsyncData *data = NULL;
+
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+    g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == bd_utils_exec_and_report_progress_async, FALSE);
+
+    data = g_task_get_task_data (G_TASK (result));
+    *proc_status = data ? data->proc_status : 0;
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * bd_utils_exec_and_capture_output_async:
+ * @argv: (array zero-terminated=1): the argv array for the call
+ * @extra: (nullable) (array zero-terminated=1): extra arguments
+ * @cancellable: (nullable): object to cancel the operation (terminates the process)
+ * @callback: (scope async): callback to call when the process finishes
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Asynchronous version of bd_utils_exec_and_capture_output(). The output of
+ * the process is processed in the thread-default main context of the caller
+ * and @callback is called from it once the process finishes. Use
+ * bd_utils_exec_and_capture_output_finish() to get the result.
+ */
+void bd_utils_exec_and_capture_output_async (const gchar **argv, const BDExtraArg **extra, GCancellable *cancellable,
+                                             GAsyncReadyCallback callback, gpointer user_data) {
+    _utils_exec_async (argv, extra, NULL, bd_utils_exec_and_capture_output_async,
+                       cancellable, callback, user_data);
+}
+
+/**
+ * bd_utils_exec_and_capture_output_finish:
+ * @result: the result passed to the callback of bd_utils_exec_and_capture_output_async()
+ * @output: (out): variable to store output to
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: whether the process was successfully executed capturing the output or not
+ */
+gboolean bd_utils_exec_and_capture_output_finish (GAsyncResult *result, gchar **output, GError **error) {
+    ExecAsyncData *data = NULL;
+
+    g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+    g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == bd_utils_exec_and_capture_output_async, FALSE);
+
+    if (!g_task_propagate_boolean (G_TASK (result), error))
+        return FALSE;
+
+    data = g_task_get_task_data (G_TASK (result));
+    if (data->out_reader->data->len == 0) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT,
+                     "Process didn't provide any data on standard output. "
+                     "Error output: %s", data->err_reader->data->str);
+        return FALSE;
+    }
+
+    *output = g_strdup (data->out_reader->data->str);
+    return TRUE;
+}
+
 /**
  * bd_utils_version_cmp:
  * @ver_string1: first version string
@@ -716,6 +1859,180 @@ gint bd_utils_version_cmp (const gchar *ver_string1, const gchar *ver_string2, G
     return ret;
 }
 
+static GMutex version_cache_lock;
+static gchar *version_cache_dir = NULL;
+
+/**
+ * bd_utils_set_util_version_cache_dir:
+ * @path: (nullable): directory to store the cached version information in
+ *                    or %NULL to disable the cache
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Sets the directory used to cache the version information of the utilities
+ * checked by bd_utils_check_util_version() across processes. The cached output
+ * of `$util --version` is used as long as the resolved binary has the same
+ * device, inode, size and mtime, so the utilities don't need to be run again
+ * by every new process. The directory should only be writable by its owner,
+ * a tmpfs location like `/run/libblockdev` is a good choice.
+ *
+ * The cache is disabled by default.
+ *
+ * Returns: whether the cache directory was successfully set or not
+ */
+gboolean bd_utils_set_util_version_cache_dir (const gchar *path, GError **error) {
+    if (path && g_mkdir_with_parents (path, 0700) != 0) {
+        g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED,
+                     "Failed to create the version cache directory '%s': %m", path);
+        return FALSE;
+    }
+
+    g_mutex_lock (&version_cache_lock);
+    g_free (version_cache_dir);
+    version_cache_dir = g_strdup (path);
+    g_mutex_unlock (&version_cache_lock);
+
+    return TRUE;
+}
+
+/* returns the path of the cache file for the given binary and version argument or %NULL if the cache is disabled */
+static gchar* get_version_cache_file (const gchar *bin_path, const gchar *version_arg) {
+    gchar *key = NULL;
+    gchar *checksum = NULL;
+    gchar *file_name = NULL;
+    gchar *ret = NULL;
+
+    g_mutex_lock (&version_cache_lock);
+    if (version_cache_dir) {
+        key = g_strdup_printf ("%s\n%s", bin_path, version_arg);
+        checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, key, -1);
+        file_name = g_strdup_printf ("%s.ver", checksum);
+        ret = g_build_filename (version_cache_dir, file_name, NULL);
+        g_free (key);
+        g_free (checksum);
+        g_free (file_name);
+    }
+    g_mutex_unlock (&version_cache_lock);
+
+    return ret;
+}
+
+static gchar* read_version_cache (const gchar *cache_file, const gchar *bin_path, const gchar *version_arg, const struct stat *bin_stat) {
+    GKeyFile *key_file = NULL;
+    struct stat cache_stat;
+    gchar *path = NULL;
+    gchar *arg = NULL;
+    gchar *output = NULL;
+    gboolean valid = FALSE;
+
+    /* don't trust cache files somebody else could have written */
+    if (stat (cache_file, &cache_stat) != 0 || cache_stat.st_uid != geteuid () ||
+        (cache_stat.st_mode & (S_IWGRP | S_IWOTH)))
+        return NULL;
+
+    key_file = g_key_file_new ();
+    if (!g_key_file_load_from_file (key_file, cache_file, G_KEY_FILE_NONE, NULL)) {
+        g_key_file_free (key_file);
+        return NULL;
+    }
+
+    path = g_key_file_get_string (key_file, "util", "path", NULL);
+    arg = g_key_file_get_string (key_file, "util", "version_arg", NULL);
+    valid = (g_strcmp0 (path, bin_path) == 0) && (g_strcmp0 (arg, version_arg) == 0) &&
+            (guint64) g_key_file_get_uint64 (key_file, "util", "dev", NULL) == (guint64) bin_stat->st_dev &&
+            (guint64) g_key_file_get_uint64 (key_file, "util", "ino", NULL) == (guint64) bin_stat->st_ino &&
+            (gint64) g_key_file_get_int64 (key_file, "util", "size", NULL) == (gint64) bin_stat->st_size &&
+            (gint64) g_key_file_get_int64 (key_file, "util", "mtime", NULL) == (gint64) bin_stat->st_mtim.tv_sec &&
+            (gint64) g_key_file_get_int64 (key_file, "util", "mtime_nsec", NULL) == (gint64) bin_stat->st_mtim.tv_nsec;
+    if (valid)
+        output = g_key_file_get_string (key_file, "util", "output", NULL);
+
+    g_free (path);
+    g_free (arg);
+    g_key_file_free (key_file);
+
+    return output;
+}
+
+static void write_version_cache (const gchar *cache_file, const gchar *bin_path, const gchar *version_arg, const struct stat *bin_stat, const gchar *output) {
+    GKeyFile *key_file = NULL;
+    gchar *data = NULL;
+    gsize data_len = 0;
+    GError *l_error = NULL;
+
+    key_file = g_key_file_new ();
+    g_key_file_set_string (key_file, "util", "path", bin_path);
+    g_key_file_set_string (key_file, "util", "version_arg", version_arg);
+    g_key_file_set_uint64 (key_file, "util", "dev", (guint64) bin_stat->st_dev);
+    g_key_file_set_uint64 (key_file, "util", "ino", (guint64) bin_stat->st_ino);
+    g_key_file_set_int64 (key_file, "util", "size", (gint64) bin_stat->st_size);
+    g_key_file_set_int64 (key_file, "util", "mtime", (gint64) bin_stat->st_mtim.tv_sec);
+    g_key_file_set_int64 (key_file, "util", "mtime_nsec", (gint64) bin_stat->st_mtim.tv_nsec);
+    g_key_file_set_string (key_file, "util", "output", output);
+
+    data = g_key_file_to_data (key_file, &data_len, NULL);
+    /* written to a temporary file and renamed so readers never see a partial file */
+    if (!g_file_set_contents (cache_file, data, data_len, &l_error)) {
+        bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Failed to write version cache file '%s': %s",
+                             cache_file, l_error->message);
+        g_clear_error (&l_error);
+    } else
+        chmod (cache_file, 0600);
+
+    g_free (data);
+    g_key_file_free (key_file);
+}
+
+/* runs "$util $version_arg" (or uses the cached output) and returns its output */
+static gchar* get_util_version_output (const gchar *util, const gchar *util_path, const gchar *version_arg, GError **error) {
+    const gchar *argv[] = {util, version_arg, NULL};
+    gchar *bin_path = NULL;
+    gchar *cache_file = NULL;
+    struct stat bin_stat;
+    gchar *output = NULL;
+    gboolean succ = FALSE;
+    GError *l_error = NULL;
+
+    bin_path = realpath (util_path, NULL);
+    if (bin_path && stat (bin_path, &bin_stat) == 0)
+        cache_file = get_version_cache_file (bin_path, version_arg);
+
+    if (cache_file) {
+        output = read_version_cache (cache_file, bin_path, version_arg, &bin_stat);
+        if (output) {
+            bd_utils_log_format (BD_UTILS_LOG_DEBUG, "Using cached version information for '%s'", bin_path);
+            g_free (cache_file);
+            free (bin_path);
+            return output;
+        }
+    }
+
+    succ = bd_utils_exec_and_capture_output (argv, NULL, &output, &l_error);
+    if (!succ) {
+        /* if we got nothing on STDOUT, try using STDERR data from error message */
+        if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
+            output = g_strdup (l_error->message);
+            g_clear_error (&l_error);
+        } else if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED)) {
+            /* exit status != 0, try using the output anyway */
+            output = g_strdup (l_error->message);
+            g_clear_error (&l_error);
+        } else {
+            g_propagate_error (error, l_error);
+            g_free (cache_file);
+            free (bin_path);
+            return NULL;
+        }
+    }
+
+    if (cache_file)
+        write_version_cache (cache_file, bin_path, version_arg, &bin_stat, output);
+
+    g_free (cache_file);
+    free (bin_path);
+
+    return output;
+}
+
 /**
  * bd_utils_check_util_version:
  * @util: name of the utility to check
@@ -736,7 +2053,6 @@ gint bd_utils_version_cmp (const gchar *ver_string1, const gchar *ver_string2, G
  */
 gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, const gchar *version_arg, const gchar *version_regexp, GError **error) {
     gchar *util_path = NULL;
-    const gchar *argv[] = {util, version_arg ? version_arg : "--version", NULL};
     gchar *output = NULL;
     gboolean succ = FALSE;
     GRegex *regex = NULL;
@@ -745,30 +2061,27 @@ gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, c
     GError *l_error = NULL;
 
     util_path = g_find_program_in_path (util);
+    if (!util_path && exec_replay_has_util (util))
+        /* not installed, but replayed (see bd_utils_exec_replay_add()) */
+        util_path = g_strdup (util);
     if (!util_path) {
         g_set_error (error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_UTIL_UNAVAILABLE,
                      "The '%s' utility is not available", util);
         return FALSE;
     }
-    g_free (util_path);
 
-    if (!version)
+    if (!version) {
         /* nothing more to do here */
+        g_free (util_path);
         return TRUE;
-
-    succ = bd_utils_exec_and_capture_output (argv, NULL, &output, &l_error);
-    if (!succ) {
-        /* if we got nothing on STDOUT, try using STDERR data from error message */
-        if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_NOOUT)) {
-            output = g_strdup (l_error->message);
-            g_clear_error (&l_error);
-        } else if (g_error_matches (l_error, BD_UTILS_EXEC_ERROR, BD_UTILS_EXEC_ERROR_FAILED)) {
-            /* exit status != 0, try using the output anyway */
-            output = g_strdup (l_error->message);
-            g_clear_error (&l_error);
-        }
     }
 
+    output = get_util_version_output (util, util_path, version_arg ? version_arg : "--version", error);
+    g_free (util_path);
+    if (!output)
+        /* error is already populated */
+        return FALSE;
+
     if (version_regexp) {
         regex = g_regex_new (version_regexp, 0, 0, error);
         if (!regex) {
@@ -864,6 +2177,27 @@ static void thread_progress_muted (guint64 task_id G_GNUC_UNUSED, BDUtilsProgSta
      */
 }
 
+/**
+ * bd_utils_exec_set_thread_cancellable:
+ * @cancellable: (nullable): object to cancel the processes run by the current
+ *                           thread or %NULL to stop using one
+ *
+ * Makes the (synchronous) exec functions called from the current thread fail
+ * with %G_IO_ERROR_CANCELLED when @cancellable is cancelled, a running process
+ * is terminated (with %SIGTERM) then. This allows cancelling long-running
+ * plugin functions (mkfs, pvmove, dasdfmt,...) called in a worker thread from
+ * another thread. Functions not running external utilities are not affected.
+ *
+ * A reference to @cancellable is held until the function is called again
+ * (with %NULL once the thread is done).
+ */
+void bd_utils_exec_set_thread_cancellable (GCancellable *cancellable) {
+    if (cancellable)
+        g_object_ref (cancellable);
+    g_clear_object (&thread_cancellable);
+    thread_cancellable = cancellable;
+}
+
 /**
  * bd_utils_mute_prog_reporting_thread:
  * @error: (out) (optional): place to store error (if any)
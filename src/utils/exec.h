@@ -1,4 +1,5 @@
 #include <glib.h>
+#include <gio/gio.h>
 #include "extra_arg.h"
 
 #ifndef BD_UTILS_EXEC
@@ -48,6 +49,75 @@ typedef void (*BDUtilsProgFunc) (guint64 task_id, BDUtilsProgStatus status, guin
  */
 typedef gboolean (*BDUtilsProgExtract) (const gchar *line, guint8 *completion);
 
+/**
+ * BDUtilsLineFunc:
+ * @line: line read from the output of the spawned command (without the trailing
+ *        newline character)
+ * @from_stderr: whether @line was read from the standard error output or from the
+ *               standard output
+ * @user_data: (closure): user data passed to bd_utils_exec_and_process_lines()
+ *
+ * Callback function used to process lines of the output of a spawned command as
+ * soon as they are read. @line is only valid during the call.
+ *
+ * Returns: whether the line was consumed and should be excluded from the collected
+ *          output or not.
+ */
+typedef gboolean (*BDUtilsLineFunc) (const gchar *line, gboolean from_stderr, gpointer user_data);
+
+/**
+ * BDUtilsTimingRecord:
+ * @task_id: ID of the task the record is for (the same ID is used in the log messages)
+ * @plugin: (nullable): plugin the operation was run by (if known)
+ * @function: (nullable): function the operation was run by (if known)
+ * @command: (nullable): external command (with arguments) or library call run by the operation
+ * @start_time: real time (in microseconds since the Epoch) the operation started at
+ * @spawn_time: time (in microseconds) it took to spawn the external command or -1 if not known
+ *              (or not applicable)
+ * @wall_time: time (in microseconds) the whole operation took
+ * @output_bytes: number of bytes of output (both standard and error outputs for external
+ *                commands) the operation produced
+ * @exit_code: exit code of the external command, 0 for a successful or -1 for a failed
+ *             operation that is not an external command
+ */
+typedef struct BDUtilsTimingRecord {
+    guint64 task_id;
+    gchar *plugin;
+    gchar *function;
+    gchar *command;
+    gint64 start_time;
+    gint64 spawn_time;
+    gint64 wall_time;
+    guint64 output_bytes;
+    gint exit_code;
+} BDUtilsTimingRecord;
+
+/**
+ * BDUtilsTimingFunc:
+ * @record: timing record of a finished operation
+ *
+ * Function called for every finished operation when timing instrumentation is
+ * enabled. It may be called from any thread and @record is only valid during the
+ * call.
+ */
+typedef void (*BDUtilsTimingFunc) (BDUtilsTimingRecord *record);
+
+/**
+ * BDUtilsTimingSpan: (skip)
+ *
+ * Private structure used for timing operations done by plugins. Should only be
+ * used on the stack with bd_utils_timing_span_begin() and bd_utils_timing_span_end().
+ */
+typedef struct BDUtilsTimingSpan {
+    /*< private >*/
+    const gchar *plugin;
+    const gchar *function;
+    gint64 start_time;
+    gint64 start_mono;
+    gint64 spawn_time;
+    struct BDUtilsTimingSpan *parent;
+} BDUtilsTimingSpan;
+
 GQuark bd_utils_exec_error_quark (void);
 #define BD_UTILS_EXEC_ERROR bd_utils_exec_error_quark ()
 typedef enum {
@@ -67,8 +137,18 @@ gboolean bd_utils_exec_and_report_error_no_progress (const gchar **argv, const B
 gboolean bd_utils_exec_and_report_status_error (const gchar **argv, const BDExtraArg **extra, gint *status, GError **error);
 gboolean bd_utils_exec_and_capture_output (const gchar **argv, const BDExtraArg **extra, gchar **output, GError **error);
 gboolean bd_utils_exec_and_report_progress (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract, gint *proc_status, GError **error);
+gboolean bd_utils_exec_and_process_lines (const gchar **argv, const BDExtraArg **extra, BDUtilsLineFunc line_func, gpointer user_data,
+                                          gint *proc_status, gchar **output, GError **error);
 gboolean bd_utils_exec_with_input (const gchar **argv, const gchar *input, const BDExtraArg **extra, GError **error);
+void bd_utils_exec_and_report_progress_async (const gchar **argv, const BDExtraArg **extra, BDUtilsProgExtract prog_extract,
+                                              GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+gboolean bd_utils_exec_and_report_progress_finish (GAsyncResult *result, gint *proc_status, GError **error);
+void bd_utils_exec_and_capture_output_async (const gchar **argv, const BDExtraArg **extra, GCancellable *cancellable,
+                                             GAsyncReadyCallback callback, gpointer user_data);
+gboolean bd_utils_exec_and_capture_output_finish (GAsyncResult *result, gchar **output, GError **error);
+void bd_utils_exec_set_thread_cancellable (GCancellable *cancellable);
 gint bd_utils_version_cmp (const gchar *ver_string1, const gchar *ver_string2, GError **error);
+gboolean bd_utils_set_util_version_cache_dir (const gchar *path, GError **error);
 gboolean bd_utils_check_util_version (const gchar *util, const gchar *version, const gchar *version_arg, const gchar *version_regexp, GError **error);
 
 gboolean bd_utils_init_prog_reporting (BDUtilsProgFunc new_prog_func, GError **error);
@@ -79,6 +159,21 @@ guint64 bd_utils_report_started (const gchar *msg);
 void bd_utils_report_progress (guint64 task_id, guint64 completion, const gchar *msg);
 void bd_utils_report_finished (guint64 task_id, const gchar *msg);
 
+#define BD_UTIL_TYPE_TIMING_RECORD (bd_utils_timing_record_get_type ())
+GType bd_utils_timing_record_get_type (void);
+BDUtilsTimingRecord* bd_utils_timing_record_copy (BDUtilsTimingRecord *record);
+void bd_utils_timing_record_free (BDUtilsTimingRecord *record);
+
+gboolean bd_utils_init_timing (BDUtilsTimingFunc new_timing_func, guint ring_size, GError **error);
+gboolean bd_utils_timing_enabled (void);
+BDUtilsTimingRecord** bd_utils_timing_get_records (gboolean clear);
+void bd_utils_timing_span_begin (BDUtilsTimingSpan *span, const gchar *plugin, const gchar *function);
+void bd_utils_timing_span_end (BDUtilsTimingSpan *span, guint64 task_id, const gchar *command, guint64 output_bytes, gint exit_code);
+
+gboolean bd_utils_exec_replay_add (const gchar *pattern, const gchar *stdout_data, const gchar *stderr_data, gint exit_status, GError **error);
+void bd_utils_exec_replay_set_strict (gboolean strict);
+void bd_utils_exec_replay_clear (void);
+
 guint64 bd_utils_get_next_task_id (void);
 void bd_utils_log_task_status (guint64 task_id, const gchar *msg);
 
@@ -0,0 +1,608 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <glib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <locale.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <linux/fs.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "io_engine.h"
+#include "sizes.h"
+#include "logging.h"
+#include "parallel.h"
+
+#define DEFAULT_QUEUE_DEPTH 64
+#define MAX_QUEUE_DEPTH 4096
+#define DEFAULT_BUFFER_SIZE (4 KiB)
+#define BUFFER_ALIGN (4 KiB)
+
+#define ZERO_OUT_STEP (1 GiB)
+#define ZEROES_CHUNK_SIZE (4 MiB)
+#define ZEROES_REGION_SIZE (256 MiB)
+
+#define _C_LOCALE (locale_t) 0
+
+#ifdef __clang__
+#define ZERO_INIT {}
+#else
+#define ZERO_INIT {0}
+#endif
+
+/* The engine keeps up to @queue_depth requests in flight from a single thread
+   using io_uring if the library was built with liburing and the kernel allows
+   it (io_uring may be disabled with the kernel.io_uring_disabled sysctl or by
+   a seccomp filter). Otherwise the requests are processed one by one with
+   pread() and pwrite(). Every request without its own buffer gets one of the
+   engine buffers (registered with the ring if possible so that the kernel
+   doesn't need to map them for every request) for the time it is in flight. */
+struct BDUtilsIOEngine {
+    guint queue_depth;
+    gsize buffer_size;
+    guint8 *buffers;
+    /* stack of the free buffer slots */
+    guint *free_slots;
+    guint n_free;
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+    gboolean uring;
+    gboolean registered;
+#endif
+};
+
+/**
+ * bd_utils_io_error_quark: (skip)
+ */
+GQuark bd_utils_io_error_quark (void)
+{
+    return g_quark_from_static_string ("g-bd-utils-io-error-quark");
+}
+
+static void reset_slots (BDUtilsIOEngine *engine) {
+    for (guint i = 0; i < engine->queue_depth; i++)
+        engine->free_slots[i] = engine->queue_depth - 1 - i;
+    engine->n_free = engine->queue_depth;
+}
+
+/**
+ * bd_utils_io_engine_new: (skip)
+ * @queue_depth: maximum number of requests in flight or 0 for the default (64)
+ * @buffer_size: size of the engine buffers (for requests without a buffer) or 0
+ *               for the default (4 KiB), needs to be a multiple of 4 KiB
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Returns: (transfer full): a new I/O engine or %NULL in case of error
+ */
+BDUtilsIOEngine* bd_utils_io_engine_new (guint queue_depth, gsize buffer_size, GError **error) {
+    BDUtilsIOEngine *engine = NULL;
+#ifdef HAVE_LIBURING
+    struct iovec *iovecs = NULL;
+    gint ret = 0;
+#endif
+
+    if (queue_depth == 0)
+        queue_depth = DEFAULT_QUEUE_DEPTH;
+    queue_depth = MIN (queue_depth, MAX_QUEUE_DEPTH);
+    if (buffer_size == 0)
+        buffer_size = DEFAULT_BUFFER_SIZE;
+
+    if (buffer_size % BUFFER_ALIGN != 0) {
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_INVAL,
+                     "Invalid buffer size %"G_GSIZE_FORMAT", needs to be a multiple of %d",
+                     buffer_size, BUFFER_ALIGN);
+        return NULL;
+    }
+
+    engine = g_new0 (BDUtilsIOEngine, 1);
+    engine->queue_depth = queue_depth;
+    engine->buffer_size = buffer_size;
+    if (posix_memalign ((void **) &(engine->buffers), BUFFER_ALIGN, queue_depth * buffer_size) != 0) {
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_FAILED,
+                     "Failed to allocate the I/O buffers");
+        g_free (engine);
+        return NULL;
+    }
+    engine->free_slots = g_new (guint, queue_depth);
+    reset_slots (engine);
+
+#ifdef HAVE_LIBURING
+    ret = io_uring_queue_init (queue_depth, &(engine->ring), 0);
+    if (ret < 0) {
+        bd_utils_log_format (BD_UTILS_LOG_INFO, "io_uring not available, using synchronous I/O: %s",
+                             strerror_l (-ret, _C_LOCALE));
+        return engine;
+    }
+    engine->uring = TRUE;
+
+    iovecs = g_new (struct iovec, queue_depth);
+    for (guint i = 0; i < queue_depth; i++) {
+        iovecs[i].iov_base = engine->buffers + i * buffer_size;
+        iovecs[i].iov_len = buffer_size;
+    }
+    /* can fail because of RLIMIT_MEMLOCK, not registered buffers work too */
+    ret = io_uring_register_buffers (&(engine->ring), iovecs, queue_depth);
+    engine->registered = ret == 0;
+    if (ret < 0)
+        bd_utils_log_format (BD_UTILS_LOG_INFO, "Failed to register the I/O buffers: %s",
+                             strerror_l (-ret, _C_LOCALE));
+    g_free (iovecs);
+#endif
+
+    return engine;
+}
+
+/**
+ * bd_utils_io_engine_free: (skip)
+ * @engine: (nullable): engine to free
+ */
+void bd_utils_io_engine_free (BDUtilsIOEngine *engine) {
+    if (!engine)
+        return;
+
+#ifdef HAVE_LIBURING
+    if (engine->uring)
+        io_uring_queue_exit (&(engine->ring));
+#endif
+    free (engine->buffers);
+    g_free (engine->free_slots);
+    g_free (engine);
+}
+
+/**
+ * bd_utils_io_engine_uses_io_uring: (skip)
+ * @engine: engine to check
+ *
+ * Returns: whether @engine submits the requests with io_uring or not
+ */
+gboolean bd_utils_io_engine_uses_io_uring (BDUtilsIOEngine *engine G_GNUC_UNUSED) {
+#ifdef HAVE_LIBURING
+    return engine->uring;
+#else
+    return FALSE;
+#endif
+}
+
+static gboolean check_request (BDUtilsIOEngine *engine, BDUtilsIORequest *request, GError **error) {
+    if (!request->buf && request->write) {
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_INVAL,
+                     "Write requests need a buffer");
+        return FALSE;
+    }
+    if (!request->buf && request->length > engine->buffer_size) {
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_INVAL,
+                     "Request for %"G_GSIZE_FORMAT" bytes is bigger than the I/O buffers",
+                     request->length);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void take_slot (BDUtilsIOEngine *engine, BDUtilsIORequest *request) {
+    request->slot = -1;
+    if (request->buf)
+        return;
+
+    request->slot = (gint) engine->free_slots[--(engine->n_free)];
+    request->buf = engine->buffers + request->slot * engine->buffer_size;
+}
+
+static void complete (BDUtilsIOEngine *engine, BDUtilsIORequest *request, BDUtilsIOCompleteFunc func, gpointer user_data) {
+    if (func)
+        func (request, user_data);
+
+    if (request->slot >= 0) {
+        engine->free_slots[(engine->n_free)++] = (guint) request->slot;
+        request->buf = NULL;
+        request->slot = -1;
+    }
+}
+
+static void run_sync (BDUtilsIOEngine *engine, BDUtilsIORequest *requests, guint n_requests,
+                      BDUtilsIOCompleteFunc func, gpointer user_data) {
+    BDUtilsIORequest *request = NULL;
+    gssize ret = 0;
+
+    for (guint i = 0; i < n_requests; i++) {
+        request = &(requests[i]);
+        take_slot (engine, request);
+        do {
+            if (request->write)
+                ret = pwrite (request->fd, request->buf, request->length, request->offset);
+            else
+                ret = pread (request->fd, request->buf, request->length, request->offset);
+        } while (ret < 0 && errno == EINTR);
+        request->result = ret < 0 ? -errno : ret;
+        complete (engine, request, func, user_data);
+    }
+}
+
+#ifdef HAVE_LIBURING
+static void prep_request (BDUtilsIOEngine *engine, struct io_uring_sqe *sqe, BDUtilsIORequest *request) {
+    if (request->slot >= 0 && engine->registered)
+        io_uring_prep_read_fixed (sqe, request->fd, request->buf, request->length, request->offset, request->slot);
+    else if (request->write)
+        io_uring_prep_write (sqe, request->fd, request->buf, request->length, request->offset);
+    else
+        io_uring_prep_read (sqe, request->fd, request->buf, request->length, request->offset);
+    io_uring_sqe_set_data (sqe, request);
+}
+
+/* waits for at least one completion if @wait (and there is something in
+   flight), returns the number of completions or a negative errno value */
+static gint reap (BDUtilsIOEngine *engine, gboolean wait, BDUtilsIOCompleteFunc func, gpointer user_data) {
+    struct io_uring_cqe *cqe = NULL;
+    BDUtilsIORequest *request = NULL;
+    gint ret = 0;
+    gint n_reaped = 0;
+
+    do {
+        if (wait && n_reaped == 0)
+            ret = io_uring_wait_cqe (&(engine->ring), &cqe);
+        else
+            ret = io_uring_peek_cqe (&(engine->ring), &cqe);
+        if (ret == -EINTR)
+            continue;
+        if (ret < 0)
+            break;
+
+        request = io_uring_cqe_get_data (cqe);
+        request->result = cqe->res;
+        io_uring_cqe_seen (&(engine->ring), cqe);
+        complete (engine, request, func, user_data);
+        n_reaped++;
+    } while (ret == 0 || ret == -EINTR);
+
+    if (ret == -EAGAIN || n_reaped > 0)
+        return n_reaped;
+    return ret;
+}
+
+static gboolean run_uring (BDUtilsIOEngine *engine, BDUtilsIORequest *requests, guint n_requests,
+                           BDUtilsIOCompleteFunc func, gpointer user_data, GError **error) {
+    struct io_uring_sqe *sqe = NULL;
+    guint next = 0;
+    guint n_submitted = 0;
+    guint in_flight = 0;
+    gint ret = 0;
+
+    while (next < n_requests || in_flight > 0) {
+        /* fill the submission queue */
+        while (next < n_requests && in_flight + (next - n_submitted) < engine->queue_depth) {
+            sqe = io_uring_get_sqe (&(engine->ring));
+            if (!sqe)
+                break;
+            take_slot (engine, &(requests[next]));
+            prep_request (engine, sqe, &(requests[next]));
+            next++;
+        }
+
+        ret = 0;
+        if (next > n_submitted) {
+            ret = io_uring_submit (&(engine->ring));
+            if (ret > 0) {
+                n_submitted += ret;
+                in_flight += ret;
+            } else if (ret != -EAGAIN && ret != -EBUSY && ret != -EINTR) {
+                /* the ring is not usable anymore, wait for the submitted
+                   requests and do the rest synchronously */
+                bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to submit I/O requests, using synchronous I/O: %s",
+                                     strerror_l (-ret, _C_LOCALE));
+                while (in_flight > 0 && (ret = reap (engine, TRUE, func, user_data)) > 0)
+                    in_flight -= ret;
+                if (in_flight > 0) {
+                    g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_FAILED,
+                                 "Failed to wait for I/O requests: %s", strerror_l (-ret, _C_LOCALE));
+                    return FALSE;
+                }
+                io_uring_queue_exit (&(engine->ring));
+                engine->uring = FALSE;
+                engine->registered = FALSE;
+                for (guint i = n_submitted; i < next; i++) {
+                    if (requests[i].slot >= 0)
+                        requests[i].buf = NULL;
+                    requests[i].slot = -1;
+                }
+                reset_slots (engine);
+                run_sync (engine, requests + n_submitted, n_requests - n_submitted, func, user_data);
+                return TRUE;
+            }
+        }
+
+        if (in_flight > 0) {
+            /* wait only if no more requests can be submitted now */
+            ret = reap (engine, next == n_requests || in_flight >= engine->queue_depth || ret < 0,
+                        func, user_data);
+            if (ret < 0) {
+                g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_FAILED,
+                             "Failed to wait for I/O requests: %s", strerror_l (-ret, _C_LOCALE));
+                return FALSE;
+            }
+            in_flight -= ret;
+        }
+    }
+
+    return TRUE;
+}
+#endif
+
+/**
+ * bd_utils_io_engine_run: (skip)
+ * @engine: engine to use
+ * @requests: (array length=n_requests): requests to run
+ * @n_requests: number of @requests
+ * @func: (nullable) (scope call): function to call for every finished request
+ * @user_data: (closure): data for @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Runs all the @requests keeping up to the queue depth of @engine requests in
+ * flight and waits for them to finish. Failures of the individual requests are
+ * reported in their result field, an error is only reported if the engine
+ * itself failed -- the state of the requests not completed yet is undefined
+ * then.
+ *
+ * Returns: whether all the @requests were run or not
+ */
+gboolean bd_utils_io_engine_run (BDUtilsIOEngine *engine, BDUtilsIORequest *requests, guint n_requests,
+                                 BDUtilsIOCompleteFunc func, gpointer user_data, GError **error) {
+    for (guint i = 0; i < n_requests; i++)
+        if (!check_request (engine, &(requests[i]), error))
+            return FALSE;
+
+#ifdef HAVE_LIBURING
+    if (engine->uring)
+        return run_uring (engine, requests, n_requests, func, user_data, error);
+#endif
+
+    run_sync (engine, requests, n_requests, func, user_data);
+    return TRUE;
+}
+
+/**
+ * bd_utils_io_open_direct: (skip)
+ * @path: path of the device (file) to open
+ * @flags: flags for open(), %O_DIRECT and %O_CLOEXEC are added
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Opens @path for direct I/O, falls back to buffered I/O if @path doesn't
+ * support %O_DIRECT (e.g. a file on tmpfs).
+ *
+ * Returns: file descriptor for @path or -1 in case of error
+ */
+gint bd_utils_io_open_direct (const gchar *path, gint flags, GError **error) {
+    gint fd = -1;
+
+    fd = open (path, flags | O_DIRECT | O_CLOEXEC);
+    if (fd == -1 && errno == EINVAL)
+        fd = open (path, flags | O_CLOEXEC);
+    if (fd == -1)
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_FAILED,
+                     "Failed to open '%s': %s", path, strerror_l (errno, _C_LOCALE));
+
+    return fd;
+}
+
+/**
+ * bd_utils_io_can_offload_zeroes: (skip)
+ * @fd: file descriptor of a device
+ *
+ * Returns: whether the block device behind @fd can offload writing zeroes
+ *          (REQ_OP_WRITE_ZEROES) or not
+ */
+gboolean bd_utils_io_can_offload_zeroes (gint fd) {
+    struct stat st;
+    g_autofree gchar *path = NULL;
+    g_autofree gchar *contents = NULL;
+
+    if (fstat (fd, &st) != 0 || !S_ISBLK (st.st_mode))
+        return FALSE;
+
+    path = g_strdup_printf ("/sys/dev/block/%u:%u/queue/write_zeroes_max_bytes",
+                            major (st.st_rdev), minor (st.st_rdev));
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        return FALSE;
+
+    return g_ascii_strtoull (contents, NULL, 10) > 0;
+}
+
+/**
+ * bd_utils_io_zero_out_device: (skip)
+ * @fd: file descriptor of the block device
+ * @device: name of the device (for the error messages)
+ * @size: size of the device
+ * @discard: whether to discard the blocks (%BLKDISCARD) instead of zeroing
+ *           them out (%BLKZEROOUT)
+ * @func: (nullable): function to report the progress with
+ * @user_data: data passed to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Discards or zeroes out the whole device in 1 GiB steps. The kernel offloads
+ * zeroing out to the device if possible and writes the zeroes itself otherwise.
+ *
+ * Returns: whether the device was successfully discarded (zeroed out) or not,
+ *          %BD_UTILS_IO_ERROR_NOT_SUPPORTED in @error means the device doesn't
+ *          support the operation at all
+ */
+gboolean bd_utils_io_zero_out_device (gint fd, const gchar *device, guint64 size, gboolean discard,
+                                      BDUtilsIOProgressFunc func, gpointer user_data, GError **error) {
+    guint64 range[2];
+
+    for (guint64 offset = 0; offset < size; offset += ZERO_OUT_STEP) {
+        range[0] = offset;
+        range[1] = MIN (ZERO_OUT_STEP, size - offset);
+        if (ioctl (fd, discard ? BLKDISCARD : BLKZEROOUT, &range) != 0) {
+            if (offset == 0 && (errno == EOPNOTSUPP || errno == EINVAL || errno == ENOTTY)) {
+                g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_NOT_SUPPORTED,
+                             "%s is not supported by the device '%s'",
+                             discard ? "Discard" : "Zeroing out", device);
+                return FALSE;
+            }
+            g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_FAILED,
+                         "Failed to %s the device '%s': %s",
+                         discard ? "discard" : "zero out", device, strerror_l (errno, _C_LOCALE));
+            return FALSE;
+        }
+        if (func)
+            func (size, offset + range[1], user_data);
+    }
+
+    return TRUE;
+}
+
+typedef struct ZeroesData {
+    gint fd;
+    guint64 size;
+    guint64 next_region;
+    guint64 done;
+    gint err;
+    BDUtilsIOProgressFunc func;
+    gpointer user_data;
+    GMutex lock;
+} ZeroesData;
+
+static void write_zeroes_regions (gpointer item, gpointer user_data G_GNUC_UNUSED) {
+    ZeroesData *data = (ZeroesData *) item;
+    void *buf = NULL;
+    guint64 region = 0;
+    guint64 end = 0;
+    ssize_t written = 0;
+    gint err = 0;
+
+    err = posix_memalign (&buf, BUFFER_ALIGN, ZEROES_CHUNK_SIZE);
+    if (err == 0)
+        memset (buf, 0, ZEROES_CHUNK_SIZE);
+
+    while (err == 0) {
+        g_mutex_lock (&(data->lock));
+        err = data->err;
+        region = data->next_region;
+        data->next_region += ZEROES_REGION_SIZE;
+        g_mutex_unlock (&(data->lock));
+        if (err != 0 || region >= data->size)
+            break;
+
+        end = MIN (region + ZEROES_REGION_SIZE, data->size);
+        for (guint64 offset = region; offset < end && err == 0; offset += written) {
+            written = pwrite (data->fd, buf, MIN (ZEROES_CHUNK_SIZE, end - offset), offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    written = 0;
+                    continue;
+                }
+                err = errno;
+            } else if (written == 0)
+                err = ENOSPC;
+        }
+
+        if (err == 0) {
+            g_mutex_lock (&(data->lock));
+            data->done += end - region;
+            if (data->func)
+                data->func (data->size, data->done, data->user_data);
+            g_mutex_unlock (&(data->lock));
+        }
+    }
+
+    free (buf);
+
+    g_mutex_lock (&(data->lock));
+    if (err != 0 && data->err == 0)
+        data->err = err;
+    g_mutex_unlock (&(data->lock));
+}
+
+/**
+ * bd_utils_io_write_zeroes: (skip)
+ * @path: path of the block device to fill with zeroes
+ * @size: size of the device, needs to be a multiple of its logical block size
+ * @max_workers: maximum number of threads writing the zeroes or 0 for the
+ *               default (number of CPUs)
+ * @func: (nullable): function to report the progress with
+ * @user_data: data passed to @func
+ * @error: (out) (optional): place to store error (if any)
+ *
+ * Fills @path with zeroes using large direct I/O writes of 256 MiB regions in
+ * parallel.
+ *
+ * Returns: whether @path was successfully filled with zeroes or not,
+ *          %BD_UTILS_IO_ERROR_NOT_SUPPORTED in @error means direct I/O is not
+ *          possible for @path
+ */
+gboolean bd_utils_io_write_zeroes (const gchar *path, guint64 size, guint max_workers,
+                                   BDUtilsIOProgressFunc func, gpointer user_data, GError **error) {
+    ZeroesData data = ZERO_INIT;
+    gpointer *items = NULL;
+    guint n_regions = 0;
+    gint block_size = 0;
+    gint fd = -1;
+
+    fd = open (path, O_WRONLY | O_DIRECT | O_CLOEXEC);
+    if (fd < 0) {
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_NOT_SUPPORTED,
+                     "Failed to open '%s' for direct I/O: %s", path, strerror_l (errno, _C_LOCALE));
+        return FALSE;
+    }
+
+    if (ioctl (fd, BLKSSZGET, &block_size) != 0 || block_size <= 0 ||
+        size % block_size != 0 || BUFFER_ALIGN % block_size != 0) {
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_NOT_SUPPORTED,
+                     "Size of '%s' is not suitable for direct I/O", path);
+        close (fd);
+        return FALSE;
+    }
+
+    data.fd = fd;
+    data.size = size;
+    data.func = func;
+    data.user_data = user_data;
+    g_mutex_init (&(data.lock));
+
+    /* all the workers share the same data and take the regions one by one */
+    n_regions = (size + ZEROES_REGION_SIZE - 1) / ZEROES_REGION_SIZE;
+    max_workers = MAX (bd_utils_parallel_workers (max_workers, n_regions), 1);
+    items = g_new (gpointer, max_workers);
+    for (guint i = 0; i < max_workers; i++)
+        items[i] = &data;
+    bd_utils_parallel_run (write_zeroes_regions, items, max_workers, max_workers, NULL);
+    g_free (items);
+
+    if (data.err == 0 && fsync (fd) != 0)
+        data.err = errno;
+    close (fd);
+
+    g_mutex_clear (&(data.lock));
+
+    if (data.err != 0) {
+        g_set_error (error, BD_UTILS_IO_ERROR, BD_UTILS_IO_ERROR_FAILED,
+                     "Failed to write zeroes to '%s': %s", path, strerror_l (data.err, _C_LOCALE));
+        return FALSE;
+    }
+
+    return TRUE;
+}
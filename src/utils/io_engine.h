@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_UTILS_IO_ENGINE
+#define BD_UTILS_IO_ENGINE
+
+/* Internal API for the plugins, the header is not installed so the ABI of the
+   engine is not part of the public API of the library. */
+
+GQuark bd_utils_io_error_quark (void);
+#define BD_UTILS_IO_ERROR bd_utils_io_error_quark ()
+
+typedef enum {
+    BD_UTILS_IO_ERROR_FAILED,
+    BD_UTILS_IO_ERROR_INVAL,
+    BD_UTILS_IO_ERROR_NOT_SUPPORTED,
+} BDUtilsIOError;
+
+/**
+ * BDUtilsIOEngine: (skip)
+ *
+ * Private structure of the engine used by the library and its plugins for
+ * direct (batched) reads and writes of devices.
+ */
+typedef struct BDUtilsIOEngine BDUtilsIOEngine;
+
+/**
+ * BDUtilsIORequest: (skip)
+ * @fd: file descriptor to read from (write to)
+ * @offset: offset to read from (write to)
+ * @length: number of bytes to read (write), at most the buffer size of the
+ *          engine for requests without a buffer
+ * @write: whether to write @buf instead of reading
+ * @buf: (nullable): buffer to read into (write from) or %NULL to read into one
+ *       of the (aligned, registered) buffers of the engine, only valid in the
+ *       completion function then
+ * @result: number of bytes read (written) or a negative errno value
+ * @user_data: data for the completion function
+ *
+ * Single request for a #BDUtilsIOEngine. For file descriptors opened with
+ * %O_DIRECT, @offset, @length and @buf need to be aligned to the logical block
+ * size of the device (the engine buffers are aligned to 4 KiB).
+ */
+typedef struct BDUtilsIORequest {
+    gint fd;
+    guint64 offset;
+    gsize length;
+    gboolean write;
+    gpointer buf;
+    gssize result;
+    gpointer user_data;
+    /*< private >*/
+    gint slot;
+} BDUtilsIORequest;
+
+/**
+ * BDUtilsIOCompleteFunc: (skip)
+ * @request: the finished request (with the result set)
+ * @user_data: data passed to bd_utils_io_engine_run()
+ *
+ * Function called for every finished request, always in the thread running
+ * bd_utils_io_engine_run().
+ */
+typedef void (*BDUtilsIOCompleteFunc) (BDUtilsIORequest *request, gpointer user_data);
+
+BDUtilsIOEngine* bd_utils_io_engine_new (guint queue_depth, gsize buffer_size, GError **error);
+void bd_utils_io_engine_free (BDUtilsIOEngine *engine);
+gboolean bd_utils_io_engine_uses_io_uring (BDUtilsIOEngine *engine);
+gboolean bd_utils_io_engine_run (BDUtilsIOEngine *engine, BDUtilsIORequest *requests, guint n_requests,
+                                 BDUtilsIOCompleteFunc func, gpointer user_data, GError **error);
+
+gint bd_utils_io_open_direct (const gchar *path, gint flags, GError **error);
+
+/**
+ * BDUtilsIOProgressFunc: (skip)
+ * @size: size of the whole device
+ * @done: number of bytes already processed
+ * @user_data: data passed to the function doing the work
+ *
+ * Function reporting progress of work done on a device, may be called from any
+ * thread (but never from multiple threads at the same time).
+ */
+typedef void (*BDUtilsIOProgressFunc) (guint64 size, guint64 done, gpointer user_data);
+
+gboolean bd_utils_io_can_offload_zeroes (gint fd);
+gboolean bd_utils_io_zero_out_device (gint fd, const gchar *device, guint64 size, gboolean discard,
+                                      BDUtilsIOProgressFunc func, gpointer user_data, GError **error);
+gboolean bd_utils_io_write_zeroes (const gchar *path, guint64 size, guint max_workers,
+                                   BDUtilsIOProgressFunc func, gpointer user_data, GError **error);
+
+#endif  /* BD_UTILS_IO_ENGINE */
@@ -31,6 +31,9 @@ static int log_level = BD_UTILS_LOG_DEBUG;
 static int log_level = BD_UTILS_LOG_WARNING;
 #endif
 
+/* maximum number of bytes of programs' output to log, 0 means no limit */
+static guint64 log_output_limit = 0;
+
 /**
  * bd_utils_init_logging:
  * @new_log_func: (nullable) (scope notified): logging function to use or
@@ -66,13 +69,49 @@ void bd_utils_set_log_level (gint level) {
     log_level = level;
 }
 
+/**
+ * bd_utils_set_log_output_limit:
+ * @limit: maximum number of bytes of the standard (error) output of the executed
+ *         programs to log or 0 for no limit
+ *
+ * By default the whole standard output and standard error output of every
+ * program executed by the library is logged. With the @limit set, only the
+ * first @limit bytes are logged followed by a note with the total size of the
+ * output. This prevents debug logging from copying huge outputs (e.g. of the
+ * LVM reporting tools).
+ */
+void bd_utils_set_log_output_limit (guint64 limit) {
+    log_output_limit = limit;
+}
+
+/**
+ * bd_utils_get_log_output_limit:
+ *
+ * Returns: the limit set by bd_utils_set_log_output_limit() (0 if no limit is set)
+ */
+guint64 bd_utils_get_log_output_limit (void) {
+    return log_output_limit;
+}
+
+/**
+ * bd_utils_log_enabled:
+ * @level: log level
+ *
+ * Returns: whether messages with the @level are logged or discarded, useful
+ *          for skipping expensive formatting of messages that would be
+ *          discarded anyway
+ */
+gboolean bd_utils_log_enabled (gint level) {
+    return log_func && level <= log_level;
+}
+
 /**
  * bd_utils_log:
  * @level: log level
  * @msg: log message
  */
 void bd_utils_log (gint level, const gchar *msg) {
-    if (log_func && level <= log_level)
+    if (bd_utils_log_enabled (level))
         log_func (level, msg);
 }
 
@@ -87,7 +126,7 @@ void bd_utils_log_format (gint level, const gchar *format, ...) {
     va_list args;
     gint ret = 0;
 
-    if (log_func && level <= log_level) {
+    if (bd_utils_log_enabled (level)) {
         va_start (args, format);
         ret = g_vasprintf (&msg, format, args);
         va_end (args);
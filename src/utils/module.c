@@ -73,6 +73,61 @@ static void set_kmod_logging (struct kmod_ctx *ctx) {
     kmod_set_log_fn (ctx, utils_kmod_log_redirect, NULL);
 }
 
+/* one kmod context for the whole process, loading the indexes (modules.dep,
+   modules.alias,...) is quite expensive, the context is not thread-safe so
+   kmod_lock needs to be held when using it */
+static struct kmod_ctx *kmod_ctx = NULL;
+static GMutex kmod_lock;
+
+/* cache of the results of bd_utils_have_kernel_module() for kmod_release */
+static GHashTable *have_module_cache = NULL;
+static gchar *kmod_release = NULL;
+
+static void drop_kmod_ctx (void) {
+    if (kmod_ctx) {
+        kmod_unref (kmod_ctx);
+        kmod_ctx = NULL;
+    }
+    if (have_module_cache)
+        g_hash_table_remove_all (have_module_cache);
+    g_clear_pointer (&kmod_release, g_free);
+}
+
+/* needs to be called with kmod_lock held, returns the (borrowed) context */
+static struct kmod_ctx* get_kmod_ctx (GError **error) {
+    gchar *null_config = NULL;
+    struct utsname buf;
+
+    if (!have_module_cache)
+        have_module_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    if (kmod_ctx) {
+        /* modules installed/removed (depmod run) or a different kernel running */
+        if (uname (&buf) != 0 || g_strcmp0 (buf.release, kmod_release) != 0 ||
+            kmod_validate_resources (kmod_ctx) != KMOD_RESOURCES_OK)
+            drop_kmod_ctx ();
+        else
+            return kmod_ctx;
+    }
+
+    kmod_ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+    if (!kmod_ctx) {
+        g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
+                     "Failed to initialize kmod context");
+        return NULL;
+    }
+    set_kmod_logging (kmod_ctx);
+
+    /* load the indexes now, not on every lookup */
+    if (kmod_load_resources (kmod_ctx) < 0)
+        bd_utils_log (LOG_DEBUG, "Failed to load kmod resources, lookups will be slower");
+
+    if (uname (&buf) == 0)
+        kmod_release = g_strdup (buf.release);
+
+    return kmod_ctx;
+}
+
 /**
  * bd_utils_have_kernel_module:
  * @module_name: name of the kernel module to check
@@ -85,26 +140,31 @@ gboolean bd_utils_have_kernel_module (const gchar *module_name, GError **error)
     gint ret = 0;
     struct kmod_ctx *ctx = NULL;
     struct kmod_module *mod = NULL;
-    gchar *null_config = NULL;
     const gchar *path = NULL;
     gboolean have_path = FALSE;
     gboolean builtin = FALSE;
+    gpointer cached = NULL;
     locale_t c_locale = newlocale (LC_ALL_MASK, "C", (locale_t) 0);
 
-    ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+    g_mutex_lock (&kmod_lock);
+    ctx = get_kmod_ctx (error);
     if (!ctx) {
-        g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
-                     "Failed to initialize kmod context");
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
-    set_kmod_logging (ctx);
+
+    if (g_hash_table_lookup_extended (have_module_cache, module_name, NULL, &cached)) {
+        g_mutex_unlock (&kmod_lock);
+        freelocale (c_locale);
+        return GPOINTER_TO_INT (cached);
+    }
 
     ret = kmod_module_new_from_name (ctx, module_name, &mod);
     if (ret < 0) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_FAIL,
                      "Failed to get the module: %s", strerror_l (-ret, c_locale));
-        kmod_unref (ctx);
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
@@ -115,7 +175,9 @@ gboolean bd_utils_have_kernel_module (const gchar *module_name, GError **error)
       builtin = kmod_module_get_initstate (mod) == KMOD_MODULE_BUILTIN;
     }
     kmod_module_unref (mod);
-    kmod_unref (ctx);
+
+    g_hash_table_insert (have_module_cache, g_strdup (module_name), GINT_TO_POINTER (have_path || builtin));
+    g_mutex_unlock (&kmod_lock);
     freelocale (c_locale);
 
     return have_path || builtin;
@@ -133,23 +195,21 @@ gboolean bd_utils_load_kernel_module (const gchar *module_name, const gchar *opt
     gint ret = 0;
     struct kmod_ctx *ctx = NULL;
     struct kmod_module *mod = NULL;
-    gchar *null_config = NULL;
     locale_t c_locale = newlocale (LC_ALL_MASK, "C", (locale_t) 0);
 
-    ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+    g_mutex_lock (&kmod_lock);
+    ctx = get_kmod_ctx (error);
     if (!ctx) {
-        g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
-                     "Failed to initialize kmod context");
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
-    set_kmod_logging (ctx);
 
     ret = kmod_module_new_from_name (ctx, module_name, &mod);
     if (ret < 0) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_FAIL,
                      "Failed to get the module: %s", strerror_l (-ret, c_locale));
-        kmod_unref (ctx);
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
@@ -158,7 +218,7 @@ gboolean bd_utils_load_kernel_module (const gchar *module_name, const gchar *opt
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_NOEXIST,
                      "Module '%s' doesn't exist", module_name);
         kmod_module_unref (mod);
-        kmod_unref (ctx);
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
@@ -177,13 +237,13 @@ gboolean bd_utils_load_kernel_module (const gchar *module_name, const gchar *opt
                          "Failed to load the module '%s': %s",
                          module_name, strerror_l (-ret, c_locale));
         kmod_module_unref (mod);
-        kmod_unref (ctx);
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
 
     kmod_module_unref (mod);
-    kmod_unref (ctx);
+    g_mutex_unlock (&kmod_lock);
     freelocale (c_locale);
     return TRUE;
 }
@@ -201,24 +261,22 @@ gboolean bd_utils_unload_kernel_module (const gchar *module_name, GError **error
     struct kmod_module *mod = NULL;
     struct kmod_list *list = NULL;
     struct kmod_list *cur = NULL;
-    gchar *null_config = NULL;
     gboolean found = FALSE;
     locale_t c_locale = newlocale (LC_ALL_MASK, "C", (locale_t) 0);
 
-    ctx = kmod_new (NULL, (const gchar * const*) &null_config);
+    g_mutex_lock (&kmod_lock);
+    ctx = get_kmod_ctx (error);
     if (!ctx) {
-        g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_KMOD_INIT_FAIL,
-                     "Failed to initialize kmod context");
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
-    set_kmod_logging (ctx);
 
     ret = kmod_module_new_from_loaded (ctx, &list);
     if (ret < 0) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_FAIL,
                      "Failed to get the module: %s", strerror_l (-ret, c_locale));
-        kmod_unref (ctx);
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
@@ -235,7 +293,7 @@ gboolean bd_utils_unload_kernel_module (const gchar *module_name, GError **error
     if (!found) {
         g_set_error (error, BD_UTILS_MODULE_ERROR, BD_UTILS_MODULE_ERROR_NOEXIST,
                      "Module '%s' is not loaded", module_name);
-        kmod_unref (ctx);
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
@@ -247,13 +305,13 @@ gboolean bd_utils_unload_kernel_module (const gchar *module_name, GError **error
                      "Failed to unload the module '%s': %s",
                      module_name, strerror_l (-ret, c_locale));
         kmod_module_unref (mod);
-        kmod_unref (ctx);
+        g_mutex_unlock (&kmod_lock);
         freelocale (c_locale);
         return FALSE;
     }
 
     kmod_module_unref (mod);
-    kmod_unref (ctx);
+    g_mutex_unlock (&kmod_lock);
     freelocale (c_locale);
     return TRUE;
 }
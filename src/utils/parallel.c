@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "parallel.h"
+#include "exec.h"
+#include "logging.h"
+
+/**
+ * bd_utils_parallel_workers: (skip)
+ * @max_workers: maximum number of workers requested by the caller or 0 for the
+ *               default (number of CPUs)
+ * @n_items: number of items to process
+ *
+ * Returns: number of workers to use for processing @n_items items, there's
+ *          never more workers than items
+ */
+guint bd_utils_parallel_workers (guint max_workers, guint n_items) {
+    if (max_workers == 0)
+        max_workers = g_get_num_processors ();
+
+    return MIN (max_workers, n_items);
+}
+
+static void run_items (GFunc func, gpointer items, gsize item_size, gboolean pointers, guint n_items,
+                       guint max_workers, gpointer user_data) {
+    GThreadPool *pool = NULL;
+    GError *l_error = NULL;
+    gpointer item = NULL;
+
+    max_workers = bd_utils_parallel_workers (max_workers, n_items);
+    if (max_workers > 1) {
+        pool = g_thread_pool_new (func, user_data, max_workers, TRUE, &l_error);
+        if (!pool) {
+            /* can only happen if the threads cannot be spawned, the work
+               still can be done, just not in parallel */
+            bd_utils_log_format (BD_UTILS_LOG_WARNING, "Failed to create a pool of %u threads, running sequentially: %s",
+                                 max_workers, l_error ? l_error->message : "unknown error");
+            g_clear_error (&l_error);
+        }
+    }
+
+    for (guint i = 0; i < n_items; i++) {
+        if (pointers)
+            item = ((gpointer *) items)[i];
+        else
+            item = (guint8 *) items + i * item_size;
+
+        if (pool)
+            g_thread_pool_push (pool, item, NULL);
+        else
+            func (item, user_data);
+    }
+
+    if (pool)
+        /* wait for all the work to be done */
+        g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+/**
+ * bd_utils_parallel_run: (skip)
+ * @func: function to run for every item
+ * @items: (array length=n_items): items to run @func for
+ * @n_items: number of @items
+ * @max_workers: maximum number of items processed in parallel or 0 for the
+ *               default (number of CPUs)
+ * @user_data: data passed to @func as its second argument
+ *
+ * Runs @func for all the @items in a pool of (at most) @max_workers threads or
+ * directly in the calling thread if only one worker is needed (or no thread can
+ * be created). Returns once @func finished for all the @items.
+ */
+void bd_utils_parallel_run (GFunc func, gpointer *items, guint n_items, guint max_workers, gpointer user_data) {
+    run_items (func, items, sizeof (gpointer), TRUE, n_items, max_workers, user_data);
+}
+
+/**
+ * bd_utils_parallel_run_array: (skip)
+ * @func: function to run for every item
+ * @items: array of @n_items items of @item_size bytes
+ * @item_size: size of a single item
+ * @n_items: number of @items
+ * @max_workers: maximum number of items processed in parallel or 0 for the
+ *               default (number of CPUs)
+ * @user_data: data passed to @func as its second argument
+ *
+ * Same as bd_utils_parallel_run(), but for an array of structures, @func gets
+ * a pointer to the particular structure.
+ */
+void bd_utils_parallel_run_array (GFunc func, gpointer items, gsize item_size, guint n_items, guint max_workers,
+                                  gpointer user_data) {
+    run_items (func, items, item_size, FALSE, n_items, max_workers, user_data);
+}
+
+/**
+ * bd_utils_parallel_progress_start: (skip)
+ * @progress: progress to initialize
+ * @n_items: number of items the work is done for
+ * @msg: message for the started progress reporting task
+ */
+void bd_utils_parallel_progress_start (BDUtilsParallelProgress *progress, guint n_items, const gchar *msg) {
+    g_mutex_init (&(progress->lock));
+    progress->n_items = n_items;
+    progress->n_done = 0;
+    progress->n_failed = 0;
+    progress->progress_id = bd_utils_report_started (msg);
+}
+
+/**
+ * bd_utils_parallel_progress_item_done: (skip)
+ * @progress: progress of the work
+ * @item: name of the finished item
+ * @success: whether the work succeeded for @item
+ * @error: (nullable): error for @item (if any)
+ *
+ * Reports that the work is done for @item, can be called from any thread.
+ */
+void bd_utils_parallel_progress_item_done (BDUtilsParallelProgress *progress, const gchar *item, gboolean success,
+                                           const GError *error) {
+    gchar *msg = NULL;
+
+    msg = g_strdup_printf ("%s: %s", item, success ? "Completed" : error ? error->message : "Failed");
+    g_mutex_lock (&(progress->lock));
+    progress->n_done++;
+    if (!success)
+        progress->n_failed++;
+    bd_utils_report_progress (progress->progress_id, (progress->n_done * 100) / MAX (progress->n_items, 1), msg);
+    g_mutex_unlock (&(progress->lock));
+    g_free (msg);
+}
+
+/**
+ * bd_utils_parallel_progress_finish: (skip)
+ * @progress: progress of the work
+ * @msg: (nullable): message for the finished progress reporting task or %NULL
+ *       for the default ("Completed")
+ */
+void bd_utils_parallel_progress_finish (BDUtilsParallelProgress *progress, const gchar *msg) {
+    bd_utils_report_finished (progress->progress_id, msg ? msg : "Completed");
+    g_mutex_clear (&(progress->lock));
+}
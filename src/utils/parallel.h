@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_UTILS_PARALLEL
+#define BD_UTILS_PARALLEL
+
+/* Internal API for the plugins implementing the *_many() functions, the header
+   is not installed. */
+
+guint bd_utils_parallel_workers (guint max_workers, guint n_items);
+void bd_utils_parallel_run (GFunc func, gpointer *items, guint n_items, guint max_workers, gpointer user_data);
+void bd_utils_parallel_run_array (GFunc func, gpointer items, gsize item_size, guint n_items, guint max_workers,
+                                  gpointer user_data);
+
+/**
+ * BDUtilsParallelProgress: (skip)
+ * @lock: lock protecting the counters (may be used by the caller for its own data too)
+ * @progress_id: ID of the progress reporting task
+ * @n_items: number of items the work is done for
+ * @n_done: number of items already done
+ * @n_failed: number of items the work failed for
+ *
+ * Progress of a work done for multiple items in parallel reported as a single
+ * task with a progress update for every finished item.
+ */
+typedef struct BDUtilsParallelProgress {
+    GMutex lock;
+    guint64 progress_id;
+    guint n_items;
+    guint n_done;
+    guint n_failed;
+} BDUtilsParallelProgress;
+
+void bd_utils_parallel_progress_start (BDUtilsParallelProgress *progress, guint n_items, const gchar *msg);
+void bd_utils_parallel_progress_item_done (BDUtilsParallelProgress *progress, const gchar *item, gboolean success,
+                                           const GError *error);
+void bd_utils_parallel_progress_finish (BDUtilsParallelProgress *progress, const gchar *msg);
+
+#endif  /* BD_UTILS_PARALLEL */
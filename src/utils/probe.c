@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "probe.h"
+#include "dev_utils.h"
+
+#ifdef HAVE_BLKID
+typedef struct ProbeAttempt {
+    blkid_probe probe;
+    gint fd;
+    BDUtilsProbeStep step;
+    gint status;
+} ProbeAttempt;
+
+static gboolean probe_attempt (gpointer user_data) {
+    ProbeAttempt *attempt = (ProbeAttempt *) user_data;
+
+    if (attempt->step == BD_UTILS_PROBE_SET_DEVICE) {
+        attempt->status = blkid_probe_set_device (attempt->probe, attempt->fd, 0, 0);
+        return attempt->status == 0;
+    }
+
+    attempt->status = blkid_do_safeprobe (attempt->probe);
+    /* 1 = nothing detected which is a valid result too */
+    return attempt->status == 0 || attempt->status == 1;
+}
+
+/**
+ * bd_utils_probe_with_retry: (skip)
+ * @device: device @probe is for
+ * @probe: probe to run @step with
+ * @fd: file descriptor of opened @device (only used for %BD_UTILS_PROBE_SET_DEVICE)
+ * @step: which probing step to run
+ * @timeout_ms: how long (in milliseconds) to keep retrying
+ *
+ * Runs @step until it succeeds or @timeout_ms passes in case the device is busy
+ * at the very moment, see bd_utils_dev_retry().
+ *
+ * Returns: status of the last attempt as returned by libblkid (0 for success,
+ *          1 for nothing detected by %BD_UTILS_PROBE_SAFEPROBE, negative number
+ *          for an error)
+ */
+gint bd_utils_probe_with_retry (const gchar *device, blkid_probe probe, gint fd, BDUtilsProbeStep step, guint timeout_ms) {
+    ProbeAttempt attempt = {probe, fd, step, -1};
+
+    bd_utils_dev_retry (device, timeout_ms, probe_attempt, &attempt);
+
+    return attempt.status;
+}
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#ifndef BD_UTILS_PROBE
+#define BD_UTILS_PROBE
+
+/* Internal API for the plugins probing devices with libblkid, the header is
+   not installed. */
+
+#ifdef HAVE_BLKID
+#include <blkid.h>
+
+/**
+ * BDUtilsProbeStep: (skip)
+ * @BD_UTILS_PROBE_SET_DEVICE: assign the device to the probe (blkid_probe_set_device())
+ * @BD_UTILS_PROBE_SAFEPROBE: run the probe (blkid_do_safeprobe())
+ */
+typedef enum {
+    BD_UTILS_PROBE_SET_DEVICE,
+    BD_UTILS_PROBE_SAFEPROBE
+} BDUtilsProbeStep;
+
+gint bd_utils_probe_with_retry (const gchar *device, blkid_probe probe, gint fd, BDUtilsProbeStep step, guint timeout_ms);
+#endif
+
+#endif  /* BD_UTILS_PROBE */
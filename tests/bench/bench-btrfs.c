@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the parsers are static functions so the plugin source is included directly */
+#include "../../src/plugins/btrfs.c"
+
+#include "bench.h"
+
+typedef struct ParseFixture {
+    gchar *output;
+    GRegex *regex;
+} ParseFixture;
+
+static void fixture_init (ParseFixture *fixture, const gchar *name, const gchar *pattern) {
+    fixture->output = bench_read_fixture (name);
+    fixture->regex = g_regex_new (pattern, G_REGEX_EXTENDED, 0, NULL);
+    g_assert (fixture->regex);
+}
+
+static void fixture_clear (ParseFixture *fixture) {
+    g_free (fixture->output);
+    g_regex_unref (fixture->regex);
+}
+
+static gboolean count_subvolume (BDBtrfsSubvolumeInfo *info G_GNUC_UNUSED, gpointer user_data) {
+    (*((guint *) user_data))++;
+    return TRUE;
+}
+
+static void bench_subvol_list (gpointer data) {
+    ParseFixture *fixture = (ParseFixture *) data;
+    guint n_subvols = 0;
+    SubvolListContext ctx = {fixture->regex, count_subvolume, &n_subvols, FALSE, FALSE, TRUE};
+    gchar **lines = NULL;
+
+    lines = g_strsplit (fixture->output, "\n", 0);
+    for (gchar **line_p = lines; *line_p; line_p++)
+        process_subvol_list_line (*line_p, FALSE, &ctx);
+    g_strfreev (lines);
+}
+
+static void bench_device_list (gpointer data) {
+    ParseFixture *fixture = (ParseFixture *) data;
+    GMatchInfo *match_info = NULL;
+    gchar **lines = NULL;
+
+    lines = g_strsplit (fixture->output, "\n", 0);
+    for (gchar **line_p = lines; *line_p; line_p++) {
+        if (g_regex_match (fixture->regex, *line_p, 0, &match_info))
+            bd_btrfs_device_info_free (get_device_info_from_match (match_info));
+        g_match_info_free (match_info);
+    }
+    g_strfreev (lines);
+}
+
+static void bench_filesystem_info (gpointer data) {
+    ParseFixture *fixture = (ParseFixture *) data;
+    GMatchInfo *match_info = NULL;
+
+    if (g_regex_match (fixture->regex, fixture->output, 0, &match_info))
+        bd_btrfs_filesystem_info_free (get_filesystem_info_from_match (match_info));
+    g_match_info_free (match_info);
+}
+
+int main (int argc, char *argv[]) {
+    ParseFixture subvols;
+    ParseFixture devices;
+    ParseFixture fs_info;
+
+    bench_init (&argc, &argv);
+
+    fixture_init (&subvols, "btrfs_subvol_list.txt", SUBVOL_LIST_PATTERN);
+    fixture_init (&devices, "btrfs_filesystem_show.txt", DEVICE_LIST_PATTERN);
+    fixture_init (&fs_info, "btrfs_filesystem_show.txt", FILESYSTEM_INFO_PATTERN);
+
+    bench_run ("btrfs/subvol_list (128 subvolumes)", bench_subvol_list, &subvols);
+    bench_run ("btrfs/device_list (8 devices)", bench_device_list, &devices);
+    bench_run ("btrfs/filesystem_info", bench_filesystem_info, &fs_info);
+
+    fixture_clear (&subvols);
+    fixture_clear (&devices);
+    fixture_clear (&fs_info);
+
+    return 0;
+}
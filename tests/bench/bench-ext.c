@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the parser is a static function so the plugin source is included directly */
+#include "../../src/plugins/fs/ext.c"
+
+#include "bench.h"
+
+static void bench_filter_line_fsck (gpointer data) {
+    gchar **lines = (gchar **) data;
+
+    for (gchar **line_p = lines; *line_p; line_p++)
+        filter_line_fsck (*line_p, 5);
+}
+
+int main (int argc, char *argv[]) {
+    gchar *output = NULL;
+    gchar **lines = NULL;
+
+    bench_init (&argc, &argv);
+
+    output = bench_read_fixture ("e2fsck_progress.txt");
+    lines = g_strsplit (output, "\n", 0);
+    g_free (output);
+
+    bench_run ("ext/filter_line_fsck (209 lines)", bench_filter_line_fsck, lines);
+
+    g_strfreev (lines);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the parsers are static functions so the plugin source is included directly */
+#include "../../src/plugins/lvm.c"
+
+#include "bench.h"
+
+typedef struct ReportFixture {
+    gchar *report;
+    gsize len;
+    /* the parsers work in place, a fresh copy of the report is made here */
+    gchar *buf;
+} ReportFixture;
+
+static void fixture_init (ReportFixture *fixture, const gchar *name) {
+    fixture->report = bench_read_fixture (name);
+    fixture->len = strlen (fixture->report);
+    fixture->buf = g_malloc (fixture->len + 1);
+}
+
+static void fixture_clear (ReportFixture *fixture) {
+    g_free (fixture->report);
+    g_free (fixture->buf);
+}
+
+static gchar* fixture_reset (ReportFixture *fixture) {
+    memcpy (fixture->buf, fixture->report, fixture->len + 1);
+    return fixture->buf;
+}
+
+static void bench_parse_lvm_vars (gpointer data) {
+    ReportFixture *fixture = (ReportFixture *) data;
+    gchar *pos = fixture_reset (fixture);
+    gchar *line = NULL;
+    ReportRow row;
+
+    while ((line = next_line (&pos)))
+        parse_lvm_vars (line, &row);
+}
+
+static void bench_lvs_report (gpointer data) {
+    ReportFixture *fixture = (ReportFixture *) data;
+    gchar *pos = fixture_reset (fixture);
+    gchar *line = NULL;
+    ReportRow row;
+
+    while ((line = next_line (&pos)))
+        if (parse_lvm_vars (line, &row) == 16)
+            bd_lvm_lvdata_free (get_lv_data_from_row (&row));
+}
+
+static void bench_pvs_report (gpointer data) {
+    ReportFixture *fixture = (ReportFixture *) data;
+    gchar *pos = fixture_reset (fixture);
+    gchar *line = NULL;
+    ReportRow row;
+
+    while ((line = next_line (&pos)))
+        if (parse_lvm_vars (line, &row) == 15)
+            bd_lvm_pvdata_free (get_pv_data_from_row (&row));
+}
+
+int main (int argc, char *argv[]) {
+    ReportFixture lvs;
+    ReportFixture pvs;
+
+    bench_init (&argc, &argv);
+
+    fixture_init (&lvs, "lvs_report.txt");
+    fixture_init (&pvs, "pvs_report.txt");
+
+    bench_run ("lvm/parse_lvm_vars (64 LVs)", bench_parse_lvm_vars, &lvs);
+    bench_run ("lvm/lvs_report (64 LVs)", bench_lvs_report, &lvs);
+    bench_run ("lvm/pvs_report (16 PVs)", bench_pvs_report, &pvs);
+
+    fixture_clear (&lvs);
+    fixture_clear (&pvs);
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the parsers are static functions so the plugin source is included directly */
+#include "../../src/plugins/mdraid.c"
+
+#include "bench.h"
+
+static void bench_parse_mdadm_vars (gpointer data) {
+    guint num_items = 0;
+
+    g_hash_table_destroy (parse_mdadm_vars ((const gchar *) data, "\n", ":", &num_items));
+}
+
+static void bench_examine_data (gpointer data) {
+    guint num_items = 0;
+    GHashTable *table = parse_mdadm_vars ((const gchar *) data, "\n", ":", &num_items);
+
+    bd_md_examine_data_free (get_examine_data_from_table (table, TRUE));
+}
+
+static void bench_detail_data (gpointer data) {
+    guint num_items = 0;
+    GHashTable *table = parse_mdadm_vars ((const gchar *) data, "\n", ":", &num_items);
+
+    bd_md_detail_data_free (get_detail_data_from_table (table, TRUE));
+}
+
+static void bench_canonicalize_uuid (gpointer data) {
+    g_free (bd_md_canonicalize_uuid ((const gchar *) data, NULL));
+}
+
+int main (int argc, char *argv[]) {
+    gchar *examine = NULL;
+    gchar *detail = NULL;
+
+    bench_init (&argc, &argv);
+
+    examine = bench_read_fixture ("mdadm_examine.txt");
+    detail = bench_read_fixture ("mdadm_detail.txt");
+
+    bench_run ("mdraid/parse_mdadm_vars (examine)", bench_parse_mdadm_vars, examine);
+    bench_run ("mdraid/parse_mdadm_vars (detail)", bench_parse_mdadm_vars, detail);
+    bench_run ("mdraid/examine_data", bench_examine_data, examine);
+    bench_run ("mdraid/detail_data", bench_detail_data, detail);
+    bench_run ("mdraid/bd_md_canonicalize_uuid", bench_canonicalize_uuid, "2a8bd3e5:4b0f4b08:6c9b8f7e:1d2e3f40");
+
+    g_free (examine);
+    g_free (detail);
+
+    return 0;
+}
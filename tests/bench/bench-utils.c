@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <blockdev/utils.h>
+
+#include "bench.h"
+
+static const gchar *const versions[][2] = {
+    {"2.03.11", "2.02.105"},
+    {"1.47.0", "1.47.0"},
+    {"6.6.3-1", "6.6.3-2"},
+    {"4.4", "4.4.1"},
+    {"0.1", "10.0.2.1"},
+};
+
+static void bench_version_cmp (gpointer data G_GNUC_UNUSED) {
+    for (guint i = 0; i < G_N_ELEMENTS (versions); i++)
+        bd_utils_version_cmp (versions[i][0], versions[i][1], NULL);
+}
+
+int main (int argc, char *argv[]) {
+    bench_init (&argc, &argv);
+
+    bench_run ("utils/bd_utils_version_cmp (5 pairs)", bench_version_cmp, NULL);
+
+    return 0;
+}
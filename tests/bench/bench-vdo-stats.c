@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the helpers are static functions so the source is included directly */
+#include "../../src/plugins/vdo_stats.c"
+
+#include "bench.h"
+
+static void bench_add_computed_stats (gpointer data) {
+    /* only replaces the computed items so the table can be reused */
+    add_computed_stats ((GHashTable *) data);
+}
+
+int main (int argc, char *argv[]) {
+    gchar *output = NULL;
+    gchar **lines = NULL;
+    gchar **fields = NULL;
+    GHashTable *stats = NULL;
+
+    bench_init (&argc, &argv);
+
+    /* 'name value' pairs as read from the files in the statistics directory */
+    output = bench_read_fixture ("vdo_stats.txt");
+    lines = g_strsplit (output, "\n", 0);
+    g_free (output);
+
+    stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    for (gchar **line_p = lines; *line_p; line_p++) {
+        fields = g_strsplit (*line_p, " ", 2);
+        if (g_strv_length (fields) == 2)
+            g_hash_table_replace (stats, g_strdup (fields[0]), g_strdup (fields[1]));
+        g_strfreev (fields);
+    }
+    g_strfreev (lines);
+
+    bench_run ("vdo_stats/add_computed_stats", bench_add_computed_stats, stats);
+
+    g_hash_table_destroy (stats);
+
+    return 0;
+}
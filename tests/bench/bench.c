@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <blockdev/utils.h>
+
+#include "bench.h"
+
+/* default minimum time (in milliseconds) to spend in every benchmark */
+#define DEFAULT_MIN_TIME 500
+
+static guint64 min_time_ns = DEFAULT_MIN_TIME * G_GUINT64_CONSTANT (1000000);
+static gchar **filters = NULL;
+
+/* The allocations are counted by overriding the allocator entry points in the
+   benchmark executable and passing the calls to the glibc implementation. That
+   way also the allocations done by GLib (which uses the system allocator) are
+   counted without any changes in the code being measured. */
+extern void* __libc_malloc (size_t size);
+extern void* __libc_calloc (size_t nmemb, size_t size);
+extern void* __libc_realloc (void *ptr, size_t size);
+
+static guint64 n_allocs = 0;
+
+void* malloc (size_t size) {
+    __atomic_add_fetch (&n_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc (size);
+}
+
+void* calloc (size_t nmemb, size_t size) {
+    __atomic_add_fetch (&n_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc (nmemb, size);
+}
+
+void* realloc (void *ptr, size_t size) {
+    __atomic_add_fetch (&n_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc (ptr, size);
+}
+
+static guint64 now_ns (void) {
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (guint64) ts.tv_sec * G_GUINT64_CONSTANT (1000000000) + (guint64) ts.tv_nsec;
+}
+
+static void print_usage (const char *name) {
+    fprintf (stderr, "Usage: %s [-t|--time MSEC] [FILTER...]\n", name);
+    fprintf (stderr, "Runs the benchmarks with names containing one of the FILTERs (all by default)\n");
+    fprintf (stderr, "for at least MSEC milliseconds each (%d by default) and reports the time and\n", DEFAULT_MIN_TIME);
+    fprintf (stderr, "number of allocations per operation.\n");
+}
+
+/**
+ * bench_init:
+ * @argc: number of the arguments of the benchmark program
+ * @argv: arguments of the benchmark program
+ *
+ * Parses the arguments (exits the program if they are not valid) and prepares
+ * the environment for the benchmarks. Has to be called before any other GLib
+ * function is used.
+ */
+void bench_init (int *argc, char ***argv) {
+    int first_filter = 1;
+    guint64 min_time = 0;
+
+    /* make sure the slice allocator doesn't hide allocations from us */
+    g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+    if (*argc > 1 && ((g_strcmp0 ((*argv)[1], "-h") == 0) || g_strcmp0 ((*argv)[1], "--help") == 0)) {
+        print_usage ((*argv)[0]);
+        exit (0);
+    }
+
+    if (*argc > 1 && ((g_strcmp0 ((*argv)[1], "-t") == 0) || g_strcmp0 ((*argv)[1], "--time") == 0)) {
+        if (*argc < 3 || (min_time = g_ascii_strtoull ((*argv)[2], NULL, 10)) == 0) {
+            fprintf (stderr, "Invalid time specified!\n");
+            print_usage ((*argv)[0]);
+            exit (1);
+        }
+        min_time_ns = min_time * G_GUINT64_CONSTANT (1000000);
+        first_filter = 3;
+    }
+
+    if (first_filter < *argc)
+        filters = &((*argv)[first_filter]);
+
+    /* the parsers log about unexpected input, we don't want the messages to
+       affect the results */
+    bd_utils_init_logging (NULL, NULL);
+
+    printf ("%-48s %12s %14s %14s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+}
+
+/**
+ * bench_read_fixture:
+ * @name: name of the fixture file
+ *
+ * Returns: (transfer full): contents of the fixture file @name (recorded
+ *                           output of some tool), exits the program if the
+ *                           file cannot be read
+ */
+gchar* bench_read_fixture (const gchar *name) {
+    gchar *path = g_build_filename (BENCH_FIXTURES_DIR, name, NULL);
+    gchar *contents = NULL;
+    GError *error = NULL;
+
+    if (!g_file_get_contents (path, &contents, NULL, &error)) {
+        fprintf (stderr, "Failed to read fixture '%s': %s\n", path, error->message);
+        exit (1);
+    }
+    g_free (path);
+
+    return contents;
+}
+
+static gboolean should_run (const gchar *name) {
+    if (!filters)
+        return TRUE;
+
+    for (gchar **filter_p = filters; *filter_p; filter_p++)
+        if (strstr (name, *filter_p))
+            return TRUE;
+
+    return FALSE;
+}
+
+/**
+ * bench_run:
+ * @name: name of the benchmark
+ * @func: function doing one operation
+ * @data: data for @func
+ *
+ * Runs @func repeatedly for at least the configured minimum time and prints
+ * the average time and number of allocations per one call of @func.
+ */
+void bench_run (const gchar *name, BenchFunc func, gpointer data) {
+    guint64 iters = 1;
+    guint64 start = 0;
+    guint64 elapsed = 0;
+    guint64 allocs = 0;
+
+    if (!should_run (name))
+        return;
+
+    /* warm up (static regexes, caches,...) */
+    func (data);
+
+    /* double the number of iterations until a batch takes long enough */
+    while (TRUE) {
+        allocs = __atomic_load_n (&n_allocs, __ATOMIC_RELAXED);
+        start = now_ns ();
+        for (guint64 i = 0; i < iters; i++)
+            func (data);
+        elapsed = now_ns () - start;
+        allocs = __atomic_load_n (&n_allocs, __ATOMIC_RELAXED) - allocs;
+
+        if (elapsed >= min_time_ns || iters >= G_MAXUINT64 / 2)
+            break;
+        iters *= 2;
+    }
+
+    printf ("%-48s %12"G_GUINT64_FORMAT" %14.1f %14.2f\n", name, iters,
+            (gdouble) elapsed / iters, (gdouble) allocs / iters);
+    fflush (stdout);
+}
@@ -0,0 +1,392 @@
+#!/usr/bin/python3
+
+"""
+Scale benchmarks measuring how the query functions of the plugins scale with
+the size of the storage topology.
+
+Synthetic topologies of increasing sizes are created and the time of the calls
+is measured for every size. The results are printed in the JSON format (see
+--output and --compare) so that they can be stored and compared between
+versions to see trends.
+
+Two modes are supported:
+
+* fake (default) -- no devices are created, the CLI tools are replaced by fake
+  ones (see tests/fake_utils/lvm_scale) reporting the topology, only the
+  functions using the CLI tools can be measured this way, root privileges are
+  not needed,
+
+* real (--real) -- real devices (loop devices, LVs, MD RAID, DM maps) are
+  created, requires root privileges and takes a lot of time for the biggest
+  topologies.
+"""
+
+from __future__ import print_function
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import time
+from contextlib import contextmanager
+
+testdir = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+projdir = os.path.abspath(os.path.join(testdir, '..'))
+
+LIBDIRS = ['src/utils/.libs', 'src/plugins/.libs', 'src/plugins/fs/.libs', 'src/lib/.libs', 'src/plugins/nvme/.libs']
+GIDIR = 'src/lib'
+
+# default sizes of the topologies to measure for every scenario
+DEFAULT_SIZES = {"lvm": [10, 100, 1000],
+                 "lvm-snapshots": [100, 1000, 10000],
+                 "loop": [16, 64, 256],
+                 "md": [4, 25, 100],
+                 "dm": [50, 500]}
+FAKE_SCENARIOS = {"lvm", "lvm-snapshots"}
+
+VG_NAME = "scalevg"
+
+
+def parse_args():
+    argparser = argparse.ArgumentParser(description='libblockdev scale benchmarks')
+    argparser.add_argument('scenarios', nargs='*', metavar='SCENARIO',
+                           help='scenarios to run (%s), all available by default' % ", ".join(sorted(DEFAULT_SIZES.keys())))
+    argparser.add_argument('--real', dest='real', action='store_true',
+                           help='create real devices instead of using fake tools (requires root)')
+    argparser.add_argument('--sizes', dest='sizes', action='append', default=[], metavar='SCENARIO=N[,N...]',
+                           help='sizes of the topologies for a scenario (can be used repeatedly)')
+    argparser.add_argument('--repeat', dest='repeat', type=int, default=5,
+                           help='number of measured calls of every function for every size (default: 5)')
+    argparser.add_argument('--backends', dest='backends', default='lvm,lvm-dbus',
+                           help='LVM plugin backends to measure (default: lvm,lvm-dbus, only lvm in the fake mode)')
+    argparser.add_argument('-o', '--output', dest='output',
+                           help='file to write the JSON results to (stdout by default)')
+    argparser.add_argument('-c', '--compare', dest='compare',
+                           help='JSON results of a previous run to compare the results with')
+    argparser.add_argument('-i', '--installed', dest='installed', action='store_true',
+                           help='measure the installed version of libblockdev')
+    args = argparser.parse_args()
+
+    sizes = dict(DEFAULT_SIZES)
+    for spec in args.sizes:
+        scenario, _sep, values = spec.partition("=")
+        if scenario not in DEFAULT_SIZES or not values:
+            argparser.error("Invalid sizes specification: '%s'" % spec)
+        sizes[scenario] = sorted(int(v) for v in values.split(","))
+    args.sizes = sizes
+
+    for scenario in args.scenarios:
+        if scenario not in DEFAULT_SIZES:
+            argparser.error("Unknown scenario: '%s'" % scenario)
+    if not args.scenarios:
+        args.scenarios = sorted(DEFAULT_SIZES.keys() if args.real else FAKE_SCENARIOS)
+    elif not args.real:
+        for scenario in args.scenarios:
+            if scenario not in FAKE_SCENARIOS:
+                argparser.error("Scenario '%s' needs real devices (--real)" % scenario)
+
+    args.backends = args.backends.split(",")
+    if not args.real:
+        args.backends = [b for b in args.backends if b == "lvm"]
+
+    return args
+
+
+def setup_environment(args):
+    """ Make sure the freshly built library is used (if not measuring the installed one) """
+
+    if args.installed:
+        os.environ['LIBBLOCKDEV_TESTS_SKIP_OVERRIDE'] = ''
+        return
+
+    if 'LD_LIBRARY_PATH' not in os.environ and 'GI_TYPELIB_PATH' not in os.environ:
+        os.environ['LD_LIBRARY_PATH'] = ":".join(os.path.join(projdir, d) for d in LIBDIRS)
+        os.environ['GI_TYPELIB_PATH'] = os.path.join(projdir, GIDIR)
+        os.environ['LIBBLOCKDEV_CONFIG_DIR'] = os.path.join(testdir, 'test_configs/default_config')
+        try:
+            os.execv(sys.executable, [sys.executable] + sys.argv)
+        except OSError as e:
+            print('Failed re-exec with a new LD_LIBRARY_PATH and GI_TYPELIB_PATH: %s' % str(e))
+            sys.exit(1)
+
+    sys.path.append(testdir)
+    sys.path.append(os.path.join(projdir, 'src/python'))
+
+    import gi.overrides
+    gi.overrides.__path__.insert(0, os.path.join(projdir, 'src/python/gi/overrides'))
+
+
+def measure(func, repeat):
+    """ Call @func (once to warm up and @repeat times measured), returns the times of the calls """
+
+    func()
+
+    times = []
+    for _i in range(repeat):
+        start = time.perf_counter()
+        func()
+        times.append(time.perf_counter() - start)
+
+    return times
+
+
+def run_cmd(cmd, cmd_input=None):
+    ret = subprocess.run(cmd, input=cmd_input, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                         universal_newlines=True)
+    if ret.returncode != 0:
+        raise RuntimeError("Failed to run '%s': %s" % (" ".join(cmd), ret.stderr.strip()))
+    return ret.stdout
+
+
+def lvm_batch(commands):
+    """ Run LVM @commands in one 'lvm' shell process (to avoid the startup cost of every command) """
+
+    if commands:
+        run_cmd(["lvm"], cmd_input="\n".join(commands) + "\nexit\n")
+
+
+class Benchmark(object):
+    def __init__(self, args, BlockDev, utils):
+        self.args = args
+        self.BlockDev = BlockDev
+        self.utils = utils
+        self.results = []
+
+    def record(self, bench_name, backend, size, times):
+        res = {"benchmark": bench_name, "backend": backend, "size": size,
+               "calls": len(times), "min": min(times), "median": statistics.median(times),
+               "mean": statistics.mean(times)}
+        self.results.append(res)
+        print("%-40s %-10s %8d %12.6f s" % (bench_name, backend, size, res["median"]), file=sys.stderr)
+
+    def init_plugins(self, lvm_backend=None):
+        BlockDev = self.BlockDev
+        plugins = [BlockDev.PluginSpec(name=p) for p in (BlockDev.Plugin.LOOP, BlockDev.Plugin.DM,
+                                                         BlockDev.Plugin.MDRAID, BlockDev.Plugin.MPATH)]
+        if lvm_backend:
+            plugins.append(BlockDev.PluginSpec(name=BlockDev.Plugin.LVM, so_name="libbd_%s.so.3" % lvm_backend))
+
+        if not BlockDev.is_initialized():
+            BlockDev.try_init(plugins, None)
+        else:
+            BlockDev.try_reinit(plugins, True, None)
+
+    def measure_lvm(self, scenario, backend, size):
+        BlockDev = self.BlockDev
+
+        self.record("%s/lvs" % scenario, backend, size,
+                    measure(lambda: BlockDev.lvm_lvs(VG_NAME), self.args.repeat))
+        self.record("%s/lvs_tree" % scenario, backend, size,
+                    measure(lambda: BlockDev.lvm_lvs_tree(VG_NAME), self.args.repeat))
+        self.record("%s/lvinfo" % scenario, backend, size,
+                    measure(lambda: BlockDev.lvm_lvinfo(VG_NAME, "lv00000"), self.args.repeat))
+
+    @contextmanager
+    def lvm_vg(self):
+        """ Creates a VG with a thin pool on a loop device """
+
+        BlockDev = self.BlockDev
+        self.init_plugins("lvm")
+
+        dev_file = self.utils.create_sparse_tempfile("scale_lvm", 4 * 1024**4)
+        loop_dev = run_cmd(["losetup", "-f", "--show", dev_file]).strip()
+        try:
+            devices_avail = BlockDev.lvm_is_tech_avail(BlockDev.LVMTech.DEVICES, 0)
+        except Exception:  # pylint: disable=broad-except
+            devices_avail = False
+        try:
+            if devices_avail:
+                BlockDev.lvm_devices_add(loop_dev, None)
+            BlockDev.lvm_pvcreate(loop_dev, 0, 0, None)
+            BlockDev.lvm_vgcreate(VG_NAME, [loop_dev], 0, None)
+            BlockDev.lvm_thpoolcreate(VG_NAME, "pool", 1024**4, 16 * 1024**3, 0, None, None)
+            yield
+        finally:
+            try:
+                BlockDev.lvm_vgremove(VG_NAME, None)
+            except Exception:  # pylint: disable=broad-except
+                run_cmd(["vgremove", "-f", "-y", VG_NAME])
+            BlockDev.lvm_pvremove(loop_dev, None)
+            if devices_avail:
+                BlockDev.lvm_devices_delete(loop_dev, None)
+            run_cmd(["losetup", "-d", loop_dev])
+            os.unlink(dev_file)
+
+    def run_lvm(self, scenario):
+        sizes = self.args.sizes[scenario]
+
+        if not self.args.real:
+            with self.utils.fake_utils(os.path.join(testdir, "fake_utils/lvm_scale")):
+                self.init_plugins("lvm")
+                for size in sizes:
+                    if scenario == "lvm":
+                        os.environ["BD_SCALE_LVS"] = str(size)
+                        os.environ["BD_SCALE_SNAPSHOTS"] = "0"
+                    else:
+                        os.environ["BD_SCALE_LVS"] = "1"
+                        os.environ["BD_SCALE_SNAPSHOTS"] = str(size)
+                    self.measure_lvm(scenario, "lvm", size)
+            return
+
+        with self.lvm_vg():
+            # the topologies grow with the sizes, only the new LVs are created
+            n_lvs = 0
+            n_snaps = 0
+            for size in sizes:
+                if scenario == "lvm":
+                    lvm_batch(["lvcreate -y -T %s/pool -V 10G -n lv%05d" % (VG_NAME, i) for i in range(n_lvs, size)])
+                    n_lvs = size
+                else:
+                    if n_lvs == 0:
+                        lvm_batch(["lvcreate -y -T %s/pool -V 10G -n lv00000" % VG_NAME])
+                        n_lvs = 1
+                    lvm_batch(["lvcreate -y -s %s/lv00000 -n snap%05d" % (VG_NAME, i) for i in range(n_snaps, size)])
+                    n_snaps = size
+
+                for backend in self.args.backends:
+                    self.init_plugins(backend)
+                    self.measure_lvm(scenario, backend, size)
+
+    def run_loop(self):
+        BlockDev = self.BlockDev
+        self.init_plugins()
+
+        files = []
+        loops = []
+        try:
+            for size in self.args.sizes["loop"]:
+                for i in range(len(files), size):
+                    files.append(self.utils.create_sparse_tempfile("scale_loop%03d" % i, 1024**2))
+                    loops.append(run_cmd(["losetup", "-f", "--show", files[-1]]).strip())
+
+                self.record("loop/get_loop_name", "loop", size,
+                            measure(lambda: BlockDev.loop_get_loop_name(files[-1]), self.args.repeat))
+                self.record("loop/get_loop_names", "loop", size,
+                            measure(lambda: BlockDev.loop_get_loop_names(files), self.args.repeat))
+                self.record("loop/info", "loop", size,
+                            measure(lambda: BlockDev.loop_info(os.path.basename(loops[-1])), self.args.repeat))
+        finally:
+            for loop in loops:
+                run_cmd(["losetup", "-d", loop])
+            for f in files:
+                os.unlink(f)
+
+    def run_md(self):
+        BlockDev = self.BlockDev
+        self.init_plugins()
+
+        for size in self.args.sizes["md"]:
+            files = []
+            loops = []
+            try:
+                for i in range(size):
+                    files.append(self.utils.create_sparse_tempfile("scale_md%03d" % i, 64 * 1024**2))
+                    loops.append(run_cmd(["losetup", "-f", "--show", files[-1]]).strip())
+                run_cmd(["mdadm", "--create", "/dev/md/bd_scale", "--run", "--assume-clean", "--level=raid1",
+                         "--metadata=1.2", "--raid-devices=%d" % size] + loops)
+
+                self.record("md/detail", "mdraid", size,
+                            measure(lambda: BlockDev.md_detail("bd_scale"), self.args.repeat))
+                self.record("md/examine", "mdraid", size,
+                            measure(lambda: BlockDev.md_examine(loops[-1]), self.args.repeat))
+                self.record("md/node_from_name", "mdraid", size,
+                            measure(lambda: BlockDev.md_node_from_name("bd_scale"), self.args.repeat))
+            finally:
+                subprocess.call(["mdadm", "--stop", "/dev/md/bd_scale"],
+                                stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+                for loop in loops:
+                    subprocess.call(["mdadm", "--zero-superblock", loop],
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+                    run_cmd(["losetup", "-d", loop])
+                for f in files:
+                    os.unlink(f)
+
+    def run_dm(self):
+        BlockDev = self.BlockDev
+        self.init_plugins()
+
+        maps = []
+        try:
+            for size in self.args.sizes["dm"]:
+                for i in range(len(maps), size):
+                    maps.append("bd_scale%05d" % i)
+                    run_cmd(["dmsetup", "create", maps[-1], "--table", "0 8 zero"])
+
+                self.record("dm/map_exists", "dm", size,
+                            measure(lambda: BlockDev.dm_map_exists(maps[-1], True, True), self.args.repeat))
+                self.record("dm/node_from_name", "dm", size,
+                            measure(lambda: BlockDev.dm_node_from_name(maps[-1]), self.args.repeat))
+                self.record("dm/get_mpath_members", "mpath", size,
+                            measure(BlockDev.mpath_get_mpath_members, self.args.repeat))
+        finally:
+            for dm_map in maps:
+                run_cmd(["dmsetup", "remove", dm_map])
+
+    def run(self, scenario):
+        if scenario in ("lvm", "lvm-snapshots"):
+            self.run_lvm(scenario)
+        elif scenario == "loop":
+            self.run_loop()
+        elif scenario == "md":
+            self.run_md()
+        elif scenario == "dm":
+            self.run_dm()
+
+
+def compare_results(results, old_file):
+    """ Print changes of the median times compared with the results in @old_file """
+
+    with open(old_file) as f:
+        old = json.load(f)
+    old_results = {(r["benchmark"], r["backend"], r["size"]): r for r in old["results"]}
+
+    print("\n%-40s %-10s %8s %12s %12s %8s" % ("benchmark", "backend", "size", "old", "new", "change"), file=sys.stderr)
+    for res in results:
+        key = (res["benchmark"], res["backend"], res["size"])
+        if key not in old_results:
+            continue
+        old_median = old_results[key]["median"]
+        change = (res["median"] - old_median) / old_median * 100 if old_median else 0.0
+        print("%-40s %-10s %8d %12.6f %12.6f %+7.1f%%" % (key + (old_median, res["median"], change)), file=sys.stderr)
+
+
+def main():
+    args = parse_args()
+    setup_environment(args)
+
+    if args.real and os.geteuid() != 0:
+        print("Root privileges are required with --real", file=sys.stderr)
+        return 1
+
+    import overrides_hack  # pylint: disable=unused-import,unused-variable
+    import utils
+    import gi
+    gi.require_version('BlockDev', '3.0')
+    from gi.repository import BlockDev
+
+    bench = Benchmark(args, BlockDev, utils)
+    for scenario in args.scenarios:
+        bench.run(scenario)
+
+    results = {"date": datetime.datetime.now().isoformat(), "host": platform.node(),
+               "kernel": platform.release(), "mode": "real" if args.real else "fake",
+               "results": bench.results}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2)
+    else:
+        json.dump(results, sys.stdout, indent=2)
+        print()
+
+    if args.compare:
+        compare_results(bench.results, args.compare)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -331,6 +331,30 @@ class BtrfsTestListDevices(BtrfsMultiTestCase):
         self.assertGreaterEqual(devs[0].used, 0)
         self.assertGreaterEqual(devs[1].used, 0)
 
+    def test_list_devices_mounted(self):
+        """Verify that info about devices of a mounted volume matches the 'btrfs' output"""
+
+        succ = BlockDev.btrfs_create_volume([self.loop_dev, self.loop_dev2], "myShinyBtrfs", None, None, None)
+        self.assertTrue(succ)
+
+        cli_devs = BlockDev.btrfs_list_devices(self.loop_dev)
+
+        mount(self.loop_dev, TEST_MNT)
+
+        # queried using ioctls
+        devs = BlockDev.btrfs_list_devices(TEST_MNT)
+        self.assertEqual(len(devs), len(cli_devs))
+        for dev, cli_dev in zip(devs, cli_devs):
+            self.assertEqual(dev.id, cli_dev.id)
+            self.assertEqual(dev.path, cli_dev.path)
+            # 'btrfs' reports rounded sizes
+            self.assertAlmostEqual(dev.size, cli_dev.size, delta=cli_dev.size * 0.01)
+
+        info = BlockDev.btrfs_filesystem_info(TEST_MNT)
+        self.assertEqual(info.label, "myShinyBtrfs")
+        self.assertEqual(info.num_devices, 2)
+        self.assertEqual(info.uuid, BlockDev.btrfs_filesystem_info(self.loop_dev).uuid)
+
 class BtrfsTestListSubvolumes(BtrfsTestCase):
     @tag_test(TestTags.CORE)
     def test_list_subvolumes(self):
@@ -356,6 +380,14 @@ class BtrfsTestListSubvolumes(BtrfsTestCase):
         self.assertEqual(subvols[0].path, "subvol1")
         self.assertEqual(subvols[1].path, "subvol1/bar")
 
+        paths = []
+        def collect(subvol, data):
+            data.append(subvol.path)
+            return True
+        succ = BlockDev.btrfs_list_subvolumes_foreach(TEST_MNT, False, collect, paths)
+        self.assertTrue(succ)
+        self.assertEqual(sorted(paths), ["subvol1", "subvol1/bar"])
+
     @tag_test(TestTags.CORE)
     def test_list_subvolumes_different_mount(self):
         """Verify that it is possible get to info about subvolumes with subvol= mount option"""
@@ -287,6 +287,50 @@ class CryptoTestFormat(CryptoTestCase):
             self.fail("Failed to get pbkdf information from:\n%s %s" % (out, err))
         self.assertEqual(int(m.group(1)), 5)
 
+    @tag_test(TestTags.SLOW, TestTags.CORE)
+    def test_luks2_format_pbkdf_calibrate(self):
+        """Verify that calibrated PBKDF parameters can be reused for LUKS 2 format"""
+
+        if self._is_fips_enabled():
+            self.skipTest("FIPS mode is enabled, cannot use argon2, skipping")
+
+        pbkdf = BlockDev.CryptoLUKSPBKDF(type="argon2id", time_ms=100, max_memory_kb=64*1024)
+        calibrated = BlockDev.crypto_luks_pbkdf_calibrate(pbkdf, 0)
+        self.assertIsNotNone(calibrated)
+        self.assertEqual(calibrated.type, "argon2id")
+        self.assertGreater(calibrated.iterations, 0)
+        self.assertGreater(calibrated.max_memory_kb, 0)
+        self.assertLessEqual(calibrated.max_memory_kb, 64*1024)
+        self.assertGreater(calibrated.parallel_threads, 0)
+
+        # already concrete parameters are just completed, not benchmarked
+        again = BlockDev.crypto_luks_pbkdf_calibrate(calibrated, 0)
+        self.assertEqual(again.iterations, calibrated.iterations)
+        self.assertEqual(again.max_memory_kb, calibrated.max_memory_kb)
+
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+        extra = BlockDev.CryptoLUKSExtra(pbkdf=calibrated)
+        succ = BlockDev.crypto_luks_format(self.loop_dev, "aes-xts-plain64", 0, ctx, 0,
+                                           BlockDev.CryptoLUKSVersion.LUKS2, extra)
+        self.assertTrue(succ)
+
+        # the calibrated values are used as they are
+        _ret, out, err = run_command("cryptsetup luksDump %s" % self.loop_dev)
+        m = re.search(r"Time cost:\s*(\d+)\s*", out)
+        if not m or len(m.groups()) != 1:
+            self.fail("Failed to get pbkdf information from:\n%s %s" % (out, err))
+        self.assertEqual(int(m.group(1)), calibrated.iterations)
+
+        m = re.search(r"Memory:\s*(\d+)\s*", out)
+        if not m or len(m.groups()) != 1:
+            self.fail("Failed to get pbkdf information from:\n%s %s" % (out, err))
+        self.assertEqual(int(m.group(1)), calibrated.max_memory_kb)
+
+        # default PBKDF
+        calibrated = BlockDev.crypto_luks_pbkdf_calibrate(None, 0)
+        self.assertIsNotNone(calibrated)
+        self.assertGreater(calibrated.iterations, 0)
+
     def _get_luks1_key_size(self, device):
         _ret, out, err = run_command("cryptsetup luksDump %s" % device)
         m = re.search(r"MK bits:\s*(\S+)\s*", out)
@@ -448,6 +492,163 @@ class CryptoTestOpenClose(CryptoTestCase):
     def test_luks2_open_close(self):
         self._luks_open_close(self._luks2_format)
 
+    def _close_many_cleanup(self, names):
+        for name in names:
+            try:
+                BlockDev.crypto_luks_close(name)
+            except GLib.GError:
+                pass
+
+    @tag_test(TestTags.SLOW, TestTags.CORE)
+    def test_luks2_open_close_many(self):
+        """Verify that opening/closing multiple LUKS devices at once works"""
+
+        names = ["libblockdevTestLUKS", "libblockdevTestLUKS2"]
+        self.addCleanup(self._close_many_cleanup, names)
+
+        self._luks2_format(self.loop_dev, PASSWD)
+        self._luks2_format(self.loop_dev2, PASSWD)
+
+        ctx = BlockDev.CryptoKeyslotContext(passphrase="wrong-passphrase")
+        results = BlockDev.crypto_luks_open_many([self.loop_dev, self.loop_dev2], names, ctx, False, 0)
+        self.assertEqual(len(results), 2)
+        for res in results:
+            self.assertIsNotNone(res.error)
+            self.assertIn("Incorrect passphrase", res.error.message)
+
+        # names have to match the devices
+        with self.assertRaises(GLib.GError):
+            BlockDev.crypto_luks_open_many([self.loop_dev, self.loop_dev2], names[:1], ctx, False, 0)
+
+        # error for one device doesn't affect the others
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+        results = BlockDev.crypto_luks_open_many([self.loop_dev, "/non/existing/device", self.loop_dev2],
+                                                 names[:1] + ["libblockdevTestLUKS3"] + names[1:],
+                                                 ctx, False, 0)
+        self.assertEqual(len(results), 3)
+        self.assertEqual(results[0].device, self.loop_dev)
+        self.assertIsNone(results[0].error)
+        self.assertIsNotNone(results[1].error)
+        self.assertEqual(results[2].device, self.loop_dev2)
+        self.assertIsNone(results[2].error)
+        for name in names:
+            self.assertTrue(os.path.exists("/dev/mapper/%s" % name))
+
+        results = BlockDev.crypto_luks_close_many(names)
+        self.assertEqual(len(results), 2)
+        for res in results:
+            self.assertIsNone(res.error)
+        for name in names:
+            self.assertFalse(os.path.exists("/dev/mapper/%s" % name))
+
+        # devices sharing the volume key (header copied) and a memory budget
+        backup_file = self.dev_file + ".header"
+        self.addCleanup(os.unlink, backup_file)
+        succ = BlockDev.crypto_luks_header_backup(self.loop_dev, backup_file)
+        self.assertTrue(succ)
+        succ = BlockDev.crypto_luks_header_restore(self.loop_dev2, backup_file)
+        self.assertTrue(succ)
+
+        results = BlockDev.crypto_luks_open_many([self.loop_dev, self.loop_dev2], names, ctx, True, 1024)
+        for res in results:
+            self.assertIsNone(res.error)
+
+        results = BlockDev.crypto_luks_close_many(names)
+        for res in results:
+            self.assertIsNone(res.error)
+
+    @tag_test(TestTags.SLOW, TestTags.CORE)
+    def test_luks2_open_flags(self):
+        """Verify that opening LUKS devices with activation flags works"""
+
+        self._luks2_format(self.loop_dev, PASSWD)
+        self._luks_format(self.loop_dev2, PASSWD)
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+
+        flags = BlockDev.CryptoLUKSOpenFlags.ALLOW_DISCARDS | BlockDev.CryptoLUKSOpenFlags.SAME_CPU_CRYPT
+        succ = BlockDev.crypto_luks_open_flags(self.loop_dev, "libblockdevTestLUKS", ctx, flags)
+        self.assertTrue(succ)
+        self.addCleanup(self._close_many_cleanup, ["libblockdevTestLUKS"])
+
+        _ret, out, _err = run_command("dmsetup table libblockdevTestLUKS")
+        self.assertIn("allow_discards", out)
+        self.assertIn("same_cpu_crypt", out)
+
+        succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
+        self.assertTrue(succ)
+
+        # store the flags in the header, next activation should use them
+        flags |= BlockDev.CryptoLUKSOpenFlags.PERSISTENT
+        succ = BlockDev.crypto_luks_open_flags(self.loop_dev, "libblockdevTestLUKS", ctx, flags)
+        self.assertTrue(succ)
+        succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("cryptsetup luksDump %s" % self.loop_dev)
+        self.assertIn("allow-discards", out)
+        self.assertIn("same-cpu-crypt", out)
+
+        succ = BlockDev.crypto_luks_open(self.loop_dev, "libblockdevTestLUKS", ctx, False)
+        self.assertTrue(succ)
+        _ret, out, _err = run_command("dmsetup table libblockdevTestLUKS")
+        self.assertIn("allow_discards", out)
+        succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
+        self.assertTrue(succ)
+
+        # LUKS 1 has no space for the flags
+        with self.assertRaisesRegex(GLib.GError, "only in the LUKS 2 header"):
+            BlockDev.crypto_luks_open_flags(self.loop_dev2, "libblockdevTestLUKS2", ctx,
+                                            BlockDev.CryptoLUKSOpenFlags.PERSISTENT)
+
+    @tag_test(TestTags.SLOW, TestTags.CORE)
+    def test_luks2_open_keyring_volume_key(self):
+        """Verify that the volume key kept in the keyring is used for resize and resume"""
+
+        self._luks2_format(self.loop_dev, PASSWD)
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+
+        succ = BlockDev.crypto_luks_open_flags(self.loop_dev, "libblockdevTestLUKS", ctx,
+                                               BlockDev.CryptoLUKSOpenFlags.KEYRING_VOLUME_KEY)
+        self.assertTrue(succ)
+        self.addCleanup(self._close_many_cleanup, ["libblockdevTestLUKS"])
+
+        # only the possessors of the keyring can access the key
+        if shutil.which("keyctl"):
+            uuid = BlockDev.crypto_luks_info(self.loop_dev).uuid
+            ret, key_id, _err = run_command("keyctl search @s user libblockdev:volume-key:%s" % uuid)
+            self.assertEqual(ret, 0)
+            ret, out, _err = run_command("keyctl rdescribe %s" % key_id)
+            self.assertEqual(ret, 0)
+            perm = int(out.split(";")[3], 16)
+            self.assertEqual(perm & 0x00ffffff, 0)
+
+        # no context needed
+        succ = BlockDev.crypto_luks_resize("libblockdevTestLUKS", 1024)
+        self.assertTrue(succ)
+        self.assertEqual(int(read_file("/sys/block/%s/size" % os.path.basename(os.path.realpath("/dev/mapper/libblockdevTestLUKS")))), 1024)
+
+        succ = BlockDev.crypto_luks_suspend("libblockdevTestLUKS")
+        self.assertTrue(succ)
+        succ = BlockDev.crypto_luks_resume("libblockdevTestLUKS", None)
+        self.assertTrue(succ)
+
+        # closing the device removes the key from the keyring
+        succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
+        self.assertTrue(succ)
+
+        succ = BlockDev.crypto_luks_open(self.loop_dev, "libblockdevTestLUKS", ctx, False)
+        self.assertTrue(succ)
+
+        succ = BlockDev.crypto_luks_suspend("libblockdevTestLUKS")
+        self.assertTrue(succ)
+        with self.assertRaisesRegex(GLib.GError, "no volume key"):
+            BlockDev.crypto_luks_resume("libblockdevTestLUKS", None)
+        succ = BlockDev.crypto_luks_resume("libblockdevTestLUKS", ctx)
+        self.assertTrue(succ)
+
+        succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
+        self.assertTrue(succ)
+
     @tag_test(TestTags.SLOW, TestTags.CORE)
     def test_luks2_open_close_non_ascii_passphrase(self):
         passphrase = "šššššššš"
@@ -1048,6 +1249,41 @@ class CryptoTestInfo(CryptoTestCase):
         self.assertTrue(succ)
 
 
+    @tag_test(TestTags.SLOW)
+    def test_luks2_info_header_change(self):
+        """Verify that information about a LUKS 2 device reflects changes of the header"""
+
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+        succ = BlockDev.crypto_luks_format(self.loop_dev, None, 0, ctx, 0,
+                                           BlockDev.CryptoLUKSVersion.LUKS2, None)
+        self.assertTrue(succ)
+
+        info = BlockDev.crypto_luks_info(self.loop_dev)
+        self.assertEqual(info.version, BlockDev.CryptoLUKSVersion.LUKS2)
+        old_uuid = info.uuid
+
+        # the same (unchanged) header queried again
+        info = BlockDev.crypto_luks_info(self.loop_dev)
+        self.assertEqual(info.uuid, old_uuid)
+
+        # header changed outside of libblockdev
+        new_uuid = "4d7086c4-a4d3-432f-819e-73da03870df9"
+        ret, _out, err = run_command("cryptsetup luksUUID --batch-mode --uuid %s %s" % (new_uuid, self.loop_dev))
+        if ret != 0:
+            self.fail("Failed to change LUKS UUID:\n%s" % err)
+
+        info = BlockDev.crypto_luks_info(self.loop_dev)
+        self.assertEqual(info.uuid, new_uuid)
+
+        # reformatted as LUKS 1
+        succ = BlockDev.crypto_luks_format(self.loop_dev, None, 0, ctx, 0,
+                                           BlockDev.CryptoLUKSVersion.LUKS1, None)
+        self.assertTrue(succ)
+
+        info = BlockDev.crypto_luks_info(self.loop_dev)
+        self.assertEqual(info.version, BlockDev.CryptoLUKSVersion.LUKS1)
+        self.assertNotEqual(info.uuid, new_uuid)
+
 class CryptoTestSetLabel(CryptoTestCase):
 
     label = "aaaaaa"
@@ -1198,6 +1434,124 @@ class CryptoTestConvert(CryptoTestCase):
         self.assertEqual(info.version, BlockDev.CryptoLUKSVersion.LUKS2)
 
 
+class CryptoTestReencrypt(CryptoTestCase):
+    # reencryption rewrites the whole device
+    _sparse_size = 64 * 1024**2
+
+    def setUp(self):
+        if not check_cryptsetup_version("2.4.0"):
+            self.skipTest("cryptsetup reencryption with progress reporting not available, skipping.")
+
+        super(CryptoTestReencrypt, self).setUp()
+
+    def _get_volume_key_digest(self):
+        _ret, out, _err = run_command("cryptsetup luksDump %s" % self.loop_dev)
+        m = re.search(r"Digest:\s+(.+)", out)
+        self.assertIsNotNone(m)
+        return m.group(1)
+
+    @tag_test(TestTags.SLOW, TestTags.CORE)
+    def test_luks2_reencrypt_offline(self):
+        """Verify that offline reencryption of LUKS2 devices works"""
+
+        self._luks2_format(self.loop_dev, PASSWD)
+        digest = self._get_volume_key_digest()
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+
+        # LUKS 1 cannot be reencrypted
+        self._luks_format(self.loop_dev2, PASSWD)
+        with self.assertRaisesRegex(GLib.GError, "only LUKS 2 devices"):
+            BlockDev.crypto_luks_reencrypt(self.loop_dev2, None, ctx)
+
+        # online reencryption needs an open device
+        with self.assertRaisesRegex(GLib.GError, "is not opened"):
+            BlockDev.crypto_luks_reencrypt(self.loop_dev, None, ctx)
+
+        pbkdf = BlockDev.CryptoLUKSPBKDF(type="pbkdf2")
+        params = BlockDev.CryptoLUKSReencryptParams(resilience="journal", offline=True, pbkdf=pbkdf)
+        succ = BlockDev.crypto_luks_reencrypt(self.loop_dev, params, ctx)
+        self.assertTrue(succ)
+        self.assertNotEqual(self._get_volume_key_digest(), digest)
+
+        # the passphrase still works
+        succ = BlockDev.crypto_luks_open(self.loop_dev, "libblockdevTestLUKS", ctx, False)
+        self.assertTrue(succ)
+        succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
+        self.assertTrue(succ)
+
+    @tag_test(TestTags.SLOW, TestTags.CORE)
+    def test_luks2_reencrypt_online(self):
+        """Verify that online reencryption of LUKS2 devices works"""
+
+        self._luks2_format(self.loop_dev, PASSWD)
+        digest = self._get_volume_key_digest()
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+
+        succ = BlockDev.crypto_luks_open(self.loop_dev, "libblockdevTestLUKS", ctx, False)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.crypto_luks_close, "libblockdevTestLUKS")
+
+        data = secrets.token_bytes(1024 * 1024)
+        with open("/dev/mapper/libblockdevTestLUKS", "wb") as f:
+            f.write(data)
+
+        params = BlockDev.CryptoLUKSReencryptParams(max_hotzone_size=1024**2, max_bandwidth=100 * 1024**2)
+        succ = BlockDev.crypto_luks_reencrypt(self.loop_dev, params, ctx)
+        self.assertTrue(succ)
+        self.assertNotEqual(self._get_volume_key_digest(), digest)
+
+        with open("/dev/mapper/libblockdevTestLUKS", "rb") as f:
+            self.assertEqual(f.read(len(data)), data)
+
+    def _get_keyslots(self):
+        _ret, out, _err = run_command("cryptsetup luksDump %s" % self.loop_dev)
+        return re.findall(r"^\s+(\d+): luks2", out, re.MULTILINE)
+
+    @tag_test(TestTags.SLOW, TestTags.CORE)
+    def test_luks2_reencrypt_resume(self):
+        """Verify that an interrupted reencryption of LUKS2 devices is resumed"""
+
+        self._luks2_format(self.loop_dev, PASSWD)
+        digest = self._get_volume_key_digest()
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+
+        succ = BlockDev.crypto_luks_open(self.loop_dev, "libblockdevTestLUKS", ctx, False)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.crypto_luks_close, "libblockdevTestLUKS")
+
+        data = secrets.token_bytes(1024 * 1024)
+        with open("/dev/mapper/libblockdevTestLUKS", "wb") as f:
+            f.write(data)
+
+        # only initialize the reencryption (adds the key slot for the new volume key)
+        # to get the state of a reencryption interrupted before reencrypting anything
+        ret, _out, err = run_command("cryptsetup reencrypt --init-only --batch-mode --key-file - %s" % self.loop_dev,
+                                     cmd_input=PASSWD.encode())
+        if ret != 0:
+            self.skipTest("Failed to initialize the reencryption with cryptsetup: %s" % err)
+        self.assertEqual(len(self._get_keyslots()), 2)
+
+        # wrong passphrase
+        with self.assertRaisesRegex(GLib.GError, "Failed to resume reencryption"):
+            BlockDev.crypto_luks_reencrypt(self.loop_dev, None, BlockDev.CryptoKeyslotContext(passphrase="wrong"))
+        self.assertEqual(len(self._get_keyslots()), 2)
+
+        # resumed without adding any other key slot, only the new one stays
+        params = BlockDev.CryptoLUKSReencryptParams(max_hotzone_size=1024**2)
+        succ = BlockDev.crypto_luks_reencrypt(self.loop_dev, params, ctx)
+        self.assertTrue(succ)
+        self.assertEqual(len(self._get_keyslots()), 1)
+        self.assertNotEqual(self._get_volume_key_digest(), digest)
+
+        with open("/dev/mapper/libblockdevTestLUKS", "rb") as f:
+            self.assertEqual(f.read(len(data)), data)
+
+        # nothing to resume now, a new reencryption is started
+        succ = BlockDev.crypto_luks_reencrypt(self.loop_dev, params, ctx)
+        self.assertTrue(succ)
+        self.assertEqual(len(self._get_keyslots()), 1)
+
+
 class CryptoTestLuksSectorSize(CryptoTestCase):
     def setUp(self):
         if not check_cryptsetup_version("2.4.0"):
@@ -1307,6 +1661,52 @@ class CryptoTestLUKS2Integrity(CryptoTestCase):
         succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
         self.assertTrue(succ)
 
+    @tag_test(TestTags.SLOW)
+    def test_luks2_integrity_wipe(self):
+        """Verify that we can wipe a LUKS 2 device with integrity"""
+
+        if not BlockDev.utils_have_kernel_module("dm-integrity"):
+            self.skipTest('dm-integrity kernel module not available, skipping.')
+
+        progress_log = []
+
+        def _my_progress_func(_task, _status, completion, msg):
+            progress_log.append((completion, msg))
+
+        extra = BlockDev.CryptoLUKSExtra()
+        extra.integrity = "hmac(sha256)"
+
+        ctx = BlockDev.CryptoKeyslotContext(passphrase=PASSWD)
+        succ = BlockDev.crypto_luks_format(self.loop_dev, "aes-cbc-essiv:sha256", 512, ctx, 0,
+                                           BlockDev.CryptoLUKSVersion.LUKS2, extra)
+        self.assertTrue(succ)
+
+        # wrong passphrase
+        with self.assertRaisesRegex(GLib.GError, r"Incorrect passphrase"):
+            BlockDev.crypto_luks_wipe(self.loop_dev, BlockDev.CryptoKeyslotContext(passphrase=PASSWD2))
+
+        succ = BlockDev.utils_init_prog_reporting(_my_progress_func)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.utils_init_prog_reporting, None)
+
+        succ = BlockDev.crypto_luks_wipe(self.loop_dev, ctx)
+        self.assertTrue(succ)
+        self.assertIn((100, "LUKS device wipe in progress"), progress_log)
+
+        # no temporary device left behind
+        _ret, holders, _err = run_command('ls /sys/block/%s/holders/' % self.loop_dev.split("/")[-1])
+        self.assertFalse(holders)
+
+        succ = BlockDev.crypto_luks_open(self.loop_dev, "libblockdevTestLUKS", ctx, False)
+        self.assertTrue(succ)
+
+        # all the checksums are valid so the whole device can be read
+        ret, _out, err = run_command("dd if=/dev/mapper/libblockdevTestLUKS of=/dev/null bs=1M")
+        self.assertEqual(ret, 0, msg="Failed to read the wiped device: %s" % err)
+
+        succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
+        self.assertTrue(succ)
+
 
 class CryptoTestLUKSToken(CryptoTestCase):
 
@@ -1346,6 +1746,49 @@ class CryptoTestLUKSToken(CryptoTestCase):
         succ = BlockDev.crypto_luks_close("libblockdevTestLUKS")
         self.assertTrue(succ)
 
+class CryptoTestSeemsEncrypted(CryptoTestCase):
+    def setUp(self):
+        self.random_file = create_sparse_tempfile("crypto_test_random", 1024**2)
+        self.addCleanup(os.unlink, self.random_file)
+        with open(self.random_file, "wb") as f:
+            f.write(os.urandom(1024**2))
+
+        self.zero_file = create_sparse_tempfile("crypto_test_zero", 1024**2)
+        self.addCleanup(os.unlink, self.zero_file)
+
+        # random at the start only
+        self.header_file = create_sparse_tempfile("crypto_test_header", 1024**2)
+        self.addCleanup(os.unlink, self.header_file)
+        with open(self.header_file, "r+b") as f:
+            f.write(os.urandom(4096))
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_seems_encrypted(self):
+        """Verify that checking whether devices seem to be encrypted works"""
+
+        self.assertTrue(BlockDev.crypto_device_seems_encrypted(self.random_file))
+        self.assertFalse(BlockDev.crypto_device_seems_encrypted(self.zero_file))
+        self.assertTrue(BlockDev.crypto_device_seems_encrypted(self.header_file))
+
+        results = BlockDev.crypto_devices_seem_encrypted([self.random_file, self.zero_file, self.header_file,
+                                                          "/non/existing/device"], 0)
+        self.assertEqual(len(results), 4)
+        self.assertEqual([r.device for r in results], [self.random_file, self.zero_file, self.header_file,
+                                                       "/non/existing/device"])
+        self.assertTrue(results[0].seems_encrypted)
+        self.assertFalse(results[1].seems_encrypted)
+        # only the start is random
+        self.assertFalse(results[2].seems_encrypted)
+        self.assertFalse(results[3].seems_encrypted)
+        for res in results[:3]:
+            self.assertIsNone(res.error)
+        self.assertIsNotNone(results[3].error)
+
+        # checking just the start is the same as the single device check
+        results = BlockDev.crypto_devices_seem_encrypted([self.header_file], 1)
+        self.assertTrue(results[0].seems_encrypted)
+
+
 class CryptoTestTrueCrypt(CryptoTestCase):
 
     # we can't create TrueCrypt/VeraCrypt formats using libblockdev
@@ -1689,6 +2132,38 @@ class CryptoTestIntegrity(CryptoTestCase):
         self.assertTrue(succ)
         self.assertFalse(os.path.exists("/dev/mapper/%s" % self._dm_name))
 
+        # journal tuning
+        extra = BlockDev.CryptoIntegrityExtra(journal_watermark=70, journal_commit_time=5000, buffer_sectors=256)
+        succ = BlockDev.crypto_integrity_open(self.loop_dev, self._dm_name, "crc32c", extra=extra)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("dmsetup table %s" % self._dm_name)
+        self.assertIn(" J ", out)
+        self.assertIn("journal_watermark:70", out)
+        self.assertIn("commit_time:5000", out)
+        self.assertIn("buffer_sectors:256", out)
+
+        succ = BlockDev.crypto_integrity_close(self._dm_name)
+        self.assertTrue(succ)
+
+        # bitmap mode
+        extra = BlockDev.CryptoIntegrityExtra(bitmap_sectors_per_bit=65536, bitmap_flush_time=2000)
+        with self.assertRaisesRegex(GLib.GError, "only in the bitmap mode"):
+            BlockDev.crypto_integrity_open(self.loop_dev, self._dm_name, "crc32c", extra=extra)
+
+        succ = BlockDev.crypto_integrity_open(self.loop_dev, self._dm_name, "crc32c",
+                                              flags=BlockDev.CryptoIntegrityOpenFlags.NO_JOURNAL_BITMAP,
+                                              extra=extra)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("dmsetup table %s" % self._dm_name)
+        self.assertIn(" B ", out)
+        self.assertIn("sectors_per_bit:65536", out)
+        self.assertIn("bitmap_flush_interval:2000", out)
+
+        succ = BlockDev.crypto_integrity_close(self._dm_name)
+        self.assertTrue(succ)
+
     @tag_test(TestTags.SLOW)
     def test_integrity_wipe(self):
         # also check that wipe progress reporting works
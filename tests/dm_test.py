@@ -114,6 +114,33 @@ class DevMapperMapExists(DevMapperTestCase):
         succ = BlockDev.dm_map_exists("testMap", False, False)
         self.assertFalse(succ)
 
+    def test_maps_exist(self):
+        """Verify that testing if multiple maps exist works as expected"""
+
+        succ = BlockDev.dm_create_linear("testMap", self.loop_dev, 100, None)
+        self.assertTrue(succ)
+
+        found = BlockDev.dm_maps_exist(["nonexistingMap", "testMap", "anotherNonexistingMap"], True, True)
+        self.assertEqual(found, ["testMap"])
+
+        found = BlockDev.dm_maps_exist(["nonexistingMap"], False, False)
+        self.assertEqual(found, [])
+
+        # suspend the map
+        os.system("dmsetup suspend testMap")
+
+        found = BlockDev.dm_maps_exist(["testMap"], True, False)
+        self.assertEqual(found, ["testMap"])
+
+        found = BlockDev.dm_maps_exist(["testMap"], True, True)
+        self.assertEqual(found, [])
+
+        succ = BlockDev.dm_remove("testMap")
+        self.assertTrue(succ)
+
+        found = BlockDev.dm_maps_exist(["testMap"], False, False)
+        self.assertEqual(found, [])
+
 class DevMapperNameNodeBijection(DevMapperTestCase):
     def test_name_node_bijection(self):
         """Verify that the map's node and map name points to each other"""
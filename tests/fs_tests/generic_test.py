@@ -2,6 +2,7 @@ import os
 import time
 import tempfile
 import re
+import threading
 
 from packaging.version import Version
 
@@ -105,6 +106,30 @@ class TestGenericWipe(GenericTestCase):
         with self.assertRaisesRegex(GLib.GError, "No signature detected on the device"):
             BlockDev.fs_wipe(self.loop_dev, True)
 
+    def test_generic_wipe_probe_timeout(self):
+        """Verify that the probe timeout can be changed and wipe works right after a change"""
+
+        succ = BlockDev.fs_set_probe_timeout(5000)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.fs_set_probe_timeout, 0)
+
+        # wipe directly after the device was changed (and udev is probing it)
+        for i in range(10):
+            ret = utils.run("pvcreate -ff -y %s --config \"devices {use_devicesfile = 0}\" >/dev/null 2>&1" % self.loop_dev)
+            self.assertEqual(ret, 0)
+
+            start = time.monotonic()
+            succ = BlockDev.fs_wipe(self.loop_dev, True)
+            self.assertTrue(succ)
+            self.assertLess(time.monotonic() - start, 5)
+
+        # 0 resets to the default
+        succ = BlockDev.fs_set_probe_timeout(0)
+        self.assertTrue(succ)
+
+        with self.assertRaisesRegex(GLib.GError, "No signature detected on the device"):
+            BlockDev.fs_wipe(self.loop_dev, True)
+
     @tag_test(TestTags.CORE)
     def test_generic_wipe_force(self):
         ret = utils.run("mkfs.ext2 %s >/dev/null 2>&1" % self.loop_dev)
@@ -176,6 +201,97 @@ class TestClean(GenericTestCase):
         fs_type = check_output(["blkid", "-ovalue", "-sTYPE", "-p", self.loop_dev]).strip()
         self.assertEqual(fs_type, b"")
 
+    def test_clean_device(self):
+        """Verify that cleaning with the different clean modes works as expected"""
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.fs_clean_device("/non/existing/device", BlockDev.FSCleanMode.EDGES)
+
+        for mode in (BlockDev.FSCleanMode.SIGNATURES, BlockDev.FSCleanMode.EDGES,
+                     BlockDev.FSCleanMode.ZEROOUT, BlockDev.FSCleanMode.DISCARD):
+            # GPT has a backup header at the end of the device
+            ret = utils.run("echo 'label: gpt' | sfdisk -q %s >/dev/null 2>&1" % self.loop_dev)
+            self.assertEqual(ret, 0)
+            ret = utils.run("dd if=/dev/urandom of=%s bs=1M count=1 seek=10 oflag=direct >/dev/null 2>&1" % self.loop_dev)
+            self.assertEqual(ret, 0)
+
+            succ = BlockDev.fs_clean_device(self.loop_dev, mode)
+            self.assertTrue(succ)
+
+            utils.run("udevadm settle")
+            pt_type = check_output(["blkid", "-ovalue", "-sPTTYPE", "-p", self.loop_dev]).strip()
+            self.assertEqual(pt_type, b"")
+            with open(self.loop_dev, "rb") as f:
+                f.seek(-1024**2, os.SEEK_END)
+                self.assertEqual(f.read(1024**2), b"\0" * 1024**2)
+
+                # only zeroing out the whole device clears the data too
+                if mode == BlockDev.FSCleanMode.ZEROOUT:
+                    f.seek(10 * 1024**2)
+                    self.assertEqual(f.read(1024**2), b"\0" * 1024**2)
+
+    def test_clean_many(self):
+        """Verify that cleaning multiple devices in parallel works as expected"""
+
+        for dev in (self.loop_dev, self.loop_dev2):
+            ret = utils.run("mkfs.ext2 -F %s >/dev/null 2>&1" % dev)
+            self.assertEqual(ret, 0)
+
+        results = BlockDev.fs_clean_many([self.loop_dev, self.loop_dev2, "/non/existing/device"],
+                                         BlockDev.FSCleanMode.EDGES)
+        self.assertEqual(len(results), 3)
+        self.assertTrue(results[0].success)
+        self.assertTrue(results[1].success)
+        self.assertFalse(results[2].success)
+        self.assertIsNotNone(results[2].error)
+
+        utils.run("udevadm settle")
+        for dev in (self.loop_dev, self.loop_dev2):
+            fs_type = check_output(["blkid", "-ovalue", "-sTYPE", "-p", dev]).strip()
+            self.assertEqual(fs_type, b"")
+
+
+class TestProbeAll(GenericTestCase):
+    def test_probe_all(self):
+        """Verify that probing all the signature information at once works as expected"""
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.fs_probe_all("/non/existing/device")
+
+        # empty device
+        info = BlockDev.fs_probe_all(self.loop_dev)
+        self.assertIsNotNone(info)
+        self.assertIsNone(info.type)
+        self.assertIsNone(info.usage)
+        self.assertIsNone(info.uuid)
+        self.assertEqual(info.size, self.loop_size)
+
+        uuid = "4d7086c4-a4d3-432f-819e-73da03870df9"
+        ret = utils.run("mkfs.ext4 -F -L myLabel -U %s %s >/dev/null 2>&1" % (uuid, self.loop_dev))
+        self.assertEqual(ret, 0)
+
+        info = BlockDev.fs_probe_all(self.loop_dev)
+        self.assertEqual(info.type, "ext4")
+        self.assertEqual(info.usage, "filesystem")
+        self.assertEqual(info.uuid, uuid)
+        self.assertEqual(info.label, "myLabel")
+        self.assertEqual(info.version, "1.0")
+        self.assertEqual(info.size, self.loop_size)
+        self.assertEqual(info.type, BlockDev.fs_get_fstype(self.loop_dev))
+
+        # not a filesystem signature which fs_get_fstype rejects
+        ret = utils.run("pvcreate -ff -y %s --config \"devices {use_devicesfile = 0}\" >/dev/null 2>&1" % self.loop_dev)
+        self.assertEqual(ret, 0)
+
+        info = BlockDev.fs_probe_all(self.loop_dev)
+        self.assertEqual(info.type, "LVM2_member")
+        self.assertEqual(info.usage, "raid")
+        pv_uuid = check_output(["blkid", "-ovalue", "-sUUID", "-p", self.loop_dev]).strip()
+        self.assertEqual(info.uuid, pv_uuid.decode())
+
+        with self.assertRaisesRegex(GLib.GError, "not 'filesystem'"):
+            BlockDev.fs_get_fstype(self.loop_dev)
+
 
 class CanResizeRepairCheckLabel(GenericNoDevTestCase):
     def test_can_resize(self):
@@ -352,6 +468,46 @@ class CanResizeRepairCheckLabel(GenericNoDevTestCase):
         with self.assertRaises(GLib.GError):
             BlockDev.fs_can_get_min_size("xfs")
 
+    def test_get_capabilities(self):
+        """Verify that the capability matrix matches the individual tooling queries"""
+
+        caps = BlockDev.fs_get_capabilities(False)
+        self.assertEqual([c.type for c in caps], BlockDev.fs_supported_filesystems())
+
+        ext4 = next(c for c in caps if c.type == "ext4")
+        self.assertTrue(ext4.supported & BlockDev.FSOperationFlags.RESIZE)
+        self.assertTrue(ext4.available & BlockDev.FSOperationFlags.RESIZE)
+        self.assertEqual(ext4.missing_utils, [])
+        self.assertEqual(ext4.resize_mode, BlockDev.FSResizeFlags.ONLINE_GROW |
+                                           BlockDev.FSResizeFlags.OFFLINE_GROW |
+                                           BlockDev.FSResizeFlags.OFFLINE_SHRINK)
+
+        xfs = next(c for c in caps if c.type == "xfs")
+        self.assertFalse(xfs.supported & BlockDev.FSOperationFlags.GET_MIN_SIZE)
+        self.assertFalse(xfs.supported & BlockDev.FSOperationFlags.GET_FREE_SPACE)
+
+        avail, _util = BlockDev.fs_can_get_min_size("ntfs")
+        ntfs = next(c for c in caps if c.type == "ntfs")
+        self.assertEqual(bool(ntfs.available & BlockDev.FSOperationFlags.GET_MIN_SIZE), avail)
+
+        # changing PATH invalidates the cache
+        old_path = os.environ.get("PATH", "")
+        os.environ["PATH"] = ""
+        try:
+            caps = BlockDev.fs_get_capabilities(False)
+        finally:
+            os.environ["PATH"] = old_path
+        ext4 = next(c for c in caps if c.type == "ext4")
+        self.assertTrue(ext4.supported & BlockDev.FSOperationFlags.RESIZE)
+        self.assertFalse(ext4.available & BlockDev.FSOperationFlags.RESIZE)
+        self.assertIn("resize2fs", ext4.missing_utils)
+        self.assertIn("mkfs.ext4", ext4.missing_utils)
+        self.assertEqual(len(ext4.missing_utils), len(set(ext4.missing_utils)))
+
+        caps = BlockDev.fs_get_capabilities(False)
+        ext4 = next(c for c in caps if c.type == "ext4")
+        self.assertTrue(ext4.available & BlockDev.FSOperationFlags.RESIZE)
+
         with self.assertRaises(GLib.GError):
             BlockDev.fs_can_get_min_size("non-existing-fs")
 
@@ -581,6 +737,57 @@ class GenericMkfs(GenericTestCase):
         label = ""
         self._test_ext_generic_mkfs("udf", BlockDev.fs_udf_get_info, label, None, default_label="LinuxUDF")
 
+    def test_ext4_generic_mkfs_provisioning(self):
+        """ Test generic mkfs with ext4 and the fast-provisioning options """
+        supported, flags, _util = BlockDev.fs_can_mkfs("ext4")
+        self.assertTrue(supported)
+        self.assertTrue(flags & BlockDev.FSMkfsOptionsFlags.LAZY_INIT)
+        self.assertTrue(flags & BlockDev.FSMkfsOptionsFlags.STRIPE)
+        self.assertTrue(flags & BlockDev.FSMkfsOptionsFlags.LOG_SIZE)
+        self.assertTrue(flags & BlockDev.FSMkfsOptionsFlags.INODE_SIZE)
+
+        options = BlockDev.FSMkfsOptions(lazy_init=True, stripe_unit=64 * 1024, stripe_width=4,
+                                         log_size=8, inode_size=512)
+        succ = BlockDev.fs_mkfs(self.loop_dev, "ext4", options)
+        self.assertTrue(succ)
+
+        info = BlockDev.fs_ext4_get_info(self.loop_dev)
+        self.assertEqual(info.block_size, 4096)
+
+        _ret, out, _err = utils.run_command("dumpe2fs -h %s" % self.loop_dev)
+        self.assertRegex(out, r"RAID stride:\s+16\n")
+        self.assertRegex(out, r"RAID stripe width:\s+64\n")
+        self.assertRegex(out, r"Inode size:\s+512\n")
+        self.assertRegex(out, r"Journal size:\s+(8192k|8M)\n")
+
+        # the loop device has no stripe so the topology doesn't change anything
+        options = BlockDev.FSMkfsOptions(stripe_from_topology=True, force=True)
+        succ = BlockDev.fs_mkfs(self.loop_dev, "ext4", options)
+        self.assertTrue(succ)
+
+        _ret, out, _err = utils.run_command("dumpe2fs -h %s" % self.loop_dev)
+        self.assertNotIn("RAID stride", out)
+
+    def test_xfs_generic_mkfs_provisioning(self):
+        """ Test generic mkfs with XFS and the fast-provisioning options """
+        supported, flags, _util = BlockDev.fs_can_mkfs("xfs")
+        self.assertTrue(supported)
+        self.assertFalse(flags & BlockDev.FSMkfsOptionsFlags.LAZY_INIT)
+        self.assertTrue(flags & BlockDev.FSMkfsOptionsFlags.STRIPE)
+
+        options = BlockDev.FSMkfsOptions(stripe_unit=64 * 1024, stripe_width=4, log_size=64, inode_size=1024)
+        succ = BlockDev.fs_mkfs(self.loop_dev, "xfs", options)
+        self.assertTrue(succ)
+
+        _ret, out, _err = utils.run_command("xfs_db -r -c 'sb 0' -c 'p unit width inodesize logblocks blocksize' %s" % self.loop_dev)
+        values = dict(line.split(" = ") for line in out.strip().split("\n"))
+        # stripe unit and width are in file system blocks
+        block_size = int(values["blocksize"])
+        self.assertEqual(int(values["unit"]) * block_size, 64 * 1024)
+        self.assertEqual(int(values["width"]) * block_size, 4 * 64 * 1024)
+        self.assertEqual(int(values["inodesize"]), 1024)
+        self.assertEqual(int(values["logblocks"]) * block_size, 64 * 1024**2)
+
     def test_generic_mkfs_no_options(self):
         """ Test that fs_mkfs works without options specified """
         succ = BlockDev.fs_mkfs(self.loop_dev, "ext2")
@@ -609,6 +816,42 @@ class GenericMkfs(GenericTestCase):
         self.assertTrue(flags & BlockDev.FSMkfsOptionsFlags.FORCE)
 
 
+class GenericMkfsMany(GenericTestCase):
+
+    def test_mkfs_many(self):
+        """Test creating multiple file systems in parallel"""
+
+        options = BlockDev.FSMkfsOptions(label="many", lazy_init=True)
+        results = BlockDev.fs_mkfs_many([self.loop_dev, self.loop_dev2, "/non/existing/device"], "ext4", options)
+        self.assertEqual(len(results), 3)
+
+        for result, device in zip(results[:2], (self.loop_dev, self.loop_dev2)):
+            self.assertEqual(result.device, device)
+            self.assertTrue(result.success)
+            self.assertIsNone(result.error)
+
+            info = BlockDev.fs_ext4_get_info(device)
+            self.assertEqual(info.label, "many")
+
+        self.assertFalse(results[2].success)
+        self.assertIsNotNone(results[2].error)
+
+        # one device at a time also works
+        results = BlockDev.fs_mkfs_many([self.loop_dev, self.loop_dev2], "xfs", BlockDev.FSMkfsOptions(force=True),
+                                        max_workers=1)
+        self.assertTrue(all(r.success for r in results))
+        self.assertEqual(BlockDev.fs_get_fstype(self.loop_dev), "xfs")
+        self.assertEqual(BlockDev.fs_get_fstype(self.loop_dev2), "xfs")
+
+        # the same UUID cannot be used for multiple file systems
+        options = BlockDev.FSMkfsOptions(uuid="8802574c-587b-43b9-a6be-9de77759d2c5")
+        with self.assertRaisesRegex(GLib.GError, "UUID"):
+            BlockDev.fs_mkfs_many([self.loop_dev, self.loop_dev2], "ext4", options)
+
+        with self.assertRaisesRegex(GLib.GError, "not supported"):
+            BlockDev.fs_mkfs_many([self.loop_dev], "non-existing-fs")
+
+
 class GenericCheck(GenericTestCase):
     log = []
 
@@ -699,6 +942,52 @@ class GenericCheck(GenericTestCase):
         self._test_generic_check(mkfs_function=BlockDev.fs_btrfs_mkfs, fstype="btrfs")
 
 
+class GenericCheckMany(GenericTestCase):
+    log = []
+
+    def _my_progress_func(self, task, status, completion, msg):
+        self.log.append((task, status, completion))
+
+    def test_check_many(self):
+        """Test checking multiple file systems in parallel"""
+
+        succ = BlockDev.fs_ext4_mkfs(self.loop_dev, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.fs_xfs_mkfs(self.loop_dev2, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.utils_init_prog_reporting(self._my_progress_func)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.utils_init_prog_reporting, None)
+
+        self.log = []
+        results = BlockDev.fs_check_many([self.loop_dev, self.loop_dev2, "/non/existing/device"], False, 0, 0)
+        self.assertEqual(len(results), 3)
+
+        self.assertEqual(results[0].device, self.loop_dev)
+        self.assertTrue(results[0].success)
+        self.assertIsNone(results[0].error)
+
+        self.assertEqual(results[1].device, self.loop_dev2)
+        self.assertTrue(results[1].success)
+        self.assertIsNone(results[1].error)
+
+        self.assertFalse(results[2].success)
+        self.assertIsNotNone(results[2].error)
+
+        # the overall task should have been reported with an update for every device
+        overall = self.log[0][0]
+        updates = [c for (t, s, c) in self.log if t == overall and s == BlockDev.UtilsProgStatus.PROGRESS]
+        self.assertEqual(len(updates), 3)
+        self.assertEqual(updates[-1], 100)
+
+        # repair also works, with checks on one disk at a time
+        results = BlockDev.fs_check_many([self.loop_dev, self.loop_dev2], True, 1, 1)
+        self.assertEqual(len(results), 2)
+        self.assertTrue(all(r.success for r in results))
+
+
 class GenericRepair(GenericTestCase):
     def _test_generic_repair(self, mkfs_function, fstype):
         # clean the device
@@ -1052,6 +1341,55 @@ class GenericResize(GenericTestCase):
         self.assertTrue(fi)
         self.assertEqual(fi.block_size * fi.block_count, 450 * 1024**2)
 
+    def test_xfs_generic_resize_temp_mounts(self):
+        """Test generic resize of an unmounted xfs file system with held temporary mounts"""
+
+        # nothing to release
+        with self.assertRaises(GLib.GError):
+            BlockDev.fs_release_temp_mounts()
+
+        lv = self._setup_lvm(vgname="libbd_fs_tests", lvname="generic_test", lvsize="350M")
+
+        succ = BlockDev.fs_xfs_mkfs(lv, None)
+        self.assertTrue(succ)
+
+        self._lvresize("libbd_fs_tests", "generic_test", "400M")
+
+        succ = BlockDev.fs_hold_temp_mounts()
+        self.assertTrue(succ)
+
+        # the hold is per thread, there's nothing to release in other threads
+        errors = []
+        def release_in_thread():
+            try:
+                BlockDev.fs_release_temp_mounts()
+            except GLib.GError as e:
+                errors.append(e)
+        thread = threading.Thread(target=release_in_thread)
+        thread.start()
+        thread.join()
+        self.assertEqual(len(errors), 1)
+
+        succ = BlockDev.fs_resize(lv, 380 * 1024**2)
+        self.assertTrue(succ)
+
+        # the temporary mount is kept and reused by the next resize
+        mountpoint = BlockDev.fs_get_mountpoint(lv)
+        self.assertIsNotNone(mountpoint)
+
+        succ = BlockDev.fs_resize(lv, 0, "xfs")
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.fs_get_mountpoint(lv), mountpoint)
+
+        succ = BlockDev.fs_release_temp_mounts()
+        self.assertTrue(succ)
+        self.assertIsNone(BlockDev.fs_get_mountpoint(lv))
+        self.assertFalse(os.path.exists(mountpoint))
+
+        fi = BlockDev.fs_xfs_get_info(lv)
+        self.assertTrue(fi)
+        self.assertEqual(fi.block_size * fi.block_count, 400 * 1024**2)
+
     def _can_resize_f2fs(self):
         ret, out, _err = utils.run_command("resize.f2fs -V")
         if ret != 0:
@@ -1225,6 +1563,53 @@ class GenericGetFreeSpace(GenericTestCase):
             BlockDev.fs_get_free_space(self.loop_dev)
 
 
+class GenericGetUsageMany(GenericTestCase):
+    def test_get_usage_many(self):
+        """Test getting size and free space of multiple file systems at once"""
+
+        succ = BlockDev.fs_ext4_mkfs(self.loop_dev, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.fs_xfs_mkfs(self.loop_dev2, None)
+        self.assertTrue(succ)
+
+        ext4_size = BlockDev.fs_get_size(self.loop_dev)
+        ext4_free = BlockDev.fs_get_free_space(self.loop_dev)
+        xfs_size = BlockDev.fs_get_size(self.loop_dev2)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.fs_get_usage_many(None, 0)
+
+        usage = BlockDev.fs_get_usage_many([self.loop_dev, self.loop_dev2, "/non/existing/device"], 2)
+        self.assertEqual(len(usage), 3)
+
+        self.assertEqual(usage[0].device, self.loop_dev)
+        self.assertEqual(usage[0].fstype, "ext4")
+        self.assertFalse(usage[0].mounted)
+        self.assertIsNone(usage[0].error)
+        self.assertEqual(usage[0].size, ext4_size)
+        self.assertEqual(usage[0].free_space, ext4_free)
+
+        # free space is not available for unmounted XFS
+        self.assertEqual(usage[1].fstype, "xfs")
+        self.assertIsNone(usage[1].error)
+        self.assertEqual(usage[1].size, xfs_size)
+        self.assertEqual(usage[1].free_space, 0)
+
+        self.assertIsNotNone(usage[2].error)
+
+        # mounted file systems are queried with statvfs
+        with mounted(self.loop_dev2, self.mount_dir):
+            usage = BlockDev.fs_get_usage_many([self.loop_dev2], 0)
+            stat = os.statvfs(self.mount_dir)
+        self.assertTrue(usage[0].mounted)
+        self.assertEqual(usage[0].fstype, "xfs")
+        self.assertIsNone(usage[0].error)
+        self.assertEqual(usage[0].size, stat.f_blocks * stat.f_frsize)
+        self.assertNotEqual(usage[0].free_space, 0)
+        self.assertLessEqual(usage[0].free_space, usage[0].size)
+
+
 class GenericGetMinSize(GenericTestCase):
     def _test_get_min_size(self, mkfs_function, fstype):
         # clean the device
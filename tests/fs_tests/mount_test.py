@@ -60,6 +60,9 @@ class MountTestCase(FSTestCase):
         mnt = BlockDev.fs_get_mountpoint(self.loop_dev)
         self.assertEqual(mnt, tmp)
 
+        mnts = BlockDev.fs_get_mountpoints([self.loop_dev, "/dev/nonexisting"])
+        self.assertEqual(mnts, [tmp, ""])
+
         succ = BlockDev.fs_unmount(self.loop_dev, False, False, None)
         self.assertTrue(succ)
         self.assertFalse(os.path.ismount(tmp))
@@ -70,6 +73,16 @@ class MountTestCase(FSTestCase):
         mnt = BlockDev.fs_get_mountpoint(self.loop_dev)
         self.assertIsNone(mnt)
 
+        # mounted and unmounted behind our back
+        ret, _out, _err = utils.run_command("mount %s %s" % (self.loop_dev, tmp))
+        self.assertEqual(ret, 0)
+        self.assertEqual(BlockDev.fs_get_mountpoint(self.loop_dev), tmp)
+        self.assertTrue(BlockDev.fs_is_mountpoint(tmp))
+        ret, _out, _err = utils.run_command("umount %s" % tmp)
+        self.assertEqual(ret, 0)
+        self.assertIsNone(BlockDev.fs_get_mountpoint(self.loop_dev))
+        self.assertFalse(BlockDev.fs_is_mountpoint(tmp))
+
         # mount again to test unmount using the mountpoint
         succ = BlockDev.fs_mount(self.loop_dev, tmp, None, None)
         self.assertTrue(succ)
@@ -199,6 +212,10 @@ class MountTestCase(FSTestCase):
         self.assertTrue(succ)
         self.assertTrue(os.path.ismount(tmp))
 
+        # only the thread doing the mount should have been running as the user
+        self.assertEqual(os.getuid(), 0)
+        self.assertEqual(os.getgid(), 0)
+
         succ = BlockDev.fs_unmount(self.loop_dev, run_as_uid=uid, run_as_gid=gid)
         self.assertTrue(succ)
         self.assertFalse(os.path.ismount(tmp))
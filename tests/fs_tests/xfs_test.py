@@ -176,6 +176,35 @@ class XfsGetInfo(XfsTestCase):
         # should be an non-empty string
         self.assertTrue(fi.uuid)
 
+    def test_xfs_get_info_superblock(self):
+        """Verify that info read from the superblock matches the xfs tools"""
+
+        uuid = "b8f3e4f2-7f5a-4c2b-9b7e-2b1a2c3d4e5f"
+        ret, _out, _err = utils.run_command("mkfs.xfs -f -b size=2048 -L xfsLabel -m uuid=%s %s" % (uuid, self.loop_dev))
+        self.assertEqual(ret, 0)
+
+        fi = BlockDev.fs_xfs_get_info(self.loop_dev)
+        self.assertEqual(fi.block_size, 2048)
+        self.assertEqual(fi.block_count, self.loop_size / 2048)
+        self.assertEqual(fi.label, "xfsLabel")
+        self.assertEqual(fi.uuid, uuid)
+
+        out = check_output(["xfs_db", "-r", "-c", "sb 0", "-c", "p dblocks", self.loop_dev])
+        self.assertEqual(fi.block_count, int(out.decode().split("=")[1]))
+
+        # mounted file system uses the geometry ioctl instead
+        with mounted(self.loop_dev, self.mount_dir):
+            mfi = BlockDev.fs_xfs_get_info(self.loop_dev)
+        self.assertEqual(mfi.block_size, fi.block_size)
+        self.assertEqual(mfi.block_count, fi.block_count)
+        self.assertEqual(mfi.label, fi.label)
+        self.assertEqual(mfi.uuid, fi.uuid)
+
+        # not an xfs superblock -- falls back to xfs_db which fails
+        utils.run("wipefs -a %s >/dev/null 2>&1" % self.loop_dev)
+        with self.assertRaises(GLib.GError):
+            BlockDev.fs_xfs_get_info(self.loop_dev)
+
 
 class XfsSetLabel(XfsTestCase):
     def test_xfs_set_label(self):
@@ -96,6 +96,41 @@ class LibraryOpsTestCase(unittest.TestCase):
         # loaded again
         self.assertTrue(BlockDev.md_canonicalize_uuid("3386ff85:f5012621:4a435f06:1eb47236"))
 
+    @tag_test(TestTags.CORE)
+    def test_lazy_init(self):
+        """Verify that loading plugins on demand works as expected"""
+
+        self.addCleanup(BlockDev.reinit, self.requested_plugins, True, None)
+        self.addCleanup(BlockDev.set_init_flags, BlockDev.InitFlags.NONE)
+
+        BlockDev.set_init_flags(BlockDev.InitFlags.LAZY)
+        plugins = BlockDev.plugin_specs_from_names(["swap", "mdraid"])
+        self.assertTrue(BlockDev.reinit(plugins, True, None))
+        self.assertTrue(BlockDev.is_initialized())
+
+        # the plugin gets loaded by the first call of its function
+        self.assertTrue(BlockDev.md_canonicalize_uuid("3386ff85:f5012621:4a435f06:1eb47236"))
+        self.assertTrue(BlockDev.is_plugin_available(BlockDev.Plugin.MDRAID))
+        self.assertEqual(set(BlockDev.get_available_plugin_names()), set(["swap", "mdraid"]))
+
+        # not requested plugin is still not available
+        self.assertFalse(BlockDev.is_plugin_available(BlockDev.Plugin.CRYPTO))
+        with self.assertRaises(GLib.GError):
+            BlockDev.crypto_generate_backup_passphrase()
+
+    @tag_test(TestTags.CORE)
+    def test_parallel_init(self):
+        """Verify that loading plugins in parallel works as expected"""
+
+        self.addCleanup(BlockDev.reinit, self.requested_plugins, True, None)
+        self.addCleanup(BlockDev.set_init_flags, BlockDev.InitFlags.NONE)
+
+        BlockDev.set_init_flags(BlockDev.InitFlags.PARALLEL)
+        self.assertTrue(BlockDev.reinit(self.requested_plugins, True, None))
+        self.assertEqual(set(BlockDev.get_available_plugin_names()),
+                         set(["crypto", "dm", "loop", "mdraid", "part", "swap"]))
+        self.assertTrue(BlockDev.md_canonicalize_uuid("3386ff85:f5012621:4a435f06:1eb47236"))
+
     def test_ensure_init(self):
         """Verify that ensure_init just returns when already initialized"""
 
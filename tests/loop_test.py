@@ -131,6 +131,43 @@ class LoopTestSetupSectorSize(LoopTestCase):
             self.assertEqual(f.read().strip(), "4096")
 
 
+class LoopTestSetupFlags(LoopTestCase):
+    def test_loop_setup_with_flags(self):
+        """Verify that loop_setup_with_flags works as expected"""
+        flags = BlockDev.LoopSetupFlags.READ_ONLY | BlockDev.LoopSetupFlags.PART_SCAN
+        succ, self.loop = BlockDev.loop_setup_with_flags(self.dev_file, flags=flags, sector_size=4096)
+        self.assertTrue(succ)
+        self.assertTrue(self.loop)
+
+        info = BlockDev.loop_info(self.loop)
+        self.assertTrue(info.read_only)
+        self.assertTrue(info.part_scan)
+        self.assertFalse(info.direct_io)
+        with open("/sys/block/%s/queue/logical_block_size" % self.loop, "r") as f:
+            self.assertEqual(f.read().strip(), "4096")
+
+        succ = BlockDev.loop_teardown(self.loop)
+        self.assertTrue(succ)
+        self.loop = None
+
+    def test_loop_setup_direct_io(self):
+        """Verify that loop_setup_with_flags with direct I/O works as expected"""
+        try:
+            succ, self.loop = BlockDev.loop_setup_with_flags(self.dev_file, flags=BlockDev.LoopSetupFlags.DIRECT_IO,
+                                                             sector_size=4096)
+        except GLib.GError as e:
+            if "Failed to enable direct I/O" in str(e):
+                self.skipTest("Direct I/O not supported for the backing file")
+            raise
+        self.assertTrue(succ)
+        self.assertTrue(self.loop)
+
+        info = BlockDev.loop_info(self.loop)
+        self.assertTrue(info.direct_io)
+        with open("/sys/block/%s/loop/dio" % self.loop, "r") as f:
+            self.assertEqual(f.read().strip(), "1")
+
+
 class LoopTestSetupPartprobe(LoopTestCase):
     def test_loop_setup_partprobe(self):
         """Verify that loop_setup with part_scan specified works as expected"""
@@ -165,6 +202,74 @@ class LoopTestSetupPartprobe(LoopTestCase):
         self.assertTrue(succ)
 
 
+class LoopTestSetupMany(LoopTestCase):
+    def setUp(self):
+        super(LoopTestSetupMany, self).setUp()
+        self.dev_files = [self.dev_file]
+        for _i in range(3):
+            dev_file = create_sparse_tempfile("loop_test", 100 * 1024**2)
+            self.addCleanup(os.unlink, dev_file)
+            self.dev_files.append(dev_file)
+        self.loops = []
+        self.addCleanup(self._clean_up_many)
+
+    def _clean_up_many(self):
+        for loop in self.loops:
+            try:
+                BlockDev.loop_teardown(loop)
+            except:
+                pass
+
+    def test_loop_setup_teardown_many(self):
+        """Verify that setting up and tearing down multiple loop devices at once works as expected"""
+
+        results = BlockDev.loop_setup_many(self.dev_files + ["/non/existing"])
+        self.assertEqual(len(results), len(self.dev_files) + 1)
+        self.loops = [r.name for r in results if r.success]
+
+        for result, dev_file in zip(results, self.dev_files):
+            self.assertEqual(result.file, dev_file)
+            self.assertTrue(result.success)
+            self.assertIsNone(result.error)
+            self.assertTrue(os.path.exists("/dev/" + result.name))
+
+            info = BlockDev.loop_info(result.name)
+            self.assertEqual(info.backing_file, dev_file)
+            self.assertTrue(info.part_scan)
+
+        # concurrent setups must not get the same device
+        self.assertEqual(len(set(self.loops)), len(self.dev_files))
+
+        # a failure doesn't affect the other files
+        self.assertEqual(results[-1].file, "/non/existing")
+        self.assertFalse(results[-1].success)
+        self.assertIsNone(results[-1].name)
+        self.assertIn("Failed to open the backing file", results[-1].error.message)
+
+        results = BlockDev.loop_teardown_many(self.loops + ["/dev/non-existing"])
+        self.assertEqual(len(results), len(self.loops) + 1)
+        for result, loop in zip(results, self.loops):
+            self.assertEqual(result.loop, loop)
+            self.assertTrue(result.success)
+        self.assertFalse(results[-1].success)
+        self.assertIsNotNone(results[-1].error)
+
+        self.loops = []
+
+        # read-only and sequentially
+        results = BlockDev.loop_setup_many(self.dev_files, BlockDev.LoopSetupFlags.READ_ONLY, max_workers=1)
+        self.loops = [r.name for r in results if r.success]
+        self.assertEqual(len(set(self.loops)), len(self.dev_files))
+        for loop in self.loops:
+            info = BlockDev.loop_info(loop)
+            self.assertTrue(info.read_only)
+            self.assertFalse(info.part_scan)
+
+        results = BlockDev.loop_teardown_many(self.loops, max_workers=1)
+        self.assertTrue(all(r.success for r in results))
+        self.loops = []
+
+
 class LoopTestGetLoopName(LoopTestCase):
     @tag_test(TestTags.CORE)
     def test_loop_get_loop_name(self):
@@ -179,6 +284,22 @@ class LoopTestGetLoopName(LoopTestCase):
         ret_loop = BlockDev.loop_get_loop_name(self.dev_file)
         self.assertEqual(ret_loop, self.loop)
 
+        # a symlink to the backing file is matched by its inode
+        link = self.dev_file + ".link"
+        os.symlink(self.dev_file, link)
+        self.addCleanup(os.unlink, link)
+        ret_loop = BlockDev.loop_get_loop_name(link)
+        self.assertEqual(ret_loop, self.loop)
+
+        ret_loops = BlockDev.loop_get_loop_names([self.dev_file, "/non/existing", link])
+        self.assertEqual(ret_loops, [self.loop, "", self.loop])
+
+        infos = BlockDev.loop_list()
+        info = next((i for i in infos if i.name == self.loop), None)
+        self.assertIsNotNone(info)
+        self.assertEqual(info.backing_file, self.dev_file)
+        self.assertEqual(info.offset, 0)
+
 
 class LoopTestGetSetAutoclear(LoopTestCase):
     def test_loop_get_set_autoclear(self):
@@ -5,6 +5,7 @@ import math
 import overrides_hack
 import re
 import shutil
+import threading
 import time
 from contextlib import contextmanager
 from packaging.version import Version
@@ -313,6 +314,39 @@ class LvmNoDevTestCase(LVMTestCase):
         succ = BlockDev.lvm_set_devices_filter(None)
         self.assertTrue(succ)
 
+    @tag_test(TestTags.NOSTORAGE)
+    def test_get_set_persistent_shell(self):
+        """Verify that persistent lvm shell is not supported by the DBus plugin"""
+
+        self.assertFalse(BlockDev.lvm_get_persistent_shell())
+
+        with self.assertRaisesRegex(GLib.GError, "not supported"):
+            BlockDev.lvm_set_persistent_shell(True)
+        self.assertFalse(BlockDev.lvm_get_persistent_shell())
+
+        succ = BlockDev.lvm_set_persistent_shell(False)
+        self.assertTrue(succ)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_pvmove_start(self):
+        """Verify that background pvmove is not supported by the DBus plugin"""
+
+        with self.assertRaisesRegex(GLib.GError, "not supported"):
+            BlockDev.lvm_pvmove_start("/dev/sda", None, None)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_get_set_auto_devices(self):
+        """Verify that automatic devices scoping is not supported by the DBus plugin"""
+
+        self.assertFalse(BlockDev.lvm_get_auto_devices())
+
+        with self.assertRaisesRegex(GLib.GError, "not supported"):
+            BlockDev.lvm_set_auto_devices(True)
+        self.assertFalse(BlockDev.lvm_get_auto_devices())
+
+        succ = BlockDev.lvm_set_auto_devices(False)
+        self.assertTrue(succ)
+
     @tag_test(TestTags.NOSTORAGE)
     def test_cache_get_default_md_size(self):
         """Verify that default cache metadata size is calculated properly"""
@@ -1057,6 +1091,55 @@ class LvmTestLVactivateDeactivate(LvmPVVGLVTestCase):
         succ = BlockDev.lvm_lvdeactivate("testVG", "testLV", None)
         self.assertTrue(succ)
 
+    def test_lvactivate_lvdeactivate_many(self):
+        """Verify it's possible to (de)activate multiple LVs at once"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 256 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV2", 256 * 1024**2, None, [self.loop_dev2], None)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_lvremove, "testVG", "testLV2", True, None)
+
+        succ = BlockDev.lvm_add_lv_tags("testVG", "testLV2", ["bulk"])
+        self.assertTrue(succ)
+
+        def active(lv_name):
+            return BlockDev.lvm_lvinfo("testVG", lv_name).attr[4] == "a"
+
+        # nothing to do
+        succ = BlockDev.lvm_lvdeactivate_many([], None)
+        self.assertTrue(succ)
+
+        # all LVs in the VG
+        succ = BlockDev.lvm_lvdeactivate_many(["testVG"], None)
+        self.assertTrue(succ)
+        self.assertFalse(active("testLV"))
+        self.assertFalse(active("testLV2"))
+
+        # by name and by tag
+        succ = BlockDev.lvm_lvactivate_many(["testVG/testLV", "@bulk"], False, False, None)
+        self.assertTrue(succ)
+        self.assertTrue(active("testLV"))
+        self.assertTrue(active("testLV2"))
+
+        succ = BlockDev.lvm_lvdeactivate_many(["@bulk"], None)
+        self.assertTrue(succ)
+        self.assertTrue(active("testLV"))
+        self.assertFalse(active("testLV2"))
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_lvactivate_many(["testVG/testLV2", "testVG/nonexistingLV"], False, False, None)
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmTestLVresize(LvmPVVGLVTestCase):
     def test_lvresize(self):
@@ -1222,6 +1305,136 @@ class LvmTestLVs(LvmPVVGLVTestCase):
         lvs = BlockDev.lvm_lvs("testVG")
         self.assertEqual(len(lvs), 1)
 
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmTestObjectsCache(LvmPVVGLVTestCase):
+    def _clean_up(self):
+        try:
+            BlockDev.lvm_lvremove("testVG", "testLV2", True, None)
+        except:
+            pass
+
+        LvmPVVGLVTestCase._clean_up(self)
+
+    def _wait_for_lvs(self, check, timeout=10):
+        # external changes are only seen once lvmdbusd notices them and sends the signals
+        for _i in range(timeout * 10):
+            lvs = BlockDev.lvm_lvs("testVG")
+            if check(lvs):
+                return lvs
+            time.sleep(0.1)
+        return BlockDev.lvm_lvs("testVG")
+
+    def test_cache_plugin_changes(self):
+        """Verify that listings reflect changes made by the plugin"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev], 0, None)
+        self.assertTrue(succ)
+
+        # populate the cache
+        lvs = BlockDev.lvm_lvs("testVG")
+        self.assertEqual(len(lvs), 0)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 256 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        lvs = BlockDev.lvm_lvs("testVG")
+        self.assertEqual([lv.lv_name for lv in lvs], ["testLV"])
+        self.assertEqual(lvs[0].size, 256 * 1024**2)
+
+        succ = BlockDev.lvm_lvresize("testVG", "testLV", 512 * 1024**2, None)
+        self.assertTrue(succ)
+
+        lvs = BlockDev.lvm_lvs("testVG")
+        self.assertEqual(len(lvs), 1)
+        self.assertEqual(lvs[0].size, 512 * 1024**2)
+
+        succ = BlockDev.lvm_lvrename("testVG", "testLV", "testLV2", None)
+        self.assertTrue(succ)
+
+        lvs = BlockDev.lvm_lvs("testVG")
+        self.assertEqual([lv.lv_name for lv in lvs], ["testLV2"])
+
+        succ = BlockDev.lvm_lvremove("testVG", "testLV2", True, None)
+        self.assertTrue(succ)
+
+        lvs = BlockDev.lvm_lvs("testVG")
+        self.assertEqual(len(lvs), 0)
+
+        # the VG info is cached too
+        vgs = BlockDev.lvm_vgs()
+        self.assertTrue(any(vg.name == "testVG" and vg.free == vg.size for vg in vgs))
+
+    def test_cache_external_changes(self):
+        """Verify that listings reflect changes made outside of the plugin"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev], 0, None)
+        self.assertTrue(succ)
+
+        # populate the cache
+        lvs = BlockDev.lvm_lvs("testVG")
+        self.assertEqual(len(lvs), 0)
+
+        ret, _out, err = run_command("lvcreate -n testLV -L 256M -y testVG")
+        self.assertEqual(ret, 0, msg=err)
+
+        lvs = self._wait_for_lvs(lambda lvs: len(lvs) == 1)
+        self.assertEqual([lv.lv_name for lv in lvs], ["testLV"])
+
+        ret, _out, err = run_command("lvremove -y testVG/testLV")
+        self.assertEqual(ret, 0, msg=err)
+
+        lvs = self._wait_for_lvs(lambda lvs: len(lvs) == 0)
+        self.assertEqual(len(lvs), 0)
+
+    def test_cache_parallel_listings(self):
+        """Verify that listings running in parallel with changes work"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev], 0, None)
+        self.assertTrue(succ)
+
+        errors = []
+        stop = threading.Event()
+
+        def list_lvs():
+            try:
+                while not stop.is_set():
+                    for lv in BlockDev.lvm_lvs("testVG"):
+                        self.assertIn(lv.lv_name, ("testLV", "testLV2"))
+                    BlockDev.lvm_report_all()
+            except Exception as e:  # pylint: disable=broad-except
+                errors.append(e)
+
+        threads = [threading.Thread(target=list_lvs) for _i in range(4)]
+        for thread in threads:
+            thread.start()
+
+        try:
+            for _i in range(3):
+                succ = BlockDev.lvm_lvcreate("testVG", "testLV", 64 * 1024**2, None, [self.loop_dev], None)
+                self.assertTrue(succ)
+                succ = BlockDev.lvm_lvcreate("testVG", "testLV2", 64 * 1024**2, None, [self.loop_dev], None)
+                self.assertTrue(succ)
+                succ = BlockDev.lvm_lvremove("testVG", "testLV", True, None)
+                self.assertTrue(succ)
+                succ = BlockDev.lvm_lvremove("testVG", "testLV2", True, None)
+                self.assertTrue(succ)
+        finally:
+            stop.set()
+            for thread in threads:
+                thread.join()
+
+        self.assertEqual(errors, [])
+        self.assertEqual(len(BlockDev.lvm_lvs("testVG")), 0)
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmTestLVsMultiSegment(LvmPVVGLVTestCase):
     def _clean_up(self):
@@ -1277,6 +1490,24 @@ class LvmTestLVsMultiSegment(LvmPVVGLVTestCase):
         self.assertEqual(len(lvs), 2)
         self.assertListEqual([lv.lv_name for lv in lvs], ["testLV", "testLV2"])
 
+        # the duplicate entries are skipped when iterating over the LVs too
+        names = []
+        def collect(lv, data):
+            data.append(lv.lv_name)
+            return True
+        succ = BlockDev.lvm_lvs_foreach("testVG", collect, names)
+        self.assertTrue(succ)
+        self.assertListEqual(sorted(names), ["testLV", "testLV2"])
+
+        # stopping the iteration after the first LV
+        names = []
+        def collect_one(lv, data):
+            data.append(lv.lv_name)
+            return False
+        succ = BlockDev.lvm_lvs_foreach("testVG", collect_one, names)
+        self.assertTrue(succ)
+        self.assertEqual(len(names), 1)
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmPVVGthpoolTestCase(LvmPVVGTestCase):
     def _clean_up(self):
@@ -1351,6 +1582,20 @@ class LvmTestPartialLVs(LvmPVVGLVTestCase):
 
         assert_raid1_structure(self.loop_dev, self.loop_dev2)
 
+        # the result set gives the same information as lvs_tree
+        lvs = BlockDev.lvm_lvs_tree("testVG")
+        result_set = BlockDev.lvm_lvs_tree_result_set("testVG")
+        self.assertEqual(result_set.n_lvs, len(lvs))
+        for i, lv in enumerate(lvs):
+            item = BlockDev.lvm_lv_result_set_get(result_set, i)
+            self.assertEqual(item.lv_name, lv.lv_name)
+            self.assertEqual(item.uuid, lv.uuid)
+            self.assertEqual(item.size, lv.size)
+            self.assertEqual(item.data_lvs, lv.data_lvs)
+            self.assertEqual(item.metadata_lvs, lv.metadata_lvs)
+            self.assertEqual([seg.pvdev for seg in item.segs], [seg.pvdev for seg in lv.segs])
+        self.assertIsNone(BlockDev.lvm_lv_result_set_get(result_set, len(lvs)))
+
         # Disconnect the second PV, this should cause it to be flagged
         # as missing, and testLV to be reported as "partial".
         delete_lio_device(self.loop_dev2)
@@ -1410,6 +1655,59 @@ class LvmTestLVsAll(LvmPVVGthpoolTestCase):
         lvs = BlockDev.lvm_lvs("testVG")
         self.assertGreater(len(lvs), 3)
 
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmTestReportAll(LvmPVVGthpoolTestCase):
+    def test_report_all(self):
+        """Verify that info about all PVs, VGs and LVs is gathered at once"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thpoolcreate("testVG", "testPool", 512 * 1024**2, 4 * 1024**2, 512 * 1024, "thin-performance", None)
+        self.assertTrue(succ)
+
+        report = BlockDev.lvm_report_all()
+        self.assertIsNotNone(report)
+
+        # the report should give the same data as the separate calls
+        pvs = {pv.pv_name: pv for pv in BlockDev.lvm_pvs()}
+        report_pvs = {pv.pv_name: pv for pv in report.pvs}
+        self.assertEqual(set(pvs.keys()), set(report_pvs.keys()))
+        for dev in (self.loop_dev, self.loop_dev2):
+            self.assertEqual(report_pvs[dev].pv_uuid, pvs[dev].pv_uuid)
+            self.assertEqual(report_pvs[dev].pv_size, pvs[dev].pv_size)
+            self.assertEqual(report_pvs[dev].vg_name, "testVG")
+            self.assertEqual(report_pvs[dev].vg_size, pvs[dev].vg_size)
+            self.assertEqual(report_pvs[dev].vg_pv_count, 2)
+
+        vgs = {vg.name: vg for vg in BlockDev.lvm_vgs()}
+        report_vgs = {vg.name: vg for vg in report.vgs}
+        self.assertEqual(set(vgs.keys()), set(report_vgs.keys()))
+        self.assertEqual(report_vgs["testVG"].uuid, vgs["testVG"].uuid)
+        self.assertEqual(report_vgs["testVG"].size, vgs["testVG"].size)
+        self.assertEqual(report_vgs["testVG"].free, vgs["testVG"].free)
+        self.assertEqual(report_vgs["testVG"].pv_count, 2)
+
+        lvs = {(lv.vg_name, lv.lv_name): lv for lv in BlockDev.lvm_lvs_tree(None)}
+        report_lvs = {(lv.vg_name, lv.lv_name): lv for lv in report.lvs}
+        self.assertEqual(set(lvs.keys()), set(report_lvs.keys()))
+        for key, lv in lvs.items():
+            self.assertEqual(report_lvs[key].uuid, lv.uuid)
+            self.assertEqual(report_lvs[key].size, lv.size)
+            self.assertEqual(report_lvs[key].segtype, lv.segtype)
+            self.assertEqual(report_lvs[key].attr, lv.attr)
+
+        pool = report_lvs[("testVG", "testPool")]
+        self.assertEqual(pool.segtype, "thin-pool")
+        self.assertEqual(pool.data_lv, "testPool_tdata")
+        self.assertEqual(pool.metadata_lv, "testPool_tmeta")
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmTestThpoolCreate(LvmPVVGthpoolTestCase):
     @tag_test(TestTags.CORE)
@@ -1583,6 +1881,47 @@ class LvmTestThSnapshotCreate(LvmPVVGLVthLVsnapshotTestCase):
         self.assertIn("snapshot", info.roles.split(","))
         self.assertIn("thinsnapshot", info.roles.split(","))
 
+    def test_thsnapshotcreate_many(self):
+        """Verify that it is possible to create multiple thin LV snapshots at once"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thpoolcreate("testVG", "testPool", 512 * 1024**2, 4 * 1024**2, 512 * 1024, None, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thlvcreate("testVG", "testPool", "testThLV", 1024**3, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thlvcreate("testVG", "testPool", "testThLV2", 1024**3, None)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_lvremove, "testVG", "testThLV2", True, None)
+
+        with self.assertRaisesRegex(GLib.GError, "doesn't match"):
+            BlockDev.lvm_thsnapshotcreate_many("testVG", ["testThLV", "testThLV2"], ["testThLV_bak"], None, None)
+
+        # the second snapshot cannot be created, the first one should be removed
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_thsnapshotcreate_many("testVG", ["testThLV", "nonexistingLV"],
+                                               ["testThLV_bak", "testThLV2_bak"], None, None)
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_lvinfo("testVG", "testThLV_bak")
+
+        succ = BlockDev.lvm_thsnapshotcreate_many("testVG", ["testThLV", "testThLV2"],
+                                                  ["testThLV_bak", "testThLV2_bak"], "testPool", None)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_lvremove, "testVG", "testThLV2_bak", True, None)
+
+        for snap in ("testThLV_bak", "testThLV2_bak"):
+            info = BlockDev.lvm_lvinfo("testVG", snap)
+            self.assertIn("thinsnapshot", info.roles.split(","))
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmPVVGLVcachePoolTestCase(LvmPVVGLVTestCase):
     def _clean_up(self):
@@ -1690,6 +2029,42 @@ class LvmPVVGLVcachePoolAttachDetachTestCase(LvmPVVGLVcachePoolTestCase):
         lvs = BlockDev.lvm_lvs("testVG")
         self.assertTrue(any(info.lv_name == "testCache" for info in lvs))
 
+@unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
+class LvmPVVGLVcacheSettingsTestCase(LvmPVVGLVcachePoolTestCase):
+    @tag_test(TestTags.SLOW)
+    def test_cache_attach_with_settings(self):
+        """Verify that it is possible to attach a cache pool with settings"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_cache_create_pool("testVG", "testCache", 512 * 1024**2, 0, BlockDev.LVMCacheMode.WRITETHROUGH, 0, [self.loop_dev2])
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 512 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        settings = BlockDev.LVMCacheSettings(high_watermark=50)
+        with self.assertRaisesRegex(GLib.GError, "Writecache settings"):
+            BlockDev.lvm_cache_attach_with_settings("testVG", "testLV", "testCache", settings)
+
+        settings = BlockDev.LVMCacheSettings(chunk_size=256 * 1024, migration_threshold=4 * 1024**2, policy="smq")
+        succ = BlockDev.lvm_cache_attach_with_settings("testVG", "testLV", "testCache", settings)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("lvs --noheadings --units b --nosuffix -o chunk_size,cache_policy,cache_settings testVG/testLV")
+        self.assertEqual(out.split(), ["262144", "smq", "migration_threshold=8192"])
+
+        # not supported by lvmdbusd
+        with self.assertRaisesRegex(GLib.GError, "not supported"):
+            BlockDev.lvm_cache_set_settings("testVG", "testLV", settings)
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmPVVGcachedLVTestCase(LvmPVVGLVTestCase):
     @tag_test(TestTags.SLOW)
@@ -1827,6 +2202,14 @@ class LvmPVVGWritecachedLVTestCase(LvmPVVGLVTestCase):
         self.assertIsNotNone(info)
         self.assertEqual(info.segtype, "writecache")
 
+        sampler = BlockDev.lvm_cache_sampler_new("testVG", "testLV")
+        self.assertIsNotNone(sampler)
+
+        sample = BlockDev.lvm_cache_sampler_sample(sampler)
+        self.assertIsNotNone(sample)
+        self.assertTrue(sample.writecache)
+        self.assertEqual(sample.promotions, 0)
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LvmPVVGcachedLVstatsTestCase(LvmPVVGLVTestCase):
     @tag_test(TestTags.SLOW)
@@ -1857,6 +2240,21 @@ class LvmPVVGcachedLVstatsTestCase(LvmPVVGLVTestCase):
         self.assertEqual(stats.md_size, 8 * 1024**2)
         self.assertEqual(stats.mode, BlockDev.LVMCacheMode.WRITETHROUGH)
 
+        sampler = BlockDev.lvm_cache_sampler_new("testVG", "testLV")
+        self.assertIsNotNone(sampler)
+        self.assertEqual(sampler.map_name, "testVG-testLV")
+
+        # generate some reads for the deltas
+        run_command("dd if=/dev/testVG/testLV of=/dev/null bs=1M count=16 iflag=direct")
+
+        sample = BlockDev.lvm_cache_sampler_sample(sampler)
+        self.assertIsNotNone(sample)
+        self.assertFalse(sample.writecache)
+        self.assertGreater(sample.interval, 0)
+        self.assertGreater(sample.read_hits_delta + sample.read_misses_delta, 0)
+        self.assertGreaterEqual(sample.read_hits, sample.read_hits_delta)
+        self.assertTrue(0 <= sample.read_hit_ratio <= 1)
+
 class LvmPVVGcachedThpoolstatsTestCase(LvmPVVGLVTestCase):
     @tag_test(TestTags.SLOW)
     def test_cache_get_stats(self):
@@ -2023,6 +2421,40 @@ class LvmTestLVTags(LvmPVVGLVTestCase):
         self.assertTrue(info)
         self.assertEqual(info.lv_tags, ["c", "e"])
 
+    def test_batch_run(self):
+        """Verify that it's possible to run independent LV operations in a batch"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev], 0, None)
+        self.assertTrue(succ)
+
+        for name in ("testLV1", "testLV2", "testLV3"):
+            succ = BlockDev.lvm_lvcreate("testVG", name, 32 * 1024**2, None, [self.loop_dev], None)
+            self.assertTrue(succ)
+
+        ops = [BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_ADD_TAGS, "testVG", "testLV1", None, ["a", "b"]),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_ADD_TAGS, "testVG", "testLV2", None, ["c"]),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_RENAME, "testVG", "testLV3", "testLV4", None),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_RENAME, "testVG", "nonexistingLV", "testLV5", None),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_DELETE_TAGS, "testVG", "testLV1", None, None)]
+        results = BlockDev.lvm_batch_run(ops, 0)
+        self.assertEqual(len(results), len(ops))
+
+        # only the operations on the nonexisting LV and without tags should fail
+        self.assertEqual([r.success for r in results], [True, True, True, False, False])
+        self.assertIsNone(results[0].error)
+        self.assertIsNotNone(results[3].error)
+        self.assertIsNotNone(results[4].error)
+
+        info = BlockDev.lvm_lvinfo("testVG", "testLV1")
+        self.assertEqual(info.lv_tags, ["a", "b"])
+        info = BlockDev.lvm_lvinfo("testVG", "testLV2")
+        self.assertEqual(info.lv_tags, ["c"])
+        info = BlockDev.lvm_lvinfo("testVG", "testLV4")
+        self.assertTrue(info)
+
 @unittest.skipUnless(lvm_dbus_running, "LVM DBus not running")
 class LVMVDOTest(LVMTestCase):
 
@@ -2151,6 +2583,29 @@ class LVMVDOTest(LVMTestCase):
         pool_info = BlockDev.lvm_lvinfo("testVDOVG", pool_name)
         self.assertEqual(pool_info.segtype, "vdo-pool")
 
+    @tag_test(TestTags.SLOW)
+    def test_vdo_pool_create_settings(self):
+        settings = BlockDev.LVMVDOSettings(ack_threads=2, bio_threads=2, cpu_threads=4, hash_zone_threads=2,
+                                           logical_threads=2, physical_threads=2, slab_size=512 * 1024**2)
+        succ = BlockDev.lvm_vdo_pool_create_with_settings("testVDOVG", "vdoLV", "vdoPool", 7 * 1024**3, 35 * 1024**3,
+                                                          settings=settings)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("lvs --noheadings --units b --nosuffix -o vdo_cpu_threads,vdo_logical_threads,vdo_slab_size testVDOVG/vdoPool")
+        self.assertEqual(out.split(), ["4", "2", str(512 * 1024**2)])
+
+        # invalid settings
+        with self.assertRaisesRegex(GLib.GError, "slab size"):
+            BlockDev.lvm_vdo_pool_create_with_settings("testVDOVG", "vdoLV2", "vdoPool2", 7 * 1024**3, 35 * 1024**3,
+                                                       settings=BlockDev.LVMVDOSettings(slab_size=100 * 1024**2))
+        with self.assertRaisesRegex(GLib.GError, "logical threads"):
+            BlockDev.lvm_vdo_pool_create_with_settings("testVDOVG", "vdoLV2", "vdoPool2", 7 * 1024**3, 35 * 1024**3,
+                                                       settings=BlockDev.LVMVDOSettings(logical_threads=100))
+
+        # not supported over D-Bus
+        with self.assertRaisesRegex(GLib.GError, "not supported"):
+            BlockDev.lvm_vdo_pool_set_settings("testVDOVG", "vdoPool", BlockDev.LVMVDOSettings(cpu_threads=2))
+
     @tag_test(TestTags.SLOW)
     def test_resize(self):
         succ = BlockDev.lvm_vdo_pool_create("testVDOVG", "vdoLV", "vdoPool", 5 * 1024**3, 10 * 1024**3)
@@ -2254,6 +2709,16 @@ class LVMVDOTest(LVMTestCase):
         full_stats = BlockDev.lvm_vdo_get_stats_full("testVDOVG", "vdoPool")
         self.assertIn("writeAmplificationRatio", full_stats.keys())
 
+        # typed stats must match the full ones
+        self.assertEqual(vdo_stats.block_size, int(full_stats["block_size"]))
+        self.assertEqual(vdo_stats.physical_blocks, int(full_stats["physical_blocks"]))
+        self.assertEqual(vdo_stats.used_percent, int(full_stats["usedPercent"]))
+        self.assertAlmostEqual(vdo_stats.write_amplification_ratio, float(full_stats["writeAmplificationRatio"]), places=2)
+
+        # the statistics files are kept open, reading again must work too
+        vdo_stats = BlockDev.lvm_vdo_get_stats("testVDOVG", "vdoPool")
+        self.assertEqual(vdo_stats.block_size, int(full_stats["block_size"]))
+
 
 class LvmTestDevicesFile(LvmPVonlyTestCase):
     devicefile = "bd_lvm_dbus_tests.devices"
@@ -1,5 +1,6 @@
 from __future__ import division
 import unittest
+import threading
 import os
 import math
 import overrides_hack
@@ -307,6 +308,103 @@ class LvmNoDevTestCase(LVMTestCase):
         succ = BlockDev.lvm_set_devices_filter(None)
         self.assertTrue(succ)
 
+    @tag_test(TestTags.NOSTORAGE)
+    def test_thread_config(self):
+        """Verify that the per-thread LVM config works as expected"""
+
+        # setup logging
+        self.assertTrue(BlockDev.reinit(self.requested_plugins, False, self._store_log))
+
+        errors = []
+        def run_with_thread_config():
+            try:
+                succ = BlockDev.lvm_set_thread_config("backup {backup=0 archive=0}", None)
+                self.assertTrue(succ)
+                BlockDev.lvm_lvs(None)
+                succ = BlockDev.lvm_reset_thread_config()
+                self.assertTrue(succ)
+            except Exception as e:  # pylint: disable=broad-except
+                errors.append(e)
+
+        thread = threading.Thread(target=run_with_thread_config)
+        thread.start()
+        thread.join()
+        self.assertEqual(errors, [])
+        self.assertIn("--config=backup {backup=0 archive=0}", self._log)
+
+        # the global config is not affected
+        self.assertEqual(BlockDev.lvm_get_global_config(), "")
+        self._log = ""
+        BlockDev.lvm_lvs(None)
+        self.assertNotIn("--config=backup {backup=0 archive=0}", self._log)
+
+        # the thread config overrides the global one
+        succ = BlockDev.lvm_set_global_config("backup {backup=0}")
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_set_global_config, None)
+        succ = BlockDev.lvm_set_thread_config("backup {archive=0}", None)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_reset_thread_config)
+        self._log = ""
+        BlockDev.lvm_lvs(None)
+        self.assertIn("--config=backup {archive=0}", self._log)
+        self.assertNotIn("--config=backup {backup=0}", self._log)
+
+        succ = BlockDev.lvm_reset_thread_config()
+        self.assertTrue(succ)
+        self._log = ""
+        BlockDev.lvm_lvs(None)
+        self.assertIn("--config=backup {backup=0}", self._log)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_get_set_persistent_shell(self):
+        """Verify that enabling and disabling the persistent lvm shell works as expected"""
+
+        # setup logging
+        self.assertTrue(BlockDev.reinit(self.requested_plugins, False, self._store_log))
+
+        # disabled by default
+        self.assertFalse(BlockDev.lvm_get_persistent_shell())
+
+        succ = BlockDev.lvm_set_persistent_shell(True)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_set_persistent_shell, False)
+        self.assertTrue(BlockDev.lvm_get_persistent_shell())
+
+        # commands should now go through the shell and give the same results
+        lvs = BlockDev.lvm_lvs(None)
+        self.assertIn("lvm shell: lvs", self._log)
+
+        succ = BlockDev.lvm_set_persistent_shell(False)
+        self.assertTrue(succ)
+        self.assertFalse(BlockDev.lvm_get_persistent_shell())
+
+        self._log = ""
+        self.assertEqual(len(BlockDev.lvm_lvs(None)), len(lvs))
+        self.assertNotIn("lvm shell: lvs", self._log)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_get_set_auto_devices(self):
+        """Verify that enabling and disabling the automatic devices scoping works as expected"""
+        if not self.devices_avail:
+            self.skipTest("skipping LVM automatic devices scoping test: not supported")
+
+        # disabled by default
+        self.assertFalse(BlockDev.lvm_get_auto_devices())
+
+        succ = BlockDev.lvm_set_auto_devices(True)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_set_auto_devices, False)
+        self.assertTrue(BlockDev.lvm_get_auto_devices())
+
+        # queries for non-existing objects still fail the same way
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_vginfo("nonexistingvg")
+
+        succ = BlockDev.lvm_set_auto_devices(False)
+        self.assertTrue(succ)
+        self.assertFalse(BlockDev.lvm_get_auto_devices())
+
     @tag_test(TestTags.NOSTORAGE)
     def test_cache_get_default_md_size(self):
         """Verify that default cache metadata size is calculated properly"""
@@ -487,6 +585,34 @@ class LvmTestPVs(LvmPVonlyTestCase):
 
         self.assertTrue(any(info.pv_uuid == all_info.pv_uuid for all_info in pvs))
 
+class LvmTestPVsShell(LvmPVonlyTestCase):
+    def test_pvs_shell(self):
+        """Verify that PV operations and queries work with the persistent lvm shell"""
+
+        succ = BlockDev.lvm_set_persistent_shell(True)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_set_persistent_shell, False)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        pvs = BlockDev.lvm_pvs()
+        self.assertTrue(any(info.pv_name == self.loop_dev for info in pvs))
+
+        info = BlockDev.lvm_pvinfo(self.loop_dev)
+        self.assertTrue(info)
+        self.assertEqual(info.pv_name, self.loop_dev)
+
+        # failures must be reported even though the shell has no exit codes
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_pvcreate("/non/existing/device", 0, 0, None)
+
+        succ = BlockDev.lvm_pvremove(self.loop_dev, None)
+        self.assertTrue(succ)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_pvinfo(self.loop_dev)
+
 class LvmPVVGTestCase(LvmPVonlyTestCase):
     def _clean_up(self):
         try:
@@ -903,6 +1029,20 @@ class LvmTestPartialLVs(LvmPVVGLVTestCase):
 
         assert_raid1_structure(self.loop_dev, self.loop_dev2)
 
+        # the result set gives the same information as lvs_tree
+        lvs = BlockDev.lvm_lvs_tree("testVG")
+        result_set = BlockDev.lvm_lvs_tree_result_set("testVG")
+        self.assertEqual(result_set.n_lvs, len(lvs))
+        for i, lv in enumerate(lvs):
+            item = BlockDev.lvm_lv_result_set_get(result_set, i)
+            self.assertEqual(item.lv_name, lv.lv_name)
+            self.assertEqual(item.uuid, lv.uuid)
+            self.assertEqual(item.size, lv.size)
+            self.assertEqual(item.data_lvs, lv.data_lvs)
+            self.assertEqual(item.metadata_lvs, lv.metadata_lvs)
+            self.assertEqual([seg.pvdev for seg in item.segs], [seg.pvdev for seg in lv.segs])
+        self.assertIsNone(BlockDev.lvm_lv_result_set_get(result_set, len(lvs)))
+
         # Disconnect the second PV, this should cause it to be flagged
         # as missing, and testLV to be reported as "partial".
         delete_lio_device(self.loop_dev2)
@@ -1114,6 +1254,102 @@ class LvmTestLVactivateDeactivate(LvmPVVGLVTestCase):
         succ = BlockDev.lvm_lvdeactivate("testVG", "testLV", None)
         self.assertTrue(succ)
 
+    def test_lvactivate_lvdeactivate_many(self):
+        """Verify it's possible to (de)activate multiple LVs at once"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 256 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV2", 256 * 1024**2, None, [self.loop_dev2], None)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_lvremove, "testVG", "testLV2", True, None)
+
+        succ = BlockDev.lvm_add_lv_tags("testVG", "testLV2", ["bulk"])
+        self.assertTrue(succ)
+
+        def active(lv_name):
+            return BlockDev.lvm_lvinfo("testVG", lv_name).attr[4] == "a"
+
+        # nothing to do
+        succ = BlockDev.lvm_lvdeactivate_many([], None)
+        self.assertTrue(succ)
+
+        # all LVs in the VG
+        succ = BlockDev.lvm_lvdeactivate_many(["testVG"], None)
+        self.assertTrue(succ)
+        self.assertFalse(active("testLV"))
+        self.assertFalse(active("testLV2"))
+
+        # by name and by tag
+        succ = BlockDev.lvm_lvactivate_many(["testVG/testLV", "@bulk"], False, False, None)
+        self.assertTrue(succ)
+        self.assertTrue(active("testLV"))
+        self.assertTrue(active("testLV2"))
+
+        succ = BlockDev.lvm_lvdeactivate_many(["@bulk"], None)
+        self.assertTrue(succ)
+        self.assertTrue(active("testLV"))
+        self.assertFalse(active("testLV2"))
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_lvactivate_many(["testVG/testLV2", "testVG/nonexistingLV"], False, False, None)
+
+class LvmTestPVmove(LvmPVVGLVTestCase):
+    def test_pvmove_start(self):
+        """Verify that it is possible to move extents of a PV in the background"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 256 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_pvmove_set_throttle(0)
+
+        # slow the move down a bit (and make sure it's not slowed down for others)
+        succ = BlockDev.lvm_pvmove_set_throttle(50)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_pvmove_set_throttle, 100)
+
+        job = BlockDev.lvm_pvmove_start(self.loop_dev, self.loop_dev2, None)
+        self.assertIsNotNone(job)
+        self.assertEqual(job.vg_name, "testVG")
+        self.assertFalse(job.aborted)
+
+        progress = 0
+        for _ in range(120):
+            succ, progress = BlockDev.lvm_pvmove_job_get_progress(job)
+            self.assertTrue(succ)
+            self.assertTrue(0 <= progress <= 100)
+            if progress == 100:
+                break
+            time.sleep(1)
+        self.assertEqual(progress, 100)
+
+        # give LVM some time to finish the move (remove the pvmove LV)
+        for _ in range(10):
+            info = BlockDev.lvm_pvinfo(self.loop_dev)
+            if info.pv_size == info.pv_free:
+                break
+            time.sleep(1)
+        self.assertEqual(info.pv_size, info.pv_free)
+
 class LvmTestLVresize(LvmPVVGLVTestCase):
     def test_lvresize(self):
         """Verify that it's possible to resize an LV"""
@@ -1328,6 +1564,24 @@ class LvmTestLVsMultiSegment(LvmPVVGLVTestCase):
         self.assertEqual(len(lvs), 2)
         self.assertListEqual([lv.lv_name for lv in lvs], ["testLV", "testLV2"])
 
+        # the duplicate entries are skipped when iterating over the LVs too
+        names = []
+        def collect(lv, data):
+            data.append(lv.lv_name)
+            return True
+        succ = BlockDev.lvm_lvs_foreach("testVG", collect, names)
+        self.assertTrue(succ)
+        self.assertListEqual(sorted(names), ["testLV", "testLV2"])
+
+        # stopping the iteration after the first LV
+        names = []
+        def collect_one(lv, data):
+            data.append(lv.lv_name)
+            return False
+        succ = BlockDev.lvm_lvs_foreach("testVG", collect_one, names)
+        self.assertTrue(succ)
+        self.assertEqual(len(names), 1)
+
 class LvmPVVGthpoolTestCase(LvmPVVGTestCase):
     def _clean_up(self):
         try:
@@ -1357,6 +1611,58 @@ class LvmTestLVsAll(LvmPVVGthpoolTestCase):
         lvs = BlockDev.lvm_lvs("testVG")
         self.assertGreater(len(lvs), 3)
 
+class LvmTestReportAll(LvmPVVGthpoolTestCase):
+    def test_report_all(self):
+        """Verify that info about all PVs, VGs and LVs is gathered at once"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thpoolcreate("testVG", "testPool", 512 * 1024**2, 4 * 1024**2, 512 * 1024, "thin-performance", None)
+        self.assertTrue(succ)
+
+        report = BlockDev.lvm_report_all()
+        self.assertIsNotNone(report)
+
+        # the report should give the same data as the separate calls
+        pvs = {pv.pv_name: pv for pv in BlockDev.lvm_pvs()}
+        report_pvs = {pv.pv_name: pv for pv in report.pvs}
+        self.assertEqual(set(pvs.keys()), set(report_pvs.keys()))
+        for dev in (self.loop_dev, self.loop_dev2):
+            self.assertEqual(report_pvs[dev].pv_uuid, pvs[dev].pv_uuid)
+            self.assertEqual(report_pvs[dev].pv_size, pvs[dev].pv_size)
+            self.assertEqual(report_pvs[dev].vg_name, "testVG")
+            self.assertEqual(report_pvs[dev].vg_size, pvs[dev].vg_size)
+            self.assertEqual(report_pvs[dev].vg_pv_count, 2)
+
+        vgs = {vg.name: vg for vg in BlockDev.lvm_vgs()}
+        report_vgs = {vg.name: vg for vg in report.vgs}
+        self.assertEqual(set(vgs.keys()), set(report_vgs.keys()))
+        self.assertEqual(report_vgs["testVG"].uuid, vgs["testVG"].uuid)
+        self.assertEqual(report_vgs["testVG"].size, vgs["testVG"].size)
+        self.assertEqual(report_vgs["testVG"].free, vgs["testVG"].free)
+        self.assertEqual(report_vgs["testVG"].pv_count, 2)
+
+        lvs = {(lv.vg_name, lv.lv_name): lv for lv in BlockDev.lvm_lvs_tree(None)}
+        report_lvs = {(lv.vg_name, lv.lv_name): lv for lv in report.lvs}
+        self.assertEqual(set(lvs.keys()), set(report_lvs.keys()))
+        for key, lv in lvs.items():
+            self.assertEqual(report_lvs[key].uuid, lv.uuid)
+            self.assertEqual(report_lvs[key].size, lv.size)
+            self.assertEqual(report_lvs[key].segtype, lv.segtype)
+            self.assertEqual(report_lvs[key].attr, lv.attr)
+
+        pool = report_lvs[("testVG", "testPool")]
+        self.assertEqual(pool.segtype, "thin-pool")
+        self.assertEqual(pool.data_lv, "testPool_tdata")
+        self.assertEqual(pool.metadata_lv, "testPool_tmeta")
+
 class LvmTestThpoolCreate(LvmPVVGthpoolTestCase):
     @tag_test(TestTags.CORE)
     def test_thpoolcreate(self):
@@ -1481,6 +1787,63 @@ class LvmTestThLVcreate(LvmPVVGLVthLVTestCase):
         self.assertEqual(pool, "testPool")
         self.assertEqual(lvi.pool_lv, "testPool")
 
+class LvmTestThpoolMonitor(LvmPVVGLVthLVTestCase):
+    def test_thpool_monitor(self):
+        """Verify that it is possible to monitor usage of a thin pool"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thpoolcreate("testVG", "testPool", 512 * 1024**2, 4 * 1024**2, 512 * 1024, None, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thlvcreate("testVG", "testPool", "testThLV", 1024**3, None)
+        self.assertTrue(succ)
+
+        monitor = BlockDev.lvm_pool_monitor_new("testVG", "testPool")
+        self.assertIsNotNone(monitor)
+        self.assertFalse(monitor.vdo)
+        self.assertEqual(monitor.map_name, "testVG-testPool-tpool")
+
+        usage = BlockDev.lvm_pool_monitor_sample(monitor)
+        self.assertIsNotNone(usage)
+        self.assertFalse(usage.vdo)
+        self.assertEqual(usage.data_total, 512 * 1024**2)
+        self.assertEqual(usage.metadata_total, 4 * 1024**2)
+        self.assertGreater(usage.metadata_used, 0)
+        self.assertFalse(usage.read_only)
+        self.assertFalse(usage.out_of_space)
+
+        # write some data to the thin LV to get over a (very low) threshold
+        def on_threshold(_monitor, usage, crossed):
+            crossed.append(usage.data_percent)
+
+        crossed = []
+        succ = BlockDev.lvm_pool_monitor_set_thresholds(monitor, 1, 0, on_threshold, crossed)
+        self.assertTrue(succ)
+        run_command("dd if=/dev/urandom of=/dev/testVG/testThLV bs=1M count=32 oflag=direct")
+
+        usage = BlockDev.lvm_pool_monitor_sample(monitor)
+        self.assertGreaterEqual(usage.data_percent, 1)
+        self.assertEqual(len(crossed), 1)
+
+        # the function is not called again while still above the threshold
+        BlockDev.lvm_pool_monitor_sample(monitor)
+        self.assertEqual(len(crossed), 1)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_pool_monitor_set_thresholds(monitor, 101, 0, on_threshold, crossed)
+
+        # not a pool
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_pool_monitor_new("testVG", "testThLV")
+
 class LvmPVVGLVthLVsnapshotTestCase(LvmPVVGLVthLVTestCase):
     def _clean_up(self):
         try:
@@ -1524,6 +1887,47 @@ class LvmTestThSnapshotCreate(LvmPVVGLVthLVsnapshotTestCase):
         self.assertIn("snapshot", info.roles.split(","))
         self.assertIn("thinsnapshot", info.roles.split(","))
 
+    def test_thsnapshotcreate_many(self):
+        """Verify that it is possible to create multiple thin LV snapshots at once"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thpoolcreate("testVG", "testPool", 512 * 1024**2, 4 * 1024**2, 512 * 1024, None, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thlvcreate("testVG", "testPool", "testThLV", 1024**3, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_thlvcreate("testVG", "testPool", "testThLV2", 1024**3, None)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_lvremove, "testVG", "testThLV2", True, None)
+
+        with self.assertRaisesRegex(GLib.GError, "doesn't match"):
+            BlockDev.lvm_thsnapshotcreate_many("testVG", ["testThLV", "testThLV2"], ["testThLV_bak"], None, None)
+
+        # the second snapshot cannot be created, the first one should be removed
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_thsnapshotcreate_many("testVG", ["testThLV", "nonexistingLV"],
+                                               ["testThLV_bak", "testThLV2_bak"], None, None)
+        with self.assertRaises(GLib.GError):
+            BlockDev.lvm_lvinfo("testVG", "testThLV_bak")
+
+        succ = BlockDev.lvm_thsnapshotcreate_many("testVG", ["testThLV", "testThLV2"],
+                                                  ["testThLV_bak", "testThLV2_bak"], "testPool", None)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.lvm_lvremove, "testVG", "testThLV2_bak", True, None)
+
+        for snap in ("testThLV_bak", "testThLV2_bak"):
+            info = BlockDev.lvm_lvinfo("testVG", snap)
+            self.assertIn("thinsnapshot", info.roles.split(","))
+
 class LvmPVVGLVcachePoolTestCase(LvmPVVGLVTestCase):
     def _clean_up(self):
         try:
@@ -1628,6 +2032,107 @@ class LvmPVVGLVcachePoolAttachDetachTestCase(LvmPVVGLVcachePoolTestCase):
         lvs = BlockDev.lvm_lvs("testVG")
         self.assertTrue(any(info.lv_name == "testCache" for info in lvs))
 
+class LvmPVVGLVcacheSettingsTestCase(LvmPVVGLVcachePoolTestCase):
+    @tag_test(TestTags.SLOW)
+    def test_cache_attach_with_settings(self):
+        """Verify that it is possible to attach a cache pool with settings and change them"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_cache_create_pool("testVG", "testCache", 512 * 1024**2, 0, BlockDev.LVMCacheMode.WRITETHROUGH, 0, [self.loop_dev2])
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 512 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        # writecache settings are not valid for dm-cache
+        settings = BlockDev.LVMCacheSettings(high_watermark=50)
+        with self.assertRaisesRegex(GLib.GError, "Writecache settings"):
+            BlockDev.lvm_cache_attach_with_settings("testVG", "testLV", "testCache", settings)
+
+        settings = BlockDev.LVMCacheSettings(chunk_size=1000)
+        with self.assertRaisesRegex(GLib.GError, "Invalid chunk size"):
+            BlockDev.lvm_cache_attach_with_settings("testVG", "testLV", "testCache", settings)
+
+        settings = BlockDev.LVMCacheSettings(chunk_size=256 * 1024, migration_threshold=4 * 1024**2, policy="smq")
+        succ = BlockDev.lvm_cache_attach_with_settings("testVG", "testLV", "testCache", settings)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("lvs --noheadings --units b --nosuffix -o chunk_size,cache_policy,cache_settings testVG/testLV")
+        self.assertEqual(out.split(), ["262144", "smq", "migration_threshold=8192"])
+
+        # chunk size cannot be changed
+        with self.assertRaisesRegex(GLib.GError, "cannot be changed"):
+            BlockDev.lvm_cache_set_settings("testVG", "testLV", settings)
+
+        settings = BlockDev.LVMCacheSettings(migration_threshold=8 * 1024**2)
+        succ = BlockDev.lvm_cache_set_settings("testVG", "testLV", settings)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("lvs --noheadings -o cache_settings testVG/testLV")
+        self.assertEqual(out, "migration_threshold=16384")
+
+    @tag_test(TestTags.SLOW)
+    def test_writecache_attach_with_settings(self):
+        """Verify that it is possible to attach a writecache LV with settings and change them"""
+
+        lvm_version = self._get_lvm_version()
+        if lvm_version < Version("2.03.02"):
+            self.skipTest("LVM writecache support not available")
+
+        lvm_segtypes = self._get_lvm_segtypes()
+        if "writecache" not in lvm_segtypes:
+            self.skipTest("LVM writecache support not available")
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev2, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev, self.loop_dev2], 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testCache", 512 * 1024**2, None, [self.loop_dev2], None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_lvcreate("testVG", "testLV", 512 * 1024**2, None, [self.loop_dev], None)
+        self.assertTrue(succ)
+
+        # dm-cache settings are not valid for writecache
+        settings = BlockDev.LVMCacheSettings(policy="smq")
+        with self.assertRaisesRegex(GLib.GError, "cannot be used for a writecache"):
+            BlockDev.lvm_writecache_attach_with_settings("testVG", "testLV", "testCache", settings)
+
+        settings = BlockDev.LVMCacheSettings(high_watermark=40, low_watermark=50)
+        with self.assertRaisesRegex(GLib.GError, "Invalid watermarks"):
+            BlockDev.lvm_writecache_attach_with_settings("testVG", "testLV", "testCache", settings)
+
+        settings = BlockDev.LVMCacheSettings(high_watermark=60, low_watermark=20, writeback_jobs=64)
+        succ = BlockDev.lvm_writecache_attach_with_settings("testVG", "testLV", "testCache", settings)
+        self.assertTrue(succ)
+
+        info = BlockDev.lvm_lvinfo("testVG", "testLV")
+        self.assertIsNotNone(info)
+        self.assertEqual(info.segtype, "writecache")
+
+        _ret, out, _err = run_command("lvs --noheadings -o cache_settings testVG/testLV")
+        self.assertEqual(sorted(out.split(",")), ["high_watermark=60", "low_watermark=20", "writeback_jobs=64"])
+
+        settings = BlockDev.LVMCacheSettings(autocommit_time=2000)
+        succ = BlockDev.lvm_cache_set_settings("testVG", "testLV", settings)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("lvs --noheadings -o cache_settings testVG/testLV")
+        self.assertIn("autocommit_time=2000", out)
+
 class LvmPVVGcachedLVTestCase(LvmPVVGLVTestCase):
     @tag_test(TestTags.SLOW)
     def test_create_cached_lv(self):
@@ -1708,6 +2213,21 @@ class LvmPVVGcachedLVstatsTestCase(LvmPVVGLVTestCase):
         self.assertEqual(stats.md_size, 8 * 1024**2)
         self.assertEqual(stats.mode, BlockDev.LVMCacheMode.WRITETHROUGH)
 
+        sampler = BlockDev.lvm_cache_sampler_new("testVG", "testLV")
+        self.assertIsNotNone(sampler)
+        self.assertEqual(sampler.map_name, "testVG-testLV")
+
+        # generate some reads for the deltas
+        run_command("dd if=/dev/testVG/testLV of=/dev/null bs=1M count=16 iflag=direct")
+
+        sample = BlockDev.lvm_cache_sampler_sample(sampler)
+        self.assertIsNotNone(sample)
+        self.assertFalse(sample.writecache)
+        self.assertGreater(sample.interval, 0)
+        self.assertGreater(sample.read_hits_delta + sample.read_misses_delta, 0)
+        self.assertGreaterEqual(sample.read_hits, sample.read_hits_delta)
+        self.assertTrue(0 <= sample.read_hit_ratio <= 1)
+
 class LvmPVVGcachedThpoolstatsTestCase(LvmPVVGLVTestCase):
     @tag_test(TestTags.SLOW)
     def test_cache_get_stats(self):
@@ -1828,6 +2348,14 @@ class LvmPVVGWritecachedLVTestCase(LvmPVVGLVTestCase):
         self.assertIsNotNone(info)
         self.assertEqual(info.segtype, "writecache")
 
+        sampler = BlockDev.lvm_cache_sampler_new("testVG", "testLV")
+        self.assertIsNotNone(sampler)
+
+        sample = BlockDev.lvm_cache_sampler_sample(sampler)
+        self.assertIsNotNone(sample)
+        self.assertTrue(sample.writecache)
+        self.assertEqual(sample.promotions, 0)
+
 class LvmVGExportedTestCase(LvmPVVGLVTestCase):
 
     def _clean_up(self):
@@ -1901,6 +2429,40 @@ class LvmTestLVTags(LvmPVVGLVTestCase):
         self.assertTrue(info)
         self.assertEqual(info.lv_tags, ["c", "e"])
 
+    def test_batch_run(self):
+        """Verify that it's possible to run independent LV operations in a batch"""
+
+        succ = BlockDev.lvm_pvcreate(self.loop_dev, 0, 0, None)
+        self.assertTrue(succ)
+
+        succ = BlockDev.lvm_vgcreate("testVG", [self.loop_dev], 0, None)
+        self.assertTrue(succ)
+
+        for name in ("testLV1", "testLV2", "testLV3"):
+            succ = BlockDev.lvm_lvcreate("testVG", name, 32 * 1024**2, None, [self.loop_dev], None)
+            self.assertTrue(succ)
+
+        ops = [BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_ADD_TAGS, "testVG", "testLV1", None, ["a", "b"]),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_ADD_TAGS, "testVG", "testLV2", None, ["c"]),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_RENAME, "testVG", "testLV3", "testLV4", None),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_RENAME, "testVG", "nonexistingLV", "testLV5", None),
+               BlockDev.LVMBatchOp.new(BlockDev.LVMBatchOpType.LV_DELETE_TAGS, "testVG", "testLV1", None, None)]
+        results = BlockDev.lvm_batch_run(ops, 0)
+        self.assertEqual(len(results), len(ops))
+
+        # only the operations on the nonexisting LV and without tags should fail
+        self.assertEqual([r.success for r in results], [True, True, True, False, False])
+        self.assertIsNone(results[0].error)
+        self.assertIsNotNone(results[3].error)
+        self.assertIsNotNone(results[4].error)
+
+        info = BlockDev.lvm_lvinfo("testVG", "testLV1")
+        self.assertEqual(info.lv_tags, ["a", "b"])
+        info = BlockDev.lvm_lvinfo("testVG", "testLV2")
+        self.assertEqual(info.lv_tags, ["c"])
+        info = BlockDev.lvm_lvinfo("testVG", "testLV4")
+        self.assertTrue(info)
+
 
 class LVMTechTest(LVMTestCase):
 
@@ -2047,6 +2609,35 @@ class LVMVDOTest(LVMTestCase):
         pool_info = BlockDev.lvm_lvinfo("testVDOVG", pool_name)
         self.assertEqual(pool_info.segtype, "vdo-pool")
 
+    @tag_test(TestTags.SLOW)
+    def test_vdo_pool_create_settings(self):
+        settings = BlockDev.LVMVDOSettings(ack_threads=2, bio_threads=2, cpu_threads=4, hash_zone_threads=2,
+                                           logical_threads=2, physical_threads=2, slab_size=512 * 1024**2)
+        succ = BlockDev.lvm_vdo_pool_create_with_settings("testVDOVG", "vdoLV", "vdoPool", 7 * 1024**3, 35 * 1024**3,
+                                                          settings=settings)
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("lvs --noheadings --units b --nosuffix -o vdo_cpu_threads,vdo_logical_threads,vdo_slab_size testVDOVG/vdoPool")
+        self.assertEqual(out.split(), ["4", "2", str(512 * 1024**2)])
+
+        # invalid settings
+        with self.assertRaisesRegex(GLib.GError, "slab size"):
+            BlockDev.lvm_vdo_pool_create_with_settings("testVDOVG", "vdoLV2", "vdoPool2", 7 * 1024**3, 35 * 1024**3,
+                                                       settings=BlockDev.LVMVDOSettings(slab_size=100 * 1024**2))
+        with self.assertRaisesRegex(GLib.GError, "logical threads"):
+            BlockDev.lvm_vdo_pool_create_with_settings("testVDOVG", "vdoLV2", "vdoPool2", 7 * 1024**3, 35 * 1024**3,
+                                                       settings=BlockDev.LVMVDOSettings(logical_threads=100))
+
+        # slab size of an existing pool cannot be changed
+        with self.assertRaisesRegex(GLib.GError, "cannot be changed"):
+            BlockDev.lvm_vdo_pool_set_settings("testVDOVG", "vdoPool", BlockDev.LVMVDOSettings(slab_size=1024**3))
+
+        succ = BlockDev.lvm_vdo_pool_set_settings("testVDOVG", "vdoPool", BlockDev.LVMVDOSettings(cpu_threads=2))
+        self.assertTrue(succ)
+
+        _ret, out, _err = run_command("lvs --noheadings -o vdo_cpu_threads testVDOVG/vdoPool")
+        self.assertEqual(out.strip(), "2")
+
     @tag_test(TestTags.SLOW)
     def test_resize(self):
         succ = BlockDev.lvm_vdo_pool_create("testVDOVG", "vdoLV", "vdoPool", 5 * 1024**3, 10 * 1024**3)
@@ -2166,6 +2757,16 @@ class LVMVDOTest(LVMTestCase):
         full_stats = BlockDev.lvm_vdo_get_stats_full("testVDOVG", "vdoPool")
         self.assertIn("writeAmplificationRatio", full_stats.keys())
 
+        # typed stats must match the full ones
+        self.assertEqual(vdo_stats.block_size, int(full_stats["block_size"]))
+        self.assertEqual(vdo_stats.physical_blocks, int(full_stats["physical_blocks"]))
+        self.assertEqual(vdo_stats.used_percent, int(full_stats["usedPercent"]))
+        self.assertAlmostEqual(vdo_stats.write_amplification_ratio, float(full_stats["writeAmplificationRatio"]), places=2)
+
+        # the statistics files are kept open, reading again must work too
+        vdo_stats = BlockDev.lvm_vdo_get_stats("testVDOVG", "vdoPool")
+        self.assertEqual(vdo_stats.block_size, int(full_stats["block_size"]))
+
 
 class LvmTestDevicesFile(LvmPVonlyTestCase):
     devicefile = "bd_lvm_test.devices"
@@ -271,6 +271,42 @@ class MDTestActivateDeactivate(MDTestCase):
                                         [self.loop_dev, self.loop_dev2, self.loop_dev3], None)
             self.assertTrue(succ)
 
+class MDTestActivateMany(MDTestCase):
+    @tag_test(TestTags.SLOW)
+    def test_activate_many(self):
+        """Verify that it is possible to activate MD RAIDs found on a set of devices"""
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_create("bd_test_md", "raid1",
+                                      [self.loop_dev, self.loop_dev2],
+                                      0, None, None)
+            self.assertTrue(succ)
+
+        ex_data = BlockDev.md_examine(self.loop_dev)
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_deactivate("bd_test_md")
+            self.assertTrue(succ)
+
+        # the third device is not an MD member and should be ignored
+        with wait_for_action("resync"):
+            results = BlockDev.md_activate_many([self.loop_dev, self.loop_dev2, self.loop_dev3],
+                                                False, 0, None)
+        self.assertEqual(len(results), 1)
+        self.assertTrue(results[0].success)
+        self.assertIsNone(results[0].error)
+        self.assertEqual(results[0].uuid, ex_data.uuid)
+        self.assertEqual(results[0].device, "/dev/md/bd_test_md")
+        self.assertEqual(results[0].members, [self.loop_dev, self.loop_dev2])
+
+        de_data = BlockDev.md_detail("bd_test_md")
+        self.assertEqual(de_data.active_devices, 2)
+
+        # nothing to activate
+        results = BlockDev.md_activate_many([self.loop_dev3], False, 0, None)
+        self.assertEqual(len(results), 0)
+
+
 class MDTestActivateWithUUID(MDTestCase):
     @tag_test(TestTags.SLOW)
     def test_activate_with_uuid(self):
@@ -473,6 +509,44 @@ class MDTestExamineDetail(MDTestCase):
         de_data = BlockDev.md_detail("/dev/%s" % node)
         self.assertTrue(de_data)
 
+    @tag_test(TestTags.SLOW)
+    def test_examine_detail_native(self):
+        """Verify that the natively read MD RAID info matches mdadm's"""
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_create("bd_test_md", "raid1",
+                                      [self.loop_dev, self.loop_dev2, self.loop_dev3],
+                                      1, None, None)
+            self.assertTrue(succ)
+
+        ex_data = BlockDev.md_examine(self.loop_dev)
+        self.assertTrue(ex_data)
+
+        _ret, out, _err = run_command("mdadm --examine --export %s" % self.loop_dev)
+        export = dict(line.split("=", 1) for line in out.splitlines() if "=" in line)
+        self.assertEqual(ex_data.level, export["MD_LEVEL"])
+        self.assertEqual(ex_data.num_devices, int(export["MD_DEVICES"]))
+        self.assertEqual(ex_data.name, export["MD_NAME"])
+        self.assertEqual(ex_data.events, int(export["MD_EVENTS"]))
+        self.assertEqual(ex_data.metadata, export["MD_METADATA"])
+        self.assertEqual(ex_data.uuid, BlockDev.md_canonicalize_uuid(export["MD_UUID"]))
+        self.assertEqual(ex_data.dev_uuid, BlockDev.md_canonicalize_uuid(export["MD_DEV_UUID"]))
+
+        de_data = BlockDev.md_detail("bd_test_md")
+        self.assertTrue(de_data)
+
+        _ret, out, _err = run_command("mdadm --detail --export /dev/md/bd_test_md")
+        export = dict(line.split("=", 1) for line in out.splitlines() if "=" in line)
+        self.assertEqual(de_data.level, export["MD_LEVEL"])
+        self.assertEqual(de_data.raid_devices, int(export["MD_DEVICES"]))
+        self.assertEqual(de_data.name, export["MD_NAME"])
+        self.assertEqual(de_data.metadata, export["MD_METADATA"])
+        self.assertEqual(de_data.uuid, BlockDev.md_canonicalize_uuid(export["MD_UUID"]))
+        self.assertEqual(de_data.active_devices, 2)
+        self.assertEqual(de_data.working_devices, 3)
+        self.assertEqual(de_data.failed_devices, 0)
+        self.assertTrue(de_data.creation_time)
+
 class MDTestNameNodeBijection(MDTestCase):
     @tag_test(TestTags.SLOW)
     def test_name_node_bijection(self):
@@ -587,6 +661,131 @@ class MDTestRequestSyncAction(MDTestCase):
         self.assertEqual(action, "check")
 
 
+class MDTestTuning(MDTestCase):
+    @tag_test(TestTags.SLOW, TestTags.UNSTABLE)
+    def test_tuning(self):
+        """Verify that we can tune the performance parameters of an MD array"""
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_create("bd_test_md", "raid5",
+                                      [self.loop_dev, self.loop_dev2, self.loop_dev3],
+                                      0, None, "internal")
+            self.assertTrue(succ)
+
+        succ = BlockDev.md_set_stripe_cache_size("bd_test_md", 1024)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.md_get_stripe_cache_size("bd_test_md"), 1024)
+
+        # out of the supported range
+        with self.assertRaisesRegex(GLib.GError, "Stripe cache size must be"):
+            BlockDev.md_set_stripe_cache_size("bd_test_md", 16)
+
+        succ = BlockDev.md_set_group_thread_cnt("bd_test_md", 2)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.md_get_group_thread_cnt("bd_test_md"), 2)
+
+        succ = BlockDev.md_set_sync_speed_limits("bd_test_md", 2000, 100000)
+        self.assertTrue(succ)
+        succ, speed_min, speed_max = BlockDev.md_get_sync_speed_limits("bd_test_md")
+        self.assertTrue(succ)
+        self.assertEqual(speed_min, 2000)
+        self.assertEqual(speed_max, 100000)
+
+        with self.assertRaisesRegex(GLib.GError, "cannot be bigger"):
+            BlockDev.md_set_sync_speed_limits("bd_test_md", 100000, 2000)
+
+        # back to the system-wide limits
+        succ = BlockDev.md_set_sync_speed_limits("bd_test_md", 0, 0)
+        self.assertTrue(succ)
+        with open("/proc/sys/dev/raid/speed_limit_min") as f:
+            system_min = int(f.read())
+        succ, speed_min, _speed_max = BlockDev.md_get_sync_speed_limits("bd_test_md")
+        self.assertTrue(succ)
+        self.assertEqual(speed_min, system_min)
+
+        policy = BlockDev.md_get_consistency_policy("bd_test_md")
+        self.assertEqual(policy, "bitmap")
+
+        with self.assertRaisesRegex(GLib.GError, "must be either resync or ppl"):
+            BlockDev.md_set_consistency_policy("bd_test_md", "journal")
+
+        chunk_size = BlockDev.md_get_bitmap_chunk_size("bd_test_md")
+        self.assertGreater(chunk_size, 0)
+
+        succ = BlockDev.md_set_bitmap_chunk_size("bd_test_md", 2 * chunk_size)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.md_get_bitmap_chunk_size("bd_test_md"), 2 * chunk_size)
+
+        with self.assertRaisesRegex(GLib.GError, "must be a power of two"):
+            BlockDev.md_set_bitmap_chunk_size("bd_test_md", 3 * 4096)
+
+        succ = BlockDev.md_tune("bd_test_md", BlockDev.MDTuneProfile.HDD)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.md_get_stripe_cache_size("bd_test_md"), 8192)
+        self.assertEqual(BlockDev.md_get_group_thread_cnt("bd_test_md"), 0)
+
+        succ = BlockDev.md_tune("bd_test_md", BlockDev.MDTuneProfile.NVME)
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.md_get_stripe_cache_size("bd_test_md"), 4096)
+        self.assertGreaterEqual(BlockDev.md_get_group_thread_cnt("bd_test_md"), 1)
+
+        BlockDev.md_deactivate("bd_test_md")
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_create("bd_test_md", "raid1",
+                                      [self.loop_dev, self.loop_dev2, self.loop_dev3],
+                                      0, None, "none")
+            self.assertTrue(succ)
+
+        # the profiles make sense only for the parity RAIDs
+        with self.assertRaisesRegex(GLib.GError, "only for RAID 4/5/6"):
+            BlockDev.md_tune("bd_test_md", BlockDev.MDTuneProfile.HDD)
+
+
+class MDTestMonitorSync(MDTestCase):
+    log = []
+
+    def _my_progress_func(self, task, status, completion, msg):
+        self.log.append((task, status, completion, msg))
+
+    @tag_test(TestTags.SLOW)
+    def test_monitor_sync(self):
+        """Verify we can wait for a sync action with progress reporting"""
+
+        with wait_for_action("resync"):
+            succ = BlockDev.md_create("bd_test_md", "raid1",
+                                      [self.loop_dev, self.loop_dev2, self.loop_dev3],
+                                      1, None, None)
+            self.assertTrue(succ)
+
+        # nothing running, should return right away
+        succ = BlockDev.md_monitor_sync(["bd_test_md"], 10)
+        self.assertTrue(succ)
+
+        succ = BlockDev.utils_init_prog_reporting(self._my_progress_func)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.utils_init_prog_reporting, None)
+
+        self.log = []
+        succ = BlockDev.md_request_sync_action("bd_test_md", "check")
+        self.assertTrue(succ)
+        succ = BlockDev.md_monitor_sync(["bd_test_md"], 60)
+        self.assertTrue(succ)
+
+        with open("/proc/mdstat", "r") as f:
+            self.assertNotIn("check", f.read())
+
+        # the check should have been started and finished as one task
+        statuses = [(s, msg) for (t, s, c, msg) in self.log]
+        self.assertEqual(statuses[0][0], BlockDev.UtilsProgStatus.STARTED)
+        self.assertIn("check", statuses[0][1])
+        self.assertEqual(statuses[-1][0], BlockDev.UtilsProgStatus.FINISHED)
+        self.assertEqual(len(set(t for (t, s, c, msg) in self.log)), 1)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.md_monitor_sync(["non_existing_md"], 1)
+
+
 class MDTestDDFRAID(MDTestCase):
 
     _sparse_size = 50 * 1024**2
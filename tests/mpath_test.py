@@ -46,6 +46,16 @@ class MpathTestCase(MpathTest):
         # device and no error is reported
         self.assertFalse(BlockDev.mpath_is_mpath_member("/dev/loop0"))
 
+    def test_filter_mpath_members(self):
+        """Verify that filter_mpath_members works as expected"""
+
+        # non-mpath and non-existing devices are filtered out without an error
+        ret = BlockDev.mpath_filter_mpath_members([self.loop_dev, "/dev/nonexisting", "loop0"])
+        self.assertEqual(ret, [])
+
+        ret = BlockDev.mpath_filter_mpath_members([])
+        self.assertEqual(ret, [])
+
 class MpathNoDevTestCase(MpathTest):
     @tag_test(TestTags.NOSTORAGE)
     def test_plugin_version(self):
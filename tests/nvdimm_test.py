@@ -1,4 +1,5 @@
 import json
+import os
 import re
 import shutil
 import unittest
@@ -113,6 +114,18 @@ class NVDIMMNamespaceTestCase(NVDIMMTestCase):
 
         self._check_namespace_info(bd_namespaces[0])
 
+        # filtering by region
+        region = os.path.basename(os.path.realpath("/sys/bus/nd/devices/%s/.." % self.sys_info["dev"]))
+        bd_namespaces = BlockDev.nvdimm_list_namespaces(region=region)
+        self.assertEqual(len(bd_namespaces), 1)
+        self.assertEqual(bd_namespaces[0].dev, self.sys_info["dev"])
+
+        self.assertIsNone(BlockDev.nvdimm_list_namespaces(region="definitely-not-a-region"))
+
+        # second query uses the cached context, must give the same results
+        info = BlockDev.nvdimm_namespace_info(self.sys_info["dev"])
+        self._check_namespace_info(info)
+
     @tag_test(TestTags.EXTRADEPS, TestTags.UNSAFE)
     def test_enable_disable(self):
         # non-existing/unknown namespace
@@ -182,6 +182,63 @@ class NVMeTestCase(NVMeTest):
         self.assertFalse(log.critical_warning & BlockDev.NVMESmartCriticalWarning.PMR_READONLY)
 
 
+    @tag_test(TestTags.CORE)
+    def test_handle(self):
+        """Test repeated queries using an opened device handle"""
+
+        with self.assertRaisesRegex(GLib.GError, r".*Failed to open device .*': No such file or directory"):
+            BlockDev.nvme_handle_open("/dev/nonexistent")
+
+        handle = BlockDev.nvme_handle_open(self.nvme_dev)
+        self.assertIsNotNone(handle)
+
+        info = handle.get_controller_info()
+        ref_info = BlockDev.nvme_get_controller_info(self.nvme_dev)
+        self.assertEqual(info.ctrl_id, ref_info.ctrl_id)
+        self.assertEqual(info.serial_number, ref_info.serial_number)
+        self.assertEqual(info.subsysnqn, ref_info.subsysnqn)
+        self.assertEqual(info.features, ref_info.features)
+
+        # the cached identify data is used for the subsequent queries
+        for _ in range(3):
+            log = handle.get_smart_log()
+            self.assertEqual(log.temp_sensors, [0, 0, 0, 0, 0, 0, 0, 0])
+            self.assertIsNotNone(handle.get_error_log_entries())
+
+        with self.assertRaisesRegex(GLib.GError, r"Error getting Namespace Identifier \(NSID\): Inappropriate ioctl for device"):
+            handle.get_namespace_info()
+
+        ns_handle = BlockDev.nvme_handle_open(self.nvme_ns_dev)
+        info = ns_handle.get_namespace_info()
+        ref_info = BlockDev.nvme_get_namespace_info(self.nvme_ns_dev)
+        self.assertEqual(info.nsid, ref_info.nsid)
+        self.assertEqual(info.nsize, ref_info.nsize)
+        self.assertEqual(info.nguid, ref_info.nguid)
+        self.assertEqual(info.current_lba_format.data_size, ref_info.current_lba_format.data_size)
+
+
+    @tag_test(TestTags.CORE)
+    def test_health_all(self):
+        """Test collecting health information from all controllers"""
+
+        infos = BlockDev.nvme_get_health_all(0)
+        self.assertIsNotNone(infos)
+
+        info = next((i for i in infos if i.device == self.nvme_dev), None)
+        self.assertIsNotNone(info)
+        self.assertIsNone(info.error)
+        self.assertIsNotNone(info.error_log_entries)
+
+        ref_log = BlockDev.nvme_get_smart_log(self.nvme_dev)
+        self.assertEqual(info.smart_log.temp_sensors, ref_log.temp_sensors)
+        self.assertEqual(info.smart_log.unsafe_shutdowns, ref_log.unsafe_shutdowns)
+        self.assertEqual(info.smart_log.critical_warning, ref_log.critical_warning)
+
+        # serial collection gives the same controllers
+        serial = BlockDev.nvme_get_health_all(1)
+        self.assertEqual([i.device for i in serial], [i.device for i in infos])
+
+
     @tag_test(TestTags.CORE)
     def test_error_log(self):
         """Test error log retrieval"""
@@ -205,6 +262,8 @@ class NVMeTestCase(NVMeTest):
         with self.assertRaisesRegex(GLib.GError, message):
             # Cannot retrieve self-test log on a nvme target loop devices
             BlockDev.nvme_get_self_test_log(self.nvme_dev)
+        with self.assertRaisesRegex(GLib.GError, message):
+            BlockDev.nvme_device_self_test_wait(self.nvme_dev, 5)
 
         self.assertEqual(BlockDev.nvme_self_test_result_to_string(BlockDev.NVMESelfTestResult.NO_ERROR), "success")
         self.assertEqual(BlockDev.nvme_self_test_result_to_string(BlockDev.NVMESelfTestResult.ABORTED), "aborted")
@@ -274,6 +333,44 @@ class NVMeTestCase(NVMeTest):
             BlockDev.nvme_format(self.nvme_dev, 0, 0, BlockDev.NVMEFormatSecureErase.NONE)
 
 
+    @tag_test(TestTags.CORE)
+    def test_select_lba_format(self):
+        """Test selecting the best performing LBA format"""
+
+        with self.assertRaisesRegex(GLib.GError, r".*Failed to open device .*': No such file or directory"):
+            BlockDev.nvme_select_lba_format("/dev/nonexistent", 0, 0)
+
+        # the loop target supports a single 4 KiB format without metadata
+        fmt = BlockDev.nvme_select_lba_format(self.nvme_ns_dev, 0, 0)
+        self.assertEqual(fmt.data_size, 4096)
+        self.assertEqual(fmt.metadata_size, 0)
+        self.assertEqual(fmt.relative_performance, BlockDev.NVMELBAFormatRelativePerformance.BEST)
+
+        fmt = BlockDev.nvme_select_lba_format(self.nvme_ns_dev, 4096, 8)
+        self.assertEqual(fmt.data_size, 4096)
+
+        with self.assertRaisesRegex(GLib.GError, r"No supported LBA format matches"):
+            BlockDev.nvme_select_lba_format(self.nvme_ns_dev, 512, 0)
+
+    @tag_test(TestTags.CORE)
+    def test_format_for_performance(self):
+        """Test formatting multiple namespaces to the best performing LBA format"""
+
+        results = BlockDev.nvme_format_for_performance([self.nvme_ns_dev, "/dev/nonexistent"], 0, 0,
+                                                       BlockDev.NVMEFormatSecureErase.NONE, 0)
+        self.assertEqual(len(results), 2)
+
+        # already in the best format, nothing to do
+        self.assertEqual(results[0].device, self.nvme_ns_dev)
+        self.assertIsNone(results[0].error)
+        self.assertFalse(results[0].formatted)
+        self.assertEqual(results[0].lba_format.data_size, 4096)
+
+        self.assertEqual(results[1].device, "/dev/nonexistent")
+        self.assertIsNotNone(results[1].error)
+        self.assertFalse(results[1].formatted)
+        self.assertIsNone(results[1].lba_format)
+
     @tag_test(TestTags.CORE)
     def test_sanitize_log(self):
         """Test sanitize log retrieval"""
@@ -287,6 +384,8 @@ class NVMeTestCase(NVMeTest):
             BlockDev.nvme_get_sanitize_log(self.nvme_dev)
         with self.assertRaisesRegex(GLib.GError, message):
             BlockDev.nvme_get_sanitize_log(self.nvme_ns_dev)
+        with self.assertRaisesRegex(GLib.GError, message):
+            BlockDev.nvme_sanitize_wait(self.nvme_dev, 5)
 
 
     @tag_test(TestTags.CORE)
@@ -687,3 +786,53 @@ class NVMeFabricsTestCase(NVMeTest):
         self.assertEqual(len(ctrls), 0)
         namespaces = find_nvme_ns_devs_for_subnqn(self.DISCOVERY_NQN)
         self.assertEqual(len(namespaces), 0)
+
+
+    @tag_test(TestTags.CORE)
+    def test_discover_connect_many(self):
+        """Test discovering and connecting multiple subsystems at once"""
+
+        # nothing to discover
+        with self.assertRaisesRegex(GLib.GError, r'Error connecting the discovery controller: '):
+            BlockDev.nvme_discover('loop', refresh=True)
+
+        self._setup_target(1)
+
+        entries = BlockDev.nvme_discover('loop', refresh=True)
+        self.assertGreater(len(entries), 0)
+        subsystems = [e for e in entries if not e.discovery]
+        self.assertEqual(len(subsystems), 1)
+        self.assertEqual(subsystems[0].subsysnqn, self.SUBNQN)
+        self.assertEqual(subsystems[0].transport, 'loop')
+
+        # the discovery controller is disconnected after getting the log page
+        ctrls = find_nvme_ctrl_devs_for_subnqn(self.DISCOVERY_NQN)
+        self.assertEqual(len(ctrls), 0)
+
+        # cached entries should be the same
+        cached = BlockDev.nvme_discover('loop')
+        self.assertEqual([(e.subsysnqn, e.discovery) for e in cached],
+                         [(e.subsysnqn, e.discovery) for e in entries])
+
+        results = BlockDev.nvme_connect_many(entries)
+        self.addCleanup(self._nvme_disconnect, self.SUBNQN, ignore_errors=True)
+        self.assertEqual(len(results), 1)
+        self.assertEqual(results[0].subsysnqn, self.SUBNQN)
+        self.assertIsNone(results[0].error)
+        self.assertEqual(results[0].attempts, 1)
+
+        ctrls = find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)
+        self.assertEqual(len(ctrls), 1)
+
+        # already connected subsystems are not connected again
+        results = BlockDev.nvme_connect_many(entries)
+        self.assertEqual(len(results), 1)
+        self.assertIsNone(results[0].error)
+        self.assertEqual(results[0].attempts, 0)
+
+        ctrls = find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)
+        self.assertEqual(len(ctrls), 1)
+
+        BlockDev.nvme_disconnect(self.SUBNQN)
+        ctrls = find_nvme_ctrl_devs_for_subnqn(self.SUBNQN)
+        self.assertEqual(len(ctrls), 0)
@@ -139,6 +139,42 @@ class PartGetDiskSpecCase(PartTestCase):
         self.assertGreaterEqual(ps.size, 100 * 1024**2 - 512)
         self.assertEqual(ps.table_type, BlockDev.PartTableType.GPT)
 
+    def test_get_disk_spec_damaged_gpt(self):
+        """Verify that getting info about a disk with a damaged primary GPT header works"""
+
+        succ = BlockDev.part_create_table (self.loop_dev, BlockDev.PartTableType.GPT, True)
+        self.assertTrue(succ)
+        ps = BlockDev.part_create_part (self.loop_dev, BlockDev.PartTypeReq.NORMAL, 2048*512, 10 * 1024**2, BlockDev.PartAlign.OPTIMAL)
+        self.assertTrue(ps)
+
+        # overwrite the primary GPT header, the backup one should be used
+        with open(self.loop_dev, "r+b") as f:
+            f.seek(self.block_size)
+            f.write(b"\0" * self.block_size)
+            f.flush()
+            os.fsync(f.fileno())
+
+        ds = BlockDev.part_get_disk_spec (self.loop_dev)
+        self.assertTrue(ds)
+        self.assertEqual(ds.table_type, BlockDev.PartTableType.GPT)
+
+        parts = BlockDev.part_get_disk_parts (self.loop_dev)
+        self.assertEqual(len(parts), 1)
+        self.assertEqual(parts[0].start, ps.start)
+        self.assertEqual(parts[0].size, ps.size)
+        self.assertEqual(parts[0].uuid, ps.uuid)
+
+    def test_get_disk_spec_whole_disk_fs(self):
+        """Verify that a filesystem on the whole disk is not reported as an MSDOS table"""
+
+        ret, _out, err = run_command("mkfs.vfat -I %s" % self.loop_dev)
+        if ret != 0:
+            self.skipTest("Failed to create a vfat filesystem: %s" % err)
+
+        ds = BlockDev.part_get_disk_spec (self.loop_dev)
+        self.assertTrue(ds)
+        self.assertNotEqual(ds.table_type, BlockDev.PartTableType.MSDOS)
+
 
 class PartGetDiskSpecCase4k(PartGetDiskSpecCase):
     block_size = 4096
@@ -179,6 +215,14 @@ class PartCreatePartCase(PartTestCase):
         self.assertEqual(ps.start, ps3.start)
         self.assertEqual(ps.size, ps3.size)
 
+        paths = []
+        def collect(spec, data):
+            data.append((spec.path, spec.start, spec.size))
+            return True
+        succ = BlockDev.part_get_disk_parts_foreach (self.loop_dev, collect, paths)
+        self.assertTrue(succ)
+        self.assertEqual(paths, [(ps.path, ps.start, ps.size)])
+
     def test_create_part_minimal_start_optimal(self):
         """Verify that it is possible to create a partition with minimal start and optimal alignment"""
 
@@ -211,6 +255,25 @@ class PartCreatePartCase(PartTestCase):
         self.assertEqual(ps.start, ps3.start)
         self.assertEqual(ps.size, ps3.size)
 
+    def test_create_part_topology_align(self):
+        """Verify that it is possible to create a partition aligned to the device I/O topology"""
+
+        succ = BlockDev.part_create_table (self.loop_dev, BlockDev.PartTableType.GPT, True)
+        self.assertTrue(succ)
+
+        # loop devices don't report any stripe or zone size, so the partition
+        # should be aligned to 1 MiB
+        ps = BlockDev.part_create_part (self.loop_dev, BlockDev.PartTypeReq.NORMAL, 1, 16 * 1024**2 + 1234,
+                                        BlockDev.PartAlign.TOPOLOGY)
+        self.assertTrue(ps)
+        self.assertEqual(ps.start % 1024**2, 0)
+        self.assertEqual(ps.size, 16 * 1024**2)
+
+        ps2 = BlockDev.part_create_part (self.loop_dev, BlockDev.PartTypeReq.NORMAL, ps.start + ps.size + 4096, 0,
+                                         BlockDev.PartAlign.TOPOLOGY)
+        self.assertTrue(ps2)
+        self.assertEqual(ps2.start % 1024**2, 0)
+
     def test_create_part_minimal_start(self):
         """Verify that it is possible to create a partition with minimal start"""
 
@@ -662,12 +725,106 @@ class PartCreatePartFullCase(PartTestCase):
         self.assertLess(abs(ps6.start - (ps5.start + ps5.size + 1)), ps.start)
         self.assertEqual(ps6.size, 10 * 1024**2)
 
+class PartCreatePartsCase(PartTestCase):
+    test_uuid = "4D7086C4-A4D3-432F-819E-73DA03870DF9"
+    test_type = "0FC63DAF-8483-4772-8E79-3D69D8477DE4"
+
+    @tag_test(TestTags.CORE)
+    def test_create_parts(self):
+        """Verify that it is possible to create multiple partitions at once"""
+
+        succ = BlockDev.part_create_table (self.loop_dev, BlockDev.PartTableType.GPT, True)
+        self.assertTrue(succ)
+
+        specs = [BlockDev.PartCreateSpec(start=2048*512, size=10 * 1024**2, name="first", uuid=self.test_uuid),
+                 BlockDev.PartCreateSpec(start=2048*512 + 10 * 1024**2, size=10 * 1024**2, type_guid=self.test_type),
+                 BlockDev.PartCreateSpec(start=2048*512 + 20 * 1024**2, size=0)]
+        parts = BlockDev.part_create_parts (self.loop_dev, specs)
+        self.assertEqual(len(parts), 3)
+
+        self.assertEqual(parts[0].path, self.loop_dev + "1")
+        self.assertEqual(parts[0].name, "first")
+        self.assertEqual(parts[0].uuid, self.test_uuid)
+        self.assertEqual(parts[0].start, 2048 * 512)
+        self.assertEqual(parts[0].size, 10 * 1024**2)
+
+        self.assertEqual(parts[1].path, self.loop_dev + "2")
+        self.assertEqual(parts[1].type_guid, self.test_type)
+        self.assertEqual(parts[1].start, 2048 * 512 + 10 * 1024**2)
+
+        self.assertEqual(parts[2].path, self.loop_dev + "3")
+        self.assertEqual(parts[2].start, 2048 * 512 + 20 * 1024**2)
+
+        # the partition table really is there
+        ps = BlockDev.part_get_part_spec (self.loop_dev, parts[0].path)
+        self.assertEqual(ps.name, "first")
+        self.assertTrue(os.path.exists(parts[2].path))
+
+        # overlapping partitions, nothing should be written
+        succ = BlockDev.part_create_table (self.loop_dev, BlockDev.PartTableType.GPT, True)
+        self.assertTrue(succ)
+        specs = [BlockDev.PartCreateSpec(start=2048*512, size=10 * 1024**2),
+                 BlockDev.PartCreateSpec(start=2048*512, size=10 * 1024**2)]
+        with self.assertRaises(GLib.GError):
+            BlockDev.part_create_parts (self.loop_dev, specs)
+        self.assertEqual(BlockDev.part_get_disk_parts (self.loop_dev), [])
+
+        # names are not supported on MSDOS
+        succ = BlockDev.part_create_table (self.loop_dev, BlockDev.PartTableType.MSDOS, True)
+        self.assertTrue(succ)
+        specs = [BlockDev.PartCreateSpec(start=2048*512, size=10 * 1024**2, name="first")]
+        with self.assertRaisesRegex(GLib.GError, "unsupported"):
+            BlockDev.part_create_parts (self.loop_dev, specs)
+
+        # but creating multiple partitions works
+        specs = [BlockDev.PartCreateSpec(type=BlockDev.PartTypeReq.NEXT, start=2048*512, size=10 * 1024**2)
+                 for i in range(5)]
+        for i, spec in enumerate(specs):
+            spec.start = 2048 * 512 + i * 12 * 1024**2
+        parts = BlockDev.part_create_parts (self.loop_dev, specs)
+        self.assertEqual(len(parts), 5)
+        self.assertEqual(parts[0].type, BlockDev.PartType.NORMAL)
+        self.assertEqual(parts[3].type, BlockDev.PartType.LOGICAL)
+        self.assertEqual(parts[4].type, BlockDev.PartType.LOGICAL)
+
+
 class PartGetDiskPartsCase(PartTestCase):
     def test_get_disk_parts_empty(self):
         """Verify that getting info about partitions with no label works"""
         with self.assertRaises(GLib.GError):
             BlockDev.part_get_disk_parts (self.loop_dev)
 
+    def test_get_disks_parts(self):
+        """Verify that it is possible to get info about partitions on multiple disks at once"""
+
+        succ = BlockDev.part_create_table (self.loop_dev, BlockDev.PartTableType.GPT, True)
+        self.assertTrue(succ)
+        ps = BlockDev.part_create_part (self.loop_dev, BlockDev.PartTypeReq.NORMAL, 2048*512, 10 * 1024**2, BlockDev.PartAlign.OPTIMAL)
+        self.assertTrue(ps)
+
+        # no partition table on the second disk -- error only for this one
+        ret = BlockDev.part_get_disks_parts ([self.loop_dev, self.loop_dev2], 0)
+        self.assertEqual(len(ret), 2)
+        self.assertEqual(ret[0].disk, self.loop_dev)
+        self.assertIsNone(ret[0].error)
+        self.assertEqual(len(ret[0].parts), 1)
+        self.assertEqual(ret[0].parts[0].path, ps.path)
+        self.assertEqual(ret[0].parts[0].start, ps.start)
+        self.assertEqual(ret[0].parts[0].size, ps.size)
+        self.assertEqual(ret[1].disk, self.loop_dev2)
+        self.assertIsNotNone(ret[1].error)
+
+        succ = BlockDev.part_create_table (self.loop_dev2, BlockDev.PartTableType.MSDOS, True)
+        self.assertTrue(succ)
+
+        # the same result with a single worker (serial scan)
+        ret = BlockDev.part_get_disks_parts ([self.loop_dev, self.loop_dev2], 1)
+        self.assertEqual(len(ret), 2)
+        self.assertIsNone(ret[0].error)
+        self.assertEqual(len(ret[0].parts), 1)
+        self.assertIsNone(ret[1].error)
+        self.assertEqual(len(ret[1].parts), 0)
+
 
 def _round_up_mib(size):
     # convert size to nearest MiB (up)
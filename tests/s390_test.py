@@ -2,7 +2,7 @@ import unittest
 import os
 import overrides_hack
 
-from utils import fake_path, TestTags, tag_test
+from utils import fake_path, fake_utils, TestTags, tag_test
 
 import gi
 gi.require_version('GLib', '2.0')
@@ -89,6 +89,68 @@ class S390TestCase(unittest.TestCase):
             BlockDev.s390_zfcp_sanitize_lun_input(lun)
 
 
+@unittest.skipUnless(os.uname()[4].startswith('s390'), "s390x architecture required")
+class S390DasdManyTest(unittest.TestCase):
+
+    requested_plugins = BlockDev.plugin_specs_from_names(("s390",))
+    log = []
+
+    @classmethod
+    def setUpClass(cls):
+
+        if not BlockDev.is_initialized():
+            BlockDev.init(cls.requested_plugins, None)
+        else:
+            BlockDev.reinit(cls.requested_plugins, True, None)
+
+    def my_progress_func(self, task, status, completion, msg):
+        self.log.append((task, status, completion, msg))
+
+    def setUp(self):
+        self.log.clear()
+        BlockDev.utils_init_prog_reporting(self.my_progress_func)
+        self.addCleanup(BlockDev.utils_init_prog_reporting, None)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_dasd_format_many(self):
+        """Verify that formatting multiple DASDs in parallel works as expected"""
+
+        with fake_utils("tests/fake_utils/s390_fake_dasdfmt/"):
+            results = BlockDev.s390_dasd_format_many(["dasda", "dasdfail", "dasdb"], 2)
+
+        self.assertEqual([r.dasd for r in results], ["dasda", "dasdfail", "dasdb"])
+        self.assertTrue(results[0].success)
+        self.assertIsNone(results[0].error)
+        self.assertFalse(results[1].success)
+        self.assertIsNotNone(results[1].error)
+        self.assertTrue(results[2].success)
+
+        # the aggregated task is the first one started
+        batch_task = next(t for (t, s, _c, m) in self.log if s == BlockDev.UtilsProgStatus.STARTED and "3 DASDs" in m)
+        completions = [c for (t, s, c, _m) in self.log if t == batch_task and s == BlockDev.UtilsProgStatus.PROGRESS]
+        self.assertTrue(completions)
+        self.assertEqual(completions, sorted(completions))
+        self.assertEqual(completions[-1], 100)
+
+        finished = [m for (t, s, _c, m) in self.log if t == batch_task and s == BlockDev.UtilsProgStatus.FINISHED]
+        self.assertEqual(finished, ["Failed formatting 1 of 3 DASDs"])
+
+        # no DASDs, nothing to do
+        self.assertEqual(BlockDev.s390_dasd_format_many([], 0), [])
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_zfcp_online_many_invalid(self):
+        """Verify that switching multiple zFCP LUNs online checks the input"""
+
+        # a WWPN and LUN needed for every device number
+        with self.assertRaisesRegex(GLib.GError, "same number"):
+            BlockDev.s390_zfcp_online_many(["0.0.fc00", "0.0.fc00"], ["0x5005076300c213e9"],
+                                           ["0x5022000000000000", "0x5023000000000000"], 0)
+
+        # no LUNs, nothing to do
+        self.assertEqual(BlockDev.s390_zfcp_online_many([], [], [], 0), [])
+
+
 @unittest.skipUnless(os.uname()[4].startswith('s390'), "s390x architecture required")
 class S390DepsTest(unittest.TestCase):
 
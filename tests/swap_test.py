@@ -162,6 +162,35 @@ class SwapTestCase(SwapTest):
         with self.assertRaises(BlockDev.SwapActivateError):
             BlockDev.swap.swapon(self.loop_dev)
 
+    def test_swap_list(self):
+        """Verify that swap_list works as expected"""
+
+        succ = BlockDev.swap_mkswap(self.loop_dev, None, None)
+        self.assertTrue(succ)
+
+        swaps = BlockDev.swap_list()
+        self.assertNotIn(self.loop_dev, [s.device for s in swaps])
+        self.assertFalse(BlockDev.swap_swapstatus(self.loop_dev))
+
+        # activate outside of libblockdev to make sure the cached state is updated
+        run("swapon -p 5 %s" % self.loop_dev)
+        self.assertTrue(BlockDev.swap_swapstatus(self.loop_dev))
+
+        swaps = BlockDev.swap_list()
+        swap = next((s for s in swaps if s.device == self.loop_dev), None)
+        self.assertIsNotNone(swap)
+        self.assertEqual(swap.dev, os.stat(self.loop_dev).st_rdev)
+        self.assertEqual(swap.type, "partition")
+        self.assertEqual(swap.priority, 5)
+        self.assertGreater(swap.size, 0)
+        self.assertLessEqual(swap.size, self.dev_size)
+
+        run("swapoff %s" % self.loop_dev)
+        self.assertFalse(BlockDev.swap_swapstatus(self.loop_dev))
+
+        swaps = BlockDev.swap_list()
+        self.assertNotIn(self.loop_dev, [s.device for s in swaps])
+
     def _remove_map(self, map_name):
         run("dmsetup remove -f %s" % map_name)
 
@@ -1,13 +1,21 @@
+import asyncio
+import ctypes
+import errno
 import unittest
+import threading
+import time
 import re
 import os
+import shutil
+import tempfile
 import overrides_hack
 from utils import fake_utils, create_sparse_tempfile, create_lio_device, delete_lio_device, run_command, TestTags, tag_test, read_file
 
 import gi
 gi.require_version('GLib', '2.0')
+gi.require_version('Gio', '2.0')
 gi.require_version('BlockDev', '3.0')
-from gi.repository import GLib, BlockDev
+from gi.repository import GLib, Gio, BlockDev
 
 
 class UtilsTestCase(unittest.TestCase):
@@ -64,6 +72,7 @@ class UtilsExecLoggingTest(UtilsTestCase):
     def _clean_up(self):
         self.log = ""
         BlockDev.utils_set_log_level(BlockDev.UTILS_LOG_WARNING)
+        BlockDev.utils_set_log_output_limit(0)
 
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
     def test_logging(self):
@@ -126,6 +135,107 @@ class UtilsExecLoggingTest(UtilsTestCase):
         BlockDev.utils_log(BlockDev.UTILS_LOG_INFO, "info message")
         self.assertIn("info message", self.log)
 
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_logging_enabled(self):
+        succ = BlockDev.utils_init_logging(self.my_log_func)
+        self.assertTrue(succ)
+
+        self.assertTrue(BlockDev.utils_log_enabled(BlockDev.UTILS_LOG_WARNING))
+        self.assertFalse(BlockDev.utils_log_enabled(BlockDev.UTILS_LOG_INFO))
+
+        BlockDev.utils_set_log_level(BlockDev.UTILS_LOG_INFO)
+        self.assertTrue(BlockDev.utils_log_enabled(BlockDev.UTILS_LOG_INFO))
+
+        # no logging function -> nothing is logged
+        succ = BlockDev.utils_init_logging(None)
+        self.assertTrue(succ)
+        self.assertFalse(BlockDev.utils_log_enabled(BlockDev.UTILS_LOG_WARNING))
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_logging_output_limit(self):
+        """Verify that logging of programs' output can be limited"""
+
+        succ = BlockDev.utils_init_logging(self.my_log_func)
+        self.assertTrue(succ)
+        BlockDev.utils_set_log_level(BlockDev.UTILS_LOG_INFO)
+
+        self.assertEqual(BlockDev.utils_get_log_output_limit(), 0)
+        BlockDev.utils_set_log_output_limit(10)
+        self.assertEqual(BlockDev.utils_get_log_output_limit(), 10)
+
+        succ, out = BlockDev.utils_exec_and_capture_output(["echo", "hi"])
+        self.assertTrue(succ)
+        match = re.search(r'Running \[(\d+)\] echo hi', self.log)
+        self.assertIsNot(match, None)
+        self.assertIn("stdout[%s]: hi" % match.group(1), self.log)
+
+        succ, out = BlockDev.utils_exec_and_capture_output(["printf", "%s", "x" * 100])
+        self.assertTrue(succ)
+        self.assertEqual(out, "x" * 100)
+        match = re.search(r'Running \[(\d+)\] printf', self.log)
+        self.assertIsNot(match, None)
+        self.assertIn("stdout[%s]: %s... (truncated, 100 bytes in total)" % (match.group(1), "x" * 10), self.log)
+
+        # multi-byte characters must not be split
+        BlockDev.utils_set_log_output_limit(11)
+        succ, out = BlockDev.utils_exec_and_capture_output(["printf", "%s", "ěšč" * 10])
+        self.assertTrue(succ)
+        match = re.search(r'Running \[(\d+)\] printf %s ě', self.log)
+        self.assertIsNot(match, None)
+        self.assertIn("stdout[%s]: ěščěš... (truncated, 60 bytes in total)" % match.group(1), self.log)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_timing(self):
+        """Verify that timing instrumentation works as expected"""
+
+        callback_records = []
+        def timing_func(record):
+            callback_records.append((record.task_id, record.command, record.exit_code))
+
+        self.assertFalse(BlockDev.utils_timing_enabled())
+        self.assertEqual(BlockDev.utils_timing_get_records(False), [])
+
+        succ = BlockDev.utils_init_timing(timing_func, 2)
+        self.assertTrue(succ)
+        self.addCleanup(BlockDev.utils_init_timing, None, 0)
+        self.assertTrue(BlockDev.utils_timing_enabled())
+
+        succ, out = BlockDev.utils_exec_and_capture_output(["echo", "hi"])
+        self.assertTrue(succ)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.utils_exec_and_report_error(["false"])
+
+        records = BlockDev.utils_timing_get_records(False)
+        self.assertEqual(len(records), 2)
+        self.assertEqual(records[0].command, "echo hi")
+        self.assertEqual(records[0].exit_code, 0)
+        self.assertEqual(records[0].output_bytes, 3)
+        self.assertGreaterEqual(records[0].spawn_time, 0)
+        self.assertGreaterEqual(records[0].wall_time, records[0].spawn_time)
+        self.assertGreater(records[0].start_time, 0)
+        self.assertEqual(records[1].command, "false")
+        self.assertEqual(records[1].exit_code, 1)
+        self.assertLess(records[0].task_id, records[1].task_id)
+
+        self.assertEqual(callback_records, [(r.task_id, r.command, r.exit_code) for r in records])
+
+        # only the last two records are kept
+        succ = BlockDev.utils_exec_and_report_error(["true"])
+        self.assertTrue(succ)
+        records = BlockDev.utils_timing_get_records(True)
+        self.assertEqual([r.command for r in records], ["false", "true"])
+        self.assertEqual(BlockDev.utils_timing_get_records(False), [])
+
+        # disable timing, nothing should be recorded
+        succ = BlockDev.utils_init_timing(None, 0)
+        self.assertTrue(succ)
+        self.assertFalse(BlockDev.utils_timing_enabled())
+        succ = BlockDev.utils_exec_and_report_error(["true"])
+        self.assertTrue(succ)
+        self.assertEqual(BlockDev.utils_timing_get_records(False), [])
+        self.assertEqual(len(callback_records), 3)
+
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
     def test_version_cmp(self):
         """Verify that version comparison works as expected"""
@@ -203,6 +313,81 @@ class UtilsExecLoggingTest(UtilsTestCase):
             # exit code != 0
             self.assertTrue(BlockDev.utils_check_util_version("libblockdev-fake-util-fail", "1.1", "version", "Version:\\s(.*)"))
 
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_util_version_cache(self):
+        """Verify that the utility version cache works as expected"""
+
+        tmp_dir = tempfile.mkdtemp(prefix="libblockdev-version-cache")
+        self.addCleanup(shutil.rmtree, tmp_dir)
+        self.addCleanup(BlockDev.utils_set_util_version_cache_dir, None)
+
+        util_dir = os.path.join(tmp_dir, "bin")
+        cache_dir = os.path.join(tmp_dir, "cache")
+        os.mkdir(util_dir)
+        util_path = os.path.join(util_dir, "libblockdev-fake-util")
+        shutil.copy("tests/fake_utils/utils_fake_util/libblockdev-fake-util", util_path)
+
+        succ = BlockDev.utils_set_util_version_cache_dir(cache_dir)
+        self.assertTrue(succ)
+
+        with fake_utils(util_dir):
+            self.assertTrue(BlockDev.utils_check_util_version("libblockdev-fake-util", "1.0", "--version", None))
+
+            cache_files = os.listdir(cache_dir)
+            self.assertEqual(len(cache_files), 1)
+            cache_file = os.path.join(cache_dir, cache_files[0])
+
+            # the cached output is used instead of running the utility again
+            with open(cache_file, "r") as f:
+                data = f.read()
+            with open(cache_file, "w") as f:
+                f.write(data.replace("output=1.0", "output=9.9"))
+            self.assertTrue(BlockDev.utils_check_util_version("libblockdev-fake-util", "9.0", "--version", None))
+
+            # changing the binary invalidates the cached output
+            with open(util_path, "w") as f:
+                f.write("#!/bin/bash\necho 0.5\n")
+            os.utime(util_path, ns=(0, 0))
+            with self.assertRaisesRegex(GLib.GError, r"Too low version"):
+                BlockDev.utils_check_util_version("libblockdev-fake-util", "1.0", "--version", None)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_env(self):
+        """Verify that the environment changes are propagated to the executed processes"""
+
+        self.addCleanup(os.environ.pop, "LIBBLOCKDEV_TEST_VAR", None)
+
+        os.environ["LIBBLOCKDEV_TEST_VAR"] = "first"
+        succ, out = BlockDev.utils_exec_and_capture_output(["sh", "-c", "echo $LIBBLOCKDEV_TEST_VAR"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "first\n")
+
+        os.environ["LIBBLOCKDEV_TEST_VAR"] = "second"
+        succ, out = BlockDev.utils_exec_and_capture_output(["sh", "-c", "echo $LIBBLOCKDEV_TEST_VAR"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "second\n")
+
+        # putenv() keeps the string so changing it changes the environment
+        # without changing the pointers in environ
+        libc = ctypes.CDLL(None)
+        env_str = ctypes.create_string_buffer(b"LIBBLOCKDEV_TEST_VAR2=first")
+        self.assertEqual(libc.putenv(env_str), 0)
+        try:
+            succ, out = BlockDev.utils_exec_and_capture_output(["sh", "-c", "echo $LIBBLOCKDEV_TEST_VAR2"])
+            self.assertTrue(succ)
+            self.assertEqual(out, "first\n")
+
+            env_str.value = b"LIBBLOCKDEV_TEST_VAR2=other"
+            succ, out = BlockDev.utils_exec_and_capture_output(["sh", "-c", "echo $LIBBLOCKDEV_TEST_VAR2"])
+            self.assertTrue(succ)
+            self.assertEqual(out, "other\n")
+        finally:
+            # the string must not be freed while it's in the environment
+            libc.unsetenv(b"LIBBLOCKDEV_TEST_VAR2")
+
+        with self.assertRaisesRegex(GLib.GError, r"Failed to execute child process"):
+            BlockDev.utils_exec_and_capture_output(["libblockdev-nonexisting-util"])
+
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
     def test_exec_locale(self):
         """Verify that setting locale for exec functions works as expected"""
@@ -357,6 +542,105 @@ class UtilsExecLoggingTest(UtilsTestCase):
         status = BlockDev.utils_exec_and_report_progress(["bash", "-c", "for i in {1..%d}; do echo -e \"%s\\0%s\"; echo -e \"%s\\0%s\" >&2; done" % (cnt, self.EXEC_PROGRESS_MSG, self.EXEC_PROGRESS_MSG, self.EXEC_PROGRESS_MSG, self.EXEC_PROGRESS_MSG)], None, None)
         self.assertTrue(status)
 
+    def test_exec_process_lines(self):
+        """Verify that lines of the output are processed as they are read"""
+
+        lines = []
+        def process_line(line, from_stderr, data):
+            data.append((line, from_stderr))
+            # keep the lines with "keep" in the output
+            return "keep" not in line
+
+        succ, status, out = BlockDev.utils_exec_and_process_lines(["bash", "-c", "echo first; echo second >&2; echo keep; echo -n last"],
+                                                                  None, process_line, lines)
+        self.assertTrue(succ)
+        self.assertEqual(status, 0)
+        self.assertIn(("first", False), lines)
+        self.assertIn(("second", True), lines)
+        self.assertIn(("keep", False), lines)
+        self.assertIn(("last", False), lines)
+        self.assertEqual(out, "keep\n")
+
+        # many lines, no output accumulated if not consumed
+        cnt = 100000
+        lines = []
+        succ, status, out = BlockDev.utils_exec_and_process_lines(["bash", "-c", "for i in {1..%d}; do echo $i; done" % cnt],
+                                                                  None, process_line, lines)
+        self.assertTrue(succ)
+        self.assertEqual(len(lines), cnt)
+        self.assertEqual(lines[-1], (str(cnt), False))
+
+        # a line longer than the buffer is passed in parts
+        cnt = 200000
+        lines = []
+        succ, status, out = BlockDev.utils_exec_and_process_lines(["bash", "-c", "printf '.%%.0s' {1..%d}; echo" % cnt],
+                                                                  None, process_line, lines)
+        self.assertTrue(succ)
+        self.assertGreater(len(lines), 1)
+        self.assertEqual(sum(len(line) for (line, _err) in lines), cnt)
+
+        # stderr lines are used for the error message
+        lines = []
+        with self.assertRaisesRegex(GLib.GError, r"Process reported exit code 3: .*keep error"):
+            BlockDev.utils_exec_and_process_lines(["bash", "-c", "echo keep error >&2; exit 3"], None, process_line, lines)
+
+    def test_exec_replay(self):
+        """Verify that registered replays are used instead of running the commands"""
+
+        self.addCleanup(BlockDev.utils_exec_replay_clear)
+
+        succ = BlockDev.utils_exec_replay_add("libblockdev-fake-replay --version", "fake-replay 1.2.3\n", None, 0)
+        self.assertTrue(succ)
+        succ = BlockDev.utils_exec_replay_add("libblockdev-fake-replay list *", "first\nsecond\n", "warning\n", 0)
+        self.assertTrue(succ)
+        succ = BlockDev.utils_exec_replay_add("libblockdev-fake-replay fail*", None, "failed badly", 3)
+        self.assertTrue(succ)
+
+        with self.assertRaises(GLib.GError):
+            BlockDev.utils_exec_replay_add("", None, None, 0)
+
+        # the utility is not installed, but replayed
+        succ = BlockDev.utils_check_util_version("libblockdev-fake-replay", "1.2", None, r"fake-replay (\d+\.\d+\.\d+)")
+        self.assertTrue(succ)
+        with self.assertRaisesRegex(GLib.GError, "Too low version"):
+            BlockDev.utils_check_util_version("libblockdev-fake-replay", "2.0", None, r"fake-replay (\d+\.\d+\.\d+)")
+
+        succ, out = BlockDev.utils_exec_and_capture_output(["libblockdev-fake-replay", "list", "all"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "first\nsecond\n")
+
+        lines = []
+        def process_line(line, from_stderr, data):
+            data.append((line, from_stderr))
+            return True
+
+        succ, status, _out = BlockDev.utils_exec_and_process_lines(["libblockdev-fake-replay", "list", "all"], None, process_line, lines)
+        self.assertTrue(succ)
+        self.assertEqual(status, 0)
+        self.assertEqual(lines, [("first", False), ("second", False), ("warning", True)])
+
+        with self.assertRaisesRegex(GLib.GError, r"Process reported exit code 3: failed badly"):
+            BlockDev.utils_exec_and_report_error(["libblockdev-fake-replay", "fail"])
+        with self.assertRaisesRegex(GLib.GError, r"Process reported exit code 3: failed badly"):
+            BlockDev.utils_exec_and_report_error_no_progress(["libblockdev-fake-replay", "fail"])
+
+        # commands without a replay are run as usual
+        succ, out = BlockDev.utils_exec_and_capture_output(["echo", "hi"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "hi\n")
+
+        # ...unless the strict mode is enabled
+        BlockDev.utils_exec_replay_set_strict(True)
+        with self.assertRaisesRegex(GLib.GError, r"No replay registered for 'echo hi'"):
+            BlockDev.utils_exec_and_capture_output(["echo", "hi"])
+
+        BlockDev.utils_exec_replay_clear()
+        succ, out = BlockDev.utils_exec_and_capture_output(["echo", "hi"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "hi\n")
+        with self.assertRaises(GLib.GError):
+            BlockDev.utils_exec_and_capture_output(["libblockdev-fake-replay", "list", "all"])
+
     def test_exec_large_input(self):
         """Verify that large input is passed to the process properly"""
 
@@ -380,6 +664,173 @@ class UtilsExecLoggingTest(UtilsTestCase):
         self.assertTrue(status)
 
 
+class UtilsExecAsyncTest(UtilsTestCase):
+    EXEC_PROGRESS_MSG = "Aloha, I'm the progress line you should match."
+
+    def _run_async(self, func, *args):
+        loop = GLib.MainLoop()
+        results = []
+
+        def done_cb(source, result, user_data):
+            results.append(result)
+            loop.quit()
+
+        func(*args, done_cb, None)
+        loop.run()
+        return results[0]
+
+    def my_exec_progress_func(self, line):
+        self.assertTrue(re.match(r".*%s.*" % self.EXEC_PROGRESS_MSG, line))
+        self.num_matches += 1
+        return 0
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_capture_output_async(self):
+        """Verify that asynchronous execution with output capture works as expected"""
+
+        res = self._run_async(BlockDev.utils_exec_and_capture_output_async, ["echo", "hi"], None, None)
+        succ, out = BlockDev.utils_exec_and_capture_output_finish(res)
+        self.assertTrue(succ)
+        self.assertEqual(out, "hi\n")
+
+        res = self._run_async(BlockDev.utils_exec_and_capture_output_async, ["true"], None, None)
+        with self.assertRaisesRegex(GLib.GError, r"Process didn't provide any data on standard output"):
+            BlockDev.utils_exec_and_capture_output_finish(res)
+
+        res = self._run_async(BlockDev.utils_exec_and_capture_output_async, ["bash", "-c", "echo fail >&2; exit 66"], None, None)
+        with self.assertRaisesRegex(GLib.GError, r"Process reported exit code 66: fail"):
+            BlockDev.utils_exec_and_capture_output_finish(res)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_report_progress_async(self):
+        """Verify that asynchronous execution with progress reporting works as expected"""
+
+        self.num_matches = 0
+        res = self._run_async(BlockDev.utils_exec_and_report_progress_async,
+                              ["bash", "-c", "for i in {1..100}; do echo \"%s\"; echo \"%s\" >&2; done" % (self.EXEC_PROGRESS_MSG, self.EXEC_PROGRESS_MSG)],
+                              None, self.my_exec_progress_func, None)
+        succ, status = BlockDev.utils_exec_and_report_progress_finish(res)
+        self.assertTrue(succ)
+        self.assertEqual(status, 0)
+        self.assertEqual(self.num_matches, 200)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_async_cancel(self):
+        """Verify that asynchronous execution can be cancelled"""
+
+        cancellable = Gio.Cancellable()
+        GLib.timeout_add(100, lambda: cancellable.cancel() and False)
+
+        res = self._run_async(BlockDev.utils_exec_and_capture_output_async, ["sleep", "60"], None, cancellable)
+        with self.assertRaisesRegex(GLib.GError, r"Operation was cancelled"):
+            BlockDev.utils_exec_and_capture_output_finish(res)
+
+
+class UtilsExecCancelTest(UtilsTestCase):
+
+    def setUp(self):
+        self.addCleanup(BlockDev.utils_exec_set_thread_cancellable, None)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_exec_thread_cancellable(self):
+        """Verify that the processes run by a thread can be cancelled"""
+
+        cancellable = Gio.Cancellable()
+        BlockDev.utils_exec_set_thread_cancellable(cancellable)
+
+        # not cancelled, no change
+        succ, out = BlockDev.utils_exec_and_capture_output(["echo", "hi"])
+        self.assertTrue(succ)
+        self.assertEqual(out, "hi\n")
+        self.assertTrue(BlockDev.utils_exec_and_report_error_no_progress(["true"]))
+        with self.assertRaisesRegex(GLib.GError, r"Process reported exit code 1"):
+            BlockDev.utils_exec_and_report_error_no_progress(["false"])
+
+        for func in (BlockDev.utils_exec_and_report_error, BlockDev.utils_exec_and_report_error_no_progress):
+            cancellable.reset()
+            timer = threading.Timer(0.2, cancellable.cancel)
+            timer.start()
+            start = time.time()
+            with self.assertRaisesRegex(GLib.GError, r"Operation was cancelled"):
+                func(["sleep", "60"])
+            self.assertLess(time.time() - start, 30)
+            timer.join()
+
+        # already cancelled, nothing is run
+        with self.assertRaisesRegex(GLib.GError, r"Operation was cancelled"):
+            BlockDev.utils_exec_and_report_error(["true"])
+
+        # other threads are not affected
+        results = []
+        thread = threading.Thread(target=lambda: results.append(BlockDev.utils_exec_and_report_error(["true"])))
+        thread.start()
+        thread.join()
+        self.assertEqual(results, [True])
+
+        BlockDev.utils_exec_set_thread_cancellable(None)
+        self.assertTrue(BlockDev.utils_exec_and_report_error(["true"]))
+
+
+class UtilsRunAsyncTest(UtilsTestCase):
+
+    def _run(self, coro):
+        return asyncio.run(asyncio.wait_for(coro, 30))
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_run_async(self):
+        """Verify that functions can be awaited with the progress as an async iterator"""
+
+        async def run():
+            op = BlockDev.run_async(BlockDev.utils_exec_and_capture_output, ["echo", "hi"])
+            ret = await op
+            reports = [report async for report in op]
+            return ret, reports
+
+        (succ, out), reports = self._run(run())
+        self.assertTrue(succ)
+        self.assertEqual(out, "hi\n")
+        self.assertEqual([r.status for r in reports],
+                         [BlockDev.UtilsProgStatus.STARTED, BlockDev.UtilsProgStatus.FINISHED])
+        self.assertIn("echo hi", reports[0].msg)
+        self.assertEqual(reports[0].task_id, reports[1].task_id)
+
+        # multiple operations in parallel, errors are raised from the await
+        async def run_many():
+            ops = [BlockDev.run_async(BlockDev.utils_exec_and_report_error, ["sleep", "0.5"]) for _i in range(8)]
+            ops.append(BlockDev.run_async(BlockDev.utils.exec_and_report_error, ["false"]))
+            return await asyncio.gather(*ops, return_exceptions=True)
+
+        start = time.time()
+        results = self._run(run_many())
+        self.assertLess(time.time() - start, 4)
+        self.assertEqual(results[:8], [True] * 8)
+        self.assertIsInstance(results[8], BlockDev.UtilsError)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_run_async_cancel(self):
+        """Verify that awaited functions can be cancelled"""
+
+        async def run():
+            op = BlockDev.run_async(BlockDev.utils_exec_and_report_error, ["sleep", "60"])
+
+            async def wait():
+                return await op
+
+            task = asyncio.ensure_future(wait())
+            await asyncio.sleep(0.2)
+            task.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await task
+            self.assertTrue(op.done())
+            # the iteration ends once the process is terminated
+            return [report async for report in op]
+
+        start = time.time()
+        reports = self._run(run())
+        self.assertLess(time.time() - start, 30)
+        self.assertEqual(reports[-1].status, BlockDev.UtilsProgStatus.FINISHED)
+        self.assertEqual(reports[-1].msg, "Operation was cancelled")
+
 class UtilsDevUtilsTestCase(UtilsTestCase):
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
     def test_resolve_device(self):
@@ -413,6 +864,96 @@ class UtilsDevUtilsTestCase(UtilsTestCase):
         # should resolve the symlink even without the "/dev" prefix
         self.assertEqual(BlockDev.utils_resolve_device(dev_link[5:]), dev)
 
+        # multiple devices at once
+        self.assertEqual(BlockDev.utils_resolve_devices([dev, dev_link, dev_link[5:]]), [dev, dev, dev])
+        with self.assertRaisesRegex(GLib.GError, "no_such_device"):
+            BlockDev.utils_resolve_devices([dev, "no_such_device"])
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_resolve_device_cache(self):
+        """Verify that the device resolution cache works as expected"""
+
+        BlockDev.utils_dev_cache_enable(True)
+        self.addCleanup(BlockDev.utils_dev_cache_enable, False)
+        self.assertTrue(BlockDev.utils_dev_cache_enabled())
+
+        dev = "/dev/libblockdev-test-dev"
+        dev2 = "/dev/libblockdev-test-dev2"
+        for path in (dev, dev2):
+            with open(path, "w"):
+                pass
+            self.addCleanup(os.unlink, path)
+
+        dev_link = "/dev/libblockdev-test-dev-link"
+        os.symlink(dev[5:], dev_link)
+        self.addCleanup(lambda: os.path.lexists(dev_link) and os.unlink(dev_link))
+
+        self.assertEqual(BlockDev.utils_resolve_device(dev_link), dev)
+        # cached now
+        self.assertEqual(BlockDev.utils_resolve_device(dev_link), dev)
+
+        # replacing the symlink makes the cached result stale
+        os.unlink(dev_link)
+        os.symlink(dev2[5:], dev_link)
+        self.assertEqual(BlockDev.utils_resolve_device(dev_link), dev2)
+
+        # removed symlink is not resolved from the cache
+        os.unlink(dev_link)
+        with self.assertRaises(GLib.GError):
+            BlockDev.utils_resolve_device(dev_link)
+
+        os.symlink(dev[5:], dev_link)
+        self.assertEqual(BlockDev.utils_resolve_devices([dev_link, dev2]), [dev, dev2])
+        BlockDev.utils_dev_cache_invalidate(dev)
+        BlockDev.utils_dev_cache_invalidate(None)
+        self.assertEqual(BlockDev.utils_resolve_device(dev_link), dev)
+
+        BlockDev.utils_dev_cache_enable(False)
+        self.assertFalse(BlockDev.utils_dev_cache_enabled())
+        self.assertEqual(BlockDev.utils_resolve_device(dev_link), dev)
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_dev_events(self):
+        """Verify that subscribing to udev events works as expected"""
+
+        def event_func(action, device, devnum, dm_name):
+            pass
+
+        self.assertFalse(BlockDev.utils_dev_events_running())
+
+        try:
+            sub1 = BlockDev.utils_dev_events_subscribe(event_func)
+        except GLib.GError as e:
+            self.skipTest("Cannot receive udev events: %s" % e)
+        self.assertNotEqual(sub1, 0)
+        self.assertTrue(BlockDev.utils_dev_events_running())
+
+        sub2 = BlockDev.utils_dev_events_subscribe(event_func)
+        self.assertNotEqual(sub2, sub1)
+
+        # the monitor runs until the last subscription is cancelled
+        BlockDev.utils_dev_events_unsubscribe(sub1)
+        self.assertTrue(BlockDev.utils_dev_events_running())
+        BlockDev.utils_dev_events_unsubscribe(sub2)
+        self.assertFalse(BlockDev.utils_dev_events_running())
+
+        # the device cache subscribes too
+        BlockDev.utils_dev_cache_enable(True)
+        self.assertTrue(BlockDev.utils_dev_events_running())
+        BlockDev.utils_dev_cache_enable(False)
+        self.assertFalse(BlockDev.utils_dev_events_running())
+
+    @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
+    def test_wait_for_device(self):
+        """Verify that waiting for a device works as expected"""
+
+        self.assertTrue(BlockDev.utils_wait_for_device("/dev/null", 100))
+
+        start = time.time()
+        with self.assertRaisesRegex(GLib.GError, "didn't become ready"):
+            BlockDev.utils_wait_for_device("/dev/no_such_device", 200)
+        self.assertGreaterEqual(time.time() - start, 0.2)
+
 
 class UtilsDevUtilsSymlinksTestCase(UtilsTestCase):
     def setUp(self):
@@ -463,6 +1004,162 @@ class UtilsDevUtilsSymlinksTestCase(UtilsTestCase):
         self.assertGreaterEqual(len(symlinks), 4)
 
 
+class IORequest(ctypes.Structure):
+    _fields_ = [("fd", ctypes.c_int),
+                ("offset", ctypes.c_uint64),
+                ("length", ctypes.c_size_t),
+                ("write", ctypes.c_int),
+                ("buf", ctypes.c_void_p),
+                ("result", ctypes.c_ssize_t),
+                ("user_data", ctypes.c_void_p),
+                ("slot", ctypes.c_int)]
+
+IOCompleteFunc = ctypes.CFUNCTYPE(None, ctypes.POINTER(IORequest), ctypes.c_void_p)
+
+
+class UtilsIOEngineTest(UtilsTestCase):
+    # the I/O engine is internal (not introspectable) so it is used through ctypes
+    block_size = 4096
+    n_blocks = 64
+
+    @classmethod
+    def setUpClass(cls):
+        UtilsTestCase.setUpClass()
+
+        cls.lib = ctypes.CDLL("libbd_utils.so.3")
+        cls.lib.bd_utils_io_engine_new.restype = ctypes.c_void_p
+        cls.lib.bd_utils_io_engine_new.argtypes = [ctypes.c_uint, ctypes.c_size_t, ctypes.c_void_p]
+        cls.lib.bd_utils_io_engine_free.argtypes = [ctypes.c_void_p]
+        cls.lib.bd_utils_io_engine_uses_io_uring.argtypes = [ctypes.c_void_p]
+        cls.lib.bd_utils_io_engine_run.argtypes = [ctypes.c_void_p, ctypes.POINTER(IORequest), ctypes.c_uint,
+                                                   IOCompleteFunc, ctypes.c_void_p, ctypes.c_void_p]
+
+    def setUp(self):
+        self.dev_file = create_sparse_tempfile("io_engine_test", self.block_size * self.n_blocks)
+        self.addCleanup(os.unlink, self.dev_file)
+        self.fd = os.open(self.dev_file, os.O_RDWR)
+        self.addCleanup(os.close, self.fd)
+
+    def _new_engine(self, queue_depth=8):
+        engine = self.lib.bd_utils_io_engine_new(queue_depth, 0, None)
+        self.assertTrue(engine)
+        self.addCleanup(self.lib.bd_utils_io_engine_free, engine)
+        return engine
+
+    def _run(self, engine, requests):
+        completed = {}
+
+        @IOCompleteFunc
+        def complete(request, _user_data):
+            req = request.contents
+            data = ctypes.string_at(req.buf, req.result) if req.result > 0 and not req.write else None
+            completed[req.offset] = (req.result, data)
+
+        req_array = (IORequest * len(requests))(*requests)
+        succ = self.lib.bd_utils_io_engine_run(engine, req_array, len(requests), complete, None, None)
+        self.assertTrue(succ)
+        return completed
+
+    def _check_engine(self, engine):
+        # write every block with its own buffer, the buffers need to stay alive during the run
+        buffers = [ctypes.create_string_buffer(bytes([i]) * self.block_size, self.block_size) for i in range(self.n_blocks)]
+        requests = [IORequest(fd=self.fd, offset=i * self.block_size, length=self.block_size, write=True,
+                              buf=ctypes.cast(buffers[i], ctypes.c_void_p))
+                    for i in range(self.n_blocks)]
+        completed = self._run(engine, requests)
+        self.assertEqual(len(completed), self.n_blocks)
+        self.assertTrue(all(result == self.block_size for (result, _data) in completed.values()))
+
+        with open(self.dev_file, "rb") as f:
+            written = f.read()
+        self.assertEqual(written, b"".join(bytes([i]) * self.block_size for i in range(self.n_blocks)))
+
+        # read the blocks back into the engine buffers (more requests than the queue depth)
+        requests = [IORequest(fd=self.fd, offset=i * self.block_size, length=self.block_size, write=False, buf=None)
+                    for i in range(self.n_blocks)]
+        completed = self._run(engine, requests)
+        self.assertEqual(len(completed), self.n_blocks)
+        for i in range(self.n_blocks):
+            self.assertEqual(completed[i * self.block_size], (self.block_size, bytes([i]) * self.block_size))
+
+        # failures of the requests are reported in their results
+        requests = [IORequest(fd=-1, offset=0, length=self.block_size, write=False, buf=None)]
+        completed = self._run(engine, requests)
+        self.assertEqual(completed[0][0], -errno.EBADF)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_io_engine(self):
+        """Verify that the I/O engine reads and writes data"""
+
+        engine = self._new_engine()
+        self._check_engine(engine)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_io_engine_sync(self):
+        """Verify that the I/O engine works without io_uring"""
+
+        sysctl = "/proc/sys/kernel/io_uring_disabled"
+        if not os.path.exists(sysctl):
+            self.skipTest("Cannot disable io_uring")
+
+        with open(sysctl, "r") as f:
+            orig = f.read().strip()
+        with open(sysctl, "w") as f:
+            f.write("2")
+        try:
+            engine = self._new_engine()
+        finally:
+            with open(sysctl, "w") as f:
+                f.write(orig)
+
+        self.assertFalse(self.lib.bd_utils_io_engine_uses_io_uring(engine))
+        self._check_engine(engine)
+
+    @tag_test(TestTags.NOSTORAGE)
+    def test_io_engine_ring_failure(self):
+        """Verify that the I/O engine falls back to synchronous I/O if the ring fails"""
+
+        fds_before = set(os.listdir("/proc/self/fd"))
+        engine = self._new_engine()
+        if not self.lib.bd_utils_io_engine_uses_io_uring(engine):
+            self.skipTest("io_uring not available")
+
+        ring_fds = [fd for fd in set(os.listdir("/proc/self/fd")) - fds_before
+                    if "io_uring" in os.readlink("/proc/self/fd/%s" % fd)]
+        self.assertEqual(len(ring_fds), 1)
+
+        # make the submissions fail
+        os.close(int(ring_fds[0]))
+
+        self._check_engine(engine)
+        self.assertFalse(self.lib.bd_utils_io_engine_uses_io_uring(engine))
+
+
+class UtilsKernelModuleTest(UtilsTestCase):
+    @tag_test(TestTags.NOSTORAGE)
+    def test_have_kernel_module(self):
+        """ Test checking for kernel modules from multiple threads"""
+
+        self.assertFalse(BlockDev.utils_have_kernel_module("libblockdev_nonexisting_module"))
+
+        expected = BlockDev.utils_have_kernel_module("loop")
+        results = {"loop": [], "libblockdev_nonexisting_module": []}
+
+        def check():
+            for _ in range(50):
+                for module in results.keys():
+                    results[module].append(BlockDev.utils_have_kernel_module(module))
+
+        threads = [threading.Thread(target=check) for _ in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        self.assertEqual(results["loop"], [expected] * 200)
+        self.assertEqual(results["libblockdev_nonexisting_module"], [False] * 200)
+
+
 class UtilsLinuxKernelVersionTest(UtilsTestCase):
     @tag_test(TestTags.NOSTORAGE, TestTags.CORE)
     def test_initialization(self):
@@ -9,9 +9,10 @@
 
 void print_usage (const char *cmd) {
     fprintf (stderr,
-             "Usage: %s CACHED_LV [CACHED_LV2...]\n"
-             "-h    --help   Print this usage info\n"
-             "-j    --json   Print stats as JSON\n"
+             "Usage: %s [OPTIONS] CACHED_LV [CACHED_LV2...]\n"
+             "-h    --help           Print this usage info\n"
+             "-j    --json           Print stats as JSON\n"
+             "-i    --interval SECS  Print hit rates every SECS seconds (until interrupted)\n"
              "Options need to be specified before LVs.\n",
              cmd);
 }
@@ -82,6 +83,98 @@ gboolean print_lv_stats_json(const char *vg_name, const char *lv_name, GError **
     return TRUE;
 }
 
+void print_sample (const char *vg_name, const char *lv_name, BDLVMCacheSample *sample) {
+    printf ("%s/%s: read hits %10.1f/s misses %10.1f/s", vg_name, lv_name, sample->read_hits_rate, sample->read_misses_rate);
+    printf (" [%6.2f%%]", sample->read_hit_ratio * 100);
+    printf ("  write hits %10.1f/s misses %10.1f/s", sample->write_hits_rate, sample->write_misses_rate);
+    printf (" [%6.2f%%]", sample->write_hit_ratio * 100);
+    if (!sample->writecache)
+        printf ("  promotions %8.1f/s demotions %8.1f/s", sample->promotions_rate, sample->demotions_rate);
+    printf ("  dirty blocks %10"G_GUINT64_FORMAT"\n", sample->dirty_blocks);
+}
+
+void print_sample_json (const char *vg_name, const char *lv_name, BDLVMCacheSample *sample) {
+    printf ("{\"lv\": \"%s/%s\", ", vg_name, lv_name);
+    printf ("\"interval\": %0.3f, ", sample->interval);
+    printf ("\"read-hits\": %"G_GUINT64_FORMAT", ", sample->read_hits_delta);
+    printf ("\"read-misses\": %"G_GUINT64_FORMAT", ", sample->read_misses_delta);
+    printf ("\"read-hits-rate\": %0.2f, ", sample->read_hits_rate);
+    printf ("\"read-misses-rate\": %0.2f, ", sample->read_misses_rate);
+    printf ("\"read-hit-ratio\": %0.2f, ", sample->read_hit_ratio);
+    printf ("\"write-hits\": %"G_GUINT64_FORMAT", ", sample->write_hits_delta);
+    printf ("\"write-misses\": %"G_GUINT64_FORMAT", ", sample->write_misses_delta);
+    printf ("\"write-hits-rate\": %0.2f, ", sample->write_hits_rate);
+    printf ("\"write-misses-rate\": %0.2f, ", sample->write_misses_rate);
+    printf ("\"write-hit-ratio\": %0.2f, ", sample->write_hit_ratio);
+    printf ("\"promotions\": %"G_GUINT64_FORMAT", ", sample->promotions_delta);
+    printf ("\"demotions\": %"G_GUINT64_FORMAT", ", sample->demotions_delta);
+    printf ("\"dirty-blocks\": %"G_GUINT64_FORMAT"}\n", sample->dirty_blocks);
+}
+
+/* the LVs are given as VG/LV, splits them in place */
+gboolean split_lv_spec (char *spec, const char **vg_name, const char **lv_name) {
+    char *slash = strchr (spec, '/');
+    if (!slash) {
+        fprintf (stderr, "Invalid LV specified: '%s'. Has to be in the VG/LV format.\n", spec);
+        return FALSE;
+    }
+    *slash = '\0';
+    *vg_name = spec;
+    *lv_name = slash + 1;
+    return TRUE;
+}
+
+int stream_stats (int n_lvs, char *lvs[], guint interval, gboolean json) {
+    BDLVMCacheSampler **samplers = g_new0 (BDLVMCacheSampler*, n_lvs);
+    BDLVMCacheSample *sample = NULL;
+    GError *error = NULL;
+    int ret = 0;
+
+    /* resolve all the LVs once, the samplers then just query the DM maps */
+    for (int i = 0; i < n_lvs; i++) {
+        const char *vg_name = NULL;
+        const char *lv_name = NULL;
+        if (!split_lv_spec (lvs[i], &vg_name, &lv_name)) {
+            ret = 3;
+            goto out;
+        }
+        samplers[i] = bd_lvm_cache_sampler_new (vg_name, lv_name, &error);
+        if (!samplers[i]) {
+            fprintf (stderr, "Failed to get stats for '%s/%s': %s\n",
+                     vg_name, lv_name, error->message);
+            g_clear_error (&error);
+            ret = 3;
+            goto out;
+        }
+    }
+
+    while (TRUE) {
+        sleep (interval);
+        for (int i = 0; i < n_lvs; i++) {
+            sample = bd_lvm_cache_sampler_sample (samplers[i], &error);
+            if (!sample) {
+                fprintf (stderr, "Failed to get stats for '%s/%s': %s\n",
+                         samplers[i]->vg_name, samplers[i]->lv_name, error->message);
+                g_clear_error (&error);
+                ret = 3;
+                goto out;
+            }
+            if (json)
+                print_sample_json (samplers[i]->vg_name, samplers[i]->lv_name, sample);
+            else
+                print_sample (samplers[i]->vg_name, samplers[i]->lv_name, sample);
+            bd_lvm_cache_sample_free (sample);
+        }
+        fflush (stdout);
+    }
+
+out:
+    for (int i = 0; i < n_lvs; i++)
+        bd_lvm_cache_sampler_free (samplers[i]);
+    g_free (samplers);
+    return ret;
+}
+
 int main (int argc, char *argv[]) {
     gboolean ret = FALSE;
     GError *error = NULL;
@@ -92,11 +185,23 @@ int main (int argc, char *argv[]) {
     }
 
     gboolean json = FALSE;
+    guint interval = 0;
     int first_lv_arg = 1;
-    for (int i=0; i < argc; i++) {
-        if ((g_strcmp0 (argv[i], "-j") == 0) || g_strcmp0 (argv[i], "--json") == 0) {
+    while (first_lv_arg < argc && argv[first_lv_arg][0] == '-') {
+        if ((g_strcmp0 (argv[first_lv_arg], "-j") == 0) || g_strcmp0 (argv[first_lv_arg], "--json") == 0) {
             json = TRUE;
             first_lv_arg++;
+        } else if ((g_strcmp0 (argv[first_lv_arg], "-i") == 0) || g_strcmp0 (argv[first_lv_arg], "--interval") == 0) {
+            if (first_lv_arg + 1 >= argc || (interval = (guint) g_ascii_strtoull (argv[first_lv_arg + 1], NULL, 10)) == 0) {
+                fprintf (stderr, "Invalid interval specified!\n");
+                print_usage (argv[0]);
+                return 1;
+            }
+            first_lv_arg += 2;
+        } else {
+            fprintf (stderr, "Unknown option '%s'!\n", argv[first_lv_arg]);
+            print_usage (argv[0]);
+            return 1;
         }
     }
 
@@ -123,21 +228,21 @@ int main (int argc, char *argv[]) {
         return 2;
     }
 
+    if (interval > 0)
+        return stream_stats (argc - first_lv_arg, argv + first_lv_arg, interval, json);
+
     gboolean ok = TRUE;
     for (int i = first_lv_arg; i < argc; i++) {
         /* Add one blank line between stats for the individual LVs */
         if (i > first_lv_arg)
             printf("\n");
 
-        char *slash = strchr (argv[i], '/');
-        if (!slash) {
-            fprintf (stderr, "Invalid LV specified: '%s'. Has to be in the VG/LV format.\n", argv[i]);
+        const char *vg_name = NULL;
+        const char *lv_name = NULL;
+        if (!split_lv_spec (argv[i], &vg_name, &lv_name)) {
             ok = FALSE;
             continue;
         }
-        *slash = '\0';
-        const char *vg_name = argv[i];
-        const char *lv_name = slash + 1;
 
         if (json)
             ret = print_lv_stats_json (vg_name, lv_name, &error);